@@ -699,6 +699,8 @@ ${SUBSTRATA_ROOT_DIR}/shared/WorldObject.cpp
 ${SUBSTRATA_ROOT_DIR}/shared/WorldObject.h
 ${SUBSTRATA_ROOT_DIR}/shared/WorldMaterial.cpp
 ${SUBSTRATA_ROOT_DIR}/shared/WorldMaterial.h
+${SUBSTRATA_ROOT_DIR}/shared/URLAtom.cpp
+${SUBSTRATA_ROOT_DIR}/shared/URLAtom.h
 ${SUBSTRATA_ROOT_DIR}/shared/Avatar.cpp
 ${SUBSTRATA_ROOT_DIR}/shared/Avatar.h
 ${SUBSTRATA_ROOT_DIR}/shared/Parcel.cpp
@@ -713,6 +715,14 @@ ${SUBSTRATA_ROOT_DIR}/shared/ObjectEventHandlers.cpp
 ${SUBSTRATA_ROOT_DIR}/shared/ObjectEventHandlers.h
 ${SUBSTRATA_ROOT_DIR}/shared/LODGeneration.cpp
 ${SUBSTRATA_ROOT_DIR}/shared/LODGeneration.h
+${SUBSTRATA_ROOT_DIR}/shared/TextureDownsampling.cpp
+${SUBSTRATA_ROOT_DIR}/shared/TextureDownsampling.h
+${SUBSTRATA_ROOT_DIR}/shared/DecodedImageCache.cpp
+${SUBSTRATA_ROOT_DIR}/shared/DecodedImageCache.h
+${SUBSTRATA_ROOT_DIR}/shared/VoxelBricks.cpp
+${SUBSTRATA_ROOT_DIR}/shared/VoxelBricks.h
+${SUBSTRATA_ROOT_DIR}/shared/VoxelCodec.cpp
+${SUBSTRATA_ROOT_DIR}/shared/VoxelCodec.h
 ${SUBSTRATA_ROOT_DIR}/shared/VoxelMeshBuilding.cpp
 ${SUBSTRATA_ROOT_DIR}/shared/VoxelMeshBuilding.h
 ${SUBSTRATA_ROOT_DIR}/shared/ImageDecoding.cpp
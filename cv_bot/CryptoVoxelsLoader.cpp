@@ -1122,7 +1122,7 @@ void CryptoVoxelsLoader::loadCryptoVoxelsData(WorldState& world_state, Reference
 					printVar(mat_index);
 					printVar(colour_index);
 					printVar(tex_index);
-					conPrint("colour_texture_url: " + parcel_mats[mat_index]->colour_texture_url);
+					conPrint("colour_texture_url: " + toStdString(parcel_mats[mat_index]->colour_texture_url));
 					conPrint("col: " + parcel_cols[colour_index].toVec3().toString());
 					conPrint("transparent: " + boolToString(transparent));
 					conPrint("");*/
@@ -140,7 +140,10 @@ void EmscriptenResourceDownloader::onResourceError(Reference<CurrentlyDownloadin
 
 void EmscriptenResourceDownloader::think()
 {
-	const int max_num_concurrent_downloads = 10;
+	// The webserver only speaks HTTP/1.1, so the browser opens at most 6 connections to it and queues any further requests itself, in FIFO order.
+	// Keep the number of in-flight requests at the connection limit, so that requests wait in download_queue instead, which is sorted by distance from the camera.
+	// Each connection is keep-alive, so a request is started on it as soon as the previous response has been received.
+	const int max_num_concurrent_downloads = 6;
 	const int max_total_unused_loaded_buffer_size_B = 256 * 1024 * 1024;
 
 	for(int i=0; i<10; ++i)
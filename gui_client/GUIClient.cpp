@@ -2051,8 +2051,8 @@ void GUIClient::loadModelForObject(WorldObject* ob, WorldStateLock& world_state_
 		// Add any objects with gif or mp4 textures to the set of animated objects. (if not already)
 		for(size_t i=0; i<ob->materials.size(); ++i)
 		{
-			if(	::hasExtension(ob->materials[i]->colour_texture_url,   "mp4") ||
-				::hasExtension(ob->materials[i]->emission_texture_url, "mp4"))
+			if(	::hasExtension(ob->materials[i]->colour_texture_url.str(),   "mp4") ||
+				::hasExtension(ob->materials[i]->emission_texture_url.str(), "mp4"))
 			{
 				if(ob->animated_tex_data.isNull())
 				{
@@ -2616,8 +2616,8 @@ void GUIClient::loadPresentObjectGraphicsAndPhysicsModels(WorldObject* ob, const
 	// Add any objects with mp4 textures to the set of animated objects. (if not already)
 	for(size_t i=0; i<ob->materials.size(); ++i)
 	{
-		if(	::hasExtension(ob->materials[i]->colour_texture_url,   "mp4") ||
-			::hasExtension(ob->materials[i]->emission_texture_url, "mp4"))
+		if(	::hasExtension(ob->materials[i]->colour_texture_url.str(),   "mp4") ||
+			::hasExtension(ob->materials[i]->emission_texture_url.str(), "mp4"))
 		{
 			if(ob->animated_tex_data.isNull())
 			{
@@ -2765,7 +2765,7 @@ void GUIClient::loadModelForAvatar(Avatar* avatar)
 		// Add any objects with gif or mp4 textures to the set of animated objects.
 		/*for(size_t i=0; i<avatar->materials.size(); ++i)
 		{
-			if(::hasExtension(avatar->materials[i]->colour_texture_url, "gif") || ::hasExtensionStringView(avatar->materials[i]->colour_texture_url, "mp4"))
+			if(::hasExtension(avatar->materials[i]->colour_texture_url.str(), "gif") || ::hasExtensionStringView(avatar->materials[i]->colour_texture_url.str(), "mp4"))
 			{
 				//Reference<AnimatedTexObData> anim_data = new AnimatedTexObData();
 				this->obs_with_animated_tex.insert(std::make_pair(ob, AnimatedTexObData()));
@@ -3174,7 +3174,7 @@ void GUIClient::loadAudioForObject(WorldObject* ob, const Reference<LoadedBuffer
 				{
 					//if(!isAudioProcessed(ob->audio_source_url)) // If we are not already loading the audio:
 
-					if(hasExtension(ob->audio_source_url, "mp3"))
+					if(hasExtension(ob->audio_source_url.str(), "mp3"))
 					{
 						// Make a new audio source
 						glare::AudioEngine::AddSourceFromStreamingSoundFileParams params;
@@ -5155,18 +5155,13 @@ void GUIClient::timerEvent(const MouseCursorState& mouse_cursor_state)
 				{
 					script_evaluator->doOnTimerEvent(timer.onTimerEvent_ref, lock); // Execute the Lua timer event callback function
 
-					if(timer.repeating)
-					{
-						// Re-insert timer with updated trigger time
-						timer.tigger_time = cur_time + timer.period;
-						timer_queue.addTimer(cur_time, timer);
-					}
-					else // Else if timer was a one-shot timer, 'destroy' it.
-					{
+					// Repeating timers are rescheduled by the timer queue.  If timer was a one-shot timer, 'destroy' it.
+					if(!timer.repeating && (timer.timer_id == script_evaluator->timers[timer.timer_index].id))
 						script_evaluator->destroyTimer(timer.timer_index);
-					}
 				}
 			}
+			else
+				timer_queue.removeTimer(timer.handle); // Script evaluator has been destroyed, remove the timer if it is repeating.
 		}
 	}
 
@@ -5174,6 +5169,10 @@ void GUIClient::timerEvent(const MouseCursorState& mouse_cursor_state)
 	if(gl_ui.nonNull())
 		gl_ui->think();
 
+	// Flush any voxel edits once the user has paused editing for a moment, so a burst of edits results in a single compression, undo edit and object update message.
+	if(voxel_edit_ob.nonNull() && (time_since_voxel_edit.elapsed() > 1.0))
+		flushVoxelEdits();
+
 	// If we are connected to a server, send a UDP packet to it occasionally, so the server can work out which UDP port
 	// we are listening on.
 #if !defined(EMSCRIPTEN)
@@ -6800,6 +6799,9 @@ void GUIClient::timerEvent(const MouseCursorState& mouse_cursor_state)
 	if(frame_num % 8 == 0)
 		checkForAudioRangeChanges();
 
+	if(frame_num % 1024 == 512)
+		URLAtomTable::getGlobalTable().removeUnreferencedAtoms(); // Remove URLs no longer used by any object or material.
+
 	if(terrain_system.nonNull())
 		terrain_system->updateCampos(this->cam_controller.getPosition(), stack_allocator);
 
@@ -9096,6 +9098,12 @@ std::string GUIClient::getDiagnosticsString(bool do_graphics_diagnostics, bool d
 	msg += resource_manager->getDiagnostics();
 	msg += "----------------------------------------\n";
 
+	{
+		const URLAtomTable::Stats stats = URLAtomTable::getGlobalTable().getStats();
+		msg += "URL atoms: " + toString(stats.num_atoms) + " (" + toString(stats.num_references) + " refs, " + getNiceByteSize(stats.total_string_size_B) + ", est. saved: " + 
+			getNiceByteSize((uint64)myMax<int64>(0, stats.bytes_saved)) + ")\n";
+	}
+
 	{
 		msg += "\nAudio engine:\n";
 		{
@@ -9724,7 +9732,7 @@ void GUIClient::setMaterialFlagsForObject(WorldObject* ob)
 		{
 			if(!mat->colour_texture_url.empty())
 			{
-				if(FileUtils::fileExists(mat->colour_texture_url)) // If this was a local path:
+				if(FileUtils::fileExists(mat->colour_texture_url.str())) // If this was a local path:
 				{
 					try
 					{
@@ -9884,7 +9892,7 @@ void GUIClient::createObjectLoadedFromXML(WorldObjectRef new_world_object, Print
 	{
 		BatchedMeshRef batched_mesh;
 	
-		if(FileUtils::fileExists(new_world_object->model_url)) // If model_url is a local file path:
+		if(FileUtils::fileExists(new_world_object->model_url.str())) // If model_url is a local file path:
 		{
 			const std::string original_mesh_path = toStdString(new_world_object->model_url);
 
@@ -10211,6 +10219,8 @@ void GUIClient::applyUndoOrRedoObject(const WorldObjectRef& restored_ob)
 {
 	if(restored_ob.nonNull())
 	{
+		flushVoxelEdits(); // Compress any pending voxel edits and finish their undo edit, before the object state is replaced below.
+
 		{
 			Lock lock(this->world_state->mutex);
 
@@ -10966,6 +10976,8 @@ void GUIClient::objectTransformEdited()
 {
 	if(this->selected_ob.nonNull())
 	{
+		flushVoxelEdits();
+
 		// Multiple edits using the object editor, in a short timespan, will be merged together,
 		// unless force_new_undo_edit is true (is set when undo or redo is issued).
 		const bool start_new_edit = force_new_undo_edit || (time_since_object_edited.elapsed() > 5.0);
@@ -11069,6 +11081,8 @@ void GUIClient::objectEdited()
 	// Update object material(s) with values from editor.
 	if(this->selected_ob.nonNull())
 	{
+		flushVoxelEdits();
+
 		// Multiple edits using the object editor, in a short timespan, will be merged together,
 		// unless force_new_undo_edit is true (is set when undo or redo is issued).
 		const bool start_new_edit = force_new_undo_edit || (time_since_object_edited.elapsed() > 5.0);
@@ -11243,8 +11257,8 @@ void GUIClient::objectEdited()
 			
 				selected_ob->physics_object->kinematic = !selected_ob->script.empty();
 				selected_ob->physics_object->dynamic = selected_ob->isDynamic();
-				selected_ob->physics_object->is_sphere = FileUtils::getFilenameStringView(selected_ob->model_url) == "Icosahedron_obj_136334556484365507.bmesh";
-				selected_ob->physics_object->is_cube = FileUtils::getFilenameStringView(selected_ob->model_url) == "Cube_obj_11907297875084081315.bmesh";
+				selected_ob->physics_object->is_sphere = FileUtils::getFilenameStringView(selected_ob->model_url.str()) == "Icosahedron_obj_136334556484365507.bmesh";
+				selected_ob->physics_object->is_cube = FileUtils::getFilenameStringView(selected_ob->model_url.str()) == "Cube_obj_11907297875084081315.bmesh";
 
 				selected_ob->physics_object->mass = selected_ob->mass;
 				selected_ob->physics_object->friction = selected_ob->friction;
@@ -11946,6 +11960,10 @@ void GUIClient::disconnectFromServerAndClearAllObjects() // Remove any WorldObje
 	selected_ob = NULL;
 	selected_parcel = NULL;
 
+	// Discard any unflushed voxel edits, we can't send them to the server any more.
+	voxel_edit_ob = NULL;
+	voxel_edit_mesher = NULL;
+
 
 	active_objects.clear();
 	obs_with_animated_tex.clear();
@@ -12602,6 +12620,7 @@ void GUIClient::mousePressed(MouseEvent& e)
 				// But when we have grabbed an arrow or rotation arc, it moves the object instead.  So don't rotate the camera.
 				ui_interface->setCamRotationOnMouseDragEnabled(false);
 
+				flushVoxelEdits();
 				undo_buffer.startWorldObjectEdit(*this->selected_ob);
 			}
 
@@ -12650,7 +12669,10 @@ void GUIClient::mousePressed(MouseEvent& e)
 
 			if(selected_ob.nonNull())
 			{
-				selected_ob->decompressVoxels(); // Make sure voxels are decompressed for this object.
+				// Make sure voxels are decompressed for this object.
+				// Don't decompress if we are batching voxel edits for this object though, since the decompressed voxels contain edits that haven't been compressed yet.
+				if(selected_ob.ptr() != voxel_edit_ob.ptr())
+					selected_ob->decompressVoxels();
 
 				if(BitUtils::isBitSet(e.modifiers, (uint32)Modifiers::Ctrl) || BitUtils::isBitSet(e.modifiers, (uint32)Modifiers::Alt)) // If user is trying to edit voxels:
 				{
@@ -12672,7 +12694,7 @@ void GUIClient::mousePressed(MouseEvent& e)
 							const float dist_from_aabb = selected_ob->opengl_engine_ob.nonNull() ? selected_ob->opengl_engine_ob->aabb_ws.distanceToPoint(point_off_surface) : 0.f;
 							if(dist_from_aabb < 2.f)
 							{
-								undo_buffer.startWorldObjectEdit(*selected_ob);
+								beginVoxelEdit(this->selected_ob);
 
 								const Vec4f point_os = world_to_ob * point_off_surface;
 								const Vec4f point_os_voxel_space = point_os / current_voxel_w;
@@ -12683,9 +12705,20 @@ void GUIClient::mousePressed(MouseEvent& e)
 								this->selected_ob->getDecompressedVoxels().back().pos = voxel_indices;
 								this->selected_ob->getDecompressedVoxels().back().mat_index = ui_interface->getSelectedMatIndex();
 
-								voxels_changed = true;
+								if(voxel_edit_mesher.nonNull())
+								{
+									try
+									{
+										voxel_edit_mesher->setVoxel(voxel_indices, ui_interface->getSelectedMatIndex());
+									}
+									catch(glare::Exception& e)
+									{
+										conPrint("Failed to set voxel in incremental voxel mesher, will re-mesh whole object for edits: " + e.what());
+										voxel_edit_mesher = NULL;
+									}
+								}
 
-								undo_buffer.finishWorldObjectEdit(*selected_ob);
+								voxels_changed = true;
 							}
 							else
 							{
@@ -12696,7 +12729,7 @@ void GUIClient::mousePressed(MouseEvent& e)
 						{
 							if(this->selected_ob->getDecompressedVoxels().size() > 1)
 							{
-								undo_buffer.startWorldObjectEdit(*selected_ob);
+								beginVoxelEdit(this->selected_ob);
 
 								const Vec4f point_under_surface = hitpos_ws - results.hit_normal_ws * (current_voxel_w * 1.0e-3f);
 
@@ -12705,15 +12738,18 @@ void GUIClient::mousePressed(MouseEvent& e)
 								Vec3<int> voxel_indices((int)floor(point_os_voxel_space[0]), (int)floor(point_os_voxel_space[1]), (int)floor(point_os_voxel_space[2]));
 
 								// Remove the voxel, if present
-								for(size_t z=0; z<this->selected_ob->getDecompressedVoxels().size(); ++z)
+								for(size_t z=0; z<this->selected_ob->getDecompressedVoxels().size(); )
 								{
 									if(this->selected_ob->getDecompressedVoxels()[z].pos == voxel_indices)
 										this->selected_ob->getDecompressedVoxels().erase(this->selected_ob->getDecompressedVoxels().begin() + z);
+									else
+										++z;
 								}
 
-								voxels_changed = true;
+								if(voxel_edit_mesher.nonNull())
+									voxel_edit_mesher->removeVoxel(voxel_indices);
 
-								undo_buffer.finishWorldObjectEdit(*selected_ob);
+								voxels_changed = true;
 							}
 							else
 							{
@@ -12723,7 +12759,7 @@ void GUIClient::mousePressed(MouseEvent& e)
 
 						if(voxels_changed)
 						{
-							updateObjectModelForChangedDecompressedVoxels(this->selected_ob);
+							updateObjectModelForVoxelEdits(this->selected_ob);
 						}
 					}
 				}
@@ -12804,6 +12840,11 @@ void GUIClient::mouseDoubleClicked(MouseEvent& mouse_event)
 
 void GUIClient::updateObjectModelForChangedDecompressedVoxels(WorldObjectRef& ob)
 {
+	// Any incremental voxel mesher for the object is out of date now.  Finish the pending voxel edit (compressing it and finishing the undo edit) before discarding the mesher.
+	// Callers should already have flushed voxel edits before changing the decompressed voxels, so this is just a safety net.
+	if(voxel_edit_ob.ptr() == ob.ptr())
+		flushVoxelEdits();
+
 	Lock lock(this->world_state->mutex);
 
 	ob->compressVoxels();
@@ -12813,6 +12854,34 @@ void GUIClient::updateObjectModelForChangedDecompressedVoxels(WorldObjectRef& ob
 	// Clear lightmap URL, since the lightmap will be invalid now the voxels (and hence the UV map) will have changed.
 	ob->lightmap_url = "";
 
+	Reference<OpenGLMeshRenderData> gl_meshdata;
+	PhysicsShape physics_shape;
+	if(!ob->getDecompressedVoxels().empty())
+	{
+		const Matrix4f ob_to_world = obToWorldMatrix(*ob);
+
+		js::Vector<bool, 16> mat_transparent(ob->materials.size());
+		for(size_t i=0; i<ob->materials.size(); ++i)
+			mat_transparent[i] = ob->materials[i]->opacity.val < 1.f;
+
+		const int subsample_factor = 1;
+		gl_meshdata = ModelLoading::makeModelForVoxelGroup(ob->getDecompressedVoxelGroup(), subsample_factor, ob_to_world,
+			opengl_engine->vert_buf_allocator.ptr(), /*do_opengl_stuff=*/true, /*need_lightmap_uvs=*/false, mat_transparent, /*build_dynamic_physics_ob=*/ob->isDynamic(),
+			worker_allocator.ptr(),
+			physics_shape);
+	}
+
+	setVoxelObjectModel(ob, gl_meshdata, physics_shape);
+
+	// Mark as from-local-dirty to send an object updated message to the server
+	ob->from_local_other_dirty = true;
+	this->world_state->dirty_from_local_objects.insert(ob);
+}
+
+
+// Removes any existing OpenGL and physics model for the voxel object, and adds new ones for gl_meshdata and physics_shape, if gl_meshdata is non-null.
+void GUIClient::setVoxelObjectModel(WorldObjectRef& ob, Reference<OpenGLMeshRenderData> gl_meshdata, const PhysicsShape& physics_shape)
+{
 	// Remove any existing OpenGL and physics model
 	if(ob->opengl_engine_ob)
 	{
@@ -12833,24 +12902,13 @@ void GUIClient::updateObjectModelForChangedDecompressedVoxels(WorldObjectRef& ob
 	// Update in Indigo view
 	//ui->indigoView->objectRemoved(*ob);
 
-	if(!ob->getDecompressedVoxels().empty())
+	if(gl_meshdata.nonNull())
 	{
 		const Matrix4f ob_to_world = obToWorldMatrix(*ob);
 
 		const int ob_lod_level = ob->getLODLevel(cam_controller.getPosition());
 
-		js::Vector<bool, 16> mat_transparent(ob->materials.size());
-		for(size_t i=0; i<ob->materials.size(); ++i)
-			mat_transparent[i] = ob->materials[i]->opacity.val < 1.f;
-
 		// Add updated model!
-		PhysicsShape physics_shape;
-		const int subsample_factor = 1;
-		Reference<OpenGLMeshRenderData> gl_meshdata = ModelLoading::makeModelForVoxelGroup(ob->getDecompressedVoxelGroup(), subsample_factor, ob_to_world,
-			opengl_engine->vert_buf_allocator.ptr(), /*do_opengl_stuff=*/true, /*need_lightmap_uvs=*/false, mat_transparent, /*build_dynamic_physics_ob=*/ob->isDynamic(),
-			worker_allocator.ptr(),
-			physics_shape);
-
 		GLObjectRef gl_ob = opengl_engine->allocateObject();
 		gl_ob->ob_to_world_matrix = ob_to_world;
 		gl_ob->mesh_data = gl_meshdata;
@@ -12898,10 +12956,110 @@ void GUIClient::updateObjectModelForChangedDecompressedVoxels(WorldObjectRef& ob
 
 		ob->setAABBOS(gl_meshdata->aabb_os);
 	}
+}
 
-	// Mark as from-local-dirty to send an object updated message to the server
-	ob->from_local_other_dirty = true;
-	this->world_state->dirty_from_local_objects.insert(ob);
+
+// Called before the decompressed voxels of ob are edited.  Starts a new voxel edit if ob is not the object currently being voxel-edited.
+void GUIClient::beginVoxelEdit(WorldObjectRef& ob)
+{
+	if(voxel_edit_ob.ptr() != ob.ptr())
+	{
+		flushVoxelEdits();
+
+		undo_buffer.startWorldObjectEdit(*ob);
+
+		voxel_edit_ob = ob;
+		voxel_edit_mesher = new IncrementalVoxelMesher();
+		try
+		{
+			voxel_edit_mesher->build(ob->getDecompressedVoxelGroup());
+		}
+		catch(glare::Exception& e)
+		{
+			conPrint("Failed to build incremental voxel mesher, will re-mesh whole object for edits: " + e.what());
+			voxel_edit_mesher = NULL;
+		}
+	}
+
+	time_since_voxel_edit.reset();
+}
+
+
+// Updates the OpenGL and physics model for the object being voxel-edited, after edits to the decompressed voxels (and voxel_edit_mesher).
+// Doesn't compress the voxels or send the changes to the server, that is done in flushVoxelEdits().
+//
+// Only the edited sub-chunks are re-meshed, but the sub-chunk meshes are still concatenated and the whole vertex buffer uploaded, and a new compound 
+// physics shape is built, for each edit.  So the GPU upload and physics shape cost per edit is still proportional to the size of the whole object.
+// TODO: Upload only the changed sub-chunks (e.g. a GL object or vertex buffer sub-range per sub-chunk), and update only the changed physics sub-shapes
+// (e.g. with a mutable compound shape).
+void GUIClient::updateObjectModelForVoxelEdits(WorldObjectRef& ob)
+{
+	assert(voxel_edit_ob.ptr() == ob.ptr());
+
+	Lock lock(this->world_state->mutex);
+
+	ob->last_modified_time = TimeStamp::currentTime(); // Gets set on server as well, this is just for updating the local display.
+
+	// Clear lightmap URL, since the lightmap will be invalid now the voxels (and hence the UV map) will have changed.
+	ob->lightmap_url = "";
+
+	js::Vector<bool, 16> mat_transparent(ob->materials.size());
+	for(size_t i=0; i<ob->materials.size(); ++i)
+		mat_transparent[i] = ob->materials[i]->opacity.val < 1.f;
+
+	Reference<OpenGLMeshRenderData> gl_meshdata;
+	PhysicsShape physics_shape;
+	if(voxel_edit_mesher.nonNull())
+	{
+		// Jolt doesn't support dynamic mesh shapes, so dynamic objects get a convex hull of the combined mesh instead of sub-chunk physics shapes.
+		voxel_edit_mesher->updateDirtySubChunks(mat_transparent, /*build_physics=*/!ob->isDynamic(), worker_allocator.ptr());
+
+		Reference<Indigo::Mesh> indigo_mesh = voxel_edit_mesher->buildCombinedMesh();
+		if(indigo_mesh.nonNull())
+		{
+			gl_meshdata = ModelLoading::makeModelForVoxelIndigoMesh(*indigo_mesh, opengl_engine->vert_buf_allocator.ptr(), /*do_opengl_stuff=*/true, worker_allocator.ptr());
+
+			if(ob->isDynamic())
+				physics_shape = PhysicsWorld::createJoltShapeForIndigoMesh(*indigo_mesh, /*build_dynamic_physics_ob=*/true, worker_allocator.ptr());
+			else
+				physics_shape = voxel_edit_mesher->buildCombinedPhysicsShape();
+		}
+	}
+	else if(!ob->getDecompressedVoxels().empty())
+	{
+		const int subsample_factor = 1;
+		gl_meshdata = ModelLoading::makeModelForVoxelGroup(ob->getDecompressedVoxelGroup(), subsample_factor, obToWorldMatrix(*ob),
+			opengl_engine->vert_buf_allocator.ptr(), /*do_opengl_stuff=*/true, /*need_lightmap_uvs=*/false, mat_transparent, /*build_dynamic_physics_ob=*/ob->isDynamic(),
+			worker_allocator.ptr(),
+			physics_shape);
+	}
+
+	setVoxelObjectModel(ob, gl_meshdata, physics_shape);
+}
+
+
+// Compresses the voxels of the object being voxel-edited, finishes the undo edit, and marks the object as dirty so the changes are sent to the server.
+void GUIClient::flushVoxelEdits()
+{
+	if(voxel_edit_ob.isNull())
+		return;
+
+	WorldObjectRef ob = voxel_edit_ob;
+	voxel_edit_ob = NULL;
+	voxel_edit_mesher = NULL;
+
+	{
+		Lock lock(this->world_state->mutex);
+
+		ob->compressVoxels();
+
+		// Mark as from-local-dirty to send an object updated message to the server
+		ob->from_local_other_dirty = true;
+		this->world_state->dirty_from_local_objects.insert(ob);
+	}
+
+	undo_buffer.finishWorldObjectEdit(*ob);
+	force_new_undo_edit = true; // Don't merge following object editor edits into this edit.
 }
 
 
@@ -12936,6 +13094,7 @@ void GUIClient::pickUpSelectedObject()
 
 			selected_ob_picked_up = true;
 
+			flushVoxelEdits();
 			undo_buffer.startWorldObjectEdit(*selected_ob);
 
 			// Play pick up sound, in the direction of the selection point
@@ -13430,6 +13589,8 @@ void GUIClient::deleteSelectedObject()
 	{
 		if(objectModificationAllowedWithMsg(*this->selected_ob, "delete"))
 		{
+			flushVoxelEdits();
+
 			undo_buffer.startWorldObjectEdit(*selected_ob);
 			undo_buffer.finishWorldObjectEdit(*selected_ob);
 
@@ -13704,6 +13865,8 @@ void GUIClient::selectObject(const WorldObjectRef& ob, int selected_mat_index)
 
 void GUIClient::deselectObject()
 {
+	flushVoxelEdits();
+
 	if(this->selected_ob.nonNull())
 	{
 		this->selected_ob->is_selected = false;
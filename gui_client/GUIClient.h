@@ -7,6 +7,7 @@ Copyright Glare Technologies Limited 2024 -
 
 
 #include "PhysicsWorld.h"
+#include "IncrementalVoxelMesher.h"
 #include "PlayerPhysics.h"
 #include "CameraController.h"
 #include "UIInterface.h"
@@ -323,6 +324,13 @@ public:
 	void doMoveAndRotateObject(WorldObjectRef ob, const Vec3d& new_ob_pos, const Vec3f& new_axis, float new_angle, const js::AABBox& aabb_os, bool summoning_object) REQUIRES(world_state->mutex);
 
 	void updateObjectModelForChangedDecompressedVoxels(WorldObjectRef& ob);
+	void setVoxelObjectModel(WorldObjectRef& ob, Reference<OpenGLMeshRenderData> gl_meshdata, const PhysicsShape& physics_shape) REQUIRES(world_state->mutex);
+
+	// Voxel edits are applied to an IncrementalVoxelMesher, so only the affected sub-chunks are re-meshed.  Voxel compression, the undo edit and the
+	// object update message to the server are deferred until flushVoxelEdits() is called, which happens when the user stops editing for a while.
+	void beginVoxelEdit(WorldObjectRef& ob);
+	void updateObjectModelForVoxelEdits(WorldObjectRef& ob);
+	void flushVoxelEdits();
 
 	void createObject(const std::string& mesh_path, BatchedMeshRef loaded_mesh, bool loaded_mesh_is_image_cube,
 		const glare::AllocatorVector<Voxel, 16>& decompressed_voxels, const Vec3d& ob_pos, const Vec3f& scale, const Vec3f& axis, float angle, const std::vector<WorldMaterialRef>& materials);
@@ -634,6 +642,10 @@ public:
 
 	UID last_restored_ob_uid_in_edit;
 
+	WorldObjectRef voxel_edit_ob; // Object whose voxels are currently being edited, with edits not flushed yet.  NULL if none.
+	IncrementalVoxelMesherRef voxel_edit_mesher; // May be NULL if the voxels of voxel_edit_ob couldn't be stored in bricks.
+	Timer time_since_voxel_edit;
+
 	GLUIRef gl_ui;
 	GestureUI gesture_ui; // Draws gesture buttons, also selfie and enable mic button
 	ObInfoUI ob_info_ui; // For object info and hyperlinks etc.
@@ -0,0 +1,443 @@
+/*=====================================================================
+IncrementalVoxelMesher.cpp
+--------------------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#include "IncrementalVoxelMesher.h"
+
+
+#include "PhysicsWorld.h"
+#include "../shared/VoxelMeshBuilding.h"
+#include "../shared/WorldObject.h"
+#include <utils/Exception.h>
+#include <utils/StringUtils.h>
+#include <algorithm>
+#include <tracy/Tracy.hpp>
+
+
+IncrementalVoxelMesher::IncrementalVoxelMesher()
+{}
+
+
+IncrementalVoxelMesher::~IncrementalVoxelMesher()
+{}
+
+
+void IncrementalVoxelMesher::build(const VoxelGroup& voxel_group)
+{
+	ZoneScoped; // Tracy profiler
+
+	sub_chunks.clear();
+	dirty_brick_coords.clear();
+
+	bricks.build(voxel_group, /*subsample_factor=*/1);
+
+	std::vector<Vec3<int> > brick_coords;
+	bricks.getSortedBrickCoords(brick_coords);
+	for(size_t i=0; i<brick_coords.size(); ++i)
+		dirty_brick_coords.insert(brick_coords[i]);
+}
+
+
+bool IncrementalVoxelMesher::setVoxel(const Vec3<int>& pos, int mat_index)
+{
+	if(bricks.getVoxel(pos) == mat_index)
+		return false; // No change, so don't need to mark anything as dirty.
+
+	const bool added = bricks.setVoxel(pos, mat_index);
+	markDirtyForVoxelPos(pos);
+	return added;
+}
+
+
+bool IncrementalVoxelMesher::removeVoxel(const Vec3<int>& pos)
+{
+	const bool removed = bricks.removeVoxel(pos);
+	if(removed)
+		markDirtyForVoxelPos(pos);
+	return removed;
+}
+
+
+void IncrementalVoxelMesher::markDirtyForVoxelPos(const Vec3<int>& pos)
+{
+	const Vec3<int> brick_coords = VoxelBricks::brickCoordsForPos(pos);
+	dirty_brick_coords.insert(brick_coords);
+
+	// If the voxel is on the boundary of the brick, faces of voxels in the adjacent brick may now be culled or exposed.
+	for(int dim=0; dim<3; ++dim)
+	{
+		const int local_coord = pos[dim] & VoxelBrick::W_MASK;
+		if(local_coord == 0 || local_coord == VoxelBrick::W - 1)
+		{
+			Vec3<int> adjacent_brick_coords = brick_coords;
+			adjacent_brick_coords[dim] += (local_coord == 0) ? -1 : 1;
+			dirty_brick_coords.insert(adjacent_brick_coords);
+		}
+	}
+}
+
+
+size_t IncrementalVoxelMesher::updateDirtySubChunks(const js::Vector<bool, 16>& mats_transparent, bool build_physics, glare::Allocator* mem_allocator)
+{
+	ZoneScoped; // Tracy profiler
+
+	size_t num_remeshed = 0;
+	for(auto it = dirty_brick_coords.begin(); it != dirty_brick_coords.end(); ++it)
+	{
+		const Vec3<int> brick_coords = *it;
+		if(!bricks.getBrick(brick_coords)) // If the brick is empty now (or never existed, for an adjacent brick):
+		{
+			sub_chunks.erase(brick_coords);
+			continue;
+		}
+
+		SubChunk& sub_chunk = sub_chunks[brick_coords];
+		sub_chunk.mesh = VoxelMeshBuilding::makeIndigoMeshForVoxelBrick(bricks, brick_coords, mats_transparent, mem_allocator);
+		sub_chunk.physics_shape = PhysicsShape();
+		num_remeshed++;
+	}
+	dirty_brick_coords.clear();
+
+	// Build any missing physics shapes.  Physics shapes may be missing for non-dirty sub-chunks if they were last updated with build_physics = false.
+	if(build_physics)
+	{
+		for(auto it = sub_chunks.begin(); it != sub_chunks.end(); ++it)
+		{
+			SubChunk& sub_chunk = it->second;
+			if(sub_chunk.mesh.nonNull() && sub_chunk.physics_shape.jolt_shape == nullptr)
+				sub_chunk.physics_shape = PhysicsWorld::createJoltShapeForIndigoMesh(*sub_chunk.mesh, /*build_dynamic_physics_ob=*/false, mem_allocator);
+		}
+	}
+
+	return num_remeshed;
+}
+
+
+void IncrementalVoxelMesher::getSortedSubChunkCoords(std::vector<Vec3<int> >& coords_out) const
+{
+	coords_out.resize(0);
+	for(auto it = sub_chunks.begin(); it != sub_chunks.end(); ++it)
+		if(it->second.mesh.nonNull())
+			coords_out.push_back(it->first);
+
+	// Sort so that the combined mesh doesn't depend on the hash map iteration order.
+	std::sort(coords_out.begin(), coords_out.end(), [](const Vec3<int>& a, const Vec3<int>& b) {
+		if(a.z != b.z) return a.z < b.z;
+		if(a.y != b.y) return a.y < b.y;
+		return a.x < b.x;
+	});
+}
+
+
+Reference<Indigo::Mesh> IncrementalVoxelMesher::buildCombinedMesh() const
+{
+	ZoneScoped; // Tracy profiler
+
+	assert(dirty_brick_coords.empty());
+
+	std::vector<Vec3<int> > coords;
+	getSortedSubChunkCoords(coords);
+	if(coords.empty())
+		return Reference<Indigo::Mesh>();
+
+	size_t total_num_verts = 0;
+	size_t total_num_tris = 0;
+	for(size_t i=0; i<coords.size(); ++i)
+	{
+		const Indigo::Mesh& sub_mesh = *sub_chunks.find(coords[i])->second.mesh;
+		total_num_verts += sub_mesh.vert_positions.size();
+		total_num_tris += sub_mesh.triangles.size();
+	}
+
+	try
+	{
+		Reference<Indigo::Mesh> mesh = new Indigo::Mesh();
+		mesh->setMaxNumTexcoordSets(0);
+		mesh->vert_positions.resize(total_num_verts);
+		mesh->triangles.resize(total_num_tris);
+
+		size_t vert_offset = 0;
+		size_t tri_offset = 0;
+		for(size_t i=0; i<coords.size(); ++i)
+		{
+			const Indigo::Mesh& sub_mesh = *sub_chunks.find(coords[i])->second.mesh;
+
+			for(size_t v=0; v<sub_mesh.vert_positions.size(); ++v)
+				mesh->vert_positions[vert_offset + v] = sub_mesh.vert_positions[v];
+
+			for(size_t t=0; t<sub_mesh.triangles.size(); ++t)
+			{
+				Indigo::Triangle tri = sub_mesh.triangles[t];
+				for(int c=0; c<3; ++c)
+					tri.vertex_indices[c] += (uint32)vert_offset;
+				mesh->triangles[tri_offset + t] = tri;
+			}
+
+			vert_offset += sub_mesh.vert_positions.size();
+			tri_offset += sub_mesh.triangles.size();
+		}
+
+		mesh->endOfModel();
+		return mesh;
+	}
+	catch(Indigo::IndigoException& e)
+	{
+		throw glare::Exception(toStdString(e.what()));
+	}
+}
+
+
+PhysicsShape IncrementalVoxelMesher::buildCombinedPhysicsShape() const
+{
+	ZoneScoped; // Tracy profiler
+
+	std::vector<Vec3<int> > coords;
+	getSortedSubChunkCoords(coords);
+	if(coords.empty())
+		return PhysicsShape();
+
+	std::vector<PhysicsShape> sub_shapes(coords.size());
+	for(size_t i=0; i<coords.size(); ++i)
+	{
+		sub_shapes[i] = sub_chunks.find(coords[i])->second.physics_shape;
+		if(sub_shapes[i].jolt_shape == nullptr)
+			throw glare::Exception("Sub-chunk physics shape has not been built.");
+	}
+
+	if(sub_shapes.size() == 1)
+		return sub_shapes[0];
+
+	return PhysicsWorld::createStaticCompoundShape(sub_shapes);
+}
+
+
+#if BUILD_TESTS
+
+
+#include <utils/TestUtils.h>
+#include <utils/ConPrint.h>
+#include <utils/Timer.h>
+#include <maths/PCG32.h>
+
+
+// Checks the combined mesh is the same as a mesh built from scratch from the current voxels.
+// Since the sub-chunks are meshed per brick, in sorted brick order, the triangles should be the same and in the same order, although vertices are not shared between bricks.
+static void checkCombinedMeshMatchesFullMesh(const IncrementalVoxelMesher& mesher, const js::Vector<bool, 16>& mats_transparent)
+{
+	Reference<Indigo::Mesh> combined_mesh = mesher.buildCombinedMesh();
+	if(mesher.getBricks().numVoxels() == 0)
+	{
+		testAssert(combined_mesh.isNull());
+		return;
+	}
+
+	Reference<Indigo::Mesh> full_mesh = VoxelMeshBuilding::makeIndigoMeshForVoxelBricks(mesher.getBricks(), mats_transparent, /*mem_allocator=*/NULL);
+	testAssert(combined_mesh.nonNull());
+	testEqual(combined_mesh->triangles.size(), full_mesh->triangles.size());
+
+	for(size_t t=0; t<full_mesh->triangles.size(); ++t)
+	{
+		const Indigo::Triangle& a = combined_mesh->triangles[t];
+		const Indigo::Triangle& b = full_mesh->triangles[t];
+		testAssert(a.tri_mat_index == b.tri_mat_index);
+		for(int c=0; c<3; ++c)
+		{
+			const Indigo::Vec3f& pa = combined_mesh->vert_positions[a.vertex_indices[c]];
+			const Indigo::Vec3f& pb = full_mesh->vert_positions[b.vertex_indices[c]];
+			testAssert(pa.x == pb.x && pa.y == pb.y && pa.z == pb.z);
+		}
+	}
+}
+
+
+void IncrementalVoxelMesher::test()
+{
+	conPrint("IncrementalVoxelMesher::test()");
+
+	js::Vector<bool, 16> mats_transparent(3);
+	mats_transparent[0] = false;
+	mats_transparent[1] = false;
+	mats_transparent[2] = true;
+
+	// Test incrementality: edits in the interior of a brick should only re-mesh that brick.
+	{
+		VoxelGroup group;
+		for(int x=0; x<64; ++x)
+		for(int y=0; y<8; ++y)
+			group.voxels.push_back(Voxel(Vec3<int>(x, y, 0), /*mat index=*/0));
+
+		IncrementalVoxelMesher mesher;
+		mesher.build(group);
+		testEqual(mesher.numDirtySubChunks(), (size_t)2);
+		testEqual(mesher.updateDirtySubChunks(mats_transparent, /*build_physics=*/true, NULL), (size_t)2);
+		testEqual(mesher.numSubChunks(), (size_t)2);
+		checkCombinedMeshMatchesFullMesh(mesher, mats_transparent);
+		testAssert(mesher.buildCombinedPhysicsShape().jolt_shape != nullptr);
+
+		// Edit in the interior of brick (0, 0, 0).
+		testAssert(mesher.setVoxel(Vec3<int>(5, 5, 1), /*mat index=*/1));
+		testEqual(mesher.updateDirtySubChunks(mats_transparent, /*build_physics=*/true, NULL), (size_t)1);
+		checkCombinedMeshMatchesFullMesh(mesher, mats_transparent);
+
+		// Setting the voxel to the same material shouldn't make anything dirty.
+		testAssert(!mesher.setVoxel(Vec3<int>(5, 5, 1), /*mat index=*/1));
+		testEqual(mesher.numDirtySubChunks(), (size_t)0);
+
+		// Edit on the boundary between bricks (0, 0, 0) and (1, 0, 0).  Both bricks should be re-meshed.
+		testAssert(mesher.removeVoxel(Vec3<int>(31, 3, 0)));
+		testEqual(mesher.updateDirtySubChunks(mats_transparent, /*build_physics=*/true, NULL), (size_t)2);
+		checkCombinedMeshMatchesFullMesh(mesher, mats_transparent);
+
+		// Removing a non-existent voxel shouldn't make anything dirty.
+		testAssert(!mesher.removeVoxel(Vec3<int>(100, 3, 0)));
+		testEqual(mesher.numDirtySubChunks(), (size_t)0);
+
+		// Adding a voxel in a new brick, on the boundary with an existing brick.
+		testAssert(mesher.setVoxel(Vec3<int>(5, 5, -1), /*mat index=*/0));
+		testEqual(mesher.updateDirtySubChunks(mats_transparent, /*build_physics=*/true, NULL), (size_t)2);
+		testEqual(mesher.numSubChunks(), (size_t)3);
+		checkCombinedMeshMatchesFullMesh(mesher, mats_transparent);
+
+		// Remove it again, the sub-chunk should be removed.
+		testAssert(mesher.removeVoxel(Vec3<int>(5, 5, -1)));
+		mesher.updateDirtySubChunks(mats_transparent, /*build_physics=*/true, NULL);
+		testEqual(mesher.numSubChunks(), (size_t)2);
+		checkCombinedMeshMatchesFullMesh(mesher, mats_transparent);
+	}
+
+	// Test a batch of voxel edits as done by GUIClient: the voxels are decompressed once when the edit starts, then several edits are made to the
+	// decompressed voxels and the mesher, and the voxels are only compressed when the edits are flushed.  All edits should reach the compressed voxels.
+	{
+		WorldObjectRef ob = new WorldObject();
+		ob->getDecompressedVoxels().push_back(Voxel(Vec3<int>(0, 0, 0), /*mat index=*/0));
+		ob->getDecompressedVoxels().push_back(Voxel(Vec3<int>(1, 0, 0), /*mat index=*/0));
+		ob->compressVoxels();
+
+		ob->decompressVoxels(); // Start of edit batch
+		IncrementalVoxelMesher mesher;
+		mesher.build(ob->getDecompressedVoxelGroup());
+
+		// First edit: add a voxel
+		ob->getDecompressedVoxels().push_back(Voxel(Vec3<int>(0, 1, 0), /*mat index=*/1));
+		testAssert(mesher.setVoxel(Vec3<int>(0, 1, 0), /*mat index=*/1));
+
+		// Second edit: remove a voxel.  The voxels must not be decompressed again before this, or the first edit would be lost.
+		for(size_t z=0; z<ob->getDecompressedVoxels().size(); )
+		{
+			if(ob->getDecompressedVoxels()[z].pos == Vec3<int>(1, 0, 0))
+				ob->getDecompressedVoxels().erase(ob->getDecompressedVoxels().begin() + z);
+			else
+				++z;
+		}
+		testAssert(mesher.removeVoxel(Vec3<int>(1, 0, 0)));
+
+		ob->compressVoxels(); // Flush
+
+		ob->decompressVoxels();
+		testEqual(ob->getDecompressedVoxels().size(), (size_t)2);
+		bool found_added = false;
+		for(size_t i=0; i<ob->getDecompressedVoxels().size(); ++i)
+		{
+			const Voxel& v = ob->getDecompressedVoxels()[i];
+			testAssert(!(v.pos == Vec3<int>(1, 0, 0))); // Removed voxel should be gone.
+			if(v.pos == Vec3<int>(0, 1, 0))
+			{
+				testAssert(v.mat_index == 1);
+				found_added = true;
+			}
+		}
+		testAssert(found_added);
+		testEqual(mesher.getBricks().numVoxels(), ob->getDecompressedVoxels().size());
+	}
+
+	// Test random edits against meshing from scratch.
+	{
+		PCG32 rng(1);
+		IncrementalVoxelMesher mesher;
+		VoxelGroup group;
+		group.voxels.push_back(Voxel(Vec3<int>(0, 0, 0), /*mat index=*/0));
+		mesher.build(group);
+
+		for(int i=0; i<3000; ++i)
+		{
+			const Vec3<int> pos((int)(rng.unitRandom() * 80) - 40, (int)(rng.unitRandom() * 80) - 40, (int)(rng.unitRandom() * 20) - 10);
+			if(rng.unitRandom() < 0.7f)
+				mesher.setVoxel(pos, /*mat index=*/(int)(rng.unitRandom() * 3));
+			else
+				mesher.removeVoxel(pos);
+
+			if(i % 100 == 0)
+			{
+				mesher.updateDirtySubChunks(mats_transparent, /*build_physics=*/(i % 200 == 0), NULL);
+				checkCombinedMeshMatchesFullMesh(mesher, mats_transparent);
+			}
+		}
+
+		mesher.updateDirtySubChunks(mats_transparent, /*build_physics=*/true, NULL);
+		checkCombinedMeshMatchesFullMesh(mesher, mats_transparent);
+		testAssert(mesher.buildCombinedPhysicsShape().jolt_shape != nullptr);
+
+		// Remove all voxels
+		VoxelGroup all_voxels;
+		mesher.getBricks().getVoxels(all_voxels);
+		for(size_t i=0; i<all_voxels.voxels.size(); ++i)
+			testAssert(mesher.removeVoxel(all_voxels.voxels[i].pos));
+		mesher.updateDirtySubChunks(mats_transparent, /*build_physics=*/true, NULL);
+		testEqual(mesher.numSubChunks(), (size_t)0);
+		testAssert(mesher.buildCombinedMesh().isNull());
+		testAssert(mesher.buildCombinedPhysicsShape().jolt_shape == nullptr);
+	}
+
+	// Perf test: Compare re-meshing the whole object with re-meshing just the sub-chunks affected by a single edit.
+	{
+		VoxelGroup group;
+		for(int x=0; x<256; ++x)
+		for(int y=0; y<256; ++y)
+		{
+			const int height = 20 + (int)(10 * std::sin(x * 0.1) * std::cos(y * 0.13));
+			for(int z=0; z<height; ++z)
+				group.voxels.push_back(Voxel(Vec3<int>(x, y, z), /*mat index=*/(z < height - 2) ? 0 : 1));
+		}
+
+		IncrementalVoxelMesher mesher;
+		mesher.build(group);
+		mesher.updateDirtySubChunks(mats_transparent, /*build_physics=*/true, NULL);
+
+		double full_time;
+		{
+			Timer timer;
+			PhysicsShape physics_shape;
+			Reference<Indigo::Mesh> mesh = VoxelMeshBuilding::makeIndigoMeshForVoxelGroup(group, /*subsample_factor=*/1, mats_transparent, NULL);
+			physics_shape = PhysicsWorld::createJoltShapeForIndigoMesh(*mesh, /*build_dynamic_physics_ob=*/false, NULL);
+			full_time = timer.elapsed();
+		}
+
+		double incremental_time;
+		{
+			Timer timer;
+			mesher.setVoxel(Vec3<int>(100, 100, 40), /*mat index=*/0);
+			const size_t num_remeshed = mesher.updateDirtySubChunks(mats_transparent, /*build_physics=*/true, NULL);
+			testEqual(num_remeshed, (size_t)1);
+			incremental_time = timer.elapsed();
+		}
+
+		double combine_time;
+		{
+			Timer timer;
+			Reference<Indigo::Mesh> mesh = mesher.buildCombinedMesh();
+			PhysicsShape physics_shape = mesher.buildCombinedPhysicsShape();
+			combine_time = timer.elapsed();
+		}
+
+		conPrint("Single voxel edit on object with " + toString(group.voxels.size()) + " voxels, " + toString(mesher.numSubChunks()) + " sub-chunks:");
+		conPrint("    full re-mesh + physics:        " + doubleToStringNSigFigs(full_time * 1.0e3, 4) + " ms");
+		conPrint("    sub-chunk re-mesh + physics:   " + doubleToStringNSigFigs(incremental_time * 1.0e3, 4) + " ms");
+		conPrint("    combining mesh + physics:      " + doubleToStringNSigFigs(combine_time * 1.0e3, 4) + " ms");
+	}
+
+	conPrint("IncrementalVoxelMesher::test() done.");
+}
+
+
+#endif // BUILD_TESTS
@@ -0,0 +1,92 @@
+/*=====================================================================
+IncrementalVoxelMesher.h
+------------------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#pragma once
+
+
+#include "PhysicsObject.h"
+#include "../shared/VoxelBricks.h"
+#include <dll/include/IndigoMesh.h>
+#include <utils/RefCounted.h>
+#include <utils/Reference.h>
+#include <utils/Vector.h>
+#include <unordered_map>
+#include <unordered_set>
+class VoxelGroup;
+namespace glare { class Allocator; }
+
+
+/*=====================================================================
+IncrementalVoxelMesher
+----------------------
+Keeps a mesh and a physics shape for each 32^3 voxel brick (sub-chunk) of a
+voxel object, so that when a voxel is added or removed only the affected
+sub-chunks need to be re-meshed, instead of the whole object.
+
+An edit marks the brick containing the voxel as dirty, as well as any
+adjacent brick that the voxel borders, since faces in that brick may now be
+culled or exposed.
+
+The per-sub-chunk meshes are concatenated into a single mesh for rendering
+with buildCombinedMesh(), and the physics sub-shapes are combined into a
+static compound shape with buildCombinedPhysicsShape(), which just references
+the sub-shapes.  Both of these are O(whole object), so only the meshing is
+incremental so far; see GUIClient::updateObjectModelForVoxelEdits().
+
+Used by GUIClient while the user is editing the voxels of an object.
+=====================================================================*/
+class IncrementalVoxelMesher : public RefCounted
+{
+public:
+	IncrementalVoxelMesher();
+	~IncrementalVoxelMesher();
+
+	// Clears, and builds bricks from the voxel group.  All sub-chunks will be dirty.
+	// Throws glare::Exception if the voxels can't be stored in bricks, see VoxelBricks::build().
+	void build(const VoxelGroup& voxel_group);
+
+	// Returns true if there was no voxel at the position before.
+	// Throws glare::Exception if the brick would reference too many materials.
+	bool setVoxel(const Vec3<int>& pos, int mat_index);
+
+	// Returns true if there was a voxel at the position.
+	bool removeVoxel(const Vec3<int>& pos);
+
+	// Re-meshes all dirty sub-chunks, and builds physics sub-shapes for them if build_physics is true.
+	// Returns the number of sub-chunks that were re-meshed.
+	size_t updateDirtySubChunks(const js::Vector<bool, 16>& mats_transparent, bool build_physics, glare::Allocator* mem_allocator);
+
+	// Concatenates the sub-chunk meshes.  Returns a NULL reference if there are no faces.
+	// updateDirtySubChunks() should have been called first.
+	Reference<Indigo::Mesh> buildCombinedMesh() const;
+
+	// Returns a static compound shape of the sub-chunk physics shapes.  Returns a shape with a NULL jolt_shape if there are no faces.
+	// updateDirtySubChunks() should have been called with build_physics = true first.
+	PhysicsShape buildCombinedPhysicsShape() const;
+
+	const VoxelBricks& getBricks() const { return bricks; }
+
+	size_t numSubChunks() const { return sub_chunks.size(); }
+	size_t numDirtySubChunks() const { return dirty_brick_coords.size(); }
+
+	static void test();
+
+private:
+	void markDirtyForVoxelPos(const Vec3<int>& pos);
+	void getSortedSubChunkCoords(std::vector<Vec3<int> >& coords_out) const;
+
+	struct SubChunk
+	{
+		Reference<Indigo::Mesh> mesh; // NULL if the brick has no faces.
+		PhysicsShape physics_shape; // jolt_shape is NULL if physics has not been built, or the brick has no faces.
+	};
+
+	VoxelBricks bricks;
+	std::unordered_map<Vec3<int>, SubChunk, BrickCoordsHasher> sub_chunks;
+	std::unordered_set<Vec3<int>, BrickCoordsHasher> dirty_brick_coords;
+};
+
+
+typedef Reference<IncrementalVoxelMesher> IncrementalVoxelMesherRef;
@@ -121,8 +121,8 @@ void ListObjectsNearbyDialog::updateResultsTable()
 				if(search_term.empty() || 
 					(search_term_is_integer && search_term_integer == (int)ob->uid.value()) || // If search term matches UID
 					StringUtils::containsStringCaseInvariant(ob->creator_name, search_term) ||
-					StringUtils::containsStringCaseInvariant(ob->model_url, search_term) ||
-					StringUtils::containsStringCaseInvariant(ob->audio_source_url, search_term) ||
+					StringUtils::containsStringCaseInvariant(ob->model_url.str(), search_term) ||
+					StringUtils::containsStringCaseInvariant(ob->audio_source_url.str(), search_term) ||
 					StringUtils::containsStringCaseInvariant(ob->script, search_term))
 				{
 					num_rows++;
@@ -143,8 +143,8 @@ void ListObjectsNearbyDialog::updateResultsTable()
 				if(search_term.empty() || 
 					(search_term_is_integer && search_term_integer == (int)ob->uid.value()) || // If search term matches UID
 					StringUtils::containsStringCaseInvariant(ob->creator_name, search_term) ||
-					StringUtils::containsStringCaseInvariant(ob->model_url, search_term) ||
-					StringUtils::containsStringCaseInvariant(ob->audio_source_url, search_term) ||
+					StringUtils::containsStringCaseInvariant(ob->model_url.str(), search_term) ||
+					StringUtils::containsStringCaseInvariant(ob->audio_source_url.str(), search_term) ||
 					StringUtils::containsStringCaseInvariant(ob->script, search_term))
 				{
 
@@ -185,10 +185,10 @@ void ListObjectsNearbyDialog::updateResultsTable()
 						objectTableWidget->setItem(row, 4, last_modified_time_ago_item);
 					}
 
-					QTableWidgetItem* model_URL_item = new QTableWidgetItem(QtUtils::toQString(ob->model_url));
+					QTableWidgetItem* model_URL_item = new QTableWidgetItem(QtUtils::toQString(ob->model_url.str()));
 					objectTableWidget->setItem(row, 5, model_URL_item);
 
-					QTableWidgetItem* audio_source_URL_item = new QTableWidgetItem(QtUtils::toQString(ob->audio_source_url));
+					QTableWidgetItem* audio_source_URL_item = new QTableWidgetItem(QtUtils::toQString(ob->audio_source_url.str()));
 					objectTableWidget->setItem(row, 6, audio_source_URL_item);
 
 					QTableWidgetItem* script_item = new QTableWidgetItem(QtUtils::toQString(ob->script.substr(0, 100)));
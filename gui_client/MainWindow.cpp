@@ -2934,6 +2934,8 @@ void MainWindow::on_actionUndo_triggered()
 {
 	try
 	{
+		gui_client.flushVoxelEdits(); // Make sure any pending voxel edits are in the undo buffer.
+
 		WorldObjectRef ob = gui_client.undo_buffer.getUndoWorldObject();
 		gui_client.applyUndoOrRedoObject(ob);
 	}
@@ -2948,6 +2950,8 @@ void MainWindow::on_actionRedo_triggered()
 {
 	try
 	{
+		gui_client.flushVoxelEdits(); // Make sure any pending voxel edits are in the undo buffer.
+
 		WorldObjectRef ob = gui_client.undo_buffer.getRedoWorldObject();
 		gui_client.applyUndoOrRedoObject(ob);
 	}
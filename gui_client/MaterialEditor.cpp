@@ -101,7 +101,7 @@ void MaterialEditor::setFromMaterial(const WorldMaterial& mat)
 {
 	// Set colour controls
 	col = mat.colour_rgb;
-	this->textureFileSelectWidget->setFilename(QtUtils::toQString(mat.colour_texture_url));
+	this->textureFileSelectWidget->setFilename(QtUtils::toQString(mat.colour_texture_url.str()));
 
 	SignalBlocker::setValue(this->textureXScaleDoubleSpinBox, mat.tex_matrix.elem(0, 0));
 	SignalBlocker::setValue(this->textureYScaleDoubleSpinBox, mat.tex_matrix.elem(1, 1));
@@ -112,12 +112,12 @@ void MaterialEditor::setFromMaterial(const WorldMaterial& mat)
 
 	this->metallicRoughnessFileSelectWidget->setFilename(QtUtils::toQString(mat.roughness.texture_url));
 	
-	this->normalMapFileSelectWidget->setFilename(QtUtils::toQString(mat.normal_map_url));
+	this->normalMapFileSelectWidget->setFilename(QtUtils::toQString(mat.normal_map_url.str()));
 
 	SignalBlocker::setChecked(this->hologramCheckBox, (mat.flags & WorldMaterial::HOLOGRAM_FLAG) != 0);
 
 	emission_col = mat.emission_rgb;
-	this->emissionTextureFileSelectWidget->setFilename(QtUtils::toQString(mat.emission_texture_url));
+	this->emissionTextureFileSelectWidget->setFilename(QtUtils::toQString(mat.emission_texture_url.str()));
 
 	SignalBlocker::setValue(this->luminanceDoubleSpinBox, mat.emission_lum_flux_or_lum);
 	
@@ -135,6 +135,12 @@ static void checkStringSize(URLString& s, size_t max_size)
 	if(s.size() > max_size)
 		s = s.substr(0, max_size);
 }
+static void checkStringSize(URLAtom& s, size_t max_size)
+{
+	// TODO: throw exception instead?
+	if(s.size() > max_size)
+		s = std::string_view(s).substr(0, max_size);
+}
 
 
 void MaterialEditor::toMaterial(WorldMaterial& mat_out)
@@ -73,10 +73,10 @@ static inline Colour3f sanitiseAndConvertToLinearEmissionColour(const Colour3f&
 void ModelLoading::setGLMaterialFromWorldMaterialWithLocalPaths(const WorldMaterial& mat, OpenGLMaterial& opengl_mat)
 {
 	opengl_mat.albedo_linear_rgb = sanitiseAndConvertToLinearAlbedoColour(mat.colour_rgb);
-	opengl_mat.tex_path = mat.colour_texture_url;
+	opengl_mat.tex_path = mat.colour_texture_url.str();
 
 	opengl_mat.emission_linear_rgb = sanitiseAndConvertToLinearEmissionColour(mat.emission_rgb);
-	opengl_mat.emission_tex_path = mat.emission_texture_url;
+	opengl_mat.emission_tex_path = mat.emission_texture_url.str();
 
 	/*
 	Luminance 
@@ -94,7 +94,7 @@ void ModelLoading::setGLMaterialFromWorldMaterialWithLocalPaths(const WorldMater
 
 	opengl_mat.roughness = mat.roughness.val;
 	opengl_mat.metallic_roughness_tex_path = mat.roughness.texture_url;
-	opengl_mat.normal_map_path = mat.normal_map_url;
+	opengl_mat.normal_map_path = mat.normal_map_url.str();
 	opengl_mat.transparent = (mat.opacity.val < 1.0f) || BitUtils::isBitSet(mat.flags, WorldMaterial::HOLOGRAM_FLAG); // Hologram is done with transparent material shader.
 
 	opengl_mat.hologram             = BitUtils::isBitSet(mat.flags, WorldMaterial::HOLOGRAM_FLAG);
@@ -137,7 +137,7 @@ void ModelLoading::setGLMaterialFromWorldMaterial(const WorldMaterial& mat, int
 		opengl_mat.tex_path.clear();
 
 	opengl_mat.emission_linear_rgb = sanitiseAndConvertToLinearEmissionColour(mat.emission_rgb);
-	opengl_mat.emission_tex_path = mat.emission_texture_url;
+	opengl_mat.emission_tex_path = mat.emission_texture_url.str();
 	opengl_mat.emission_scale = mat.emission_lum_flux_or_lum * (1.0e-9f / (683.002f * 106.856e-9f)); // See comments above
 
 
@@ -1588,11 +1588,23 @@ Reference<OpenGLMeshRenderData> ModelLoading::makeModelForVoxelGroup(const Voxel
 		UVUnwrapper::build(*indigo_mesh, ob_to_world, print_output, normed_margin); // Adds UV set to indigo_mesh.
 	}
 
-	// Convert Indigo mesh to opengl data
-	Reference<OpenGLMeshRenderData> mesh_data = buildVoxelOpenGLMeshData(*indigo_mesh, mem_allocator);
+	// Convert Indigo mesh to opengl data, and load into GPU mem if requested.
+	Reference<OpenGLMeshRenderData> mesh_data = makeModelForVoxelIndigoMesh(*indigo_mesh, vert_buf_allocator, do_opengl_stuff, mem_allocator);
 
 	physics_shape_out = PhysicsWorld::createJoltShapeForIndigoMesh(*indigo_mesh, build_dynamic_physics_ob, mem_allocator);
 
+	// conPrint("ModelLoading::makeModelForVoxelGroup for " + toString(voxel_group.voxels.size()) + " voxels took " + timer.elapsedString());
+	return mesh_data;
+}
+
+
+Reference<OpenGLMeshRenderData> ModelLoading::makeModelForVoxelIndigoMesh(const Indigo::Mesh& indigo_mesh, VertexBufferAllocator* vert_buf_allocator, bool do_opengl_stuff, 
+	glare::Allocator* mem_allocator)
+{
+	ZoneScoped; // Tracy profiler
+
+	Reference<OpenGLMeshRenderData> mesh_data = buildVoxelOpenGLMeshData(indigo_mesh, mem_allocator);
+
 	// Load rendering data into GPU mem if requested.
 	if(do_opengl_stuff)
 	{
@@ -1622,7 +1634,6 @@ Reference<OpenGLMeshRenderData> ModelLoading::makeModelForVoxelGroup(const Voxel
 		mesh_data->vert_index_buffer_uint8.clearAndFreeMem();
 	}
 
-	// conPrint("ModelLoading::makeModelForVoxelGroup for " + toString(voxel_group.voxels.size()) + " voxels took " + timer.elapsedString());
 	return mesh_data;
 }
 
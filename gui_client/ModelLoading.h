@@ -100,6 +100,11 @@ public:
 		glare::Allocator* mem_allocator,
 		PhysicsShape& physics_shape_out);
 
+	// Build OpenGLMeshRenderData from an already built voxel Indigo mesh, for example one built incrementally by IncrementalVoxelMesher.
+	// Doesn't build a physics shape.
+	static Reference<OpenGLMeshRenderData> makeModelForVoxelIndigoMesh(const Indigo::Mesh& indigo_mesh, VertexBufferAllocator* vert_buf_allocator, bool do_opengl_stuff, 
+		glare::Allocator* mem_allocator);
+
 	//static Reference<BatchedMesh> makeBatchedMeshForVoxelGroup(const VoxelGroup& voxel_group);
 	//static Reference<Indigo::Mesh> makeIndigoMeshForVoxelGroup(const VoxelGroup& voxel_group);
 
@@ -211,7 +211,7 @@ void ObjectEditor::setFromObject(const WorldObject& ob, int selected_mat_index_,
 	if(ob.object_type == WorldObject::ObjectType_Spotlight)
 		this->selected_mat_index = 0;
 
-	this->modelFileSelectWidget->setFilename(QtUtils::toQString(ob.model_url));
+	this->modelFileSelectWidget->setFilename(QtUtils::toQString(ob.model_url.str()));
 	{
 		SignalBlocker b(this->scriptTextEdit);
 		this->scriptTextEdit->setPlainText(QtUtils::toQString(ob.script));
@@ -251,11 +251,11 @@ void ObjectEditor::setFromObject(const WorldObject& ob, int selected_mat_index_,
 	SignalBlocker::setChecked(this->audioAutoplayCheckBox, BitUtils::isBitSet(ob.flags, WorldObject::AUDIO_AUTOPLAY));
 	SignalBlocker::setChecked(this->audioLoopCheckBox,     BitUtils::isBitSet(ob.flags, WorldObject::AUDIO_LOOP));
 
-	this->videoURLFileSelectWidget->setFilename(QtUtils::toQString((!ob.materials.empty()) ? ob.materials[0]->emission_texture_url : ""));
+	this->videoURLFileSelectWidget->setFilename(QtUtils::toQString((!ob.materials.empty()) ? ob.materials[0]->emission_texture_url.str() : URLString()));
 
 	SignalBlocker::setValue(videoVolumeDoubleSpinBox, ob.audio_volume);
 	
-	lightmapURLLabel->setText(QtUtils::toQString(ob.lightmap_url));
+	lightmapURLLabel->setText(QtUtils::toQString(ob.lightmap_url.str()));
 
 	WorldMaterialRef selected_mat;
 	if(selected_mat_index >= 0 && selected_mat_index < (int)ob.materials.size())
@@ -379,7 +379,7 @@ void ObjectEditor::setFromObject(const WorldObject& ob, int selected_mat_index_,
 		lightmapBakeStatusLabel->setText("");
 	}
 
-	this->audioFileWidget->setFilename(QtUtils::toQString(ob.audio_source_url));
+	this->audioFileWidget->setFilename(QtUtils::toQString(ob.audio_source_url.str()));
 	SignalBlocker::setValue(volumeDoubleSpinBox, ob.audio_volume);
 }
 
@@ -423,6 +423,12 @@ static void checkStringSize(URLString& s, size_t max_size)
 	if(s.size() > max_size)
 		s = s.substr(0, max_size);
 }
+static void checkStringSize(URLAtom& s, size_t max_size)
+{
+	// TODO: throw exception instead?
+	if(s.size() > max_size)
+		s = std::string_view(s).substr(0, max_size);
+}
 
 void ObjectEditor::toObject(WorldObject& ob_out)
 {
@@ -570,7 +576,7 @@ void ObjectEditor::writeTransformMembersToObject(WorldObject& ob_out)
 
 void ObjectEditor::objectModelURLUpdated(const WorldObject& ob)
 {
-	this->modelFileSelectWidget->setFilename(QtUtils::toQString(ob.model_url));
+	this->modelFileSelectWidget->setFilename(QtUtils::toQString(ob.model_url.str()));
 
 	updateInfoLabel(ob); // Update info label, which includes last-modified time.
 }
@@ -578,7 +584,7 @@ void ObjectEditor::objectModelURLUpdated(const WorldObject& ob)
 
 void ObjectEditor::objectLightmapURLUpdated(const WorldObject& ob)
 {
-	lightmapURLLabel->setText(QtUtils::toQString(ob.lightmap_url));
+	lightmapURLLabel->setText(QtUtils::toQString(ob.lightmap_url.str()));
 
 	if(ob.lightmap_baking)
 	{
@@ -55,6 +55,7 @@ Copyright Glare Technologies Limited 2022 -
 #include <Jolt/Physics/Collision/RayCast.h>
 #include <Jolt/Physics/Collision/CastResult.h>
 #include <Jolt/Physics/Collision/Shape/OffsetCenterOfMassShape.h>
+#include <Jolt/Physics/Collision/Shape/StaticCompoundShape.h>
 #endif
 #include <HashSet.h>
 #include <fstream>
@@ -1141,6 +1142,27 @@ PhysicsShape PhysicsWorld::createCOMOffsetShapeForShape(const PhysicsShape& orig
 }
 
 
+PhysicsShape PhysicsWorld::createStaticCompoundShape(const std::vector<PhysicsShape>& sub_shapes)
+{
+	JPH::StaticCompoundShapeSettings compound_settings;
+	size_t size_B = 0;
+	for(size_t i=0; i<sub_shapes.size(); ++i)
+	{
+		compound_settings.AddShape(JPH::Vec3::sZero(), JPH::Quat::sIdentity(), sub_shapes[i].jolt_shape.GetPtr());
+		size_B += sub_shapes[i].size_B;
+	}
+
+	JPH::Result<JPH::Ref<JPH::Shape>> result = compound_settings.Create();
+	if(result.HasError())
+		throw glare::Exception(std::string("Error building Jolt shape: ") + result.GetError().c_str());
+
+	PhysicsShape compound_shape;
+	compound_shape.jolt_shape = result.Get();
+	compound_shape.size_B = size_B;
+	return compound_shape;
+}
+
+
 PhysicsShape PhysicsWorld::createScaledAndTranslatedShapeForShape(const PhysicsShape& original_shape, const Vec3f& translation, const Vec3f& scale)
 {
 	JPH::Ref<JPH::Shape> scaled_jolt_shape = new JPH::ScaledShape(original_shape.jolt_shape.GetPtr(), JPH::Vec3(scale.x, scale.y, scale.z));
@@ -1577,15 +1599,24 @@ const Vec4f PhysicsWorld::getPosInJolt(const Reference<PhysicsObject>& object)
 }
 
 
-// Return the inner MeshShape if shape is a decorated MeshShape, otherwise return NULL.
-static const JPH::MeshShape* getInnerMeshShape(const JPH::Shape* shape)
+// Return the inner MeshShape if shape is a (possibly decorated or compound) MeshShape, otherwise return NULL.
+// sub_shape_id is the sub-shape ID relative to shape, sub_shape_id_out is set to the sub-shape ID relative to the returned MeshShape.
+static const JPH::MeshShape* getInnerMeshShape(const JPH::Shape* shape, const JPH::SubShapeID& sub_shape_id, JPH::SubShapeID& sub_shape_id_out)
 {
 	if(shape->GetType() == JPH::EShapeType::Decorated)
 	{
-		return getInnerMeshShape(static_cast<const JPH::DecoratedShape*>(shape)->GetInnerShape());
+		return getInnerMeshShape(static_cast<const JPH::DecoratedShape*>(shape)->GetInnerShape(), sub_shape_id, sub_shape_id_out);
+	}
+	else if(shape->GetType() == JPH::EShapeType::Compound)
+	{
+		const JPH::CompoundShape* compound_shape = static_cast<const JPH::CompoundShape*>(shape);
+		JPH::SubShapeID remainder;
+		const JPH::uint32 index = compound_shape->GetSubShapeIndexFromID(sub_shape_id, remainder);
+		return getInnerMeshShape(compound_shape->GetSubShape(index).mShape, remainder, sub_shape_id_out);
 	}
 	else if(shape->GetType() == JPH::EShapeType::Mesh)
 	{
+		sub_shape_id_out = sub_shape_id;
 		return static_cast<const JPH::MeshShape*>(shape);
 	}
 	else
@@ -1619,9 +1650,10 @@ void PhysicsWorld::traceRay(const Vec4f& origin, const Vec4f& dir, float max_t,
 			results_out.hit_normal_ws = toVec4fVec(body->GetWorldSpaceSurfaceNormal(hit_result.mSubShapeID2, ray.GetPointOnRay(hit_result.mFraction)));
 
 			results_out.hit_mat_index = 0;
-			if(const JPH::MeshShape* mesh_shape = getInnerMeshShape(body->GetShape()))
+			JPH::SubShapeID mesh_sub_shape_id;
+			if(const JPH::MeshShape* mesh_shape = getInnerMeshShape(body->GetShape(), hit_result.mSubShapeID2, mesh_sub_shape_id))
 			{
-				results_out.hit_mat_index = mesh_shape->GetTriangleUserData(hit_result.mSubShapeID2);
+				results_out.hit_mat_index = mesh_shape->GetTriangleUserData(mesh_sub_shape_id);
 			}
 
 			// conPrint("Hit object, hitdist_ws: " + toString(results_out.hitdist_ws) + ", hit_tri_index: " + toString(results_out.hit_tri_index));
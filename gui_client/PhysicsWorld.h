@@ -18,6 +18,7 @@ Copyright Glare Technologies Limited 2022 -
 #include <utils/HashSet.h>
 #include <utils/Array2D.h>
 #include <set>
+#include <vector>
 
 #if USE_JOLT
 #include <Jolt/Jolt.h>
@@ -133,6 +134,10 @@ public:
 
 	static PhysicsShape createScaledAndTranslatedShapeForShape(const PhysicsShape& shape, const Vec3f& translation, const Vec3f& scale);
 
+	// Creates a static compound shape containing the given (non-null) sub-shapes, untransformed.  The sub-shapes are referenced, not copied, 
+	// so rebuilding a compound after changing some of the sub-shapes is cheap.
+	static PhysicsShape createStaticCompoundShape(const std::vector<PhysicsShape>& sub_shapes);
+
 	void think(double dt);
 
 #if USE_JOLT
@@ -8,11 +8,15 @@ Copyright Glare Technologies Limited 2023 -
 
 #include "ModelLoading.h"
 #include "PhysicsWorld.h"
+#include "IncrementalVoxelMesher.h"
 #include "TerrainTests.h"
 #include "URLParser.h"
 #include "CameraController.h"
 #include "../shared/VoxelMeshBuilding.h"
+#include "../shared/VoxelBricks.h"
+#include "../shared/VoxelCodec.h"
 #include "../shared/LODGeneration.h"
+#include "../shared/TextureDownsampling.h"
 #include "../shared/ImageDecoding.h"
 #include "../physics/TreeTest.h"
 #include "../opengl/TextureLoading.h"
@@ -148,6 +152,7 @@ void TestSuite::test()
 	runTest([&]() { glare::AtomicInt::test(); });
 	runTest([&]() { TextureProcessingTests::test(); });
 	runTest([&]() { ImageMapTests::test(); });
+	runTest([&]() { TextureDownsampling::test(); });
 	runTest([&]() { web::Escaping::test(); });
 	runTest([&]() { URL::test(); });
 	runTest([&]() { glare::testLinearIterSet(); });
@@ -160,7 +165,10 @@ void TestSuite::test()
 	runTest([&]() { testSRGBUtils(); });
 	runTest([&]() { TopologicalSort::test(); });
 	runTest([&]() { CheckedMaths::test(); });
+	runTest([&]() { VoxelBricks::test(); });
+	runTest([&]() { VoxelCodec::test(); });
 	runTest([&]() { VoxelMeshBuilding::test(); });
+	runTest([&]() { IncrementalVoxelMesher::test(); });
 	runTest([&]() { ModelLoading::test(); });
 	runTest([&]() { glare::AudioFileReader::test(); });
 	runTest([&]() { URLParser::test(); });
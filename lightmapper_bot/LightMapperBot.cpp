@@ -549,7 +549,7 @@ public:
 			conPrint("\n\n\n");
 			conPrint("=================== Building lightmap for object ====================");
 			conPrint("UID: " + ob_to_lightmap->uid.toString());
-			conPrint("model_url: " + ob_to_lightmap->model_url);
+			conPrint("model_url: " + toStdString(ob_to_lightmap->model_url));
 			conPrint("pos: " + ob_to_lightmap->pos.toString());
 			conPrint("dimensions: " + (ob_to_lightmap->aabb_ws.max_ - ob_to_lightmap->aabb_ws.min_).toString());
 			conPrint("creator_name: " + ob_to_lightmap->creator_name);
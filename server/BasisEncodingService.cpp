@@ -0,0 +1,450 @@
+/*=====================================================================
+BasisEncodingService.cpp
+------------------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#include "BasisEncodingService.h"
+
+
+#include "../shared/LODGeneration.h"
+#include <graphics/ImageMap.h>
+#include <graphics/ImageMapSequence.h>
+#include <maths/mathstypes.h>
+#include <utils/Lock.h>
+#include <utils/Task.h>
+#include <utils/TaskManager.h>
+#include <utils/ConPrint.h>
+#include <utils/Exception.h>
+#include <utils/PlatformUtils.h>
+
+
+// Encodes a single job on a task manager thread, plus any extra threads the job was given.
+class BasisEncodeTask : public glare::Task
+{
+public:
+	BasisEncodeTask(BasisEncodingService* service_, const BasisEncodingService::QueuedJob& queued_job_) : service(service_), queued_job(queued_job_) {}
+
+	virtual void run(size_t thread_index)
+	{
+		BasisEncodingService::EncodeJob& job = *queued_job.job;
+
+		Timer timer;
+		try
+		{
+			if(job.image.isNull())
+				throw glare::Exception("No image to encode");
+
+			LODGeneration::writeBasisUniversalFileForMap(*job.image, job.output_path, job.quality_level, queued_job.num_threads);
+			job.succeeded = true;
+		}
+		catch(glare::Exception& e)
+		{
+			job.error_msg = e.what();
+		}
+		catch(std::exception& e) // catch std::bad_alloc etc..
+		{
+			job.error_msg = std::string("std::exception: ") + e.what();
+		}
+		job.num_threads = queued_job.num_threads;
+		job.encode_time_s = timer.elapsed();
+
+		service->jobFinished(queued_job);
+	}
+
+	BasisEncodingService* service;
+	BasisEncodingService::QueuedJob queued_job;
+};
+
+
+BasisEncodingService::BasisEncodingService(int max_total_threads_)
+:	next_sequence_num(0),
+	num_threads_in_use(0),
+	max_total_threads((max_total_threads_ > 0) ? max_total_threads_ : myMax(1, (int)PlatformUtils::getNumLogicalProcessors() / 2)),
+	task_manager(NULL),
+	max_queue_depth(0),
+	num_running_jobs(0),
+	num_jobs_done(0),
+	num_jobs_failed(0),
+	total_encode_time_s(0),
+	total_queue_wait_time_s(0)
+{}
+
+
+BasisEncodingService::~BasisEncodingService()
+{
+	// encodeJobs() doesn't return until its jobs are done, so there are no tasks left to run here.
+	delete task_manager;
+}
+
+
+static size_t numPixelsToEncode(const Map2D& image)
+{
+	const size_t num_frames = dynamic_cast<const ImageMapSequenceUInt8*>(&image) ? dynamic_cast<const ImageMapSequenceUInt8*>(&image)->images.size() : 1;
+	return image.getMapWidth() * image.getMapHeight() * num_frames;
+}
+
+
+int BasisEncodingService::numThreadsForImage(size_t num_pixels, int max_total_threads)
+{
+	// Basis splits the work for an image into fixed-size blocks of pixels, so small images don't have enough work to keep more than a thread or two busy.
+	int num_threads;
+	if(num_pixels <= 256 * 256)
+		num_threads = 1;
+	else if(num_pixels <= 1024 * 1024)
+		num_threads = 2;
+	else if(num_pixels <= 2048 * 2048)
+		num_threads = 4;
+	else
+		num_threads = 8;
+
+	return myClamp(num_threads, 1, myMax(1, max_total_threads));
+}
+
+
+void BasisEncodingService::queueJob(const QueuedJob& queued_job, Priority priority)
+{
+	queued_jobs[std::make_pair((int)priority, next_sequence_num++)] = queued_job;
+	max_queue_depth = myMax(max_queue_depth, queued_jobs.size());
+}
+
+
+void BasisEncodingService::startQueuedJobs()
+{
+	while(!queued_jobs.empty())
+	{
+		auto it = queued_jobs.begin();
+		QueuedJob& queued_job = it->second;
+
+		// Wait for running jobs to free up enough threads for the first job.  Don't start later jobs before it, so it isn't starved.
+		if(num_threads_in_use + queued_job.num_threads > max_total_threads)
+			break;
+
+		num_threads_in_use += queued_job.num_threads;
+		total_queue_wait_time_s += queued_job.queue_timer.elapsed();
+
+		if(queued_job.job)
+		{
+			num_running_jobs++;
+			task_manager->addTask(new BasisEncodeTask(this, queued_job));
+		}
+		else // Else this is a thread reservation, so the waiting thread can start its encode now:
+		{
+			queued_job.waiter->num_unfinished--;
+			queued_job.waiter->condition.notify();
+		}
+
+		queued_jobs.erase(it);
+	}
+}
+
+
+void BasisEncodingService::jobFinished(const QueuedJob& queued_job)
+{
+	Lock lock(mutex);
+
+	num_threads_in_use -= queued_job.num_threads;
+	num_running_jobs--;
+	num_jobs_done++;
+	if(!queued_job.job->succeeded)
+		num_jobs_failed++;
+	total_encode_time_s += queued_job.job->encode_time_s;
+
+	queued_job.waiter->num_unfinished--;
+	queued_job.waiter->condition.notify();
+
+	startQueuedJobs();
+}
+
+
+void BasisEncodingService::releaseThreads(int num_threads)
+{
+	Lock lock(mutex);
+
+	num_threads_in_use -= num_threads;
+
+	startQueuedJobs();
+}
+
+
+void BasisEncodingService::encodeJobs(std::vector<EncodeJob>& jobs)
+{
+	if(jobs.empty())
+		return;
+
+	Lock lock(mutex);
+
+	if(!task_manager)
+		task_manager = new glare::TaskManager("BasisEncodingService task manager", max_total_threads); // Each running job uses at least one thread from the budget, so we never need more task threads than this.
+
+	Waiter waiter(/*num_unfinished=*/jobs.size());
+	for(size_t i=0; i<jobs.size(); ++i)
+	{
+		EncodeJob& job = jobs[i];
+		job.succeeded = false;
+		job.error_msg.clear();
+
+		QueuedJob queued_job;
+		queued_job.job = &job;
+		queued_job.waiter = &waiter;
+		queued_job.num_threads = numThreadsForImage(job.image.nonNull() ? numPixelsToEncode(*job.image) : 0, max_total_threads);
+		queueJob(queued_job, job.priority);
+	}
+
+	startQueuedJobs();
+
+	while(waiter.num_unfinished > 0)
+		waiter.condition.wait(mutex); // Suspend until one of our jobs finishes, or we get a spurious wake up.
+}
+
+
+BasisEncodingService::ThreadReservation::ThreadReservation(BasisEncodingService& service_, int num_threads_, Priority priority)
+:	service(service_)
+{
+	Lock lock(service.mutex);
+
+	num_threads = myClamp(num_threads_, 1, service.max_total_threads);
+
+	Waiter waiter(/*num_unfinished=*/1);
+
+	QueuedJob queued_job;
+	queued_job.job = NULL;
+	queued_job.waiter = &waiter;
+	queued_job.num_threads = num_threads;
+	service.queueJob(queued_job, priority);
+
+	service.startQueuedJobs();
+
+	while(waiter.num_unfinished > 0)
+		waiter.condition.wait(service.mutex);
+}
+
+
+BasisEncodingService::ThreadReservation::~ThreadReservation()
+{
+	service.releaseThreads(num_threads);
+}
+
+
+BasisEncodingService::Stats BasisEncodingService::getStats()
+{
+	Lock lock(mutex);
+
+	Stats stats;
+	stats.queue_depth = queued_jobs.size();
+	stats.max_queue_depth = max_queue_depth;
+	stats.num_running_jobs = num_running_jobs;
+	stats.num_threads_in_use = num_threads_in_use;
+	stats.max_total_threads = max_total_threads;
+	stats.num_jobs_done = num_jobs_done;
+	stats.num_jobs_failed = num_jobs_failed;
+	stats.total_encode_time_s = total_encode_time_s;
+	stats.total_queue_wait_time_s = total_queue_wait_time_s;
+	return stats;
+}
+
+
+#if BUILD_TESTS
+
+
+#include <utils/TestUtils.h>
+#include <utils/FileUtils.h>
+#include <utils/StringUtils.h>
+#include <utils/Timer.h>
+#include <maths/PCG32.h>
+#include <thread>
+
+
+static ImageMapUInt8Ref makeTestImage(int W, int H, uint64 seed)
+{
+	ImageMapUInt8Ref map = new ImageMapUInt8(W, H, 3);
+	PCG32 rng(seed);
+	for(int y=0; y<H; ++y)
+	for(int x=0; x<W; ++x)
+	{
+		// Smooth gradients with some noise, so the encoder has some work to do.
+		map->getPixel(x, y)[0] = (uint8)((x * 255) / W);
+		map->getPixel(x, y)[1] = (uint8)((y * 255) / H);
+		map->getPixel(x, y)[2] = (uint8)(rng.unitRandom() * 64.f);
+	}
+	return map;
+}
+
+
+void BasisEncodingService::test()
+{
+	conPrint("BasisEncodingService::test()");
+
+	try
+	{
+		//-------------------------------------- Test numThreadsForImage --------------------------------------
+		testAssert(numThreadsForImage(0, 8) == 1);
+		testAssert(numThreadsForImage(64 * 64, 8) == 1);
+		testAssert(numThreadsForImage(1024 * 1024, 8) == 2);
+		testAssert(numThreadsForImage(4096 * 4096, 8) == 8);
+		testAssert(numThreadsForImage(4096 * 4096, 3) == 3); // Should be clamped to the budget
+		testAssert(numThreadsForImage(4096 * 4096, 0) == 1);
+		for(size_t n=1; n<8192 * 8192; n *= 2)
+			testAssert(numThreadsForImage(n, 16) <= numThreadsForImage(n * 2, 16));
+
+#if !GUI_CLIENT
+		const std::string dir = PlatformUtils::getTempDirPath() + "/basis_encoding_service_test";
+		FileUtils::createDirIfDoesNotExist(dir);
+
+		//-------------------------------------- Test encoding a batch of jobs with mixed sizes and priorities --------------------------------------
+		{
+			BasisEncodingService service(/*max_total_threads=*/4);
+
+			std::vector<EncodeJob> jobs(8);
+			for(size_t i=0; i<jobs.size(); ++i)
+			{
+				const int W = (i == 0) ? 1024 : 64;
+				jobs[i].image = makeTestImage(W, W, /*seed=*/i);
+				jobs[i].output_path = dir + "/job_" + toString(i) + ".basis";
+				jobs[i].quality_level = 128;
+				jobs[i].priority = (Priority)(i % 3);
+			}
+
+			// Add a job with an image sequence
+			{
+				Reference<ImageMapSequenceUInt8> seq = new ImageMapSequenceUInt8();
+				for(int f=0; f<3; ++f)
+				{
+					seq->images.push_back(makeTestImage(64, 64, /*seed=*/100 + f));
+					seq->frame_durations.push_back(0.1);
+				}
+				EncodeJob job;
+				job.image = seq;
+				job.output_path = dir + "/seq.basis";
+				jobs.push_back(job);
+			}
+
+			// Add a job with no image, which should fail.
+			{
+				EncodeJob job;
+				job.output_path = dir + "/invalid.basis";
+				jobs.push_back(job);
+			}
+
+			service.encodeJobs(jobs);
+
+			for(size_t i=0; i+1<jobs.size(); ++i)
+			{
+				testAssert(jobs[i].succeeded);
+				testAssert(FileUtils::fileExists(jobs[i].output_path) && FileUtils::getFileSize(jobs[i].output_path) > 0);
+				testAssert(jobs[i].num_threads >= 1 && jobs[i].num_threads <= 4);
+			}
+			testAssert(jobs[0].num_threads == 2);
+
+			testAssert(!jobs.back().succeeded);
+			testAssert(!jobs.back().error_msg.empty());
+
+			const Stats stats = service.getStats();
+			testAssert(stats.queue_depth == 0);
+			testAssert(stats.max_queue_depth > 0 && stats.max_queue_depth <= jobs.size());
+			testAssert(stats.num_running_jobs == 0);
+			testAssert(stats.num_threads_in_use == 0);
+			testAssert(stats.num_jobs_done == jobs.size());
+			testAssert(stats.num_jobs_failed == 1);
+		}
+
+		//-------------------------------------- Test thread reservations --------------------------------------
+		{
+			BasisEncodingService service(/*max_total_threads=*/4);
+			{
+				ThreadReservation reservation(service, /*num_threads=*/3, Priority_Low);
+				testAssert(reservation.numThreads() == 3);
+				testAssert(service.getStats().num_threads_in_use == 3);
+
+				// A job should still be able to run in the remaining thread.
+				std::vector<EncodeJob> jobs(1);
+				jobs[0].image = makeTestImage(64, 64, /*seed=*/1);
+				jobs[0].output_path = dir + "/reservation_job.basis";
+				service.encodeJobs(jobs);
+				testAssert(jobs[0].succeeded);
+			}
+			testAssert(service.getStats().num_threads_in_use == 0);
+
+			{
+				ThreadReservation reservation(service, /*num_threads=*/100, Priority_High);
+				testAssert(reservation.numThreads() == 4); // Should be clamped to the budget
+			}
+			testAssert(service.getStats().num_threads_in_use == 0);
+		}
+
+		//-------------------------------------- Test a batch and a reservation waiting at the same time --------------------------------------
+		// When a job in the batch finishes, the batch caller must be woken, even though the reservation is waiting as well and can't start yet.
+		for(int iter=0; iter<10; ++iter)
+		{
+			BasisEncodingService service(/*max_total_threads=*/2);
+
+			std::vector<EncodeJob> jobs(4);
+			for(size_t i=0; i<jobs.size(); ++i)
+			{
+				jobs[i].image = makeTestImage(64, 64, /*seed=*/i);
+				jobs[i].output_path = dir + "/concurrent_" + toString(i) + ".basis";
+			}
+
+			std::thread batch_thread;
+			std::thread reservation_thread;
+			{
+				// Hold all the threads, so the batch and the reservation both have to wait.
+				ThreadReservation blocking_reservation(service, /*num_threads=*/2, Priority_High);
+
+				batch_thread = std::thread([&service, &jobs]() { service.encodeJobs(jobs); });
+				reservation_thread = std::thread([&service]() {
+					ThreadReservation reservation(service, /*num_threads=*/2, Priority_Low); // Can only start once all the batch jobs are done.
+					testAssert(reservation.numThreads() == 2);
+				});
+
+				while(service.getStats().queue_depth < jobs.size() + 1)
+					PlatformUtils::Sleep(1);
+			}
+
+			batch_thread.join();
+			reservation_thread.join();
+
+			for(size_t i=0; i<jobs.size(); ++i)
+				testAssert(jobs[i].succeeded);
+			testAssert(service.getStats().num_threads_in_use == 0);
+		}
+
+		//-------------------------------------- Benchmark: many small textures, encoded one at a time vs. by the service --------------------------------------
+		{
+			const int num_threads = myMax(1, (int)PlatformUtils::getNumLogicalProcessors() / 2);
+
+			std::vector<EncodeJob> jobs(32);
+			for(size_t i=0; i<jobs.size(); ++i)
+			{
+				jobs[i].image = makeTestImage(256, 256, /*seed=*/i);
+				jobs[i].output_path = dir + "/bench_" + toString(i) + ".basis";
+				jobs[i].quality_level = 128;
+			}
+
+			Timer timer;
+			for(size_t i=0; i<jobs.size(); ++i)
+				LODGeneration::writeBasisUniversalFileForMap(*jobs[i].image, jobs[i].output_path, jobs[i].quality_level, num_threads);
+			const double serial_time = timer.elapsed();
+
+			BasisEncodingService service(num_threads);
+			timer.reset();
+			service.encodeJobs(jobs);
+			const double service_time = timer.elapsed();
+
+			for(size_t i=0; i<jobs.size(); ++i)
+				testAssert(jobs[i].succeeded);
+
+			conPrint("Encoding " + toString(jobs.size()) + " 256x256 textures with " + toString(num_threads) + " threads: one at a time: " + doubleToStringNSigFigs(serial_time, 3) + " s, BasisEncodingService: " +
+				doubleToStringNSigFigs(service_time, 3) + " s (" + doubleToStringNSigFigs(serial_time / service_time, 3) + "x speedup)");
+		}
+#endif // !GUI_CLIENT
+	}
+	catch(glare::Exception& e)
+	{
+		failTest(e.what());
+	}
+
+	conPrint("BasisEncodingService::test() done.");
+}
+
+
+#endif // BUILD_TESTS
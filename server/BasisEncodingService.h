@@ -0,0 +1,149 @@
+/*=====================================================================
+BasisEncodingService.h
+----------------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#pragma once
+
+
+#include <graphics/Map2D.h>
+#include <utils/Reference.h>
+#include <utils/Condition.h>
+#include <utils/Timer.h>
+#include <Mutex.h>
+#include <Platform.h>
+#include <string>
+#include <vector>
+#include <map>
+namespace glare { class TaskManager; }
+
+
+/*=====================================================================
+BasisEncodingService
+--------------------
+Encodes Basis Universal texture files, with a global budget on the number
+of encoder threads, shared by MeshLODGenThread and ChunkGenThread.
+
+Each job is given a number of encoder threads based on its size.  Small
+textures don't encode much faster with more threads, so several of them
+are encoded in parallel with a thread each, while large textures get more
+threads.
+
+Jobs wait in a queue ordered by priority, then by submission order.  The
+job at the front of the queue starts once there are enough free threads in
+the budget for it.  Later jobs don't skip ahead of it, so that large jobs
+aren't starved by a stream of small ones.
+
+Thread-safe.
+=====================================================================*/
+class BasisEncodingService
+{
+public:
+	// max_total_threads is the maximum number of encoder threads running at once, over all jobs.  If <= 0, uses half the logical processors.
+	BasisEncodingService(int max_total_threads = 0);
+	~BasisEncodingService();
+
+	enum Priority
+	{
+		Priority_High	= 0, // Textures a user is likely waiting on, such as avatar textures.
+		Priority_Normal	= 1, // Object textures.
+		Priority_Low	= 2  // Background work, such as LOD chunk array textures.
+	};
+
+	struct EncodeJob
+	{
+		EncodeJob() : quality_level(255), priority(Priority_Normal), succeeded(false), num_threads(0), encode_time_s(0) {}
+
+		Reference<Map2D> image; // An ImageMapUInt8, or an ImageMapSequenceUInt8 for animated textures.  Must not be modified until the job is done.
+		std::string output_path;
+		int quality_level; // ETC1S quality level, 1 - 255.
+		Priority priority;
+
+		// Set by encodeJobs():
+		bool succeeded;
+		std::string error_msg; // Set if succeeded is false.
+		int num_threads; // Number of encoder threads the job was given.
+		double encode_time_s;
+	};
+
+	// Queues the jobs, then blocks until they have all been encoded.  Jobs are encoded in parallel as the thread budget allows.
+	// Doesn't throw on encoding errors, sets succeeded and error_msg for each job instead.
+	void encodeJobs(std::vector<EncodeJob>& jobs);
+
+
+	// Reserves threads from the budget, for an encode with custom parameters done on the calling thread, such as a LOD chunk array texture.
+	// Blocks until the reservation gets to the front of the queue and enough threads are free.  The threads are released on destruction.
+	class ThreadReservation
+	{
+	public:
+		ThreadReservation(BasisEncodingService& service, int num_threads, Priority priority);
+		~ThreadReservation();
+
+		int numThreads() const { return num_threads; } // Number of threads reserved.  May be less than requested, if more than max_total_threads was requested.
+
+	private:
+		GLARE_DISABLE_COPY(ThreadReservation);
+		BasisEncodingService& service;
+		int num_threads;
+	};
+
+
+	// Number of encoder threads to give an encode of an image with the given number of pixels (summed over all frames).  Returns a value in [1, max(1, max_total_threads)].
+	static int numThreadsForImage(size_t num_pixels, int max_total_threads);
+
+	struct Stats
+	{
+		size_t queue_depth; // Number of jobs and reservations waiting for threads.
+		size_t max_queue_depth;
+		size_t num_running_jobs;
+		int num_threads_in_use;
+		int max_total_threads;
+		uint64 num_jobs_done;
+		uint64 num_jobs_failed;
+		double total_encode_time_s;
+		double total_queue_wait_time_s;
+	};
+	Stats getStats();
+
+	static void test();
+
+private:
+	GLARE_DISABLE_COPY(BasisEncodingService);
+	friend class BasisEncodeTask;
+
+	// A thread blocked in encodeJobs() or a ThreadReservation constructor.
+	// Each waiter has its own condition, so a wake-up can't go to a waiter other than the one whose job finished.
+	struct Waiter
+	{
+		Waiter(size_t num_unfinished_) : num_unfinished(num_unfinished_) {}
+		size_t num_unfinished; // Number of unstarted or running jobs in the encodeJobs() call, or unstarted reservations.  Decremented when the job finishes, or the reservation is granted.
+		Condition condition; // Notified when num_unfinished is decremented.
+	};
+
+	struct QueuedJob
+	{
+		EncodeJob* job; // NULL for thread reservations.
+		Waiter* waiter;
+		int num_threads;
+		Timer queue_timer;
+	};
+
+	void queueJob(const QueuedJob& queued_job, Priority priority) REQUIRES(mutex);
+	void startQueuedJobs() REQUIRES(mutex);
+	void jobFinished(const QueuedJob& queued_job);
+	void releaseThreads(int num_threads);
+
+	Mutex mutex;
+	std::map<std::pair<int, uint64>, QueuedJob> queued_jobs	GUARDED_BY(mutex); // Keyed by (priority, sequence number), so the first job is the next to start.
+	uint64 next_sequence_num									GUARDED_BY(mutex);
+	int num_threads_in_use										GUARDED_BY(mutex);
+	int max_total_threads;
+	glare::TaskManager* task_manager							GUARDED_BY(mutex); // Runs the encode jobs.  Created on first use.
+
+	size_t max_queue_depth										GUARDED_BY(mutex);
+	size_t num_running_jobs										GUARDED_BY(mutex);
+	uint64 num_jobs_done										GUARDED_BY(mutex);
+	uint64 num_jobs_failed										GUARDED_BY(mutex);
+	double total_encode_time_s									GUARDED_BY(mutex);
+	double total_queue_wait_time_s								GUARDED_BY(mutex);
+};
@@ -10,6 +10,7 @@ Copyright Glare Technologies Limited 2024 -
 #include "../shared/LODGeneration.h"
 #include "../shared/VoxelMeshBuilding.h"
 #include "../shared/ImageDecoding.h"
+#include "../shared/TextureDownsampling.h"
 #include "../shared/Protocol.h"
 #include <graphics/MeshSimplification.h>
 #include <graphics/GifDecoder.h>
@@ -39,6 +40,7 @@ Copyright Glare Technologies Limited 2024 -
 #endif
 #include <zstd.h>
 #include <FileChecksum.h>
+#include <algorithm>
 
 
 static const float chunk_w = 128;
@@ -194,7 +196,7 @@ inline static Vec4f transformSkinnedVertex(const Vec4f vert_pos, size_t joint_of
 
 // May return null mesh if there were no voxels or mesh was simplified away.
 // May also return mesh with zero indices.
-BatchedMeshRef loadAndSimplifyGeometry(const ObInfo& ob_info, LRUCache<std::string, BatchedMeshRef>& mesh_cache, Matrix4f& voxel_scale_matrix_out)
+BatchedMeshRef loadAndSimplifyGeometry(const ObInfo& ob_info, LRUCache<std::string, BatchedMeshRef>& mesh_cache, glare::TaskManager& task_manager, Matrix4f& voxel_scale_matrix_out)
 {
 	float voxel_scale = 1.f;
 	voxel_scale_matrix_out = Matrix4f::identity();
@@ -244,7 +246,7 @@ BatchedMeshRef loadAndSimplifyGeometry(const ObInfo& ob_info, LRUCache<std::stri
 			if(voxel_group.voxels.size() > 64)
 				subsample_factor = 2;
 			Indigo::MeshRef indigo_mesh = VoxelMeshBuilding::makeIndigoMeshWithShadingNormalsForVoxelGroup(voxel_group, 
-				subsample_factor, mat_transparent, /*mem_allocator=*/NULL);
+				subsample_factor, mat_transparent, &task_manager, /*mem_allocator=*/NULL);
 
 			mesh = BatchedMesh::buildFromIndigoMesh(*indigo_mesh);
 
@@ -286,8 +288,24 @@ BatchedMeshRef loadAndSimplifyGeometry(const ObInfo& ob_info, LRUCache<std::stri
 }
 
 
-static void buildAndSaveArrayTexture(const std::vector<std::string>& used_tex_paths, glare::TaskManager& task_manager, int chunk_x, int chunk_y, std::map<std::string, int>& array_image_indices_out,
-	std::string& combined_texture_path_out, uint64& combined_texture_hash_out)
+// Returns the content hash of the file at abs_path, computing it only if it is not already in tex_content_hashes.
+static uint64 getTexContentHash(const std::string& abs_path, std::map<std::string, uint64>& tex_content_hashes)
+{
+	auto res = tex_content_hashes.find(abs_path);
+	if(res != tex_content_hashes.end())
+		return res->second;
+
+	const uint64 hash = FileChecksum::fileChecksum(abs_path);
+	tex_content_hashes[abs_path] = hash;
+	return hash;
+}
+
+
+// Textures are decoded through image_cache if it is non-NULL.  The array texture is encoded with threads reserved from basis_encoding_service.
+// tex_content_hashes caches the content hashes used as image_cache keys, so a texture file is only read for hashing once per chunk-building pass.
+static void buildAndSaveArrayTexture(const std::vector<std::string>& used_tex_paths, glare::TaskManager& task_manager, DecodedImageCache* image_cache, std::map<std::string, uint64>& tex_content_hashes, 
+	BasisEncodingService& basis_encoding_service, int chunk_x, int chunk_y, 
+	std::map<std::string, int>& array_image_indices_out, std::string& combined_texture_path_out, uint64& combined_texture_hash_out)
 {
 	if(!used_tex_paths.empty())
 	{
@@ -304,6 +322,8 @@ static void buildAndSaveArrayTexture(const std::vector<std::string>& used_tex_pa
 				Reference<Map2D> map;
 				if(hasExtension(tex_path, "gif"))
 					map = GIFDecoder::decodeImageSequence(tex_path);
+				else if(image_cache)
+					map = image_cache->getOrDecodeImage(tex_path, getTexContentHash(tex_path, tex_content_hashes)); // Load texture from disk and decode it, or reuse the decoded texture if MeshLODGenThread or another chunk has decoded it.
 				else
 					map = ImageDecoding::decodeImage(".", tex_path); // Load texture from disk and decode it.
 
@@ -326,11 +346,21 @@ static void buildAndSaveArrayTexture(const std::vector<std::string>& used_tex_pa
 
 				const int new_W = 64;
 
-				// Resize image down
-				Reference<Map2D> resized_map = imagemap->resizeMidQuality(new_W, new_W, &task_manager);
+				// Resize image down.  Textures here are colour textures, so filter in linear space.
+				ImageMapUInt8Ref resized_map_uint8;
+				if(((int)imagemap->getWidth() >= new_W) && ((int)imagemap->getHeight() >= new_W) && (imagemap->getN() <= 4))
+				{
+					std::vector<TextureDownsampling::DownsampleOutput> outputs(1, TextureDownsampling::DownsampleOutput(new_W, new_W));
+					TextureDownsampling::downsample(*imagemap, outputs, TextureDownsampling::DownsampleOptions(), &task_manager);
+					resized_map_uint8 = outputs[0].result;
+				}
+				else
+				{
+					Reference<Map2D> resized_map = imagemap->resizeMidQuality(new_W, new_W, &task_manager);
 
-				runtimeCheck(resized_map.isType<ImageMapUInt8>());
-				ImageMapUInt8Ref resized_map_uint8 = resized_map.downcast<ImageMapUInt8>();
+					runtimeCheck(resized_map.isType<ImageMapUInt8>());
+					resized_map_uint8 = resized_map.downcast<ImageMapUInt8>();
+				}
 
 				if(resized_map_uint8->numChannels() > 3)
 					resized_map_uint8 = resized_map_uint8->extract3ChannelImage();
@@ -378,7 +408,15 @@ static void buildAndSaveArrayTexture(const std::vector<std::string>& used_tex_pa
 
 			params.m_etc1s_quality_level = 128;
 
-			basisu::job_pool jpool(PlatformUtils::getNumLogicalProcessors());
+			// Chunk building is background work, so reserve encoder threads from the global Basis encoding budget at low priority.
+			size_t num_pixels = 0;
+			for(size_t i=0; i<params.m_source_images.size(); ++i)
+				num_pixels += (size_t)params.m_source_images[i].get_width() * params.m_source_images[i].get_height();
+
+			BasisEncodingService::ThreadReservation thread_reservation(basis_encoding_service, BasisEncodingService::numThreadsForImage(num_pixels, /*max_total_threads=*/(int)PlatformUtils::getNumLogicalProcessors()), 
+				BasisEncodingService::Priority_Low);
+
+			basisu::job_pool jpool((uint32)thread_reservation.numThreads());
 			params.m_pJob_pool = &jpool;
 
 			basisu::basis_compressor basisCompressor;
@@ -409,7 +447,8 @@ static void buildAndSaveArrayTexture(const std::vector<std::string>& used_tex_pa
 }
 
 
-static ChunkBuildResults buildChunkForObInfo(std::vector<ObInfo>& ob_infos, int chunk_x, int chunk_y, glare::TaskManager& task_manager)
+static ChunkBuildResults buildChunkForObInfo(std::vector<ObInfo>& ob_infos, int chunk_x, int chunk_y, glare::TaskManager& task_manager, DecodedImageCache* image_cache, std::map<std::string, uint64>& tex_content_hashes, 
+	BasisEncodingService& basis_encoding_service)
 {
 	ChunkBuildResults results;
 	results.ob_batch_ranges.resize(ob_infos.size());
@@ -459,7 +498,7 @@ static ChunkBuildResults buildChunkForObInfo(std::vector<ObInfo>& ob_infos, int
 		try
 		{
 			Matrix4f voxel_scale_matrix;
-			BatchedMeshRef mesh = loadAndSimplifyGeometry(ob_info, mesh_cache, /*voxel_scale_matrix_out=*/voxel_scale_matrix);
+			BatchedMeshRef mesh = loadAndSimplifyGeometry(ob_info, mesh_cache, task_manager, /*voxel_scale_matrix_out=*/voxel_scale_matrix);
 			
 			if(mesh.nonNull() && (mesh->numIndices() > 0))
 			{
@@ -931,7 +970,7 @@ static ChunkBuildResults buildChunkForObInfo(std::vector<ObInfo>& ob_infos, int
 			std::map<std::string, int> array_image_indices; // Index of texture in texture array.
 			// There will be no entry in the map for the path if the texture could not be loaded.
 
-			buildAndSaveArrayTexture(used_tex_paths, task_manager, chunk_x, chunk_y, 
+			buildAndSaveArrayTexture(used_tex_paths, task_manager, image_cache, tex_content_hashes, basis_encoding_service, chunk_x, chunk_y, 
 				array_image_indices, // array_image_indices_out
 				results.combined_texture_path, // combined_texture_path_out
 				results.combined_texture_hash // combined_texture_hash_out
@@ -1052,92 +1091,97 @@ static ChunkBuildResults buildChunkForObInfo(std::vector<ObInfo>& ob_infos, int
 }
 
 
-static ChunkBuildResults buildChunk(ServerAllWorldsState* world_state, Reference<ServerWorldState> world, const js::AABBox chunk_aabb, int chunk_x, int chunk_y, glare::TaskManager& task_manager)
+static ChunkBuildResults buildChunk(ServerAllWorldsState* world_state, Reference<ServerWorldState> world, const js::AABBox chunk_aabb, int chunk_x, int chunk_y, glare::TaskManager& task_manager, 
+	std::map<std::string, uint64>& tex_content_hashes)
 {
 	std::vector<ObInfo> ob_infos;
 
 	{
 		WorldStateLock lock(world_state->mutex);
-		ServerWorldState::ObjectMapType& objects = world->getObjects(lock);
-		for(auto it = objects.begin(); it != objects.end(); ++it)
+
+		// Get objects with centroid in the chunk, that are not excluded from LOD chunk meshes.
+		// Sort by UID so the objects are added to the chunk mesh in the same order each time.
+		std::vector<WorldObject*> chunk_obs;
+		world->getObjectHotTable(lock).getObjectsWithCentroidInAABB(chunk_aabb, WorldObject::EXCLUDE_FROM_LOD_CHUNK_MESH, chunk_obs);
+		std::sort(chunk_obs.begin(), chunk_obs.end(), [](const WorldObject* a, const WorldObject* b) { return a->uid < b->uid; });
+
+		for(size_t z=0; z<chunk_obs.size(); ++z)
 		{
-			WorldObjectRef ob = it->second;
-			if(chunk_aabb.contains(ob->getCentroidWS()) && !BitUtils::isBitSet(ob->flags, WorldObject::EXCLUDE_FROM_LOD_CHUNK_MESH))
+			WorldObjectRef ob = chunk_obs[z];
+
+			bool have_mesh = false;
+			if(ob->object_type == WorldObject::ObjectType_Generic)
 			{
-				bool have_mesh = false;
-				if(ob->object_type == WorldObject::ObjectType_Generic)
-				{
-					if(!ob->model_url.empty())
-					{
-						const std::string model_path = world_state->resource_manager->pathForURL(ob->model_url);
-						if(FileUtils::fileExists(model_path))
-							have_mesh = true;
-					}
-				}
-				else if(ob->object_type == WorldObject::ObjectType_VoxelGroup)
+				if(!ob->model_url.empty())
 				{
-					if(ob->getCompressedVoxels() && ob->getCompressedVoxels()->size() > 0)
+					const std::string model_path = world_state->resource_manager->pathForURL(ob->model_url);
+					if(FileUtils::fileExists(model_path))
 						have_mesh = true;
 				}
+			}
+			else if(ob->object_type == WorldObject::ObjectType_VoxelGroup)
+			{
+				if(ob->getCompressedVoxels() && ob->getCompressedVoxels()->size() > 0)
+					have_mesh = true;
+			}
 
 
-				if(have_mesh)
-				{
-					if(!isFinite(ob->angle))
-						ob->angle = 0;
+			if(have_mesh)
+			{
+				if(!isFinite(ob->angle))
+					ob->angle = 0;
 
-					if(/*!isFinite(ob->angle) || */!ob->axis.isFinite())
-					{
-						//	throw glare::Exception("Invalid angle or axis");
-					}
-					else
-					{
-						ObInfo ob_info;
+				if(/*!isFinite(ob->angle) || */!ob->axis.isFinite())
+				{
+					//	throw glare::Exception("Invalid angle or axis");
+				}
+				else
+				{
+					ObInfo ob_info;
 
-						ob_info.ob_uid = ob->uid;
+					ob_info.ob_uid = ob->uid;
 
-						if(!ob->model_url.empty())
-							ob_info.model_path = world_state->resource_manager->pathForURL(ob->model_url);
-						
-						ob_info.compressed_voxels = ob->getCompressedVoxels();
+					if(!ob->model_url.empty())
+						ob_info.model_path = world_state->resource_manager->pathForURL(ob->model_url);
+					
+					ob_info.compressed_voxels = ob->getCompressedVoxels();
+
+					ob_info.ob_to_world = obToWorldMatrix(*ob);
+					ob_info.ob_to_world_scale = myMax(ob->scale.x, ob->scale.y, ob->scale.z);
+					ob_info.object_type = ob->object_type;
+					ob_info.aabb_ws = ob->getAABBWS();
+
+					ob_info.mat_info.resize(ob->materials.size());
+					
+					for(size_t i=0; i<ob->materials.size(); ++i)
+					{
+						WorldMaterial* mat = ob->materials[i].ptr();
 
-						ob_info.ob_to_world = obToWorldMatrix(*ob);
-						ob_info.ob_to_world_scale = myMax(ob->scale.x, ob->scale.y, ob->scale.z);
-						ob_info.object_type = ob->object_type;
-						ob_info.aabb_ws = ob->getAABBWS();
+						ob_info.mat_info[i].tex_matrix = mat->tex_matrix;
 
-						ob_info.mat_info.resize(ob->materials.size());
-						
-						for(size_t i=0; i<ob->materials.size(); ++i)
+						if(!mat->colour_texture_url.empty())
 						{
-							WorldMaterial* mat = ob->materials[i].ptr();
-
-							ob_info.mat_info[i].tex_matrix = mat->tex_matrix;
-
-							if(!mat->colour_texture_url.empty())
-							{
-								const std::string tex_path = world_state->resource_manager->pathForURL(mat->colour_texture_url);
-								ob_info.mat_info[i].tex_path = tex_path;
-							}
-
-							ob_info.mat_info[i].emission_lum_flux_or_lum = mat->emission_lum_flux_or_lum;
-							ob_info.mat_info[i].roughness = mat->roughness.val;
-							ob_info.mat_info[i].metallic = mat->metallic_fraction.val;
-							ob_info.mat_info[i].colour_rgb = mat->colour_rgb;
-							ob_info.mat_info[i].opacity = mat->opacity.val;
-							//ob_info.mat_info[i].flags = OpenGLEngine::matFlags(*mat);
+							const std::string tex_path = world_state->resource_manager->pathForURL(mat->colour_texture_url);
+							ob_info.mat_info[i].tex_path = tex_path;
 						}
 
-
-						ob_infos.push_back(ob_info);
+						ob_info.mat_info[i].emission_lum_flux_or_lum = mat->emission_lum_flux_or_lum;
+						ob_info.mat_info[i].roughness = mat->roughness.val;
+						ob_info.mat_info[i].metallic = mat->metallic_fraction.val;
+						ob_info.mat_info[i].colour_rgb = mat->colour_rgb;
+						ob_info.mat_info[i].opacity = mat->opacity.val;
+						//ob_info.mat_info[i].flags = OpenGLEngine::matFlags(*mat);
 					}
+
+
+					ob_infos.push_back(ob_info);
 				}
 			}
 		}
 	} // End lock scope.
 
 
-	ChunkBuildResults results = buildChunkForObInfo(ob_infos, chunk_x, chunk_y, task_manager);
+	ChunkBuildResults results = buildChunkForObInfo(ob_infos, chunk_x, chunk_y, task_manager, &world_state->decoded_image_cache, tex_content_hashes, world_state->basis_encoding_service);
 	return results;
 }
 
@@ -1285,7 +1329,8 @@ void ChunkGenThread::doRun()
 						Vec4f((x + 1) * chunk_w, (y + 1) * chunk_w, 1000.f, 1.f) // max
 					);
 
-					buildChunk(all_worlds_state, world_state, chunk_aabb, x, y, task_manager);
+					std::map<std::string, uint64> tex_content_hashes;
+					buildChunk(all_worlds_state, world_state, chunk_aabb, x, y, task_manager, tex_content_hashes);
 				}
 			}
 
@@ -1308,7 +1353,8 @@ void ChunkGenThread::doRun()
 
 		while(1)
 		{
-			
+			std::map<std::string, uint64> tex_content_hashes; // Map from texture abs path to content hash.  Per pass, so it doesn't grow over the life of the thread.
+
 			std::vector<ChunkToBuild> dirty_chunks;
 
 			{
@@ -1344,7 +1390,7 @@ void ChunkGenThread::doRun()
 
 				conPrint("================================= Building chunk " + toString(x) + ", " + toString(y) + " (" + toString(i) + "/" + toString(dirty_chunks.size()) + " dirty chunks) =================================");
 
-				const ChunkBuildResults results = buildChunk(all_worlds_state, dirty_chunks[i].world_state, chunk_aabb, x, y, task_manager);
+				const ChunkBuildResults results = buildChunk(all_worlds_state, dirty_chunks[i].world_state, chunk_aabb, x, y, task_manager, tex_content_hashes);
 
 				conPrint("====== chunk " + toString(x) + ", " + toString(y) + " built. ======");
 
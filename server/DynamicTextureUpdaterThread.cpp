@@ -18,11 +18,14 @@ Copyright Glare Technologies Limited 2023 -
 #include <PlatformUtils.h>
 #include <Timer.h>
 #include <TaskManager.h>
+#include <Task.h>
 #include <FileUtils.h>
 #include <IncludeXXHash.h>
 #include <HTTPClient.h>
 #include <KillThreadMessage.h>
 #include <graphics/ImageMap.h>
+#include <ctime>
+#include <set>
 
 
 DynamicTextureUpdaterThread::DynamicTextureUpdaterThread(Server* server_, ServerAllWorldsState* world_state_)
@@ -88,174 +91,252 @@ static std::string sanitiseString(const std::string& s)
 }
 
 
-struct DynTextureFetchResults
+// Returns the current time minus offset_s, formatted as an HTTP-date, e.g. "Sun, 06 Nov 1994 08:49:37 GMT".  See https://www.rfc-editor.org/rfc/rfc9110#name-date-time-formats
+static std::string currentHTTPDate(int offset_s)
 {
-	URLString substrata_URL; // Set to empty string if exception occurred or download failed.
-};
+	const time_t t = time(NULL) - offset_s;
+	struct tm gmt;
+#if defined(_WIN32)
+	gmtime_s(&gmt, &t);
+#else
+	gmtime_r(&t, &gmt);
+#endif
+	char buf[64];
+	strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &gmt);
+	return std::string(buf);
+}
 
 
-// Returns substrata URL of resource for the downloaded file.
-static URLString fetchFileForURLAndAddAsResource(const std::string& base_URL, ServerAllWorldsState* world_state)
+// Get the host part of a URL, e.g. returns "example.com" for "https://example.com:8080/image.jpg".
+static std::string getHostForURL(const std::string& URL)
 {
-	HTTPClient http_client;
-	http_client.setAsNotIndependentlyHeapAllocated();
-	http_client.max_data_size			= 32 * 1024 * 1024; // 32 MB
-	http_client.max_socket_buffer_size	= 32 * 1024 * 1024; // 32 MB
+	const size_t scheme_end = URL.find("://");
+	const size_t host_start = (scheme_end == std::string::npos) ? 0 : (scheme_end + 3);
+
+	size_t host_end = host_start;
+	while(host_end < URL.size() && URL[host_end] != '/' && URL[host_end] != ':' && URL[host_end] != '?')
+		host_end++;
+
+	return toLowerCase(URL.substr(host_start, host_end - host_start));
+}
 
-	std::vector<uint8> data;
-	HTTPClient::ResponseInfo response = http_client.downloadFile(base_URL, data);
 
-	if(response.response_code >= 200 && response.response_code < 300)
+static void doFetch(DynTexFetch& fetch)
+{
+	try
 	{
-		conPrint("\tDynamicTextureUpdaterThread: Got HTTP " + toString(response.response_code) + " response, file size: " + ::getNiceByteSize(data.size()));
+		HTTPClient http_client;
+		http_client.setAsNotIndependentlyHeapAllocated();
+		http_client.max_data_size			= 32 * 1024 * 1024; // 32 MB
+		http_client.max_socket_buffer_size	= 32 * 1024 * 1024; // 32 MB
+
+		// Make the request conditional if we have fetched this URL successfully before.
+		if(!fetch.prev_state.last_fetch_http_date.empty())
+			http_client.additional_headers.push_back("If-Modified-Since: " + fetch.prev_state.last_fetch_http_date);
+
+		// Get time before doing the request, so we don't miss any changes made during the request.
+		// The date is from our clock, which may be ahead of the origin server's clock, in which case the server would say a changed file was not modified.
+		// So subtract a safety margin.  Any extra full responses this causes are caught by the content hash comparison below.
+		const int CLOCK_SKEW_MARGIN_S = 600;
+		const std::string fetch_http_date = currentHTTPDate(/*offset_s=*/CLOCK_SKEW_MARGIN_S);
 
-		// If original URL didn't have a file extension in it, pick one based on MIME type
-		std::string use_extension = sanitiseString(::getExtension(base_URL));
-		if(use_extension.empty())
+		HTTPClient::ResponseInfo response = http_client.downloadFile(fetch.base_URL, fetch.data);
+
+		if(response.response_code == 304)
+		{
+			fetch.result = DynTexFetch::Result_NotModified;
+			fetch.data.clear();
+		}
+		else if(response.response_code >= 200 && response.response_code < 300)
 		{
-			// Work out extension to use - see https://developer.mozilla.org/en-US/docs/Web/HTTP/Basics_of_HTTP/MIME_types
-			if(response.mime_type == "image/gif")
-				use_extension = "gif";
-			else if(response.mime_type == "image/jpeg")
-				use_extension = "jpg";
-			else if(response.mime_type == "image/png")
-				use_extension = "png";
+			fetch.content_hash = XXH64(fetch.data.data(), fetch.data.size(), /*seed=*/1);
+			fetch.mime_type = response.mime_type;
+			fetch.fetch_http_date = fetch_http_date;
+
+			// If the image data is the same as last time, we don't need to do anything else with it.
+			if(!fetch.prev_state.substrata_URL.empty() && (fetch.content_hash == fetch.prev_state.content_hash))
+			{
+				fetch.result = DynTexFetch::Result_ContentUnchanged;
+				fetch.data.clear();
+			}
 			else
-				throw glare::Exception("Unknown MIME type for image or unsupported MIME type: '" + response.mime_type + "'");
+				fetch.result = DynTexFetch::Result_NewContent;
+		}
+		else
+		{
+			fetch.result = DynTexFetch::Result_Failed;
+			fetch.error_msg = "Non 200 HTTP return code: " + toString(response.response_code) + ", msg: '" + response.response_message + "'";
+			fetch.data.clear();
 		}
+	}
+	catch(glare::Exception& e)
+	{
+		fetch.result = DynTexFetch::Result_Failed;
+		fetch.error_msg = e.what();
+		fetch.data.clear();
+	}
+}
 
-		if(!ImageDecoding::isSupportedImageExtension(use_extension))
-			throw glare::Exception("Image type extension not supported: '" + use_extension + "'.");
 
-		if(!ImageDecoding::areMagicBytesValid(data.data(), data.size(), use_extension))
-			throw glare::Exception("Image magic bytes are not valid for extension '" + use_extension + "'.");
+// Does a list of fetches sequentially.
+// Each task does the fetches for one 'lane' to a host, which limits the number of concurrent requests to a single host.
+class DynTexFetchTask : public glare::Task
+{
+public:
+	virtual void run(size_t thread_index) override
+	{
+		for(size_t i=0; i<fetch_indices.size(); ++i)
+			doFetch((*fetches)[fetch_indices[i]]);
+	}
 
-		const uint64 hash = XXH64(data.data(), data.size(), /*seed=*/1);
+	std::vector<DynTexFetch>* fetches;
+	std::vector<size_t> fetch_indices;
+};
 
-		const URLString URL = ResourceManager::URLForNameAndExtensionAndHash(::removeDotAndExtension(base_URL), use_extension, hash);
 
-		conPrint("\tDynamicTextureUpdaterThread: current/new URL: " + toStdString(URL) + "");
+void DynamicTextureUpdaterThread::doFetches(std::vector<DynTexFetch>& fetches, glare::TaskManager& task_manager, size_t max_concurrent_fetches_per_host)
+{
+	assert(max_concurrent_fetches_per_host >= 1);
 
-		if(URL.size() > WorldObject::MAX_URL_SIZE)
-			throw glare::Exception("URL too long.");
+	// Group fetches by host
+	std::map<std::string, std::vector<size_t>> host_fetch_indices;
+	for(size_t i=0; i<fetches.size(); ++i)
+		host_fetch_indices[getHostForURL(fetches[i].base_URL)].push_back(i);
 
+	// Split the fetches for each host into at most max_concurrent_fetches_per_host lanes.
+	// Overall concurrency is limited by the number of task manager threads.
+	Reference<glare::TaskGroup> task_group = new glare::TaskGroup();
+	for(auto it = host_fetch_indices.begin(); it != host_fetch_indices.end(); ++it)
+	{
+		const std::vector<size_t>& indices = it->second;
+		const size_t num_lanes = myMin(indices.size(), max_concurrent_fetches_per_host);
+		for(size_t lane=0; lane<num_lanes; ++lane)
 		{
-			Lock lock(world_state->mutex);
-
-			if(!world_state->resource_manager->isFileForURLPresent(URL))
-			{
-				conPrint("\tDynamicTextureUpdaterThread: Resource not already present, adding to resource_manager...");
+			Reference<DynTexFetchTask> task = new DynTexFetchTask();
+			task->fetches = &fetches;
+			for(size_t z=lane; z<indices.size(); z += num_lanes)
+				task->fetch_indices.push_back(indices[z]);
+			task_group->tasks.push_back(task);
+		}
+	}
 
-				const std::string local_abs_path = world_state->resource_manager->pathForURL(URL);
+	if(!task_group->tasks.empty())
+		task_manager.runTaskGroup(task_group);
+}
 
-				FileUtils::writeEntireFile(local_abs_path, data);
 
-				world_state->resource_manager->setResourceAsLocallyPresentForURL(URL);
+// Validates the fetched image data, and adds it as a resource if not already present.
+// Returns substrata URL of resource for the downloaded file.
+static URLString addFetchedImageAsResource(const DynTexFetch& fetch, ServerAllWorldsState* world_state)
+{
+	const std::string& base_URL = fetch.base_URL;
+	const std::vector<uint8>& data = fetch.data;
 
-				ResourceRef resource = world_state->resource_manager->getExistingResourceForURL(URL);
-				world_state->addResourceAsDBDirty(resource);
-			}
-			else
-			{
-				conPrint("\tDynamicTextureUpdaterThread: texture is already present as a resource.");
-			}
-		} // End lock scope
+	conPrint("\tDynamicTextureUpdaterThread: Got new image data for '" + base_URL + "', file size: " + ::getNiceByteSize(data.size()));
 
-		return URL;
+	// If original URL didn't have a file extension in it, pick one based on MIME type
+	std::string use_extension = sanitiseString(::getExtension(base_URL));
+	if(use_extension.empty())
+	{
+		// Work out extension to use - see https://developer.mozilla.org/en-US/docs/Web/HTTP/Basics_of_HTTP/MIME_types
+		if(fetch.mime_type == "image/gif")
+			use_extension = "gif";
+		else if(fetch.mime_type == "image/jpeg")
+			use_extension = "jpg";
+		else if(fetch.mime_type == "image/png")
+			use_extension = "png";
+		else
+			throw glare::Exception("Unknown MIME type for image or unsupported MIME type: '" + fetch.mime_type + "'");
 	}
-	else
-		throw glare::Exception("Non 200 HTTP return code: " + toString(response.response_code) + ", msg: '" + response.response_message + "'"); 
 
-}
+	if(!ImageDecoding::isSupportedImageExtension(use_extension))
+		throw glare::Exception("Image type extension not supported: '" + use_extension + "'.");
 
+	if(!ImageDecoding::areMagicBytesValid(data.data(), data.size(), use_extension))
+		throw glare::Exception("Image magic bytes are not valid for extension '" + use_extension + "'.");
 
-static void checkDynamicTexture(const ObWithDynamicTexture& ob_with_dyn_tex, ServerAllWorldsState* world_state, Server* server, std::map<std::string, DynTextureFetchResults>& fetch_results_map)
-{
-	const std::string base_URL = ob_with_dyn_tex.script->base_image_URL;
+	const URLString URL = ResourceManager::URLForNameAndExtensionAndHash(::removeDotAndExtension(base_URL), use_extension, fetch.content_hash);
+
+	conPrint("\tDynamicTextureUpdaterThread: current/new URL: " + toStdString(URL) + "");
+
+	if(URL.size() > WorldObject::MAX_URL_SIZE)
+		throw glare::Exception("URL too long.");
 
-	const auto fetch_it = fetch_results_map.find(base_URL);
-	if(fetch_it == fetch_results_map.end())
 	{
-		conPrint("\tDynamicTextureUpdaterThread: Requesting file at URL '" + ob_with_dyn_tex.script->base_image_URL + "'...");
+		Lock lock(world_state->mutex);
 
-		try
+		if(!world_state->resource_manager->isFileForURLPresent(URL))
 		{
-			const URLString substrata_URL = fetchFileForURLAndAddAsResource(base_URL, world_state);
+			conPrint("\tDynamicTextureUpdaterThread: Resource not already present, adding to resource_manager...");
+
+			const std::string local_abs_path = world_state->resource_manager->pathForURL(URL);
+
+			FileUtils::writeEntireFile(local_abs_path, data);
 
-			fetch_results_map[base_URL] = DynTextureFetchResults({substrata_URL});
+			world_state->resource_manager->setResourceAsLocallyPresentForURL(URL);
+
+			ResourceRef resource = world_state->resource_manager->getExistingResourceForURL(URL);
+			world_state->addResourceAsDBDirty(resource);
 		}
-		catch(glare::Exception& e)
+		else
 		{
-			conPrint("\tDynamicTextureUpdaterThread: Excep fetching URL '" + base_URL + "': " + e.what());
-			fetch_results_map[base_URL] = DynTextureFetchResults({""});
+			conPrint("\tDynamicTextureUpdaterThread: texture is already present as a resource.");
 		}
-	}
+	} // End lock scope
 
-	assert(fetch_results_map.count(base_URL) > 0);
-	DynTextureFetchResults fetch_results = fetch_results_map[base_URL];
+	return URL;
+}
 
-	if(fetch_results.substrata_URL.empty())
-	{
-		// We already tried to fetch from this URL, and it failed.
-		conPrint("\tDynamicTextureUpdaterThread: Fetch for URL '" + base_URL + "' failed, skipping");
-	}
-	else
+
+// Update the object material texture to use substrata_URL, if it is not already using it.
+static void updateObjectDynamicTexture(const ObWithDynamicTexture& ob_with_dyn_tex, const URLString& substrata_URL, ServerAllWorldsState* world_state, Server* server, WorldStateLock& lock) REQUIRES(world_state->mutex)
+{
+	// Update object to use new texture
+	const auto ob_res = world_state->world_states[ob_with_dyn_tex.world_name]->getObjects(lock).find(ob_with_dyn_tex.ob_uid);
+	if(ob_res != world_state->world_states[ob_with_dyn_tex.world_name]->getObjects(lock).end())
 	{
-		{
-			WorldStateLock lock(world_state->mutex);
+		WorldObject* ob = ob_res->second.ptr();
 
-			const URLString substrata_URL = fetch_results.substrata_URL;
+		if(ob_with_dyn_tex.script->material_index < ob->materials.size())
+		{
+			WorldMaterial* material = ob->materials[ob_with_dyn_tex.script->material_index].ptr();
 
-			// Update object to use new texture
-			const auto ob_res = world_state->world_states[ob_with_dyn_tex.world_name]->getObjects(lock).find(ob_with_dyn_tex.ob_uid);
-			if(ob_res != world_state->world_states[ob_with_dyn_tex.world_name]->getObjects(lock).end())
+			bool tex_URL_changed = false;
+			if(ob_with_dyn_tex.script->material_texture == "colour")
 			{
-				WorldObject* ob = ob_res->second.ptr();
-
-				if(ob_with_dyn_tex.script->material_index < ob->materials.size())
+				if(substrata_URL != material->colour_texture_url) // If new URL is different from existing texture URL:
 				{
-					WorldMaterial* material = ob->materials[ob_with_dyn_tex.script->material_index].ptr();
-
-					bool tex_URL_changed = false;
-					if(ob_with_dyn_tex.script->material_texture == "colour")
-					{
-						if(substrata_URL != material->colour_texture_url) // If new URL is different from existing texture URL:
-						{
-							material->colour_texture_url = substrata_URL;
-							tex_URL_changed = true;
-						}
-					}
-					else if(ob_with_dyn_tex.script->material_texture == "emission")
-					{
-						if(substrata_URL != material->emission_texture_url) // If new URL is different from existing texture URL:
-						{
-							material->emission_texture_url = substrata_URL;
-							tex_URL_changed = true;
-						}
-					}
-					else
-						throw glare::Exception("Invalid material_texture type");
+					material->colour_texture_url = substrata_URL;
+					tex_URL_changed = true;
+				}
+			}
+			else if(ob_with_dyn_tex.script->material_texture == "emission")
+			{
+				if(substrata_URL != material->emission_texture_url) // If new URL is different from existing texture URL:
+				{
+					material->emission_texture_url = substrata_URL;
+					tex_URL_changed = true;
+				}
+			}
+			else
+				throw glare::Exception("Invalid material_texture type");
 
-					if(tex_URL_changed) // If new URL is different from existing texture URL:
-					{
-						conPrint("\tDynamicTextureUpdaterThread: Texture is different from existing texture, updating object...");
+			if(tex_URL_changed) // If new URL is different from existing texture URL:
+			{
+				conPrint("\tDynamicTextureUpdaterThread: Texture is different from existing texture, updating object...");
 
-						world_state->world_states[ob_with_dyn_tex.world_name]->addWorldObjectAsDBDirty(ob, lock);
-						world_state->markAsChanged();
+				world_state->world_states[ob_with_dyn_tex.world_name]->addWorldObjectAsDBDirty(ob, lock);
+				world_state->markAsChanged();
 
-						ob->from_remote_other_dirty = true; // Set this so a ObjectFullUpdate message is sent to clients.
-						world_state->world_states[ob_with_dyn_tex.world_name]->getDirtyFromRemoteObjects(lock).insert(ob);
+				ob->from_remote_other_dirty = true; // Set this so a ObjectFullUpdate message is sent to clients.
+				world_state->world_states[ob_with_dyn_tex.world_name]->getDirtyFromRemoteObjects(lock).insert(ob);
 
-						// Send a message to MeshLODGenThread to generate LOD textures for this new texture (if not already generated)
-						CheckGenResourcesForObject* msg = new CheckGenResourcesForObject();
-						msg->ob_uid = ob_with_dyn_tex.ob_uid;
-						server->enqueueMsgForLodGenThread(msg);
-					}
-					else
-						conPrint("\tDynamicTextureUpdaterThread: Texture is the same as existing texture on object.");
-				}
+				// Send a message to MeshLODGenThread to generate LOD textures for this new texture (if not already generated)
+				CheckGenResourcesForObject* msg = new CheckGenResourcesForObject();
+				msg->ob_uid = ob_with_dyn_tex.ob_uid;
+				server->enqueueMsgForLodGenThread(msg);
 			}
-		} // End lock scope
+		}
 	}
 }
 
@@ -264,6 +345,8 @@ void DynamicTextureUpdaterThread::doRun()
 {
 	PlatformUtils::setCurrentThreadName("DynamicTextureUpdaterThread");
 
+	glare::TaskManager task_manager("DynamicTextureUpdaterThread task manager", MAX_CONCURRENT_FETCHES);
+
 	try
 	{
 		while(1)
@@ -323,27 +406,101 @@ void DynamicTextureUpdaterThread::doRun()
 			conPrint("DynamicTextureUpdaterThread: Iterating over objects took " + timer.elapsedStringNSigFigs(4) + ", obs_with_dyn_textures: " + toString(obs_with_dyn_textures.size()));
 			//----------------------------------------------------------------------------------------------------------------------------------------------------
 
-			//-------------------------------------------  Check each dynamic texture, without holding the world lock -------------------------------------------
+			//-------------------------------------------  Fetch each source image concurrently, without holding the world lock -------------------------------------------
 			conPrint("DynamicTextureUpdaterThread: Checking for image updates...");
 			timer.reset();
 
-			std::map<std::string, DynTextureFetchResults> fetch_results_map;
-
-			for(size_t i=0; i<obs_with_dyn_textures.size(); ++i)
+			std::vector<DynTexFetch> fetches;
 			{
-				const ObWithDynamicTexture& ob_with_dyn_tex = obs_with_dyn_textures[i];
-				try
+				std::set<std::string> base_URLs;
+				for(size_t i=0; i<obs_with_dyn_textures.size(); ++i)
+					base_URLs.insert(obs_with_dyn_textures[i].script->base_image_URL);
+
+				// Remove state for URLs no longer used by any object.
+				for(auto it = url_states.begin(); it != url_states.end(); )
 				{
-					conPrint("DynamicTextureUpdaterThread: Checking dynamic texture for URL '" + ob_with_dyn_tex.script->base_image_URL + "'");
+					if(base_URLs.count(it->first) == 0)
+						it = url_states.erase(it);
+					else
+						++it;
+				}
+
+				fetches.resize(base_URLs.size());
+				size_t i = 0;
+				for(auto it = base_URLs.begin(); it != base_URLs.end(); ++it, ++i)
+				{
+					fetches[i].base_URL = *it;
+					auto res = url_states.find(*it);
+					if(res != url_states.end())
+						fetches[i].prev_state = res->second;
+				}
+			}
 
-					checkDynamicTexture(ob_with_dyn_tex, world_state, server, fetch_results_map);
+			doFetches(fetches, task_manager, MAX_CONCURRENT_FETCHES_PER_HOST);
+
+			size_t num_failed = 0, num_not_modified = 0, num_unchanged = 0, num_new = 0;
+			for(size_t i=0; i<fetches.size(); ++i)
+			{
+				DynTexFetch& fetch = fetches[i];
+				if(fetch.result == DynTexFetch::Result_Failed)
+				{
+					conPrint("\tDynamicTextureUpdaterThread: Excep fetching URL '" + fetch.base_URL + "': " + fetch.error_msg);
+					num_failed++;
+				}
+				else if(fetch.result == DynTexFetch::Result_NotModified)
+				{
+					num_not_modified++;
+				}
+				else if(fetch.result == DynTexFetch::Result_ContentUnchanged)
+				{
+					url_states[fetch.base_URL].last_fetch_http_date = fetch.fetch_http_date;
+					num_unchanged++;
 				}
-				catch(glare::Exception& e)
+				else if(fetch.result == DynTexFetch::Result_NewContent)
 				{
-					conPrint("\tDynamicTextureUpdaterThread: glare::Exception while checking dynamic texture changes: " + e.what());
+					try
+					{
+						const URLString substrata_URL = addFetchedImageAsResource(fetch, world_state);
+
+						DynTexURLState& state = url_states[fetch.base_URL];
+						state.content_hash = fetch.content_hash;
+						state.substrata_URL = substrata_URL;
+						state.last_fetch_http_date = fetch.fetch_http_date;
+						num_new++;
+					}
+					catch(glare::Exception& e)
+					{
+						conPrint("\tDynamicTextureUpdaterThread: Excep processing image from URL '" + fetch.base_URL + "': " + e.what());
+						num_failed++;
+					}
 				}
 			}
-			conPrint("DynamicTextureUpdaterThread: Done checking for image updates textures. (Elapsed: " + timer.elapsedStringNSigFigs(4) + ")");
+
+			conPrint("DynamicTextureUpdaterThread: Fetched " + toString(fetches.size()) + " URL(s): " + toString(num_new) + " new, " + toString(num_unchanged) + " unchanged, " + 
+				toString(num_not_modified) + " not modified, " + toString(num_failed) + " failed. (Elapsed: " + timer.elapsedStringNSigFigs(4) + ")");
+
+			//-------------------------------------------  Update objects to use the latest textures -------------------------------------------
+			{
+				WorldStateLock lock(world_state->mutex);
+
+				for(size_t i=0; i<obs_with_dyn_textures.size(); ++i)
+				{
+					const ObWithDynamicTexture& ob_with_dyn_tex = obs_with_dyn_textures[i];
+
+					auto res = url_states.find(ob_with_dyn_tex.script->base_image_URL);
+					if(res != url_states.end() && !res->second.substrata_URL.empty())
+					{
+						try
+						{
+							updateObjectDynamicTexture(ob_with_dyn_tex, res->second.substrata_URL, world_state, server, lock);
+						}
+						catch(glare::Exception& e)
+						{
+							conPrint("\tDynamicTextureUpdaterThread: glare::Exception while updating object dynamic texture: " + e.what());
+						}
+					}
+				}
+			} // End lock scope
 			//----------------------------------------------------------------------------------------------------------------------------------------------------
 		}
 	}
@@ -356,3 +513,115 @@ void DynamicTextureUpdaterThread::doRun()
 		conPrint(std::string("DynamicTextureUpdaterThread: Caught std::exception: ") + e.what());
 	}
 }
+
+
+#if BUILD_TESTS
+
+
+#include "TestHTTPServer.h"
+#include <TestUtils.h>
+
+
+void DynamicTextureUpdaterThread::test()
+{
+	conPrint("DynamicTextureUpdaterThread::test()");
+
+	testAssert(getHostForURL("https://example.com:8080/image.jpg") == "example.com");
+	testAssert(getHostForURL("http://Example.com/a/b.png?x=1") == "example.com");
+	testAssert(getHostForURL("http://example.com") == "example.com");
+
+	TestHTTPServer test_server(/*port=*/39471);
+	const std::string base = test_server.getBaseURL();
+
+	glare::TaskManager task_manager("DynamicTextureUpdaterThread test task manager", MAX_CONCURRENT_FETCHES);
+
+	//------------------------------- Test conditional requests and the response-hash short circuit -------------------------------
+	{
+		test_server.setFile("/a.png", "image data 1", "image/png");
+
+		std::vector<DynTexFetch> fetches(1);
+		fetches[0].base_URL = base + "/a.png";
+
+		// First fetch should return the full image.
+		doFetches(fetches, task_manager, MAX_CONCURRENT_FETCHES_PER_HOST);
+		testAssert(fetches[0].result == DynTexFetch::Result_NewContent);
+		testAssert(std::string(fetches[0].data.begin(), fetches[0].data.end()) == "image data 1");
+		testAssert(fetches[0].mime_type == "image/png");
+		testAssert(!fetches[0].fetch_http_date.empty());
+
+		DynTexURLState state;
+		state.content_hash = fetches[0].content_hash;
+		state.substrata_URL = "a_1234.png";
+		state.last_fetch_http_date = fetches[0].fetch_http_date;
+
+		// Second fetch is conditional, file is not modified, so should get a 304.
+		fetches[0] = DynTexFetch();
+		fetches[0].base_URL = base + "/a.png";
+		fetches[0].prev_state = state;
+		doFetches(fetches, task_manager, MAX_CONCURRENT_FETCHES_PER_HOST);
+		testAssert(fetches[0].result == DynTexFetch::Result_NotModified);
+		testAssert(fetches[0].data.empty());
+		testAssert(test_server.getNumRequests("/a.png") == 2);
+		testAssert(test_server.getNumFullResponses("/a.png") == 1);
+
+		// Touch the file on the server without changing the content.  Full response should be returned, but should be detected as unchanged from the hash.
+		test_server.setFile("/a.png", "image data 1", "image/png");
+		fetches[0] = DynTexFetch();
+		fetches[0].base_URL = base + "/a.png";
+		fetches[0].prev_state = state;
+		doFetches(fetches, task_manager, MAX_CONCURRENT_FETCHES_PER_HOST);
+		testAssert(fetches[0].result == DynTexFetch::Result_ContentUnchanged);
+		testAssert(fetches[0].data.empty());
+		testAssert(test_server.getNumFullResponses("/a.png") == 2);
+
+		// Change the content.
+		test_server.setFile("/a.png", "image data 2", "image/png");
+		fetches[0] = DynTexFetch();
+		fetches[0].base_URL = base + "/a.png";
+		fetches[0].prev_state = state;
+		doFetches(fetches, task_manager, MAX_CONCURRENT_FETCHES_PER_HOST);
+		testAssert(fetches[0].result == DynTexFetch::Result_NewContent);
+		testAssert(std::string(fetches[0].data.begin(), fetches[0].data.end()) == "image data 2");
+		testAssert(fetches[0].content_hash != state.content_hash);
+	}
+
+	//------------------------------- Test a missing file -------------------------------
+	{
+		std::vector<DynTexFetch> fetches(1);
+		fetches[0].base_URL = base + "/missing.png";
+		doFetches(fetches, task_manager, MAX_CONCURRENT_FETCHES_PER_HOST);
+		testAssert(fetches[0].result == DynTexFetch::Result_Failed);
+	}
+
+	//------------------------------- Test per-host concurrency limit -------------------------------
+	{
+		const int N = 8;
+		std::vector<DynTexFetch> fetches(N);
+		for(int i=0; i<N; ++i)
+		{
+			test_server.setFile("/img" + toString(i) + ".png", "image " + toString(i), "image/png");
+			fetches[i].base_URL = base + "/img" + toString(i) + ".png";
+		}
+
+		test_server.setResponseDelay(0.1);
+
+		Timer timer;
+		doFetches(fetches, task_manager, /*max_concurrent_fetches_per_host=*/2);
+		conPrint("Fetching " + toString(N) + " URLs with 0.1 s response delay took " + timer.elapsedStringNSigFigs(3));
+
+		test_server.setResponseDelay(0);
+
+		for(int i=0; i<N; ++i)
+		{
+			testAssert(fetches[i].result == DynTexFetch::Result_NewContent);
+			testAssert(std::string(fetches[i].data.begin(), fetches[i].data.end()) == "image " + toString(i));
+		}
+
+		testAssert(test_server.getMaxNumConcurrentRequests() <= 2);
+	}
+
+	conPrint("DynamicTextureUpdaterThread::test() done.");
+}
+
+
+#endif // BUILD_TESTS
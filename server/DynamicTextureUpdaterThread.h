@@ -7,9 +7,48 @@ Copyright Glare Technologies Limited 2023 -
 
 
 #include "../shared/UID.h"
+#include "../shared/URLString.h"
 #include <MessageableThread.h>
+#include <map>
+#include <vector>
 class Server;
 class ServerAllWorldsState;
+namespace glare { class TaskManager; }
+
+
+// Info about a dynamic-texture source URL, from the last successful fetch.
+struct DynTexURLState
+{
+	DynTexURLState() : content_hash(0) {}
+
+	uint64 content_hash; // Hash of the last downloaded image data.
+	URLString substrata_URL; // Resource URL the last downloaded image was stored under.  Empty if there has been no successful fetch.
+	std::string last_fetch_http_date; // Time of last successful fetch, as an HTTP-date.  Sent as If-Modified-Since in the next request.
+};
+
+
+// A fetch of a single dynamic-texture source URL.  Fetches are done concurrently on task manager threads.
+struct DynTexFetch
+{
+	enum Result
+	{
+		Result_Failed,
+		Result_NotModified,			// Server returned 304 Not Modified.
+		Result_ContentUnchanged,	// Server returned the full image, but its hash was the same as last time.
+		Result_NewContent			// Server returned a new image.  data is set.
+	};
+
+	std::string base_URL;
+	DynTexURLState prev_state;
+
+	// Results:
+	Result result;
+	std::vector<uint8> data;
+	std::string mime_type;
+	uint64 content_hash;
+	std::string fetch_http_date;
+	std::string error_msg;
+};
 
 
 /*=====================================================================
@@ -20,6 +59,11 @@ These scripts download an image from a fixed URL periodically,
 and if the image changes, add it as a resource to the substrata server,
 and assign the image to the specified object material.
 
+Fetches are done concurrently on a bounded task manager, with at most MAX_CONCURRENT_FETCHES_PER_HOST
+requests in flight to a single host, so one slow host doesn't hold up the others.
+Requests are conditional (If-Modified-Since), and if the image data hash is unchanged from
+the last fetch, no resource is written and no objects are updated.
+
 Note that this code runs on the server, so we have to be a bit careful with it.
 =====================================================================*/
 class DynamicTextureUpdaterThread : public MessageableThread
@@ -31,7 +75,17 @@ public:
 
 	virtual void doRun();
 
+	// Fetches all URLs in fetches concurrently, and sets the results in each DynTexFetch.
+	static void doFetches(std::vector<DynTexFetch>& fetches, glare::TaskManager& task_manager, size_t max_concurrent_fetches_per_host);
+
+	static void test();
+
+	static const size_t MAX_CONCURRENT_FETCHES = 8;
+	static const size_t MAX_CONCURRENT_FETCHES_PER_HOST = 2;
+
 private:
 	Server* server;
 	ServerAllWorldsState* world_state;
+
+	std::map<std::string, DynTexURLState> url_states; // Map from source URL to info from last successful fetch.
 };
@@ -9,10 +9,128 @@ Copyright Glare Technologies Limited 2024 -
 #include "LuaHTTPWorkerThread.h"
 #include "Server.h"
 #include "../shared/LuaScriptEvaluator.h"
+#include "../shared/WorldStateLock.h"
+#include <utils/Clock.h>
+#include <utils/StringUtils.h>
+#include <utils/ConPrint.h>
+#include <utils/Lock.h>
+#include <utils/BitUtils.h>
+
+
+LuaHTTPConnectionPool::LuaHTTPConnectionPool()
+:	num_clients_created(0),
+	num_clients_reused(0)
+{
+}
+
+
+LuaHTTPConnectionPool::~LuaHTTPConnectionPool()
+{
+}
+
+
+Reference<HTTPClient> LuaHTTPConnectionPool::getClientForHost(const std::string& host_key, double max_idle_time_s, bool& reused_out)
+{
+	{
+		Lock lock(mutex);
+
+		auto res = idle_clients.find(host_key);
+		if(res != idle_clients.end() && !res->second.empty() && (Clock::getTimeSinceInit() - res->second.back().last_used_time) <= max_idle_time_s)
+		{
+			// Take the most recently used client, as its connection is the least likely to have been closed by the remote host.
+			Reference<HTTPClient> client = res->second.back().client;
+			res->second.pop_back();
+			if(res->second.empty())
+				idle_clients.erase(res);
+
+			num_clients_reused++;
+			reused_out = true;
+			return client;
+		}
+	}
+
+	reused_out = false;
+	return createClient();
+}
+
+
+Reference<HTTPClient> LuaHTTPConnectionPool::createClient()
+{
+	Reference<HTTPClient> client = new HTTPClient();
+	client->max_data_size = 1 << 24; // 16 MB
+	client->max_socket_buffer_size = 1 << 16;
+
+	num_clients_created++;
+	return client;
+}
+
+
+void LuaHTTPConnectionPool::returnClient(const std::string& host_key, Reference<HTTPClient> client)
+{
+	Lock lock(mutex);
+
+	std::vector<IdleClient>& clients = idle_clients[host_key];
+	if(clients.size() >= MAX_IDLE_CLIENTS_PER_HOST)
+		clients.erase(clients.begin()); // Close the least recently used client.
+
+	IdleClient idle_client;
+	idle_client.client = client;
+	idle_client.last_used_time = Clock::getTimeSinceInit();
+	clients.push_back(idle_client);
+}
+
+
+void LuaHTTPConnectionPool::removeStaleClients()
+{
+	const double cur_time = Clock::getTimeSinceInit();
+
+	Lock lock(mutex);
+
+	for(auto it = idle_clients.begin(); it != idle_clients.end(); )
+	{
+		std::vector<IdleClient>& clients = it->second;
+
+		// Clients are in order of increasing last_used_time.
+		size_t num_stale = 0;
+		while(num_stale < clients.size() && (cur_time - clients[num_stale].last_used_time) > MAX_IDLE_TIME_S)
+			num_stale++;
+		clients.erase(clients.begin(), clients.begin() + num_stale);
+
+		if(clients.empty())
+			it = idle_clients.erase(it);
+		else
+			++it;
+	}
+}
+
+
+size_t LuaHTTPConnectionPool::getNumIdleClients()
+{
+	Lock lock(mutex);
+
+	size_t num = 0;
+	for(auto it = idle_clients.begin(); it != idle_clients.end(); ++it)
+		num += it->second.size();
+	return num;
+}
+
+
+//======================================================================================================
+
+
+static const size_t MAX_RESPONSE_CACHE_SIZE_B = 1 << 24; // 16 MB
+static const double CACHE_CLEANUP_PERIOD_S = 10.0;
 
 
 LuaHTTPRequestManager::LuaHTTPRequestManager(Server* server_)
-:	server(server_)
+:	server(server_),
+	num_cache_hits(0),
+	num_coalesced_requests(0),
+	num_results_processed(0),
+	max_num_in_flight_for_a_user(0),
+	response_cache_size_B(0),
+	max_response_cache_size_B(MAX_RESPONSE_CACHE_SIZE_B),
+	last_cache_cleanup_time(0)
 {
 	if(!server->config.do_lua_http_request_rate_limiting)
 		conPrint("Lua HTTP request rate limiting is disabled.");
@@ -34,36 +152,258 @@ LuaHTTPRequestManager::~LuaHTTPRequestManager()
 }
 
 
-void LuaHTTPRequestManager::think()
+std::string LuaHTTPRequestManager::getHostKeyForURL(const std::string& URL)
 {
-	Lock lock(result_queue.getMutex());
-	
-	while(result_queue.unlockedNonEmpty())
+	const size_t scheme_end = URL.find("://");
+	const std::string scheme = (scheme_end == std::string::npos) ? std::string("http") : toLowerCase(URL.substr(0, scheme_end));
+	const size_t host_start = (scheme_end == std::string::npos) ? 0 : (scheme_end + 3);
+
+	size_t host_end = host_start;
+	while(host_end < URL.size() && URL[host_end] != '/' && URL[host_end] != ':' && URL[host_end] != '?')
+		host_end++;
+
+	std::string port = (scheme == "https") ? "443" : "80";
+	if(host_end < URL.size() && URL[host_end] == ':')
 	{
-		Reference<LuaHTTPRequestResult> result = result_queue.unlockedDequeue();
+		size_t port_end = host_end + 1;
+		while(port_end < URL.size() && URL[port_end] != '/' && URL[port_end] != '?')
+			port_end++;
+		port = URL.substr(host_end + 1, port_end - (host_end + 1));
+	}
 
-		Reference<LuaHTTPRequest> request = result->request;
+	return scheme + "://" + toLowerCase(URL.substr(host_start, host_end - host_start)) + ":" + port;
+}
 
-		Reference<LuaScriptEvaluator> script_evaluator = request->lua_script_evaluator.upgradeToStrongRef();
-		if(script_evaluator)
-		{
-			WorldStateLock world_state_lock(server->world_state->mutex);
 
-			if(!result->exception_msg.empty())
+std::string LuaHTTPRequestManager::makeResponseCacheKey(const LuaHTTPRequest& request)
+{
+	// Responses are only shared between requests made by the same user, as they may be for authenticated or per-user endpoints.
+	// The cache key includes the request headers (apart from Cache-Control), as they may affect the response.
+	std::string cache_key = toString(request.script_user_id.value()) + "\n" + request.URL;
+	for(size_t i=0; i<request.additional_headers.size(); ++i)
+		if(!hasPrefix(toLowerCase(request.additional_headers[i]), "cache-control:"))
+			cache_key += "\n" + request.additional_headers[i];
+	return cache_key;
+}
+
+
+LuaHTTPRequestManager::CacheControl LuaHTTPRequestManager::parseRequestCacheControl(const std::vector<std::string>& headers)
+{
+	CacheControl cache_control;
+	cache_control.no_cache = false;
+	cache_control.no_store = false;
+	cache_control.max_age_s = -1;
+
+	for(size_t i=0; i<headers.size(); ++i)
+	{
+		const size_t colon_pos = headers[i].find(':');
+		if(colon_pos == std::string::npos)
+			continue;
+
+		if(toLowerCase(stripHeadAndTailWhitespace(headers[i].substr(0, colon_pos))) != "cache-control")
+			continue;
+
+		const std::vector<std::string> directives = split(headers[i].substr(colon_pos + 1), ',');
+		for(size_t z=0; z<directives.size(); ++z)
+		{
+			const std::string directive = toLowerCase(stripHeadAndTailWhitespace(directives[z]));
+			if(directive == "no-cache")
+				cache_control.no_cache = true;
+			else if(directive == "no-store")
 			{
-				// Call the script onError function
-				script_evaluator->doOnError(request->onError_ref, 
-					/*error code=*/result->error_code,
-					result->exception_msg, // error description
-					world_state_lock
-				);
+				cache_control.no_cache = true;
+				cache_control.no_store = true;
 			}
-			else
+			else if(hasPrefix(directive, "max-age="))
+			{
+				try
+				{
+					cache_control.max_age_s = (double)myMax(0, stringToInt(directive.substr(8)));
+				}
+				catch(glare::Exception&)
+				{} // Ignore invalid max-age values.
+			}
+		}
+	}
+
+	return cache_control;
+}
+
+
+void LuaHTTPRequestManager::think()
+{
+	// Take the results off the queue first, so we don't hold the queue mutex while running script callbacks, which may make new requests.
+	std::vector<Reference<LuaHTTPRequestResult>> results;
+	{
+		Lock lock(result_queue.getMutex());
+	
+		while(result_queue.unlockedNonEmpty())
+			results.push_back(result_queue.unlockedDequeue());
+	}
+
+	for(size_t i=0; i<results.size(); ++i)
+	{
+		const Reference<LuaHTTPRequest> request = results[i]->request;
+
+		if(request->dispatched)
+		{
+			num_in_flight_per_user[request->script_user_id]--;
+			if(--num_in_flight_per_host[request->host_key] == 0)
+				num_in_flight_per_host.erase(request->host_key);
+
+			if(!request->cache_key.empty())
 			{
-				// Call the script onDone function
-				script_evaluator->doOnDone(request->onDone_ref, result, world_state_lock);
+				auto in_flight_res = in_flight_cacheable_requests.find(request->cache_key);
+				if(in_flight_res != in_flight_cacheable_requests.end() && in_flight_res->second == request)
+					in_flight_cacheable_requests.erase(in_flight_res);
+
+				// Store successful responses in the cache.
+				if(results[i]->exception_msg.empty() && results[i]->response.response_code == 200 && results[i]->data.size() <= max_response_cache_size_B / 4)
+					addToResponseCache(request->cache_key, *results[i]);
 			}
 		}
+
+		// Give the result to any identical requests that were coalesced with this one.
+		for(size_t z=0; z<request->coalesced_requests.size(); ++z)
+		{
+			Reference<LuaHTTPRequestResult> coalesced_result = new LuaHTTPRequestResult();
+			coalesced_result->request = request->coalesced_requests[z];
+			coalesced_result->response = results[i]->response;
+			coalesced_result->data = results[i]->data;
+			coalesced_result->exception_msg = results[i]->exception_msg;
+			coalesced_result->error_code = results[i]->error_code;
+			processResult(coalesced_result);
+		}
+		request->coalesced_requests.clear();
+
+		processResult(results[i]);
+	}
+
+	const double cur_time = Clock::getTimeSinceInit();
+	if(cur_time - last_cache_cleanup_time > CACHE_CLEANUP_PERIOD_S)
+	{
+		removeExpiredCacheEntries(cur_time);
+		connection_pool.removeStaleClients();
+		last_cache_cleanup_time = cur_time;
+	}
+
+	if(!results.empty())
+		dispatchPendingRequests();
+}
+
+
+void LuaHTTPRequestManager::processResult(Reference<LuaHTTPRequestResult> result)
+{
+	num_results_processed++;
+
+	Reference<LuaScriptEvaluator> script_evaluator = result->request->lua_script_evaluator.upgradeToStrongRef();
+	if(script_evaluator)
+	{
+		WorldStateLock world_state_lock(server->world_state->mutex);
+
+		if(!result->exception_msg.empty())
+		{
+			// Call the script onError function
+			script_evaluator->doOnError(result->request->onError_ref, 
+				/*error code=*/result->error_code,
+				result->exception_msg, // error description
+				world_state_lock
+			);
+		}
+		else
+		{
+			// Call the script onDone function
+			script_evaluator->doOnDone(result->request->onDone_ref, result, world_state_lock);
+		}
+	}
+}
+
+
+void LuaHTTPRequestManager::addToResponseCache(const std::string& cache_key, const LuaHTTPRequestResult& result)
+{
+	auto existing = response_cache.find(cache_key);
+	if(existing != response_cache.end())
+		removeFromResponseCache(existing);
+
+	CachedResponse& cached = response_cache[cache_key];
+	cached.response = result.response;
+	cached.data = result.data;
+	cached.fetched_time = Clock::getTimeSinceInit();
+	cached.fetch_order_it = response_cache_fetch_order.insert(response_cache_fetch_order.end(), cache_key);
+	response_cache_size_B += cached.data.size();
+
+	// Evict the oldest entries until the cache is within budget.
+	while(response_cache_size_B > max_response_cache_size_B && !response_cache_fetch_order.empty())
+		removeFromResponseCache(response_cache.find(response_cache_fetch_order.front()));
+}
+
+
+void LuaHTTPRequestManager::removeFromResponseCache(std::map<std::string, CachedResponse>::iterator it)
+{
+	assert(it != response_cache.end());
+	response_cache_size_B -= it->second.data.size();
+	response_cache_fetch_order.erase(it->second.fetch_order_it);
+	response_cache.erase(it);
+}
+
+
+void LuaHTTPRequestManager::removeExpiredCacheEntries(double cur_time)
+{
+	const double max_age_s = server->config.lua_http_response_cache_max_age_s;
+
+	// Entries are in order of increasing fetched_time, so stop at the first entry that hasn't expired.
+	while(!response_cache_fetch_order.empty())
+	{
+		auto it = response_cache.find(response_cache_fetch_order.front());
+		if(cur_time - it->second.fetched_time > max_age_s)
+			removeFromResponseCache(it);
+		else
+			break;
+	}
+}
+
+
+// Send pending requests to the worker threads, while the number of in-flight requests is below the per-user and per-host limits.
+// Requests that can't be sent yet keep their place in the queue.
+void LuaHTTPRequestManager::dispatchPendingRequests()
+{
+	const int max_per_user = myMax(1, server->config.lua_http_max_concurrent_requests_per_user);
+	const int max_per_host = myMax(1, server->config.lua_http_max_concurrent_requests_per_host);
+
+	for(auto it = pending_requests.begin(); it != pending_requests.end(); )
+	{
+		Reference<LuaHTTPRequest> request = *it;
+
+		int& num_for_user = num_in_flight_per_user[request->script_user_id];
+		int& num_for_host = num_in_flight_per_host[request->host_key];
+		if(num_for_user < max_per_user && num_for_host < max_per_host)
+		{
+			num_for_user++;
+			num_for_host++;
+			max_num_in_flight_for_a_user = myMax(max_num_in_flight_for_a_user, num_for_user);
+
+			request->dispatched = true;
+			request_queue.enqueue(request);
+			it = pending_requests.erase(it);
+		}
+		else
+			++it;
+	}
+
+	// Remove zero counts so the maps don't grow without bound.
+	for(auto it = num_in_flight_per_user.begin(); it != num_in_flight_per_user.end(); )
+	{
+		if(it->second == 0)
+			it = num_in_flight_per_user.erase(it);
+		else
+			++it;
+	}
+	for(auto it = num_in_flight_per_host.begin(); it != num_in_flight_per_host.end(); )
+	{
+		if(it->second == 0)
+			it = num_in_flight_per_host.erase(it);
+		else
+			++it;
 	}
 }
 
@@ -78,6 +418,7 @@ void LuaHTTPRequestManager::enqueueHTTPRequest(Reference<LuaHTTPRequest> request
 
 	if(http_requests_enabled)
 	{
+		// Do the rate limiting check first, so that requests served from the cache, or coalesced with an in-flight request, count against the limit as well.
 		bool can_enqueue_request;
 		if(server->config.do_lua_http_request_rate_limiting)
 		{
@@ -97,18 +438,68 @@ void LuaHTTPRequestManager::enqueueHTTPRequest(Reference<LuaHTTPRequest> request
 		else // Else if rate limiting disabled:
 			can_enqueue_request = true;
 
-		if(can_enqueue_request)
-		{
-			request_queue.enqueue(request);
-		}
-		else
+		if(!can_enqueue_request)
 		{
 			Reference<LuaHTTPRequestResult> result = new LuaHTTPRequestResult();
 			result->request = request;
 			result->error_code = LuaHTTPRequestResult::ErrorCode_RateLimited;
 			result->exception_msg = "Rate limited: too many HTTP requests in too short a period of time.";
 			result_queue.enqueue(result);
+			return;
 		}
+
+		request->host_key = getHostKeyForURL(request->URL);
+		request->dispatched = false;
+		request->cache_key.clear();
+
+		if(request->request_type == "GET")
+		{
+			const CacheControl cache_control = parseRequestCacheControl(request->additional_headers);
+
+			const std::string cache_key = makeResponseCacheKey(*request);
+
+			// See if we have a fresh enough cached response.
+			if(!cache_control.no_cache)
+			{
+				double max_age_s = server->config.lua_http_response_cache_max_age_s;
+				if(cache_control.max_age_s >= 0)
+					max_age_s = myMin(max_age_s, cache_control.max_age_s);
+
+				auto res = response_cache.find(cache_key);
+				if(res != response_cache.end() && (Clock::getTimeSinceInit() - res->second.fetched_time) <= max_age_s)
+				{
+					// The result is delivered in think(), not here, as we may be in the middle of executing the script.
+					Reference<LuaHTTPRequestResult> result = new LuaHTTPRequestResult();
+					result->request = request;
+					result->response = res->second.response;
+					result->data = res->second.data;
+					result_queue.enqueue(result);
+					num_cache_hits++;
+					return;
+				}
+
+				// If an identical request is already in flight, just wait for its result.
+				auto in_flight_res = in_flight_cacheable_requests.find(cache_key);
+				if(in_flight_res != in_flight_cacheable_requests.end())
+				{
+					in_flight_res->second->coalesced_requests.push_back(request);
+					num_coalesced_requests++;
+					return;
+				}
+			}
+
+			if(!cache_control.no_store && server->config.lua_http_response_cache_max_age_s > 0)
+				request->cache_key = cache_key;
+		}
+
+		if(!request->cache_key.empty())
+		{
+			// A no-cache request may replace an existing in-flight request for the same key.  The existing request still gets its result, it just won't have any more requests coalesced with it.
+			in_flight_cacheable_requests[request->cache_key] = request;
+		}
+
+		pending_requests.push_back(request);
+		dispatchPendingRequests();
 	}
 	else
 	{
@@ -121,3 +512,227 @@ void LuaHTTPRequestManager::enqueueResult(Reference<LuaHTTPRequestResult> result
 {
 	result_queue.enqueue(result);
 }
+
+
+#if BUILD_TESTS
+
+
+#include "TestHTTPServer.h"
+#include <utils/TestUtils.h>
+#include <utils/PlatformUtils.h>
+
+
+static Reference<LuaHTTPRequest> makeTestGETRequest(const std::string& URL, UserID user_id, const std::vector<std::string>& headers = std::vector<std::string>())
+{
+	Reference<LuaHTTPRequest> request = new LuaHTTPRequest();
+	request->script_user_id = user_id;
+	request->request_type = "GET";
+	request->URL = URL;
+	request->additional_headers = headers;
+	request->onDone_ref = 0;
+	request->onError_ref = 0;
+	return request;
+}
+
+
+// Call think() until the given number of results have been processed.
+static void waitForResults(LuaHTTPRequestManager& manager, uint64 target_num_results_processed)
+{
+	for(int i=0; i<1000; ++i)
+	{
+		manager.think();
+		if(manager.num_results_processed >= target_num_results_processed)
+			return;
+		PlatformUtils::Sleep(10);
+	}
+	failTest("Timed out waiting for HTTP results");
+}
+
+
+void LuaHTTPRequestManager::test()
+{
+	conPrint("LuaHTTPRequestManager::test()");
+
+	testAssert(getHostKeyForURL("https://Example.com/a/b?c=d") == "https://example.com:443");
+	testAssert(getHostKeyForURL("http://example.com:8080/a") == "http://example.com:8080");
+	testAssert(getHostKeyForURL("http://example.com") == "http://example.com:80");
+
+	{
+		CacheControl c = parseRequestCacheControl({ "User-Agent: test", "cache-control: No-Cache, max-age=20" });
+		testAssert(c.no_cache && !c.no_store && c.max_age_s == 20);
+		c = parseRequestCacheControl({ "Cache-Control: no-store" });
+		testAssert(c.no_cache && c.no_store && c.max_age_s == -1);
+		c = parseRequestCacheControl({ "Cache-Control: max-age=abc" });
+		testAssert(!c.no_cache && !c.no_store && c.max_age_s == -1);
+	}
+
+	try
+	{
+		Server server;
+		BitUtils::setBit(server.world_state->feature_flag_info.feature_flags, ServerAllWorldsState::LUA_HTTP_REQUESTS_FEATURE_FLAG);
+		server.config.do_lua_http_request_rate_limiting = false;
+		server.config.lua_http_max_concurrent_requests_per_user = 2;
+		server.config.lua_http_max_concurrent_requests_per_host = 3;
+		server.config.lua_http_response_cache_max_age_s = 60;
+
+		TestHTTPServer test_server(/*port=*/39472);
+		const std::string base = test_server.getBaseURL();
+		test_server.setResponseDelay(0.05);
+		for(int i=0; i<8; ++i)
+			test_server.setFile("/file" + toString(i), "data " + toString(i), "text/plain");
+
+		Reference<LuaHTTPRequestManager> manager = new LuaHTTPRequestManager(&server);
+		uint64 num_requests_made = 0;
+
+		//------------------------------- Test the per-user concurrency limit and connection reuse -------------------------------
+		{
+			for(int i=0; i<6; ++i)
+				manager->enqueueHTTPRequest(makeTestGETRequest(base + "/file" + toString(i), UserID(1)));
+			num_requests_made += 6;
+			waitForResults(*manager, num_requests_made);
+
+			testAssert(manager->max_num_in_flight_for_a_user <= 2);
+			testAssert(test_server.getMaxNumConcurrentRequests() <= 2);
+			for(int i=0; i<6; ++i)
+				testAssert(test_server.getNumRequests("/file" + toString(i)) == 1);
+
+			// Only a couple of requests are in flight at once, and a client is returned to the pool before its result is processed, so most requests should reuse a client.
+			testAssert(manager->connection_pool.num_clients_created <= 2);
+			testAssert(manager->connection_pool.num_clients_reused >= 4);
+			testAssert(manager->connection_pool.getNumIdleClients() >= 1);
+		}
+
+		//------------------------------- Test the response cache -------------------------------
+		{
+			auto res = manager->response_cache.find(makeResponseCacheKey(*makeTestGETRequest(base + "/file0", UserID(1))));
+			testAssert(res != manager->response_cache.end());
+			testAssert(std::string(res->second.data.begin(), res->second.data.end()) == "data 0");
+
+			// Should be served from the cache, without a request to the server.
+			manager->enqueueHTTPRequest(makeTestGETRequest(base + "/file0", UserID(1)));
+			num_requests_made++;
+			waitForResults(*manager, num_requests_made);
+			testAssert(manager->num_cache_hits == 1);
+			testAssert(test_server.getNumRequests("/file0") == 1);
+
+			// no-cache should bypass the cache.
+			manager->enqueueHTTPRequest(makeTestGETRequest(base + "/file0", UserID(1), { "Cache-Control: no-cache" }));
+			num_requests_made++;
+			waitForResults(*manager, num_requests_made);
+			testAssert(manager->num_cache_hits == 1);
+			testAssert(test_server.getNumRequests("/file0") == 2);
+
+			// max-age=0 should bypass the cache as well.
+			PlatformUtils::Sleep(10);
+			manager->enqueueHTTPRequest(makeTestGETRequest(base + "/file1", UserID(1), { "Cache-Control: max-age=0" }));
+			num_requests_made++;
+			waitForResults(*manager, num_requests_made);
+			testAssert(test_server.getNumRequests("/file1") == 2);
+
+			// no-store responses should not be cached.
+			manager->enqueueHTTPRequest(makeTestGETRequest(base + "/file6", UserID(1), { "Cache-Control: no-store" }));
+			num_requests_made++;
+			waitForResults(*manager, num_requests_made);
+			testAssert(manager->response_cache.count(makeResponseCacheKey(*makeTestGETRequest(base + "/file6", UserID(1)))) == 0);
+
+			// Another user's request should not be served from the cache.
+			testAssert(makeResponseCacheKey(*makeTestGETRequest(base + "/file0", UserID(1))) != makeResponseCacheKey(*makeTestGETRequest(base + "/file0", UserID(2))));
+			manager->enqueueHTTPRequest(makeTestGETRequest(base + "/file0", UserID(2)));
+			num_requests_made++;
+			waitForResults(*manager, num_requests_made);
+			testAssert(manager->num_cache_hits == 1);
+			testAssert(test_server.getNumRequests("/file0") == 3);
+		}
+
+		//------------------------------- Test coalescing of identical in-flight requests -------------------------------
+		{
+			manager->enqueueHTTPRequest(makeTestGETRequest(base + "/file7", UserID(2)));
+			manager->enqueueHTTPRequest(makeTestGETRequest(base + "/file7", UserID(2)));
+			num_requests_made += 2;
+			waitForResults(*manager, num_requests_made);
+			testAssert(manager->num_coalesced_requests == 1);
+			testAssert(test_server.getNumRequests("/file7") == 1);
+
+			// Requests from different users should not be coalesced.
+			manager->enqueueHTTPRequest(makeTestGETRequest(base + "/file7", UserID(3), { "Cache-Control: no-cache" }));
+			manager->enqueueHTTPRequest(makeTestGETRequest(base + "/file7", UserID(4), { "Cache-Control: no-cache" }));
+			num_requests_made += 2;
+			waitForResults(*manager, num_requests_made);
+			testAssert(manager->num_coalesced_requests == 1);
+			testAssert(test_server.getNumRequests("/file7") == 3);
+		}
+
+		//------------------------------- Test the per-host concurrency limit -------------------------------
+		{
+			for(int i=0; i<8; ++i)
+				manager->enqueueHTTPRequest(makeTestGETRequest(base + "/file" + toString(i), UserID(100 + i), { "Cache-Control: no-cache" }));
+			num_requests_made += 8;
+			waitForResults(*manager, num_requests_made);
+			testAssert(test_server.getMaxNumConcurrentRequests() <= 3);
+			testAssert(manager->pending_requests.empty());
+			testAssert(manager->num_in_flight_per_host.empty());
+			testAssert(manager->num_in_flight_per_user.empty());
+		}
+
+		//------------------------------- Test the response cache size limit -------------------------------
+		{
+			// Each response is 6 bytes ("data N"), so the cache has room for 4 responses.
+			manager->max_response_cache_size_B = 24;
+			manager->removeExpiredCacheEntries(/*cur_time=*/1.0e20); // Empty the cache.
+			testAssert(manager->response_cache.empty() && manager->response_cache_size_B == 0);
+
+			for(int i=0; i<8; ++i)
+			{
+				manager->enqueueHTTPRequest(makeTestGETRequest(base + "/file" + toString(i), UserID(1)));
+				num_requests_made++;
+				waitForResults(*manager, num_requests_made);
+				testAssert(manager->response_cache_size_B <= manager->max_response_cache_size_B);
+			}
+
+			// The oldest responses should have been evicted.
+			testAssert(manager->response_cache.size() == 4);
+			testAssert(manager->response_cache_fetch_order.size() == 4);
+			testAssert(manager->response_cache.count(makeResponseCacheKey(*makeTestGETRequest(base + "/file3", UserID(1)))) == 0);
+			for(int i=4; i<8; ++i)
+				testAssert(manager->response_cache.count(makeResponseCacheKey(*makeTestGETRequest(base + "/file" + toString(i), UserID(1)))) == 1);
+
+			manager->max_response_cache_size_B = MAX_RESPONSE_CACHE_SIZE_B;
+		}
+
+		//------------------------------- Test that cached responses count against the rate limit -------------------------------
+		{
+			server.config.do_lua_http_request_rate_limiting = true;
+			const uint64 initial_num_cache_hits = manager->num_cache_hits;
+
+			// The rate limiter allows 10 requests per user in the period.  The first request is made to the server, the next 9 should be served from the cache, and the rest rate limited.
+			for(int i=0; i<12; ++i)
+			{
+				manager->enqueueHTTPRequest(makeTestGETRequest(base + "/file5", UserID(50)));
+				num_requests_made++;
+				waitForResults(*manager, num_requests_made);
+			}
+			testAssert(manager->num_cache_hits == initial_num_cache_hits + 9);
+
+			server.config.do_lua_http_request_rate_limiting = false;
+		}
+
+		//------------------------------- Test failed requests -------------------------------
+		{
+			manager->enqueueHTTPRequest(makeTestGETRequest("http://localhost:1/nothing_listening_here", UserID(1)));
+			num_requests_made++;
+			waitForResults(*manager, num_requests_made);
+			testAssert(manager->in_flight_cacheable_requests.empty());
+		}
+
+		manager = nullptr;
+	}
+	catch(glare::Exception& e)
+	{
+		failTest(e.what());
+	}
+
+	conPrint("LuaHTTPRequestManager::test() done.");
+}
+
+
+#endif // BUILD_TESTS
@@ -13,8 +13,13 @@ Copyright Glare Technologies Limited 2024 -
 #include <utils/Reference.h>
 #include <utils/ThreadManager.h>
 #include <utils/WeakReference.h>
+#include <utils/Mutex.h>
+#include <utils/AtomicInt.h>
 #include <vector>
 #include <string>
+#include <map>
+#include <deque>
+#include <list>
 #include <unordered_map>
 
 
@@ -25,6 +30,8 @@ class Server;
 class LuaHTTPRequest : public ThreadSafeRefCounted
 {
 public:
+	LuaHTTPRequest() : dispatched(false) {}
+
 	UserID script_user_id;
 
 	std::string request_type; // GET or POST
@@ -36,6 +43,12 @@ public:
 	WeakReference<LuaScriptEvaluator> lua_script_evaluator;
 	int onDone_ref;
 	int onError_ref;
+
+	// Set by LuaHTTPRequestManager
+	std::string host_key; // e.g. "https://example.com:443".  Requests with the same host key can share connections.
+	std::string cache_key; // Empty if the request is not cacheable.
+	bool dispatched; // True if the request was sent to a worker thread, and so counts towards the concurrent request limits.
+	std::vector<Reference<LuaHTTPRequest>> coalesced_requests; // Identical GET requests made while this request was in flight.  They get the same result.
 };
 
 
@@ -60,9 +73,70 @@ public:
 };
 
 
+/*=====================================================================
+LuaHTTPConnectionPool
+---------------------
+Pool of idle HTTPClients, keyed by host.
+An HTTPClient keeps its connection open after a request, so reusing a
+client for the same host avoids the DNS lookup and TCP + TLS handshakes.
+Thread-safe.
+=====================================================================*/
+class LuaHTTPConnectionPool
+{
+public:
+	LuaHTTPConnectionPool();
+	~LuaHTTPConnectionPool();
+
+	// Returns an idle client for the host if there is one that was last used no more than max_idle_time_s ago, otherwise makes a new client.
+	Reference<HTTPClient> getClientForHost(const std::string& host_key, double max_idle_time_s, bool& reused_out);
+
+	// Make a new client, for when a reused client's connection turned out to be closed.
+	Reference<HTTPClient> createClient();
+
+	// Return the client to the pool after a successful request, so it can be reused.
+	void returnClient(const std::string& host_key, Reference<HTTPClient> client);
+
+	// Close clients that have been idle for more than MAX_IDLE_TIME_S.
+	void removeStaleClients();
+
+	size_t getNumIdleClients();
+
+	static const size_t MAX_IDLE_CLIENTS_PER_HOST = 4;
+	static constexpr double MAX_IDLE_TIME_S = 4.0; // Less than common server keep-alive timeouts (e.g. 5 s), so pooled connections are unlikely to have been closed by the remote host.
+
+	// Requests that can't be safely retried (e.g. POST) only reuse a client that was used very recently, as its connection is very unlikely to have been closed.
+	static constexpr double MAX_IDLE_TIME_NON_IDEMPOTENT_S = 1.0;
+
+	glare::AtomicInt num_clients_created;
+	glare::AtomicInt num_clients_reused;
+private:
+	struct IdleClient
+	{
+		Reference<HTTPClient> client;
+		double last_used_time;
+	};
+
+	Mutex mutex;
+	std::map<std::string, std::vector<IdleClient>> idle_clients GUARDED_BY(mutex);
+};
+
+
 /*=====================================================================
 LuaHTTPRequestManager
 ---------------------
+Requests are made on a pool of LuaHTTPWorkerThreads, using pooled keep-alive connections (see LuaHTTPConnectionPool).
+
+Scheduling, the concurrency limits and the response cache are all handled on the main thread (in enqueueHTTPRequest() and think()):
+Requests wait in pending_requests until the number of in-flight requests for both the script user and the host are below the
+limits in the server config.
+
+Successful GET responses are cached for up to lua_http_response_cache_max_age_s (0 by default, so caching is opt-in), with the oldest 
+responses evicted when the cache is over its size limit.  Cached responses are only returned to requests from the same script user.
+Cache-Control request headers set by the script
+are respected: no-cache and no-store bypass the cache, and max-age limits the age of a cached response that may be returned.
+Cache-Control response headers are not available from HTTPClient, so are not respected.
+An identical GET request from the same user made while another is in flight is coalesced with it, and gets the same result.
+Requests served from the cache or coalesced still count against the per-user rate limit.
 =====================================================================*/
 class LuaHTTPRequestManager : public ThreadSafeRefCounted
 {
@@ -78,11 +152,61 @@ public:
 	// Called from worker threads.
 	void enqueueResult(Reference<LuaHTTPRequestResult> result);
 
+	// Returns e.g. "https://example.com:443" for "https://Example.com/some/path".
+	static std::string getHostKeyForURL(const std::string& URL);
+
+	struct CacheControl
+	{
+		bool no_cache; // no-cache or no-store: don't return a cached response.
+		bool no_store; // Don't store the response in the cache.
+		double max_age_s; // Maximum acceptable age of a cached response, or -1 if not specified.
+	};
+	// Parse Cache-Control directives from request headers, which are in the form "Name: value".
+	static CacheControl parseRequestCacheControl(const std::vector<std::string>& headers);
+
+	// Returns the key for the request in the response cache.  Includes the script user ID, the URL, and the request headers apart from Cache-Control.
+	static std::string makeResponseCacheKey(const LuaHTTPRequest& request);
+
+	static void test();
+
 	ThreadSafeQueue<Reference<LuaHTTPRequest>> request_queue;
+	LuaHTTPConnectionPool connection_pool;
+
+	// Stats, main thread only
+	uint64 num_cache_hits;
+	uint64 num_coalesced_requests;
+	uint64 num_results_processed;
+	int max_num_in_flight_for_a_user; // Max number of in-flight requests for any single user seen so far.
 private:
+	void dispatchPendingRequests();
+	void processResult(Reference<LuaHTTPRequestResult> result);
+	void removeExpiredCacheEntries(double cur_time);
+
 	ThreadManager thread_manager;
 	ThreadSafeQueue<Reference<LuaHTTPRequestResult>> result_queue;
 	Server* server;
 
 	std::unordered_map<UserID, Reference<RateLimiter>, UserIDHasher> rate_limiters;
+
+	// Main thread only:
+	std::deque<Reference<LuaHTTPRequest>> pending_requests; // Requests waiting for the number of in-flight requests to fall below the concurrency limits.
+	std::unordered_map<UserID, int, UserIDHasher> num_in_flight_per_user;
+	std::map<std::string, int> num_in_flight_per_host;
+	std::map<std::string, Reference<LuaHTTPRequest>> in_flight_cacheable_requests; // Map from cache key to in-flight request.
+
+	struct CachedResponse
+	{
+		HTTPClient::ResponseInfo response;
+		std::vector<uint8> data;
+		double fetched_time;
+		std::list<std::string>::iterator fetch_order_it; // Position of the cache key in response_cache_fetch_order.
+	};
+	void addToResponseCache(const std::string& cache_key, const LuaHTTPRequestResult& result);
+	void removeFromResponseCache(std::map<std::string, CachedResponse>::iterator it);
+
+	std::map<std::string, CachedResponse> response_cache;
+	std::list<std::string> response_cache_fetch_order; // Cache keys in order of increasing fetched_time, so the oldest entries can be evicted first.
+	size_t response_cache_size_B;
+	size_t max_response_cache_size_B; // Oldest entries are evicted to keep response_cache_size_B at or below this.
+	double last_cache_cleanup_time;
 };
@@ -24,6 +24,25 @@ LuaHTTPWorkerThread::~LuaHTTPWorkerThread()
 }
 
 
+void LuaHTTPWorkerThread::doRequest(const LuaHTTPRequest& request, LuaHTTPRequestResult& result)
+{
+	result.data.clear();
+
+	http_client->additional_headers = request.additional_headers;
+
+	if(request.request_type == "GET")
+	{
+		result.response = http_client->downloadFile(request.URL, /*data_out=*/result.data);
+	}
+	else if(request.request_type == "POST")
+	{
+		result.response = http_client->sendPost(request.URL, request.post_content, request.content_type, /*data_out=*/result.data);
+	}
+	else
+		runtimeCheckFailed("invalid request type");
+}
+
+
 void LuaHTTPWorkerThread::doRun()
 {
 	PlatformUtils::setCurrentThreadName("LuaHTTPWorkerThread");
@@ -43,20 +62,30 @@ void LuaHTTPWorkerThread::doRun()
 			{
 				conPrint("Doing Lua HTTP Request to '" + request->URL + "'...");
 
-				http_client = new HTTPClient();
-				http_client->max_data_size = 1 << 24; // 16 MB
-				http_client->max_socket_buffer_size = 1 << 16;
+				// A request that fails on a reused connection is only retried if it is idempotent, so non-idempotent requests only reuse very recently used connections.
+				const bool idempotent = request->request_type == "GET";
+				bool reused_client;
+				http_client = manager->connection_pool.getClientForHost(request->host_key,
+					/*max idle time=*/idempotent ? LuaHTTPConnectionPool::MAX_IDLE_TIME_S : LuaHTTPConnectionPool::MAX_IDLE_TIME_NON_IDEMPOTENT_S, reused_client);
 
-				if(request->request_type == "GET")
+				try
 				{
-					result->response = http_client->downloadFile(request->URL, /*data_out=*/result->data);
+					doRequest(*request, *result);
 				}
-				else if(request->request_type == "POST")
+				catch(glare::Exception& e)
 				{
-					result->response = http_client->sendPost(request->URL, request->post_content, request->content_type, /*data_out=*/result->data);
+					// The remote host may have closed the pooled connection while it was idle.  GET requests are idempotent, so retry once on a new connection.
+					if(reused_client && idempotent)
+					{
+						conPrint("Lua HTTP Request on reused connection failed (" + e.what() + "), retrying on new connection...");
+						http_client = manager->connection_pool.createClient();
+						doRequest(*request, *result);
+					}
+					else
+						throw;
 				}
-				else
-					runtimeCheckFailed("invalid request type");
+
+				manager->connection_pool.returnClient(request->host_key, http_client);
 
 				conPrint("Lua HTTP Request to '" + request->URL + "' done.");
 			}
@@ -10,13 +10,16 @@ Copyright Glare Technologies Limited 2024 -
 #include <networking/HTTPClient.h>
 #include <utils/MessageableThread.h>
 class LuaHTTPRequestManager;
+class LuaHTTPRequest;
+class LuaHTTPRequestResult;
 class HTTPClient;
 
 
 /*=====================================================================
 LuaHTTPWorkerThread
 -------------------
-
+Does HTTP requests for Lua scripts, using pooled connections from
+LuaHTTPRequestManager::connection_pool.
 =====================================================================*/
 class LuaHTTPWorkerThread : public MessageableThread
 {
@@ -30,6 +33,8 @@ public:
 	virtual void kill() override;
 
 private:
+	void doRequest(const LuaHTTPRequest& request, LuaHTTPRequestResult& result);
+
 	LuaHTTPRequestManager* manager;
 
 	Reference<HTTPClient> http_client;
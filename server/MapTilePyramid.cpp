@@ -0,0 +1,516 @@
+/*=====================================================================
+MapTilePyramid.cpp
+------------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#include "MapTilePyramid.h"
+
+
+#include "Server.h"
+#include "ServerWorldState.h"
+#include <graphics/jpegdecoder.h>
+#include <maths/SSE.h>
+#include <utils/ConPrint.h>
+#include <utils/Exception.h>
+#include <utils/Lock.h>
+#include <utils/StringUtils.h>
+#include <utils/FileUtils.h>
+#include <utils/CryptoRNG.h>
+#include <cassert>
+#include <cstring>
+#if BUILD_TESTS
+#include <maths/PCG32.h>
+#include <utils/Timer.h>
+#include <utils/TestUtils.h>
+#include <utils/TestExceptionUtils.h>
+#endif
+
+
+namespace MapTilePyramid
+{
+
+
+Vec3<int> getParentTileCoords(const Vec3<int>& tile_coords)
+{
+	// Round towards -infinity, so that e.g. tiles -2 and -1 have parent -1.
+	const int px = (tile_coords.x >= 0) ? (tile_coords.x / 2) : ((tile_coords.x - 1) / 2);
+	const int py = (tile_coords.y >= 0) ? (tile_coords.y / 2) : ((tile_coords.y - 1) / 2);
+	return Vec3<int>(px, py, tile_coords.z - 1);
+}
+
+
+Vec3<int> getChildTileCoords(const Vec3<int>& tile_coords, int i)
+{
+	assert(i >= 0 && i < 4);
+	return Vec3<int>(tile_coords.x * 2 + (i % 2), tile_coords.y * 2 + (i / 2), tile_coords.z + 1);
+}
+
+
+static const int MAX_NUM_CHANNELS = 4;
+static const int MAX_ROW_BYTES = TILE_RES * MAX_NUM_CHANNELS;
+
+
+// Downsamples child by a factor of 2 in each dimension with a 2x2 box filter, writing the result to the TILE_RES/2 x TILE_RES/2 region of parent
+// with top-left pixel (dest_x, dest_y).
+//
+// Each pair of source rows is summed vertically into 16-bit lanes, then each sum is added to the sum N bytes to the right (the horizontally adjacent pixel),
+// giving the rounded 2x2 average for every byte offset.  The averages for even pixels are then copied to the parent.
+static void downsampleIntoQuadrant(const ImageMapUInt8& child, ImageMapUInt8& parent, size_t dest_x, size_t dest_y)
+{
+	const size_t N = child.getN();
+	const size_t row_bytes = TILE_RES * N;
+	static_assert((TILE_RES * 3) % 16 == 0, "row byte size must be a multiple of 16");
+
+	// Padded so that the loads at offset N past the end of the row stay in bounds.  The padding is zeroed and only affects averages that are discarded.
+	uint16 vsum[MAX_ROW_BYTES + 16];
+	uint8 avg[MAX_ROW_BYTES];
+	std::memset(vsum + row_bytes, 0, 16 * sizeof(uint16));
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i two = _mm_set1_epi16(2);
+
+	for(size_t y=0; y<TILE_RES/2; ++y)
+	{
+		const uint8* row_a = child.getPixel(0, y*2);
+		const uint8* row_b = child.getPixel(0, y*2 + 1);
+
+		for(size_t i=0; i<row_bytes; i += 16)
+		{
+			const __m128i a = _mm_loadu_si128((const __m128i*)(row_a + i));
+			const __m128i b = _mm_loadu_si128((const __m128i*)(row_b + i));
+			_mm_storeu_si128((__m128i*)(vsum + i),     _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)));
+			_mm_storeu_si128((__m128i*)(vsum + i + 8), _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)));
+		}
+
+		for(size_t i=0; i<row_bytes; i += 16)
+		{
+			const __m128i s0 = _mm_add_epi16(_mm_loadu_si128((const __m128i*)(vsum + i)),     _mm_loadu_si128((const __m128i*)(vsum + i + N)));
+			const __m128i s1 = _mm_add_epi16(_mm_loadu_si128((const __m128i*)(vsum + i + 8)), _mm_loadu_si128((const __m128i*)(vsum + i + 8 + N)));
+			const __m128i avg0 = _mm_srli_epi16(_mm_add_epi16(s0, two), 2);
+			const __m128i avg1 = _mm_srli_epi16(_mm_add_epi16(s1, two), 2);
+			_mm_storeu_si128((__m128i*)(avg + i), _mm_packus_epi16(avg0, avg1));
+		}
+
+		uint8* dest = parent.getPixel(dest_x, dest_y + y);
+		for(size_t x=0; x<TILE_RES/2; ++x)
+		{
+			dest[x*3 + 0] = avg[x*2*N + 0];
+			dest[x*3 + 1] = avg[x*2*N + 1];
+			dest[x*3 + 2] = avg[x*2*N + 2];
+		}
+	}
+}
+
+
+static void checkTileImageValid(const ImageMapUInt8& tile, const char* description)
+{
+	if(tile.getWidth() != TILE_RES || tile.getHeight() != TILE_RES)
+		throw glare::Exception(std::string(description) + " had invalid size " + toString(tile.getWidth()) + " x " + toString(tile.getHeight()) + ", expected " + toString(TILE_RES) + " x " + toString(TILE_RES));
+	if(tile.getN() < 3 || tile.getN() > MAX_NUM_CHANNELS)
+		throw glare::Exception(std::string(description) + " had invalid number of channels: " + toString(tile.getN()));
+}
+
+
+ImageMapUInt8Ref buildParentTile(const ImageMapUInt8* children[4], const ImageMapUInt8* prev_parent)
+{
+	if(prev_parent)
+		checkTileImageValid(*prev_parent, "Previous parent tile");
+
+	ImageMapUInt8Ref parent = new ImageMapUInt8(TILE_RES, TILE_RES, 3);
+	parent->zero();
+
+	for(int i=0; i<4; ++i)
+	{
+		// Children with y offset 1 are in the top half of the image.  See diagram in MapTilePyramid.h.
+		const size_t dest_x = (i % 2) * (TILE_RES/2);
+		const size_t dest_y = (i / 2 == 1) ? 0 : (TILE_RES/2);
+
+		const ImageMapUInt8* child = children[i];
+		if(child)
+		{
+			checkTileImageValid(*child, "Child tile");
+			downsampleIntoQuadrant(*child, *parent, dest_x, dest_y);
+		}
+		else if(prev_parent) // Else keep the quadrant of the previous tile image:
+		{
+			const size_t prev_N = prev_parent->getN();
+			for(size_t y=0; y<TILE_RES/2; ++y)
+			{
+				const uint8* src = prev_parent->getPixel(dest_x, dest_y + y);
+				uint8* dest = parent->getPixel(dest_x, dest_y + y);
+				for(size_t x=0; x<TILE_RES/2; ++x)
+				{
+					dest[x*3 + 0] = src[x*prev_N + 0];
+					dest[x*3 + 1] = src[x*prev_N + 1];
+					dest[x*3 + 2] = src[x*prev_N + 2];
+				}
+			}
+		}
+	}
+
+	return parent;
+}
+
+
+static ImageMapUInt8Ref loadTile(const std::string& path)
+{
+	std::vector<uint8> data;
+	FileUtils::readEntireFile(path, data);
+
+	Map2DRef map = JPEGDecoder::decodeFromBuffer(data.data(), data.size(), /*indigo base dir=*/".");
+	if(!map.isType<ImageMapUInt8>())
+		throw glare::Exception("Decoded tile was not ImageMapUInt8: " + path);
+	return map.downcast<ImageMapUInt8>();
+}
+
+
+struct TileToBuild
+{
+	Vec3<int> coords;
+	ScreenshotRef screenshot;
+	std::string child_paths[4]; // Local path of each child tile, in getChildTileCoords() order.  Empty if the child tile doesn't exist.
+	std::string prev_tile_path; // Local path of the current image of the tile, if there is one and some child tile doesn't exist, so the quadrant for the missing child can be kept.
+};
+
+
+size_t buildDirtyTiles(Server* server, ServerAllWorldsState* world_state)
+{
+	size_t num_built = 0;
+
+	// Build from the finest coarse level to the coarsest, so that a change at MAX_TILE_Z propagates all the way to zoom level 0 in one call.
+	for(int z = MAX_TILE_Z - 1; z >= 0; --z)
+	{
+		std::vector<TileToBuild> tiles_to_build;
+
+		{ // Lock scope
+			Lock lock(world_state->mutex);
+
+			MapTileInfo& map_tile_info = world_state->map_tile_info;
+			for(auto it = map_tile_info.info.begin(); it != map_tile_info.info.end(); ++it)
+			{
+				const Vec3<int>& coords = it->first;
+				const ScreenshotRef& screenshot = it->second.cur_tile_screenshot;
+				if(coords.z != z || screenshot.isNull())
+					continue;
+
+				if(screenshot->state == Screenshot::ScreenshotState_done && (map_tile_info.pyramid_dirty_tiles.count(coords) == 0))
+					continue; // Tile is up to date.
+
+				TileToBuild tile;
+				tile.coords = coords;
+				tile.screenshot = screenshot;
+				bool children_done = true;
+				bool have_child = false;
+				for(int i=0; i<4; ++i)
+				{
+					auto res = map_tile_info.info.find(getChildTileCoords(coords, i));
+					if(res != map_tile_info.info.end() && res->second.cur_tile_screenshot.nonNull())
+					{
+						const Screenshot* child = res->second.cur_tile_screenshot.ptr();
+						if(child->state != Screenshot::ScreenshotState_done || child->local_path.empty())
+						{
+							children_done = false; // Wait until the child has been rendered or built.
+							break;
+						}
+						tile.child_paths[i] = child->local_path;
+						have_child = true;
+					}
+				}
+
+				if(children_done && have_child)
+				{
+					const bool missing_child = tile.child_paths[0].empty() || tile.child_paths[1].empty() || tile.child_paths[2].empty() || tile.child_paths[3].empty();
+					if(missing_child && screenshot->state == Screenshot::ScreenshotState_done && !screenshot->local_path.empty())
+						tile.prev_tile_path = screenshot->local_path;
+
+					tiles_to_build.push_back(tile);
+					map_tile_info.pyramid_dirty_tiles.erase(coords);
+					map_tile_info.db_dirty = true; // pyramid_dirty_tiles is saved with the map tile info.
+				}
+			}
+		} // End lock scope
+
+		for(size_t t=0; t<tiles_to_build.size(); ++t)
+		{
+			const TileToBuild& tile = tiles_to_build[t];
+			try
+			{
+				ImageMapUInt8Ref child_maps[4];
+				const ImageMapUInt8* children[4];
+				for(int i=0; i<4; ++i)
+				{
+					if(!tile.child_paths[i].empty())
+						child_maps[i] = loadTile(tile.child_paths[i]);
+					children[i] = child_maps[i].ptr();
+				}
+
+				ImageMapUInt8Ref prev_parent;
+				if(!tile.prev_tile_path.empty())
+				{
+					try
+					{
+						prev_parent = loadTile(tile.prev_tile_path);
+						checkTileImageValid(*prev_parent, "Previous tile");
+					}
+					catch(glare::Exception& e)
+					{
+						conPrint("MapTilePyramid: Failed to load previous image of tile " + tile.coords.toString() + ", missing children will be black: " + e.what());
+						prev_parent = NULL;
+					}
+				}
+
+				ImageMapUInt8Ref parent = buildParentTile(children, prev_parent.ptr());
+
+				// Save with a random path, like the screenshot bot tiles in WorkerThread, so the new tile gets a new resource URL.
+				const int NUM_BYTES = 16;
+				uint8 pathdata[NUM_BYTES];
+				CryptoRNG::getRandomBytes(pathdata, NUM_BYTES);
+				const std::string tile_filename = "screenshot_" + StringUtils::convertByteArrayToHexString(pathdata, NUM_BYTES) + ".jpg";
+				const std::string tile_path = server->screenshot_dir + "/" + tile_filename;
+
+				JPEGDecoder::save(parent, tile_path, JPEGDecoder::SaveOptions(/*quality=*/95));
+
+				// Add map tile as a resource too, for access by embedded minimap on client.
+				const URLString URL = toURLString(tile_filename);
+				ResourceRef resource = world_state->resource_manager->getOrCreateResourceForURL(URL);
+				const std::string local_abs_path = world_state->resource_manager->getLocalAbsPathForResource(*resource);
+
+				FileUtils::copyFile(tile_path, local_abs_path);
+
+				resource->owner_id = UserID::invalidUserID();
+				resource->setState(Resource::State_Present);
+
+				{
+					Lock lock(world_state->mutex);
+
+					world_state->addResourceAsDBDirty(resource);
+
+					tile.screenshot->URL = URL;
+					tile.screenshot->state = Screenshot::ScreenshotState_done;
+					tile.screenshot->local_path = tile_path;
+					world_state->addScreenshotAsDBDirty(tile.screenshot);
+					world_state->map_tile_info.db_dirty = true;
+
+					if(z > 0)
+						world_state->map_tile_info.pyramid_dirty_tiles.insert(getParentTileCoords(tile.coords));
+				}
+
+				num_built++;
+			}
+			catch(glare::Exception& e)
+			{
+				conPrint("MapTilePyramid: Failed to build tile " + tile.coords.toString() + ": " + e.what());
+			}
+		}
+	}
+
+	return num_built;
+}
+
+
+#if BUILD_TESTS
+
+
+// Straightforward scalar version of buildParentTile(), for checking the SSE version against.
+static ImageMapUInt8Ref refBuildParentTile(const ImageMapUInt8* children[4])
+{
+	ImageMapUInt8Ref parent = new ImageMapUInt8(TILE_RES, TILE_RES, 3);
+	parent->zero();
+
+	for(int i=0; i<4; ++i)
+	{
+		const ImageMapUInt8* child = children[i];
+		if(!child)
+			continue;
+
+		// Composite into 2*TILE_RES x 2*TILE_RES image coordinates, then filter.
+		const int comp_x0 = (i % 2) * TILE_RES;
+		const int comp_y0 = (i / 2 == 1) ? 0 : TILE_RES;
+
+		for(int y=0; y<TILE_RES/2; ++y)
+		for(int x=0; x<TILE_RES/2; ++x)
+		for(int c=0; c<3; ++c)
+		{
+			const int sum =
+				(int)child->getPixel(x*2,     y*2    )[c] +
+				(int)child->getPixel(x*2 + 1, y*2    )[c] +
+				(int)child->getPixel(x*2,     y*2 + 1)[c] +
+				(int)child->getPixel(x*2 + 1, y*2 + 1)[c];
+
+			parent->getPixel((comp_x0 / 2) + x, (comp_y0 / 2) + y)[c] = (uint8)((sum + 2) / 4);
+		}
+	}
+
+	return parent;
+}
+
+
+static ImageMapUInt8Ref makeRandomTile(PCG32& rng, int N)
+{
+	ImageMapUInt8Ref map = new ImageMapUInt8(TILE_RES, TILE_RES, N);
+	for(size_t i=0; i<map->getDataSize(); ++i)
+		map->getData()[i] = (uint8)(rng.unitRandom() * 255.99f);
+	return map;
+}
+
+
+static ImageMapUInt8Ref makeSolidTile(uint8 r, uint8 g, uint8 b)
+{
+	ImageMapUInt8Ref map = new ImageMapUInt8(TILE_RES, TILE_RES, 3);
+	for(size_t i=0; i<map->getWidth() * map->getHeight(); ++i)
+	{
+		map->getPixel(i)[0] = r;
+		map->getPixel(i)[1] = g;
+		map->getPixel(i)[2] = b;
+	}
+	return map;
+}
+
+
+static void testImagesEqual(const ImageMapUInt8& a, const ImageMapUInt8& b)
+{
+	testAssert(a.getWidth() == b.getWidth() && a.getHeight() == b.getHeight() && a.getN() == b.getN());
+	testAssert(std::memcmp(a.getData(), b.getData(), a.getDataSize()) == 0);
+}
+
+
+void test()
+{
+	conPrint("MapTilePyramid::test()");
+
+	//------------------------ Test tile coordinates ------------------------
+	testAssert(getParentTileCoords(Vec3<int>(0, 0, 6)) == Vec3<int>(0, 0, 5));
+	testAssert(getParentTileCoords(Vec3<int>(1, 1, 6)) == Vec3<int>(0, 0, 5));
+	testAssert(getParentTileCoords(Vec3<int>(5, 2, 6)) == Vec3<int>(2, 1, 5));
+	testAssert(getParentTileCoords(Vec3<int>(-1, -2, 6)) == Vec3<int>(-1, -1, 5));
+	testAssert(getParentTileCoords(Vec3<int>(-3, -4, 6)) == Vec3<int>(-2, -2, 5));
+
+	for(int y=-3; y<=3; ++y)
+	for(int x=-3; x<=3; ++x)
+	for(int i=0; i<4; ++i)
+	{
+		const Vec3<int> parent(x, y, 4);
+		testAssert(getParentTileCoords(getChildTileCoords(parent, i)) == parent);
+	}
+
+	//------------------------ Test child placement ------------------------
+	{
+		ImageMapUInt8Ref bot_left  = makeSolidTile(10, 0, 0);
+		ImageMapUInt8Ref bot_right = makeSolidTile(0, 20, 0);
+		ImageMapUInt8Ref top_left  = makeSolidTile(0, 0, 30);
+		ImageMapUInt8Ref top_right = makeSolidTile(40, 40, 40);
+		const ImageMapUInt8* children[4] = { bot_left.ptr(), bot_right.ptr(), top_left.ptr(), top_right.ptr() };
+		ImageMapUInt8Ref parent = buildParentTile(children);
+
+		// Image row 0 is the top of the tile (max y)
+		testAssert(parent->getPixel(0, 0)[2] == 30);
+		testAssert(parent->getPixel(TILE_RES-1, 0)[0] == 40 && parent->getPixel(TILE_RES-1, 0)[1] == 40);
+		testAssert(parent->getPixel(0, TILE_RES-1)[0] == 10);
+		testAssert(parent->getPixel(TILE_RES-1, TILE_RES-1)[1] == 20);
+		testAssert(parent->getPixel(TILE_RES/2 - 1, TILE_RES/2)[0] == 10);
+		testAssert(parent->getPixel(TILE_RES/2, TILE_RES/2 - 1)[0] == 40);
+	}
+
+	//------------------------ Test missing children are black ------------------------
+	{
+		ImageMapUInt8Ref top_right = makeSolidTile(100, 150, 200);
+		const ImageMapUInt8* children[4] = { NULL, NULL, NULL, top_right.ptr() };
+		ImageMapUInt8Ref parent = buildParentTile(children);
+		testAssert(parent->getPixel(TILE_RES-1, 0)[0] == 100 && parent->getPixel(TILE_RES-1, 0)[1] == 150 && parent->getPixel(TILE_RES-1, 0)[2] == 200);
+		testAssert(parent->getPixel(0, 0)[0] == 0 && parent->getPixel(0, 0)[1] == 0 && parent->getPixel(0, 0)[2] == 0);
+		testAssert(parent->getPixel(TILE_RES-1, TILE_RES-1)[0] == 0);
+	}
+
+	//------------------------ Test missing children keep the quadrant of the previous parent image ------------------------
+	{
+		ImageMapUInt8Ref top_right = makeSolidTile(100, 150, 200);
+		ImageMapUInt8Ref prev_parent = makeSolidTile(7, 8, 9);
+		const ImageMapUInt8* children[4] = { NULL, NULL, NULL, top_right.ptr() };
+		ImageMapUInt8Ref parent = buildParentTile(children, prev_parent.ptr());
+		testAssert(parent->getPixel(TILE_RES-1, 0)[0] == 100 && parent->getPixel(TILE_RES-1, 0)[1] == 150 && parent->getPixel(TILE_RES-1, 0)[2] == 200);
+		testAssert(parent->getPixel(0, 0)[0] == 7 && parent->getPixel(0, 0)[1] == 8 && parent->getPixel(0, 0)[2] == 9);
+		testAssert(parent->getPixel(TILE_RES-1, TILE_RES-1)[0] == 7);
+		testAssert(parent->getPixel(TILE_RES/2 - 1, TILE_RES/2)[2] == 9);
+
+		// The previous parent image should be ignored for children that exist.
+		const ImageMapUInt8* all_children[4] = { top_right.ptr(), top_right.ptr(), top_right.ptr(), top_right.ptr() };
+		testImagesEqual(*buildParentTile(all_children, prev_parent.ptr()), *buildParentTile(all_children));
+
+		ImageMapUInt8Ref small = new ImageMapUInt8(TILE_RES/2, TILE_RES, 3);
+		small->zero();
+		testThrowsExcepContainingString([&]() { buildParentTile(children, small.ptr()); }, "invalid size");
+	}
+
+	//------------------------ Test against scalar reference ------------------------
+	{
+		PCG32 rng(1);
+		for(int N=3; N<=4; ++N)
+		{
+			ImageMapUInt8Ref child_maps[4];
+			const ImageMapUInt8* children[4];
+			for(int i=0; i<4; ++i)
+			{
+				child_maps[i] = makeRandomTile(rng, N);
+				children[i] = child_maps[i].ptr();
+			}
+			testImagesEqual(*buildParentTile(children), *refBuildParentTile(children));
+
+			children[1] = NULL;
+			testImagesEqual(*buildParentTile(children), *refBuildParentTile(children));
+		}
+
+		// Test maximum values don't overflow
+		ImageMapUInt8Ref white = makeSolidTile(255, 255, 255);
+		const ImageMapUInt8* children[4] = { white.ptr(), white.ptr(), white.ptr(), white.ptr() };
+		ImageMapUInt8Ref parent = buildParentTile(children);
+		testAssert(parent->getPixel(17, 33)[0] == 255 && parent->getPixel(TILE_RES-1, TILE_RES-1)[2] == 255);
+	}
+
+	//------------------------ Test invalid children ------------------------
+	{
+		ImageMapUInt8Ref small = new ImageMapUInt8(TILE_RES/2, TILE_RES, 3);
+		small->zero();
+		const ImageMapUInt8* children[4] = { small.ptr(), NULL, NULL, NULL };
+		testThrowsExcepContainingString([&]() { buildParentTile(children); }, "invalid size");
+
+		ImageMapUInt8Ref greyscale = new ImageMapUInt8(TILE_RES, TILE_RES, 1);
+		greyscale->zero();
+		children[0] = greyscale.ptr();
+		testThrowsExcepContainingString([&]() { buildParentTile(children); }, "invalid number of channels");
+	}
+
+	//------------------------ Perf test ------------------------
+	{
+		PCG32 rng(1);
+		ImageMapUInt8Ref child_maps[4];
+		const ImageMapUInt8* children[4];
+		for(int i=0; i<4; ++i)
+		{
+			child_maps[i] = makeRandomTile(rng, 3);
+			children[i] = child_maps[i].ptr();
+		}
+
+		const int NUM_ITERS = 100;
+		size_t sum = 0;
+		Timer timer;
+		for(int i=0; i<NUM_ITERS; ++i)
+			sum += buildParentTile(children)->getPixel(i)[0];
+		const double sse_time = timer.elapsed() / NUM_ITERS;
+
+		timer.reset();
+		for(int i=0; i<NUM_ITERS; ++i)
+			sum += refBuildParentTile(children)->getPixel(i)[0];
+		const double ref_time = timer.elapsed() / NUM_ITERS;
+
+		conPrint("buildParentTile():    " + doubleToStringNSigFigs(sse_time * 1.0e6, 4) + " us");
+		conPrint("refBuildParentTile(): " + doubleToStringNSigFigs(ref_time * 1.0e6, 4) + " us (sum: " + toString(sum) + ")");
+	}
+
+	conPrint("MapTilePyramid::test() done.");
+}
+
+
+#endif // BUILD_TESTS
+
+
+} // end namespace MapTilePyramid
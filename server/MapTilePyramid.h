@@ -0,0 +1,72 @@
+/*=====================================================================
+MapTilePyramid.h
+----------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#pragma once
+
+
+#include <graphics/ImageMap.h>
+#include <maths/vec3.h>
+#include <Platform.h>
+class Server;
+class ServerAllWorldsState;
+
+
+/*=====================================================================
+MapTilePyramid
+--------------
+Builds the coarser zoom levels of the map tile pyramid on the CPU.
+
+Only tiles at the finest zoom level (MAX_TILE_Z) are rendered by the
+screenshot bot.  Each tile at a coarser zoom level z is built from its
+four child tiles at zoom level z+1, by compositing them and downsampling
+with a 2x2 box filter.
+
+Tile (x, y, z) covers the world-space square [x*W, (x+1)*W] x [y*W, (y+1)*W],
+where W = 5120 / 2^z metres.  Tile images have +y at the top, so the children
+of (x, y, z) are placed in the parent image like so:
+
+	-------------------------------------
+	|                 |                 |
+	| (2x, 2y+1, z+1) | (2x+1,2y+1,z+1) |
+	|                 |                 |
+	-------------------------------------
+	|                 |                 |
+	| (2x, 2y, z+1)   | (2x+1, 2y, z+1) |
+	|                 |                 |
+	-------------------------------------
+
+A coarse tile is (re)built when it is not done yet, or when one of its children
+has been rendered or rebuilt since it was last built (see MapTileInfo::pyramid_dirty_tiles),
+and only once all of its existing children are done.  Quadrants of children that
+don't exist, e.g. outside the area rendered at MAX_TILE_Z, keep the previous image
+of the tile.
+=====================================================================*/
+namespace MapTilePyramid
+{
+
+static const int MAX_TILE_Z = 6; // Finest zoom level.  Tiles at this level are rendered by the screenshot bot.
+static const int TILE_RES = 256; // Tile image width and height in pixels.
+
+
+inline bool isTileRenderedByBot(int tile_z) { return tile_z == MAX_TILE_Z; }
+
+Vec3<int> getParentTileCoords(const Vec3<int>& tile_coords);
+
+// Child index i in [0, 4) is (2x + (i % 2), 2y + (i / 2), z + 1).  See diagram above.
+Vec3<int> getChildTileCoords(const Vec3<int>& tile_coords, int i);
+
+// Composite and downsample the 4 child tiles (in getChildTileCoords() order) into a new TILE_RES x TILE_RES RGB parent tile.
+// The quadrant for a NULL child is copied from prev_parent, the previous image of the parent tile, if prev_parent is non-NULL, and is black otherwise.
+// Throws glare::Exception if a child or prev_parent is not TILE_RES x TILE_RES with at least 3 channels.
+ImageMapUInt8Ref buildParentTile(const ImageMapUInt8* children[4], const ImageMapUInt8* prev_parent = NULL);
+
+// Builds all coarse tiles that need (re)building, from the finest coarse level to zoom level 0.
+// Saves built tiles to server->screenshot_dir and adds them as resources, like the screenshot bot tiles.
+// Returns the number of tiles built.  Doesn't hold the world state mutex while decoding, filtering or encoding images.
+size_t buildDirtyTiles(Server* server, ServerAllWorldsState* world_state);
+
+void test();
+
+} // end namespace MapTilePyramid
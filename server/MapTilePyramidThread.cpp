@@ -0,0 +1,62 @@
+/*=====================================================================
+MapTilePyramidThread.cpp
+------------------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#include "MapTilePyramidThread.h"
+
+
+#include "MapTilePyramid.h"
+#include "Server.h"
+#include "ServerWorldState.h"
+#include <ConPrint.h>
+#include <Exception.h>
+#include <StringUtils.h>
+#include <PlatformUtils.h>
+#include <Timer.h>
+#include <KillThreadMessage.h>
+
+
+MapTilePyramidThread::MapTilePyramidThread(Server* server_, ServerAllWorldsState* world_state_)
+:	server(server_), world_state(world_state_)
+{
+}
+
+
+MapTilePyramidThread::~MapTilePyramidThread()
+{
+}
+
+
+void MapTilePyramidThread::doRun()
+{
+	PlatformUtils::setCurrentThreadName("MapTilePyramidThread");
+
+	try
+	{
+		while(1)
+		{
+			// Block for a while, or until we have a kill message
+			ThreadMessageRef msg;
+			const bool got_msg = getMessageQueue().dequeueWithTimeout(/*wait_time_seconds=*/10.0, msg);
+			if(got_msg)
+			{
+				if(dynamic_cast<KillThreadMessage*>(msg.ptr()))
+					return;
+			}
+
+			Timer timer;
+			const size_t num_built = MapTilePyramid::buildDirtyTiles(server, world_state);
+			if(num_built > 0)
+				conPrint("MapTilePyramidThread: Built " + toString(num_built) + " map tile(s) in " + timer.elapsedStringNSigFigs(4));
+		}
+	}
+	catch(glare::Exception& e)
+	{
+		conPrint("MapTilePyramidThread: glare::Exception: " + e.what());
+	}
+	catch(std::exception& e) // catch std::bad_alloc etc..
+	{
+		conPrint(std::string("MapTilePyramidThread: Caught std::exception: ") + e.what());
+	}
+}
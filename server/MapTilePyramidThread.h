@@ -0,0 +1,32 @@
+/*=====================================================================
+MapTilePyramidThread.h
+----------------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#pragma once
+
+
+#include <MessageableThread.h>
+class Server;
+class ServerAllWorldsState;
+
+
+/*=====================================================================
+MapTilePyramidThread
+--------------------
+Periodically builds coarse map tiles whose child tiles have changed.
+See MapTilePyramid.
+=====================================================================*/
+class MapTilePyramidThread : public MessageableThread
+{
+public:
+	MapTilePyramidThread(Server* server, ServerAllWorldsState* world_state);
+
+	virtual ~MapTilePyramidThread();
+
+	virtual void doRun();
+
+private:
+	Server* server;
+	ServerAllWorldsState* world_state;
+};
@@ -19,8 +19,10 @@ Copyright Glare Technologies Limited 2022 -
 #include <Timer.h>
 #include <TaskManager.h>
 #include <FileUtils.h>
+#include <FileChecksum.h>
 #include <KillThreadMessage.h>
 #include <graphics/ImageMap.h>
+#include <algorithm>
 
 
 MeshLODGenThread::MeshLODGenThread(Server* server_, ServerAllWorldsState* world_state_)
@@ -60,6 +62,7 @@ struct LODTextureToGen
 	URLString lod_URL;
 	int lod_level;
 	UserID owner_id;
+	bool srgb; // True for colour textures, false for textures with linear data (roughness, normal maps).
 };
 
 
@@ -71,6 +74,8 @@ struct BasisTextureToGen
 	int base_lod_level;
 	int lod_level;
 	UserID owner_id;
+	BasisEncodingService::Priority priority;
+	bool srgb; // True for colour textures, false for textures with linear data (roughness, normal maps).
 };
 
 
@@ -400,7 +405,21 @@ static void checkForOptimisedMeshToGenerateForURL(const URLString& URL, Resource
 }
 
 
-static void checkMaterialFlags(ServerAllWorldsState* world_state, ServerWorldState* world, WorldObject* ob, std::map<std::string, MeshLODGenThreadTexInfo>& tex_info)
+// Get the content hash of a source resource file.  Resource files don't change once present, so we can cache the hashes by path.
+static uint64 getSourceContentHash(const std::string& abs_path, std::map<std::string, uint64>& source_content_hashes)
+{
+	auto res = source_content_hashes.find(abs_path);
+	if(res != source_content_hashes.end())
+		return res->second;
+
+	const uint64 hash = FileChecksum::fileChecksum(abs_path);
+	source_content_hashes[abs_path] = hash;
+	return hash;
+}
+
+
+static void checkMaterialFlags(ServerAllWorldsState* world_state, ServerWorldState* world, WorldObject* ob, std::map<std::string, MeshLODGenThreadTexInfo>& tex_info,
+	std::map<std::string, uint64>& source_content_hashes)
 {
 	for(size_t z=0; z<ob->materials.size(); ++z)
 	{
@@ -427,7 +446,8 @@ static void checkMaterialFlags(ServerAllWorldsState* world_state, ServerWorldSta
 							auto res = tex_info.find(tex_abs_path);
 							if(res == tex_info.end())
 							{
-								Reference<Map2D> map = ImageDecoding::decodeImage(".", tex_abs_path); // Load texture from disk and decode it.
+								// Load texture from disk and decode it, via the decoded image cache so that LOD and Basis texture generation can reuse it.
+								Reference<Map2D> map = world_state->decoded_image_cache.getOrDecodeImage(tex_abs_path, getSourceContentHash(tex_abs_path, source_content_hashes));
 								const bool is_hi_res = map->getMapWidth() > 1024 || map->getMapHeight() > 1024;
 								const bool has_alpha = textureHasAlphaChannel(map);
 
@@ -518,6 +538,7 @@ static void checkForLODTexturesToGenerate(ServerAllWorldsState* world_state, Ser
 									tex_to_gen.LOD_tex_abs_path = lod_abs_path;
 									tex_to_gen.lod_URL = lod_URL;
 									tex_to_gen.owner_id = base_resource->owner_id;
+									tex_to_gen.srgb = (texture_URL == mat->colour_texture_url) || (texture_URL == mat->emission_texture_url);
 									textures_to_gen.push_back(tex_to_gen);
 								}
 							}
@@ -532,7 +553,7 @@ static void checkForLODTexturesToGenerate(ServerAllWorldsState* world_state, Ser
 
 // Make tasks for generating Basis level textures.
 static void checkForBasisTexturesToGenerateForMaterials(ServerAllWorldsState* world_state, const std::vector<WorldMaterialRef>& materials, std::unordered_set<URLString, URLStringHasher>& lod_URLs_considered,
-	std::vector<BasisTextureToGen>& basis_textures_to_gen)
+	BasisEncodingService::Priority priority, std::vector<BasisTextureToGen>& basis_textures_to_gen)
 {
 	for(size_t z=0; z<materials.size(); ++z)
 	{
@@ -576,6 +597,8 @@ static void checkForBasisTexturesToGenerateForMaterials(ServerAllWorldsState* wo
 									tex_to_gen.base_lod_level = mat->minLODLevel();
 									tex_to_gen.lod_level = lvl;
 									tex_to_gen.owner_id = base_resource->owner_id;
+									tex_to_gen.priority = priority;
+									tex_to_gen.srgb = (texture_URL == mat->colour_texture_url) || (texture_URL == mat->emission_texture_url);
 									basis_textures_to_gen.push_back(tex_to_gen);
 								}
 							}
@@ -592,13 +615,14 @@ static void checkForBasisTexturesToGenerateForMaterials(ServerAllWorldsState* wo
 static void checkForBasisTexturesToGenerateForOb(ServerAllWorldsState* world_state, WorldObject* ob, std::unordered_set<URLString, URLStringHasher>& lod_URLs_considered,
 	std::vector<BasisTextureToGen>& basis_textures_to_gen)
 {
-	checkForBasisTexturesToGenerateForMaterials(world_state, /*world, */ob->materials, lod_URLs_considered, basis_textures_to_gen);
+	checkForBasisTexturesToGenerateForMaterials(world_state, /*world, */ob->materials, lod_URLs_considered, BasisEncodingService::Priority_Normal, basis_textures_to_gen);
 }
 
 
 // Make tasks for generating Basis level textures.
-static void checkForBasisTexturesToGenerateForURL(const URLString& URL, ResourceManager* resource_manager, std::unordered_set<URLString, URLStringHasher>& lod_URLs_considered,
-	std::vector<BasisTextureToGen>& basis_textures_to_gen)
+// srgb should be true if the texture has colour data.
+static void checkForBasisTexturesToGenerateForURL(const URLString& URL, bool srgb, ResourceManager* resource_manager, std::unordered_set<URLString, URLStringHasher>& lod_URLs_considered,
+	BasisEncodingService::Priority priority, std::vector<BasisTextureToGen>& basis_textures_to_gen)
 {
 	const URLString base_texture_URL = URL;
 
@@ -627,6 +651,8 @@ static void checkForBasisTexturesToGenerateForURL(const URLString& URL, Resource
 						tex_to_gen.base_lod_level = 0;
 						tex_to_gen.lod_level = lvl;
 						tex_to_gen.owner_id = base_resource->owner_id;
+						tex_to_gen.priority = priority;
+						tex_to_gen.srgb = srgb;
 						basis_textures_to_gen.push_back(tex_to_gen);
 					}
 				}
@@ -707,6 +733,29 @@ static void markOptimisedMeshesAsNotPresent(ServerAllWorldsState* world_state)
 #endif
 
 
+// Add a resource for a newly generated (or reused) derived file, and notify the server so that clients can be told about it.
+static void addGeneratedResource(Server* server, ServerAllWorldsState* world_state, const URLString& URL, const std::string& raw_path, UserID owner_id)
+{
+	{ // lock scope
+		Lock lock(world_state->mutex);
+
+		ResourceRef resource = new Resource(
+			URL, // URL
+			raw_path, // raw local path
+			Resource::State_Present, // state
+			owner_id,
+			/*external resource=*/false
+		);
+
+		world_state->addResourceAsDBDirty(resource);
+		world_state->resource_manager->addResource(resource);
+
+	} // End lock scope
+
+	server->enqueueMsg(new NewResourceGenerated(URL));
+}
+
+
 void MeshLODGenThread::doRun()
 {
 	PlatformUtils::setCurrentThreadName("MeshLODGenThread");
@@ -723,6 +772,8 @@ void MeshLODGenThread::doRun()
 
 		while(1)
 		{
+			std::map<std::string, uint64> source_content_hashes; // Map from source resource abs path to content hash.  Per scan pass, so it doesn't grow over the life of the thread.
+
 			std::set<UID> obs_to_scan_UIDs;
 			std::set<URLString> URLs_to_check;
 			if(!do_initial_full_scan)
@@ -789,7 +840,7 @@ void MeshLODGenThread::doRun()
 									checkObjectSpaceAABB(world_state, world, ob);
 
 								if(false)
-									checkMaterialFlags(world_state, world, ob, tex_info);
+									checkMaterialFlags(world_state, world, ob, tex_info, source_content_hashes);
 
 								checkForLODMeshesToGenerate(world_state, world, ob, lod_URLs_considered, meshes_to_gen);
 								checkForOptimisedMeshesToGenerate(world_state, world, ob, lod_URLs_considered, meshes_to_gen);
@@ -806,10 +857,10 @@ void MeshLODGenThread::doRun()
 						for(int i=0; i<4; ++i)
 						{
 							const URLString detail_col_map_URL = world->world_settings.terrain_spec.detail_col_map_URLs[i];
-							checkForBasisTexturesToGenerateForURL(detail_col_map_URL, world_state->resource_manager.ptr(), lod_URLs_considered, basis_textures_to_gen);
+							checkForBasisTexturesToGenerateForURL(detail_col_map_URL, /*srgb=*/true, world_state->resource_manager.ptr(), lod_URLs_considered, BasisEncodingService::Priority_Normal, basis_textures_to_gen);
 
 							const URLString detail_height_map_URL = world->world_settings.terrain_spec.detail_height_map_URLs[i];
-							checkForBasisTexturesToGenerateForURL(detail_height_map_URL, world_state->resource_manager.ptr(), lod_URLs_considered, basis_textures_to_gen);
+							checkForBasisTexturesToGenerateForURL(detail_height_map_URL, /*srgb=*/false, world_state->resource_manager.ptr(), lod_URLs_considered, BasisEncodingService::Priority_Normal, basis_textures_to_gen);
 						}
 					}
 
@@ -819,7 +870,7 @@ void MeshLODGenThread::doRun()
 						const User* user = it->second.ptr();
 						checkForOptimisedMeshToGenerateForURL(user->avatar_settings.model_url, world_state->resource_manager.ptr(), lod_URLs_considered, meshes_to_gen);
 
-						checkForBasisTexturesToGenerateForMaterials(world_state, user->avatar_settings.materials, lod_URLs_considered, basis_textures_to_gen);
+						checkForBasisTexturesToGenerateForMaterials(world_state, user->avatar_settings.materials, lod_URLs_considered, BasisEncodingService::Priority_High, basis_textures_to_gen);
 					}
 
 					do_initial_full_scan = false;
@@ -855,7 +906,8 @@ void MeshLODGenThread::doRun()
 					for(auto it = URLs_to_check.begin(); it != URLs_to_check.end(); ++it)
 					{
 						const URLString URL_to_check = *it;
-						checkForBasisTexturesToGenerateForURL(URL_to_check, world_state->resource_manager.ptr(), lod_URLs_considered, basis_textures_to_gen);
+						// These are textures used by e.g. avatars, so a user is likely waiting for them.  We don't know what the texture is used for here, so assume it has colour data.
+						checkForBasisTexturesToGenerateForURL(URL_to_check, /*srgb=*/true, world_state->resource_manager.ptr(), lod_URLs_considered, BasisEncodingService::Priority_High, basis_textures_to_gen);
 						checkForOptimisedMeshToGenerateForURL(URL_to_check, world_state->resource_manager.ptr(), lod_URLs_considered, meshes_to_gen);
 					}
 				}
@@ -872,48 +924,108 @@ void MeshLODGenThread::doRun()
 				conPrint("MeshLODGenThread: Generating LOD meshes...");
 				timer.reset();
 
-				for(size_t i=0; i<meshes_to_gen.size(); ++i)
+				// Group the meshes to generate by source model (and by whether they are optimised meshes), so that each source model is only loaded once,
+				// and each LOD level can be simplified from the previous level.  Groups are in order of first appearance in meshes_to_gen.
+				std::vector<std::vector<size_t>> mesh_groups; // Indices into meshes_to_gen
+				{
+					std::map<std::pair<std::string, bool>, size_t> group_index_for_source;
+					for(size_t i=0; i<meshes_to_gen.size(); ++i)
+					{
+						const std::pair<std::string, bool> source(meshes_to_gen[i].model_abs_path, meshes_to_gen[i].build_optimised_mesh);
+						auto res = group_index_for_source.find(source);
+						if(res == group_index_for_source.end())
+						{
+							group_index_for_source[source] = mesh_groups.size();
+							mesh_groups.push_back(std::vector<size_t>(1, i));
+						}
+						else
+							mesh_groups[res->second].push_back(i);
+					}
+				}
+
+				for(size_t g=0; g<mesh_groups.size(); ++g)
 				{
-					const LODMeshToGen& mesh_to_gen = meshes_to_gen[i];
+					const std::vector<size_t>& group = mesh_groups[g];
+					const LODMeshToGen& first_mesh_to_gen = meshes_to_gen[group[0]];
 					try
 					{
-						conPrint("MeshLODGenThread: (mesh " + toString(i) + " / " + toString(meshes_to_gen.size()) + "): Generating " + (mesh_to_gen.build_optimised_mesh ? "optimised" : "LOD") + " mesh with URL " + toStdString(mesh_to_gen.lod_URL));
+						conPrint("MeshLODGenThread: (source mesh " + toString(g) + " / " + toString(mesh_groups.size()) + "): Generating " + toString(group.size()) + " " + (first_mesh_to_gen.build_optimised_mesh ? "optimised" : "LOD") + 
+							" mesh(es) for '" + first_mesh_to_gen.model_abs_path + "'");
 
-						if(mesh_to_gen.build_optimised_mesh) // If building optimised mesh (may be LOD mesh also):
-						{
-							LODGeneration::generateOptimisedMesh(mesh_to_gen.model_abs_path, mesh_to_gen.lod_level, mesh_to_gen.LOD_model_abs_path);
+						const uint64 source_content_hash = getSourceContentHash(first_mesh_to_gen.model_abs_path, source_content_hashes);
 
-							conPrint("\tMeshLODGenThread: done generating mesh.");
-						}
-						else // Else if building (unoptimised) LOD mesh:
+						// Reuse any meshes already in the derived asset store, and work out which LOD levels we need to generate.
+						std::vector<DerivedAssetKey> keys(group.size());
+						std::vector<std::string> raw_paths(group.size());
+						std::vector<size_t> group_indices_to_gen;
+						std::vector<LODGeneration::LODChainLevel> levels_to_gen;
+						for(size_t z=0; z<group.size(); ++z)
 						{
-							LODGeneration::generateLODModel(mesh_to_gen.model_abs_path, mesh_to_gen.lod_level, mesh_to_gen.LOD_model_abs_path);
+							const LODMeshToGen& mesh_to_gen = meshes_to_gen[group[z]];
+							keys[z] = DerivedAssetKey(
+								source_content_hash,
+								mesh_to_gen.build_optimised_mesh ? DerivedAssetKey::GeneratorKind_OptimisedMesh : DerivedAssetKey::GeneratorKind_LODModel,
+								mesh_to_gen.lod_level,
+								/*param=*/0,
+								// Optimised meshes above LOD level 0 are made by the LOD chain as well, so their version includes LOD_MODEL_GEN_VERSION.
+								mesh_to_gen.build_optimised_mesh ? (((uint32)Protocol::OPTIMISED_MESH_VERSION << 16) | LODGeneration::LOD_MODEL_GEN_VERSION) : LODGeneration::LOD_MODEL_GEN_VERSION,
+								getExtension(mesh_to_gen.LOD_model_abs_path)
+							);
+
+							if(world_state->resource_manager->lookupDerivedAsset(keys[z], raw_paths[z]))
+								conPrint("\tMeshLODGenThread: reusing existing derived asset '" + raw_paths[z] + "'");
+							else
+							{
+								group_indices_to_gen.push_back(z);
+								levels_to_gen.push_back(LODGeneration::LODChainLevel(mesh_to_gen.lod_level, mesh_to_gen.LOD_model_abs_path));
+							}
 						}
 
-						// Now that we have generated the LOD model, add it to resources.
-						{ // lock scope
-							Lock lock(world_state->mutex);
+						if(!levels_to_gen.empty())
+						{
+							Timer gen_timer;
+							LODGeneration::LODChainStats stats;
+							LODGeneration::generateLODChain(first_mesh_to_gen.model_abs_path, levels_to_gen, first_mesh_to_gen.build_optimised_mesh, &task_manager, stats);
+							const double gen_time_per_level_s = gen_timer.elapsed() / levels_to_gen.size();
 
-							const std::string raw_path = FileUtils::getFilename(mesh_to_gen.LOD_model_abs_path); // NOTE: assuming we can get raw/relative path from abs path like this.
+							conPrint("\tMeshLODGenThread: done generating " + toString(levels_to_gen.size()) + " mesh(es) (load: " + doubleToStringNSigFigs(stats.load_time_s, 3) + " s, simplify: " + 
+								doubleToStringNSigFigs(stats.simplify_time_s, 3) + " s, write: " + doubleToStringNSigFigs(stats.write_time_s, 3) + " s, peak mesh mem: " + getNiceByteSize(stats.peak_mesh_mem_B) + ")");
 
-							ResourceRef resource = new Resource(
-								mesh_to_gen.lod_URL, // URL
-								raw_path, // raw local path
-								Resource::State_Present, // state
-								mesh_to_gen.owner_id,
-								/*external_resource=*/false
-							);
+							for(size_t z=0; z<group_indices_to_gen.size(); ++z)
+							{
+								const size_t group_i = group_indices_to_gen[z];
+								raw_paths[group_i] = FileUtils::getFilename(levels_to_gen[z].output_path); // NOTE: assuming we can get raw/relative path from abs path like this.
+								world_state->resource_manager->insertDerivedAsset(keys[group_i], raw_paths[group_i], gen_time_per_level_s);
+							}
+						}
 
-							world_state->addResourceAsDBDirty(resource);
-							world_state->resource_manager->addResource(resource);
+						for(size_t z=0; z<group.size(); ++z)
+						{
+							const LODMeshToGen& mesh_to_gen = meshes_to_gen[group[z]];
+
+							// Now that we have generated the LOD model, add it to resources.
+							{ // lock scope
+								Lock lock(world_state->mutex);
+
+								ResourceRef resource = new Resource(
+									mesh_to_gen.lod_URL, // URL
+									raw_paths[z], // raw local path
+									Resource::State_Present, // state
+									mesh_to_gen.owner_id,
+									/*external_resource=*/false
+								);
+
+								world_state->addResourceAsDBDirty(resource);
+								world_state->resource_manager->addResource(resource);
 						
-						} // End lock scope
+							} // End lock scope
 
-						server->enqueueMsg(new NewResourceGenerated(mesh_to_gen.lod_URL));
+							server->enqueueMsg(new NewResourceGenerated(mesh_to_gen.lod_URL));
+						}
 					}
 					catch(glare::Exception& e)
 					{
-						conPrint("\tMeshLODGenThread: glare::Exception while generating LOD model for URL '" + toStdString(mesh_to_gen.lod_URL) + "': " + e.what());
+						conPrint("\tMeshLODGenThread: glare::Exception while generating LOD models for '" + first_mesh_to_gen.model_abs_path + "': " + e.what());
 					}
 
 					if(should_quit)
@@ -930,39 +1042,96 @@ void MeshLODGenThread::doRun()
 				conPrint("MeshLODGenThread: Generating LOD textures...");
 				timer.reset();
 
-				for(size_t i=0; i<lod_textures_to_gen.size(); ++i)
+				// Group the textures to generate by source texture (and colour space), so that each source texture is only decoded once,
+				// and all its LOD levels are made in a single downsampling pass.  Groups are in order of first appearance in lod_textures_to_gen.
+				std::vector<std::vector<size_t>> tex_groups; // Indices into lod_textures_to_gen
 				{
-					const LODTextureToGen& tex_to_gen = lod_textures_to_gen[i];
+					std::map<std::pair<std::string, bool>, size_t> group_index_for_source;
+					for(size_t i=0; i<lod_textures_to_gen.size(); ++i)
+					{
+						const std::pair<std::string, bool> source(lod_textures_to_gen[i].source_tex_abs_path, lod_textures_to_gen[i].srgb);
+						auto res = group_index_for_source.find(source);
+						if(res == group_index_for_source.end())
+						{
+							group_index_for_source[source] = tex_groups.size();
+							tex_groups.push_back(std::vector<size_t>(1, i));
+						}
+						else
+							tex_groups[res->second].push_back(i);
+					}
+				}
+
+				for(size_t g=0; g<tex_groups.size(); ++g)
+				{
+					const std::vector<size_t>& group = tex_groups[g];
+					const LODTextureToGen& first_tex_to_gen = lod_textures_to_gen[group[0]];
 					try
 					{
-						conPrint("MeshLODGenThread:  (LOD tex " + toString(i) + " / " + toString(lod_textures_to_gen.size()) + "): Generating LOD texture with URL " + toStdString(tex_to_gen.lod_URL));
+						conPrint("MeshLODGenThread:  (source tex " + toString(g) + " / " + toString(tex_groups.size()) + "): Generating " + toString(group.size()) + " LOD texture(s) for '" + first_tex_to_gen.source_tex_abs_path + "'");
+
+						const uint64 source_content_hash = getSourceContentHash(first_tex_to_gen.source_tex_abs_path, source_content_hashes);
+
+						// Reuse any textures already in the derived asset store, and work out which LOD levels we need to generate.
+						std::vector<DerivedAssetKey> keys(group.size());
+						std::vector<std::string> raw_paths(group.size());
+						std::vector<size_t> group_indices_to_gen;
+						std::vector<LODGeneration::LODTextureLevel> levels_to_gen;
+						for(size_t z=0; z<group.size(); ++z)
+						{
+							const LODTextureToGen& tex_to_gen = lod_textures_to_gen[group[z]];
+							keys[z] = DerivedAssetKey(source_content_hash, DerivedAssetKey::GeneratorKind_LODTexture, tex_to_gen.lod_level,
+								/*param=*/tex_to_gen.srgb ? 0 : 1, LODGeneration::LOD_TEXTURE_GEN_VERSION, getExtension(tex_to_gen.LOD_tex_abs_path));
+
+							if(world_state->resource_manager->lookupDerivedAsset(keys[z], raw_paths[z]))
+								conPrint("\tMeshLODGenThread: reusing existing derived asset '" + raw_paths[z] + "'");
+							else
+							{
+								group_indices_to_gen.push_back(z);
+								levels_to_gen.push_back(LODGeneration::LODTextureLevel(tex_to_gen.lod_level, tex_to_gen.LOD_tex_abs_path));
+							}
+						}
 
-						LODGeneration::generateLODTexture(tex_to_gen.source_tex_abs_path, tex_to_gen.lod_level, tex_to_gen.LOD_tex_abs_path, task_manager);
+						if(!levels_to_gen.empty())
+						{
+							Timer gen_timer;
+							LODGeneration::generateLODTextures(first_tex_to_gen.source_tex_abs_path, levels_to_gen, first_tex_to_gen.srgb, task_manager, &world_state->decoded_image_cache, source_content_hash);
+							const double gen_time_per_level_s = gen_timer.elapsed() / levels_to_gen.size();
 
-						// Now that we have generated the LOD model, add it to resources.
-						{ // lock scope
-							Lock lock(world_state->mutex);
+							for(size_t z=0; z<group_indices_to_gen.size(); ++z)
+							{
+								const size_t group_i = group_indices_to_gen[z];
+								raw_paths[group_i] = FileUtils::getFilename(levels_to_gen[z].output_path); // NOTE: assuming we can get raw/relative path from abs path like this.
+								world_state->resource_manager->insertDerivedAsset(keys[group_i], raw_paths[group_i], gen_time_per_level_s);
+							}
+						}
 
-							const std::string raw_path = FileUtils::getFilename(tex_to_gen.LOD_tex_abs_path); // NOTE: assuming we can get raw/relative path from abs path like this.
+						for(size_t z=0; z<group.size(); ++z)
+						{
+							const LODTextureToGen& tex_to_gen = lod_textures_to_gen[group[z]];
 
-							ResourceRef resource = new Resource(
-								tex_to_gen.lod_URL, // URL
-								raw_path, // raw local path
-								Resource::State_Present, // state
-								tex_to_gen.owner_id,
-								/*external_resource=*/false
-							);
+							// Now that we have generated the LOD texture, add it to resources.
+							{ // lock scope
+								Lock lock(world_state->mutex);
 
-							world_state->addResourceAsDBDirty(resource);
-							world_state->resource_manager->addResource(resource);
+								ResourceRef resource = new Resource(
+									tex_to_gen.lod_URL, // URL
+									raw_paths[z], // raw local path
+									Resource::State_Present, // state
+									tex_to_gen.owner_id,
+									/*external_resource=*/false
+								);
 
-						} // End lock scope
+								world_state->addResourceAsDBDirty(resource);
+								world_state->resource_manager->addResource(resource);
 
-						server->enqueueMsg(new NewResourceGenerated(tex_to_gen.lod_URL));
+							} // End lock scope
+
+							server->enqueueMsg(new NewResourceGenerated(tex_to_gen.lod_URL));
+						}
 					}
 					catch(glare::Exception& e)
 					{
-						conPrint("\tMeshLODGenThread: excep while generating LOD texture: " + e.what());
+						conPrint("\tMeshLODGenThread: excep while generating LOD textures: " + e.what());
 					}
 
 					if(should_quit)
@@ -972,56 +1141,117 @@ void MeshLODGenThread::doRun()
 				conPrint("MeshLODGenThread: Done generating LOD textures. (Elapsed: " + timer.elapsedStringNSigFigs(4));
 			}
 
-			//------------------------------------------- Generate each Basis texture, without holding the world lock -------------------------------------------
+			//------------------------------------------- Generate Basis textures, without holding the world lock -------------------------------------------
+			// Source images for a batch of textures are prepared on this thread, then the batch is encoded in parallel by the Basis encoding service.
 			if(!basis_textures_to_gen.empty())
 			{
 				conPrint("MeshLODGenThread: Generating Basis textures...");
 				timer.reset();
 
-				for(size_t i=0; i<basis_textures_to_gen.size(); ++i)
-				{
-					const BasisTextureToGen& tex_to_gen = basis_textures_to_gen[i];
-					try
-					{
-						conPrint("MeshLODGenThread: (basis " + toString(i) + " / " + toString(basis_textures_to_gen.size()) + "): Generating basis texture with URL " + toStdString(tex_to_gen.basis_URL));
+				// Generate higher priority textures first.
+				std::stable_sort(basis_textures_to_gen.begin(), basis_textures_to_gen.end(), [](const BasisTextureToGen& a, const BasisTextureToGen& b) { return a.priority < b.priority; });
 
-						LODGeneration::generateBasisTexture(tex_to_gen.source_tex_abs_path, 
-							tex_to_gen.base_lod_level, tex_to_gen.lod_level, tex_to_gen.basis_tex_abs_path, 
-							task_manager);
+				const size_t MAX_BATCH_NUM_JOBS = 64;
+				const size_t MAX_BATCH_SIZE_B = 256 * 1024 * 1024; // Limit memory used by the prepared source images.
 
-						// Now that we have generated the LOD model, add it to resources.
-						{ // lock scope
-							Lock lock(world_state->mutex);
+				size_t next_i = 0;
+				while(next_i < basis_textures_to_gen.size())
+				{
+					std::vector<BasisEncodingService::EncodeJob> jobs;
+					std::vector<size_t> job_tex_indices; // Index into basis_textures_to_gen for each job.
+					std::vector<DerivedAssetKey> job_keys;
+					std::map<DerivedAssetKey, size_t> job_index_for_key;
+					std::vector<std::pair<size_t, size_t> > duplicate_textures; // (index into basis_textures_to_gen, job index) for textures with the same key as a job in this batch.
+					size_t batch_size_B = 0;
+
+					for(; (next_i < basis_textures_to_gen.size()) && (jobs.size() < MAX_BATCH_NUM_JOBS) && (batch_size_B < MAX_BATCH_SIZE_B); ++next_i)
+					{
+						const BasisTextureToGen& tex_to_gen = basis_textures_to_gen[next_i];
+						try
+						{
+							conPrint("MeshLODGenThread: (basis " + toString(next_i) + " / " + toString(basis_textures_to_gen.size()) + "): Generating basis texture with URL " + toStdString(tex_to_gen.basis_URL));
 
-							const std::string raw_path = FileUtils::getFilename(tex_to_gen.basis_tex_abs_path); // NOTE: assuming we can get raw/relative path from abs path like this.
+							const uint64 source_content_hash = getSourceContentHash(tex_to_gen.source_tex_abs_path, source_content_hashes);
+							const DerivedAssetKey key(source_content_hash, DerivedAssetKey::GeneratorKind_BasisTexture, tex_to_gen.lod_level,
+								/*param=*/(tex_to_gen.base_lod_level * 2) + (tex_to_gen.srgb ? 0 : 1), LODGeneration::BASIS_TEXTURE_GEN_VERSION, getExtension(tex_to_gen.basis_tex_abs_path));
 
-							ResourceRef resource = new Resource(
-								tex_to_gen.basis_URL, // URL
-								raw_path, // raw local path
-								Resource::State_Present, // state
-								tex_to_gen.owner_id,
-								/*external resource=*/false
-							);
+							std::string existing_raw_path;
+							if(world_state->resource_manager->lookupDerivedAsset(key, existing_raw_path))
+							{
+								conPrint("\tMeshLODGenThread: reusing existing derived asset '" + existing_raw_path + "'");
+								addGeneratedResource(server, world_state, tex_to_gen.basis_URL, existing_raw_path, tex_to_gen.owner_id);
+							}
+							else if(job_index_for_key.count(key))
+							{
+								duplicate_textures.push_back(std::make_pair(next_i, job_index_for_key[key]));
+							}
+							else
+							{
+								BasisEncodingService::EncodeJob job;
+								job.image = LODGeneration::makeBasisTextureSourceImage(tex_to_gen.source_tex_abs_path, tex_to_gen.base_lod_level, tex_to_gen.lod_level, tex_to_gen.srgb, task_manager, 
+									&world_state->decoded_image_cache, source_content_hash, job.quality_level);
+								job.output_path = tex_to_gen.basis_tex_abs_path;
+								job.priority = tex_to_gen.priority;
+								batch_size_B += job.image->getByteSize();
+
+								job_index_for_key[key] = jobs.size();
+								jobs.push_back(job);
+								job_tex_indices.push_back(next_i);
+								job_keys.push_back(key);
+							}
+						}
+						catch(glare::Exception& e)
+						{
+							conPrint("\tMeshLODGenThread: excep while generating Basis texture: " + e.what());
+						}
+					}
 
-							world_state->addResourceAsDBDirty(resource);
-							world_state->resource_manager->addResource(resource);
+					world_state->basis_encoding_service.encodeJobs(jobs);
 
-						} // End lock scope
+					std::vector<std::string> job_raw_paths(jobs.size());
+					for(size_t z=0; z<jobs.size(); ++z)
+					{
+						const BasisTextureToGen& tex_to_gen = basis_textures_to_gen[job_tex_indices[z]];
+						if(jobs[z].succeeded)
+						{
+							job_raw_paths[z] = FileUtils::getFilename(jobs[z].output_path); // NOTE: assuming we can get raw/relative path from abs path like this.
+							world_state->resource_manager->insertDerivedAsset(job_keys[z], job_raw_paths[z], jobs[z].encode_time_s);
 
-						server->enqueueMsg(new NewResourceGenerated(tex_to_gen.basis_URL));
+							addGeneratedResource(server, world_state, tex_to_gen.basis_URL, job_raw_paths[z], tex_to_gen.owner_id);
+						}
+						else
+							conPrint("\tMeshLODGenThread: excep while generating Basis texture with URL " + toStdString(tex_to_gen.basis_URL) + ": " + jobs[z].error_msg);
 					}
-					catch(glare::Exception& e)
+
+					for(size_t z=0; z<duplicate_textures.size(); ++z)
 					{
-						conPrint("\tMeshLODGenThread: excep while generating Basis texture: " + e.what());
+						const size_t job_i = duplicate_textures[z].second;
+						if(jobs[job_i].succeeded)
+						{
+							const BasisTextureToGen& tex_to_gen = basis_textures_to_gen[duplicate_textures[z].first];
+							conPrint("\tMeshLODGenThread: reusing existing derived asset '" + job_raw_paths[job_i] + "'");
+							addGeneratedResource(server, world_state, tex_to_gen.basis_URL, job_raw_paths[job_i], tex_to_gen.owner_id);
+						}
 					}
 
 					if(should_quit)
 						return;
 				}
 
-				conPrint("MeshLODGenThread: Done generating Basis textures. (Elapsed: " + timer.elapsedStringNSigFigs(4) + ")");
+				const BasisEncodingService::Stats encoding_stats = world_state->basis_encoding_service.getStats();
+				conPrint("MeshLODGenThread: Done generating Basis textures. (Elapsed: " + timer.elapsedStringNSigFigs(4) + ", Basis encoding service: " + toString(encoding_stats.num_jobs_done) + " jobs done, max queue depth " + 
+					toString(encoding_stats.max_queue_depth) + ", total queue wait " + doubleToStringNSigFigs(encoding_stats.total_queue_wait_time_s, 3) + " s)");
 			}
 			//------------------------------------------- End Generate each KTX texture  -------------------------------------------
+
+			if(!meshes_to_gen.empty() || !lod_textures_to_gen.empty() || !basis_textures_to_gen.empty())
+			{
+				conPrint("MeshLODGenThread: derived-asset store stats:\n" + world_state->resource_manager->getDerivedAssetStoreStats());
+
+				const DecodedImageCache::Stats image_cache_stats = world_state->decoded_image_cache.getStats();
+				conPrint("MeshLODGenThread: decoded image cache: " + toString(image_cache_stats.num_hits) + " hits, " + toString(image_cache_stats.num_misses) + " misses, " + 
+					toString(image_cache_stats.num_evictions) + " evictions, " + toString(image_cache_stats.num_images) + " images (" + getNiceByteSize(image_cache_stats.total_size_B) + ")");
+			}
 		}
 	}
 	catch(glare::Exception& e)
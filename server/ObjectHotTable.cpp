@@ -0,0 +1,366 @@
+/*=====================================================================
+ObjectHotTable.cpp
+------------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#include "ObjectHotTable.h"
+
+
+#include <utils/ConPrint.h>
+#include <limits>
+
+
+ObjectHotTable::ObjectHotTable()
+{}
+
+
+ObjectHotTable::~ObjectHotTable()
+{}
+
+
+void ObjectHotTable::setHotData(size_t i, const WorldObject* ob)
+{
+	const Vec4f pos = ob->pos.toVec4fPoint();
+	if(pos.isFinite())
+	{
+		pos_x[i] = pos[0];
+		pos_y[i] = pos[1];
+		pos_z[i] = pos[2];
+	}
+	else
+	{
+		// Use NaNs so the position is never in any AABB.
+		pos_x[i] = pos_y[i] = pos_z[i] = std::numeric_limits<float>::quiet_NaN();
+	}
+
+	centroid_ws[i] = ob->getCentroidWS();
+	flags[i] = ob->flags;
+}
+
+
+void ObjectHotTable::updateObject(WorldObject* ob)
+{
+	auto res = index_for_uid.find(ob->uid);
+	if(res != index_for_uid.end())
+	{
+		const size_t i = res->second;
+		obs[i] = ob; // Another object with the same UID may have replaced the old one in the object map.
+		setHotData(i, ob);
+	}
+	else
+	{
+		const size_t i = obs.size();
+		pos_x.resize(i + 1);
+		pos_y.resize(i + 1);
+		pos_z.resize(i + 1);
+		centroid_ws.resize(i + 1);
+		flags.resize(i + 1);
+		obs.push_back(ob);
+		setHotData(i, ob);
+
+		index_for_uid[ob->uid] = i;
+	}
+}
+
+
+void ObjectHotTable::removeObject(const UID& uid)
+{
+	auto res = index_for_uid.find(uid);
+	if(res == index_for_uid.end())
+		return;
+
+	const size_t i = res->second;
+	const size_t last = obs.size() - 1;
+	if(i != last)
+	{
+		// Move last object into slot i.
+		pos_x[i]       = pos_x[last];
+		pos_y[i]       = pos_y[last];
+		pos_z[i]       = pos_z[last];
+		centroid_ws[i] = centroid_ws[last];
+		flags[i]       = flags[last];
+		obs[i]         = obs[last];
+
+		index_for_uid[obs[i]->uid] = i;
+	}
+
+	pos_x.resize(last);
+	pos_y.resize(last);
+	pos_z.resize(last);
+	centroid_ws.resize(last);
+	flags.resize(last);
+	obs.pop_back();
+
+	index_for_uid.erase(uid);
+}
+
+
+void ObjectHotTable::rebuild(const std::map<UID, WorldObjectRef>& objects)
+{
+	clear();
+
+	const size_t num = objects.size();
+	pos_x.resize(num);
+	pos_y.resize(num);
+	pos_z.resize(num);
+	centroid_ws.resize(num);
+	flags.resize(num);
+	obs.reserve(num);
+	index_for_uid.reserve(num);
+
+	for(auto it = objects.begin(); it != objects.end(); ++it)
+	{
+		const size_t i = obs.size();
+		obs.push_back(it->second);
+		setHotData(i, it->second.ptr());
+		index_for_uid[it->first] = i;
+	}
+}
+
+
+void ObjectHotTable::clear()
+{
+	pos_x.clear();
+	pos_y.clear();
+	pos_z.clear();
+	centroid_ws.clear();
+	flags.clear();
+	obs.clear();
+	index_for_uid.clear();
+}
+
+
+// Same test as js::AABBox::contains(), done on the separate coordinate arrays.
+void ObjectHotTable::getObjectsWithPosInAABB(const js::AABBox& aabb, std::vector<WorldObject*>& obs_out) const
+{
+	const float min_x = aabb.min_[0], min_y = aabb.min_[1], min_z = aabb.min_[2];
+	const float max_x = aabb.max_[0], max_y = aabb.max_[1], max_z = aabb.max_[2];
+
+	const size_t num = obs.size();
+	const float* const xs = pos_x.data();
+	const float* const ys = pos_y.data();
+	const float* const zs = pos_z.data();
+	for(size_t i=0; i<num; ++i)
+	{
+		const bool in_aabb =
+			(xs[i] >= min_x) & (xs[i] <= max_x) &
+			(ys[i] >= min_y) & (ys[i] <= max_y) &
+			(zs[i] >= min_z) & (zs[i] <= max_z); // Use & instead of && to avoid branches.  Comparisons with NaN are false.
+		if(in_aabb)
+			obs_out.push_back(obs[i].ptr());
+	}
+}
+
+
+void ObjectHotTable::getObjectsWithPosInAnyAABB(const js::AABBox* aabbs, size_t num_aabbs, std::vector<WorldObject*>& obs_out) const
+{
+	const size_t num = obs.size();
+	for(size_t i=0; i<num; ++i)
+	{
+		const Vec4f pos(pos_x[i], pos_y[i], pos_z[i], 1.f);
+		for(size_t z=0; z<num_aabbs; ++z)
+			if(aabbs[z].contains(pos))
+			{
+				obs_out.push_back(obs[i].ptr());
+				break;
+			}
+	}
+}
+
+
+void ObjectHotTable::getObjectsWithCentroidInAABB(const js::AABBox& aabb, uint32 exclude_flags, std::vector<WorldObject*>& obs_out) const
+{
+	const size_t num = obs.size();
+	for(size_t i=0; i<num; ++i)
+		if(aabb.contains(centroid_ws[i]) && ((flags[i] & exclude_flags) == 0))
+			obs_out.push_back(obs[i].ptr());
+}
+
+
+void ObjectHotTable::getObjectsWithFlags(uint32 required_flags, std::vector<WorldObject*>& obs_out) const
+{
+	const size_t num = obs.size();
+	for(size_t i=0; i<num; ++i)
+		if((flags[i] & required_flags) == required_flags)
+			obs_out.push_back(obs[i].ptr());
+}
+
+
+#if BUILD_TESTS
+
+
+#include <utils/TestUtils.h>
+#include <utils/Timer.h>
+#include <utils/StringUtils.h>
+#include <utils/BitUtils.h>
+#include <maths/PCG32.h>
+#include <algorithm>
+
+
+static void sortByUID(std::vector<WorldObject*>& obs)
+{
+	std::sort(obs.begin(), obs.end(), [](const WorldObject* a, const WorldObject* b) { return a->uid < b->uid; });
+}
+
+
+void ObjectHotTable::test()
+{
+	conPrint("ObjectHotTable::test()");
+
+	//------------------------ Test adding, updating and removing objects ------------------------
+	{
+		ObjectHotTable table;
+
+		std::vector<WorldObjectRef> test_obs;
+		for(int i=0; i<4; ++i)
+		{
+			WorldObjectRef ob = new WorldObject();
+			ob->uid = UID(i);
+			ob->pos = Vec3d(i * 10.0, 0, 0);
+			ob->centroid_ws = Vec4f(i * 10.f, 0, 0, 1);
+			ob->flags = (i % 2 == 0) ? WorldObject::SUMMONED_FLAG : 0;
+			test_obs.push_back(ob);
+			table.updateObject(ob.ptr());
+		}
+		testAssert(table.size() == 4);
+
+		const js::AABBox query_aabb(Vec4f(5, -1, -1, 1), Vec4f(25, 1, 1, 1));
+		std::vector<WorldObject*> res;
+		table.getObjectsWithPosInAABB(query_aabb, res);
+		sortByUID(res);
+		testAssert(res.size() == 2 && res[0] == test_obs[1].ptr() && res[1] == test_obs[2].ptr());
+
+		res.clear();
+		table.getObjectsWithCentroidInAABB(query_aabb, /*exclude flags=*/WorldObject::SUMMONED_FLAG, res);
+		testAssert(res.size() == 1 && res[0] == test_obs[1].ptr());
+
+		res.clear();
+		table.getObjectsWithFlags(WorldObject::SUMMONED_FLAG, res);
+		sortByUID(res);
+		testAssert(res.size() == 2 && res[0] == test_obs[0].ptr() && res[1] == test_obs[2].ptr());
+
+		// Move object 0 into the query AABB
+		test_obs[0]->pos = Vec3d(20, 0, 0);
+		table.updateObject(test_obs[0].ptr());
+		testAssert(table.size() == 4);
+		res.clear();
+		table.getObjectsWithPosInAABB(query_aabb, res);
+		testAssert(res.size() == 3);
+
+		// Non-finite positions should never be returned.
+		test_obs[1]->pos = Vec3d(std::numeric_limits<double>::infinity(), 0, 0);
+		table.updateObject(test_obs[1].ptr());
+		res.clear();
+		table.getObjectsWithPosInAABB(js::AABBox(Vec4f(-1.0e30f, -1.0e30f, -1.0e30f, 1), Vec4f(1.0e30f, 1.0e30f, 1.0e30f, 1)), res);
+		testAssert(res.size() == 3);
+
+		// Remove a middle object and the last object.
+		table.removeObject(UID(0));
+		table.removeObject(UID(3));
+		table.removeObject(UID(100)); // Not present, should do nothing.
+		testAssert(table.size() == 2);
+		res.clear();
+		table.getObjectsWithPosInAABB(query_aabb, res);
+		testAssert(res.size() == 1 && res[0] == test_obs[2].ptr());
+
+		// Re-adding should work
+		table.updateObject(test_obs[0].ptr());
+		testAssert(table.size() == 3);
+		res.clear();
+		table.getObjectsWithPosInAABB(query_aabb, res);
+		testAssert(res.size() == 2);
+	}
+
+	//------------------------ Compare full object map scans with table scans ------------------------
+	{
+		const int num_obs = 50000;
+
+		std::map<UID, WorldObjectRef> objects;
+		PCG32 rng(1);
+		for(int i=0; i<num_obs; ++i)
+		{
+			WorldObjectRef ob = new WorldObject();
+			ob->uid = UID(i);
+			ob->pos = Vec3d(rng.unitRandom() * 4000.0 - 2000.0, rng.unitRandom() * 4000.0 - 2000.0, rng.unitRandom() * 100.0);
+			ob->centroid_ws = ob->pos.toVec4fPoint();
+			ob->flags = (rng.unitRandom() < 0.1f) ? WorldObject::EXCLUDE_FROM_LOD_CHUNK_MESH : 0;
+			objects[ob->uid] = ob;
+		}
+
+		ObjectHotTable table;
+		{
+			Timer timer;
+			table.rebuild(objects);
+			conPrint("rebuild() of " + toString(num_obs) + " objects took " + timer.elapsedStringNSigFigs(4));
+		}
+		testAssert(table.size() == objects.size());
+
+		const js::AABBox query_aabb(Vec4f(-500, -500, -1000, 1), Vec4f(500, 500, 1000, 1));
+		const int num_iters = 20;
+
+		// QueryObjectsInAABB-style scan
+		{
+			std::vector<WorldObject*> map_res, table_res;
+			Timer timer;
+			for(int q=0; q<num_iters; ++q)
+			{
+				map_res.clear();
+				for(auto it = objects.begin(); it != objects.end(); ++it)
+				{
+					const Vec4f ob_pos = it->second->pos.toVec4fPoint();
+					if(ob_pos.isFinite() && query_aabb.contains(ob_pos))
+						map_res.push_back(it->second.ptr());
+				}
+			}
+			const double map_time = timer.elapsed() / num_iters;
+
+			timer.reset();
+			for(int q=0; q<num_iters; ++q)
+			{
+				table_res.clear();
+				table.getObjectsWithPosInAABB(query_aabb, table_res);
+			}
+			const double table_time = timer.elapsed() / num_iters;
+
+			sortByUID(table_res);
+			testAssert(map_res == table_res);
+			conPrint("Pos in AABB scan (" + toString(map_res.size()) + " results): object map: " + doubleToStringNSigFigs(map_time * 1.0e3, 4) + " ms, hot table: " +
+				doubleToStringNSigFigs(table_time * 1.0e3, 4) + " ms (" + doubleToStringNSigFigs(map_time / table_time, 3) + "x)");
+		}
+
+		// ChunkGenThread-style scan
+		{
+			std::vector<WorldObject*> map_res, table_res;
+			Timer timer;
+			for(int q=0; q<num_iters; ++q)
+			{
+				map_res.clear();
+				for(auto it = objects.begin(); it != objects.end(); ++it)
+				{
+					WorldObject* ob = it->second.ptr();
+					if(query_aabb.contains(ob->getCentroidWS()) && !BitUtils::isBitSet(ob->flags, WorldObject::EXCLUDE_FROM_LOD_CHUNK_MESH))
+						map_res.push_back(ob);
+				}
+			}
+			const double map_time = timer.elapsed() / num_iters;
+
+			timer.reset();
+			for(int q=0; q<num_iters; ++q)
+			{
+				table_res.clear();
+				table.getObjectsWithCentroidInAABB(query_aabb, WorldObject::EXCLUDE_FROM_LOD_CHUNK_MESH, table_res);
+			}
+			const double table_time = timer.elapsed() / num_iters;
+
+			sortByUID(table_res);
+			testAssert(map_res == table_res);
+			conPrint("Centroid in chunk scan (" + toString(map_res.size()) + " results): object map: " + doubleToStringNSigFigs(map_time * 1.0e3, 4) + " ms, hot table: " +
+				doubleToStringNSigFigs(table_time * 1.0e3, 4) + " ms (" + doubleToStringNSigFigs(map_time / table_time, 3) + "x)");
+		}
+	}
+
+	conPrint("ObjectHotTable::test() done.");
+}
+
+
+#endif // BUILD_TESTS
@@ -0,0 +1,83 @@
+/*=====================================================================
+ObjectHotTable.h
+----------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#pragma once
+
+
+#include "../shared/WorldObject.h"
+#include "../shared/UID.h"
+#include <utils/Vector.h>
+#include <physics/jscol_aabbox.h>
+#include <Platform.h>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+
+/*=====================================================================
+ObjectHotTable
+--------------
+A packed structure-of-arrays copy of the 'hot' per-object data that full-world
+scans on the server filter on: position, world-space centroid and flags.
+
+WorldObject is large (materials, script, content, snapshots, voxel data etc.),
+so iterating over the object map and reading ob->pos touches at least one cache
+line per object, spread all over the heap.  Scanning these arrays instead only
+touches the data needed to decide whether an object matches, and the full
+WorldObject is only looked at for matching objects.
+
+Objects are stored densely, in no particular order.  Removal moves the last
+object into the removed slot.
+
+The WorldObject is still the authoritative copy of the data.  The table is owned
+by ServerWorldState, which keeps it up to date, see ServerWorldState::getObjectHotTable().
+
+Not thread-safe, the world state mutex should be held.
+=====================================================================*/
+class ObjectHotTable
+{
+public:
+	ObjectHotTable();
+	~ObjectHotTable();
+
+	// Adds the object if not already present, otherwise updates the hot data for it.
+	void updateObject(WorldObject* ob);
+
+	void removeObject(const UID& uid);
+
+	void rebuild(const std::map<UID, WorldObjectRef>& objects);
+
+	void clear();
+
+	size_t size() const { return obs.size(); }
+
+	// Appends objects with position (as a float point) in aabb.  Objects with non-finite positions are not returned.
+	void getObjectsWithPosInAABB(const js::AABBox& aabb, std::vector<WorldObject*>& obs_out) const;
+
+	// Appends objects with position in any of the AABBs.
+	void getObjectsWithPosInAnyAABB(const js::AABBox* aabbs, size_t num_aabbs, std::vector<WorldObject*>& obs_out) const;
+
+	// Appends objects with world-space centroid in aabb, that have none of exclude_flags set.
+	void getObjectsWithCentroidInAABB(const js::AABBox& aabb, uint32 exclude_flags, std::vector<WorldObject*>& obs_out) const;
+
+	// Appends objects that have all of required_flags set.
+	void getObjectsWithFlags(uint32 required_flags, std::vector<WorldObject*>& obs_out) const;
+
+	static void test();
+
+private:
+	GLARE_DISABLE_COPY(ObjectHotTable);
+
+	void setHotData(size_t i, const WorldObject* ob);
+
+	js::Vector<float, 16> pos_x;
+	js::Vector<float, 16> pos_y;
+	js::Vector<float, 16> pos_z;
+	js::Vector<Vec4f, 16> centroid_ws;
+	std::vector<uint32> flags;
+	std::vector<WorldObjectRef> obs; // Cold data.
+
+	std::unordered_map<UID, size_t, UIDHasher> index_for_uid;
+};
@@ -0,0 +1,492 @@
+/*=====================================================================
+PhotoResizing.cpp
+-----------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#include "PhotoResizing.h"
+
+
+#include <graphics/jpegdecoder.h>
+#include <maths/SSE.h>
+#include <maths/mathstypes.h>
+#include <utils/TaskManager.h>
+#include <utils/Task.h>
+#include <utils/Exception.h>
+#include <utils/StringUtils.h>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#if BUILD_TESTS
+#include <maths/PCG32.h>
+#include <utils/ConPrint.h>
+#include <utils/PlatformUtils.h>
+#include <utils/Timer.h>
+#include <utils/TestUtils.h>
+#include <utils/TestExceptionUtils.h>
+#endif
+
+
+namespace PhotoResizing
+{
+
+
+// Filter taps for resampling along one axis.
+// Destination pixel d is the sum over i in [0, num_taps[d]) of weights[weights_offset[d] + i] * source pixel (first_tap[d] + i).
+struct FilterTaps
+{
+	std::vector<int> first_tap;
+	std::vector<int> num_taps;
+	std::vector<size_t> weights_offset;
+	std::vector<float> weights;
+};
+
+
+// Computes taps of a triangle filter for resampling the src_len pixels starting at src_begin to dst_len pixels.
+static void computeFilterTaps(int src_begin, int src_len, int dst_len, FilterTaps& taps)
+{
+	const float scale = (float)src_len / (float)dst_len;
+	const float radius = myMax(1.f, scale); // Widen the filter when downsampling
+
+	taps.first_tap.resize(dst_len);
+	taps.num_taps.resize(dst_len);
+	taps.weights_offset.resize(dst_len);
+	taps.weights.clear();
+
+	for(int d=0; d<dst_len; ++d)
+	{
+		const float centre = (float)src_begin + ((float)d + 0.5f) * scale; // Centre of destination pixel, in source pixel coordinates.
+		const int begin = myMax(src_begin,           (int)std::floor(centre - radius));
+		const int end   = myMin(src_begin + src_len, (int)std::ceil (centre + radius));
+
+		const size_t offset = taps.weights.size();
+		float sum = 0;
+		for(int s=begin; s<end; ++s)
+		{
+			const float w = myMax(0.f, 1.f - std::fabs((float)s + 0.5f - centre) / radius);
+			taps.weights.push_back(w);
+			sum += w;
+		}
+
+		// The source pixel containing the centre always has weight >= 0.5, so sum > 0.
+		assert(sum > 0);
+		for(size_t i=offset; i<taps.weights.size(); ++i)
+			taps.weights[i] /= sum;
+
+		taps.first_tap[d] = begin;
+		taps.num_taps[d] = end - begin;
+		taps.weights_offset[d] = offset;
+	}
+}
+
+
+struct OutputFilterTaps
+{
+	FilterTaps x_taps;
+	FilterTaps y_taps;
+};
+
+
+static const int BAND_HEIGHT = 32; // Number of destination rows resized by a single task.
+
+
+// Resizes destination rows [dst_y_begin, dst_y_end) of output.
+static void resizeBand(const ImageMapUInt8& src, ResizeOutput& output, const OutputFilterTaps& taps, int dst_y_begin, int dst_y_end)
+{
+	const size_t N = src.getN();
+	const int dst_w = output.dst_w;
+
+	// Work out the range of source rows needed for this band.
+	const int src_row_begin = taps.y_taps.first_tap[dst_y_begin];
+	int src_row_end = src_row_begin;
+	for(int y=dst_y_begin; y<dst_y_end; ++y)
+		src_row_end = myMax(src_row_end, taps.y_taps.first_tap[y] + taps.y_taps.num_taps[y]);
+
+	//------------------------ Horizontal pass ------------------------
+	// Each source row is converted to 4-wide float pixels, then filtered horizontally into hrows.
+	std::vector<float> src_row((size_t)output.src_w * 4);
+	std::vector<float> hrows((size_t)(src_row_end - src_row_begin) * dst_w * 4);
+
+	for(int sy=src_row_begin; sy<src_row_end; ++sy)
+	{
+		const uint8* src_pixels = src.getPixel(output.src_x, sy);
+		if(N == 1) // Greyscale
+		{
+			for(int x=0; x<output.src_w; ++x)
+			{
+				const float v = (float)src_pixels[x];
+				src_row[x*4 + 0] = v;
+				src_row[x*4 + 1] = v;
+				src_row[x*4 + 2] = v;
+				src_row[x*4 + 3] = 0.f;
+			}
+		}
+		else
+		{
+			for(int x=0; x<output.src_w; ++x)
+			{
+				src_row[x*4 + 0] = (float)src_pixels[x*N + 0];
+				src_row[x*4 + 1] = (float)src_pixels[x*N + 1];
+				src_row[x*4 + 2] = (float)src_pixels[x*N + 2];
+				src_row[x*4 + 3] = 0.f;
+			}
+		}
+
+		float* const hrow = &hrows[(size_t)(sy - src_row_begin) * dst_w * 4];
+		for(int x=0; x<dst_w; ++x)
+		{
+			const float* weights = &taps.x_taps.weights[taps.x_taps.weights_offset[x]];
+			const float* tap_pixels = &src_row[(size_t)(taps.x_taps.first_tap[x] - output.src_x) * 4];
+			const int num_taps = taps.x_taps.num_taps[x];
+
+			__m128 sum = _mm_setzero_ps();
+			for(int i=0; i<num_taps; ++i)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[i]), _mm_loadu_ps(tap_pixels + i*4)));
+
+			_mm_storeu_ps(hrow + x*4, sum);
+		}
+	}
+
+	//------------------------ Vertical pass ------------------------
+	for(int y=dst_y_begin; y<dst_y_end; ++y)
+	{
+		const float* weights = &taps.y_taps.weights[taps.y_taps.weights_offset[y]];
+		const int num_taps = taps.y_taps.num_taps[y];
+		const float* first_hrow = &hrows[(size_t)(taps.y_taps.first_tap[y] - src_row_begin) * dst_w * 4];
+
+		uint8* dest = output.result->getPixel(0, y);
+		for(int x=0; x<dst_w; ++x)
+		{
+			__m128 sum = _mm_setzero_ps();
+			for(int i=0; i<num_taps; ++i)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[i]), _mm_loadu_ps(first_hrow + ((size_t)i * dst_w + x) * 4)));
+
+			// Round to nearest int, then pack with saturation to 4 bytes.
+			const __m128i sum_i = _mm_cvtps_epi32(sum);
+			const __m128i packed_16 = _mm_packs_epi32(sum_i, sum_i);
+			const uint32 packed_8 = (uint32)_mm_cvtsi128_si32(_mm_packus_epi16(packed_16, packed_16));
+
+			dest[x*3 + 0] = (uint8)(packed_8);
+			dest[x*3 + 1] = (uint8)(packed_8 >> 8);
+			dest[x*3 + 2] = (uint8)(packed_8 >> 16);
+		}
+	}
+}
+
+
+class ResizeBandTask : public glare::Task
+{
+public:
+	virtual void run(size_t thread_index) override
+	{
+		resizeBand(*src, *output, *taps, dst_y_begin, dst_y_end);
+	}
+
+	const ImageMapUInt8* src;
+	ResizeOutput* output;
+	const OutputFilterTaps* taps;
+	int dst_y_begin, dst_y_end;
+};
+
+
+ResizeOutput makeCentreCroppedOutput(int src_w, int src_h, int dst_w, int dst_h)
+{
+	int cropped_w, cropped_h;
+	if((double)src_w / (double)src_h > ((double)dst_w / (double)dst_h))
+	{
+		// Image is wider than destination ratio, need to crop off left and right edges.
+		cropped_w = (int)((double)src_h * ((double)dst_w / (double)dst_h));
+		cropped_h = src_h;
+	}
+	else
+	{
+		// Image is taller than destination ratio, need to crop off top and bottom edges.
+		cropped_w = src_w;
+		cropped_h = (int)((double)src_w * ((double)dst_h / (double)dst_w));
+	}
+
+	const int left_right_edge_w = (src_w - cropped_w) / 2; // Get the width of the edge that will be cropped off, if any.
+	const int top_bottom_edge_w = (src_h - cropped_h) / 2;
+
+	return ResizeOutput(/*src_x=*/left_right_edge_w, /*src_y=*/top_bottom_edge_w, cropped_w, cropped_h, dst_w, dst_h);
+}
+
+
+void resizeToOutputs(const ImageMapUInt8& src, std::vector<ResizeOutput>& outputs, glare::TaskManager* task_manager)
+{
+	if(src.getN() != 1 && src.getN() != 3 && src.getN() != 4)
+		throw glare::Exception("Invalid number of channels for resize: " + toString(src.getN()));
+
+	std::vector<OutputFilterTaps> taps(outputs.size());
+	Reference<glare::TaskGroup> task_group = new glare::TaskGroup();
+
+	for(size_t i=0; i<outputs.size(); ++i)
+	{
+		ResizeOutput& output = outputs[i];
+		if(output.src_x < 0 || output.src_y < 0 || output.src_w <= 0 || output.src_h <= 0 ||
+			(size_t)output.src_x + output.src_w > src.getWidth() || (size_t)output.src_y + output.src_h > src.getHeight())
+			throw glare::Exception("Invalid source region for resize.");
+		if(output.dst_w <= 0 || output.dst_h <= 0)
+			throw glare::Exception("Invalid destination size for resize.");
+
+		computeFilterTaps(output.src_x, output.src_w, output.dst_w, taps[i].x_taps);
+		computeFilterTaps(output.src_y, output.src_h, output.dst_h, taps[i].y_taps);
+
+		output.result = new ImageMapUInt8(output.dst_w, output.dst_h, 3);
+
+		for(int y=0; y<output.dst_h; y += BAND_HEIGHT)
+		{
+			Reference<ResizeBandTask> task = new ResizeBandTask();
+			task->src = &src;
+			task->output = &output;
+			task->taps = &taps[i];
+			task->dst_y_begin = y;
+			task->dst_y_end = myMin(y + BAND_HEIGHT, output.dst_h);
+			task_group->tasks.push_back(task);
+		}
+	}
+
+	if(task_manager)
+		task_manager->runTaskGroup(task_group);
+	else
+	{
+		for(size_t i=0; i<task_group->tasks.size(); ++i)
+			task_group->tasks[i]->run(/*thread_index=*/0);
+	}
+}
+
+
+class SaveJPEGTask : public glare::Task
+{
+public:
+	virtual void run(size_t thread_index) override
+	{
+		try
+		{
+			JPEGDecoder::save(jpeg->image, jpeg->path, JPEGDecoder::SaveOptions(jpeg->quality));
+		}
+		catch(glare::Exception& e)
+		{
+			error_msg = e.what();
+		}
+	}
+
+	const JPEGToSave* jpeg;
+	std::string error_msg;
+};
+
+
+void saveJPEGs(const std::vector<JPEGToSave>& jpegs, glare::TaskManager* task_manager)
+{
+	Reference<glare::TaskGroup> task_group = new glare::TaskGroup();
+	std::vector<Reference<SaveJPEGTask>> tasks(jpegs.size());
+	for(size_t i=0; i<jpegs.size(); ++i)
+	{
+		tasks[i] = new SaveJPEGTask();
+		tasks[i]->jpeg = &jpegs[i];
+		task_group->tasks.push_back(tasks[i]);
+	}
+
+	if(task_manager && (jpegs.size() > 1))
+		task_manager->runTaskGroup(task_group);
+	else
+	{
+		for(size_t i=0; i<tasks.size(); ++i)
+			tasks[i]->run(/*thread_index=*/0);
+	}
+
+	for(size_t i=0; i<tasks.size(); ++i)
+		if(!tasks[i]->error_msg.empty())
+			throw glare::Exception("Failed to save '" + jpegs[i].path + "': " + tasks[i]->error_msg);
+}
+
+
+#if BUILD_TESTS
+
+
+static ImageMapUInt8Ref makeRandomImage(PCG32& rng, size_t W, size_t H, size_t N)
+{
+	ImageMapUInt8Ref map = new ImageMapUInt8(W, H, N);
+	for(size_t i=0; i<map->getDataSize(); ++i)
+		map->getData()[i] = (uint8)(rng.unitRandom() * 255.99f);
+	return map;
+}
+
+
+void test()
+{
+	conPrint("PhotoResizing::test()");
+
+	//------------------------ Test filter taps ------------------------
+	{
+		// Downsampling by 2: each dest pixel should use the 4 nearest source pixels, with weights summing to 1.
+		FilterTaps taps;
+		computeFilterTaps(/*src_begin=*/10, /*src_len=*/100, /*dst_len=*/50, taps);
+		testAssert(taps.first_tap[0] == 10); // Clamped to region start
+		testAssert(taps.first_tap[10] == 29 && taps.num_taps[10] == 4); // Centre is at 31
+		for(int d=0; d<50; ++d)
+		{
+			float sum = 0;
+			for(int i=0; i<taps.num_taps[d]; ++i)
+				sum += taps.weights[taps.weights_offset[d] + i];
+			testAssert(std::fabs(sum - 1.f) < 1.0e-5f);
+			testAssert(taps.first_tap[d] >= 10 && taps.first_tap[d] + taps.num_taps[d] <= 110);
+		}
+
+		// Same size: should just copy
+		computeFilterTaps(0, 20, 20, taps);
+		for(int d=0; d<20; ++d)
+		{
+			for(int i=0; i<taps.num_taps[d]; ++i)
+				testAssert(taps.weights[taps.weights_offset[d] + i] == ((taps.first_tap[d] + i == d) ? 1.f : 0.f));
+		}
+	}
+
+	//------------------------ Test resizing a constant image gives the same constant ------------------------
+	for(size_t N=3; N<=4; ++N)
+	{
+		ImageMapUInt8Ref src = new ImageMapUInt8(301, 207, N);
+		for(size_t i=0; i<src->getWidth() * src->getHeight(); ++i)
+		{
+			src->getPixel(i)[0] = 10;
+			src->getPixel(i)[1] = 128;
+			src->getPixel(i)[2] = 255;
+			if(N == 4)
+				src->getPixel(i)[3] = 0;
+		}
+
+		std::vector<ResizeOutput> outputs;
+		outputs.push_back(ResizeOutput(0, 0, 301, 207, /*dst_w=*/100, /*dst_h=*/69));
+		outputs.push_back(ResizeOutput(50, 20, 200, 150, /*dst_w=*/230, /*dst_h=*/172)); // Upsampling crop
+		resizeToOutputs(*src, outputs, /*task_manager=*/NULL);
+
+		for(size_t z=0; z<outputs.size(); ++z)
+		{
+			const ImageMapUInt8& res = *outputs[z].result;
+			testAssert((int)res.getWidth() == outputs[z].dst_w && (int)res.getHeight() == outputs[z].dst_h && res.getN() == 3);
+			for(size_t i=0; i<res.getWidth() * res.getHeight(); ++i)
+				testAssert(res.getPixel(i)[0] == 10 && res.getPixel(i)[1] == 128 && res.getPixel(i)[2] == 255);
+		}
+	}
+
+	//------------------------ Test greyscale images are expanded to RGB ------------------------
+	{
+		ImageMapUInt8Ref src = new ImageMapUInt8(64, 48, 1);
+		for(size_t i=0; i<src->getDataSize(); ++i)
+			src->getData()[i] = 77;
+
+		std::vector<ResizeOutput> outputs(1, ResizeOutput(0, 0, 64, 48, 23, 17));
+		resizeToOutputs(*src, outputs, NULL);
+		for(size_t i=0; i<23*17; ++i)
+			testAssert(outputs[0].result->getPixel(i)[0] == 77 && outputs[0].result->getPixel(i)[1] == 77 && outputs[0].result->getPixel(i)[2] == 77);
+	}
+
+	//------------------------ Test crop region is respected ------------------------
+	{
+		// Left half black, right half white.  Cropping to the right half should give all white.
+		ImageMapUInt8Ref src = new ImageMapUInt8(200, 100, 3);
+		for(size_t y=0; y<100; ++y)
+		for(size_t x=0; x<200; ++x)
+			for(int c=0; c<3; ++c)
+				src->getPixel(x, y)[c] = (x < 100) ? 0 : 255;
+
+		std::vector<ResizeOutput> outputs(1, ResizeOutput(100, 0, 100, 100, 30, 30));
+		resizeToOutputs(*src, outputs, NULL);
+		for(size_t i=0; i<30*30; ++i)
+			testAssert(outputs[0].result->getPixel(i)[0] == 255);
+	}
+
+	//------------------------ Test task manager results are the same as single-threaded results ------------------------
+	{
+		glare::TaskManager task_manager("PhotoResizing test task manager", 4);
+
+		PCG32 rng(1);
+		ImageMapUInt8Ref src = makeRandomImage(rng, 1234, 567, 3);
+
+		std::vector<ResizeOutput> outputs_a, outputs_b;
+		outputs_a.push_back(ResizeOutput(0, 0, 1234, 567, 1000, 459));
+		outputs_a.push_back(ResizeOutput(239, 0, 756, 567, 230, 172));
+		outputs_b = outputs_a;
+
+		resizeToOutputs(*src, outputs_a, NULL);
+		resizeToOutputs(*src, outputs_b, &task_manager);
+		for(size_t z=0; z<outputs_a.size(); ++z)
+			testAssert(std::memcmp(outputs_a[z].result->getData(), outputs_b[z].result->getData(), outputs_a[z].result->getDataSize()) == 0);
+	}
+
+	//------------------------ Test invalid regions ------------------------
+	{
+		ImageMapUInt8Ref src = new ImageMapUInt8(100, 100, 3);
+		src->zero();
+		std::vector<ResizeOutput> outputs(1, ResizeOutput(50, 0, 51, 100, 10, 10));
+		testThrowsExcepContainingString([&]() { resizeToOutputs(*src, outputs, NULL); }, "Invalid source region");
+		outputs[0] = ResizeOutput(0, 0, 100, 100, 0, 10);
+		testThrowsExcepContainingString([&]() { resizeToOutputs(*src, outputs, NULL); }, "Invalid destination size");
+
+		ImageMapUInt8Ref two_channel = new ImageMapUInt8(100, 100, 2);
+		outputs[0] = ResizeOutput(0, 0, 100, 100, 10, 10);
+		testThrowsExcepContainingString([&]() { resizeToOutputs(*two_channel, outputs, NULL); }, "Invalid number of channels");
+	}
+
+	//------------------------ Test makeCentreCroppedOutput ------------------------
+	{
+		ResizeOutput output = makeCentreCroppedOutput(3000, 4000, 230, 172); // Portrait image: top and bottom should be cropped off.
+		testAssert(output.src_x == 0 && output.src_w == 3000);
+		testAssert(output.src_h == (int)(3000.0 * 172 / 230) && output.src_y == (4000 - output.src_h) / 2);
+		testAssert(output.dst_w == 230 && output.dst_h == 172);
+
+		output = makeCentreCroppedOutput(4000, 1000, 230, 172); // Wide image: left and right should be cropped off.
+		testAssert(output.src_y == 0 && output.src_h == 1000);
+		testAssert(output.src_w == (int)(1000.0 * 230 / 172) && output.src_x == (4000 - output.src_w) / 2);
+	}
+
+	//------------------------ Throughput benchmark ------------------------
+	// Resize a 12 MP portrait phone photo to the mid-size and the centre-cropped thumbnail, as done for photo uploads.
+	// This is slow, so isn't run as part of the normal test suite.
+	const bool run_benchmark = false;
+	if(run_benchmark)
+	{
+		glare::TaskManager task_manager("PhotoResizing test task manager", myClamp<size_t>(PlatformUtils::getNumLogicalProcessors(), 1, 8));
+
+		PCG32 rng(1);
+		ImageMapUInt8Ref src = makeRandomImage(rng, 3000, 4000, 3);
+		const double src_MP = 3000 * 4000 * 1.0e-6;
+
+		const ResizeOutput thumb_output = makeCentreCroppedOutput(3000, 4000, 230, 172);
+
+		const int NUM_ITERS = 4;
+		{
+			Timer timer;
+			for(int i=0; i<NUM_ITERS; ++i)
+			{
+				Map2DRef midsize = src->resizeMidQuality(750, 1000, /*task_manager=*/nullptr);
+				ImageMapUInt8Ref cropped = src->cropImage(thumb_output.src_x, thumb_output.src_y, thumb_output.src_w, thumb_output.src_h);
+				Map2DRef thumb = cropped->resizeMidQuality(thumb_output.dst_w, thumb_output.dst_h, /*task_manager=*/nullptr);
+			}
+			const double elapsed = timer.elapsed() / NUM_ITERS;
+			conPrint("resizeMidQuality (single-threaded):         " + doubleToStringNSigFigs(elapsed * 1.0e3, 4) + " ms (" + doubleToStringNSigFigs(src_MP / elapsed, 4) + " MP/s)");
+		}
+
+		for(int use_task_manager=0; use_task_manager<2; ++use_task_manager)
+		{
+			Timer timer;
+			for(int i=0; i<NUM_ITERS; ++i)
+			{
+				std::vector<ResizeOutput> outputs;
+				outputs.push_back(ResizeOutput(0, 0, 3000, 4000, 750, 1000));
+				outputs.push_back(thumb_output);
+				resizeToOutputs(*src, outputs, use_task_manager ? &task_manager : NULL);
+			}
+			const double elapsed = timer.elapsed() / NUM_ITERS;
+			conPrint(std::string("resizeToOutputs (") + (use_task_manager ? "task manager):             " : "single-threaded):          ") +
+				doubleToStringNSigFigs(elapsed * 1.0e3, 4) + " ms (" + doubleToStringNSigFigs(src_MP / elapsed, 4) + " MP/s)");
+		}
+	}
+
+	conPrint("PhotoResizing::test() done.");
+}
+
+
+#endif // BUILD_TESTS
+
+
+} // end namespace PhotoResizing
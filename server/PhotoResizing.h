@@ -0,0 +1,67 @@
+/*=====================================================================
+PhotoResizing.h
+---------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#pragma once
+
+
+#include <graphics/ImageMap.h>
+#include <Platform.h>
+#include <string>
+#include <vector>
+namespace glare { class TaskManager; }
+
+
+/*=====================================================================
+PhotoResizing
+-------------
+Makes the resized versions (mid-size image, thumbnail) of uploaded photos.
+
+Resizing uses a separable triangle filter, with the filter width scaled by
+the downsampling factor so that every source pixel contributes to the result.
+Filtering is done on 4-wide float pixels with SSE.
+
+All outputs are resized in a single task group: each output is split into
+bands of rows, and each band is a task.  A band does the horizontal pass for
+just the source rows it needs, so no full-size intermediate image is allocated.
+=====================================================================*/
+namespace PhotoResizing
+{
+
+struct ResizeOutput
+{
+	ResizeOutput() {}
+	ResizeOutput(int src_x_, int src_y_, int src_w_, int src_h_, int dst_w_, int dst_h_) : src_x(src_x_), src_y(src_y_), src_w(src_w_), src_h(src_h_), dst_w(dst_w_), dst_h(dst_h_) {}
+
+	int src_x, src_y, src_w, src_h; // Region of the source image to resize.  Used for cropping.
+	int dst_w, dst_h;
+
+	ImageMapUInt8Ref result; // Set by resizeToOutputs().  Has 3 channels.
+};
+
+
+// Returns an output that crops the centre of a src_w x src_h image to the aspect ratio of dst_w x dst_h, and resizes it to dst_w x dst_h.
+ResizeOutput makeCentreCroppedOutput(int src_w, int src_h, int dst_w, int dst_h);
+
+
+// Resizes regions of src into each output.  src must have 1, 3 or 4 channels.  Greyscale is expanded to RGB, alpha is ignored.
+// Runs on task_manager if non-null, otherwise on the calling thread.
+// Throws glare::Exception if an output region is invalid.
+void resizeToOutputs(const ImageMapUInt8& src, std::vector<ResizeOutput>& outputs, glare::TaskManager* task_manager);
+
+
+struct JPEGToSave
+{
+	ImageMapUInt8Ref image;
+	std::string path;
+	int quality;
+};
+
+// Encodes and saves the images concurrently on task_manager, if non-null.  Throws glare::Exception if any save failed.
+void saveJPEGs(const std::vector<JPEGToSave>& jpegs, glare::TaskManager* task_manager);
+
+
+void test();
+
+} // end namespace PhotoResizing
@@ -11,6 +11,8 @@ Copyright Glare Technologies Limited 2023 -
 #include "MeshLODGenThread.h"
 #include "DynamicTextureUpdaterThread.h"
 #include "ChunkGenThread.h"
+#include "MapTilePyramidThread.h"
+#include "MapTilePyramid.h"
 #include "WorkerThread.h"
 #include "ServerTestSuite.h"
 #include "WorldCreation.h"
@@ -40,6 +42,7 @@ Copyright Glare Technologies Limited 2023 -
 #include <maths/Rect2.h>
 #include <graphics/BasisDecoder.h>
 #include <utils/ThreadManager.h>
+#include <utils/TaskManager.h>
 #include <utils/PlatformUtils.h>
 #include <utils/Clock.h>
 #include <utils/Timer.h>
@@ -58,12 +61,14 @@ Copyright Glare Technologies Limited 2023 -
 #endif
 
 
+// Adds a not-done tile screenshot for every map tile that doesn't exist yet.
+// Tiles at MapTilePyramid::MAX_TILE_Z are rendered by the screenshot bot, coarser tiles are built from them by MapTilePyramidThread.
 void updateMapTiles(ServerAllWorldsState& world_state)
 {
 	uint64 next_shot_id = world_state.getNextScreenshotUID();
 
 	const int z_begin = 0;
-	const int z_end = 7;
+	const int z_end = MapTilePyramid::MAX_TILE_Z + 1;
 	if(true) // world_state.map_tile_info.empty())
 	{
 		// world_state.map_tile_info.clear();
@@ -193,6 +198,9 @@ static ServerConfig parseServerConfig(const std::string& config_path)
 	config.allow_light_mapper_bot_full_perms	= XMLParseUtils::parseBoolWithDefault(root_elem, "allow_light_mapper_bot_full_perms", /*default val=*/false);
 	config.update_parcel_sales					= XMLParseUtils::parseBoolWithDefault(root_elem, "update_parcel_sales", /*default val=*/false);
 	config.do_lua_http_request_rate_limiting	= XMLParseUtils::parseBoolWithDefault(root_elem, "do_lua_http_request_rate_limiting", /*default val=*/true);
+	config.lua_http_max_concurrent_requests_per_user	= XMLParseUtils::parseIntWithDefault(root_elem, "lua_http_max_concurrent_requests_per_user", /*default val=*/2);
+	config.lua_http_max_concurrent_requests_per_host	= XMLParseUtils::parseIntWithDefault(root_elem, "lua_http_max_concurrent_requests_per_host", /*default val=*/4);
+	config.lua_http_response_cache_max_age_s			= XMLParseUtils::parseDoubleWithDefault(root_elem, "lua_http_response_cache_max_age_s", /*default val=*/0.0);
 	config.enable_LOD_chunking					= XMLParseUtils::parseBoolWithDefault(root_elem, "enable_LOD_chunking", /*default val=*/true);
 	return config;
 }
@@ -383,6 +391,23 @@ int main(int argc, char *argv[])
 			server.world_state->resource_manager->getResourcesForURL().clear();
 		}
 
+		// Load the derived-asset store, then remove entries (and delete the output files) for outputs that are no longer used by any resource.
+		// Don't garbage collect if the resources weren't loaded, as then no outputs would appear to be used.
+		const std::string derived_asset_store_path = server_state_dir + "/derived_assets.bin";
+		if(FileUtils::fileExists(derived_asset_store_path))
+		{
+			try
+			{
+				server.world_state->resource_manager->loadDerivedAssetStore(derived_asset_store_path);
+				if(!parsed_args.isArgPresent("--do_not_load_resources"))
+					server.world_state->resource_manager->garbageCollectDerivedAssets();
+			}
+			catch(glare::Exception& e)
+			{
+				conPrint("WARNING: Error while loading derived-asset store: " + e.what());
+			}
+		}
+
 
 		WorldCreation::createParcelsAndRoads(server.world_state);
 
@@ -530,6 +555,8 @@ int main(int argc, char *argv[])
 
 		server.dyn_tex_updater_thread_manager.addThread(new DynamicTextureUpdaterThread(&server, server.world_state.ptr()));
 
+		thread_manager.addThread(new MapTilePyramidThread(&server, server.world_state.ptr()));
+
 		server.lua_http_manager = new LuaHTTPRequestManager(&server);
 
 		//----------------------------------------------- Create any Lua scripts for objects -----------------------------------------------
@@ -587,6 +614,7 @@ int main(int argc, char *argv[])
 		//----------------------------------------------- End create any Lua scripts for objects -----------------------------------------------
 
 		Timer save_state_timer;
+		Timer save_derived_asset_store_timer;
 
 		// A map from world name to a vector of packets to send to clients connected to that world.
 		std::map<std::string, std::vector<std::string>> broadcast_packets;
@@ -617,24 +645,19 @@ int main(int argc, char *argv[])
 						LuaScriptEvaluator* script_evaluator = timer.lua_script_evaluator.getPtrIfAlive();
 						if(script_evaluator)
 						{
-							// Check timer is still valid (has not been destroyed by destroyTimer), by checking the timer id with the same index is still equal to our timer id.
+							// Check timer is still valid (has not been destroyed by destroyTimer, possibly in an earlier timer callback in this loop), by checking the timer id with the same index is still equal to our timer id.
 							assert(timer.timer_index >= 0 && timer.timer_index <= LuaScriptEvaluator::MAX_NUM_TIMERS);
 							if(timer.timer_id == script_evaluator->timers[timer.timer_index].id)
 							{
 								script_evaluator->doOnTimerEvent(timer.onTimerEvent_ref, lock); // Execute the Lua timer event callback function
 
-								if(timer.repeating)
-								{
-									// Re-insert timer with updated trigger time
-									timer.tigger_time = cur_time + timer.period;
-									server.timer_queue.addTimer(cur_time, timer);
-								}
-								else // Else if timer was a one-shot timer, 'destroy' it.
-								{
+								// Repeating timers are rescheduled by the timer queue.  If timer was a one-shot timer, 'destroy' it.
+								if(!timer.repeating && (timer.timer_id == script_evaluator->timers[timer.timer_index].id))
 									script_evaluator->destroyTimer(timer.timer_index);
-								}
 							}
 						}
+						else
+							server.timer_queue.removeTimer(timer.handle); // Script evaluator has been destroyed, remove the timer if it is repeating.
 					}
 				}
 
@@ -879,6 +902,9 @@ int main(int argc, char *argv[])
 					}
 
 
+					// Update hot object data for changed objects, before the dirty-from-remote set is cleared below.
+					world_state->updateObjectHotTableForDirtyObjects(lock);
+
 					// Generate packets for object changes
 					ServerWorldState::DirtyFromRemoteObjectSetType& dirty_from_remote_objects = world_state->getDirtyFromRemoteObjects(lock);
 					for(auto i = dirty_from_remote_objects.begin(); i != dirty_from_remote_objects.end(); ++i)
@@ -927,6 +953,7 @@ int main(int argc, char *argv[])
 								server.world_state->db_records_to_delete.insert(ob->database_key);
 
 								// Remove ob from object map
+								world_state->removeObjectFromHotTable(ob->uid, lock);
 								world_state->getObjects(lock).erase(ob->uid);
 
 								conPrint("Removed object from world_state->objects");
@@ -991,7 +1018,7 @@ int main(int argc, char *argv[])
 							// Send ObjectLightmapURLChanged packet
 							MessageUtils::initPacket(scratch_packet, Protocol::ObjectLightmapURLChanged);
 							writeToStream(ob->uid, scratch_packet);
-							scratch_packet.writeStringLengthFirst(ob->lightmap_url);
+							scratch_packet.writeStringLengthFirst(ob->lightmap_url.str());
 
 							enqueueMessageToBroadcast(scratch_packet, world_packets);
 
@@ -1003,7 +1030,7 @@ int main(int argc, char *argv[])
 							// Send ObjectModelURLChanged packet
 							MessageUtils::initPacket(scratch_packet, Protocol::ObjectModelURLChanged);
 							writeToStream(ob->uid, scratch_packet);
-							scratch_packet.writeStringLengthFirst(ob->model_url);
+							scratch_packet.writeStringLengthFirst(ob->model_url.str());
 
 							enqueueMessageToBroadcast(scratch_packet, world_packets);
 
@@ -1125,6 +1152,12 @@ int main(int argc, char *argv[])
 				if(isFeatureFlagSet(server.world_state, ServerAllWorldsState::DO_WORLD_MAINTENANCE_FEATURE_FLAG))
 					WorldMaintenance::removeOldVehicles(server.world_state);
 
+			if((loop_iter % 1024) == 256) // Approx every 100 s.
+				URLAtomTable::getGlobalTable().removeUnreferencedAtoms(); // Remove URLs no longer used by any object or material.
+
+			if((loop_iter % 32768) == 128) // Approx every hour.
+				WorldMaintenance::removeExpiredWebSessions(server.world_state);
+
 			if(server.world_state->hasChanged() && (save_state_timer.elapsed() > 10.0))
 			{
 				try
@@ -1144,6 +1177,19 @@ int main(int argc, char *argv[])
 				}
 			}
 
+			if(server.world_state->resource_manager->derivedAssetStoreHasChanged() && (save_derived_asset_store_timer.elapsed() > 60.0))
+			{
+				try
+				{
+					server.world_state->resource_manager->saveDerivedAssetStore(derived_asset_store_path);
+				}
+				catch(glare::Exception& e)
+				{
+					conPrint("Warning: saving derived-asset store to disk failed: " + e.what());
+				}
+				save_derived_asset_store_timer.reset();
+			}
+
 			loop_iter++;
 
 			//if(loop_iter > 100) // TEMP: test shutting down
@@ -1166,6 +1212,18 @@ int main(int argc, char *argv[])
 			conPrint("Warning: saving world state to disk failed: " + e.what());
 		}
 
+		if(server.world_state->resource_manager->derivedAssetStoreHasChanged())
+		{
+			try
+			{
+				server.world_state->resource_manager->saveDerivedAssetStore(derived_asset_store_path);
+			}
+			catch(glare::Exception& e)
+			{
+				conPrint("Warning: saving derived-asset store to disk failed: " + e.what());
+			}
+		}
+
 		// Shut down threads in reverse order of creation
 		conPrint("Stopping threads...");
 
@@ -1192,6 +1250,8 @@ int main(int argc, char *argv[])
 Server::Server()
 {
 	world_state = new ServerAllWorldsState();
+
+	photo_task_manager = new glare::TaskManager("photo task manager", myClamp<size_t>(PlatformUtils::getNumLogicalProcessors() / 2, 1, 8));
 }
 
 
@@ -1205,6 +1265,8 @@ Server::~Server()
 	mesh_lod_gen_thread_manager.killThreadsBlocking();
 	worker_thread_manager.killThreadsBlocking();
 
+	delete photo_task_manager;
+
 	lua_http_manager = nullptr;
 
 	message_queue.clear();
@@ -18,12 +18,13 @@ class WorkerThread;
 class SubstrataLuaVM;
 class LuaHTTPRequestManager;
 class LuaHTTPRequest;
+namespace glare { class TaskManager; }
 
 
 class ServerConfig
 {
 public:
-	ServerConfig() : allow_light_mapper_bot_full_perms(false), update_parcel_sales(false), do_lua_http_request_rate_limiting(true), enable_LOD_chunking(true) {}
+	ServerConfig() : allow_light_mapper_bot_full_perms(false), update_parcel_sales(false), do_lua_http_request_rate_limiting(true), lua_http_max_concurrent_requests_per_user(2), lua_http_max_concurrent_requests_per_host(4), lua_http_response_cache_max_age_s(0), enable_LOD_chunking(true) {}
 	
 	std::string webserver_fragments_dir; // empty string = use default.
 	std::string webserver_public_files_dir; // empty string = use default.
@@ -37,6 +38,9 @@ public:
 	bool update_parcel_sales; // Should we run auctions?
 
 	bool do_lua_http_request_rate_limiting; // Should we rate-limit HTTP requests made by Lua scripts?
+	int lua_http_max_concurrent_requests_per_user; // Max number of HTTP requests by scripts of a single user that may be in flight at once.
+	int lua_http_max_concurrent_requests_per_host; // Max number of HTTP requests by Lua scripts to a single host that may be in flight at once.
+	double lua_http_response_cache_max_age_s; // How long successful GET responses to Lua script HTTP requests are cached for.  0 = don't cache (the default).
 
 	bool enable_LOD_chunking; // Should we generate LOD chunks?
 };
@@ -168,4 +172,6 @@ public:
 	std::vector<TimerQueueTimer> temp_triggered_timers;
 
 	Reference<LuaHTTPRequestManager> lua_http_manager;
+
+	glare::TaskManager* photo_task_manager; // For resizing and encoding uploaded photos.  Shared by all worker threads.
 };
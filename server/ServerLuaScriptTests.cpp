@@ -22,6 +22,7 @@ Copyright Glare Technologies Limited 2024 -
 #include <utils/ConPrint.h>
 #include <utils/StringUtils.h>
 #include <utils/TestUtils.h>
+#include <utils/Timer.h>
 #include <utils/TestExceptionUtils.h>
 #include <lualib.h>
 
@@ -87,6 +88,19 @@ void ServerLuaScriptTests::test()
 			Reference<LuaScriptEvaluator> lua_script_evaluator = new LuaScriptEvaluator(&vm, &output_handler, "print('hello')", world_ob.ptr(), main_world_state.ptr(), lock);
 		}
 
+		//-------------------------------- Test the VM keeps track of its script evaluators --------------------------------
+		{
+			testAssert(vm.script_evaluators.empty());
+			{
+				Reference<LuaScriptEvaluator> lua_script_evaluator = new LuaScriptEvaluator(&vm, &output_handler, "print('hello')", world_ob.ptr(), main_world_state.ptr(), lock);
+				Reference<LuaScriptEvaluator> lua_script_evaluator2 = new LuaScriptEvaluator(&vm, &output_handler, "print('hello')", world_ob2.ptr(), main_world_state.ptr(), lock);
+				testAssert(vm.script_evaluators.size() == 2);
+				testAssert(vm.script_evaluators[lua_script_evaluator.ptr()] == world_ob->uid);
+				testAssert(vm.script_evaluators[lua_script_evaluator2.ptr()] == world_ob2->uid);
+			}
+			testAssert(vm.script_evaluators.empty());
+		}
+
 		//-------------------------------- Test this_object --------------------------------
 		{
 			const std::string script_src = "print('this_object.uid: ' .. tostring(this_object.uid))  assert(this_object.uid == 123.0)\n";
@@ -239,6 +253,56 @@ void ServerLuaScriptTests::test()
 			testAssert(output_handler.buf == "Avatar 456 exited vehicle 123");
 		}
 
+		//-------------------------------- Test execution time budget --------------------------------
+		// A callback that runs forever should be aborted, and the script should be throttled rather than disabled.
+		{
+			const std::string script_src = 
+				"function onUserTouchedObject(av : Avatar, ob : Object)		\n"
+				"		while true do end									\n"
+				"end														";
+
+			WorldObjectRef temp_world_ob = new WorldObject();
+			temp_world_ob->uid = UID(201);
+			main_world_state->getObjects(lock)[temp_world_ob->uid] = temp_world_ob;
+
+			Reference<LuaScriptEvaluator> lua_script_evaluator = new LuaScriptEvaluator(&vm, &output_handler, script_src, temp_world_ob.ptr(), main_world_state.ptr(), lock);
+			testAssert(lua_script_evaluator->exec_stats.num_callbacks == 1); // Initial execution
+
+			const int func_ref = temp_world_ob->getOrCreateEventHandlers()->onUserTouchedObject_handlers.handler_funcs[0].handler_func_ref;
+
+			Timer timer;
+			lua_script_evaluator->doOnUserTouchedObject(func_ref, avatar->uid, temp_world_ob->uid, lock);
+			testAssert(timer.elapsed() < 1.0);
+			testAssert(!lua_script_evaluator->hit_error);
+			testAssert(lua_script_evaluator->exec_stats.num_callbacks == 2);
+			testAssert(lua_script_evaluator->exec_stats.num_budget_overruns == 1);
+			testAssert(lua_script_evaluator->exec_stats.num_throttle_events == 1);
+			testAssert(lua_script_evaluator->exec_stats.total_exec_time_s >= LuaScriptEvaluator::CALLBACK_TIME_BUDGET_S);
+			testAssert(lua_script_evaluator->isThrottled());
+
+			// Callbacks should be skipped while throttled.
+			lua_script_evaluator->doOnUserTouchedObject(func_ref, avatar->uid, temp_world_ob->uid, lock);
+			testAssert(lua_script_evaluator->exec_stats.num_callbacks == 2);
+			testAssert(lua_script_evaluator->exec_stats.num_throttled_callbacks == 1);
+
+			// After MAX_NUM_THROTTLE_EVENTS throttle events, the script should be suspended.
+			for(int i=1; i<LuaScriptEvaluator::MAX_NUM_THROTTLE_EVENTS; ++i)
+			{
+				lua_script_evaluator->throttled_until_time = 0; // Skip throttle period
+				lua_script_evaluator->doOnUserTouchedObject(func_ref, avatar->uid, temp_world_ob->uid, lock);
+			}
+			testAssert(lua_script_evaluator->exec_stats.num_throttle_events == LuaScriptEvaluator::MAX_NUM_THROTTLE_EVENTS);
+			testAssert(lua_script_evaluator->hit_error);
+
+			main_world_state->getObjects(lock).erase(temp_world_ob->uid);
+		}
+
+		// The Lua heap size should be tracked.
+		{
+			testAssert(vm.getHeapSizeB() > 0);
+			testAssert(vm.peak_heap_size_B >= vm.getHeapSizeB());
+		}
+
 		//-------------------------------- Test doOnTimerEvent --------------------------------
 
 		// The script creates a timer, then we call it.
@@ -9,9 +9,27 @@ Copyright Glare Technologies Limited 2023 -
 #include "AccountHandlers.h"
 #include "ServerLuaScriptTests.h"
 #include "SubEvent.h"
+#include "DynamicTextureUpdaterThread.h"
+#include "LuaHTTPRequestManager.h"
+#include "MapTilePyramid.h"
+#include "PhotoResizing.h"
+#include "WebSessionStore.h"
+#include "ObjectHotTable.h"
+#include "BasisEncodingService.h"
+#include "../webserver/WebPageCache.h"
+#include "../webserver/ImageFileCache.h"
+#include "../webserver/WebDataStore.h"
+#include "../webserver/WebRouter.h"
+#include "../webserver/WebServerResponseUtils.h"
+#include "../webserver/Pagination.h"
+#include "../webserver/WebServerRequestHandlerTests.h"
 #include "../shared/WorldObject.h"
+#include "../shared/URLAtom.h"
 #include "../shared/RateLimiter.h"
 #include "../shared/LODGeneration.h"
+#include "../shared/TextureDownsampling.h"
+#include "../shared/DecodedImageCache.h"
+#include "../shared/ResourceManager.h"
 #include "../ethereum/RLP.h"
 #include "../ethereum/Signing.h"
 #include "../ethereum/Infura.h"
@@ -105,6 +123,8 @@ void ServerTestSuite::test()
 	runTest([&]() { glare::testArray();													});
 	runTest([&]() { BasisDecoder::test();												});
 	runTest([&]() { WorldObject::test();												});
+	runTest([&]() { URLAtomTable::test();												});
+	runTest([&]() { ObjectHotTable::test();												});
 	runTest([&]() { testLRUCache();														});
 	runTest([&]() { TimeStamp::test();													});
 	runTest([&]() { SubEvent::test();													});
@@ -126,6 +146,22 @@ void ServerTestSuite::test()
 	runTest([&]() { Keccak256::test();													});
 	runTest([&]() { WorldMaterial::test();												});
 	runTest([&]() { LODGeneration::test();												});
+	runTest([&]() { ResourceManager::test();											});
+	runTest([&]() { DynamicTextureUpdaterThread::test();								});
+	runTest([&]() { LuaHTTPRequestManager::test();									});
+	runTest([&]() { WebPageCache::test();											});
+	runTest([&]() { ImageFileCache::test();											});
+	runTest([&]() { WebDataStore::test();											});
+	runTest([&]() { WebRouter::test();												});
+	runTest([&]() { WebServerRequestHandlerTests::test();							});
+	runTest([&]() { WebServerResponseUtils::test();										});
+	runTest([&]() { Pagination::test();													});
+	runTest([&]() { MapTilePyramid::test();												});
+	runTest([&]() { PhotoResizing::test();												});
+	runTest([&]() { TextureDownsampling::test();										});
+	runTest([&]() { DecodedImageCache::test();										});
+	runTest([&]() { BasisEncodingService::test();										});
+	runTest([&]() { WebSessionStore::test();											});
 	runTest([&]() { WebSocketTests::test();												});
 	runTest([&]() { GIFDecoder::test();													}, /*mem leak allowed=*/true); // NOTE: leaks mem due to https://sourceforge.net/p/giflib/bugs/165/
 	runTest([&]() { PNGDecoder::test(".");												});
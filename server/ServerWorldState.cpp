@@ -69,6 +69,30 @@ void readServerWorldStateFromStream(RandomAccessInStream& stream, ServerWorldSta
 }
 
 
+ObjectHotTable& ServerWorldState::getObjectHotTable(WorldStateLock& /*world_state_lock*/)
+{
+	// The dirty-from-remote set is cleared every main loop iteration, so is small.
+	for(auto it = dirty_from_remote_objects.begin(); it != dirty_from_remote_objects.end(); ++it)
+		object_hot_table.updateObject(it->ptr());
+
+	if(object_hot_table.size() != objects.size())
+		object_hot_table.rebuild(objects);
+
+	return object_hot_table;
+}
+
+
+void ServerWorldState::updateObjectHotTableForDirtyObjects(WorldStateLock& /*world_state_lock*/)
+{
+	for(auto it = dirty_from_remote_objects.begin(); it != dirty_from_remote_objects.end(); ++it)
+		object_hot_table.updateObject(it->ptr());
+
+	for(auto it = db_dirty_world_objects.begin(); it != db_dirty_world_objects.end(); ++it)
+		if((*it)->state != WorldObject::State_Dead)
+			object_hot_table.updateObject(it->ptr());
+}
+
+
 ServerAllWorldsState::ServerAllWorldsState()
 :	lua_vms(/*empty key=*/UserID::invalidUserID())
 {
@@ -95,6 +119,11 @@ ServerAllWorldsState::ServerAllWorldsState()
 	read_only_mode = false;
 
 	force_dyn_tex_update = false;
+
+	parcel_auctions_version = 0;
+	news_posts_version = 0;
+	events_version = 0;
+	photos_version = 0;
 }
 
 
@@ -147,7 +176,7 @@ static const uint32 EOS_CHUNK = 1000;
 
 
 static const uint32 PARCEL_SALE_UPDATE_VERSION = 1;
-static const uint32 MAP_TILE_INFO_VERSION = 1;
+static const uint32 MAP_TILE_INFO_VERSION = 2; // 2: Added pyramid_dirty_tiles
 static const uint32 ETH_INFO_CHUNK_VERSION = 1;
 static const uint32 FEATURE_FLAG_CHUNK_VERSION = 1;
 static const uint32 OBJECT_STORAGE_ITEM_VERSION = 1;
@@ -181,6 +210,8 @@ void ServerAllWorldsState::readFromDisk(const std::string& path)
 	size_t num_worlds = 0;
 	size_t num_photos = 0;
 
+	std::vector<UserWebSessionRef> loaded_sessions;
+
 	bool is_pre_database_format = false;
 	{
 		FileInStream stream(path);
@@ -341,7 +372,7 @@ void ServerAllWorldsState::readFromDisk(const std::string& path)
 					readFromStream(stream, *session);
 
 					session->database_key = database_key;
-					user_web_sessions[session->id] = session; // Add to session map
+					loaded_sessions.push_back(session); // Added to web_sessions once all users are loaded.
 					num_sessions++;
 				}
 				else if(chunk == PARCEL_AUCTION_CHUNK)
@@ -475,7 +506,7 @@ void ServerAllWorldsState::readFromDisk(const std::string& path)
 				else if(chunk == MAP_TILE_INFO_CHUNK)
 				{
 					const uint32 map_tile_info_version = stream.readInt32();
-					if(map_tile_info_version != MAP_TILE_INFO_VERSION)
+					if(map_tile_info_version < 1 || map_tile_info_version > MAP_TILE_INFO_VERSION)
 						throw glare::Exception("invalid map_tile_info_version: " + toString(map_tile_info_version));
 
 					const int num_tiles = stream.readInt32();
@@ -502,6 +533,18 @@ void ServerAllWorldsState::readFromDisk(const std::string& path)
 						map_tile_info.info[Vec3<int>(x, y, z)] = tile_info; // Insert
 					}
 
+					if(map_tile_info_version >= 2)
+					{
+						const int num_dirty_tiles = stream.readInt32();
+						for(int i=0; i<num_dirty_tiles; ++i)
+						{
+							const int x = stream.readInt32();
+							const int y = stream.readInt32();
+							const int z = stream.readInt32();
+							map_tile_info.pyramid_dirty_tiles.insert(Vec3<int>(x, y, z));
+						}
+					}
+
 					map_tile_info.database_key = database_key;
 
 					num_tiles_read = num_tiles;
@@ -646,7 +689,7 @@ void ServerAllWorldsState::readFromDisk(const std::string& path)
 				UserWebSessionRef session = new UserWebSession();
 				readFromStream(stream, *session);
 
-				user_web_sessions[session->id] = session; // Add to session map
+				loaded_sessions.push_back(session); // Added to web_sessions once all users are loaded.
 				num_sessions++;
 			}
 			else if(chunk == PARCEL_AUCTION_CHUNK)
@@ -698,7 +741,7 @@ void ServerAllWorldsState::readFromDisk(const std::string& path)
 			else if(chunk == MAP_TILE_INFO_CHUNK)
 			{
 				const uint32 map_tile_info_version = stream.readInt32();
-				if(map_tile_info_version != MAP_TILE_INFO_VERSION)
+				if(map_tile_info_version < 1 || map_tile_info_version > MAP_TILE_INFO_VERSION)
 					throw glare::Exception("invalid map_tile_info_version: " + toString(map_tile_info_version));
 
 				const int num_tiles = stream.readInt32();
@@ -724,6 +767,18 @@ void ServerAllWorldsState::readFromDisk(const std::string& path)
 
 					map_tile_info.info[Vec3<int>(x, y, z)] = tile_info; // Insert
 				}
+
+				if(map_tile_info_version >= 2)
+				{
+					const int num_dirty_tiles = stream.readInt32();
+					for(int i=0; i<num_dirty_tiles; ++i)
+					{
+						const int x = stream.readInt32();
+						const int y = stream.readInt32();
+						const int z = stream.readInt32();
+						map_tile_info.pyramid_dirty_tiles.insert(Vec3<int>(x, y, z));
+					}
+				}
 				num_tiles_read = num_tiles;
 			}
 			else if(chunk == EOS_CHUNK)
@@ -739,6 +794,13 @@ void ServerAllWorldsState::readFromDisk(const std::string& path)
 		this->migration_version_info.migration_version = 0;
 	}
 
+	// Add loaded sessions to the session store, with the name of the session user.
+	for(size_t i=0; i<loaded_sessions.size(); ++i)
+	{
+		const auto user_res = user_id_to_users.find(loaded_sessions[i]->user_id);
+		web_sessions.addSession(loaded_sessions[i], (user_res != user_id_to_users.end()) ? user_res->second->name : std::string());
+	}
+
 
 	// If we were loading the old pre-database format:
 	if(is_pre_database_format)
@@ -806,8 +868,11 @@ void ServerAllWorldsState::addEverythingToDirtySets()
 			world_state->getDBDirtyParcels(lock).insert(it->second);
 	}
 
-	for(auto it = user_web_sessions.begin(); it != user_web_sessions.end(); ++it)
-		db_dirty_userwebsessions.insert(it->second);
+	{
+		std::vector<UserWebSessionRef> sessions;
+		web_sessions.getAllSessions(sessions);
+		db_dirty_userwebsessions.insert(sessions.begin(), sessions.end());
+	}
 
 	for(auto it = parcel_auctions.begin(); it != parcel_auctions.end(); ++it)
 		db_dirty_parcel_auctions.insert(it->second);
@@ -838,6 +903,9 @@ void ServerAllWorldsState::clearAndReset() // Just for fuzzing
 	Lock lock(mutex);
 	next_object_uid = UID(0);
 	next_avatar_uid = UID(0);
+	web_page_cache.clear();
+	image_file_cache.clear();
+	decoded_image_cache.clear();
 }
 
 
@@ -870,10 +938,14 @@ void ServerAllWorldsState::denormaliseData()
 				i->second->creator_name = res->second->name;
 		}
 
+		world_state->parcel_ids_by_owner.clear();
+
 		for(auto i=world_state->getParcels(lock).begin(); i != world_state->getParcels(lock).end(); ++i)
 		{
 			Parcel* parcel = i->second.ptr();
 
+			world_state->parcel_ids_by_owner[parcel->owner_id].push_back(parcel->id); // Parcels are iterated in id order, so the id vectors stay sorted.
+
 			// Denormalise Parcel::owner_name
 			{
 				auto res = user_id_to_users.find(parcel->owner_id); // Lookup user from owner_id
@@ -1138,9 +1210,11 @@ void ServerAllWorldsState::saveSanitisedDatabase()
 
 		// Delete all UserWebSessions
 		{
-			for(auto i=user_web_sessions.begin(); i != user_web_sessions.end(); ++i)
+			std::vector<UserWebSessionRef> sessions;
+			web_sessions.getAllSessions(sessions);
+			for(auto i=sessions.begin(); i != sessions.end(); ++i)
 			{
-				UserWebSession* session = i->second.ptr();
+				UserWebSession* session = i->ptr();
 				assert(session->database_key.valid());
 				
 				db_records_to_delete.insert(session->database_key);
@@ -1618,6 +1692,14 @@ void ServerAllWorldsState::serialiseToDisk(WorldStateLock& lock)
 					writeScreenshotToStream(*tile_info.prev_tile_screenshot, temp_buf);
 			}
 
+			temp_buf.writeInt32((int)map_tile_info.pyramid_dirty_tiles.size());
+			for(auto it=map_tile_info.pyramid_dirty_tiles.begin(); it != map_tile_info.pyramid_dirty_tiles.end(); ++it)
+			{
+				temp_buf.writeInt32(it->x);
+				temp_buf.writeInt32(it->y);
+				temp_buf.writeInt32(it->z);
+			}
+
 			if(!map_tile_info.database_key.valid())
 				map_tile_info.database_key = database.allocUnusedKey(); // Get a new key
 
@@ -20,17 +20,25 @@ Copyright Glare Technologies Limited 2024 -
 #include "User.h"
 #include "Order.h"
 #include "UserWebSession.h"
+#include "WebSessionStore.h"
+#include "ObjectHotTable.h"
 #include "ParcelAuction.h"
 #include "Screenshot.h"
 #include "Photo.h"
 #include "SubEthTransaction.h"
+#include "../webserver/WebPageCache.h"
+#include "../webserver/ImageFileCache.h"
+#include "../shared/DecodedImageCache.h"
+#include "BasisEncodingService.h"
 #include <ThreadSafeRefCounted.h>
 #include <Platform.h>
 #include <Mutex.h>
+#include <AtomicInt.h>
 #include <Database.h>
 #include <CircularBuffer.h>
 #include <HashMap.h>
 #include <map>
+#include <set>
 #include <unordered_set>
 class ServerWorldState;
 class WebDataStore;
@@ -77,6 +85,7 @@ struct MapTileInfo
 	MapTileInfo() : db_dirty(false) {}
 
 	std::map<Vec3<int>, TileInfo> info;
+	std::set<Vec3<int>> pyramid_dirty_tiles; // Coarse tiles with a child tile that has changed since the tile was last built by MapTilePyramid.  Saved to the DB with the tile info.
 	DatabaseKey database_key;
 	bool db_dirty; // If true, there is a change that has not been saved to the DB.
 };
@@ -251,13 +260,28 @@ public:
 	
 	ParcelMapType parcels; // TODO: make private.  Lots of compile errors to fix when doing so.
 
+	// Secondary index of parcels by owner, with the parcel ids for each owner in ascending order.  Used for paginated admin listings.
+	// Rebuilt by ServerAllWorldsState::denormaliseData(), which is called after parcels are added, removed or change owner, so may briefly contain ids of removed parcels.
+	std::map<UserID, std::vector<ParcelID>> parcel_ids_by_owner;
+
 	DirtyFromRemoteObjectSetType&                           getDirtyFromRemoteObjects(WorldStateLock& /*world_state_lock*/) { return dirty_from_remote_objects; }
 	std::unordered_set<WorldObjectRef, WorldObjectRefHash>& getDBDirtyWorldObjects(WorldStateLock& /*world_state_lock*/) { return db_dirty_world_objects; }
 	std::unordered_set<ParcelRef, ParcelRefHash>&           getDBDirtyParcels(WorldStateLock& /*world_state_lock*/) { return db_dirty_parcels; }
 	std::unordered_set<LODChunkRef, LODChunkRefHash>&       getDBDirtyLODChunks(WorldStateLock& /*world_state_lock*/) { return db_dirty_lod_chunks; }
 
+	// Returns the table of hot object data (position, centroid, flags), for fast full-world scans.
+	// Objects in the dirty-from-remote set are updated in the table first, and the table is rebuilt if objects have been inserted or removed without going through
+	// the dirty set (e.g. on load from the DB).
+	ObjectHotTable& getObjectHotTable(WorldStateLock& world_state_lock);
+
+	// Updates the table for objects in the dirty-from-remote and DB-dirty sets.  Called from the server main loop before the dirty-from-remote set is cleared.
+	// Changes that only go through the DB-dirty set (e.g. flags or AABBs changed by the chunk and LOD generation threads) are picked up here.
+	void updateObjectHotTableForDirtyObjects(WorldStateLock& world_state_lock);
+	void removeObjectFromHotTable(const UID& uid, WorldStateLock& /*world_state_lock*/) { object_hot_table.removeObject(uid); }
+
 private:
 	ObjectMapType objects;
+	ObjectHotTable object_hot_table;
 	DirtyFromRemoteObjectSetType dirty_from_remote_objects; // TODO: could just use vector for this, and avoid duplicates by checking object dirty flag.
 	AvatarMapType avatars;
 	LODChunkMapType lod_chunks;
@@ -328,13 +352,13 @@ public:
 	void addResourceAsDBDirty(const ResourceRef resource)					REQUIRES(mutex) { db_dirty_resources.insert(resource); changed = 1; }
 	void addSubEthTransactionAsDBDirty(const SubEthTransactionRef trans)	REQUIRES(mutex) { db_dirty_sub_eth_transactions.insert(trans); changed = 1; }
 	void addOrderAsDBDirty(const OrderRef order)							REQUIRES(mutex) { db_dirty_orders.insert(order); changed = 1; }
-	void addParcelAuctionAsDBDirty(const ParcelAuctionRef parcel_auction)	REQUIRES(mutex) { db_dirty_parcel_auctions.insert(parcel_auction); changed = 1; }
+	void addParcelAuctionAsDBDirty(const ParcelAuctionRef parcel_auction)	REQUIRES(mutex) { db_dirty_parcel_auctions.insert(parcel_auction); changed = 1; parcel_auctions_version.increment(); }
 	void addUserWebSessionAsDBDirty(const UserWebSessionRef screenshot)		REQUIRES(mutex) { db_dirty_userwebsessions.insert(screenshot); changed = 1; }
 	void addScreenshotAsDBDirty(const ScreenshotRef screenshot)				REQUIRES(mutex) { db_dirty_screenshots.insert(screenshot); changed = 1; }
-	void addPhotoAsDBDirty(const PhotoRef photo)							REQUIRES(mutex) { db_dirty_photos.insert(photo); changed = 1; }
+	void addPhotoAsDBDirty(const PhotoRef photo)							REQUIRES(mutex) { db_dirty_photos.insert(photo); changed = 1; photos_version.increment(); }
 	void addUserAsDBDirty(const UserRef user)								REQUIRES(mutex) { db_dirty_users.insert(user); changed = 1; }
-	void addNewsPostAsDBDirty(const NewsPostRef post)						REQUIRES(mutex) { db_dirty_news_posts.insert(post); changed = 1; }
-	void addEventAsDBDirty(const SubEventRef event)							REQUIRES(mutex) { db_dirty_events.insert(event); changed = 1; }
+	void addNewsPostAsDBDirty(const NewsPostRef post)						REQUIRES(mutex) { db_dirty_news_posts.insert(post); changed = 1; news_posts_version.increment(); }
+	void addEventAsDBDirty(const SubEventRef event)							REQUIRES(mutex) { db_dirty_events.insert(event); changed = 1; events_version.increment(); }
 
 	void addEverythingToDirtySets();
 
@@ -354,7 +378,7 @@ public:
 	std::map<std::string, Reference<ServerWorldState> > world_states GUARDED_BY(mutex); // ServerWorldState contains WorldObjects and Parcels
 	Reference<ServerWorldState> root_world_state GUARDED_BY(mutex); // = world_states[""]
 
-	std::map<std::string, UserWebSessionRef> user_web_sessions GUARDED_BY(mutex); // Map from key to UserWebSession
+	WebSessionStore web_sessions; // Not guarded by mutex, has its own locking.
 	
 	std::map<uint32, ParcelAuctionRef> parcel_auctions GUARDED_BY(mutex); // ParcelAuction id to ParcelAuction
 
@@ -433,6 +457,18 @@ public:
 
 	std::unordered_set<DatabaseKey, DatabaseKeyHash>					db_records_to_delete			GUARDED_BY(mutex);
 
+	// Incremented when the corresponding content changes (see add*AsDBDirty above), to invalidate fragments in web_page_cache.
+	// Atomic so web request handlers can check them without holding mutex.
+	glare::AtomicInt parcel_auctions_version;
+	glare::AtomicInt news_posts_version;
+	glare::AtomicInt events_version;
+	glare::AtomicInt photos_version;
+
+	WebPageCache web_page_cache; // Rendered HTML fragments for public web pages.
+	ImageFileCache image_file_cache; // Recently served screenshot, map tile and photo files.
+	DecodedImageCache decoded_image_cache; // Decoded source textures, shared by MeshLODGenThread and ChunkGenThread.
+	BasisEncodingService basis_encoding_service; // Encodes Basis textures for MeshLODGenThread and ChunkGenThread, within a global encoder thread budget.
+
 	WebDataStore* web_data_store; // Since we pass around ServerAllWorldsState for all the web request handlers, just store a pointer to web_data_store so we can access it.
 
 	ServerCredentials server_credentials;
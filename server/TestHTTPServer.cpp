@@ -0,0 +1,187 @@
+/*=====================================================================
+TestHTTPServer.cpp
+------------------
+Copyright Glare Technologies Limited 2024 -
+=====================================================================*/
+#include "TestHTTPServer.h"
+
+
+#if BUILD_TESTS
+
+
+#include <WebListenerThread.h>
+#include <RequestInfo.h>
+#include <ResponseUtils.h>
+#include <ConPrint.h>
+#include <Lock.h>
+#include <StringUtils.h>
+#include <PlatformUtils.h>
+
+
+class TestHTTPServerRequestHandler : public web::RequestHandler
+{
+public:
+	virtual void handleRequest(const web::RequestInfo& request, web::ReplyInfo& reply_info) override
+	{
+		double delay_s;
+		{
+			Lock lock(state->mutex);
+			state->cur_num_concurrent_requests++;
+			state->max_num_concurrent_requests = myMax(state->max_num_concurrent_requests, state->cur_num_concurrent_requests);
+			delay_s = state->response_delay_s;
+		}
+
+		if(delay_s > 0)
+			PlatformUtils::Sleep((int)(delay_s * 1000));
+
+		bool if_modified_since_present = false;
+		for(size_t i=0; i<request.headers.size(); ++i)
+			if(StringUtils::equalCaseInsensitive(request.headers[i].key, "if-modified-since"))
+				if_modified_since_present = true;
+
+		std::string response;
+		{
+			Lock lock(state->mutex);
+
+			auto res = state->files.find(request.path);
+			if(res == state->files.end())
+			{
+				response = "HTTP/1.1 404 Not Found\r\n"
+					"Content-Length: 0\r\n"
+					"Connection: Keep-Alive\r\n"
+					"\r\n";
+			}
+			else
+			{
+				TestHTTPServerFile& file = res->second;
+				file.num_requests++;
+
+				if(if_modified_since_present && !file.modified_since_last_served)
+				{
+					response = "HTTP/1.1 304 Not Modified\r\n"
+						"Connection: Keep-Alive\r\n"
+						"\r\n";
+				}
+				else
+				{
+					response = "HTTP/1.1 200 OK\r\n"
+						"Content-Type: " + file.content_type + "\r\n"
+						"Content-Length: " + toString(file.data.size()) + "\r\n" +
+						(file.cache_control.empty() ? std::string() : ("Cache-Control: " + file.cache_control + "\r\n")) +
+						"Connection: Keep-Alive\r\n"
+						"\r\n" + 
+						file.data;
+
+					file.modified_since_last_served = false;
+					file.num_full_responses++;
+				}
+			}
+
+			state->cur_num_concurrent_requests--;
+		}
+
+		reply_info.socket->writeData(response.data(), response.size());
+	}
+
+	virtual void handleWebSocketConnection(const web::RequestInfo& request_info, Reference<SocketInterface>& socket) override
+	{}
+
+	Reference<TestHTTPServerState> state;
+};
+
+
+class TestHTTPServerSharedRequestHandler : public web::SharedRequestHandler
+{
+public:
+	virtual Reference<web::RequestHandler> getOrMakeRequestHandler() override // Factory method for request handler.  Called once per connection.
+	{
+		{
+			Lock lock(state->mutex);
+			state->num_connections++;
+		}
+
+		Reference<TestHTTPServerRequestHandler> h = new TestHTTPServerRequestHandler();
+		h->state = state;
+		return h;
+	}
+
+	Reference<TestHTTPServerState> state;
+};
+
+
+TestHTTPServer::TestHTTPServer(int port_)
+:	port(port_)
+{
+	state = new TestHTTPServerState();
+
+	shared_request_handler = new TestHTTPServerSharedRequestHandler();
+	shared_request_handler->state = state;
+
+	thread_manager.addThread(new web::WebListenerThread(port, shared_request_handler.ptr(), /*tls configuration=*/NULL));
+
+	PlatformUtils::Sleep(100); // Give the listener thread a chance to start listening.
+}
+
+
+TestHTTPServer::~TestHTTPServer()
+{
+	thread_manager.killThreadsBlocking();
+}
+
+
+std::string TestHTTPServer::getBaseURL() const
+{
+	return "http://localhost:" + toString(port);
+}
+
+
+void TestHTTPServer::setFile(const std::string& path, const std::string& data, const std::string& content_type, const std::string& cache_control)
+{
+	Lock lock(state->mutex);
+
+	TestHTTPServerFile& file = state->files[path]; // Creates if not present
+	file.data = data;
+	file.content_type = content_type;
+	file.cache_control = cache_control;
+	file.modified_since_last_served = true;
+}
+
+
+void TestHTTPServer::setResponseDelay(double delay_s)
+{
+	Lock lock(state->mutex);
+	state->response_delay_s = delay_s;
+}
+
+
+int TestHTTPServer::getNumRequests(const std::string& path)
+{
+	Lock lock(state->mutex);
+	auto res = state->files.find(path);
+	return (res != state->files.end()) ? res->second.num_requests : 0;
+}
+
+
+int TestHTTPServer::getNumFullResponses(const std::string& path)
+{
+	Lock lock(state->mutex);
+	auto res = state->files.find(path);
+	return (res != state->files.end()) ? res->second.num_full_responses : 0;
+}
+
+
+int TestHTTPServer::getNumConnections()
+{
+	Lock lock(state->mutex);
+	return state->num_connections;
+}
+
+
+int TestHTTPServer::getMaxNumConcurrentRequests()
+{
+	Lock lock(state->mutex);
+	return state->max_num_concurrent_requests;
+}
+
+
+#endif // BUILD_TESTS
@@ -0,0 +1,85 @@
+/*=====================================================================
+TestHTTPServer.h
+----------------
+Copyright Glare Technologies Limited 2024 -
+=====================================================================*/
+#pragma once
+
+
+#if BUILD_TESTS
+
+
+#include <RequestHandler.h>
+#include <ThreadManager.h>
+#include <ThreadSafeRefCounted.h>
+#include <Reference.h>
+#include <Mutex.h>
+#include <map>
+#include <string>
+class TestHTTPServerSharedRequestHandler;
+
+
+struct TestHTTPServerFile
+{
+	TestHTTPServerFile() : modified_since_last_served(true), num_requests(0), num_full_responses(0) {}
+
+	std::string data;
+	std::string content_type;
+	std::string cache_control; // Sent as Cache-Control header if non-empty.
+	bool modified_since_last_served;
+	int num_requests;
+	int num_full_responses; // Number of 200 responses (as opposed to 304 responses)
+};
+
+
+// State shared between the request handlers.
+class TestHTTPServerState : public ThreadSafeRefCounted
+{
+public:
+	TestHTTPServerState() : num_connections(0), cur_num_concurrent_requests(0), max_num_concurrent_requests(0), response_delay_s(0) {}
+
+	Mutex mutex;
+	std::map<std::string, TestHTTPServerFile> files	GUARDED_BY(mutex); // Map from path to file
+	int num_connections								GUARDED_BY(mutex);
+	int cur_num_concurrent_requests					GUARDED_BY(mutex);
+	int max_num_concurrent_requests					GUARDED_BY(mutex);
+	double response_delay_s							GUARDED_BY(mutex); // Requests will sleep for this long before responding, for testing concurrency.
+};
+
+
+/*=====================================================================
+TestHTTPServer
+--------------
+A local stand-in HTTP server, for testing code that makes outgoing HTTP requests,
+without hitting remote hosts.
+
+Serves files added with setFile() over plain HTTP on localhost.
+Supports If-Modified-Since: returns 304 Not Modified if the file has not been changed
+with setFile() since it was last sent in full.
+Counts connections, requests, and the maximum number of concurrent requests.
+=====================================================================*/
+class TestHTTPServer
+{
+public:
+	TestHTTPServer(int port);
+	~TestHTTPServer();
+
+	std::string getBaseURL() const; // e.g. "http://localhost:8123"
+
+	void setFile(const std::string& path, const std::string& data, const std::string& content_type, const std::string& cache_control = std::string());
+	void setResponseDelay(double delay_s);
+
+	int getNumRequests(const std::string& path);
+	int getNumFullResponses(const std::string& path);
+	int getNumConnections();
+	int getMaxNumConcurrentRequests();
+
+private:
+	int port;
+	Reference<TestHTTPServerState> state;
+	Reference<TestHTTPServerSharedRequestHandler> shared_request_handler;
+	ThreadManager thread_manager;
+};
+
+
+#endif // BUILD_TESTS
@@ -0,0 +1,230 @@
+/*=====================================================================
+WebSessionStore.cpp
+-------------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#include "WebSessionStore.h"
+
+
+#include <utils/IncludeXXHash.h>
+#include <mutex>
+
+
+WebSessionStore::WebSessionStore()
+{
+}
+
+
+WebSessionStore::~WebSessionStore()
+{
+}
+
+
+uint64 WebSessionStore::hashSessionID(const std::string& session_id)
+{
+	return XXH64(session_id.data(), session_id.size(), /*seed=*/1);
+}
+
+
+bool WebSessionStore::lookupSession(const std::string& session_id, SessionInfo& info_out) const
+{
+	const uint64 hash = hashSessionID(session_id);
+	const Shard& shard = shards[hash % NUM_SHARDS];
+
+	std::shared_lock<std::shared_mutex> lock(shard.mutex);
+
+	const auto res = shard.sessions.find(hash);
+	if(res == shard.sessions.end())
+		return false;
+
+	// Check the full ID, so that a hash collision can't log someone in to another session.
+	if(res->second.session->id != session_id)
+		return false;
+
+	if(res->second.session->created_time.numSecondsAgo() > (int64)SESSION_MAX_AGE_S)
+		return false;
+
+	info_out = res->second;
+	return true;
+}
+
+
+void WebSessionStore::addSession(const UserWebSessionRef& session, const std::string& username)
+{
+	const uint64 hash = hashSessionID(session->id);
+	Shard& shard = shards[hash % NUM_SHARDS];
+
+	std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+	SessionInfo& info = shard.sessions[hash];
+	info.session = session;
+	info.username = username;
+}
+
+
+void WebSessionStore::removeExpiredSessions(uint64 now_time, uint64 max_age_s, std::vector<UserWebSessionRef>& removed_sessions_out)
+{
+	for(size_t i=0; i<NUM_SHARDS; ++i)
+	{
+		Shard& shard = shards[i];
+
+		std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+		for(auto it = shard.sessions.begin(); it != shard.sessions.end(); )
+		{
+			const uint64 created_time = it->second.session->created_time.time;
+			if((created_time < now_time) && (now_time - created_time > max_age_s))
+			{
+				removed_sessions_out.push_back(it->second.session);
+				it = shard.sessions.erase(it);
+			}
+			else
+				++it;
+		}
+	}
+}
+
+
+void WebSessionStore::getAllSessions(std::vector<UserWebSessionRef>& sessions_out) const
+{
+	for(size_t i=0; i<NUM_SHARDS; ++i)
+	{
+		const Shard& shard = shards[i];
+
+		std::shared_lock<std::shared_mutex> lock(shard.mutex);
+
+		for(auto it = shard.sessions.begin(); it != shard.sessions.end(); ++it)
+			sessions_out.push_back(it->second.session);
+	}
+}
+
+
+size_t WebSessionStore::size() const
+{
+	size_t total = 0;
+	for(size_t i=0; i<NUM_SHARDS; ++i)
+	{
+		std::shared_lock<std::shared_mutex> lock(shards[i].mutex);
+		total += shards[i].sessions.size();
+	}
+	return total;
+}
+
+
+void WebSessionStore::clear()
+{
+	for(size_t i=0; i<NUM_SHARDS; ++i)
+	{
+		std::unique_lock<std::shared_mutex> lock(shards[i].mutex);
+		shards[i].sessions.clear();
+	}
+}
+
+
+#if BUILD_TESTS
+
+
+#include <utils/ConPrint.h>
+#include <utils/StringUtils.h>
+#include <utils/Timer.h>
+#include <utils/TestUtils.h>
+#include <thread>
+
+
+static UserWebSessionRef makeTestSession(const std::string& id, uint32 user_id, uint64 created_time)
+{
+	UserWebSessionRef session = new UserWebSession();
+	session->id = id;
+	session->user_id = UserID(user_id);
+	session->created_time = TimeStamp(created_time);
+	return session;
+}
+
+
+void WebSessionStore::test()
+{
+	conPrint("WebSessionStore::test()");
+
+	const uint64 now = TimeStamp::currentTime().time;
+
+	//------------------------ Test lookup ------------------------
+	{
+		WebSessionStore store;
+		SessionInfo info;
+		testAssert(!store.lookupSession("AAA", info));
+
+		store.addSession(makeTestSession("AAA", 1, now), "alice");
+		store.addSession(makeTestSession("BBB", 2, now), "bob");
+		testAssert(store.size() == 2);
+
+		testAssert(store.lookupSession("AAA", info));
+		testAssert(info.session->user_id == UserID(1) && info.username == "alice");
+		testAssert(store.lookupSession("BBB", info));
+		testAssert(info.session->user_id == UserID(2) && info.username == "bob");
+		testAssert(!store.lookupSession("CCC", info));
+		testAssert(!store.lookupSession("", info));
+
+		std::vector<UserWebSessionRef> all;
+		store.getAllSessions(all);
+		testAssert(all.size() == 2);
+
+		store.clear();
+		testAssert(store.size() == 0);
+		testAssert(!store.lookupSession("AAA", info));
+	}
+
+	//------------------------ Test expiry ------------------------
+	{
+		WebSessionStore store;
+		store.addSession(makeTestSession("new", 1, now - 10), "alice");
+		store.addSession(makeTestSession("old", 2, now - SESSION_MAX_AGE_S - 100), "bob");
+
+		// Expired sessions aren't returned, even before they are removed.
+		SessionInfo info;
+		testAssert(store.lookupSession("new", info));
+		testAssert(!store.lookupSession("old", info));
+
+		std::vector<UserWebSessionRef> removed;
+		store.removeExpiredSessions(now, SESSION_MAX_AGE_S, removed);
+		testAssert(removed.size() == 1 && removed[0]->id == "old");
+		testAssert(store.size() == 1);
+		testAssert(store.lookupSession("new", info));
+
+		removed.clear();
+		store.removeExpiredSessions(now, SESSION_MAX_AGE_S, removed);
+		testAssert(removed.empty());
+	}
+
+	//------------------------ Test concurrent lookups and adds ------------------------
+	{
+		WebSessionStore store;
+		const int NUM_SESSIONS = 1000;
+		for(int i=0; i<NUM_SESSIONS; ++i)
+			store.addSession(makeTestSession("session_" + toString(i), i, now), "user_" + toString(i));
+
+		Timer timer;
+		std::vector<std::thread> threads;
+		for(int t=0; t<4; ++t)
+			threads.push_back(std::thread([&store, t, now]() {
+				SessionInfo info;
+				for(int i=0; i<100000; ++i)
+				{
+					const int z = (i * 7 + t) % NUM_SESSIONS;
+					testAssert(store.lookupSession("session_" + toString(z), info));
+					testAssert(info.username == "user_" + toString(z));
+					if(t == 0 && (i % 100) == 0) // One thread adds sessions as well
+						store.addSession(makeTestSession("extra_" + toString(i), 0, now), "extra");
+				}
+			}));
+		for(size_t t=0; t<threads.size(); ++t)
+			threads[t].join();
+
+		conPrint("400000 concurrent lookups took " + timer.elapsedStringNSigFigs(4));
+		testAssert(store.size() == NUM_SESSIONS + 1000);
+	}
+
+	conPrint("WebSessionStore::test() done.");
+}
+
+
+#endif // BUILD_TESTS
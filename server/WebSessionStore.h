@@ -0,0 +1,77 @@
+/*=====================================================================
+WebSessionStore.h
+-----------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#pragma once
+
+
+#include "UserWebSession.h"
+#include <Platform.h>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+/*=====================================================================
+WebSessionStore
+---------------
+Logged-in web sessions, looked up by session ID (the site-b cookie value).
+
+Has its own locking, so looking up a session doesn't need the world state mutex.
+Sessions are spread over NUM_SHARDS shards by a hash of the session ID,
+each with a reader-writer lock.  Lookups are much more common than logins,
+so lookups only take a shared lock.
+
+The name of the session user is cached with the session, so
+LoginHandlers::isLoggedIn() doesn't need to look up the user.
+
+Sessions older than SESSION_MAX_AGE_S are treated as not present, and are
+removed periodically by WorldMaintenance::removeExpiredWebSessions().
+=====================================================================*/
+class WebSessionStore
+{
+public:
+	WebSessionStore();
+	~WebSessionStore();
+
+	static const uint64 SESSION_MAX_AGE_S = 90 * 24 * 3600; // 90 days, same as the Max-Age of the session cookie.
+
+	struct SessionInfo
+	{
+		UserWebSessionRef session;
+		std::string username; // Name of the session user.
+	};
+
+	// Returns false if there is no session with the given ID, or the session has expired.
+	bool lookupSession(const std::string& session_id, SessionInfo& info_out) const;
+
+	void addSession(const UserWebSessionRef& session, const std::string& username);
+
+	// Removes sessions created more than max_age_s seconds before now_time, and appends them to removed_sessions_out.
+	void removeExpiredSessions(uint64 now_time, uint64 max_age_s, std::vector<UserWebSessionRef>& removed_sessions_out);
+
+	void getAllSessions(std::vector<UserWebSessionRef>& sessions_out) const;
+
+	size_t size() const;
+
+	void clear();
+
+	static void test();
+
+private:
+	GLARE_DISABLE_COPY(WebSessionStore);
+
+	static uint64 hashSessionID(const std::string& session_id);
+
+	static const size_t NUM_SHARDS = 16;
+
+	struct Shard
+	{
+		mutable std::shared_mutex mutex;
+		std::unordered_map<uint64, SessionInfo> sessions; // Map from hash of session ID to session.
+	};
+
+	Shard shards[NUM_SHARDS];
+};
@@ -12,6 +12,7 @@ Copyright Glare Technologies Limited 2018 -
 #include "SubEthTransaction.h"
 #include "MeshLODGenThread.h"
 #include "WorkerThreadUploadPhotoHandling.h"
+#include "MapTilePyramid.h"
 #include "../webserver/LoginHandlers.h"
 #include "../shared/Protocol.h"
 #include "../shared/ProtocolStructs.h"
@@ -527,10 +528,11 @@ void WorkerThread::handleScreenshotBotConnection()
 				if(screenshot.isNull())
 				{
 					// Find first screenshot in map_tile_info map in ScreenshotState_notdone state.  NOTE: slow linear scan.
+					// Only tiles at the finest zoom level are rendered by the bot, coarser tiles are built from them by MapTilePyramidThread.
 					for(auto it = server->world_state->map_tile_info.info.begin(); it != server->world_state->map_tile_info.info.end(); ++it)
 					{
 						TileInfo& tile_info = it->second;
-						if(tile_info.cur_tile_screenshot.nonNull() && tile_info.cur_tile_screenshot->state == Screenshot::ScreenshotState_notdone)
+						if(MapTilePyramid::isTileRenderedByBot(it->first.z) && tile_info.cur_tile_screenshot.nonNull() && tile_info.cur_tile_screenshot->state == Screenshot::ScreenshotState_notdone)
 						{
 							screenshot = tile_info.cur_tile_screenshot;
 							break;
@@ -622,7 +624,12 @@ void WorkerThread::handleScreenshotBotConnection()
 						server->world_state->addScreenshotAsDBDirty(screenshot);
 
 						if(screenshot->is_map_tile) // If we received a tile screenshot, mark map tile info as dirty to get it saved.
+						{
 							server->world_state->map_tile_info.db_dirty = true;
+
+							// Mark the parent tile as needing to be rebuilt by MapTilePyramidThread.
+							server->world_state->map_tile_info.pyramid_dirty_tiles.insert(MapTilePyramid::getParentTileCoords(Vec3<int>(screenshot->tile_x, screenshot->tile_y, screenshot->tile_z)));
+						}
 					}
 				}
 				else
@@ -2261,31 +2268,23 @@ void WorkerThread::doRun()
 
 							{ // Lock scope
 								WorldStateLock lock(world_state->mutex);
-								const ServerWorldState::ObjectMapType& objects = cur_world_state->getObjects(lock);
-								for(auto it = objects.begin(); it != objects.end(); ++it)
-								{
-									const WorldObject* ob = it->second.ptr();
 
-									// See if the object is in any of the cell AABBs
-									bool in_cell = false;
-									for(uint32 i=0; i<num_cells; ++i)
-										if(cell_aabbs[i].contains(ob->pos.toVec4fPoint()))
-										{
-											in_cell = true;
-											break;
-										}
+								// Find the objects in any of the cell AABBs
+								std::vector<WorldObject*> obs_in_cells;
+								cur_world_state->getObjectHotTable(lock).getObjectsWithPosInAnyAABB(cell_aabbs.data(), cell_aabbs.size(), obs_in_cells);
 
-									if(in_cell)
-									{
-										// Send ObjectInitialSend packet
-										MessageUtils::initPacket(scratch_packet, Protocol::ObjectInitialSend);
-										ob->writeToNetworkStream(scratch_packet);
-										MessageUtils::updatePacketLengthField(scratch_packet);
+								for(size_t i=0; i<obs_in_cells.size(); ++i)
+								{
+									const WorldObject* ob = obs_in_cells[i];
 
-										packet.writeData(scratch_packet.buf.data(), scratch_packet.buf.size()); 
+									// Send ObjectInitialSend packet
+									MessageUtils::initPacket(scratch_packet, Protocol::ObjectInitialSend);
+									ob->writeToNetworkStream(scratch_packet);
+									MessageUtils::updatePacketLengthField(scratch_packet);
 
-										num_obs_written++;
-									}
+									packet.writeData(scratch_packet.buf.data(), scratch_packet.buf.size()); 
+
+									num_obs_written++;
 								}
 							} // End lock scope
 
@@ -2336,19 +2335,12 @@ void WorkerThread::doRun()
 							chunk_begin_offsets.push_back(0);
 							size_t last_chunk_begin_offset = 0;
 
-							std::vector<const WorldObject*> obs;
+							std::vector<WorldObject*> obs;
 							obs.reserve(16384);
 
 							{ // Lock scope
 								WorldStateLock lock(world_state->mutex);
-								const ServerWorldState::ObjectMapType& objects = cur_world_state->getObjects(lock);
-								for(auto it = objects.begin(); it != objects.end(); ++it)
-								{
-									const WorldObject* ob = it->second.ptr();
-									const Vec4f ob_pos_vec4f = ob->pos.toVec4fPoint();
-									if(ob_pos_vec4f.isFinite() && aabb.contains(ob_pos_vec4f)) // If the object position is valid, and if it's in the query AABB:
-										obs.push_back(ob);
-								}
+								cur_world_state->getObjectHotTable(lock).getObjectsWithPosInAABB(aabb, obs); // Get objects with a valid position in the query AABB.
 
 								// Sort objects from near to far from camera.
 								struct WorldObjectDistComparator
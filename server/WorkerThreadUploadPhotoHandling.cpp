@@ -8,6 +8,7 @@ Copyright Glare Technologies Limited 2025 -
 
 #include "ServerWorldState.h"
 #include "Server.h"
+#include "PhotoResizing.h"
 #include "../webserver/LoginHandlers.h"
 #include "../shared/Protocol.h"
 #include <graphics/jpegdecoder.h>
@@ -152,7 +153,7 @@ void handlePhotoUploadConnection(Reference<SocketInterface> socket, Server* serv
 			// Make other photo sizes
 			try
 			{
-				saveMidSizeAndThumbnailImages(/*src_full_res_screenshot_filename=*/photo_filename, random_path_hex_str, server->photo_dir, data, 
+				saveMidSizeAndThumbnailImages(/*src_full_res_screenshot_filename=*/photo_filename, random_path_hex_str, server->photo_dir, data, server->photo_task_manager,
 					/*midsize_filename_out=*/midsize_filename, /*thumbnail_filename_out=*/thumbnail_filename);
 			}
 			catch(glare::Exception& e)
@@ -217,7 +218,8 @@ void handlePhotoUploadConnection(Reference<SocketInterface> socket, Server* serv
 }
 
 
-void saveMidSizeAndThumbnailImages(const std::string& src_full_res_screenshot_filename, const std::string& random_path_hex_str, const std::string& photo_dir, const std::vector<uint8>& src_image_data, std::string& midsize_filename_out, std::string& thumbnail_filename_out)
+void saveMidSizeAndThumbnailImages(const std::string& src_full_res_screenshot_filename, const std::string& random_path_hex_str, const std::string& photo_dir, const std::vector<uint8>& src_image_data, glare::TaskManager* task_manager,
+	std::string& midsize_filename_out, std::string& thumbnail_filename_out)
 {
 	conPrint("WorkerThreadUploadPhotoHandling::saveMidSizeAndThumbnailImages()");
 
@@ -229,44 +231,32 @@ void saveMidSizeAndThumbnailImages(const std::string& src_full_res_screenshot_fi
 	if((im->getMapWidth() < 8) || (im->getMapHeight() < 8))
 		throw glare::Exception("image too small.");
 
+	// The decoded image is resized to all the output sizes in one task group, then the outputs are encoded concurrently.
+	std::vector<PhotoResizing::ResizeOutput> resize_outputs;
+	std::vector<std::string> output_filenames;
 
-	//------------------------ Save midsize image (if needed) --------------------------
+	//------------------------ Mid-size image (if needed) --------------------------
 	// max width: 1000px
+	const bool make_midsize = im->getMapWidth() > 1000;
+	if(make_midsize)
 	{
-		if(im->getMapWidth() > 1000)
-		{
-			// Resize needed
-			const int midsize_width = 1000;
-			const int midsize_height = (int)(1000.0 * (double)im->getMapHeight() / (double)im->getMapWidth());
-
-			// Do the resize
-			Map2DRef resized = im->resizeMidQuality(midsize_width, midsize_height, /*task_manager=*/nullptr);
-			if(!resized)
-				throw glare::Exception("resizeMidQuality failed.");
-			if(!resized.isType<ImageMapUInt8>())
-				throw glare::Exception("resized image was not ImageMapUInt8");
-
-			// Save to disk
-			const std::string midsize_filename = "photo_" + random_path_hex_str + "_midsize1000.jpg";
-			const std::string midsize_path = photo_dir + "/" + midsize_filename;
-
-			conPrint("Saving resized midsize image to disk at '" + midsize_path + "'...");
-
-			JPEGDecoder::save(resized.downcast<ImageMapUInt8>(), midsize_path, JPEGDecoder::SaveOptions(/*quality=*/95));
+		// Resize needed
+		const int midsize_width = 1000;
+		const int midsize_height = (int)(1000.0 * (double)im->getMapHeight() / (double)im->getMapWidth());
 
-			midsize_filename_out = midsize_filename;
-		}
-		else
-		{
-			// If src full-res image is small enough already, just use it directly.
+		resize_outputs.push_back(PhotoResizing::ResizeOutput(0, 0, (int)im->getMapWidth(), (int)im->getMapHeight(), midsize_width, midsize_height));
+		output_filenames.push_back("photo_" + random_path_hex_str + "_midsize1000.jpg");
+	}
+	else
+	{
+		// If src full-res image is small enough already, just use it directly.
 
-			conPrint("Just using src_full_res_screenshot_filename for midsize_filename_out: '" + src_full_res_screenshot_filename + "'.");
-			midsize_filename_out = src_full_res_screenshot_filename;
-		}
+		conPrint("Just using src_full_res_screenshot_filename for midsize_filename_out: '" + src_full_res_screenshot_filename + "'.");
+		midsize_filename_out = src_full_res_screenshot_filename;
 	}
 
 
-	//------------------------ Save thumbnail --------------------------
+	//------------------------ Thumbnail --------------------------
 	// Thumbnail is 230 px wide with a fixed aspect ratio of 4/3.
 	// The source image will be cropped to get the desired aspect ratio.
 	{
@@ -274,42 +264,32 @@ void saveMidSizeAndThumbnailImages(const std::string& src_full_res_screenshot_fi
 		const int thumb_width = 230;
 		const int thumb_height = 230 * 3 / 4; // 4/3 ratio
 
-		int cropped_w, cropped_h;
-		if((double)im->getMapWidth() / (double)im->getMapHeight()  > ((double)thumb_width / (double)thumb_height))
-		{
-			// Image is wider than thumbnail ratio, need to crop off left and right edges.
-			cropped_w = (int)((double)im->getMapHeight() * ((double)thumb_width / (double)thumb_height));
-			cropped_h = (int)im->getMapHeight();
-		}
-		else
-		{
-			// Image is taller than thumbnail ratio, need to crop off top and bottom edges.
-			cropped_w = (int)im->getMapWidth();
-			cropped_h = (int)((double)im->getMapWidth() * ((double)thumb_height / (double)thumb_width));
-		}
-
-		// Crop the image to the correct ratio
-		const int left_right_edge_w = ((int)im->getMapWidth()  - cropped_w) / 2; // Get the width of the edge that will be cropped off, if any.
-		const int top_bottom_edge_w = ((int)im->getMapHeight() - cropped_h) / 2;
-		ImageMapUInt8Ref cropped = im.downcast<ImageMapUInt8>()->cropImage(/*start_x=*/left_right_edge_w, /*start_y=*/top_bottom_edge_w, cropped_w, cropped_h);
+		resize_outputs.push_back(PhotoResizing::makeCentreCroppedOutput((int)im->getMapWidth(), (int)im->getMapHeight(), thumb_width, thumb_height));
+		output_filenames.push_back("photo_" + random_path_hex_str + "_thumb_" + toString(thumb_width) + "x" + toString(thumb_height) + ".jpg");
+	}
 
-		// Do the resize
-		Map2DRef resized = cropped->resizeMidQuality(thumb_width, thumb_height, /*task_manager=*/nullptr);
-		if(!resized)
-			throw glare::Exception("resizeMidQuality failed.");
-		if(!resized.isType<ImageMapUInt8>())
-			throw glare::Exception("resized image was not ImageMapUInt8");
+	//------------------------ Resize and save to disk --------------------------
+	Timer timer;
+	PhotoResizing::resizeToOutputs(*im.downcast<ImageMapUInt8>(), resize_outputs, task_manager);
+	const double resize_time = timer.elapsed();
 
-		// Save to disk
-		const std::string thumbnail_filename = "photo_" + random_path_hex_str + "_thumb_" + toString(thumb_width) + "x" + toString(thumb_height) + ".jpg";
-		const std::string thumbnail_path = photo_dir + "/" + thumbnail_filename;
+	std::vector<PhotoResizing::JPEGToSave> jpegs(resize_outputs.size());
+	for(size_t i=0; i<resize_outputs.size(); ++i)
+	{
+		jpegs[i].image = resize_outputs[i].result;
+		jpegs[i].path = photo_dir + "/" + output_filenames[i];
+		jpegs[i].quality = 95;
+		conPrint("Saving resized image to disk at '" + jpegs[i].path + "'...");
+	}
 
-		conPrint("Saving thumbnail image to disk at '" + thumbnail_path + "'...");
+	timer.reset();
+	PhotoResizing::saveJPEGs(jpegs, task_manager);
 
-		JPEGDecoder::save(resized.downcast<ImageMapUInt8>(), thumbnail_path, JPEGDecoder::SaveOptions(/*quality=*/95));
+	conPrint("Resizing took " + doubleToStringNSigFigs(resize_time * 1.0e3, 3) + " ms, saving took " + timer.elapsedStringNSigFigs(3));
 
-		thumbnail_filename_out = thumbnail_filename;
-	}
+	if(make_midsize)
+		midsize_filename_out = output_filenames[0];
+	thumbnail_filename_out = output_filenames.back();
 
 	conPrint("WorkerThreadUploadPhotoHandling::saveMidSizeAndThumbnailImages() done.");
 }
@@ -327,7 +307,7 @@ void test()
 			FileUtils::readEntireFile(TestUtils::getTestReposDir() + "/testfiles/italy_bolsena_flag_flowers_stairs_01.jpg", src_image_data);
 
 			std::string thumbnail_filename, midsize_filename;
-			saveMidSizeAndThumbnailImages(src_full_res_screenshot_path, /*random_path_hex_str=*/"aaa", /*photo_dir=*/"d:/files", src_image_data, midsize_filename, thumbnail_filename);
+			saveMidSizeAndThumbnailImages(src_full_res_screenshot_path, /*random_path_hex_str=*/"aaa", /*photo_dir=*/"d:/files", src_image_data, /*task_manager=*/NULL, midsize_filename, thumbnail_filename);
 		}
 		{
 			const std::string src_full_res_screenshot_filename = "screenshot_1560x1028.jpg";
@@ -336,7 +316,7 @@ void test()
 			FileUtils::readEntireFile(TestUtils::getTestReposDir() + "/testfiles/jpegs/screenshot_1560x1028.jpg", src_image_data);
 
 			std::string midsize_filename, thumbnail_filename;
-			saveMidSizeAndThumbnailImages(src_full_res_screenshot_path, /*random_path_hex_str=*/"bbb", /*photo_dir=*/"d:/files", src_image_data, midsize_filename, thumbnail_filename);
+			saveMidSizeAndThumbnailImages(src_full_res_screenshot_path, /*random_path_hex_str=*/"bbb", /*photo_dir=*/"d:/files", src_image_data, /*task_manager=*/NULL, midsize_filename, thumbnail_filename);
 		}
 	}
 	catch(glare::Exception& e)
@@ -12,6 +12,7 @@ Copyright Glare Technologies Limited 2025 -
 #include <vector>
 class SocketInterface;
 class Server;
+namespace glare { class TaskManager; }
 
 
 /*=====================================================================
@@ -24,7 +25,8 @@ namespace WorkerThreadUploadPhotoHandling
 
 void handlePhotoUploadConnection(Reference<SocketInterface> socket, Server* server, const web::RequestInfo& websocket_request_info, bool fuzzing);
 
-void saveMidSizeAndThumbnailImages(const std::string& src_full_res_screenshot_filename, const std::string& random_path_hex_str, const std::string& photo_dir, const std::vector<uint8>& src_image_data, 
+// Resizing and encoding is done on task_manager if non-null.
+void saveMidSizeAndThumbnailImages(const std::string& src_full_res_screenshot_filename, const std::string& random_path_hex_str, const std::string& photo_dir, const std::vector<uint8>& src_image_data, glare::TaskManager* task_manager,
 	std::string& midsize_filename_out, std::string& thumbnail_filename_out);
 
 void test();
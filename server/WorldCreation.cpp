@@ -618,7 +618,7 @@ static void updateToUseImageCubeMeshes(ServerAllWorldsState& all_worlds_state)
 			{
 				WorldObject* ob = i->second.ptr();
 
-				if(!ob->model_url.empty() && all_worlds_state.resource_manager->isFileForURLPresent(ob->model_url) && hasExtension(ob->model_url, "bmesh"))
+				if(!ob->model_url.empty() && all_worlds_state.resource_manager->isFileForURLPresent(ob->model_url.str()) && hasExtension(ob->model_url.str(), "bmesh"))
 				{
 					try
 					{
@@ -630,7 +630,7 @@ static void updateToUseImageCubeMeshes(ServerAllWorldsState& all_worlds_state)
 							const uint64 checksum = FileChecksum::fileChecksum(local_path);
 							if(checksum == image_cube_mesh_checksum)
 							{
-								conPrint("updateToUseImageCubeMeshes(): Updating model_url '" + ob->model_url + "' to 'image_cube_5438347426447337425.bmesh'.");
+								conPrint("updateToUseImageCubeMeshes(): Updating model_url '" + toStdString(ob->model_url) + "' to 'image_cube_5438347426447337425.bmesh'.");
 								ob->model_url = "image_cube_5438347426447337425.bmesh";
 
 								world_state->addWorldObjectAsDBDirty(ob);
@@ -17,6 +17,7 @@ Copyright Glare Technologies Limited 2024 -
 #include <Exception.h>
 #include <FileChecksum.h>
 #include <Lock.h>
+#include <StringUtils.h>
 
 
 // From GUIClient::summonBike()
@@ -162,12 +163,15 @@ void WorldMaintenance::removeOldVehicles(Reference<ServerAllWorldsState> all_wor
 	{
 		ServerWorldState* world_state = it->second.ptr();
 
-		ServerWorldState::ObjectMapType& objects = world_state->getObjects(lock);
-		for(auto ob_it = objects.begin(); ob_it != objects.end(); ++ob_it)
+		// Only summoned objects can be vehicles to remove, so just look at those.
+		std::vector<WorldObject*> summoned_obs;
+		world_state->getObjectHotTable(lock).getObjectsWithFlags(WorldObject::SUMMONED_FLAG, summoned_obs);
+
+		for(size_t z=0; z<summoned_obs.size(); ++z)
 		{
-			WorldObject* object = ob_it->second.ptr();
+			WorldObject* object = summoned_obs[z];
 
-			if(BitUtils::isBitSet(object->flags, WorldObject::SUMMONED_FLAG) && (object->last_modified_time <= timestamp_cutoff))
+			if(object->last_modified_time <= timestamp_cutoff)
 			{
 				bool delete_ob = false;
 
@@ -216,3 +220,27 @@ void WorldMaintenance::removeOldVehicles(Reference<ServerAllWorldsState> all_wor
 		conPrint("WorldMaintenance::removeOldVehicles(): removed " + toString(num_bikes_deleted) + " bike(s), " + toString(num_hovercars_deleted) + " hovercar(s), " + 
 			toString(num_cars_deleted) + " car(s) and " + toString(num_boats_deleted) + " boat(s).");
 }
+
+
+void WorldMaintenance::removeExpiredWebSessions(Reference<ServerAllWorldsState> all_worlds_state)
+{
+	// Sessions are removed from the session store without holding the world state lock.
+	std::vector<UserWebSessionRef> removed_sessions;
+	all_worlds_state->web_sessions.removeExpiredSessions(TimeStamp::currentTime().time, WebSessionStore::SESSION_MAX_AGE_S, removed_sessions);
+
+	if(!removed_sessions.empty())
+	{
+		Lock lock(all_worlds_state->mutex);
+
+		for(size_t i=0; i<removed_sessions.size(); ++i)
+		{
+			all_worlds_state->db_dirty_userwebsessions.erase(removed_sessions[i]);
+			if(removed_sessions[i]->database_key.valid())
+				all_worlds_state->db_records_to_delete.insert(removed_sessions[i]->database_key);
+		}
+
+		all_worlds_state->markAsChanged();
+
+		conPrint("WorldMaintenance::removeExpiredWebSessions(): Removed " + toString(removed_sessions.size()) + " expired web session(s).");
+	}
+}
@@ -17,4 +17,7 @@ class WorldMaintenance
 {
 public:
 	static void removeOldVehicles(Reference<ServerAllWorldsState> world_state);
+
+	// Removes web sessions older than WebSessionStore::SESSION_MAX_AGE_S, and deletes them from the DB.
+	static void removeExpiredWebSessions(Reference<ServerAllWorldsState> world_state);
 };
@@ -0,0 +1,214 @@
+/*=====================================================================
+DecodedImageCache.cpp
+---------------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#include "DecodedImageCache.h"
+
+
+#include "ImageDecoding.h"
+#include <utils/Lock.h>
+#include <utils/ConPrint.h>
+
+
+DecodedImageCache::DecodedImageCache(size_t max_total_size_B_)
+:	total_size_B(0),
+	max_total_size_B(max_total_size_B_),
+	num_hits(0),
+	num_misses(0),
+	num_evictions(0)
+{}
+
+
+DecodedImageCache::~DecodedImageCache() {}
+
+
+Reference<Map2D> DecodedImageCache::getImage(const std::string& abs_path, uint64 content_hash)
+{
+	ImageKey key;
+	key.abs_path = abs_path;
+	key.content_hash = content_hash;
+
+	Lock lock(mutex);
+
+	auto res = images.find(key);
+	if(res == images.end())
+	{
+		num_misses++;
+		return Reference<Map2D>();
+	}
+
+	// Move to front of LRU list
+	lru_keys.splice(lru_keys.begin(), lru_keys, res->second.lru_it);
+
+	num_hits++;
+	return res->second.image;
+}
+
+
+Reference<Map2D> DecodedImageCache::getOrDecodeImage(const std::string& abs_path, uint64 content_hash)
+{
+	Reference<Map2D> image = getImage(abs_path, content_hash);
+	if(image.nonNull())
+		return image;
+
+	// Decode the image without holding the mutex.
+	image = ImageDecoding::decodeImage(".", abs_path);
+
+	const size_t image_size_B = image->getByteSize();
+	if(image_size_B <= max_total_size_B / 4)
+	{
+		ImageKey key;
+		key.abs_path = abs_path;
+		key.content_hash = content_hash;
+
+		Lock lock(mutex);
+		if(images.count(key) == 0) // Another thread may have inserted it in the meantime.
+			insertImage(key, image, image_size_B);
+	}
+
+	return image;
+}
+
+
+void DecodedImageCache::insertImage(const ImageKey& key, const Reference<Map2D>& image, size_t image_size_B)
+{
+	lru_keys.push_front(key);
+
+	CacheEntry& entry = images[key];
+	entry.image = image;
+	entry.size_B = image_size_B;
+	entry.lru_it = lru_keys.begin();
+	total_size_B += image_size_B;
+
+	// Evict least recently used images until we are under the size limit.  Don't evict the image just inserted.
+	while(total_size_B > max_total_size_B && lru_keys.size() > 1)
+	{
+		auto res = images.find(lru_keys.back());
+		assert(res != images.end());
+		total_size_B -= res->second.size_B;
+		images.erase(res);
+		lru_keys.pop_back();
+		num_evictions++;
+	}
+}
+
+
+void DecodedImageCache::clear()
+{
+	Lock lock(mutex);
+
+	images.clear();
+	lru_keys.clear();
+	total_size_B = 0;
+}
+
+
+DecodedImageCache::Stats DecodedImageCache::getStats()
+{
+	Lock lock(mutex);
+
+	Stats stats;
+	stats.num_hits = num_hits;
+	stats.num_misses = num_misses;
+	stats.num_evictions = num_evictions;
+	stats.num_images = images.size();
+	stats.total_size_B = total_size_B;
+	stats.max_total_size_B = max_total_size_B;
+	return stats;
+}
+
+
+#if BUILD_TESTS
+
+
+#include <graphics/ImageMap.h>
+#include <graphics/PNGDecoder.h>
+#include <utils/TestUtils.h>
+#include <utils/FileUtils.h>
+#include <utils/PlatformUtils.h>
+#include <utils/StringUtils.h>
+#include <utils/Exception.h>
+
+
+void DecodedImageCache::test()
+{
+	conPrint("DecodedImageCache::test()");
+
+	try
+	{
+		const std::string dir = PlatformUtils::getTempDirPath() + "/decoded_image_cache_test";
+		FileUtils::createDirIfDoesNotExist(dir);
+
+		// Write some 16 * 16 RGB PNGs, each with a different colour.
+		const size_t image_size_B = 16 * 16 * 3;
+		std::vector<std::string> paths;
+		for(int i=0; i<5; ++i)
+		{
+			ImageMapUInt8 map(16, 16, 3);
+			for(size_t z=0; z<map.getDataSize(); ++z)
+				map.getData()[z] = (uint8)(i * 50);
+			paths.push_back(dir + "/image_" + toString(i) + ".png");
+			PNGDecoder::write(map, paths.back());
+		}
+
+		// Cache with room for 4 images.
+		DecodedImageCache cache(/*max_total_size_B=*/image_size_B * 4);
+		testAssert(cache.getImage(paths[0], /*content_hash=*/1).isNull());
+
+		Reference<Map2D> image = cache.getOrDecodeImage(paths[0], /*content_hash=*/1);
+		testAssert(image->getMapWidth() == 16 && image->getMapHeight() == 16 && image->numChannels() == 3);
+		testAssert(image.isType<ImageMapUInt8>() && image.downcastToPtr<ImageMapUInt8>()->getPixel(3, 3)[0] == 0);
+		testAssert(cache.getImage(paths[0], /*content_hash=*/1).ptr() == image.ptr());
+		testAssert(cache.getOrDecodeImage(paths[0], /*content_hash=*/1).ptr() == image.ptr());
+
+		// A different content hash for the same path shouldn't return the stale image.
+		testAssert(cache.getImage(paths[0], /*content_hash=*/2).isNull());
+
+		cache.getOrDecodeImage(paths[1], /*content_hash=*/1);
+		cache.getOrDecodeImage(paths[2], /*content_hash=*/1);
+		cache.getOrDecodeImage(paths[3], /*content_hash=*/1);
+		testAssert(cache.getStats().num_images == 4 && cache.getStats().total_size_B == image_size_B * 4);
+
+		// Use image 0, so image 1 is the least recently used, then decode image 4.  Image 1 should be evicted.
+		cache.getImage(paths[0], /*content_hash=*/1);
+		Reference<Map2D> image_4 = cache.getOrDecodeImage(paths[4], /*content_hash=*/1);
+		testAssert(image_4.downcastToPtr<ImageMapUInt8>()->getPixel(3, 3)[0] == 200);
+		testAssert(cache.getStats().num_images == 4 && cache.getStats().total_size_B == image_size_B * 4);
+		testAssert(cache.getStats().num_evictions == 1);
+		testAssert(cache.getImage(paths[0], /*content_hash=*/1).nonNull());
+		testAssert(cache.getImage(paths[1], /*content_hash=*/1).isNull());
+		testAssert(cache.getImage(paths[2], /*content_hash=*/1).nonNull());
+		testAssert(cache.getImage(paths[3], /*content_hash=*/1).nonNull());
+		testAssert(cache.getImage(paths[4], /*content_hash=*/1).nonNull());
+
+		// Images taking more than 1/4 of the max total size should be returned but not cached.
+		{
+			DecodedImageCache small_cache(/*max_total_size_B=*/image_size_B * 4 - 4);
+			Reference<Map2D> uncached_image = small_cache.getOrDecodeImage(paths[0], /*content_hash=*/1);
+			testAssert(uncached_image->getMapWidth() == 16);
+			testAssert(small_cache.getStats().num_images == 0);
+		}
+
+		// Missing files should throw.
+		try
+		{
+			cache.getOrDecodeImage(dir + "/not_a_file.png", /*content_hash=*/1);
+			failTest("Expected exception");
+		}
+		catch(glare::Exception&)
+		{}
+
+		cache.clear();
+		testAssert(cache.getStats().num_images == 0 && cache.getStats().total_size_B == 0);
+	}
+	catch(glare::Exception& e)
+	{
+		failTest(e.what());
+	}
+
+	conPrint("DecodedImageCache::test() done.");
+}
+
+
+#endif // BUILD_TESTS
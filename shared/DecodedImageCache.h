@@ -0,0 +1,99 @@
+/*=====================================================================
+DecodedImageCache.h
+-------------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#pragma once
+
+
+#include <graphics/Map2D.h>
+#include <utils/Reference.h>
+#include <Mutex.h>
+#include <Platform.h>
+#include <string>
+#include <list>
+#include <unordered_map>
+
+
+/*=====================================================================
+DecodedImageCache
+-----------------
+LRU cache of decoded images, keyed by path and content hash, so that a
+texture that is used by several generation steps (material flag checks,
+LOD textures, Basis textures, chunk array textures) is only loaded and
+decoded once.
+
+The content hash is part of the key, so if the file at a path changes,
+the stale decoded image won't be returned.
+
+Cached images are shared between threads, so must not be modified.
+
+Images taking more than max_total_size_B / 4 bytes are returned but not cached.
+Least recently used images are evicted once the total size exceeds max_total_size_B.
+
+Only single images are cached, not image sequences such as animated GIFs.
+
+Thread-safe.
+=====================================================================*/
+class DecodedImageCache
+{
+public:
+	DecodedImageCache(size_t max_total_size_B = 512 * 1024 * 1024);
+	~DecodedImageCache();
+
+	// Returns the cached image, or NULL if it is not cached.  Marks the image as most recently used.
+	Reference<Map2D> getImage(const std::string& abs_path, uint64 content_hash);
+
+	// Returns the cached image if present, otherwise loads and decodes it with ImageDecoding::decodeImage(), and caches it if it's not too large.
+	// Throws glare::Exception if the image could not be loaded or decoded.
+	Reference<Map2D> getOrDecodeImage(const std::string& abs_path, uint64 content_hash);
+
+	void clear();
+
+	struct Stats
+	{
+		uint64 num_hits;
+		uint64 num_misses;
+		uint64 num_evictions;
+		size_t num_images;
+		size_t total_size_B;
+		size_t max_total_size_B;
+	};
+	Stats getStats();
+
+	static void test();
+
+private:
+	GLARE_DISABLE_COPY(DecodedImageCache);
+
+	struct ImageKey
+	{
+		std::string abs_path;
+		uint64 content_hash;
+
+		bool operator == (const ImageKey& other) const { return content_hash == other.content_hash && abs_path == other.abs_path; }
+	};
+
+	struct ImageKeyHasher
+	{
+		size_t operator() (const ImageKey& key) const { return std::hash<std::string>()(key.abs_path) ^ (size_t)key.content_hash; }
+	};
+
+	void insertImage(const ImageKey& key, const Reference<Map2D>& image, size_t image_size_B) REQUIRES(mutex);
+
+	struct CacheEntry
+	{
+		Reference<Map2D> image;
+		size_t size_B;
+		std::list<ImageKey>::iterator lru_it;
+	};
+
+	Mutex mutex;
+	std::unordered_map<ImageKey, CacheEntry, ImageKeyHasher> images	GUARDED_BY(mutex);
+	std::list<ImageKey> lru_keys										GUARDED_BY(mutex); // Most recently used at front.
+	size_t total_size_B													GUARDED_BY(mutex);
+	size_t max_total_size_B;
+	uint64 num_hits														GUARDED_BY(mutex);
+	uint64 num_misses													GUARDED_BY(mutex);
+	uint64 num_evictions												GUARDED_BY(mutex);
+};
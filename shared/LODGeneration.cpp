@@ -7,6 +7,8 @@ Copyright Glare Technologies Limited 2021 -
 
 
 #include "ImageDecoding.h"
+#include "TextureDownsampling.h"
+#include "DecodedImageCache.h"
 #include "../server/ServerWorldState.h"
 #include <ConPrint.h>
 #include <Exception.h>
@@ -32,6 +34,9 @@ Copyright Glare Technologies Limited 2021 -
 #include <dll/include/IndigoMesh.h>
 #include <dll/include/IndigoException.h>
 #include <dll/IndigoStringUtils.h>
+#include "meshoptimizer/src/meshoptimizer.h"
+#include <algorithm>
+#include <cstring>
 #include <basis_universal/encoder/basisu_comp.h>
 #if !GUI_CLIENT
 //#include <basis_universal/encoder/basisu_comp.h>
@@ -95,29 +100,269 @@ BatchedMeshRef loadModel(const std::string& model_path)
 }
 
 
-BatchedMeshRef computeLODModel(BatchedMeshRef batched_mesh, int lod_level)
+// Simplification parameters for each LOD level, applied to the previous level.
+struct LODLevelSimplifyParams
+{
+	float target_reduction_ratio; // Ratio of previous level num indices to target num indices.
+	float target_error; // Relative to the extent of the whole mesh.
+	bool sloppy;
+};
+
+static LODLevelSimplifyParams getLODLevelSimplifyParams(int lod_level)
 {
-	BatchedMeshRef simplified_mesh;
+	LODLevelSimplifyParams params;
 	if(lod_level == 1)
 	{
-		simplified_mesh = MeshSimplification::buildSimplifiedMesh(*batched_mesh, /*target_reduction_ratio=*/10.f, /*target_error=*/0.02f, /*sloppy=*/false);
-		
-		// If we achieved less than a 4x reduction in the number of vertices (and this is a med/large mesh), try again with sloppy simplification
-		if((batched_mesh->numVerts() > 1024) && // if this is a med/large mesh
-			((float)simplified_mesh->numVerts() > (batched_mesh->numVerts() / 4.f)))
-		{
-			simplified_mesh = MeshSimplification::buildSimplifiedMesh(*batched_mesh, /*target_reduction_ratio=*/10.f, /*target_error=*/0.02f, /*sloppy=*/true);
-		}
+		params.target_reduction_ratio = 10.f;
+		params.target_error = 0.02f;
+		params.sloppy = false;
 	}
 	else
 	{
 		assert(lod_level == 2);
-		simplified_mesh = MeshSimplification::buildSimplifiedMesh(*batched_mesh, /*target_reduction_ratio=*/100.f, /*target_error=*/0.08f, /*sloppy=*/true);
+		// Level 2 is simplified from level 1, so the overall reduction is about 100x, and the accumulated error is about 0.08, as when it was simplified from level 0.
+		params.target_reduction_ratio = 10.f;
+		params.target_error = 0.06f;
+		params.sloppy = true;
+	}
+	return params;
+}
+
+
+static float getPositionsExtent(const Vec3f* positions, const uint32* vert_indices, size_t num_verts)
+{
+	if(num_verts == 0)
+		return 0.f;
+
+	Vec3f min_pos = positions[vert_indices[0]];
+	Vec3f max_pos = min_pos;
+	for(size_t i=1; i<num_verts; ++i)
+	{
+		const Vec3f& p = positions[vert_indices[i]];
+		min_pos = min_pos.min(p);
+		max_pos = max_pos.max(p);
+	}
+	const Vec3f diff = max_pos - min_pos;
+	return myMax(diff.x, myMax(diff.y, diff.z));
+}
+
+
+// Simplifies the triangles of a single batch.
+// The batch vertices are compacted first, so that meshoptimizer only has to process the vertices this batch uses, then the vertex cache is optimised for the result.
+class SimplifyBatchTask : public glare::Task
+{
+public:
+	virtual void run(size_t thread_index) override
+	{
+		const uint32* const batch_indices = indices->data() + batch_indices_start;
+
+		// Get sorted unique vertex indices used by the batch.  Local vertex i is global vertex local_to_global[i].
+		std::vector<uint32> local_to_global(batch_indices, batch_indices + batch_num_indices);
+		std::sort(local_to_global.begin(), local_to_global.end());
+		local_to_global.erase(std::unique(local_to_global.begin(), local_to_global.end()), local_to_global.end());
+
+		const size_t num_local_verts = local_to_global.size();
+
+		js::Vector<Vec3f, 16> local_positions(num_local_verts);
+		for(size_t i=0; i<num_local_verts; ++i)
+			local_positions[i] = (*positions)[local_to_global[i]];
+
+		std::vector<uint32> local_indices(batch_num_indices);
+		for(size_t i=0; i<batch_num_indices; ++i)
+			local_indices[i] = (uint32)(std::lower_bound(local_to_global.begin(), local_to_global.end(), batch_indices[i]) - local_to_global.begin());
+
+		// meshoptimizer treats target_error as relative to the extent of the vertices it is given, so scale the error so that it is relative to the whole mesh,
+		// otherwise small batches would be simplified much more coarsely than large ones.
+		const float batch_extent = getPositionsExtent(positions->data(), local_to_global.data(), num_local_verts);
+		const float target_error = (batch_extent > 0) ? myMin(1.f, params.target_error * mesh_extent / batch_extent) : params.target_error;
+
+		const size_t target_num_indices = (size_t)((float)batch_num_indices / params.target_reduction_ratio);
+
+		std::vector<uint32> simplified_indices(batch_num_indices);
+		size_t num_simplified_indices;
+		if(params.sloppy)
+			num_simplified_indices = meshopt_simplifySloppy(simplified_indices.data(), local_indices.data(), batch_num_indices, &local_positions[0].x, num_local_verts, sizeof(Vec3f),
+				target_num_indices, target_error, /*result error=*/NULL);
+		else
+			num_simplified_indices = meshopt_simplify(simplified_indices.data(), local_indices.data(), batch_num_indices, &local_positions[0].x, num_local_verts, sizeof(Vec3f),
+				target_num_indices, target_error, /*options=*/0, /*result error=*/NULL);
+
+		meshopt_optimizeVertexCache(simplified_indices.data(), simplified_indices.data(), num_simplified_indices, num_local_verts);
+
+		indices_out.resize(num_simplified_indices);
+		for(size_t i=0; i<num_simplified_indices; ++i)
+			indices_out[i] = local_to_global[simplified_indices[i]];
+	}
+
+	const js::Vector<Vec3f, 16>* positions;
+	const js::Vector<uint32>* indices;
+	size_t batch_indices_start;
+	size_t batch_num_indices;
+	float mesh_extent;
+	LODLevelSimplifyParams params;
+
+	std::vector<uint32> indices_out; // Simplified batch indices, referencing the vertices of the whole mesh.
+};
+
+
+// Simplifies each batch, and returns the concatenated simplified indices, with the new batches in batches_out.  Batches with no triangles left are removed.
+static void simplifyBatches(const BatchedMesh& mesh, const js::Vector<Vec3f, 16>& positions, const js::Vector<uint32>& indices, float mesh_extent, const LODLevelSimplifyParams& params,
+	glare::TaskManager* task_manager, js::Vector<uint32>& indices_out, std::vector<BatchedMesh::IndicesBatch>& batches_out)
+{
+	Reference<glare::TaskGroup> task_group = new glare::TaskGroup();
+	std::vector<Reference<SimplifyBatchTask>> tasks(mesh.batches.size());
+	for(size_t b=0; b<mesh.batches.size(); ++b)
+	{
+		runtimeCheck((size_t)mesh.batches[b].indices_start + mesh.batches[b].num_indices <= indices.size());
+
+		tasks[b] = new SimplifyBatchTask();
+		tasks[b]->positions = &positions;
+		tasks[b]->indices = &indices;
+		tasks[b]->batch_indices_start = mesh.batches[b].indices_start;
+		tasks[b]->batch_num_indices = mesh.batches[b].num_indices;
+		tasks[b]->mesh_extent = mesh_extent;
+		tasks[b]->params = params;
+		task_group->tasks.push_back(tasks[b]);
+	}
+
+	if(task_manager && (tasks.size() > 1))
+		task_manager->runTaskGroup(task_group);
+	else
+	{
+		for(size_t i=0; i<tasks.size(); ++i)
+			tasks[i]->run(/*thread_index=*/0);
+	}
+
+	// Merge the batch results, in batch order.
+	indices_out.clear();
+	batches_out.clear();
+	for(size_t b=0; b<tasks.size(); ++b)
+	{
+		const std::vector<uint32>& batch_indices = tasks[b]->indices_out;
+		if(batch_indices.empty())
+			continue;
+
+		BatchedMesh::IndicesBatch batch;
+		batch.indices_start = (uint32)indices_out.size();
+		batch.num_indices = (uint32)batch_indices.size();
+		batch.material_index = mesh.batches[b].material_index;
+		batches_out.push_back(batch);
+
+		for(size_t i=0; i<batch_indices.size(); ++i)
+			indices_out.push_back(batch_indices[i]);
+	}
+}
+
+
+BatchedMeshRef computeNextLODModel(const BatchedMesh& prev_level_mesh, int lod_level, glare::TaskManager* task_manager)
+{
+	const LODLevelSimplifyParams params = getLODLevelSimplifyParams(lod_level);
+
+	const BatchedMesh::VertAttribute* pos_attr = prev_level_mesh.findAttribute(BatchedMesh::VertAttribute_Position);
+	if(!pos_attr)
+		throw glare::Exception("Pos attribute not present.");
+
+	if(pos_attr->component_type != BatchedMesh::ComponentType_Float)
+	{
+		// Per-batch simplification needs float positions, so just use MeshSimplification for other position types (e.g. quantised meshes).
+		BatchedMeshRef simplified_mesh = MeshSimplification::buildSimplifiedMesh(prev_level_mesh, params.target_reduction_ratio, params.target_error, params.sloppy);
+		if((lod_level == 1) && (prev_level_mesh.numVerts() > 1024) && ((float)simplified_mesh->numVerts() > (prev_level_mesh.numVerts() / 4.f)))
+			simplified_mesh = MeshSimplification::buildSimplifiedMesh(prev_level_mesh, params.target_reduction_ratio, params.target_error, /*sloppy=*/true);
+		simplified_mesh->doMeshOptimizerOptimisations();
+		return simplified_mesh;
+	}
+
+	const size_t num_verts = prev_level_mesh.numVerts();
+	const size_t vert_size = prev_level_mesh.vertexSize();
+	const uint8* const src_vertex_data = prev_level_mesh.vertex_data.data();
+	runtimeCheck(num_verts * vert_size <= prev_level_mesh.vertex_data.size());
+
+	// Get vertex positions and indices in a form meshoptimizer can use.
+	js::Vector<Vec3f, 16> positions(num_verts);
+	for(size_t i=0; i<num_verts; ++i)
+		std::memcpy(&positions[i], src_vertex_data + i * vert_size + pos_attr->offset_B, sizeof(Vec3f));
+
+	const size_t num_indices = prev_level_mesh.numIndices();
+	js::Vector<uint32> indices(num_indices);
+	if(prev_level_mesh.index_type == BatchedMesh::ComponentType_UInt8)
+	{
+		for(size_t i=0; i<num_indices; ++i)
+			indices[i] = ((const uint8*)prev_level_mesh.index_data.data())[i];
+	}
+	else if(prev_level_mesh.index_type == BatchedMesh::ComponentType_UInt16)
+	{
+		for(size_t i=0; i<num_indices; ++i)
+			indices[i] = ((const uint16*)prev_level_mesh.index_data.data())[i];
+	}
+	else if(prev_level_mesh.index_type == BatchedMesh::ComponentType_UInt32)
+	{
+		std::memcpy(indices.data(), prev_level_mesh.index_data.data(), num_indices * sizeof(uint32));
+	}
+	else
+		throw glare::Exception("Invalid index type.");
+
+	for(size_t i=0; i<num_indices; ++i)
+		runtimeCheck(indices[i] < num_verts);
+
+	std::vector<uint32> all_verts(num_verts);
+	for(size_t i=0; i<num_verts; ++i)
+		all_verts[i] = (uint32)i;
+	const float mesh_extent = getPositionsExtent(positions.data(), all_verts.data(), num_verts);
+
+	js::Vector<uint32> new_indices;
+	std::vector<BatchedMesh::IndicesBatch> new_batches;
+	simplifyBatches(prev_level_mesh, positions, indices, mesh_extent, params, task_manager, new_indices, new_batches);
+
+	// Optimise vertex fetch for the whole mesh, which also removes unused vertices.
+	std::vector<uint32> remap(num_verts);
+	size_t new_num_verts = meshopt_optimizeVertexFetchRemap(remap.data(), new_indices.data(), new_indices.size(), num_verts);
+
+	// If we achieved less than a 4x reduction in the number of vertices (and this is a med/large mesh), try again with sloppy simplification
+	if(!params.sloppy && (num_verts > 1024) && ((float)new_num_verts > (num_verts / 4.f)))
+	{
+		LODLevelSimplifyParams sloppy_params = params;
+		sloppy_params.sloppy = true;
+		simplifyBatches(prev_level_mesh, positions, indices, mesh_extent, sloppy_params, task_manager, new_indices, new_batches);
+
+		new_num_verts = meshopt_optimizeVertexFetchRemap(remap.data(), new_indices.data(), new_indices.size(), num_verts);
+	}
+
+	meshopt_remapIndexBuffer(new_indices.data(), new_indices.data(), new_indices.size(), remap.data());
+
+	// Build the new mesh
+	BatchedMeshRef simplified_mesh = new BatchedMesh();
+	simplified_mesh->vert_attributes = prev_level_mesh.vert_attributes;
+	simplified_mesh->animation_data = prev_level_mesh.animation_data;
+
+	simplified_mesh->vertex_data.resize(new_num_verts * vert_size);
+	js::AABBox aabb_os = js::AABBox::emptyAABBox();
+	for(size_t i=0; i<num_verts; ++i)
+	{
+		if(remap[i] != ~0u)
+		{
+			std::memcpy(simplified_mesh->vertex_data.data() + remap[i] * vert_size, src_vertex_data + i * vert_size, vert_size);
+			aabb_os.enlargeToHoldPoint(Vec4f(positions[i].x, positions[i].y, positions[i].z, 1.f));
+		}
 	}
+	simplified_mesh->aabb_os = (new_num_verts > 0) ? aabb_os : js::AABBox(Vec4f(0,0,0,1), Vec4f(0,0,0,1));
+
+	if(!new_indices.empty())
+		simplified_mesh->setIndexDataFromIndices(new_indices, new_num_verts);
+	simplified_mesh->batches = new_batches;
+
 	return simplified_mesh;
 }
 
 
+BatchedMeshRef computeLODModel(BatchedMeshRef batched_mesh, int lod_level)
+{
+	BatchedMeshRef mesh = batched_mesh;
+	for(int lvl=1; lvl<=lod_level; ++lvl)
+		mesh = computeNextLODModel(*mesh, lvl, /*task_manager=*/NULL);
+	return mesh;
+}
+
+
 void generateLODModel(BatchedMeshRef batched_mesh, int lod_level, const std::string& LOD_model_path)
 {
 	BatchedMeshRef simplified_mesh = computeLODModel(batched_mesh, lod_level);
@@ -127,30 +372,90 @@ void generateLODModel(BatchedMeshRef batched_mesh, int lod_level, const std::str
 
 void generateLODModel(const std::string& model_path, int lod_level, const std::string& LOD_model_path)
 {
-	BatchedMeshRef batched_mesh = loadModel(model_path);
-
-	generateLODModel(batched_mesh, lod_level, LOD_model_path);
+	std::vector<LODChainLevel> levels(1, LODChainLevel(lod_level, LOD_model_path));
+	LODChainStats stats;
+	generateLODChain(model_path, levels, /*build_optimised_meshes=*/false, /*task_manager=*/NULL, stats);
 }
 
 
 void generateOptimisedMesh(const std::string& source_mesh_abs_path, int lod_level, const std::string& optimised_mesh_path)
 {
-	BatchedMeshRef batched_mesh = LODGeneration::loadModel(source_mesh_abs_path);
+	std::vector<LODChainLevel> levels(1, LODChainLevel(lod_level, optimised_mesh_path));
+	LODChainStats stats;
+	generateLODChain(source_mesh_abs_path, levels, /*build_optimised_meshes=*/true, /*task_manager=*/NULL, stats);
+}
 
-	if(lod_level > 0)
-		batched_mesh = LODGeneration::computeLODModel(batched_mesh, lod_level);
 
-	BatchedMesh::QuantiseOptions quantise_options;
-	quantise_options.pos_bits = (lod_level == 0) ? 16 : 12;
-	quantise_options.uv_bits  = (lod_level == 0) ? 16 : 10;
-	batched_mesh = batched_mesh->buildQuantisedMesh(quantise_options);
+// Writes the mesh for a single LOD level.  Updates stats_out.peak_mesh_mem_B with the memory used by any quantised copy.
+static void writeLODChainLevel(const BatchedMesh& mesh, size_t live_mesh_mem_B, int lod_level, bool build_optimised_mesh, const std::string& output_path, LODChainStats& stats_out)
+{
+	if(build_optimised_mesh)
+	{
+		BatchedMesh::QuantiseOptions quantise_options;
+		quantise_options.pos_bits = (lod_level == 0) ? 16 : 12;
+		quantise_options.uv_bits  = (lod_level == 0) ? 16 : 10;
+		BatchedMeshRef quantised_mesh = mesh.buildQuantisedMesh(quantise_options);
+
+		stats_out.peak_mesh_mem_B = myMax(stats_out.peak_mesh_mem_B, live_mesh_mem_B + quantised_mesh->getTotalMemUsage());
 
-	batched_mesh->doMeshOptimizerOptimisations();
+		if(lod_level == 0)
+			quantised_mesh->doMeshOptimizerOptimisations(); // Simplified levels have already been optimised by computeNextLODModel().
 
-	BatchedMesh::WriteOptions options;
-	options.use_meshopt = true;
-	options.compression_level = 19;
-	batched_mesh->writeToFile(optimised_mesh_path, options);
+		BatchedMesh::WriteOptions options;
+		options.use_meshopt = true;
+		options.compression_level = 19;
+		quantised_mesh->writeToFile(output_path, options);
+	}
+	else
+	{
+		mesh.writeToFile(output_path);
+	}
+}
+
+
+void generateLODChain(const std::string& model_path, const std::vector<LODChainLevel>& levels, bool build_optimised_meshes, glare::TaskManager* task_manager, LODChainStats& stats_out)
+{
+	stats_out = LODChainStats();
+
+	int max_lod_level = 0;
+	for(size_t i=0; i<levels.size(); ++i)
+	{
+		if(levels[i].lod_level < 0 || levels[i].lod_level > 2)
+			throw glare::Exception("Invalid LOD level " + toString(levels[i].lod_level));
+		max_lod_level = myMax(max_lod_level, levels[i].lod_level);
+	}
+
+	Timer timer;
+	BatchedMeshRef mesh = loadModel(model_path);
+	stats_out.load_time_s = timer.elapsed();
+
+	size_t mesh_mem_B = mesh->getTotalMemUsage();
+	stats_out.peak_mesh_mem_B = mesh_mem_B;
+
+	for(int lvl=0; lvl<=max_lod_level; ++lvl)
+	{
+		if(lvl > 0)
+		{
+			timer.reset();
+			BatchedMeshRef next_level_mesh = computeNextLODModel(*mesh, lvl, task_manager);
+			stats_out.simplify_time_s += timer.elapsed();
+
+			const size_t next_level_mesh_mem_B = next_level_mesh->getTotalMemUsage();
+			stats_out.peak_mesh_mem_B = myMax(stats_out.peak_mesh_mem_B, mesh_mem_B + next_level_mesh_mem_B);
+
+			mesh = next_level_mesh; // Frees the previous level mesh.
+			mesh_mem_B = next_level_mesh_mem_B;
+		}
+
+		// Write out any requested outputs for this level now, so we don't need to keep this level around.
+		for(size_t i=0; i<levels.size(); ++i)
+			if(levels[i].lod_level == lvl)
+			{
+				timer.reset();
+				writeLODChainLevel(*mesh, mesh_mem_B, lvl, build_optimised_meshes, levels[i].output_path, stats_out);
+				stats_out.write_time_s += timer.elapsed();
+			}
+	}
 }
 
 
@@ -188,92 +493,138 @@ static Reference<ImageMapUInt8> convertUInt16ToUInt8ImageMap(const ImageMap<uint
 }
 
 
-void generateLODTexture(const std::string& base_tex_path, int lod_level, const std::string& LOD_tex_path, glare::TaskManager& task_manager)
+// Computes the size of a texture resized to fit within new_max_w_h, keeping the aspect ratio.  Doesn't upsample.
+static void computeResizedTextureSize(int map_w, int map_h, int new_max_w_h, int& new_w_out, int& new_h_out)
 {
-	const int new_max_w_h = (lod_level == 0) ? 1024 : ((lod_level == 1) ? 256 : 64);
 	const int min_w_h = 1;
-
-	Reference<Map2D> map;
-	if(hasExtension(base_tex_path, "gif"))
+	if(map_w > map_h)
+	{
+		new_w_out = myMin(map_w, new_max_w_h);
+		new_h_out = myMax(min_w_h, (int)((float)new_w_out * (float)map_h / (float)map_w));
+	}
+	else
 	{
-		GIFDecoder::resizeGIF(base_tex_path, LOD_tex_path, new_max_w_h);
+		new_h_out = myMin(map_h, new_max_w_h);
+		new_w_out = myMax(min_w_h, (int)((float)new_h_out * (float)map_w / (float)map_h));
 	}
+}
+
+
+// Loads and decodes the texture, through image_cache if it is non-NULL.  The returned map may be shared with other threads, so must not be modified.
+static Reference<Map2D> decodeTexture(const std::string& tex_path, DecodedImageCache* image_cache, uint64 content_hash)
+{
+	if(image_cache)
+		return image_cache->getOrDecodeImage(tex_path, content_hash);
 	else
+		return ImageDecoding::decodeImage(".", tex_path);
+}
+
+
+static int maxLODTextureWidthHeight(int lod_level)
+{
+	return (lod_level == 0) ? 1024 : ((lod_level == 1) ? 256 : 64);
+}
+
+
+void generateLODTexture(const std::string& base_tex_path, int lod_level, const std::string& LOD_tex_path, glare::TaskManager& task_manager)
+{
+	std::vector<LODTextureLevel> levels(1, LODTextureLevel(lod_level, LOD_tex_path));
+	generateLODTextures(base_tex_path, levels, /*srgb=*/true, task_manager);
+}
+
+
+void generateLODTextures(const std::string& base_tex_path, const std::vector<LODTextureLevel>& levels, bool srgb, glare::TaskManager& task_manager,
+	DecodedImageCache* image_cache, uint64 base_tex_content_hash)
+{
+	if(hasExtension(base_tex_path, "gif"))
 	{
-		map = ImageDecoding::decodeImage(".", base_tex_path); // Load texture from disk and decode it.
+		for(size_t i=0; i<levels.size(); ++i)
+			GIFDecoder::resizeGIF(base_tex_path, levels[i].output_path, maxLODTextureWidthHeight(levels[i].lod_level));
+		return;
+	}
 
-		// If the map is a 16-bit image, convert to 8-bit first.
-		if(dynamic_cast<const ImageMap<uint16, UInt16ComponentValueTraits>*>(map.ptr()))
-		{
-			map = convertUInt16ToUInt8ImageMap(static_cast<const ImageMap<uint16, UInt16ComponentValueTraits>&>(*map));
-		}
+	Reference<Map2D> map = decodeTexture(base_tex_path, image_cache, base_tex_content_hash); // Load texture from disk and decode it.
 
-		if((map->getMapWidth() == 0) || (map->getMapHeight() == 0) || (map->numChannels() == 0))
-			throw glare::Exception("Invalid image dimensions (zero)");
+	// If the map is a 16-bit image, convert to 8-bit first.
+	if(dynamic_cast<const ImageMap<uint16, UInt16ComponentValueTraits>*>(map.ptr()))
+	{
+		map = convertUInt16ToUInt8ImageMap(static_cast<const ImageMap<uint16, UInt16ComponentValueTraits>&>(*map));
+	}
 
-		if(dynamic_cast<const ImageMapUInt8*>(map.ptr()))
-		{
-			int new_w, new_h;
-			if(map->getMapWidth() > map->getMapHeight())
-			{
-				new_w = myMin((int)map->getMapWidth(), new_max_w_h);
-				new_h = myMax(min_w_h, (int)((float)new_w * (float)map->getMapHeight() / (float)map->getMapWidth()));
-			}
-			else
-			{
-				new_h = myMin((int)map->getMapHeight(), new_max_w_h);
-				new_w = myMax(min_w_h, (int)((float)new_h * (float)map->getMapWidth() / (float)map->getMapHeight()));
-			}
+	if((map->getMapWidth() == 0) || (map->getMapHeight() == 0) || (map->numChannels() == 0))
+		throw glare::Exception("Invalid image dimensions (zero)");
 
-			conPrint("\tMaking LOD texture with dimensions " + toString(new_w) + " * " + toString(new_h) + " for LOD level " + toString(lod_level));
+	if(!dynamic_cast<const ImageMapUInt8*>(map.ptr()))
+		throw glare::Exception("Unhandled image type (not ImageMapUInt8): " + base_tex_path);
 
-			const ImageMapUInt8* imagemap = map.downcastToPtr<ImageMapUInt8>();
+	const ImageMapUInt8* imagemap = map.downcastToPtr<ImageMapUInt8>();
 
-			Reference<Map2D> resized_map = imagemap->resizeMidQuality(new_w, new_h, &task_manager);
-			assert(resized_map.isType<ImageMapUInt8>());
+	// Downsample to all the LOD levels in a single pass over the base texture.
+	std::vector<TextureDownsampling::DownsampleOutput> outputs(levels.size());
+	for(size_t i=0; i<levels.size(); ++i)
+	{
+		computeResizedTextureSize((int)map->getMapWidth(), (int)map->getMapHeight(), maxLODTextureWidthHeight(levels[i].lod_level), outputs[i].dst_w, outputs[i].dst_h);
 
-			// Save as a JPEG or PNG depending if there is an alpha channel.
-			if(hasExtension(LOD_tex_path, "jpg"))
-			{
-				if(resized_map->numChannels() > 3)
-				{
-					// Convert to a 3 channel image
-					resized_map = resized_map.downcast<ImageMapUInt8>()->extract3ChannelImage();
-				}
+		conPrint("\tMaking LOD texture with dimensions " + toString(outputs[i].dst_w) + " * " + toString(outputs[i].dst_h) + " for LOD level " + toString(levels[i].lod_level));
+	}
 
+	TextureDownsampling::DownsampleOptions options;
+	options.srgb = srgb;
+	TextureDownsampling::downsample(*imagemap, outputs, options, &task_manager);
 
-				JPEGDecoder::SaveOptions options;
-				options.quality = 90;
-				JPEGDecoder::save(resized_map.downcast<ImageMapUInt8>(), LOD_tex_path, options);
-			}
-			else if(hasExtension(LOD_tex_path, "png"))
-			{
-				PNGDecoder::write(*resized_map.downcastToPtr<ImageMapUInt8>(), LOD_tex_path);
-			}
-			else
+	for(size_t i=0; i<levels.size(); ++i)
+	{
+		const std::string& LOD_tex_path = levels[i].output_path;
+		ImageMapUInt8Ref resized_map = outputs[i].result;
+
+		// Save as a JPEG or PNG depending if there is an alpha channel.
+		if(hasExtension(LOD_tex_path, "jpg"))
+		{
+			if(resized_map->numChannels() > 3)
 			{
-				throw glare::Exception("not saving basis files in generateLODTexture().");
+				// Convert to a 3 channel image
+				resized_map = resized_map->extract3ChannelImage();
 			}
+
+
+			JPEGDecoder::SaveOptions save_options;
+			save_options.quality = 90;
+			JPEGDecoder::save(resized_map, LOD_tex_path, save_options);
+		}
+		else if(hasExtension(LOD_tex_path, "png"))
+		{
+			PNGDecoder::write(*resized_map, LOD_tex_path);
 		}
 		else
-			throw glare::Exception("Unhandled image type (not ImageMapUInt8): " + base_tex_path);
+		{
+			throw glare::Exception("not saving basis files in generateLODTexture().");
+		}
 	}
 }
 
 
-void generateBasisTexture(const std::string& src_tex_path, int base_lod_level, int lod_level, const std::string& basis_tex_path, glare::TaskManager& task_manager)
+void generateBasisTexture(const std::string& src_tex_path, int base_lod_level, int lod_level, const std::string& basis_tex_path, bool srgb, glare::TaskManager& task_manager,
+	DecodedImageCache* image_cache, uint64 src_tex_content_hash)
 {
 #if GUI_CLIENT
 	throw glare::Exception("generateBasisTexture not supported.");
 #else
+	int quality_level;
+	Reference<Map2D> map = makeBasisTextureSourceImage(src_tex_path, base_lod_level, lod_level, srgb, task_manager, image_cache, src_tex_content_hash, quality_level);
+
+	writeBasisUniversalFileForMap(*map, basis_tex_path, quality_level, /*num_threads=*/0);
+#endif
+}
+
 
+Reference<Map2D> makeBasisTextureSourceImage(const std::string& src_tex_path, int base_lod_level, int lod_level, bool srgb, glare::TaskManager& task_manager,
+	DecodedImageCache* image_cache, uint64 src_tex_content_hash, int& quality_level_out)
+{
 	int new_max_w_h;
 	if(lod_level == base_lod_level)
 		new_max_w_h = 4096; // Basis compression can get pretty slow for large textures, so limit the texture size.
 	else
-		new_max_w_h = (lod_level == 0) ? 1024 : ((lod_level == 1) ? 256 : 64);
-
-	const int min_w_h = 1;
+		new_max_w_h = maxLODTextureWidthHeight(lod_level);
 
 	Reference<Map2D> map;
 	if(hasExtension(src_tex_path, "gif"))
@@ -283,7 +634,7 @@ void generateBasisTexture(const std::string& src_tex_path, int base_lod_level, i
 	else
 	{
 		//Timer timer;
-		map = ImageDecoding::decodeImage(".", src_tex_path); // Load texture from disk and decode it.
+		map = decodeTexture(src_tex_path, image_cache, src_tex_content_hash); // Load texture from disk and decode it.
 		//conPrint("Decoding took " + timer.elapsedString());
 	}
 
@@ -297,35 +648,35 @@ void generateBasisTexture(const std::string& src_tex_path, int base_lod_level, i
 		throw glare::Exception("Invalid image dimensions (zero)");
 
 	int new_w, new_h;
-	if(map->getMapWidth() > map->getMapHeight())
-	{
-		new_w = myMin((int)map->getMapWidth(), new_max_w_h);
-		new_h = myMax(min_w_h, (int)((float)new_w * (float)map->getMapHeight() / (float)map->getMapWidth()));
-	}
-	else
-	{
-		new_h = myMin((int)map->getMapHeight(), new_max_w_h);
-		new_w = myMax(min_w_h, (int)((float)new_h * (float)map->getMapWidth() / (float)map->getMapHeight()));
-	}
-
+	computeResizedTextureSize((int)map->getMapWidth(), (int)map->getMapHeight(), new_max_w_h, new_w, new_h);
 
 	new_w = Maths::roundUpToMultipleOfPowerOf2(new_w, 4); // There seems to be a WebGL / 3.js limitation where the texture dimensions must be a multiple of 4.
 	new_h = Maths::roundUpToMultipleOfPowerOf2(new_h, 4);
 
-	int quality_level = 255;
+	quality_level_out = 255;
 	if(lod_level >= 1)
-		quality_level = 128;
+		quality_level_out = 128;
 
-	conPrint("\tMaking basis file with dimensions " + toString(new_w) + " * " + toString(new_h) + ", quality " + toString(quality_level) + " for LOD level " + toString(lod_level));
+	conPrint("\tMaking basis file with dimensions " + toString(new_w) + " * " + toString(new_h) + ", quality " + toString(quality_level_out) + " for LOD level " + toString(lod_level));
 
 	if(dynamic_cast<const ImageMapUInt8*>(map.ptr()))
 	{
 		const ImageMapUInt8* imagemap = map.downcastToPtr<ImageMapUInt8>();
 
-		Reference<Map2D> resized_map = imagemap->resizeMidQuality(new_w, new_h, &task_manager);
-		runtimeCheck(resized_map.isType<ImageMapUInt8>());
-
-		writeBasisUniversalFile(*resized_map.downcast<ImageMapUInt8>(), basis_tex_path, quality_level);
+		if((new_w <= (int)imagemap->getWidth()) && (new_h <= (int)imagemap->getHeight()))
+		{
+			std::vector<TextureDownsampling::DownsampleOutput> outputs(1, TextureDownsampling::DownsampleOutput(new_w, new_h));
+			TextureDownsampling::DownsampleOptions options;
+			options.srgb = srgb;
+			TextureDownsampling::downsample(*imagemap, outputs, options, &task_manager);
+			return outputs[0].result;
+		}
+		else // Else if rounding up to a multiple of 4 made the texture larger than the source:
+		{
+			Reference<Map2D> upsampled_map = imagemap->resizeMidQuality(new_w, new_h, &task_manager);
+			runtimeCheck(upsampled_map.isType<ImageMapUInt8>());
+			return upsampled_map;
+		}
 	}
 	else if(dynamic_cast<const ImageMapSequenceUInt8*>(map.ptr()))
 	{
@@ -333,17 +684,25 @@ void generateBasisTexture(const std::string& src_tex_path, int base_lod_level, i
 
 		Reference<Map2D> resized_seq = seq->resizeMidQuality(new_w, new_h, &task_manager);
 		runtimeCheck(resized_seq.isType<ImageMapSequenceUInt8>());
-
-		writeBasisUniversalFileForSequence(*resized_seq.downcast<ImageMapSequenceUInt8>(), basis_tex_path, quality_level);
+		return resized_seq;
 	}
 	else
 		throw glare::Exception("Unhandled image type: " + src_tex_path);
-	
-#endif
 }
 
 
-void writeBasisUniversalFile(const ImageMapUInt8& imagemap, const std::string& path, int quality_level)
+void writeBasisUniversalFileForMap(const Map2D& map, const std::string& path, int quality_level, int num_threads)
+{
+	if(const ImageMapUInt8* imagemap = dynamic_cast<const ImageMapUInt8*>(&map))
+		writeBasisUniversalFile(*imagemap, path, quality_level, num_threads);
+	else if(const ImageMapSequenceUInt8* seq = dynamic_cast<const ImageMapSequenceUInt8*>(&map))
+		writeBasisUniversalFileForSequence(*seq, path, quality_level, num_threads);
+	else
+		throw glare::Exception("Unhandled image type for Basis file: " + path);
+}
+
+
+void writeBasisUniversalFile(const ImageMapUInt8& imagemap, const std::string& path, int quality_level, int num_threads)
 {
 #if GUI_CLIENT
 	throw glare::Exception("writeBasisUniversalFile not supported.");
@@ -372,7 +731,7 @@ void writeBasisUniversalFile(const ImageMapUInt8& imagemap, const std::string& p
 
 	//Timer timer2;
 	//printVar(PlatformUtils::getNumLogicalProcessors());
-	basisu::job_pool jpool(PlatformUtils::getNumLogicalProcessors() / 2); // TODO: don't recreate this for each image.
+	basisu::job_pool jpool((num_threads > 0) ? (uint32)num_threads : (PlatformUtils::getNumLogicalProcessors() / 2)); // TODO: don't recreate this for each image.
 	params.m_pJob_pool = &jpool;
 	//conPrint("Creating job pool took " + timer2.elapsedString());
 
@@ -393,7 +752,7 @@ void writeBasisUniversalFile(const ImageMapUInt8& imagemap, const std::string& p
 }
 
 
-void writeBasisUniversalFileForSequence(const ImageMapSequenceUInt8& imagemapseq, const std::string& path, int quality_level)
+void writeBasisUniversalFileForSequence(const ImageMapSequenceUInt8& imagemapseq, const std::string& path, int quality_level, int num_threads)
 {
 #if GUI_CLIENT
 	throw glare::Exception("writeBasisUniversalFileForSequence not supported.");
@@ -426,7 +785,7 @@ void writeBasisUniversalFileForSequence(const ImageMapSequenceUInt8& imagemapseq
 	params.m_etc1s_quality_level = quality_level;
 
 	//Timer timer2;
-	basisu::job_pool jpool(PlatformUtils::getNumLogicalProcessors() / 2); // TODO: don't recreate this for each image.
+	basisu::job_pool jpool((num_threads > 0) ? (uint32)num_threads : (PlatformUtils::getNumLogicalProcessors() / 2)); // TODO: don't recreate this for each image.
 	params.m_pJob_pool = &jpool;
 	//conPrint("Creating job pool took " + timer2.elapsedString());
 
@@ -537,6 +896,145 @@ bool texHasAlpha(const std::string& tex_path, std::map<std::string, bool>& tex_h
 #include "../utils/Timer.h"
 
 
+namespace LODGeneration
+{
+
+
+// Makes a mesh with num_batches wavy grids side by side, each grid in its own batch.
+static BatchedMeshRef makeTestGridMesh(int num_batches, int grid_res)
+{
+	BatchedMeshRef mesh = new BatchedMesh();
+	mesh->vert_attributes.push_back(BatchedMesh::VertAttribute(BatchedMesh::VertAttribute_Position, BatchedMesh::ComponentType_Float, /*offset_B=*/0));
+
+	const int verts_per_side = grid_res + 1;
+	mesh->vertex_data.resize((size_t)num_batches * verts_per_side * verts_per_side * sizeof(Vec3f));
+	js::Vector<uint32> indices;
+	js::AABBox aabb_os = js::AABBox::emptyAABBox();
+	for(int b=0; b<num_batches; ++b)
+	{
+		const uint32 batch_vert_start = (uint32)(b * verts_per_side * verts_per_side);
+		for(int y=0; y<verts_per_side; ++y)
+		for(int x=0; x<verts_per_side; ++x)
+		{
+			const float px = b + (float)x / grid_res;
+			const float py = (float)y / grid_res;
+			const Vec3f pos(px, py, 0.05f * std::sin(px * 20.f) * std::cos(py * 13.f));
+			std::memcpy(mesh->vertex_data.data() + (batch_vert_start + y * verts_per_side + x) * sizeof(Vec3f), &pos, sizeof(Vec3f));
+			aabb_os.enlargeToHoldPoint(Vec4f(pos.x, pos.y, pos.z, 1.f));
+		}
+
+		BatchedMesh::IndicesBatch batch;
+		batch.indices_start = (uint32)indices.size();
+		batch.material_index = b % 4;
+		for(int y=0; y<grid_res; ++y)
+		for(int x=0; x<grid_res; ++x)
+		{
+			const uint32 v00 = batch_vert_start + y * verts_per_side + x;
+			const uint32 v10 = v00 + 1;
+			const uint32 v01 = v00 + verts_per_side;
+			const uint32 v11 = v01 + 1;
+			indices.push_back(v00); indices.push_back(v10); indices.push_back(v11);
+			indices.push_back(v00); indices.push_back(v11); indices.push_back(v01);
+		}
+		batch.num_indices = (uint32)indices.size() - batch.indices_start;
+		mesh->batches.push_back(batch);
+	}
+	mesh->setIndexDataFromIndices(indices, mesh->numVerts());
+	mesh->aabb_os = aabb_os;
+	return mesh;
+}
+
+
+static void checkLODMesh(const BatchedMesh& lod_mesh, const BatchedMesh& prev_mesh)
+{
+	testAssert(lod_mesh.numIndices() > 0);
+	testAssert(lod_mesh.numIndices() < prev_mesh.numIndices());
+	testAssert(lod_mesh.numVerts() < prev_mesh.numVerts());
+	testAssert(lod_mesh.batches.size() <= prev_mesh.batches.size());
+
+	size_t num_batch_indices = 0;
+	for(size_t b=0; b<lod_mesh.batches.size(); ++b)
+	{
+		testAssert(lod_mesh.batches[b].indices_start == num_batch_indices);
+		num_batch_indices += lod_mesh.batches[b].num_indices;
+	}
+	testAssert(num_batch_indices == lod_mesh.numIndices());
+}
+
+
+static void testLODChainGeneration(glare::TaskManager& task_manager)
+{
+	// Test computeNextLODModel on a small mesh
+	{
+		BatchedMeshRef mesh = makeTestGridMesh(/*num_batches=*/3, /*grid_res=*/32);
+		BatchedMeshRef lod1_mesh = computeNextLODModel(*mesh, 1, &task_manager);
+		checkLODMesh(*lod1_mesh, *mesh);
+		BatchedMeshRef lod2_mesh = computeNextLODModel(*lod1_mesh, 2, &task_manager);
+		checkLODMesh(*lod2_mesh, *lod1_mesh);
+
+		// Results shouldn't depend on whether a task manager is used.
+		BatchedMeshRef serial_lod1_mesh = computeNextLODModel(*mesh, 1, /*task_manager=*/NULL);
+		testAssert(serial_lod1_mesh->numIndices() == lod1_mesh->numIndices());
+		testAssert(serial_lod1_mesh->numVerts() == lod1_mesh->numVerts());
+		testAssert(serial_lod1_mesh->index_data.size() == lod1_mesh->index_data.size() && std::memcmp(serial_lod1_mesh->index_data.data(), lod1_mesh->index_data.data(), lod1_mesh->index_data.size()) == 0);
+		testAssert(serial_lod1_mesh->vertex_data.size() == lod1_mesh->vertex_data.size() && std::memcmp(serial_lod1_mesh->vertex_data.data(), lod1_mesh->vertex_data.data(), lod1_mesh->vertex_data.size()) == 0);
+	}
+
+	// Test generateLODChain, writing all levels from a single load of the source model.
+	{
+		BatchedMeshRef mesh = makeTestGridMesh(/*num_batches=*/4, /*grid_res=*/64);
+		const std::string src_path = PlatformUtils::getTempDirPath() + "/lod_chain_src.bmesh";
+		mesh->writeToFile(src_path);
+
+		std::vector<LODChainLevel> levels;
+		levels.push_back(LODChainLevel(2, PlatformUtils::getTempDirPath() + "/lod_chain_lod2.bmesh")); // Out of order, should still work.
+		levels.push_back(LODChainLevel(0, PlatformUtils::getTempDirPath() + "/lod_chain_lod0.bmesh"));
+		levels.push_back(LODChainLevel(1, PlatformUtils::getTempDirPath() + "/lod_chain_lod1.bmesh"));
+		LODChainStats stats;
+		generateLODChain(src_path, levels, /*build_optimised_meshes=*/true, &task_manager, stats);
+
+		BatchedMeshRef lod0_mesh = loadModel(levels[1].output_path);
+		BatchedMeshRef lod1_mesh = loadModel(levels[2].output_path);
+		BatchedMeshRef lod2_mesh = loadModel(levels[0].output_path);
+		testAssert(lod0_mesh->numIndices() == mesh->numIndices());
+		checkLODMesh(*lod1_mesh, *lod0_mesh);
+		checkLODMesh(*lod2_mesh, *lod1_mesh);
+		testAssert(stats.peak_mesh_mem_B >= mesh->getTotalMemUsage());
+	}
+
+	// Benchmark on a large mesh: simplifying each level from the full-resolution mesh, vs simplifying each level from the previous level per batch.
+	{
+		BatchedMeshRef mesh = makeTestGridMesh(/*num_batches=*/16, /*grid_res=*/256);
+		conPrint("Large mesh: " + toString(mesh->numVerts()) + " verts, " + toString(mesh->numIndices() / 3) + " tris, " + toString(mesh->batches.size()) + " batches");
+
+		{
+			Timer timer;
+			BatchedMeshRef lod1_mesh = MeshSimplification::buildSimplifiedMesh(*mesh, /*target_reduction_ratio=*/10.f, /*target_error=*/0.02f, /*sloppy=*/false);
+			lod1_mesh->doMeshOptimizerOptimisations();
+			const size_t lod1_mem_B = lod1_mesh->getTotalMemUsage();
+			lod1_mesh = NULL;
+			BatchedMeshRef lod2_mesh = MeshSimplification::buildSimplifiedMesh(*mesh, /*target_reduction_ratio=*/100.f, /*target_error=*/0.08f, /*sloppy=*/true);
+			lod2_mesh->doMeshOptimizerOptimisations();
+			conPrint("Simplifying each level from level 0:     " + timer.elapsedStringNSigFigs(4) + ", peak mesh mem: " + getNiceByteSize(mesh->getTotalMemUsage() + myMax(lod1_mem_B, lod2_mesh->getTotalMemUsage())) + 
+				", lod 2 tris: " + toString(lod2_mesh->numIndices() / 3));
+		}
+		{
+			Timer timer;
+			BatchedMeshRef lod1_mesh = computeNextLODModel(*mesh, 1, &task_manager);
+			checkLODMesh(*lod1_mesh, *mesh);
+			const size_t peak_mem_B = mesh->getTotalMemUsage() + lod1_mesh->getTotalMemUsage();
+			BatchedMeshRef lod2_mesh = computeNextLODModel(*lod1_mesh, 2, &task_manager);
+			checkLODMesh(*lod2_mesh, *lod1_mesh);
+			conPrint("Simplifying each level from prev level: " + timer.elapsedStringNSigFigs(4) + ", peak mesh mem: " + getNiceByteSize(peak_mem_B) + ", lod 2 tris: " + toString(lod2_mesh->numIndices() / 3) +
+				" (" + toString(task_manager.getNumThreads()) + " threads)");
+		}
+	}
+}
+
+
+} // end namespace LODGeneration
+
+
 void LODGeneration::test()
 {
 	conPrint("LODGeneration::test()");
@@ -545,6 +1043,7 @@ void LODGeneration::test()
 
 	try
 	{
+		testLODChainGeneration(task_manager);
 
 #if !GUI_CLIENT  // generateBasisTexture is disabled in gui_client.
 		// Test generateBasisTexture on an animated gif.
@@ -553,6 +1052,7 @@ void LODGeneration::test()
 				0, // base lod level
 				0, // lod level
 				"d:/files/fire_gif.basis", // basis_tex_path
+				true, // srgb
 				task_manager);
 		}
 		
@@ -562,6 +1062,7 @@ void LODGeneration::test()
 				0, // base lod level
 				0, // lod level
 				"d:/files/cow_gif.basis", // basis_tex_path
+				true, // srgb
 				task_manager);
 		}
 
@@ -576,6 +1077,7 @@ void LODGeneration::test()
 				0, // base lod level
 				0, // lod level
 				"d:/files/QueenPalmTree_BaseColor_png_9712663273203237448.basis", // basis_tex_path
+				true, // srgb
 				task_manager);
 
 			/*Reference<Map2D> lod_map = ImageDecoding::decodeImage(".", lod_tex_path);
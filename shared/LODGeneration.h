@@ -12,9 +12,11 @@ Copyright Glare Technologies Limited 2021 -
 #include <graphics/ImageMap.h>
 #include <graphics/ImageMapSequence.h>
 #include <string>
+#include <vector>
 class WorldMaterial;
 class WorldObject;
 class ResourceManager;
+class DecodedImageCache;
 namespace glare { class TaskManager; }
 
 
@@ -26,8 +28,21 @@ LODGeneration
 namespace LODGeneration
 {
 
+// Versions of the generation code, used in derived-asset store keys.  Bump when the output of the corresponding generation function changes.
+// Bumping a version only stops reuse of stored outputs for new generations; LOD files already present for an object are not regenerated.
+const uint32 LOD_MODEL_GEN_VERSION = 2; // 2: LOD levels are simplified from the previous level, per batch.
+const uint32 LOD_TEXTURE_GEN_VERSION = 2; // 2: Box filtered with TextureDownsampling, in linear space for sRGB textures.
+const uint32 BASIS_TEXTURE_GEN_VERSION = 3; // 2: Box filtered with TextureDownsampling.  3: In linear space for sRGB textures.
+
+
 BatchedMeshRef loadModel(const std::string& model_path);
 
+// Simplifies prev_level_mesh, which should be the mesh for LOD level lod_level - 1, to make the mesh for LOD level lod_level (1 or 2).
+// Each batch is simplified separately, in parallel on task_manager if it is non-NULL.
+// Vertex cache and vertex fetch optimisations are done on the result, so it doesn't need doMeshOptimizerOptimisations().
+BatchedMeshRef computeNextLODModel(const BatchedMesh& prev_level_mesh, int lod_level, glare::TaskManager* task_manager);
+
+// Computes the LOD model for lod_level from the full-resolution mesh, by simplifying through each LOD level in turn.
 BatchedMeshRef computeLODModel(BatchedMeshRef batched_mesh, int lod_level);
 
 // Generate and save to disk
@@ -37,18 +52,70 @@ void generateLODModel(const std::string& model_path, int lod_level, const std::s
 
 void generateOptimisedMesh(const std::string& source_mesh_abs_path, int lod_level, const std::string& optimised_mesh_path);
 
+
+struct LODChainLevel
+{
+	LODChainLevel(int lod_level_, const std::string& output_path_) : lod_level(lod_level_), output_path(output_path_) {}
+
+	int lod_level; // 0, 1 or 2
+	std::string output_path;
+};
+
+struct LODChainStats
+{
+	LODChainStats() : peak_mesh_mem_B(0), load_time_s(0), simplify_time_s(0), write_time_s(0) {}
+
+	size_t peak_mesh_mem_B; // Peak total memory used by the meshes held at once.
+	double load_time_s;
+	double simplify_time_s;
+	double write_time_s;
+};
+
+// Loads the model once, then generates the given LOD levels as a chain, each level simplified from the previous one (see computeNextLODModel()).
+// Each level is written out as soon as it has been computed, and only the current and next level meshes are held at once, to keep peak memory usage down.
+// If build_optimised_meshes is true, writes optimised meshes as with generateOptimisedMesh(), otherwise writes LOD models as with generateLODModel().
+void generateLODChain(const std::string& model_path, const std::vector<LODChainLevel>& levels, bool build_optimised_meshes, glare::TaskManager* task_manager, LODChainStats& stats_out);
+
 bool textureHasAlphaChannel(const std::string& tex_path, Map2DRef map);
 
+// Treats the texture as sRGB, see generateLODTextures().
 void generateLODTexture(const std::string& base_tex_path, int lod_level, const std::string& LOD_tex_path, glare::TaskManager& task_manager);
 
-void generateBasisTexture(const std::string& src_tex_path, int base_lod_level, int lod_level, const std::string& basis_tex_path, glare::TaskManager& task_manager);
+struct LODTextureLevel
+{
+	LODTextureLevel(int lod_level_, const std::string& output_path_) : lod_level(lod_level_), output_path(output_path_) {}
+
+	int lod_level; // 0, 1 or 2
+	std::string output_path; // Should have a jpg or png extension.
+};
+
+// Decodes the base texture once, then makes all the given LOD level textures from it in a single downsampling pass (see TextureDownsampling).
+// srgb should be true for colour textures, and false for textures with linear data, such as roughness and normal maps.
+// If image_cache is non-NULL, the base texture is decoded through it, keyed by base_tex_content_hash.
+void generateLODTextures(const std::string& base_tex_path, const std::vector<LODTextureLevel>& levels, bool srgb, glare::TaskManager& task_manager,
+	DecodedImageCache* image_cache = NULL, uint64 base_tex_content_hash = 0);
+
+// srgb should be true for colour textures, and false for textures with linear data, such as roughness and normal maps.
+// If image_cache is non-NULL, the source texture is decoded through it, keyed by src_tex_content_hash.  Animated GIFs are always decoded directly.
+void generateBasisTexture(const std::string& src_tex_path, int base_lod_level, int lod_level, const std::string& basis_tex_path, bool srgb, glare::TaskManager& task_manager,
+	DecodedImageCache* image_cache = NULL, uint64 src_tex_content_hash = 0);
+
+// Loads the source texture and resizes it for the Basis texture for lod_level, without encoding it.  Used to prepare jobs for BasisEncodingService.
+// Returns an ImageMapUInt8, or an ImageMapSequenceUInt8 for animated GIFs, and sets quality_level_out to the ETC1S quality level to encode it with.
+Reference<Map2D> makeBasisTextureSourceImage(const std::string& src_tex_path, int base_lod_level, int lod_level, bool srgb, glare::TaskManager& task_manager,
+	DecodedImageCache* image_cache, uint64 src_tex_content_hash, int& quality_level_out);
 
 // Generate LOD and KTX textures for materials, if not already present on disk.
 //void generateLODTexturesForMaterialsIfNotPresent(std::vector<WorldMaterialRef>& materials, ResourceManager& resource_manager, glare::TaskManager& task_manager);
 
 //void writeBasisUniversalKTXFile(const ImageMapUInt8& imagemap, const std::string& path);
-void writeBasisUniversalFile(const ImageMapUInt8& imagemap, const std::string& path, int quality_level);
-void writeBasisUniversalFileForSequence(const ImageMapSequenceUInt8& imagemap, const std::string& path, int quality_level);
+
+// num_threads is the total number of encoder threads to use, including the calling thread.  If <= 0, uses half the logical processors.
+void writeBasisUniversalFile(const ImageMapUInt8& imagemap, const std::string& path, int quality_level, int num_threads = 0);
+void writeBasisUniversalFileForSequence(const ImageMapSequenceUInt8& imagemap, const std::string& path, int quality_level, int num_threads = 0);
+
+// Writes an ImageMapUInt8 or an ImageMapSequenceUInt8, as returned by makeBasisTextureSourceImage().  Throws glare::Exception for other image types.
+void writeBasisUniversalFileForMap(const Map2D& map, const std::string& path, int quality_level, int num_threads);
 
 void test();
 
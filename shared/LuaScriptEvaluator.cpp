@@ -11,10 +11,14 @@ Copyright Glare Technologies Limited 2024 -
 #include "WorldStateLock.h"
 #include "WorldObject.h"
 #include "../server/LuaHTTPRequestManager.h" // For LuaHTTPRequestResult
+#if SERVER
+#include "../server/Server.h"
+#endif
 #include <utils/Exception.h>
 #include <utils/ConPrint.h>
 #include <utils/StringUtils.h>
 #include <utils/Lock.h>
+#include <utils/Clock.h>
 #include <lua/LuaUtils.h>
 #include <lualib.h>
 
@@ -40,6 +44,43 @@ private:
 };
 
 
+// Sets the execution time budget deadline for a script callback, and measures the execution time and Lua heap growth of the callback.
+// Nested callbacks (e.g. a callback triggered by Lua code in another callback) are counted as part of the outermost callback.
+class ScriptCallbackScope
+{
+public:
+	ScriptCallbackScope(LuaScriptEvaluator* script_evaluator_, double time_budget_s_)
+	:	script_evaluator(script_evaluator_),
+		outermost(script_evaluator_->cur_callback_deadline == 0),
+		time_budget_s(time_budget_s_)
+	{
+		if(outermost)
+		{
+			start_time = Clock::getTimeSinceInit();
+			start_heap_size_B = script_evaluator->substrata_lua_vm->getHeapSizeB();
+			script_evaluator->cur_callback_deadline = start_time + time_budget_s;
+			script_evaluator->cur_callback_exceeded_budget = false;
+		}
+	}
+
+	~ScriptCallbackScope()
+	{
+		if(outermost)
+		{
+			script_evaluator->cur_callback_deadline = 0;
+			script_evaluator->callbackFinished(Clock::getTimeSinceInit() - start_time, time_budget_s, (int64)script_evaluator->substrata_lua_vm->getHeapSizeB() - (int64)start_heap_size_B);
+		}
+	}
+
+private:
+	LuaScriptEvaluator* script_evaluator;
+	bool outermost;
+	double time_budget_s;
+	double start_time;
+	size_t start_heap_size_B;
+};
+
+
 LuaScriptEvaluator::LuaScriptEvaluator(const Reference<SubstrataLuaVM>& substrata_lua_vm_, LuaScriptOutputHandler* script_output_handler_, 
 	const std::string& script_src, WorldObject* world_object_,
 #if SERVER
@@ -56,17 +97,24 @@ LuaScriptEvaluator::LuaScriptEvaluator(const Reference<SubstrataLuaVM>& substrat
 #endif
 	next_timer_id(0),
 	num_obs_event_listening(0),
-	cur_world_state_lock(nullptr)
+	cur_world_state_lock(nullptr),
+	cur_callback_deadline(0),
+	cur_callback_exceeded_budget(false),
+	budget_window_start_time(0),
+	budget_window_exec_time_s(0),
+	throttled_until_time(0)
 {
 	for(int i=0; i<MAX_NUM_TIMERS; ++i)
 		timers[i].id = -1;
 
 	LuaScriptOptions options;
-	options.max_num_interrupts = 10000;
+	options.max_num_interrupts = 10000000; // Backstop only, the execution time budget (see checkExecutionTimeBudget()) should abort long-running callbacks first.
 	options.script_output_handler = script_output_handler_;
 	options.userdata = this;
 	lua_script.set(new LuaScript(substrata_lua_vm->lua_vm.ptr(), options, script_src));
 
+	substrata_lua_vm->installInterruptHandler(); // Make sure our interrupt handler, which checks the execution time budget, is installed.
+
 
 	// Set 'this_object' global variable
 	pushWorldObjectTableOntoStack(world_object->uid);
@@ -91,7 +139,10 @@ LuaScriptEvaluator::LuaScriptEvaluator(const Reference<SubstrataLuaVM>& substrat
 
 
 	SetCurWorldStateLockClass lock_setter(this, world_state_lock);
-	lua_script->exec();
+	{
+		ScriptCallbackScope callback_scope(this, INITIAL_EXEC_TIME_BUDGET_S);
+		lua_script->exec();
+	}
 
 	// Add any event handling functions defined in the script to the object event-handler list.
 	// Event handling functions defined in this way basically do implicit addEventListener() calls.
@@ -143,18 +194,32 @@ LuaScriptEvaluator::LuaScriptEvaluator(const Reference<SubstrataLuaVM>& substrat
 			world_object->getOrCreateEventHandlers()->onUserExitedParcel_handlers.addHandler(handler_func);
 		}
 	}
+
+	{
+		Lock lock(substrata_lua_vm->script_evaluators_mutex);
+		substrata_lua_vm->script_evaluators[this] = world_object->uid;
+	}
 }
 
 
 LuaScriptEvaluator::~LuaScriptEvaluator()
 {
+	{
+		Lock lock(substrata_lua_vm->script_evaluators_mutex);
+		substrata_lua_vm->script_evaluators.erase(this);
+	}
+
+	// Remove any of our timers from the timer queue, so they don't linger there.
+	for(int i=0; i<MAX_NUM_TIMERS; ++i)
+		if(timers[i].id != -1)
+			substrata_lua_vm->timer_queue->removeTimer(timers[i].queue_handle);
 }
 
 
 void LuaScriptEvaluator::doOnUserTouchedObject(int func_ref, UID avatar_uid, UID ob_uid, WorldStateLock& world_state_lock) noexcept
 {
 	//conPrint("LuaScriptEvaluator: doOnUserTouchedObject");
-	if(hit_error || (func_ref == LUA_NOREF))
+	if(hit_error || (func_ref == LUA_NOREF) || checkThrottled())
 		return;
 
 	try
@@ -163,6 +228,8 @@ void LuaScriptEvaluator::doOnUserTouchedObject(int func_ref, UID avatar_uid, UID
 
 		lua_script->resetExecutionTimeCounter();
 
+		ScriptCallbackScope callback_scope(this, CALLBACK_TIME_BUDGET_S);
+
 		lua_getref(lua_script->thread_state, func_ref); // Pushes function onto the stack.
 
 		pushAvatarTableOntoStack(avatar_uid);
@@ -175,16 +242,12 @@ void LuaScriptEvaluator::doOnUserTouchedObject(int func_ref, UID avatar_uid, UID
 	catch(std::exception& e)
 	{
 		//conPrint("Error while executing onUserTouchedObject: " + std::string(e.what()));
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 	catch(glare::Exception& e)
 	{
 		//conPrint("Error while executing onUserTouchedObject: " + e.what());
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), e.what());
-		hit_error = true;
+		handleCallbackError(e.what());
 	}
 }
 
@@ -192,7 +255,7 @@ void LuaScriptEvaluator::doOnUserTouchedObject(int func_ref, UID avatar_uid, UID
 void LuaScriptEvaluator::doOnUserUsedObject(int func_ref, UID avatar_uid, UID ob_uid, WorldStateLock& world_state_lock) noexcept
 {
 	//conPrint("LuaScriptEvaluator: doOnUserUsedObject");
-	if(hit_error || (func_ref == LUA_NOREF))
+	if(hit_error || (func_ref == LUA_NOREF) || checkThrottled())
 		return;
 
 	try
@@ -201,6 +264,8 @@ void LuaScriptEvaluator::doOnUserUsedObject(int func_ref, UID avatar_uid, UID ob
 
 		lua_script->resetExecutionTimeCounter();
 
+		ScriptCallbackScope callback_scope(this, CALLBACK_TIME_BUDGET_S);
+
 		lua_getref(lua_script->thread_state, func_ref); // Pushes onUserUsedObject onto the stack.
 		
 		pushAvatarTableOntoStack(avatar_uid);
@@ -213,16 +278,12 @@ void LuaScriptEvaluator::doOnUserUsedObject(int func_ref, UID avatar_uid, UID ob
 	catch(std::exception& e)
 	{
 		//conPrint("Error while executing onUserUsedObject: " + std::string(e.what()));
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 	catch(glare::Exception& e)
 	{
 		//conPrint("Error while executing onUserUsedObject: " + e.what());
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 }
 
@@ -230,7 +291,7 @@ void LuaScriptEvaluator::doOnUserUsedObject(int func_ref, UID avatar_uid, UID ob
 void LuaScriptEvaluator::doOnUserMovedNearToObject(int func_ref, UID avatar_uid, UID ob_uid, WorldStateLock& world_state_lock) noexcept
 {
 	//conPrint("LuaScriptEvaluator: doOnUserMovedNearToObject");
-	if(hit_error || (func_ref == LUA_NOREF))
+	if(hit_error || (func_ref == LUA_NOREF) || checkThrottled())
 		return;
 
 	try
@@ -239,6 +300,8 @@ void LuaScriptEvaluator::doOnUserMovedNearToObject(int func_ref, UID avatar_uid,
 
 		lua_script->resetExecutionTimeCounter();
 
+		ScriptCallbackScope callback_scope(this, CALLBACK_TIME_BUDGET_S);
+
 		lua_getref(lua_script->thread_state, func_ref); // Pushes func_ref onto the stack.
 
 		pushAvatarTableOntoStack(avatar_uid);
@@ -251,16 +314,12 @@ void LuaScriptEvaluator::doOnUserMovedNearToObject(int func_ref, UID avatar_uid,
 	catch(std::exception& e)
 	{
 		//conPrint("Error while executing onUserMovedNearToObject: " + std::string(e.what()));
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 	catch(glare::Exception& e)
 	{
 		//conPrint("Error while executing onUserMovedNearToObject: " + e.what());
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 }
 
@@ -268,7 +327,7 @@ void LuaScriptEvaluator::doOnUserMovedNearToObject(int func_ref, UID avatar_uid,
 void LuaScriptEvaluator::doOnUserMovedAwayFromObject(int func_ref, UID avatar_uid, UID ob_uid, WorldStateLock& world_state_lock) noexcept
 {
 	//conPrint("LuaScriptEvaluator: doOnUserMovedAwayFromObject");
-	if(hit_error || (func_ref == LUA_NOREF))
+	if(hit_error || (func_ref == LUA_NOREF) || checkThrottled())
 		return;
 
 	try
@@ -277,6 +336,8 @@ void LuaScriptEvaluator::doOnUserMovedAwayFromObject(int func_ref, UID avatar_ui
 
 		lua_script->resetExecutionTimeCounter();
 
+		ScriptCallbackScope callback_scope(this, CALLBACK_TIME_BUDGET_S);
+
 		lua_getref(lua_script->thread_state, func_ref); // Pushes func_ref onto the stack.
 
 		pushAvatarTableOntoStack(avatar_uid);
@@ -289,16 +350,12 @@ void LuaScriptEvaluator::doOnUserMovedAwayFromObject(int func_ref, UID avatar_ui
 	catch(std::exception& e)
 	{
 		//conPrint("Error while executing onUserMovedAwayFromObject: " + std::string(e.what()));
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 	catch(glare::Exception& e)
 	{
 		//conPrint("Error while executing onUserMovedAwayFromObject: " + e.what());
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 }
 
@@ -306,7 +363,7 @@ void LuaScriptEvaluator::doOnUserMovedAwayFromObject(int func_ref, UID avatar_ui
 void LuaScriptEvaluator::doOnUserEnteredParcel(int func_ref, UID avatar_uid, UID ob_uid, ParcelID parcel_id, WorldStateLock& world_state_lock) noexcept
 {
 	//conPrint("LuaScriptEvaluator: doOnUserEnteredParcel");
-	if(hit_error || (func_ref == LUA_NOREF))
+	if(hit_error || (func_ref == LUA_NOREF) || checkThrottled())
 		return;
 
 	try
@@ -315,6 +372,8 @@ void LuaScriptEvaluator::doOnUserEnteredParcel(int func_ref, UID avatar_uid, UID
 
 		lua_script->resetExecutionTimeCounter();
 
+		ScriptCallbackScope callback_scope(this, CALLBACK_TIME_BUDGET_S);
+
 		lua_getref(lua_script->thread_state, func_ref); // Pushes func_ref onto the stack.
 
 		pushAvatarTableOntoStack(avatar_uid);
@@ -327,16 +386,12 @@ void LuaScriptEvaluator::doOnUserEnteredParcel(int func_ref, UID avatar_uid, UID
 	catch(std::exception& e)
 	{
 		//conPrint("Error while executing doOnUserEnteredParcel: " + std::string(e.what()));
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 	catch(glare::Exception& e)
 	{
 		//conPrint("Error while executing doOnUserEnteredParcel: " + e.what());
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 }
 
@@ -344,7 +399,7 @@ void LuaScriptEvaluator::doOnUserEnteredParcel(int func_ref, UID avatar_uid, UID
 void LuaScriptEvaluator::doOnUserExitedParcel(int func_ref, UID avatar_uid, UID ob_uid, ParcelID parcel_id, WorldStateLock& world_state_lock) noexcept
 {
 	//conPrint("LuaScriptEvaluator: doOnUserExitedParcel");
-	if(hit_error || (func_ref == LUA_NOREF))
+	if(hit_error || (func_ref == LUA_NOREF) || checkThrottled())
 		return;
 
 	try
@@ -353,6 +408,8 @@ void LuaScriptEvaluator::doOnUserExitedParcel(int func_ref, UID avatar_uid, UID
 
 		lua_script->resetExecutionTimeCounter();
 
+		ScriptCallbackScope callback_scope(this, CALLBACK_TIME_BUDGET_S);
+
 		lua_getref(lua_script->thread_state, func_ref); // Pushes func_ref onto the stack.
 
 		pushAvatarTableOntoStack(avatar_uid);
@@ -365,16 +422,12 @@ void LuaScriptEvaluator::doOnUserExitedParcel(int func_ref, UID avatar_uid, UID
 	catch(std::exception& e)
 	{
 		//conPrint("Error while executing onUserExitedParcel: " + std::string(e.what()));
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 	catch(glare::Exception& e)
 	{
 		//conPrint("Error while executing onUserExitedParcel: " + e.what());
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 }
 
@@ -382,7 +435,7 @@ void LuaScriptEvaluator::doOnUserExitedParcel(int func_ref, UID avatar_uid, UID
 void LuaScriptEvaluator::doOnUserEnteredVehicle(int func_ref, UID avatar_uid, UID vehicle_ob_uid, WorldStateLock& world_state_lock) noexcept
 {
 	// conPrint("LuaScriptEvaluator: doOnUserEnteredVehicle");
-	if(hit_error || (func_ref == LUA_NOREF))
+	if(hit_error || (func_ref == LUA_NOREF) || checkThrottled())
 		return;
 
 	try
@@ -391,6 +444,8 @@ void LuaScriptEvaluator::doOnUserEnteredVehicle(int func_ref, UID avatar_uid, UI
 
 		lua_script->resetExecutionTimeCounter();
 
+		ScriptCallbackScope callback_scope(this, CALLBACK_TIME_BUDGET_S);
+
 		lua_getref(lua_script->thread_state, func_ref); // Pushes func_ref onto the stack.
 
 		pushAvatarTableOntoStack(avatar_uid);
@@ -401,15 +456,11 @@ void LuaScriptEvaluator::doOnUserEnteredVehicle(int func_ref, UID avatar_uid, UI
 	}
 	catch(std::exception& e)
 	{
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 	catch(glare::Exception& e)
 	{
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 }
 
@@ -417,7 +468,7 @@ void LuaScriptEvaluator::doOnUserEnteredVehicle(int func_ref, UID avatar_uid, UI
 void LuaScriptEvaluator::doOnUserExitedVehicle(int func_ref, UID avatar_uid, UID vehicle_ob_uid, WorldStateLock& world_state_lock) noexcept
 {
 	// conPrint("LuaScriptEvaluator: doOnUserExitedVehicle");
-	if(hit_error || (func_ref == LUA_NOREF))
+	if(hit_error || (func_ref == LUA_NOREF) || checkThrottled())
 		return;
 
 	try
@@ -426,6 +477,8 @@ void LuaScriptEvaluator::doOnUserExitedVehicle(int func_ref, UID avatar_uid, UID
 
 		lua_script->resetExecutionTimeCounter();
 
+		ScriptCallbackScope callback_scope(this, CALLBACK_TIME_BUDGET_S);
+
 		lua_getref(lua_script->thread_state, func_ref); // Pushes func_ref onto the stack.
 
 		pushAvatarTableOntoStack(avatar_uid);
@@ -436,22 +489,18 @@ void LuaScriptEvaluator::doOnUserExitedVehicle(int func_ref, UID avatar_uid, UID
 	}
 	catch(std::exception& e)
 	{
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 	catch(glare::Exception& e)
 	{
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 }
 
 
 void LuaScriptEvaluator::doOnTimerEvent(int onTimerEvent_ref, WorldStateLock& world_state_lock) noexcept
 {
-	if(hit_error)
+	if(hit_error || checkThrottled())
 		return;
 
 	try
@@ -460,6 +509,8 @@ void LuaScriptEvaluator::doOnTimerEvent(int onTimerEvent_ref, WorldStateLock& wo
 
 		lua_script->resetExecutionTimeCounter();
 
+		ScriptCallbackScope callback_scope(this, CALLBACK_TIME_BUDGET_S);
+
 		lua_getref(lua_script->thread_state, onTimerEvent_ref);  // Push function to be called onto stack
 
 		pushWorldObjectTableOntoStack(this->world_object->uid);
@@ -470,16 +521,12 @@ void LuaScriptEvaluator::doOnTimerEvent(int onTimerEvent_ref, WorldStateLock& wo
 	catch(std::exception& e)
 	{
 		//conPrint("Error while executing doOnTimerEvent: " + std::string(e.what()));
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 	catch(glare::Exception& e)
 	{
 		//conPrint("Error while executing doOnTimerEvent: " + e.what());
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 }
 
@@ -489,16 +536,122 @@ void LuaScriptEvaluator::destroyTimer(int timer_index)
 	// Mark slot as free
 	timers[timer_index].id = -1;
 
+	// Remove from timer queue.  Does nothing if this was a one-shot timer that has already fired.
+	substrata_lua_vm->timer_queue->removeTimer(timers[timer_index].queue_handle);
+	timers[timer_index].queue_handle = TimerQueueHandle();
+
 	// Free reference to Lua onTimerEvent function, if valid
 	if(timers[timer_index].onTimerEvent_ref != LUA_NOREF)
 		lua_unref(lua_script->thread_state, timers[timer_index].onTimerEvent_ref); 
 }
 
 
+bool LuaScriptEvaluator::isThrottled() const
+{
+	return (throttled_until_time > 0) && (Clock::getTimeSinceInit() < throttled_until_time);
+}
+
+
+bool LuaScriptEvaluator::checkThrottled()
+{
+	if(isThrottled())
+	{
+		exec_stats.num_throttled_callbacks++;
+		return true;
+	}
+	else
+		return false;
+}
+
+
+void LuaScriptEvaluator::checkExecutionTimeBudget()
+{
+	if((cur_callback_deadline > 0) && (Clock::getTimeSinceInit() > cur_callback_deadline))
+	{
+		cur_callback_exceeded_budget = true;
+		throw glare::Exception("Script exceeded execution time budget.");
+	}
+}
+
+
+void LuaScriptEvaluator::callbackFinished(double exec_time_s, double time_budget_s, int64 heap_growth_B)
+{
+	exec_stats.num_callbacks++;
+	exec_stats.total_exec_time_s += exec_time_s;
+	if(heap_growth_B > 0)
+		exec_stats.total_heap_growth_B += (uint64)heap_growth_B;
+
+	const double cur_time = Clock::getTimeSinceInit();
+	if(cur_time - budget_window_start_time > BUDGET_WINDOW_S)
+	{
+		// Start a new window
+		budget_window_start_time = cur_time;
+		budget_window_exec_time_s = 0;
+	}
+
+	budget_window_exec_time_s += exec_time_s;
+
+	if(hit_error)
+		return;
+
+	if(cur_callback_exceeded_budget)
+	{
+		exec_stats.num_budget_overruns++;
+		throttle("Script exceeded execution time budget of " + toString((int)(time_budget_s * 1000)) + " ms for a single callback (took " + doubleToStringNSigFigs(exec_time_s * 1000, 3) + " ms).");
+	}
+	else if(budget_window_exec_time_s > WINDOW_EXEC_TIME_BUDGET_S)
+		throttle("Script used " + doubleToStringNSigFigs(budget_window_exec_time_s * 1000, 3) + " ms of execution time in the last " + toString((int)BUDGET_WINDOW_S) + " s, which exceeds the budget of " + 
+			toString((int)(WINDOW_EXEC_TIME_BUDGET_S * 1000)) + " ms.");
+}
+
+
+void LuaScriptEvaluator::throttle(const std::string& reason)
+{
+	exec_stats.num_throttle_events++;
+
+	throttled_until_time = Clock::getTimeSinceInit() + THROTTLE_PERIOD_S;
+	budget_window_start_time = throttled_until_time;
+	budget_window_exec_time_s = 0;
+
+	if(exec_stats.num_throttle_events >= MAX_NUM_THROTTLE_EVENTS)
+	{
+		logExecBudgetMessage(reason + "  Script has been throttled " + toString(exec_stats.num_throttle_events) + " times, script will be suspended.");
+		hit_error = true;
+	}
+	else
+		logExecBudgetMessage(reason + "  Script will be throttled for " + toString((int)THROTTLE_PERIOD_S) + " s.");
+}
+
+
+void LuaScriptEvaluator::handleCallbackError(const std::string& msg)
+{
+	if(cur_callback_exceeded_budget)
+	{
+		// The callback was aborted for exceeding its execution time budget.  The script has already been throttled in callbackFinished(), so don't disable it.
+	}
+	else
+	{
+		if(script_output_handler)
+			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), msg);
+		hit_error = true;
+	}
+}
+
+
+void LuaScriptEvaluator::logExecBudgetMessage(const std::string& msg)
+{
+#if SERVER
+	substrata_lua_vm->server->logLuaMessage(msg, UserScriptLogMessage::MessageType_error, world_object->uid, world_object->creator_id);
+#else
+	conPrint("Lua script for object " + world_object->uid.toString() + ": " + msg);
+#endif
+}
+
+
 // See doHTTPGetRequestAsync in SubstrataLuaVM.cpp
 void LuaScriptEvaluator::doOnError(int onError_ref, int error_code, const std::string& error_description, WorldStateLock& world_state_lock) noexcept
 {
-	if(hit_error)
+	if(hit_error || checkThrottled())
 		return;
 
 	try
@@ -507,6 +660,8 @@ void LuaScriptEvaluator::doOnError(int onError_ref, int error_code, const std::s
 
 		lua_script->resetExecutionTimeCounter();
 
+		ScriptCallbackScope callback_scope(this, CALLBACK_TIME_BUDGET_S);
+
 		lua_getref(lua_script->thread_state, onError_ref);  // Push function to be called onto stack
 
 		// onError gets passed
@@ -524,16 +679,12 @@ void LuaScriptEvaluator::doOnError(int onError_ref, int error_code, const std::s
 	catch(std::exception& e)
 	{
 		//conPrint("Error while executing doOnError: " + std::string(e.what()));
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 	catch(glare::Exception& e)
 	{
 		//conPrint("Error while executing doOnError: " + e.what());
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 }
 
@@ -542,7 +693,7 @@ void LuaScriptEvaluator::doOnError(int onError_ref, int error_code, const std::s
 void LuaScriptEvaluator::doOnDone(int onDone_ref, Reference<LuaHTTPRequestResult> result, WorldStateLock& world_state_lock) noexcept
 {
 #if SERVER
-	if(hit_error)
+	if(hit_error || checkThrottled())
 		return;
 
 	try
@@ -551,6 +702,8 @@ void LuaScriptEvaluator::doOnDone(int onDone_ref, Reference<LuaHTTPRequestResult
 
 		lua_script->resetExecutionTimeCounter();
 
+		ScriptCallbackScope callback_scope(this, CALLBACK_TIME_BUDGET_S);
+
 		lua_getref(lua_script->thread_state, onDone_ref);  // Push function to be called onto stack
 
 		// onDone gets passed:
@@ -580,16 +733,12 @@ void LuaScriptEvaluator::doOnDone(int onDone_ref, Reference<LuaHTTPRequestResult
 	catch(std::exception& e)
 	{
 		//conPrint("Error while executing doOnDone: " + std::string(e.what()));
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 	catch(glare::Exception& e)
 	{
 		//conPrint("Error while executing doOnDone: " + e.what());
-		if(script_output_handler)
-			script_output_handler->errorOccurredFromLuaScript(lua_script.ptr(), std::string(e.what()));
-		hit_error = true;
+		handleCallbackError(std::string(e.what()));
 	}
 #else
 	assert(0);
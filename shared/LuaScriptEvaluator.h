@@ -9,6 +9,7 @@ Copyright Glare Technologies Limited 2024 -
 #include "UserID.h"
 #include "UID.h"
 #include "ParcelID.h"
+#include "TimerQueue.h"
 #include <lua/LuaScript.h>
 #include <maths/Vec4f.h>
 #include <utils/RefCounted.h>
@@ -22,10 +23,32 @@ class WorldStateLock;
 class LuaHTTPRequestResult;
 
 
+// Execution statistics for a script, shown in the user script log and admin pages.
+struct LuaScriptExecStats
+{
+	LuaScriptExecStats() : total_exec_time_s(0), num_callbacks(0), num_budget_overruns(0), num_throttle_events(0), num_throttled_callbacks(0), total_heap_growth_B(0) {}
+
+	double total_exec_time_s; // Total wall-clock time spent executing script code, including the initial script execution.
+	uint64 num_callbacks;
+	uint64 num_budget_overruns; // Number of callbacks aborted for exceeding CALLBACK_TIME_BUDGET_S.
+	uint64 num_throttle_events;
+	uint64 num_throttled_callbacks; // Number of callbacks skipped because the script was throttled.
+	uint64 total_heap_growth_B; // Sum of the increase in Lua VM heap size over each callback.  Approximates the memory allocated by the script.
+};
+
+
 /*=====================================================================
 LuaScriptEvaluator
 ------------------
 Per-WorldObject
+
+Execution budget
+----------------
+Each callback into the script (event handler, timer event etc.) has an execution time budget of CALLBACK_TIME_BUDGET_S.
+This is checked in the Lua interrupt handler (see SubstrataLuaVM), which aborts the callback if it runs over.
+If a callback runs over budget, or the script uses more than WINDOW_EXEC_TIME_BUDGET_S of execution time in a BUDGET_WINDOW_S window,
+the script is throttled: callbacks are skipped for THROTTLE_PERIOD_S.
+After MAX_NUM_THROTTLE_EVENTS throttle events the script is suspended (disabled), in the same way as if it had hit an error.
 =====================================================================*/
 class LuaScriptEvaluator : public WeakRefCounted
 {
@@ -63,6 +86,14 @@ public:
 	void doOnError(int onError_ref, int error_code, const std::string& error_description, WorldStateLock& world_state_lock) noexcept;
 	void doOnDone(int onDone_ref, Reference<LuaHTTPRequestResult> result, WorldStateLock& world_state_lock) noexcept;
 
+	bool isThrottled() const;
+
+	// Called from the Lua interrupt handler.  Throws glare::Exception if the current callback has run over its execution time budget.
+	void checkExecutionTimeBudget();
+
+	// Called at the end of each callback (and the initial script execution) with the elapsed time, execution time budget and heap growth of the callback.
+	void callbackFinished(double exec_time_s, double time_budget_s, int64 heap_growth_B);
+
 //private:
 	void pushUserTableOntoStack(UserID client_user_id);
 	void pushAvatarTableOntoStack(UID avatar_uid);
@@ -87,10 +118,32 @@ public:
 	{
 		int id; // -1 means no timer.
 		int onTimerEvent_ref; // Reference to Lua callback function
+		TimerQueueHandle queue_handle; // Handle to timer in the timer queue, used to remove it from the queue when the timer is destroyed.
 	};
 	LuaTimerInfo timers[MAX_NUM_TIMERS];
 
 	int next_timer_id;
 
 	int num_obs_event_listening; // Number of objects that this script has added an event listener to.
+
+	static constexpr double CALLBACK_TIME_BUDGET_S = 0.02;
+	static constexpr double INITIAL_EXEC_TIME_BUDGET_S = 0.1; // Budget for the initial execution of the script, which may do more setup work.
+	static constexpr double BUDGET_WINDOW_S = 10.0;
+	static constexpr double WINDOW_EXEC_TIME_BUDGET_S = 0.25;
+	static constexpr double THROTTLE_PERIOD_S = 10.0;
+	static const int MAX_NUM_THROTTLE_EVENTS = 10;
+
+	LuaScriptExecStats exec_stats;
+
+	double cur_callback_deadline; // Time (from Clock::getTimeSinceInit()) after which the current callback will be aborted, or 0 if not currently executing a callback.
+	bool cur_callback_exceeded_budget;
+	double budget_window_start_time;
+	double budget_window_exec_time_s;
+	double throttled_until_time; // Callbacks are skipped until this time (from Clock::getTimeSinceInit()).
+
+private:
+	bool checkThrottled(); // Returns true if throttled, and the callback should be skipped.
+	void throttle(const std::string& reason);
+	void handleCallbackError(const std::string& msg);
+	void logExecBudgetMessage(const std::string& msg);
 };
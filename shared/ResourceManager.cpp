@@ -21,7 +21,7 @@ Generated at 2016-01-12 12:22:34 +1300
 
 
 ResourceManager::ResourceManager(const std::string& base_resource_dir_)
-:	base_resource_dir(base_resource_dir_), changed(0)
+:	base_resource_dir(base_resource_dir_), changed(0), derived_assets_changed(0), derived_asset_num_hits(0), derived_asset_bytes_saved(0), derived_asset_gen_time_saved_s(0)
 {
 }
 
@@ -352,6 +352,283 @@ Version history:
 2: Serialising resource state
 */
 
+
+bool DerivedAssetKey::operator < (const DerivedAssetKey& other) const
+{
+	if(source_content_hash != other.source_content_hash)
+		return source_content_hash < other.source_content_hash;
+	if(generator_kind != other.generator_kind)
+		return generator_kind < other.generator_kind;
+	if(lod_level != other.lod_level)
+		return lod_level < other.lod_level;
+	if(param != other.param)
+		return param < other.param;
+	if(version != other.version)
+		return version < other.version;
+	return output_extension < other.output_extension;
+}
+
+
+bool ResourceManager::lookupDerivedAsset(const DerivedAssetKey& key, std::string& raw_local_path_out) // Threadsafe
+{
+	DerivedAsset asset;
+	{
+		Lock lock(mutex);
+		auto res = derived_assets.find(key);
+		if(res == derived_assets.end())
+			return false;
+		asset = res->second;
+	}
+
+	// Check the output file is still on disk, without holding the lock.
+	if(!FileUtils::fileExists(base_resource_dir + "/" + asset.raw_local_path))
+	{
+		Lock lock(mutex);
+		derived_assets.erase(key);
+		derived_assets_changed = 1;
+		return false;
+	}
+
+	{
+		Lock lock(mutex);
+		derived_asset_num_hits++;
+		derived_asset_bytes_saved += asset.size_B;
+		derived_asset_gen_time_saved_s += asset.gen_time_s;
+	}
+
+	raw_local_path_out = asset.raw_local_path;
+	return true;
+}
+
+
+void ResourceManager::insertDerivedAsset(const DerivedAssetKey& key, const std::string& raw_local_path, double gen_time_s) // Threadsafe
+{
+	DerivedAsset asset;
+	asset.raw_local_path = raw_local_path;
+	asset.size_B = 0;
+	asset.gen_time_s = gen_time_s;
+	try
+	{
+		asset.size_B = FileUtils::getFileSize(base_resource_dir + "/" + raw_local_path);
+	}
+	catch(FileUtils::FileUtilsExcep& e)
+	{
+		throw glare::Exception(e.what());
+	}
+
+	Lock lock(mutex);
+	derived_assets[key] = asset;
+	derived_assets_changed = 1;
+}
+
+
+size_t ResourceManager::garbageCollectDerivedAssets() // Threadsafe
+{
+	ZoneScoped; // Tracy profiler
+
+	Timer timer;
+
+	// Get the set of local paths in use by present resources, and a copy of the store entries.
+	std::unordered_set<std::string> used_raw_paths;
+	std::vector<std::pair<DerivedAssetKey, std::string>> entries;
+	{
+		Lock lock(mutex);
+
+		for(auto it = resource_for_url.begin(); it != resource_for_url.end(); ++it)
+			if(it->second->isPresent() && !it->second->external_resource)
+				used_raw_paths.insert(it->second->getRawLocalPath());
+
+		entries.reserve(derived_assets.size());
+		for(auto it = derived_assets.begin(); it != derived_assets.end(); ++it)
+			entries.push_back(std::make_pair(it->first, it->second.raw_local_path));
+	}
+
+	// Work out which entries are dead, doing the file-system checks without holding the lock.
+	std::vector<std::pair<DerivedAssetKey, std::string>> dead_entries;
+	for(size_t i=0; i<entries.size(); ++i)
+		if((used_raw_paths.count(entries[i].second) == 0) || !FileUtils::fileExists(base_resource_dir + "/" + entries[i].second))
+			dead_entries.push_back(entries[i]);
+
+	size_t num_removed = 0;
+	size_t num_files_deleted = 0;
+	if(!dead_entries.empty())
+	{
+		Lock lock(mutex);
+
+		// Recompute the used paths under the lock, as resources may have been added since we released it.
+		used_raw_paths.clear();
+		for(auto it = resource_for_url.begin(); it != resource_for_url.end(); ++it)
+			if(it->second->isPresent() && !it->second->external_resource)
+				used_raw_paths.insert(it->second->getRawLocalPath());
+
+		for(size_t i=0; i<dead_entries.size(); ++i)
+		{
+			const std::string& raw_path = dead_entries[i].second;
+			if(used_raw_paths.count(raw_path) != 0 && FileUtils::fileExists(base_resource_dir + "/" + raw_path)) // If the output is now used by a resource:
+				continue;
+
+			auto res = derived_assets.find(dead_entries[i].first);
+			if(res == derived_assets.end() || res->second.raw_local_path != raw_path)
+				continue;
+
+			derived_assets.erase(res);
+			num_removed++;
+
+			// Delete the output file, unless it is used by a resource, or another store entry refers to it.
+			if(used_raw_paths.count(raw_path) == 0 && FileUtils::fileExists(base_resource_dir + "/" + raw_path))
+			{
+				bool referenced_by_other_entry = false;
+				for(auto it = derived_assets.begin(); it != derived_assets.end(); ++it)
+					if(it->second.raw_local_path == raw_path)
+					{
+						referenced_by_other_entry = true;
+						break;
+					}
+
+				if(!referenced_by_other_entry)
+				{
+					try
+					{
+						FileUtils::deleteFile(base_resource_dir + "/" + raw_path);
+						num_files_deleted++;
+					}
+					catch(FileUtils::FileUtilsExcep& e)
+					{
+						conPrint("ResourceManager: failed to delete unused derived asset file: " + e.what());
+					}
+				}
+			}
+		}
+
+		if(num_removed > 0)
+			derived_assets_changed = 1;
+	}
+
+	conPrint("ResourceManager: garbage collected " + toString(num_removed) + " / " + toString(entries.size()) + " derived asset(s), deleted " + toString(num_files_deleted) + " unused file(s). (Elapsed: " + timer.elapsedStringNSigFigs(3) + ")");
+	return num_removed;
+}
+
+
+std::string ResourceManager::getDerivedAssetStoreStats() const // Threadsafe
+{
+	Lock lock(mutex);
+
+	std::string s;
+	s += "Num derived assets:            " + toString(derived_assets.size()) + "\n";
+	s += "Derived asset reuses:          " + toString(derived_asset_num_hits) + "\n";
+	s += "Derived asset bytes saved:     " + getMBSizeString(derived_asset_bytes_saved) + "\n";
+	s += "Derived asset gen time saved:  " + doubleToStringNSigFigs(derived_asset_gen_time_saved_s, 4) + " s\n";
+	return s;
+}
+
+
+static const uint32 DERIVED_ASSET_STORE_MAGIC_NUMBER = 698210483;
+static const uint32 DERIVED_ASSET_STORE_SERIALISATION_VERSION = 1;
+static const uint32 DERIVED_ASSET_CHUNK = 104;
+
+
+void ResourceManager::loadDerivedAssetStore(const std::string& path) // Threadsafe
+{
+	Timer timer;
+
+	FileInStream stream(path);
+
+	const uint32 m = stream.readUInt32();
+	if(m != DERIVED_ASSET_STORE_MAGIC_NUMBER)
+		throw glare::Exception("Invalid magic number " + toString(m) + ", expected " + toString(DERIVED_ASSET_STORE_MAGIC_NUMBER) + ".");
+
+	const uint32 version = stream.readUInt32();
+	if(version > DERIVED_ASSET_STORE_SERIALISATION_VERSION)
+		throw glare::Exception("Unknown version " + toString(version) + ", expected " + toString(DERIVED_ASSET_STORE_SERIALISATION_VERSION) + ".");
+
+	Lock lock(mutex);
+
+	while(1)
+	{
+		const uint32 chunk = stream.readUInt32();
+		if(chunk == DERIVED_ASSET_CHUNK)
+		{
+			DerivedAssetKey key;
+			key.source_content_hash = stream.readUInt64();
+			key.generator_kind		= stream.readUInt32();
+			key.lod_level			= stream.readInt32();
+			key.param				= stream.readInt32();
+			key.version				= stream.readUInt32();
+			key.output_extension	= stream.readStringLengthFirst(/*max len=*/100);
+
+			DerivedAsset asset;
+			asset.raw_local_path	= stream.readStringLengthFirst(/*max len=*/20000);
+			asset.size_B			= stream.readUInt64();
+			asset.gen_time_s		= stream.readDouble();
+
+			derived_assets[key] = asset;
+		}
+		else if(chunk == EOS_CHUNK)
+		{
+			break;
+		}
+		else
+		{
+			throw glare::Exception("Unknown chunk type '" + toString(chunk) + "'");
+		}
+	}
+
+	derived_assets_changed = 0;
+
+	conPrint("Loaded " + toString(derived_assets.size()) + " derived asset(s) from '" + path + "'.  Elapsed: " + timer.elapsedStringNSigFigs(3));
+}
+
+
+void ResourceManager::saveDerivedAssetStore(const std::string& path) // Threadsafe
+{
+	Timer timer;
+
+	Lock lock(mutex);
+
+	try
+	{
+		const std::string temp_path = path + "_temp";
+
+		{
+			FileOutStream stream(temp_path);
+
+			stream.writeUInt32(DERIVED_ASSET_STORE_MAGIC_NUMBER);
+			stream.writeUInt32(DERIVED_ASSET_STORE_SERIALISATION_VERSION);
+
+			for(auto it = derived_assets.begin(); it != derived_assets.end(); ++it)
+			{
+				const DerivedAssetKey& key = it->first;
+				const DerivedAsset& asset = it->second;
+
+				stream.writeUInt32(DERIVED_ASSET_CHUNK);
+				stream.writeUInt64(key.source_content_hash);
+				stream.writeUInt32(key.generator_kind);
+				stream.writeInt32(key.lod_level);
+				stream.writeInt32(key.param);
+				stream.writeUInt32(key.version);
+				stream.writeStringLengthFirst(key.output_extension);
+
+				stream.writeStringLengthFirst(asset.raw_local_path);
+				stream.writeUInt64(asset.size_B);
+				stream.writeDouble(asset.gen_time_s);
+			}
+
+			stream.writeUInt32(EOS_CHUNK); // Write end-of-stream chunk
+		}
+
+		FileUtils::moveFile(temp_path, path);
+
+		derived_assets_changed = 0;
+
+		conPrint("Saved " + toString(derived_assets.size()) + " derived asset(s) to disk.  (Elapsed: " + timer.elapsedStringNSigFigs(3) + ")");
+	}
+	catch(FileUtils::FileUtilsExcep& e)
+	{
+		throw glare::Exception(e.what());
+	}
+}
+
+
 void ResourceManager::loadFromDisk(const std::string& path, bool force_check_if_resources_exist_on_disk)
 {
 	ZoneScoped; // Tracy profiler
@@ -485,3 +762,83 @@ void ResourceManager::saveToDisk(const std::string& path)
 		throw glare::Exception(e.what());
 	}
 }
+
+
+#if BUILD_TESTS
+
+
+#include <utils/TestUtils.h>
+#include <utils/PlatformUtils.h>
+
+
+void ResourceManager::test()
+{
+	conPrint("ResourceManager::test()");
+
+	try
+	{
+		//------------------------------------------- Test derived-asset store -------------------------------------------
+		const std::string base_dir = PlatformUtils::getTempDirPath() + "/resource_manager_test";
+		FileUtils::createDirIfDoesNotExist(base_dir);
+		FileUtils::writeEntireFile(base_dir + "/a_lod1.jpg", "some LOD texture data");
+
+		const std::string store_path = base_dir + "/derived_assets.bin";
+		{
+			ResourceManagerRef resource_manager = new ResourceManager(base_dir);
+
+			const DerivedAssetKey key(/*source_content_hash=*/1234, DerivedAssetKey::GeneratorKind_LODTexture, /*lod level=*/1, /*param=*/0, /*version=*/1, "jpg");
+
+			std::string raw_path;
+			testAssert(!resource_manager->lookupDerivedAsset(key, raw_path));
+
+			resource_manager->insertDerivedAsset(key, "a_lod1.jpg", /*gen_time_s=*/2.0);
+			testAssert(resource_manager->derivedAssetStoreHasChanged());
+
+			testAssert(resource_manager->lookupDerivedAsset(key, raw_path));
+			testAssert(raw_path == "a_lod1.jpg");
+
+			// Keys differing in any parameter should not match.
+			testAssert(!resource_manager->lookupDerivedAsset(DerivedAssetKey(1234, DerivedAssetKey::GeneratorKind_LODTexture, /*lod level=*/2, 0, 1, "jpg"), raw_path));
+			testAssert(!resource_manager->lookupDerivedAsset(DerivedAssetKey(1234, DerivedAssetKey::GeneratorKind_LODTexture, 1, 0, /*version=*/2, "jpg"), raw_path));
+			testAssert(!resource_manager->lookupDerivedAsset(DerivedAssetKey(1234, DerivedAssetKey::GeneratorKind_LODTexture, 1, 0, 1, "png"), raw_path));
+
+			resource_manager->saveDerivedAssetStore(store_path);
+			testAssert(!resource_manager->derivedAssetStoreHasChanged());
+		}
+
+		// Test loading the store back from disk, and garbage collection.
+		{
+			ResourceManagerRef resource_manager = new ResourceManager(base_dir);
+			resource_manager->loadDerivedAssetStore(store_path);
+
+			const DerivedAssetKey key(1234, DerivedAssetKey::GeneratorKind_LODTexture, 1, 0, 1, "jpg");
+			std::string raw_path;
+			testAssert(resource_manager->lookupDerivedAsset(key, raw_path));
+			testAssert(raw_path == "a_lod1.jpg");
+
+			// The output is used by a present resource, so should not be garbage collected.
+			resource_manager->addResource(new Resource(/*URL=*/"a_lod1.jpg", /*raw local path=*/"a_lod1.jpg", Resource::State_Present, UserID(0), /*external_resource=*/false));
+			testAssert(resource_manager->garbageCollectDerivedAssets() == 0);
+			testAssert(resource_manager->lookupDerivedAsset(key, raw_path));
+			testAssert(FileUtils::fileExists(base_dir + "/a_lod1.jpg"));
+
+			// After the resource is gone, the entry should be garbage collected.
+			{
+				Lock lock(resource_manager->getMutex());
+				resource_manager->getResourcesForURL().clear();
+			}
+			testAssert(resource_manager->garbageCollectDerivedAssets() == 1);
+			testAssert(!resource_manager->lookupDerivedAsset(key, raw_path));
+			testAssert(!FileUtils::fileExists(base_dir + "/a_lod1.jpg")); // The unused output file should have been deleted.
+		}
+	}
+	catch(glare::Exception& e)
+	{
+		failTest(e.what());
+	}
+
+	conPrint("ResourceManager::test() done.");
+}
+
+
+#endif // BUILD_TESTS
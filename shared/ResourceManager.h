@@ -24,6 +24,42 @@ Generated at 2016-01-12 12:22:34 +1300
 #include <AtomicInt.h>
 
 
+// Identifies a derived asset (LOD mesh, optimised mesh, LOD texture, Basis texture) by the content of the source file it was generated from,
+// and by the parameters used to generate it.
+// Different URLs with identical content will map to the same key, so the asset only needs to be generated once.
+struct DerivedAssetKey
+{
+	enum GeneratorKind
+	{
+		GeneratorKind_LODModel			= 0,
+		GeneratorKind_OptimisedMesh		= 1,
+		GeneratorKind_LODTexture		= 2,
+		GeneratorKind_BasisTexture		= 3
+	};
+
+	DerivedAssetKey() : source_content_hash(0), generator_kind(0), lod_level(0), param(0), version(0) {}
+	DerivedAssetKey(uint64 source_content_hash_, GeneratorKind generator_kind_, int lod_level_, int param_, uint32 version_, const std::string& output_extension_)
+	:	source_content_hash(source_content_hash_), generator_kind((uint32)generator_kind_), lod_level(lod_level_), param(param_), version(version_), output_extension(output_extension_) {}
+
+	bool operator < (const DerivedAssetKey& other) const;
+
+	uint64 source_content_hash;
+	uint32 generator_kind; // A GeneratorKind value
+	int lod_level;
+	int param; // Generator-specific parameter, e.g. base LOD level and colour space for Basis textures.
+	uint32 version; // Version of the generation code/parameters, e.g. Protocol::OPTIMISED_MESH_VERSION.  Bumping this stops reuse of old outputs.
+	std::string output_extension; // e.g. "jpg" or "png" for LOD textures.
+};
+
+
+struct DerivedAsset
+{
+	std::string raw_local_path; // Path of the generated file, relative to base_resource_dir.
+	uint64 size_B;
+	double gen_time_s; // Time it took to generate the asset.
+};
+
+
 /*=====================================================================
 ResourceManager
 -------------------
@@ -98,6 +134,29 @@ public:
 	void saveToDisk(const std::string& path);
 
 	std::string getDiagnostics() const;
+
+	//---------------------------------- Derived-asset store ----------------------------------
+	// Returns true and sets raw_local_path_out if an asset for the key has already been generated, and the output file is still on disk.
+	// Records the saved bytes and generation time in the store statistics.
+	bool lookupDerivedAsset(const DerivedAssetKey& key, std::string& raw_local_path_out); // Threadsafe
+
+	// Record a newly generated asset.  raw_local_path is relative to base_resource_dir.
+	void insertDerivedAsset(const DerivedAssetKey& key, const std::string& raw_local_path, double gen_time_s); // Threadsafe
+
+	// Remove entries whose output file is not used by any present resource, or is no longer on disk.  Returns number of entries removed.
+	// Output files that are not used by any present resource are deleted.
+	size_t garbageCollectDerivedAssets(); // Threadsafe
+
+	bool derivedAssetStoreHasChanged() const { return derived_assets_changed != 0; }
+
+	// Throws glare::Exception on failure.
+	void loadDerivedAssetStore(const std::string& path); // Threadsafe
+	void saveDerivedAssetStore(const std::string& path); // Threadsafe
+
+	std::string getDerivedAssetStoreStats() const; // Threadsafe
+	//---------------------------------- End derived-asset store ----------------------------------
+
+	static void test();
 private:
 	std::string base_resource_dir;
 
@@ -108,6 +167,12 @@ private:
 
 	std::unordered_set<URLString, URLStringHasher> download_failed_URLs; // Ephemeral state, used to prevent trying to download the same resource over and over again in one client execution.
 
+	std::map<DerivedAssetKey, DerivedAsset> derived_assets			GUARDED_BY(mutex);
+	glare::AtomicInt derived_assets_changed;
+	uint64 derived_asset_num_hits									GUARDED_BY(mutex);
+	uint64 derived_asset_bytes_saved								GUARDED_BY(mutex);
+	double derived_asset_gen_time_saved_s							GUARDED_BY(mutex);
+
 public:
 	// Total amount of memory in LoadedBuffer objects that are not persistently used.
 	glare::AtomicInt total_unused_loaded_buffer_size_B;
@@ -981,7 +981,7 @@ static int createTimer(lua_State* state)
 			timer.timer_id = timer_id;
 			//timer.lua_script_evaluator_handle = script_evaluator->generational_handle;
 			timer.lua_script_evaluator = script_evaluator;
-			timer_queue.addTimer(cur_time, timer);
+			script_evaluator->timers[i].queue_handle = timer_queue.addTimer(cur_time, timer);
 
 			lua_pushnumber(state, (double)i); // Push timer id
 			return 1; // Count of returned values
@@ -1150,7 +1150,7 @@ static int worldObjectClassIndexMetaMethod(lua_State* state)
 	{
 	case Atom_model_url:
 		assert(stringEqual(key_str, "model_url"));
-		LuaUtils::pushString(state, ob->model_url);
+		LuaUtils::pushString(state, ob->model_url.str());
 		break;
 	case Atom_pos:
 		assert(stringEqual(key_str, "pos"));
@@ -1218,7 +1218,7 @@ static int worldObjectClassIndexMetaMethod(lua_State* state)
 		break;
 	case Atom_audio_source_url:
 		assert(stringEqual(key_str, "audio_source_url"));
-		LuaUtils::pushString(state, ob->audio_source_url);
+		LuaUtils::pushString(state, ob->audio_source_url.str());
 		break;
 	case Atom_audio_volume:
 		assert(stringEqual(key_str, "audio_volume"));
@@ -1486,7 +1486,7 @@ static int worldMaterialClassIndexMetaMethod(lua_State* state)
 		break;
 	case Atom_colour_texture_url:
 		assert(stringEqual(key_str, "colour_texture_url"));
-		LuaUtils::pushString(state, mat->colour_texture_url);
+		LuaUtils::pushString(state, mat->colour_texture_url.str());
 		break;
 	case Atom_emission_rgb:
 		assert(stringEqual(key_str, "emission_rgb"));
@@ -1494,11 +1494,11 @@ static int worldMaterialClassIndexMetaMethod(lua_State* state)
 		break;
 	case Atom_emission_texture_url:
 		assert(stringEqual(key_str, "emission_texture_url"));
-		LuaUtils::pushString(state, mat->emission_texture_url);
+		LuaUtils::pushString(state, mat->emission_texture_url.str());
 		break;
 	case Atom_normal_map_url:
 		assert(stringEqual(key_str, "normal_map_url"));
-		LuaUtils::pushString(state, mat->normal_map_url);
+		LuaUtils::pushString(state, mat->normal_map_url.str());
 		break;
 	case Atom_roughness_val:
 		assert(stringEqual(key_str, "roughness_val"));
@@ -1930,11 +1930,15 @@ SubstrataLuaVM::SubstrataLuaVM(const SubstrataLuaVMArgs& args)
 :	metatable_uid_to_ref_map(std::numeric_limits<uint32>::max()),
 #if GUI_CLIENT
 	gui_client(args.gui_client),
-	player_physics(args.player_physics)
+	player_physics(args.player_physics),
+	timer_queue(&args.gui_client->timer_queue),
 #endif
 #if SERVER
-	server(args.server)
+	server(args.server),
+	timer_queue(&args.server->timer_queue),
 #endif
+	prev_interrupt(nullptr),
+	peak_heap_size_B(0)
 {
 	lua_vm.set(new LuaVM());
 	lua_vm->max_total_mem_allowed = 16 * 1024 * 1024;
@@ -2061,3 +2065,42 @@ SubstrataLuaVM::SubstrataLuaVM(const SubstrataLuaVMArgs& args)
 SubstrataLuaVM::~SubstrataLuaVM()
 {
 }
+
+
+// Called periodically by Luau while executing script code.
+// Aborts the currently executing script callback if it has run over its execution time budget.
+static void substrataLuaInterrupt(lua_State* state, int gc)
+{
+	SubstrataLuaVM* sub_lua_vm = (SubstrataLuaVM*)lua_callbacks(state)->userdata;
+	if(sub_lua_vm->prev_interrupt)
+		sub_lua_vm->prev_interrupt(state, gc);
+
+	if(gc >= 0) // Don't abort execution from GC interrupts.
+		return;
+
+	LuaScript* script = (LuaScript*)lua_getthreaddata(state);
+	if(script && script->userdata)
+	{
+		LuaScriptEvaluator* script_evaluator = (LuaScriptEvaluator*)script->userdata;
+		script_evaluator->checkExecutionTimeBudget();
+	}
+}
+
+
+void SubstrataLuaVM::installInterruptHandler()
+{
+	lua_Callbacks* callbacks = lua_callbacks(lua_vm->state);
+	if(callbacks->interrupt != substrataLuaInterrupt)
+	{
+		prev_interrupt = callbacks->interrupt;
+		callbacks->interrupt = substrataLuaInterrupt;
+	}
+}
+
+
+size_t SubstrataLuaVM::getHeapSizeB()
+{
+	const size_t heap_size_B = (size_t)lua_gc(lua_vm->state, LUA_GCCOUNT, 0) * 1024 + (size_t)lua_gc(lua_vm->state, LUA_GCCOUNTB, 0);
+	peak_heap_size_B = myMax(peak_heap_size_B, heap_size_B);
+	return heap_size_B;
+}
@@ -6,15 +6,21 @@ Copyright Glare Technologies Limited 2024 -
 #pragma once
 
 
+#include "UID.h"
 #include <maths/Vec4f.h>
 #include <utils/ThreadSafeRefCounted.h>
 #include <utils/UniqueRef.h>
 #include <utils/HashMap.h>
+#include <utils/Mutex.h>
 #include <string>
+#include <map>
+class LuaScriptEvaluator;
 class PlayerPhysics;
 class GUIClient;
 class Server;
 class LuaVM;
+class TimerQueue;
+struct lua_State;
 
 
 /*=====================================================================
@@ -89,6 +95,13 @@ public:
 
 	~SubstrataLuaVM();
 
+	// Installs our interrupt handler, which checks the execution time budget of the currently executing LuaScriptEvaluator, if not already installed.
+	// Any existing interrupt handler is called first.
+	void installInterruptHandler();
+
+	// Returns the current size of the Lua heap, as tracked by the VM allocator.  Also updates peak_heap_size_B.
+	size_t getHeapSizeB();
+
 
 	UniqueRef<LuaVM> lua_vm;
 
@@ -100,6 +113,11 @@ public:
 #if SERVER
 	Server* server;
 #endif
+
+	TimerQueue* timer_queue; // The GUIClient or Server timer queue.
+
+	void (*prev_interrupt)(lua_State* state, int gc); // Interrupt handler that was installed before ours, if any.
+	size_t peak_heap_size_B;
 	
 	int worldObjectClassMetaTable_ref;
 	int worldMaterialClassMetaTable_ref;
@@ -107,4 +125,9 @@ public:
 	int avatarClassMetaTable_ref;
 
 	HashMap<uint32, int> metatable_uid_to_ref_map;
+
+	// Script evaluators using this VM, with the UID of the object each belongs to.  Added and removed by the LuaScriptEvaluator constructor and destructor.
+	// On the server there is one VM per user, so this allows finding the scripts of a user without scanning all objects.
+	Mutex script_evaluators_mutex;
+	std::map<LuaScriptEvaluator*, UID> script_evaluators GUARDED_BY(script_evaluators_mutex);
 };
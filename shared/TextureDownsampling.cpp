@@ -0,0 +1,669 @@
+/*=====================================================================
+TextureDownsampling.cpp
+-----------------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#include "TextureDownsampling.h"
+
+
+#include <maths/SSE.h>
+#include <maths/mathstypes.h>
+#include <utils/TaskManager.h>
+#include <utils/Task.h>
+#include <utils/Vector.h>
+#include <utils/Exception.h>
+#include <utils/StringUtils.h>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <map>
+#if BUILD_TESTS
+#include <maths/PCG32.h>
+#include <utils/ConPrint.h>
+#include <utils/PlatformUtils.h>
+#include <utils/Timer.h>
+#include <utils/TestUtils.h>
+#include <utils/TestExceptionUtils.h>
+#endif
+
+
+namespace TextureDownsampling
+{
+
+
+static const int LINEAR_TO_SRGB_TABLE_SIZE = 16384; // Large enough that 8-bit sRGB values round-trip through linear exactly.
+
+
+struct ColourSpaceTables
+{
+	ColourSpaceTables()
+	{
+		for(int i=0; i<256; ++i)
+		{
+			const float v = i / 255.f;
+			srgb_to_linear[i] = (v <= 0.04045f) ? (v / 12.92f) : std::pow((v + 0.055f) / 1.055f, 2.4f);
+		}
+
+		for(int i=0; i<LINEAR_TO_SRGB_TABLE_SIZE; ++i)
+		{
+			const float v = (float)i / (LINEAR_TO_SRGB_TABLE_SIZE - 1);
+			const float srgb = (v <= 0.0031308f) ? (v * 12.92f) : (1.055f * std::pow(v, 1 / 2.4f) - 0.055f);
+			linear_to_srgb[i] = (uint8)myClamp((int)(srgb * 255.f + 0.5f), 0, 255);
+		}
+	}
+
+	float srgb_to_linear[256];
+	uint8 linear_to_srgb[LINEAR_TO_SRGB_TABLE_SIZE];
+};
+
+
+static const ColourSpaceTables& getColourSpaceTables()
+{
+	static const ColourSpaceTables tables; // Thread-safe initialisation
+	return tables;
+}
+
+
+// Contribution of a source pixel along one axis: weight0 to destination pixel dst_index, and weight1 to destination pixel dst_index + 1.
+// Weights are the overlap with the destination pixel, in units of destination pixels, so the weights of the source pixels contributing to a destination pixel sum to 1.
+struct AxisTap
+{
+	int dst_index;
+	float weight0;
+	float weight1;
+};
+
+
+// Computes box filter taps for downsampling src_len pixels to dst_len pixels.  Requires 1 <= dst_len <= src_len.
+static void computeAxisTaps(int src_len, int dst_len, std::vector<AxisTap>& taps_out)
+{
+	assert(dst_len >= 1 && dst_len <= src_len);
+	const double scale = (double)dst_len / (double)src_len;
+
+	taps_out.resize(src_len);
+	for(int s=0; s<src_len; ++s)
+	{
+		const double begin = s * scale; // Source pixel extent in destination pixel coordinates
+		const double end = (s + 1) * scale;
+		const int d = myMin((int)begin, dst_len - 1);
+
+		AxisTap& tap = taps_out[s];
+		tap.dst_index = d;
+		if((end > d + 1) && (d + 1 < dst_len)) // If source pixel straddles two destination pixels:
+		{
+			tap.weight0 = (float)((d + 1) - begin);
+			tap.weight1 = (float)(end - (d + 1));
+		}
+		else
+		{
+			tap.weight0 = (float)(end - begin);
+			tap.weight1 = 0.f;
+		}
+	}
+}
+
+
+struct OutputFilterInfo
+{
+	std::vector<AxisTap> x_taps; // Indexed by source x
+	std::vector<AxisTap> y_taps; // Indexed by source y
+	std::vector<int> first_src_row; // For each destination row, the first source row that contributes to it.
+	std::vector<int> last_src_row; // For each destination row, the last source row that contributes to it.
+};
+
+
+// Number of floats per accumulated pixel.
+// If alpha weighting, each pixel is the alpha-weighted colour and alpha, followed by the unweighted colour, otherwise just colour and alpha.
+static inline size_t floatsPerPixel(bool alpha_weighted)
+{
+	return alpha_weighted ? 8 : 4;
+}
+
+
+// Converts a row of source pixels to linear float pixels (see floatsPerPixel()).  alpha_weighted should only be true if the image has alpha.
+static void convertRowToLinear(const uint8* src_pixels, int src_w, size_t N, bool srgb, bool alpha_weighted, float* row_out)
+{
+	const ColourSpaceTables& tables = getColourSpaceTables();
+	const float recip_255 = 1 / 255.f;
+	const bool has_alpha = (N == 2) || (N == 4);
+	const size_t S = floatsPerPixel(alpha_weighted);
+
+	for(int x=0; x<src_w; ++x)
+	{
+		const uint8* pixel = src_pixels + x * N;
+		const size_t num_colour_channels = has_alpha ? (N - 1) : N;
+
+		float c[4] = { 0.f, 0.f, 0.f, 1.f };
+		for(size_t i=0; i<num_colour_channels; ++i)
+			c[i] = srgb ? tables.srgb_to_linear[pixel[i]] : (pixel[i] * recip_255);
+		if(has_alpha)
+			c[3] = pixel[N - 1] * recip_255;
+
+		const __m128 v = _mm_loadu_ps(c);
+		if(alpha_weighted)
+		{
+			_mm_storeu_ps(row_out + x*S,     _mm_mul_ps(v, _mm_set_ps(1.f, c[3], c[3], c[3]))); // Premultiply colour by alpha.  (_mm_set_ps takes elements in reverse order)
+			_mm_storeu_ps(row_out + x*S + 4, v); // Unweighted colour
+		}
+		else
+			_mm_storeu_ps(row_out + x*S, v);
+	}
+}
+
+
+// Converts a row of accumulated linear float pixels (see floatsPerPixel()) to 8-bit pixels.
+static void finaliseRow(const float* acc_row, int dst_w, size_t N, bool srgb, bool alpha_weighted, uint8* dest)
+{
+	const ColourSpaceTables& tables = getColourSpaceTables();
+	const bool has_alpha = (N == 2) || (N == 4);
+	const size_t num_colour_channels = has_alpha ? (N - 1) : N;
+	const size_t S = floatsPerPixel(alpha_weighted);
+
+	for(int x=0; x<dst_w; ++x)
+	{
+		const float* p = acc_row + x*S;
+		const float alpha = myClamp(p[3], 0.f, 1.f);
+
+		const float* colour = p;
+		float colour_scale = 1.f;
+		if(alpha_weighted)
+		{
+			if(alpha > 1.0e-6f)
+				colour_scale = 1 / p[3]; // Undo premultiplication
+			else
+				colour = p + 4; // Fully transparent: use the unweighted colour, so the colour isn't lost.
+		}
+
+		uint8* dest_pixel = dest + x * N;
+		for(size_t i=0; i<num_colour_channels; ++i)
+		{
+			const float v = myClamp(colour[i] * colour_scale, 0.f, 1.f);
+			dest_pixel[i] = srgb ? tables.linear_to_srgb[(int)(v * (LINEAR_TO_SRGB_TABLE_SIZE - 1) + 0.5f)] : (uint8)(v * 255.f + 0.5f);
+		}
+		if(has_alpha)
+			dest_pixel[N - 1] = (uint8)(alpha * 255.f + 0.5f);
+	}
+}
+
+
+static const int BAND_HEIGHT = 64; // Number of source rows processed by a single task.
+
+
+// Accumulated destination rows for one output, over the source rows of a band.
+struct BandOutputRows
+{
+	int first_row; // Destination row index of the first accumulated row.
+	int num_rows;
+	js::Vector<float, 16> rows; // num_rows * dst_w float pixels (see floatsPerPixel()).
+};
+
+
+// A destination row with contributions from only some of its source rows, because it straddles a band boundary.
+struct PartialRow
+{
+	int row_index;
+	std::vector<float> pixels; // dst_w float pixels (see floatsPerPixel()).
+};
+
+
+class DownsampleBandTask : public glare::Task
+{
+public:
+	virtual void run(size_t thread_index) override
+	{
+		const size_t N = src->getN();
+		const int src_w = (int)src->getWidth();
+		const bool alpha_weighted = options->alpha_weighted && ((N == 2) || (N == 4));
+		const size_t S = floatsPerPixel(alpha_weighted);
+
+		// Allocate accumulation rows for each output
+		std::vector<BandOutputRows> band_rows(outputs->size());
+		int max_dst_w = 0;
+		for(size_t z=0; z<outputs->size(); ++z)
+		{
+			const DownsampleOutput& output = (*outputs)[z];
+			const OutputFilterInfo& info = (*filter_info)[z];
+
+			const AxisTap& last_tap = info.y_taps[src_y_end - 1];
+			BandOutputRows& rows = band_rows[z];
+			rows.first_row = info.y_taps[src_y_begin].dst_index;
+			rows.num_rows = last_tap.dst_index + ((last_tap.weight1 > 0) ? 1 : 0) + 1 - rows.first_row;
+			rows.rows.resize((size_t)rows.num_rows * output.dst_w * S);
+			std::memset(rows.rows.data(), 0, rows.rows.size() * sizeof(float));
+
+			max_dst_w = myMax(max_dst_w, output.dst_w);
+		}
+
+		js::Vector<float, 16> src_row((size_t)src_w * S);
+		js::Vector<float, 16> hrow(((size_t)max_dst_w + 1) * S); // One extra pixel so weight1 can always be added.
+
+		for(int sy=src_y_begin; sy<src_y_end; ++sy)
+		{
+			convertRowToLinear(src->getPixel(0, sy), src_w, N, options->srgb, alpha_weighted, src_row.data());
+
+			for(size_t z=0; z<outputs->size(); ++z)
+			{
+				const int dst_w = (*outputs)[z].dst_w;
+				const OutputFilterInfo& info = (*filter_info)[z];
+
+				//------------------------ Horizontal pass ------------------------
+				std::memset(hrow.data(), 0, ((size_t)dst_w + 1) * S * sizeof(float));
+				const AxisTap* x_taps = info.x_taps.data();
+				for(int x=0; x<src_w; ++x)
+				{
+					const __m128 w0 = _mm_set1_ps(x_taps[x].weight0);
+					const __m128 w1 = _mm_set1_ps(x_taps[x].weight1);
+					for(size_t v=0; v<S; v += 4)
+					{
+						const __m128 p = _mm_load_ps(src_row.data() + x*S + v);
+						float* h = hrow.data() + x_taps[x].dst_index * S + v;
+						_mm_store_ps(h,     _mm_add_ps(_mm_load_ps(h),     _mm_mul_ps(w0, p)));
+						_mm_store_ps(h + S, _mm_add_ps(_mm_load_ps(h + S), _mm_mul_ps(w1, p)));
+					}
+				}
+
+				//------------------------ Vertical pass ------------------------
+				const AxisTap& y_tap = info.y_taps[sy];
+				BandOutputRows& rows = band_rows[z];
+				const size_t row_size = (size_t)dst_w * S; // Number of floats in a row
+				float* row0 = rows.rows.data() + (size_t)(y_tap.dst_index - rows.first_row) * row_size;
+				const __m128 w0 = _mm_set1_ps(y_tap.weight0);
+				for(size_t q=0; q<row_size; q += 4)
+					_mm_store_ps(row0 + q, _mm_add_ps(_mm_load_ps(row0 + q), _mm_mul_ps(w0, _mm_load_ps(hrow.data() + q))));
+
+				if(y_tap.weight1 > 0)
+				{
+					float* row1 = row0 + row_size;
+					const __m128 w1 = _mm_set1_ps(y_tap.weight1);
+					for(size_t q=0; q<row_size; q += 4)
+						_mm_store_ps(row1 + q, _mm_add_ps(_mm_load_ps(row1 + q), _mm_mul_ps(w1, _mm_load_ps(hrow.data() + q))));
+				}
+			}
+		}
+
+		// Write out the rows whose contributing source rows are all in this band.  Rows that straddle band boundaries are merged and written by downsample().
+		partial_rows.resize(outputs->size());
+		for(size_t z=0; z<outputs->size(); ++z)
+		{
+			const DownsampleOutput& output = (*outputs)[z];
+			const OutputFilterInfo& info = (*filter_info)[z];
+			const BandOutputRows& rows = band_rows[z];
+			for(int r=0; r<rows.num_rows; ++r)
+			{
+				const int row_index = rows.first_row + r;
+				const float* row = rows.rows.data() + (size_t)r * output.dst_w * S;
+				if((info.first_src_row[row_index] >= src_y_begin) && (info.last_src_row[row_index] < src_y_end))
+					finaliseRow(row, output.dst_w, N, options->srgb, alpha_weighted, output.result->getPixel(0, row_index));
+				else
+				{
+					PartialRow partial_row;
+					partial_row.row_index = row_index;
+					partial_row.pixels.assign(row, row + (size_t)output.dst_w * S);
+					partial_rows[z].push_back(partial_row);
+				}
+			}
+		}
+	}
+
+	const ImageMapUInt8* src;
+	const std::vector<DownsampleOutput>* outputs;
+	const std::vector<OutputFilterInfo>* filter_info;
+	const DownsampleOptions* options;
+	int src_y_begin, src_y_end;
+
+	std::vector<std::vector<PartialRow>> partial_rows; // Output, per DownsampleOutput
+};
+
+
+void downsample(const ImageMapUInt8& src, std::vector<DownsampleOutput>& outputs, const DownsampleOptions& options, glare::TaskManager* task_manager)
+{
+	const size_t N = src.getN();
+	if(N < 1 || N > 4)
+		throw glare::Exception("Invalid number of channels for downsample: " + toString(N));
+
+	const int src_w = (int)src.getWidth();
+	const int src_h = (int)src.getHeight();
+
+	std::vector<OutputFilterInfo> filter_info(outputs.size());
+	for(size_t z=0; z<outputs.size(); ++z)
+	{
+		DownsampleOutput& output = outputs[z];
+		if(output.dst_w < 1 || output.dst_h < 1 || output.dst_w > src_w || output.dst_h > src_h)
+			throw glare::Exception("Invalid destination size for downsample: " + toString(output.dst_w) + " * " + toString(output.dst_h));
+
+		OutputFilterInfo& info = filter_info[z];
+		computeAxisTaps(src_w, output.dst_w, info.x_taps);
+		computeAxisTaps(src_h, output.dst_h, info.y_taps);
+
+		info.first_src_row.resize(output.dst_h, src_h);
+		info.last_src_row.resize(output.dst_h, -1);
+		for(int sy=0; sy<src_h; ++sy)
+		{
+			const AxisTap& tap = info.y_taps[sy];
+			info.first_src_row[tap.dst_index] = myMin(info.first_src_row[tap.dst_index], sy);
+			info.last_src_row [tap.dst_index] = myMax(info.last_src_row [tap.dst_index], sy);
+			if(tap.weight1 > 0)
+			{
+				info.first_src_row[tap.dst_index + 1] = myMin(info.first_src_row[tap.dst_index + 1], sy);
+				info.last_src_row [tap.dst_index + 1] = myMax(info.last_src_row [tap.dst_index + 1], sy);
+			}
+		}
+
+		output.result = new ImageMapUInt8(output.dst_w, output.dst_h, N);
+	}
+
+	if(outputs.empty() || src_h == 0)
+		return;
+
+	Reference<glare::TaskGroup> task_group = new glare::TaskGroup();
+	std::vector<Reference<DownsampleBandTask>> tasks;
+	for(int y=0; y<src_h; y += BAND_HEIGHT)
+	{
+		Reference<DownsampleBandTask> task = new DownsampleBandTask();
+		task->src = &src;
+		task->outputs = &outputs;
+		task->filter_info = &filter_info;
+		task->options = &options;
+		task->src_y_begin = y;
+		task->src_y_end = myMin(y + BAND_HEIGHT, src_h);
+		tasks.push_back(task);
+		task_group->tasks.push_back(task);
+	}
+
+	if(task_manager && (tasks.size() > 1))
+		task_manager->runTaskGroup(task_group);
+	else
+	{
+		for(size_t i=0; i<tasks.size(); ++i)
+			tasks[i]->run(/*thread_index=*/0);
+	}
+
+	// Merge and write out the rows that straddle band boundaries.
+	const bool alpha_weighted = options.alpha_weighted && ((N == 2) || (N == 4));
+	const size_t S = floatsPerPixel(alpha_weighted);
+	for(size_t z=0; z<outputs.size(); ++z)
+	{
+		const int dst_w = outputs[z].dst_w;
+		std::map<int, std::vector<float>> merged_rows; // Map from destination row index to merged row pixels.
+		for(size_t i=0; i<tasks.size(); ++i) // Merge in band order, so the result doesn't depend on thread scheduling.
+		{
+			const std::vector<PartialRow>& task_partial_rows = tasks[i]->partial_rows[z];
+			for(size_t r=0; r<task_partial_rows.size(); ++r)
+			{
+				std::vector<float>& merged_row = merged_rows[task_partial_rows[r].row_index];
+				const float* row = task_partial_rows[r].pixels.data();
+				if(merged_row.empty())
+					merged_row = task_partial_rows[r].pixels;
+				else
+				{
+					for(size_t q=0; q<(size_t)dst_w * S; q += 4)
+						_mm_storeu_ps(merged_row.data() + q, _mm_add_ps(_mm_loadu_ps(merged_row.data() + q), _mm_loadu_ps(row + q)));
+				}
+			}
+		}
+
+		for(auto it = merged_rows.begin(); it != merged_rows.end(); ++it)
+			finaliseRow(it->second.data(), dst_w, N, options.srgb, alpha_weighted, outputs[z].result->getPixel(0, it->first));
+	}
+}
+
+
+#if BUILD_TESTS
+
+
+static ImageMapUInt8Ref makeRandomImage(PCG32& rng, size_t W, size_t H, size_t N)
+{
+	ImageMapUInt8Ref map = new ImageMapUInt8(W, H, N);
+	for(size_t i=0; i<map->getDataSize(); ++i)
+		map->getData()[i] = (uint8)(rng.unitRandom() * 255.99f);
+	return map;
+}
+
+
+void test()
+{
+	conPrint("TextureDownsampling::test()");
+
+	//------------------------ Test axis taps ------------------------
+	{
+		std::vector<AxisTap> taps;
+
+		// Downsampling 5 to 2: source pixel 2 straddles both destination pixels.
+		computeAxisTaps(5, 2, taps);
+		testAssert(taps[0].dst_index == 0 && epsEqual(taps[0].weight0, 0.4f) && taps[0].weight1 == 0);
+		testAssert(taps[2].dst_index == 0 && epsEqual(taps[2].weight0, 0.2f) && epsEqual(taps[2].weight1, 0.2f));
+		testAssert(taps[4].dst_index == 1 && epsEqual(taps[4].weight0, 0.4f) && taps[4].weight1 == 0);
+
+		// Weights for each destination pixel should sum to 1.
+		computeAxisTaps(1000, 333, taps);
+		std::vector<double> sums(333, 0.0);
+		for(size_t s=0; s<taps.size(); ++s)
+		{
+			testAssert(taps[s].dst_index >= 0 && taps[s].dst_index < 333);
+			testAssert(taps[s].weight1 == 0 || taps[s].dst_index + 1 < 333);
+			sums[taps[s].dst_index] += taps[s].weight0;
+			if(taps[s].weight1 > 0)
+				sums[taps[s].dst_index + 1] += taps[s].weight1;
+		}
+		for(size_t d=0; d<sums.size(); ++d)
+			testAssert(std::fabs(sums[d] - 1.0) < 1.0e-5);
+	}
+
+	//------------------------ Test that 8-bit sRGB values round-trip through linear ------------------------
+	{
+		const ColourSpaceTables& tables = getColourSpaceTables();
+		for(int i=0; i<256; ++i)
+			testAssert(tables.linear_to_srgb[(int)(tables.srgb_to_linear[i] * (LINEAR_TO_SRGB_TABLE_SIZE - 1) + 0.5f)] == i);
+	}
+
+	//------------------------ Test downsampling a constant image gives the same constant ------------------------
+	for(size_t N=1; N<=4; ++N)
+	for(int srgb=0; srgb<2; ++srgb)
+	{
+		const uint8 vals[4] = { 10, 128, 255, 200 };
+		ImageMapUInt8Ref src = new ImageMapUInt8(301, 207, N);
+		for(size_t i=0; i<src->getWidth() * src->getHeight(); ++i)
+			for(size_t c=0; c<N; ++c)
+				src->getPixel(i)[c] = vals[c];
+
+		std::vector<DownsampleOutput> outputs;
+		outputs.push_back(DownsampleOutput(301, 207)); // Same size
+		outputs.push_back(DownsampleOutput(100, 69));
+		outputs.push_back(DownsampleOutput(7, 3));
+		outputs.push_back(DownsampleOutput(1, 1));
+		DownsampleOptions options;
+		options.srgb = srgb != 0;
+		downsample(*src, outputs, options, /*task_manager=*/NULL);
+
+		for(size_t z=0; z<outputs.size(); ++z)
+		{
+			const ImageMapUInt8& res = *outputs[z].result;
+			testAssert((int)res.getWidth() == outputs[z].dst_w && (int)res.getHeight() == outputs[z].dst_h && res.getN() == N);
+			for(size_t i=0; i<res.getWidth() * res.getHeight(); ++i)
+				for(size_t c=0; c<N; ++c)
+					testAssert(res.getPixel(i)[c] == vals[c]);
+		}
+	}
+
+	//------------------------ Test gamma handling ------------------------
+	{
+		// Black and white pixels should average to linear 0.5, which is 188 in sRGB, or 128 if treated as linear.
+		ImageMapUInt8Ref src = new ImageMapUInt8(2, 1, 3);
+		std::memset(src->getPixel(0, 0), 0, 3);
+		std::memset(src->getPixel(1, 0), 255, 3);
+
+		std::vector<DownsampleOutput> outputs(1, DownsampleOutput(1, 1));
+		DownsampleOptions options;
+		options.srgb = true;
+		downsample(*src, outputs, options, NULL);
+		testAssert(outputs[0].result->getPixel(0, 0)[0] == 188);
+
+		options.srgb = false;
+		downsample(*src, outputs, options, NULL);
+		testAssert(outputs[0].result->getPixel(0, 0)[0] == 128);
+	}
+
+	//------------------------ Test alpha weighting ------------------------
+	{
+		// An opaque red pixel and a fully transparent green pixel should give half-transparent red.
+		ImageMapUInt8Ref src = new ImageMapUInt8(2, 1, 4);
+		const uint8 red[4] = { 255, 0, 0, 255 };
+		const uint8 transparent_green[4] = { 0, 255, 0, 0 };
+		std::memcpy(src->getPixel(0, 0), red, 4);
+		std::memcpy(src->getPixel(1, 0), transparent_green, 4);
+
+		std::vector<DownsampleOutput> outputs(1, DownsampleOutput(1, 1));
+		DownsampleOptions options;
+		downsample(*src, outputs, options, NULL);
+		const uint8* res = outputs[0].result->getPixel(0, 0);
+		testAssert(res[0] == 255 && res[1] == 0 && res[2] == 0 && res[3] == 128);
+
+		// Without alpha weighting, the green should bleed in.
+		options.alpha_weighted = false;
+		downsample(*src, outputs, options, NULL);
+		testAssert(outputs[0].result->getPixel(0, 0)[1] == 188);
+	}
+
+	//------------------------ Test fully transparent regions keep their colour ------------------------
+	for(int use_task_manager=0; use_task_manager<2; ++use_task_manager)
+	{
+		glare::TaskManager task_manager("TextureDownsampling test task manager", 4);
+
+		// Left half is opaque red, right half is fully transparent, with a mix of blue and green colour.
+		// Use a tall image so destination rows straddle band boundaries.
+		const int W = 64;
+		const int H = 301;
+		ImageMapUInt8Ref src = new ImageMapUInt8(W, H, 4);
+		for(int y=0; y<H; ++y)
+		for(int x=0; x<W; ++x)
+		{
+			uint8* pixel = src->getPixel(x, y);
+			if(x < W/2)
+			{
+				const uint8 red[4] = { 255, 0, 0, 255 };
+				std::memcpy(pixel, red, 4);
+			}
+			else
+			{
+				const uint8 transparent_blue[4] = { 0, 0, 255, 0 };
+				const uint8 transparent_green[4] = { 0, 255, 0, 0 };
+				std::memcpy(pixel, ((x + y) % 2 == 0) ? transparent_blue : transparent_green, 4);
+			}
+		}
+
+		std::vector<DownsampleOutput> outputs(1, DownsampleOutput(8, 7));
+		DownsampleOptions options;
+		options.srgb = false;
+		downsample(*src, outputs, options, use_task_manager ? &task_manager : NULL);
+
+		const ImageMapUInt8& res = *outputs[0].result;
+		for(int y=0; y<7; ++y)
+		for(int x=0; x<8; ++x)
+		{
+			const uint8* pixel = res.getPixel(x, y);
+			if(x < 4)
+			{
+				// Opaque pixels should be unchanged.
+				testAssert(pixel[0] == 255 && pixel[1] == 0 && pixel[2] == 0 && pixel[3] == 255);
+			}
+			else
+			{
+				// Fully transparent pixels should have the average of the transparent colours, not black.
+				testAssert(pixel[3] == 0);
+				testAssert(pixel[0] == 0);
+				testAssert(std::abs((int)pixel[1] - 128) <= 2 && std::abs((int)pixel[2] - 128) <= 2);
+			}
+		}
+	}
+
+	//------------------------ Test results don't depend on banding or the task manager ------------------------
+	{
+		glare::TaskManager task_manager("TextureDownsampling test task manager", 4);
+
+		PCG32 rng(1);
+		ImageMapUInt8Ref src = makeRandomImage(rng, 1234, 567, 4);
+
+		std::vector<DownsampleOutput> outputs_a, outputs_b;
+		outputs_a.push_back(DownsampleOutput(1000, 459));
+		outputs_a.push_back(DownsampleOutput(256, 117));
+		outputs_a.push_back(DownsampleOutput(64, 29));
+		outputs_a.push_back(DownsampleOutput(1, 1));
+		outputs_b = outputs_a;
+
+		downsample(*src, outputs_a, DownsampleOptions(), NULL);
+		downsample(*src, outputs_b, DownsampleOptions(), &task_manager);
+		for(size_t z=0; z<outputs_a.size(); ++z)
+			testAssert(std::memcmp(outputs_a[z].result->getData(), outputs_b[z].result->getData(), outputs_a[z].result->getDataSize()) == 0);
+
+		// A single output computed by itself should be the same as when computed along with other outputs.
+		std::vector<DownsampleOutput> single_output(1, DownsampleOutput(256, 117));
+		downsample(*src, single_output, DownsampleOptions(), &task_manager);
+		testAssert(std::memcmp(single_output[0].result->getData(), outputs_a[1].result->getData(), single_output[0].result->getDataSize()) == 0);
+
+		// A tall image with a large downsampling factor, where each destination row spans several bands.
+		ImageMapUInt8Ref tall_src = makeRandomImage(rng, 50, 1000, 3);
+		std::vector<DownsampleOutput> tall_outputs_a(1, DownsampleOutput(3, 3));
+		std::vector<DownsampleOutput> tall_outputs_b = tall_outputs_a;
+		downsample(*tall_src, tall_outputs_a, DownsampleOptions(), NULL);
+		downsample(*tall_src, tall_outputs_b, DownsampleOptions(), &task_manager);
+		testAssert(std::memcmp(tall_outputs_a[0].result->getData(), tall_outputs_b[0].result->getData(), tall_outputs_a[0].result->getDataSize()) == 0);
+	}
+
+	//------------------------ Test invalid sizes ------------------------
+	{
+		ImageMapUInt8Ref src = new ImageMapUInt8(100, 100, 3);
+		src->zero();
+		std::vector<DownsampleOutput> outputs(1, DownsampleOutput(101, 10));
+		testThrowsExcepContainingString([&]() { downsample(*src, outputs, DownsampleOptions(), NULL); }, "Invalid destination size");
+		outputs[0] = DownsampleOutput(10, 0);
+		testThrowsExcepContainingString([&]() { downsample(*src, outputs, DownsampleOptions(), NULL); }, "Invalid destination size");
+	}
+
+	//------------------------ Throughput benchmark ------------------------
+	// Make the 3 LOD levels of a 4096 * 4096 RGBA texture, as done for LOD textures.
+	// This is slow, so isn't run as part of the normal test suite.
+	const bool run_benchmark = false;
+	if(run_benchmark)
+	{
+		glare::TaskManager task_manager("TextureDownsampling test task manager", myClamp<size_t>(PlatformUtils::getNumLogicalProcessors(), 1, 8));
+
+		PCG32 rng(1);
+		ImageMapUInt8Ref src = makeRandomImage(rng, 4096, 4096, 4);
+		const double src_MP = 4096 * 4096 * 1.0e-6;
+
+		const int NUM_ITERS = 4;
+		{
+			Timer timer;
+			for(int i=0; i<NUM_ITERS; ++i)
+			{
+				Map2DRef lod0 = src->resizeMidQuality(1024, 1024, &task_manager);
+				Map2DRef lod1 = src->resizeMidQuality(256, 256, &task_manager);
+				Map2DRef lod2 = src->resizeMidQuality(64, 64, &task_manager);
+			}
+			const double elapsed = timer.elapsed() / NUM_ITERS;
+			conPrint("resizeMidQuality x 3:      " + doubleToStringNSigFigs(elapsed * 1.0e3, 4) + " ms (" + doubleToStringNSigFigs(src_MP / elapsed, 4) + " source MP/s)");
+		}
+		{
+			Timer timer;
+			for(int i=0; i<NUM_ITERS; ++i)
+			{
+				std::vector<DownsampleOutput> outputs;
+				outputs.push_back(DownsampleOutput(1024, 1024));
+				outputs.push_back(DownsampleOutput(256, 256));
+				outputs.push_back(DownsampleOutput(64, 64));
+				downsample(*src, outputs, DownsampleOptions(), &task_manager);
+			}
+			const double elapsed = timer.elapsed() / NUM_ITERS;
+			conPrint("downsample (all levels):   " + doubleToStringNSigFigs(elapsed * 1.0e3, 4) + " ms (" + doubleToStringNSigFigs(src_MP / elapsed, 4) + " source MP/s, " +
+				toString(task_manager.getNumThreads()) + " threads)");
+		}
+	}
+
+	conPrint("TextureDownsampling::test() done.");
+}
+
+
+#endif // BUILD_TESTS
+
+
+} // end namespace TextureDownsampling
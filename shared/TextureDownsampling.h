@@ -0,0 +1,71 @@
+/*=====================================================================
+TextureDownsampling.h
+---------------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#pragma once
+
+
+#include <graphics/ImageMap.h>
+#include <Platform.h>
+#include <vector>
+namespace glare { class TaskManager; }
+
+
+/*=====================================================================
+TextureDownsampling
+-------------------
+Downsamples 8-bit textures to smaller sizes, for LOD textures, Basis
+textures and chunk array textures.
+
+Uses a separable box (area) filter: each destination pixel is the average
+of the source area it covers, with fractional weights for source pixels on
+the edges of that area.  When downsampling, a source pixel overlaps at most
+two destination pixels along each axis, so filtering is just two
+multiply-adds per source pixel per output along each axis.
+Filtering is done on 4-wide float pixels with SSE.
+
+All outputs are computed in a single pass over the source image: the source
+is split into bands of rows, and each band is a task.  A band converts each
+of its source rows to linear float once, then accumulates it into every
+output.  Destination rows that straddle two bands are merged after the
+tasks have finished.
+
+sRGB images are filtered in linear space, then converted back to sRGB.
+Colour is weighted by alpha for images with an alpha channel, so that the
+colour of fully transparent pixels doesn't bleed into the result.  The
+unweighted colour is accumulated as well, and is used for destination
+pixels that are fully transparent, so that they keep their colour instead
+of becoming black (which would give dark fringes when filtered later).
+=====================================================================*/
+namespace TextureDownsampling
+{
+
+struct DownsampleOutput
+{
+	DownsampleOutput() {}
+	DownsampleOutput(int dst_w_, int dst_h_) : dst_w(dst_w_), dst_h(dst_h_) {}
+
+	int dst_w, dst_h; // Must be >= 1, and <= the source width and height.
+
+	ImageMapUInt8Ref result; // Set by downsample().  Has the same number of channels as the source.
+};
+
+struct DownsampleOptions
+{
+	DownsampleOptions() : srgb(true), alpha_weighted(true) {}
+
+	bool srgb; // Colour channels are sRGB encoded, so should be converted to linear for filtering.  Alpha is always linear.
+	bool alpha_weighted; // Weight colour by alpha, for images with 2 or 4 channels.
+};
+
+
+// Downsamples src into each output, in a single pass over src.  src must have 1 to 4 channels.  2 and 4 channel images are treated as having alpha in the last channel.
+// Runs on task_manager if non-null, otherwise on the calling thread.
+// Throws glare::Exception if the number of channels or an output size is invalid.
+void downsample(const ImageMapUInt8& src, std::vector<DownsampleOutput>& outputs, const DownsampleOptions& options, glare::TaskManager* task_manager);
+
+
+void test();
+
+} // end namespace TextureDownsampling
@@ -6,50 +6,24 @@ Copyright Glare Technologies Limited 2024 -
 #include "TimerQueue.h"
 
 
+#include <maths/mathstypes.h>
+#include <cmath>
+#include <cassert>
+
+
 TimerQueueTimer::TimerQueueTimer()
 {}
 
 
-TimerQueueTimer::TimerQueueTimer(double tigger_time_) : tigger_time(tigger_time_)/*, valid(true)*/ {}
+TimerQueueTimer::TimerQueueTimer(double tigger_time_) : tigger_time(tigger_time_) {}
 
 
 TimerQueue::TimerQueue()
+:	cur_tick(0),
+	num_timers(0)
 {
-#if 0
-	bucket_max_ttt[0] = 0.03125;
-	bucket_max_ttt[1] = 0.125;
-	bucket_max_ttt[2] = 0.5;
-	bucket_max_ttt[3] = 2;
-	bucket_max_ttt[4] = 8;
-	bucket_max_ttt[5] = 32;
-	bucket_max_ttt[6] = 128;
-	bucket_max_ttt[7] = std::numeric_limits<double>::infinity();
-
-	bucket_min_ttt[0] = 0;
-	bucket_min_ttt[1] = 0.03125;
-	bucket_min_ttt[2] = 0.125;
-	bucket_min_ttt[3] = 0.5;
-	bucket_min_ttt[4] = 2;
-	bucket_min_ttt[5] = 8;
-	bucket_min_ttt[6] = 32;
-	bucket_min_ttt[7] = 128;
-
-	// Initialise buckets
-	for(size_t b=0; b<8; ++b)
-	{
-		TimerQueueBucket& bucket = buckets[b];
-
-		const size_t initial_num = 1024;
-		bucket.timers.resize(initial_num);
-		bucket.freelist.resize(initial_num);
-
-		for(size_t i=0; i<initial_num; ++i)
-			bucket.timers[i].valid = false;
-
-		for(size_t i=0; i<initial_num; ++i)
-			bucket.freelist[i] = (int)i;
-	}
-#endif
+	for(int i=0; i<NUM_LEVELS * NUM_SLOTS_PER_LEVEL; ++i)
+		slot_heads[i] = -1;
 }
 
 
@@ -58,172 +32,221 @@ TimerQueue::~TimerQueue()
 }
 
 
-void TimerQueue::addTimer(double cur_time, const TimerQueueTimer& timer)
+int64 TimerQueue::tickForTime(double t)
 {
-	// const double ttt = timer.tigger_time - cur_time; // time-to-trigger
-	// const size_t new_bucket_i = getBucketForTimeToTrigger(ttt);
-	// addTimerToBucket(timer, new_bucket_i);
-
-	queue.push(timer);
+	return (int64)std::floor(t * TICKS_PER_SECOND);
 }
 
 
-void TimerQueue::update(double cur_time, std::vector<TimerQueueTimer>& triggered_timers_out)
+// Places the node in the slot for its expire tick, relative to cur_tick.
+void TimerQueue::insertNode(int node_i)
 {
-	triggered_timers_out.resize(0);
+	TimerNode& node = nodes[node_i];
 
-#if 1
-	while(!queue.empty() && queue.top().tigger_time <= cur_time)
+	int64 e = myMax(node.expire_tick, cur_tick); // Timers that are already due go in the current tick slot, which will be processed on the next update.
+	int64 delta = e - cur_tick;
+
+	int slot_i;
+	if(delta < NUM_SLOTS_PER_LEVEL)
 	{
-		triggered_timers_out.push_back(queue.top());
-		queue.pop();
+		slot_i = (int)(e & (NUM_SLOTS_PER_LEVEL - 1));
 	}
-#else
-	for(size_t b=0; b<8; ++b)
+	else
 	{
-		TimerQueueBucket& bucket = buckets[b];
+		const int64 max_delta = ((int64)1 << (SLOT_BITS * NUM_LEVELS)) - 1;
+		if(delta > max_delta)
+		{
+			// Timer is too far in the future for the wheel.  Place it at the furthest slot, it will get redistributed to another slot when that slot is cascaded.
+			e = cur_tick + max_delta;
+			delta = max_delta;
+		}
 
-		const double min_ttt = bucket_min_ttt[b];
+		int level = 1;
+		while(delta >= ((int64)1 << (SLOT_BITS * (level + 1))))
+			level++;
+		assert(level < NUM_LEVELS);
 
-		const double min_trigger_time = cur_time + min_ttt; // Minimum trigger time for a timer to remain in this bucket.
+		slot_i = level * NUM_SLOTS_PER_LEVEL + (int)((e >> (SLOT_BITS * level)) & (NUM_SLOTS_PER_LEVEL - 1));
+	}
 
-		for(size_t i=0; i<bucket.timers.size(); ++i)
-		{
-			TimerQueueTimer& timer = bucket.timers[i];
-			if(timer.valid)
-			{
-				const double tt = timer.tigger_time;
-				if(cur_time >= tt)
-				{
-					// Timer has triggered
-					triggered_timers_out.push_back(timer);
+	// Push onto front of slot list
+	node.slot = slot_i;
+	node.prev = -1;
+	node.next = slot_heads[slot_i];
+	if(node.next >= 0)
+		nodes[node.next].prev = node_i;
+	slot_heads[slot_i] = node_i;
+}
 
-					timer.valid = false;
 
-					// Add to free list
-					bucket.freelist.push_back((int)i);
-				}
-				else
-				{
-					if(tt < min_trigger_time)
-					{
-						const double ttt = tt - cur_time;
-						const size_t new_bucket_i = getBucketForTimeToTrigger(ttt);
-						if(new_bucket_i != b) // Check we don't try and remove and add to same bucket due to numerical issues.
-						{
-							// Remove from this bucket, place in other bucket
-							timer.valid = false;
-
-							// Add to free list
-							bucket.freelist.push_back((int)i);
-
-							addTimerToBucket(timer, new_bucket_i);
-						}
-					}
-				}
-			}
-		}
-	}
-#endif
+void TimerQueue::unlinkNode(int node_i)
+{
+	TimerNode& node = nodes[node_i];
+	assert(node.slot >= 0);
+
+	if(node.prev >= 0)
+		nodes[node.prev].next = node.next;
+	else
+		slot_heads[node.slot] = node.next;
+
+	if(node.next >= 0)
+		nodes[node.next].prev = node.prev;
+
+	node.prev = node.next = -1;
 }
 
-void TimerQueue::clear()
+
+// Marks node as free.  Node should already be unlinked from any slot list.
+void TimerQueue::freeNode(int node_i)
 {
-	while(!queue.empty())
-		queue.pop();
+	TimerNode& node = nodes[node_i];
+	node.slot = -1;
+	node.generation++; // Invalidate any existing handles to this node.
+	node.timer.lua_script_evaluator = nullptr;
+	free_nodes.push_back(node_i);
+	num_timers--;
 }
 
-#if 0
-size_t TimerQueue::numValidTimersInBucket(size_t bucket_i)
+
+int TimerQueue::detachSlot(int slot_i)
 {
-	const TimerQueueBucket& bucket = buckets[bucket_i];
+	const int head = slot_heads[slot_i];
+	slot_heads[slot_i] = -1;
+	return head;
+}
 
-	size_t num = 0;
-	for(size_t i=0; i<bucket.timers.size(); ++i)
-		if(bucket.timers[i].valid)
-			num++;
-	return num;
+
+TimerQueueHandle TimerQueue::addTimer(double cur_time, const TimerQueueTimer& timer)
+{
+	int node_i;
+	if(!free_nodes.empty())
+	{
+		node_i = free_nodes.back();
+		free_nodes.pop_back();
+	}
+	else
+	{
+		node_i = (int)nodes.size();
+		nodes.push_back(TimerNode());
+		nodes.back().generation = 0;
+	}
+
+	TimerNode& node = nodes[node_i];
+	node.timer = timer;
+	node.timer.handle.index = node_i;
+	node.timer.handle.generation = node.generation;
+	node.expire_tick = tickForTime(timer.tigger_time);
+	insertNode(node_i);
+	num_timers++;
+
+	return node.timer.handle;
 }
 
 
-size_t TimerQueue::getBucketForTimeToTrigger(double ttt)
+void TimerQueue::removeTimer(TimerQueueHandle handle)
 {
-	/*
-	0.03125
-	0.125
-	0.5
-	2
-	8
-	32
-	128
-	inf
-	*/
-
-	if(ttt < 2.0)
+	if(handle.index < 0 || handle.index >= (int)nodes.size())
+		return;
+
+	TimerNode& node = nodes[handle.index];
+	if(node.slot < 0 || node.generation != handle.generation) // If node is free, or has been reused for another timer:
+		return;
+
+	unlinkNode(handle.index);
+	freeNode(handle.index);
+}
+
+
+// Fire any timers in the slot for cur_tick with trigger time <= cur_time.
+void TimerQueue::processCurTickSlot(double cur_time, std::vector<TimerQueueTimer>& triggered_timers_out)
+{
+	int node_i = detachSlot((int)(cur_tick & (NUM_SLOTS_PER_LEVEL - 1)));
+	while(node_i >= 0)
 	{
-		if(ttt < 0.125)
+		TimerNode& node = nodes[node_i];
+		const int next = node.next;
+
+		if(node.timer.tigger_time <= cur_time)
 		{
-			if(ttt < 0.03125)
-				return 0;
+			triggered_timers_out.push_back(node.timer);
+
+			if(node.timer.repeating)
+			{
+				// Reschedule with updated trigger time.  Since the slot list was detached, a timer with a small period won't fire again in this update.
+				node.timer.tigger_time = cur_time + node.timer.period;
+				node.expire_tick = tickForTime(node.timer.tigger_time);
+				insertNode(node_i);
+			}
 			else
-				return 1; // < 0.125
+				freeNode(node_i);
 		}
 		else
-		{
-			if(ttt < 0.5)
-				return 2;
-			else
-				return 3; // < 2
-		}
+			insertNode(node_i); // Not due yet, put back in slot.
+
+		node_i = next;
 	}
-	else // ttt >= 2
+}
+
+
+void TimerQueue::update(double cur_time, std::vector<TimerQueueTimer>& triggered_timers_out)
+{
+	triggered_timers_out.resize(0);
+
+	const int64 new_tick = tickForTime(cur_time);
+
+	if(num_timers == 0)
 	{
-		if(ttt < 32.0)
+		cur_tick = myMax(cur_tick, new_tick);
+		return;
+	}
+
+	processCurTickSlot(cur_time, triggered_timers_out);
+
+	while(cur_tick < new_tick)
+	{
+		cur_tick++;
+
+		// Cascade timers down from higher levels when we cross a slot boundary of that level.
+		for(int level=1; level<NUM_LEVELS; ++level)
 		{
-			if(ttt < 8.0)
-				return 4;
-			else
-				return 5; // < 32
+			const int shift = SLOT_BITS * level;
+			if((cur_tick & (((int64)1 << shift) - 1)) != 0)
+				break;
+
+			int node_i = detachSlot(level * NUM_SLOTS_PER_LEVEL + (int)((cur_tick >> shift) & (NUM_SLOTS_PER_LEVEL - 1)));
+			while(node_i >= 0)
+			{
+				const int next = nodes[node_i].next;
+				insertNode(node_i);
+				node_i = next;
+			}
 		}
-		else
+
+		processCurTickSlot(cur_time, triggered_timers_out);
+
+		if(num_timers == 0)
 		{
-			if(ttt < 128)
-				return 6;
-			else
-				return 7; // < inf
+			cur_tick = new_tick;
+			break;
 		}
 	}
 }
 
 
-void TimerQueue::addTimerToBucket(const TimerQueueTimer& timer, size_t new_bucket_i)
+void TimerQueue::clear()
 {
-	TimerQueueBucket& new_bucket = buckets[new_bucket_i];
-
-	// Query freelist of bucket
-	if(new_bucket.freelist.empty()) // If there are no free slots in bucket:
+	for(int i=0; i<NUM_LEVELS * NUM_SLOTS_PER_LEVEL; ++i)
 	{
-		// Expand bucket
-		const size_t old_size = new_bucket.timers.size();
-		const size_t new_num_items = old_size;
-		new_bucket.timers.resize(old_size + new_num_items);
-
-		// Add new slots to freelist
-		const size_t old_freelist_size = new_bucket.freelist.size();
-		new_bucket.freelist.resize(old_freelist_size + new_num_items);
-		for(size_t z=0; z<new_num_items; ++z)
-			new_bucket.freelist[old_freelist_size + z] = (int)(old_size + z);
+		int node_i = detachSlot(i);
+		while(node_i >= 0)
+		{
+			const int next = nodes[node_i].next;
+			freeNode(node_i);
+			node_i = next;
+		}
 	}
-
-	assert(!new_bucket.freelist.empty());
-	const int free_index = new_bucket.freelist.back();
-	new_bucket.freelist.pop_back();
-	assert(free_index < (int)new_bucket.timers.size());
-
-	new_bucket.timers[free_index] = timer;
-	new_bucket.timers[free_index].valid = true;
+	assert(num_timers == 0);
 }
-#endif
 
 
 #if BUILD_TESTS
@@ -234,23 +257,26 @@ void TimerQueue::addTimerToBucket(const TimerQueueTimer& timer, size_t new_bucke
 #include "../utils/TestUtils.h"
 #include "../maths/PCG32.h"
 #include <Timer.h>
+#include <algorithm>
+#include <limits>
 
 
 void TimerQueue::test()
 {
 	conPrint("TimerQueue::test()");
 
-#if 1
 	{
 		TimerQueue timer_queue;
 
 		
 		TimerQueueTimer timer_a(1.0);
 		timer_a.timer_id = 0;
+		timer_a.repeating = false;
 		timer_queue.addTimer(/*cur time=*/0.0, timer_a);
 
 		TimerQueueTimer timer_b(2.0);
 		timer_b.timer_id = 1;
+		timer_b.repeating = false;
 		timer_queue.addTimer(/*cur time=*/0.0, timer_b);
 		
 		std::vector<TimerQueueTimer> triggered_timers;
@@ -265,68 +291,195 @@ void TimerQueue::test()
 
 		timer_queue.update(/*cur_time=*/2.5, triggered_timers);
 		testAssert(triggered_timers.size() == 1 && triggered_timers[0].timer_id == 1);
+		testAssert(timer_queue.numTimers() == 0);
 	}
 
+	// Test timers fire exactly when cur_time reaches the trigger time, even within a tick.
 	{
 		TimerQueue timer_queue;
 
-		PCG32 rng(1);
-		for(int i=0; i<1000; ++i)
+		TimerQueueTimer timer_a(1.01);
+		timer_a.timer_id = 0;
+		timer_a.repeating = false;
+		timer_queue.addTimer(/*cur time=*/0.0, timer_a);
+
+		std::vector<TimerQueueTimer> triggered_timers;
+		timer_queue.update(/*cur_time=*/1.005, triggered_timers);
+		testAssert(triggered_timers.empty());
+		timer_queue.update(/*cur_time=*/1.01, triggered_timers);
+		testAssert(triggered_timers.size() == 1);
+	}
+
+	// Test removing timers, and stale handles
+	{
+		TimerQueue timer_queue;
+
+		TimerQueueTimer timer_a(1.0);
+		timer_a.timer_id = 0;
+		timer_a.repeating = false;
+		const TimerQueueHandle handle_a = timer_queue.addTimer(/*cur time=*/0.0, timer_a);
+
+		timer_queue.removeTimer(handle_a);
+		testAssert(timer_queue.numTimers() == 0);
+		timer_queue.removeTimer(handle_a); // Removing again should have no effect.
+
+		// Node should be reused, but old handle should be stale.
+		const TimerQueueHandle handle_b = timer_queue.addTimer(/*cur time=*/0.0, timer_a);
+		testAssert(handle_b.index == handle_a.index && handle_b.generation != handle_a.generation);
+		timer_queue.removeTimer(handle_a);
+		testAssert(timer_queue.numTimers() == 1);
+
+		std::vector<TimerQueueTimer> triggered_timers;
+		timer_queue.update(/*cur_time=*/2.0, triggered_timers);
+		testAssert(triggered_timers.size() == 1 && triggered_timers[0].handle.index == handle_b.index && triggered_timers[0].handle.generation == handle_b.generation);
+	}
+
+	// Test repeating timers
+	{
+		TimerQueue timer_queue;
+
+		TimerQueueTimer timer_a(1.0);
+		timer_a.timer_id = 0;
+		timer_a.repeating = true;
+		timer_a.period = 1.0;
+		const TimerQueueHandle handle_a = timer_queue.addTimer(/*cur time=*/0.0, timer_a);
+
+		std::vector<TimerQueueTimer> triggered_timers;
+		int num_triggered = 0;
+		for(int i=1; i<=100; ++i)
 		{
-			TimerQueueTimer timer_a(rng.unitRandom() * 1000.0);
-			timer_queue.addTimer(/*cur time=*/0.0, timer_a);
+			timer_queue.update(/*cur_time=*/i * 0.1, triggered_timers);
+			num_triggered += (int)triggered_timers.size();
 		}
+		testAssert(num_triggered == 10);
+		testAssert(timer_queue.numTimers() == 1);
+
+		timer_queue.removeTimer(handle_a);
+		testAssert(timer_queue.numTimers() == 0);
+		timer_queue.update(/*cur_time=*/100.0, triggered_timers);
+		testAssert(triggered_timers.empty());
+	}
+
+	// Test timers far in the future, past the range covered by the wheel.
+	{
+		TimerQueue timer_queue;
+
+		TimerQueueTimer timer_a(1.0e6);
+		timer_a.timer_id = 0;
+		timer_a.repeating = false;
+		timer_queue.addTimer(/*cur time=*/0.0, timer_a);
 
 		std::vector<TimerQueueTimer> triggered_timers;
-		for(int t=0; t<1000; ++t)
+		timer_queue.update(/*cur_time=*/1.0e6 - 1.0, triggered_timers);
+		testAssert(triggered_timers.empty());
+		timer_queue.update(/*cur_time=*/1.0e6, triggered_timers);
+		testAssert(triggered_timers.size() == 1);
+	}
+
+	// Randomised test against a brute-force reference implementation
+	{
+		TimerQueue timer_queue;
+
+		PCG32 rng(1);
+		struct RefTimer { double trigger_time; bool repeating; double period; TimerQueueHandle handle; };
+		std::vector<RefTimer> ref_timers;
+		std::vector<TimerQueueTimer> triggered_timers;
+
+		double cur_time = 0;
+		for(int iter=0; iter<2000; ++iter)
 		{
-			timer_queue.update(/*cur_time=*/(double)t, triggered_timers);
-			
-			for(size_t z=0; z<triggered_timers.size(); ++z)
+			// Add some timers
+			const int num_to_add = (int)(rng.unitRandom() * 5);
+			for(int i=0; i<num_to_add; ++i)
 			{
-				testAssert(triggered_timers[z].tigger_time <= (double)t);
-				printVar(triggered_timers[z].tigger_time);
+				TimerQueueTimer timer(cur_time + ((rng.unitRandom() < 0.1f) ? rng.unitRandom() * 10000.0 : rng.unitRandom() * 20.0));
+				timer.timer_id = (int)ref_timers.size();
+				timer.repeating = rng.unitRandom() < 0.3f;
+				timer.period = 0.1 + rng.unitRandom() * 5.0;
+				const TimerQueueHandle handle = timer_queue.addTimer(cur_time, timer);
+				ref_timers.push_back({timer.tigger_time, timer.repeating, timer.period, handle});
 			}
-		}
 
-		// Perf test
-		Timer timer;
-		const int NUM_TIMERS = 1000;
-		for(int i=0; i<NUM_TIMERS; ++i)
-		{
-			TimerQueueTimer timer_a(rng.unitRandom() * 1000.0);
-			timer_queue.addTimer(/*cur time=*/0.0, timer_a);
-		}
+			// Remove a random timer sometimes
+			if(!ref_timers.empty() && rng.unitRandom() < 0.3f)
+			{
+				const size_t i = myMin(ref_timers.size() - 1, (size_t)(rng.unitRandom() * ref_timers.size()));
+				timer_queue.removeTimer(ref_timers[i].handle);
+				ref_timers[i].trigger_time = std::numeric_limits<double>::infinity(); // Mark as removed
+				ref_timers[i].repeating = false;
+			}
 
-		for(int t=0; t<NUM_TIMERS; ++t)
-		{
-			timer_queue.update(/*cur_time=*/(double)t, triggered_timers);
-		}
+			cur_time += (rng.unitRandom() < 0.01f) ? rng.unitRandom() * 2000.0 : rng.unitRandom() * 0.3;
 
-		const double elapsed = timer.elapsed();
-		conPrint("Adding and removing " + toString(NUM_TIMERS) + " timers took " + doubleToStringNSigFigs(elapsed * 1.0e3, 4) + " ms");
-		const double time_per_timer = elapsed / NUM_TIMERS * 1.0e9;
-		conPrint("time_per_timer (ns): " + toString(time_per_timer));
+			timer_queue.update(cur_time, triggered_timers);
 
+			// Check triggered timers match the reference timers
+			size_t num_expected = 0;
+			for(size_t i=0; i<ref_timers.size(); ++i)
+				if(ref_timers[i].trigger_time <= cur_time)
+					num_expected++;
+			testAssert(triggered_timers.size() == num_expected);
+
+			for(size_t z=0; z<triggered_timers.size(); ++z)
+			{
+				RefTimer& ref_timer = ref_timers[triggered_timers[z].timer_id];
+				testAssert(ref_timer.trigger_time <= cur_time);
+				testAssert(triggered_timers[z].tigger_time == ref_timer.trigger_time);
+				if(ref_timer.repeating)
+					ref_timer.trigger_time = cur_time + ref_timer.period;
+				else
+					ref_timer.trigger_time = std::numeric_limits<double>::infinity(); // Mark as fired
+			}
+		}
 	}
 
-#else
+	// Perf test with 100k active timers
 	{
 		TimerQueue timer_queue;
+		PCG32 rng(1);
 
-		
-		timer_queue.addTimer(/*cur time=*/0.0, TimerQueueTimer(1.0)); // Should insert in bucket 3.
-		testAssert(timer_queue.numValidTimersInBucket(/*bucket_i=*/0) == 0);
-		testAssert(timer_queue.numValidTimersInBucket(/*bucket_i=*/3) == 1);
+		const int NUM_TIMERS = 100000;
+		std::vector<TimerQueueHandle> handles(NUM_TIMERS);
+
+		Timer timer;
+		for(int i=0; i<NUM_TIMERS; ++i)
+		{
+			TimerQueueTimer timer_a(rng.unitRandom() * 10.0);
+			timer_a.timer_id = i;
+			timer_a.repeating = true;
+			timer_a.period = 0.1 + rng.unitRandom() * 10.0;
+			handles[i] = timer_queue.addTimer(/*cur time=*/0.0, timer_a);
+		}
+		const double add_elapsed = timer.elapsed();
+		conPrint("Adding " + toString(NUM_TIMERS) + " timers took " + doubleToStringNSigFigs(add_elapsed * 1.0e3, 4) + " ms (" + doubleToStringNSigFigs(add_elapsed / NUM_TIMERS * 1.0e9, 4) + " ns / timer)");
 
+		// Simulate 100 s of server main loop iterations, one every 0.1 s.
+		timer.reset();
 		std::vector<TimerQueueTimer> triggered_timers;
-		timer_queue.update(/*cur_time=*/0.6, triggered_timers); // time-to-trigger will be 0.4, so should move to bucket 2.
-		testAssert(timer_queue.numValidTimersInBucket(/*bucket_i=*/2) == 1);
-		testAssert(timer_queue.numValidTimersInBucket(/*bucket_i=*/3) == 0);
+		size_t num_triggered = 0;
+		const int NUM_UPDATES = 1000;
+		for(int t=1; t<=NUM_UPDATES; ++t)
+		{
+			timer_queue.update(/*cur_time=*/t * 0.1, triggered_timers);
+			num_triggered += triggered_timers.size();
+		}
+		const double update_elapsed = timer.elapsed();
+		testAssert(timer_queue.numTimers() == NUM_TIMERS);
+		conPrint(toString(NUM_UPDATES) + " updates with " + toString(NUM_TIMERS) + " repeating timers took " + doubleToStringNSigFigs(update_elapsed * 1.0e3, 4) + " ms (" + 
+			doubleToStringNSigFigs(update_elapsed / NUM_UPDATES * 1.0e6, 4) + " us / update, " + toString(num_triggered) + " timer events, " + 
+			doubleToStringNSigFigs(update_elapsed / num_triggered * 1.0e9, 4) + " ns / event)");
 
-		testAssert(triggered_timers.empty());
+		// Remove all timers, in random order
+		for(int i=NUM_TIMERS-1; i>0; --i)
+			std::swap(handles[i], handles[myMin(i, (int)(rng.unitRandom() * (i + 1)))]);
+
+		timer.reset();
+		for(int i=0; i<NUM_TIMERS; ++i)
+			timer_queue.removeTimer(handles[i]);
+		const double remove_elapsed = timer.elapsed();
+		testAssert(timer_queue.numTimers() == 0);
+		conPrint("Removing " + toString(NUM_TIMERS) + " timers took " + doubleToStringNSigFigs(remove_elapsed * 1.0e3, 4) + " ms (" + doubleToStringNSigFigs(remove_elapsed / NUM_TIMERS * 1.0e9, 4) + " ns / timer)");
 	}
-#endif
 
 	conPrint("TimerQueue::test() done");
 }
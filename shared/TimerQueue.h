@@ -9,16 +9,27 @@ Copyright Glare Technologies Limited 2024 -
 #include <maths/Vec4f.h>
 #include <utils/RefCounted.h>
 #include <utils/WeakReference.h>
-#include <utils/GenerationalArray.h>
+#include <utils/Platform.h>
 #include <string>
 #include <vector>
-#include <queue>
 
 
 class LuaScript;
 class LuaScriptEvaluator;
 
 
+// Identifies a timer in a TimerQueue.  Becomes stale once the timer is removed or has fired (for one-shot timers).
+struct TimerQueueHandle
+{
+	TimerQueueHandle() : index(-1), generation(0) {}
+
+	bool valid() const { return index >= 0; }
+
+	int index; // Index of timer node in TimerQueue, or -1 if invalid.
+	uint32 generation; // Generation of timer node, used to detect stale handles (ABA problem)
+};
+
+
 class TimerQueueTimer
 {
 public:
@@ -26,7 +37,6 @@ public:
 	TimerQueueTimer(double tigger_time_);
 
 	double tigger_time;
-	//bool valid;
 
 	int onTimerEvent_ref; // Reference to Lua function
 	bool repeating;
@@ -34,14 +44,8 @@ public:
 	int timer_index;
 	int timer_id;
 	WeakReference<LuaScriptEvaluator> lua_script_evaluator;
-};
 
-
-class TimerQueueBucket
-{
-public:
-	std::vector<TimerQueueTimer> timers;
-	std::vector<int> freelist;
+	TimerQueueHandle handle; // Set by TimerQueue::addTimer().
 };
 
 
@@ -49,9 +53,14 @@ public:
 TimerQueue
 ----------
 Handles timer events for Lua scripts.
-Currently using priority_queue.
-There is also some commented-out and unfinished code for a bucket-based solution
-that may be more efficient.
+
+Uses a hierarchical timing wheel, see 'Hashed and Hierarchical Timing Wheels', Varghese and Lauck.
+Time is quantised into ticks of 1/32 s.  There are NUM_LEVELS wheels of 64 slots each, where
+a slot in level l covers 64^l ticks.  Each slot is an intrusive doubly-linked list of timer nodes,
+so adding and removing timers is O(1).
+When the current tick crosses a level l slot boundary, the timers in the level l slot are
+redistributed to lower levels.
+Timers fire on the first update() call where cur_time >= the timer trigger time.
 =====================================================================*/
 class TimerQueue
 {
@@ -59,37 +68,48 @@ public:
 	TimerQueue();
 	~TimerQueue();
 
-	void addTimer(double cur_time, const TimerQueueTimer& timer);
-	/*
-	segment 0: time to trigger < 0.03125
-	0.125
-	0.5
-	2
-	8
-	32
-	128
-	inf
-	*/
+	// Returns handle that can be used to remove the timer.
+	TimerQueueHandle addTimer(double cur_time, const TimerQueueTimer& timer);
 
+	// Removes the timer from the queue.  Does nothing if the timer has already been removed or has fired (and is not repeating).
+	void removeTimer(TimerQueueHandle handle);
+
+	// Triggered timers are returned in triggered_timers_out.
+	// Triggered one-shot timers are removed from the queue.  Triggered repeating timers are rescheduled to fire at cur_time + period, and keep the same handle.
 	void update(double cur_time, std::vector<TimerQueueTimer>& triggered_timers_out);
 
 	void clear(); // Just used for testing
 
+	size_t numTimers() const { return num_timers; }
+
 	static void test();
 
 private:
-	//size_t numValidTimersInBucket(size_t bucket_i);
-	//size_t getBucketForTimeToTrigger(double ttt);
-	//void addTimerToBucket(const TimerQueueTimer& timer, size_t new_bucket_i);
-
-	//TimerQueueBucket buckets[8];
-	//double bucket_min_ttt[8];
-	//double bucket_max_ttt[8];
+	static const int TICKS_PER_SECOND = 32;
+	static const int SLOT_BITS = 6;
+	static const int NUM_SLOTS_PER_LEVEL = 1 << SLOT_BITS;
+	static const int NUM_LEVELS = 4; // Covers 2^24 ticks = ~6 days.  Timers further in the future than that are placed in the last level and redistributed as needed.
 
-	struct TimerComparator
+	struct TimerNode
 	{
-		bool operator() (const TimerQueueTimer& a, const TimerQueueTimer& b) const { return a.tigger_time > b.tigger_time; }
+		TimerQueueTimer timer;
+		int64 expire_tick;
+		int prev;
+		int next;
+		int slot; // Index of slot (in slot_heads) that this node is in, or -1 if node is free.
+		uint32 generation;
 	};
 
-	std::priority_queue<TimerQueueTimer, std::vector<TimerQueueTimer>, TimerComparator> queue;
+	static int64 tickForTime(double t);
+	void insertNode(int node_i);
+	void unlinkNode(int node_i);
+	void freeNode(int node_i);
+	int detachSlot(int slot_i); // Removes all nodes from the slot, returns head of the list.
+	void processCurTickSlot(double cur_time, std::vector<TimerQueueTimer>& triggered_timers_out);
+
+	std::vector<TimerNode> nodes;
+	std::vector<int> free_nodes;
+	int slot_heads[NUM_LEVELS * NUM_SLOTS_PER_LEVEL];
+	int64 cur_tick; // Timers due at ticks < cur_tick have fired.  Timers due at cur_tick may not have fired yet.
+	size_t num_timers;
 };
@@ -0,0 +1,239 @@
+/*=====================================================================
+URLAtom.cpp
+-----------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#include "URLAtom.h"
+
+
+#include <utils/Lock.h>
+#include <utils/ConPrint.h>
+#include <utils/StringUtils.h>
+#include <maths/mathstypes.h>
+
+
+static const URLString empty_url_string;
+
+
+URLAtom& URLAtom::operator = (std::string_view s)
+{
+	if(s.empty())
+		entry = Reference<URLAtomEntry>();
+	else if(entry.isNull() || (std::string_view(entry->str) != s))
+		entry = URLAtomTable::getGlobalTable().intern(s);
+	return *this;
+}
+
+
+const URLString& URLAtom::str() const
+{
+	return entry.nonNull() ? entry->str : empty_url_string;
+}
+
+
+size_t URLAtom::hash() const
+{
+	return entry.nonNull() ? entry->hash : URLStringHasher()(empty_url_string);
+}
+
+
+URLAtomTable::URLAtomTable()
+{}
+
+
+URLAtomTable::~URLAtomTable()
+{}
+
+
+URLAtomTable& URLAtomTable::getGlobalTable()
+{
+	static URLAtomTable table;
+	return table;
+}
+
+
+Reference<URLAtomEntry> URLAtomTable::intern(std::string_view s)
+{
+	const size_t hash = std::hash<std::string_view>()(s);
+	Shard& shard = shards[hash % NUM_SHARDS];
+
+	Lock lock(shard.mutex);
+
+	const auto res = shard.entries.find(s);
+	if(res != shard.entries.end())
+		return res->second;
+
+	Reference<URLAtomEntry> entry = new URLAtomEntry();
+	entry->str = URLString(s);
+	entry->hash = hash;
+	shard.entries.insert(std::make_pair(std::string_view(entry->str), entry)); // Key points into entry->str, which doesn't move while the entry is alive.
+	return entry;
+}
+
+
+size_t URLAtomTable::removeUnreferencedAtoms()
+{
+	size_t num_removed = 0;
+	for(size_t i=0; i<NUM_SHARDS; ++i)
+	{
+		Shard& shard = shards[i];
+
+		Lock lock(shard.mutex);
+
+		// An entry with a reference count of 1 is only referenced by the table.  New references to it can only be made by intern(), which holds the shard mutex,
+		// so it can't be referenced again while we hold the mutex.
+		for(auto it = shard.entries.begin(); it != shard.entries.end(); )
+		{
+			if(it->second->getRefCount() == 1)
+			{
+				it = shard.entries.erase(it);
+				num_removed++;
+			}
+			else
+				++it;
+		}
+	}
+	return num_removed;
+}
+
+
+URLAtomTable::Stats URLAtomTable::getStats() const
+{
+	Stats stats;
+	stats.num_atoms = 0;
+	stats.num_references = 0;
+	stats.total_string_size_B = 0;
+	stats.bytes_saved = 0;
+
+	const size_t SSO_CAPACITY = 15; // Strings up to this length are stored in the URLString object itself, with no heap allocation (libstdc++, MSVC).
+	const size_t TABLE_OVERHEAD_PER_ENTRY_B = 64; // Rough size of an unordered_map node and bucket.
+
+	for(size_t i=0; i<NUM_SHARDS; ++i)
+	{
+		const Shard& shard = shards[i];
+
+		Lock lock(shard.mutex);
+
+		for(auto it = shard.entries.begin(); it != shard.entries.end(); ++it)
+		{
+			const URLAtomEntry* entry = it->second.ptr();
+			const size_t num_refs = (size_t)myMax<int64>(0, (int64)entry->getRefCount() - 1); // Don't count the reference held by the table.
+			const size_t heap_size = (entry->str.size() > SSO_CAPACITY) ? (entry->str.capacity() + 1) : 0;
+
+			const int64 size_without_interning = (int64)(num_refs * (sizeof(URLString) + heap_size));
+			const int64 size_with_interning = (int64)(num_refs * sizeof(URLAtom) + sizeof(URLAtomEntry) + heap_size + TABLE_OVERHEAD_PER_ENTRY_B);
+
+			stats.num_atoms++;
+			stats.num_references += num_refs;
+			stats.total_string_size_B += entry->str.size();
+			stats.bytes_saved += size_without_interning - size_with_interning;
+		}
+	}
+	return stats;
+}
+
+
+#if BUILD_TESTS
+
+
+#include <utils/TestUtils.h>
+#include <thread>
+#include <vector>
+
+
+void URLAtomTable::test()
+{
+	conPrint("URLAtomTable::test()");
+
+	//------------------------ Test basic interning and comparison ------------------------
+	{
+		URLAtom a(std::string_view("Cube_obj_11907297875084081315.bmesh"));
+		URLAtom b;
+		testAssert(b.empty() && b.size() == 0 && b.str().empty());
+		testAssert(b == URLAtom());
+		testAssert(a != b);
+
+		b = toURLString("Cube_obj_11907297875084081315.bmesh");
+		testAssert(a == b);
+		testAssert(&a.str() == &b.str()); // Should share the same string.
+		testAssert(a.hash() == URLStringHasher()(a.str()));
+
+		// Comparisons with strings
+		testAssert(a == "Cube_obj_11907297875084081315.bmesh");
+		testAssert("Cube_obj_11907297875084081315.bmesh" == a);
+		testAssert(a == toURLString("Cube_obj_11907297875084081315.bmesh"));
+		testAssert(a != "Icosahedron_obj_136334556484365507.bmesh");
+
+		// Conversions
+		const URLString& s = a;
+		testAssert(s == "Cube_obj_11907297875084081315.bmesh");
+		testAssert(toStdString(a) == "Cube_obj_11907297875084081315.bmesh");
+		testAssert(std::string(a.c_str()) == "Cube_obj_11907297875084081315.bmesh");
+		testAssert(a.find_last_of('.') == std::string("Cube_obj_11907297875084081315").size());
+
+		b = std::string("Icosahedron_obj_136334556484365507.bmesh");
+		testAssert(a != b);
+		testAssert(b == "Icosahedron_obj_136334556484365507.bmesh");
+
+		// Assigning the empty string should give the null atom.
+		b = "";
+		testAssert(b.empty() && b == URLAtom());
+
+		a.clear();
+		testAssert(a.empty());
+	}
+
+	//------------------------ Test removal of unreferenced atoms ------------------------
+	{
+		URLAtomTable table;
+		Reference<URLAtomEntry> e1 = table.intern("a.jpg");
+		Reference<URLAtomEntry> e2 = table.intern("b.jpg");
+		testAssert(table.intern("a.jpg").ptr() == e1.ptr());
+		testAssert(table.getStats().num_atoms == 2);
+
+		e1 = Reference<URLAtomEntry>();
+		testAssert(table.removeUnreferencedAtoms() == 1);
+		testAssert(table.getStats().num_atoms == 1);
+		testAssert(table.intern("b.jpg").ptr() == e2.ptr());
+	}
+
+	//------------------------ Test memory stats for many objects sharing a few URLs ------------------------
+	{
+		URLAtomTable::Stats stats_before = getGlobalTable().getStats();
+
+		std::vector<URLAtom> atoms(10000);
+		for(size_t i=0; i<atoms.size(); ++i)
+			atoms[i] = "some_model_url_with_a_long_hash_" + toString(i % 100) + ".bmesh";
+
+		const URLAtomTable::Stats stats = getGlobalTable().getStats();
+		testAssert(stats.num_atoms - stats_before.num_atoms == 100);
+		testAssert(stats.num_references - stats_before.num_references == 10000);
+		testAssert(stats.bytes_saved > stats_before.bytes_saved);
+		conPrint("10000 atoms of 100 distinct URLs: estimated " + toString(stats.bytes_saved - stats_before.bytes_saved) + " B saved.");
+	}
+	getGlobalTable().removeUnreferencedAtoms();
+
+	//------------------------ Test concurrent interning ------------------------
+	{
+		URLAtomTable table;
+		std::vector<std::vector<Reference<URLAtomEntry>>> thread_entries(4);
+		std::vector<std::thread> threads;
+		for(int t=0; t<4; ++t)
+			threads.push_back(std::thread([&table, &thread_entries, t]() {
+				for(int i=0; i<10000; ++i)
+					thread_entries[t].push_back(table.intern("url_" + toString(i % 1000)));
+			}));
+		for(size_t t=0; t<threads.size(); ++t)
+			threads[t].join();
+
+		testAssert(table.getStats().num_atoms == 1000);
+		for(int i=0; i<10000; ++i)
+			for(int t=1; t<4; ++t)
+				testAssert(thread_entries[t][i].ptr() == thread_entries[0][i].ptr());
+	}
+
+	conPrint("URLAtomTable::test() done.");
+}
+
+
+#endif // BUILD_TESTS
@@ -0,0 +1,139 @@
+/*=====================================================================
+URLAtom.h
+---------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#pragma once
+
+
+#include "URLString.h"
+#include <utils/ThreadSafeRefCounted.h>
+#include <utils/Reference.h>
+#include <utils/Mutex.h>
+#include <Platform.h>
+#include <string_view>
+#include <unordered_map>
+
+
+class URLAtomEntry : public ThreadSafeRefCounted
+{
+public:
+	URLString str;
+	size_t hash; // URLStringHasher()(str)
+};
+
+
+/*=====================================================================
+URLAtom
+-------
+A handle to an interned URL.
+
+Many objects and materials in a world reference the same few hundred
+model and texture URLs.  Instead of each holding its own URLString copy,
+they hold a URLAtom, which is a pointer to a single shared copy of the
+string in the URLAtomTable, along with its precomputed hash.
+
+Two atoms are equal iff they point to the same entry, so comparisons
+between atoms don't compare string contents.
+
+URLAtom converts implicitly to const URLString& and std::string_view,
+and has the common read-only string methods, so it can be used mostly
+like a URLString.  Assigning a string interns it.
+The empty URL is represented by a NULL entry, so doesn't use the table.
+
+URL-keyed maps (ResourceManager, LoadItemQueue, MeshManager etc.) are still
+keyed by URLString, so atoms are converted to strings for lookups there.
+=====================================================================*/
+class URLAtom
+{
+public:
+	URLAtom() {}
+	explicit URLAtom(std::string_view s) { *this = s; }
+
+	URLAtom& operator = (std::string_view s); // Interns s.
+
+	const URLString& str() const;
+	operator const URLString& () const { return str(); }
+	operator std::string_view () const { return str(); }
+
+	size_t hash() const; // Same as URLStringHasher()(str())
+
+	bool empty() const { return entry.isNull(); }
+	size_t size() const { return str().size(); }
+	size_t length() const { return str().size(); }
+	const char* c_str() const { return str().c_str(); }
+	const char* data() const { return str().data(); }
+	URLString::const_iterator begin() const { return str().begin(); }
+	URLString::const_iterator end() const { return str().end(); }
+	size_t find_last_of(char c, size_t pos = URLString::npos) const { return str().find_last_of(c, pos); }
+	char operator [] (size_t i) const { return str()[i]; }
+
+	void clear() { entry = Reference<URLAtomEntry>(); }
+	void assign(const char* s, size_t len) { *this = std::string_view(s, len); }
+
+	bool operator == (const URLAtom& b) const { return entry.ptr() == b.entry.ptr(); }
+	bool operator != (const URLAtom& b) const { return entry.ptr() != b.entry.ptr(); }
+
+private:
+	Reference<URLAtomEntry> entry; // NULL for the empty URL.
+};
+
+
+inline bool operator == (const URLAtom& a, std::string_view b) { return std::string_view(a) == b; }
+inline bool operator == (std::string_view a, const URLAtom& b) { return a == std::string_view(b); }
+inline bool operator != (const URLAtom& a, std::string_view b) { return std::string_view(a) != b; }
+inline bool operator != (std::string_view a, const URLAtom& b) { return a != std::string_view(b); }
+
+inline std::string toStdString(const URLAtom& s) { return std::string(s.begin(), s.end()); }
+
+
+/*=====================================================================
+URLAtomTable
+------------
+The table of interned URLs.  There is a single global table, used by URLAtom.
+
+Thread-safe.  The table is split into NUM_SHARDS shards by URL hash, each
+with its own mutex, so concurrent interning (e.g. from object loading threads)
+doesn't contend much.
+
+Entries are kept while any atom references them.  removeUnreferencedAtoms()
+should be called occasionally to remove entries that are no longer referenced.
+=====================================================================*/
+class URLAtomTable
+{
+public:
+	URLAtomTable();
+	~URLAtomTable();
+
+	static URLAtomTable& getGlobalTable();
+
+	// Returns the entry for s, adding it if not already present.  s should be non-empty.
+	Reference<URLAtomEntry> intern(std::string_view s);
+
+	// Removes entries that are only referenced by the table.  Returns number of entries removed.
+	size_t removeUnreferencedAtoms();
+
+	struct Stats
+	{
+		size_t num_atoms;			// Number of distinct URLs
+		size_t num_references;		// Number of URLAtoms referencing the URLs
+		size_t total_string_size_B;	// Total size of distinct URLs
+		int64 bytes_saved;			// Estimated memory saved compared to each reference holding its own URLString.
+	};
+	Stats getStats() const;
+
+	static void test();
+
+private:
+	GLARE_DISABLE_COPY(URLAtomTable);
+
+	static const size_t NUM_SHARDS = 16;
+
+	struct Shard
+	{
+		mutable Mutex mutex;
+		std::unordered_map<std::string_view, Reference<URLAtomEntry>> entries	GUARDED_BY(mutex); // Keys point into the entry strings.
+	};
+
+	Shard shards[NUM_SHARDS];
+};
@@ -0,0 +1,443 @@
+/*=====================================================================
+VoxelBricks.cpp
+---------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#include "VoxelBricks.h"
+
+
+#include "WorldObject.h"
+#include <utils/Exception.h>
+#include <utils/StringUtils.h>
+#include <utils/ConPrint.h>
+#include <maths/mathstypes.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+
+VoxelBrick::VoxelBrick()
+:	num_voxels(0)
+{
+	PaletteEntry no_voxel_entry;
+	no_voxel_entry.mat_index = -1;
+	no_voxel_entry.count = 0;
+	palette.push_back(no_voxel_entry);
+
+	std::memset(palette_indices, 0, sizeof(palette_indices));
+}
+
+
+uint8 VoxelBrick::findOrAddPaletteEntry(int mat_index)
+{
+	assert(mat_index >= 0);
+
+	// Palettes are usually small, so just do a linear scan.
+	size_t unused_entry = 0;
+	for(size_t i=1; i<palette.size(); ++i)
+	{
+		if(palette[i].mat_index == mat_index)
+			return (uint8)i;
+		if(palette[i].count == 0 && unused_entry == 0)
+			unused_entry = i;
+	}
+
+	if(unused_entry != 0)
+	{
+		palette[unused_entry].mat_index = mat_index;
+		return (uint8)unused_entry;
+	}
+
+	if(palette.size() >= MAX_PALETTE_SIZE)
+		throw glare::Exception("Too many materials in voxel brick");
+
+	PaletteEntry entry;
+	entry.mat_index = mat_index;
+	entry.count = 0;
+	palette.push_back(entry);
+	return (uint8)(palette.size() - 1);
+}
+
+
+bool VoxelBrick::setVoxel(int x, int y, int z, int mat_index)
+{
+	const int i = voxelIndex(x, y, z);
+	const uint8 old_palette_index = palette_indices[i];
+	if(old_palette_index != 0 && palette[old_palette_index].mat_index == mat_index)
+		return false; // Voxel is already set with this material.
+
+	// Release the old entry first, so it can be reused if this was its last voxel.
+	if(old_palette_index != 0)
+		palette[old_palette_index].count--;
+
+	uint8 new_palette_index;
+	try
+	{
+		new_palette_index = findOrAddPaletteEntry(mat_index);
+	}
+	catch(glare::Exception&)
+	{
+		if(old_palette_index != 0)
+			palette[old_palette_index].count++;
+		throw;
+	}
+
+	palette[new_palette_index].count++;
+	palette_indices[i] = new_palette_index;
+
+	if(old_palette_index != 0)
+		return false;
+
+	num_voxels++;
+	return true;
+}
+
+
+size_t VoxelBrick::setVoxels(const uint16* voxel_indices, size_t num_indices, int mat_index)
+{
+	const uint8 new_palette_index = findOrAddPaletteEntry(mat_index);
+
+	size_t num_added = 0;
+	for(size_t z=0; z<num_indices; ++z)
+	{
+		const uint16 i = voxel_indices[z];
+		assert(i < NUM_VOXELS);
+		const uint8 old_palette_index = palette_indices[i];
+		if(old_palette_index == new_palette_index)
+			continue;
+
+		if(old_palette_index != 0)
+			palette[old_palette_index].count--;
+		else
+			num_added++;
+
+		palette[new_palette_index].count++;
+		palette_indices[i] = new_palette_index;
+	}
+
+	num_voxels += num_added;
+	return num_added;
+}
+
+
+bool VoxelBrick::removeVoxel(int x, int y, int z)
+{
+	const int i = voxelIndex(x, y, z);
+	const uint8 old_palette_index = palette_indices[i];
+	if(old_palette_index == 0)
+		return false;
+
+	palette[old_palette_index].count--;
+	palette_indices[i] = 0;
+	num_voxels--;
+	return true;
+}
+
+
+VoxelBricks::VoxelBricks()
+:	num_voxels(0)
+{}
+
+
+VoxelBricks::~VoxelBricks()
+{}
+
+
+void VoxelBricks::build(const VoxelGroup& group, int subsample_factor)
+{
+	clear();
+
+	const int subsample_shift = Maths::intLogBase2((uint32)subsample_factor);
+
+	// Voxels that are near each other in the list are often in the same brick, so cache the last brick looked up.
+	Vec3<int> last_brick_coords(std::numeric_limits<int>::max());
+	VoxelBrick* last_brick = NULL;
+
+	const size_t num = group.voxels.size();
+	for(size_t i=0; i<num; ++i)
+	{
+		const Voxel& voxel = group.voxels[i];
+		if(voxel.mat_index < 0)
+			throw glare::Exception("Invalid mat index (< 0)");
+
+		const Vec3<int> pos(voxel.pos.x >> subsample_shift, voxel.pos.y >> subsample_shift, voxel.pos.z >> subsample_shift); // Shifting right with sign extension divides by subsample_factor, rounding down.
+		const Vec3<int> brick_coords = brickCoordsForPos(pos);
+		if(brick_coords != last_brick_coords)
+		{
+			VoxelBrickRef& brick = bricks[brick_coords];
+			if(brick.isNull())
+				brick = new VoxelBrick();
+			last_brick = brick.ptr();
+			last_brick_coords = brick_coords;
+		}
+
+		if(last_brick->setVoxel(pos.x & VoxelBrick::W_MASK, pos.y & VoxelBrick::W_MASK, pos.z & VoxelBrick::W_MASK, voxel.mat_index))
+			num_voxels++;
+	}
+}
+
+
+void VoxelBricks::clear()
+{
+	bricks.clear();
+	num_voxels = 0;
+}
+
+
+int VoxelBricks::getVoxel(const Vec3<int>& pos) const
+{
+	const auto res = bricks.find(brickCoordsForPos(pos));
+	if(res == bricks.end())
+		return -1;
+	return res->second->getVoxel(pos.x & VoxelBrick::W_MASK, pos.y & VoxelBrick::W_MASK, pos.z & VoxelBrick::W_MASK);
+}
+
+
+bool VoxelBricks::setVoxel(const Vec3<int>& pos, int mat_index)
+{
+	if(mat_index < 0)
+		throw glare::Exception("Invalid mat index (< 0)");
+
+	VoxelBrickRef& brick = bricks[brickCoordsForPos(pos)];
+	if(brick.isNull())
+		brick = new VoxelBrick();
+
+	const bool added = brick->setVoxel(pos.x & VoxelBrick::W_MASK, pos.y & VoxelBrick::W_MASK, pos.z & VoxelBrick::W_MASK, mat_index);
+	if(added)
+		num_voxels++;
+	return added;
+}
+
+
+bool VoxelBricks::removeVoxel(const Vec3<int>& pos)
+{
+	const auto res = bricks.find(brickCoordsForPos(pos));
+	if(res == bricks.end())
+		return false;
+
+	const bool removed = res->second->removeVoxel(pos.x & VoxelBrick::W_MASK, pos.y & VoxelBrick::W_MASK, pos.z & VoxelBrick::W_MASK);
+	if(removed)
+	{
+		num_voxels--;
+		if(res->second->numVoxels() == 0)
+			bricks.erase(res);
+	}
+	return removed;
+}
+
+
+void VoxelBricks::setVoxelsInBrick(const Vec3<int>& brick_coords, const uint16* voxel_indices, size_t num_indices, int mat_index)
+{
+	if(mat_index < 0)
+		throw glare::Exception("Invalid mat index (< 0)");
+	if(num_indices == 0)
+		return;
+
+	VoxelBrickRef& brick = bricks[brick_coords];
+	if(brick.isNull())
+		brick = new VoxelBrick();
+
+	try
+	{
+		num_voxels += brick->setVoxels(voxel_indices, num_indices, mat_index);
+	}
+	catch(glare::Exception&)
+	{
+		if(brick->numVoxels() == 0) // Don't leave an empty brick behind.
+			bricks.erase(brick_coords);
+		throw;
+	}
+}
+
+
+const VoxelBrick* VoxelBricks::getBrick(const Vec3<int>& brick_coords) const
+{
+	const auto res = bricks.find(brick_coords);
+	return (res == bricks.end()) ? NULL : res->second.ptr();
+}
+
+
+void VoxelBricks::getSortedBrickCoords(std::vector<Vec3<int> >& coords_out) const
+{
+	coords_out.resize(0);
+	coords_out.reserve(bricks.size());
+	for(auto it = bricks.begin(); it != bricks.end(); ++it)
+		coords_out.push_back(it->first);
+
+	std::sort(coords_out.begin(), coords_out.end(), [](const Vec3<int>& a, const Vec3<int>& b) {
+		if(a.z != b.z) return a.z < b.z;
+		if(a.y != b.y) return a.y < b.y;
+		return a.x < b.x;
+	});
+}
+
+
+void VoxelBricks::getVoxels(VoxelGroup& group_out) const
+{
+	std::vector<Vec3<int> > brick_coords;
+	getSortedBrickCoords(brick_coords);
+
+	for(size_t b=0; b<brick_coords.size(); ++b)
+	{
+		const VoxelBrick* brick = getBrick(brick_coords[b]);
+		const Vec3<int> origin = brick_coords[b] * VoxelBrick::W;
+
+		for(int z=0; z<VoxelBrick::W; ++z)
+		for(int y=0; y<VoxelBrick::W; ++y)
+		for(int x=0; x<VoxelBrick::W; ++x)
+		{
+			const int mat_index = brick->getVoxel(x, y, z);
+			if(mat_index >= 0)
+				group_out.voxels.push_back(Voxel(origin + Vec3<int>(x, y, z), mat_index));
+		}
+	}
+}
+
+
+size_t VoxelBricks::getTotalMemUsage() const
+{
+	size_t sum = sizeof(VoxelBricks) + bricks.size() * (sizeof(Vec3<int>) + sizeof(VoxelBrickRef) + 16); // 16 = Rough hash table node overhead.
+	for(auto it = bricks.begin(); it != bricks.end(); ++it)
+		sum += sizeof(VoxelBrick) + it->second->palette.capacity() * sizeof(VoxelBrick::PaletteEntry);
+	return sum;
+}
+
+
+#if BUILD_TESTS
+
+
+#include <utils/TestUtils.h>
+
+
+void VoxelBricks::test()
+{
+	conPrint("VoxelBricks::test()");
+
+	//------------------------ Test setting, getting and removing voxels ------------------------
+	{
+		VoxelBricks bricks;
+		testAssert(bricks.getVoxel(Vec3<int>(0, 0, 0)) == -1);
+
+		testAssert(bricks.setVoxel(Vec3<int>(0, 0, 0), 3));
+		testAssert(!bricks.setVoxel(Vec3<int>(0, 0, 0), 3));
+		testAssert(bricks.getVoxel(Vec3<int>(0, 0, 0)) == 3);
+		testAssert(bricks.numVoxels() == 1 && bricks.numBricks() == 1);
+
+		// Voxels with negative coords should go in a different brick.
+		testAssert(bricks.setVoxel(Vec3<int>(-1, 0, 0), 4));
+		testAssert(bricks.getVoxel(Vec3<int>(-1, 0, 0)) == 4);
+		testAssert(bricks.numBricks() == 2);
+		testAssert(bricks.getBrick(Vec3<int>(-1, 0, 0)) != NULL);
+		testAssert(bricks.getBrick(Vec3<int>(-1, 0, 0))->getVoxel(31, 0, 0) == 4);
+
+		testAssert(bricks.setVoxel(Vec3<int>(31, 31, 31), 3));
+		testAssert(bricks.numBricks() == 2);
+		testAssert(bricks.setVoxel(Vec3<int>(32, 31, 31), 3));
+		testAssert(bricks.numBricks() == 3);
+
+		// Overwrite with a different material
+		testAssert(!bricks.setVoxel(Vec3<int>(0, 0, 0), 5));
+		testAssert(bricks.getVoxel(Vec3<int>(0, 0, 0)) == 5);
+		testAssert(bricks.numVoxels() == 4);
+
+		// Removing the last voxel in a brick should remove the brick.
+		testAssert(bricks.removeVoxel(Vec3<int>(-1, 0, 0)));
+		testAssert(!bricks.removeVoxel(Vec3<int>(-1, 0, 0)));
+		testAssert(bricks.getVoxel(Vec3<int>(-1, 0, 0)) == -1);
+		testAssert(bricks.numBricks() == 2);
+		testAssert(bricks.numVoxels() == 3);
+	}
+
+	//------------------------ Test palette entries are reused ------------------------
+	{
+		VoxelBrick brick;
+		for(int i=0; i<255; ++i)
+			brick.setVoxel(i % 32, i / 32, 0, i);
+		testAssert(brick.palette.size() == 256);
+
+		try
+		{
+			brick.setVoxel(0, 0, 1, 1000);
+			failTest("Expected exception");
+		}
+		catch(glare::Exception&)
+		{}
+
+		// Overwriting voxel 0 with mat 1000 frees palette entry for mat 0, which can then be reused.
+		brick.setVoxel(0, 0, 0, 1000);
+		testAssert(brick.palette.size() == 256);
+		testAssert(brick.getVoxel(0, 0, 0) == 1000);
+		testAssert(brick.numVoxels() == 255);
+	}
+
+	//------------------------ Test setVoxelsInBrick ------------------------
+	{
+		VoxelBricks bricks;
+		testAssert(bricks.setVoxel(Vec3<int>(-32, 0, 0), 1));
+
+		const uint16 indices[] = { 0, 1, (uint16)VoxelBrick::voxelIndex(31, 31, 31) };
+		bricks.setVoxelsInBrick(Vec3<int>(-1, 0, 0), indices, 3, 2); // Overwrites existing voxel at index 0.
+		testAssert(bricks.numVoxels() == 3);
+		testAssert(bricks.numBricks() == 1);
+		testAssert(bricks.getVoxel(Vec3<int>(-32, 0, 0)) == 2);
+		testAssert(bricks.getVoxel(Vec3<int>(-31, 0, 0)) == 2);
+		testAssert(bricks.getVoxel(Vec3<int>(-1, 31, 31)) == 2);
+		testAssert(bricks.getBrick(Vec3<int>(-1, 0, 0))->palette[1].count == 0); // Entry for mat 1 is now unused.
+
+		bricks.setVoxelsInBrick(Vec3<int>(5, 5, 5), indices, 0, 2); // Setting no voxels shouldn't create a brick.
+		testAssert(bricks.numBricks() == 1);
+
+		try
+		{
+			bricks.setVoxelsInBrick(Vec3<int>(0, 0, 0), indices, 3, -1);
+			failTest("Expected exception");
+		}
+		catch(glare::Exception&)
+		{}
+		testAssert(bricks.numBricks() == 1);
+	}
+
+	//------------------------ Test build and getVoxels ------------------------
+	{
+		VoxelGroup group;
+		group.voxels.push_back(Voxel(Vec3<int>(0, 0, 0), 0));
+		group.voxels.push_back(Voxel(Vec3<int>(100, -50, 3), 1));
+		group.voxels.push_back(Voxel(Vec3<int>(-33, 64, 1000), 2));
+		group.voxels.push_back(Voxel(Vec3<int>(0, 0, 0), 3)); // Should overwrite first voxel
+
+		VoxelBricks bricks;
+		bricks.build(group, /*subsample_factor=*/1);
+		testAssert(bricks.numVoxels() == 3);
+		testAssert(bricks.numBricks() == 3);
+		testAssert(bricks.getVoxel(Vec3<int>(0, 0, 0)) == 3);
+		testAssert(bricks.getVoxel(Vec3<int>(100, -50, 3)) == 1);
+		testAssert(bricks.getVoxel(Vec3<int>(-33, 64, 1000)) == 2);
+
+		VoxelGroup group2;
+		bricks.getVoxels(group2);
+		testAssert(group2.voxels.size() == 3);
+		for(size_t i=0; i<group2.voxels.size(); ++i)
+			testAssert(bricks.getVoxel(group2.voxels[i].pos) == group2.voxels[i].mat_index);
+
+		// Test with subsampling.  Positions should be divided by 4, rounding down.
+		bricks.build(group, /*subsample_factor=*/4);
+		testAssert(bricks.numVoxels() == 3);
+		testAssert(bricks.getVoxel(Vec3<int>(25, -13, 0)) == 1);
+		testAssert(bricks.getVoxel(Vec3<int>(-9, 16, 250)) == 2);
+
+		// Negative mat indices should be rejected.
+		group.voxels.push_back(Voxel(Vec3<int>(1, 1, 1), -1));
+		try
+		{
+			bricks.build(group, /*subsample_factor=*/1);
+			failTest("Expected exception");
+		}
+		catch(glare::Exception&)
+		{}
+	}
+
+	conPrint("VoxelBricks::test() done.");
+}
+
+
+#endif // BUILD_TESTS
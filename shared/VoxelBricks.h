@@ -0,0 +1,149 @@
+/*=====================================================================
+VoxelBricks.h
+-------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#pragma once
+
+
+#include <maths/vec3.h>
+#include <utils/RefCounted.h>
+#include <utils/Reference.h>
+#include <utils/Platform.h>
+#include <unordered_map>
+#include <vector>
+class VoxelGroup;
+
+
+/*=====================================================================
+VoxelBrick
+----------
+A dense 32^3 block of voxels.
+
+Each voxel is stored as a uint8 index into the brick's material palette.
+Palette index 0 is reserved for 'no voxel'.  A brick can reference up to
+255 distinct materials.
+
+Voxel (x, y, z) is at index x + y*32 + z*32*32.
+=====================================================================*/
+class VoxelBrick : public RefCounted
+{
+public:
+	static const int W = 32;
+	static const int W_SHIFT = 5;
+	static const int W_MASK = W - 1;
+	static const int NUM_VOXELS = W * W * W;
+	static const int MAX_PALETTE_SIZE = 256; // Including the 'no voxel' entry.
+
+	VoxelBrick();
+
+	static inline int voxelIndex(int x, int y, int z) { return x | (y << W_SHIFT) | (z << (2 * W_SHIFT)); }
+
+	// Returns the material index of the voxel at local coords (x, y, z), or -1 if there is no voxel there.
+	inline int getVoxel(int x, int y, int z) const { return palette[palette_indices[voxelIndex(x, y, z)]].mat_index; }
+
+	// Returns true if there was no voxel at the position before.
+	// Throws glare::Exception if the brick palette is full.
+	bool setVoxel(int x, int y, int z, int mat_index);
+
+	// Returns true if there was a voxel at the position.
+	bool removeVoxel(int x, int y, int z);
+
+	// Sets the voxels with the given voxel indices (see voxelIndex()) to mat_index.  Returns the number of voxels that were added (weren't already present).
+	// Throws glare::Exception if the brick palette is full.
+	size_t setVoxels(const uint16* voxel_indices, size_t num_indices, int mat_index);
+
+	size_t numVoxels() const { return num_voxels; }
+
+
+	struct PaletteEntry
+	{
+		int mat_index; // -1 for the 'no voxel' entry 0.
+		uint32 count; // Number of voxels using this entry.  An entry with count 0 (apart from entry 0) is unused, and may be reused by setVoxel().
+	};
+
+	std::vector<PaletteEntry> palette;
+	uint8 palette_indices[NUM_VOXELS];
+
+private:
+	uint8 findOrAddPaletteEntry(int mat_index);
+
+	size_t num_voxels;
+};
+
+typedef Reference<VoxelBrick> VoxelBrickRef;
+
+
+struct BrickCoordsHasher
+{
+	size_t operator() (const Vec3<int>& v) const
+	{
+		return (size_t)((uint32)v.x * 73856093u ^ (uint32)v.y * 19349663u ^ (uint32)v.z * 83492791u);
+	}
+};
+
+
+/*=====================================================================
+VoxelBricks
+-----------
+Sparse set of dense voxel bricks, keyed by brick coordinates.
+
+Voxel at integer position p is in brick floor(p / 32), at local coordinates p mod 32.
+
+This is an alternative representation to the flat voxel list in VoxelGroup, which allows
+constant-time voxel lookups, and fast meshing with 64-bit column masks - see
+VoxelMeshBuilding::makeIndigoMeshForVoxelBricks().
+
+Bricks are removed when their last voxel is removed.
+=====================================================================*/
+class VoxelBricks
+{
+public:
+	VoxelBricks();
+	~VoxelBricks();
+
+	// Clears and inserts all voxels from the group, with positions divided by subsample_factor (rounding down).  subsample_factor should be a power of 2.
+	// Later voxels overwrite earlier voxels at the same (subsampled) position.
+	// Throws glare::Exception if a voxel has a negative material index, or if a brick would reference too many materials.
+	void build(const VoxelGroup& group, int subsample_factor);
+
+	void clear();
+
+	// Returns the material index of the voxel at pos, or -1 if there is no voxel there.
+	int getVoxel(const Vec3<int>& pos) const;
+
+	// Returns true if there was no voxel at the position before.
+	// Throws glare::Exception if the brick would reference too many materials.
+	bool setVoxel(const Vec3<int>& pos, int mat_index);
+
+	// Returns true if there was a voxel at the position.
+	bool removeVoxel(const Vec3<int>& pos);
+
+	// Sets the voxels with the given voxel indices in the brick at brick_coords to mat_index.  Used for fast decoding of compressed voxel data, see VoxelCodec.
+	// Throws glare::Exception if mat_index is negative, or if the brick would reference too many materials.
+	void setVoxelsInBrick(const Vec3<int>& brick_coords, const uint16* voxel_indices, size_t num_indices, int mat_index);
+
+	// Returns NULL if there is no brick at the given brick coordinates.
+	const VoxelBrick* getBrick(const Vec3<int>& brick_coords) const;
+
+	static inline Vec3<int> brickCoordsForPos(const Vec3<int>& pos) { return Vec3<int>(pos.x >> VoxelBrick::W_SHIFT, pos.y >> VoxelBrick::W_SHIFT, pos.z >> VoxelBrick::W_SHIFT); } // Shifting right with sign extension rounds down.
+
+	// Get coordinates of all bricks, sorted by z, then y, then x.  Useful for iterating over bricks in a deterministic order.
+	void getSortedBrickCoords(std::vector<Vec3<int> >& coords_out) const;
+
+	size_t numBricks() const { return bricks.size(); }
+	size_t numVoxels() const { return num_voxels; }
+
+	// Appends all voxels to group_out, ordered by brick.
+	void getVoxels(VoxelGroup& group_out) const;
+
+	size_t getTotalMemUsage() const;
+
+	static void test();
+
+private:
+	GLARE_DISABLE_COPY(VoxelBricks);
+
+	std::unordered_map<Vec3<int>, VoxelBrickRef, BrickCoordsHasher> bricks;
+	size_t num_voxels;
+};
@@ -0,0 +1,895 @@
+/*=====================================================================
+VoxelCodec.cpp
+--------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#include "VoxelCodec.h"
+
+
+#include "WorldObject.h"
+#include "VoxelBricks.h"
+#include <maths/mathstypes.h>
+#include <utils/Exception.h>
+#include <utils/StringUtils.h>
+#include <utils/ConPrint.h>
+#include <utils/Vector.h>
+#include <utils/BitUtils.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <zstd.h>
+
+
+static const size_t HEADER_SIZE_B = 8; // MAGIC + version
+static const uint64 MAX_NUM_VOXELS = 64000000; // Same limit as the version 1 decoder in WorldObject::decompressVoxelGroup().
+static const int COORD_BITS = 21; // Max number of bits for each coordinate relative to the origin, so a Morton code fits in 63 bits.
+static const int LOCAL_MORTON_BITS = 3 * VoxelBrick::W_SHIFT; // Number of bits of a brick-local Morton code.
+static const uint64 MAX_BRICK_CODE = (uint64(1) << (3 * COORD_BITS - LOCAL_MORTON_BITS)) - 1;
+static const size_t BITMASK_NUM_WORDS = VoxelBrick::NUM_VOXELS / 64;
+static const size_t BITMASK_SIZE_B = VoxelBrick::NUM_VOXELS / 8;
+
+
+// Spread the lower 21 bits of x out so there are 2 zero bits between each bit.
+static inline uint64 spreadBits3(uint32 x)
+{
+	uint64 v = x & 0x1FFFFF;
+	v = (v | (v << 32)) & 0x1F00000000FFFFull;
+	v = (v | (v << 16)) & 0x1F0000FF0000FFull;
+	v = (v | (v << 8))  & 0x100F00F00F00F00Full;
+	v = (v | (v << 4))  & 0x10C30C30C30C30C3ull;
+	v = (v | (v << 2))  & 0x1249249249249249ull;
+	return v;
+}
+
+
+// Inverse of spreadBits3().  Ignores bits not at positions that are a multiple of 3.
+static inline uint32 compactBits3(uint64 v)
+{
+	v &= 0x1249249249249249ull;
+	v = (v | (v >> 2))  & 0x10C30C30C30C30C3ull;
+	v = (v | (v >> 4))  & 0x100F00F00F00F00Full;
+	v = (v | (v >> 8))  & 0x1F0000FF0000FFull;
+	v = (v | (v >> 16)) & 0x1F00000000FFFFull;
+	v = (v | (v >> 32)) & 0x1FFFFF;
+	return (uint32)v;
+}
+
+
+static inline uint64 mortonCode(uint32 x, uint32 y, uint32 z)
+{
+	return spreadBits3(x) | (spreadBits3(y) << 1) | (spreadBits3(z) << 2);
+}
+
+
+// Table mapping brick-local Morton codes to voxel indices in the brick (see VoxelBrick::voxelIndex()).
+struct LocalMortonTable
+{
+	LocalMortonTable()
+	{
+		for(uint32 m=0; m<(uint32)VoxelBrick::NUM_VOXELS; ++m)
+			voxel_index[m] = (uint16)VoxelBrick::voxelIndex((int)compactBits3(m), (int)compactBits3(m >> 1), (int)compactBits3(m >> 2));
+	}
+
+	uint16 voxel_index[VoxelBrick::NUM_VOXELS];
+};
+
+static const LocalMortonTable& getLocalMortonTable()
+{
+	static const LocalMortonTable table; // Thread-safe initialisation.
+	return table;
+}
+
+
+static inline void writeVarint(js::Vector<uint8, 16>& buf, uint64 x)
+{
+	while(x >= 0x80)
+	{
+		buf.push_back((uint8)(x | 0x80));
+		x >>= 7;
+	}
+	buf.push_back((uint8)x);
+}
+
+
+static inline size_t varintSize(uint64 x)
+{
+	size_t size = 1;
+	while(x >= 0x80)
+	{
+		x >>= 7;
+		size++;
+	}
+	return size;
+}
+
+
+static inline uint64 zigZagEncode(int x) { return (uint64)(((int64)x << 1) ^ ((int64)x >> 63)); }
+static inline int64 zigZagDecode(uint64 x) { return (int64)(x >> 1) ^ -(int64)(x & 1); }
+
+
+class VarintReader
+{
+public:
+	VarintReader(const uint8* data, size_t data_len) : cur(data), end(data + data_len) {}
+
+	uint64 readVarint()
+	{
+		uint64 x = 0;
+		for(int shift=0; shift<64; shift += 7)
+		{
+			if(cur == end)
+				throw glare::Exception("Unexpected end of voxel data");
+			const uint8 b = *cur++;
+			x |= (uint64)(b & 0x7F) << shift;
+			if((b & 0x80) == 0)
+				return x;
+		}
+		throw glare::Exception("Invalid varint in voxel data");
+	}
+
+	const uint8* readBytes(size_t n)
+	{
+		if((size_t)(end - cur) < n)
+			throw glare::Exception("Unexpected end of voxel data");
+		const uint8* p = cur;
+		cur += n;
+		return p;
+	}
+
+	bool endOfData() const { return cur == end; }
+
+private:
+	const uint8* cur;
+	const uint8* end;
+};
+
+
+uint32 VoxelCodec::getFormatVersion(const uint8* data, size_t data_len)
+{
+	if(data_len >= HEADER_SIZE_B)
+	{
+		uint32 magic;
+		std::memcpy(&magic, data, sizeof(uint32));
+		if(magic == MAGIC)
+		{
+			uint32 version;
+			std::memcpy(&version, data + 4, sizeof(uint32));
+			return version;
+		}
+	}
+	return 1;
+}
+
+
+Reference<glare::SharedImmutableArray<uint8> > VoxelCodec::encode(const VoxelGroup& group, bool use_dense_brick_bitmasks)
+{
+	const size_t num = group.voxels.size();
+
+	// Compute bounds and number of materials
+	Vec3<int> min_pos(0, 0, 0);
+	Vec3<int> max_pos(0, 0, 0);
+	int max_mat_index = -1;
+	for(size_t i=0; i<num; ++i)
+	{
+		const Voxel& voxel = group.voxels[i];
+		if(voxel.mat_index < 0)
+			throw glare::Exception("Invalid mat index (< 0)");
+		max_mat_index = myMax(max_mat_index, voxel.mat_index);
+		if(i == 0)
+			min_pos = max_pos = voxel.pos;
+		else
+		{
+			min_pos = Vec3<int>(myMin(min_pos.x, voxel.pos.x), myMin(min_pos.y, voxel.pos.y), myMin(min_pos.z, voxel.pos.z));
+			max_pos = Vec3<int>(myMax(max_pos.x, voxel.pos.x), myMax(max_pos.y, voxel.pos.y), myMax(max_pos.z, voxel.pos.z));
+		}
+	}
+
+	// Round origin down to a multiple of the brick width, so that bricks are aligned with VoxelBricks bricks.
+	const Vec3<int> origin(min_pos.x & ~VoxelBrick::W_MASK, min_pos.y & ~VoxelBrick::W_MASK, min_pos.z & ~VoxelBrick::W_MASK);
+	for(int c=0; c<3; ++c)
+		if((int64)max_pos[c] - (int64)origin[c] >= (int64(1) << COORD_BITS))
+			throw glare::Exception("Voxel positions span too large a range to encode.");
+
+	// Counting-sort Morton codes by material
+	const size_t num_mats = (size_t)(max_mat_index + 1);
+	std::vector<size_t> mat_run_begin(num_mats + 1, 0);
+	for(size_t i=0; i<num; ++i)
+		mat_run_begin[group.voxels[i].mat_index + 1]++;
+	for(size_t m=0; m<num_mats; ++m)
+		mat_run_begin[m + 1] += mat_run_begin[m];
+
+	js::Vector<uint64, 16> codes(num);
+	{
+		std::vector<size_t> write_i(mat_run_begin.begin(), mat_run_begin.end() - 1);
+		for(size_t i=0; i<num; ++i)
+		{
+			const Voxel& voxel = group.voxels[i];
+			codes[write_i[voxel.mat_index]++] = mortonCode((uint32)(voxel.pos.x - origin.x), (uint32)(voxel.pos.y - origin.y), (uint32)(voxel.pos.z - origin.z));
+		}
+	}
+
+	// Sort each material run into Morton order, and remove duplicates.
+	std::vector<size_t> mat_run_end(num_mats);
+	size_t total_num_voxels = 0;
+	for(size_t m=0; m<num_mats; ++m)
+	{
+		uint64* const run_begin = codes.data() + mat_run_begin[m];
+		std::sort(run_begin, codes.data() + mat_run_begin[m + 1]);
+		uint64* const run_end = std::unique(run_begin, codes.data() + mat_run_begin[m + 1]);
+		mat_run_end[m] = run_end - codes.data();
+		total_num_voxels += run_end - run_begin;
+	}
+
+	// Write the uncompressed body
+	const LocalMortonTable& local_morton_table = getLocalMortonTable();
+	const uint64 local_mask = (uint64(1) << LOCAL_MORTON_BITS) - 1;
+	js::Vector<uint8, 16> body;
+	body.reserve(16 + total_num_voxels * 2);
+
+	writeVarint(body, total_num_voxels);
+	for(int c=0; c<3; ++c)
+		writeVarint(body, zigZagEncode(origin[c]));
+	writeVarint(body, num_mats);
+
+	for(size_t m=0; m<num_mats; ++m)
+	{
+		const size_t run_begin = mat_run_begin[m];
+		const size_t run_end = mat_run_end[m];
+
+		size_t num_bricks = 0;
+		for(size_t i=run_begin; i<run_end; ++i)
+			if(i == run_begin || (codes[i] >> LOCAL_MORTON_BITS) != (codes[i - 1] >> LOCAL_MORTON_BITS))
+				num_bricks++;
+		writeVarint(body, num_bricks);
+
+		uint64 next_brick_code = 0;
+		size_t brick_begin = run_begin;
+		while(brick_begin < run_end)
+		{
+			const uint64 brick_code = codes[brick_begin] >> LOCAL_MORTON_BITS;
+			size_t brick_end = brick_begin + 1;
+			while(brick_end < run_end && (codes[brick_end] >> LOCAL_MORTON_BITS) == brick_code)
+				brick_end++;
+
+			writeVarint(body, brick_code - next_brick_code);
+			next_brick_code = brick_code + 1;
+
+			const size_t brick_num_voxels = brick_end - brick_begin;
+
+			// Work out the size of the sparse encoding, so we can store the brick as a bitmask if that is smaller.
+			bool use_bitmask = false;
+			if(use_dense_brick_bitmasks && brick_num_voxels * 1 > BITMASK_SIZE_B) // Each sparse voxel takes at least 1 byte.
+			{
+				size_t sparse_size = 0;
+				uint64 next_local_code = 0;
+				for(size_t i=brick_begin; i<brick_end; ++i)
+				{
+					const uint64 local_code = codes[i] & local_mask;
+					sparse_size += varintSize(local_code - next_local_code);
+					next_local_code = local_code + 1;
+				}
+				use_bitmask = sparse_size > BITMASK_SIZE_B;
+			}
+
+			writeVarint(body, ((uint64)brick_num_voxels << 1) | (use_bitmask ? 1 : 0));
+
+			if(use_bitmask)
+			{
+				uint64 bitmask[BITMASK_NUM_WORDS];
+				std::memset(bitmask, 0, sizeof(bitmask));
+				for(size_t i=brick_begin; i<brick_end; ++i)
+				{
+					const uint32 voxel_index = local_morton_table.voxel_index[codes[i] & local_mask];
+					bitmask[voxel_index >> 6] |= uint64(1) << (voxel_index & 63);
+				}
+
+				const size_t write_i = body.size();
+				body.resize(write_i + BITMASK_SIZE_B);
+				std::memcpy(body.data() + write_i, bitmask, BITMASK_SIZE_B); // Assumes little-endian, like the rest of our serialisation code.
+			}
+			else
+			{
+				uint64 next_local_code = 0;
+				for(size_t i=brick_begin; i<brick_end; ++i)
+				{
+					const uint64 local_code = codes[i] & local_mask;
+					writeVarint(body, local_code - next_local_code);
+					next_local_code = local_code + 1;
+				}
+			}
+
+			brick_begin = brick_end;
+		}
+	}
+
+	// Compress the body with zstd, after the header.
+	const size_t compressed_bound = ZSTD_compressBound(body.size());
+	js::Vector<uint8, 16> compressed_data(HEADER_SIZE_B + compressed_bound);
+
+	const uint32 magic = MAGIC;
+	const uint32 version = CURRENT_VERSION;
+	std::memcpy(compressed_data.data(), &magic, sizeof(uint32));
+	std::memcpy(compressed_data.data() + 4, &version, sizeof(uint32));
+
+	const size_t compressed_size = ZSTD_compress(compressed_data.data() + HEADER_SIZE_B, compressed_bound, body.data(), body.size(),
+		ZSTD_CLEVEL_DEFAULT // compression level
+	);
+	if(ZSTD_isError(compressed_size))
+		throw glare::Exception("Compression of voxel data failed: " + toString(compressed_size));
+
+	return new glare::SharedImmutableArray<uint8>(compressed_data.begin(), compressed_data.begin() + HEADER_SIZE_B + compressed_size);
+}
+
+
+// Decodes the zstd-compressed body of version 2 data.  Calls sink.begin(total_num_voxels), then sink.addBrickVoxels(brick_coords, brick_origin, voxel_indices, num, mat_index) for each brick of each material.
+template <class Sink>
+static void decodeVersion2(const uint8* data, size_t data_len, glare::Allocator* mem_allocator, Sink& sink)
+{
+	if(data_len < HEADER_SIZE_B)
+		throw glare::Exception("Voxel data is too short");
+
+	const uint8* compressed_data = data + HEADER_SIZE_B;
+	const size_t compressed_data_len = data_len - HEADER_SIZE_B;
+
+	const uint64 decompressed_size = ZSTD_getFrameContentSize(compressed_data, compressed_data_len);
+	if(decompressed_size == ZSTD_CONTENTSIZE_UNKNOWN || decompressed_size == ZSTD_CONTENTSIZE_ERROR)
+		throw glare::Exception("Failed to get decompressed_size");
+	if(decompressed_size > 16 + MAX_NUM_VOXELS * 4) // Each voxel takes at most 3 bytes, with some overhead for each material and brick.
+		throw glare::Exception("Decompressed voxel data is too large");
+
+	js::Vector<uint8, 16> body;
+	if(mem_allocator)
+		body.setAllocator(mem_allocator);
+	body.resizeNoCopy(decompressed_size);
+
+	const size_t res = ZSTD_decompress(body.data(), body.size(), compressed_data, compressed_data_len);
+	if(ZSTD_isError(res))
+		throw glare::Exception("Decompression of buffer failed: " + toString(res));
+	if(res < decompressed_size)
+		throw glare::Exception("Decompression of buffer failed: not enough bytes in result");
+
+	VarintReader reader(body.data(), body.size());
+
+	const uint64 total_num_voxels = reader.readVarint();
+	if(total_num_voxels > MAX_NUM_VOXELS)
+		throw glare::Exception("Voxel count is too large: " + toString(total_num_voxels));
+
+	Vec3<int> origin;
+	for(int c=0; c<3; ++c)
+	{
+		const int64 coord = zigZagDecode(reader.readVarint());
+		if(coord < -(int64(1) << 30) || coord > (int64(1) << 30) || (coord & VoxelBrick::W_MASK) != 0)
+			throw glare::Exception("Invalid voxel origin");
+		origin[c] = (int)coord;
+	}
+	const Vec3<int> origin_brick_coords = VoxelBricks::brickCoordsForPos(origin);
+
+	const uint64 num_mats = reader.readVarint();
+	if(num_mats > (uint64)std::numeric_limits<int>::max())
+		throw glare::Exception("Invalid number of materials");
+
+	sink.begin((size_t)total_num_voxels);
+
+	const LocalMortonTable& local_morton_table = getLocalMortonTable();
+	js::Vector<uint16, 16> voxel_indices(VoxelBrick::NUM_VOXELS);
+	uint64 num_voxels_decoded = 0;
+
+	for(uint64 m=0; m<num_mats; ++m)
+	{
+		const uint64 num_bricks = reader.readVarint();
+		uint64 next_brick_code = 0;
+		for(uint64 b=0; b<num_bricks; ++b)
+		{
+			const uint64 brick_code_delta = reader.readVarint();
+			if(brick_code_delta > MAX_BRICK_CODE - next_brick_code)
+				throw glare::Exception("Invalid brick code");
+			const uint64 brick_code = next_brick_code + brick_code_delta;
+			next_brick_code = brick_code + 1;
+
+			const uint64 count_and_type = reader.readVarint();
+			const uint64 brick_num_voxels = count_and_type >> 1;
+			if(brick_num_voxels == 0 || brick_num_voxels > (uint64)VoxelBrick::NUM_VOXELS || brick_num_voxels > total_num_voxels - num_voxels_decoded)
+				throw glare::Exception("Invalid brick voxel count");
+
+			if(count_and_type & 1) // If brick is stored as a bitmask:
+			{
+				uint64 bitmask[BITMASK_NUM_WORDS];
+				std::memcpy(bitmask, reader.readBytes(BITMASK_SIZE_B), BITMASK_SIZE_B);
+
+				size_t num_set = 0;
+				for(size_t w=0; w<BITMASK_NUM_WORDS; ++w)
+				{
+					uint64 word = bitmask[w];
+					while(word != 0)
+					{
+						if(num_set == brick_num_voxels)
+							throw glare::Exception("Brick bitmask doesn't match voxel count");
+						voxel_indices[num_set++] = (uint16)((w << 6) + BitUtils::lowestSetBitIndex(word));
+						word &= word - 1; // Clear lowest set bit
+					}
+				}
+				if(num_set != brick_num_voxels)
+					throw glare::Exception("Brick bitmask doesn't match voxel count");
+			}
+			else
+			{
+				uint64 next_local_code = 0;
+				for(uint64 i=0; i<brick_num_voxels; ++i)
+				{
+					const uint64 local_code = next_local_code + reader.readVarint();
+					if(local_code >= (uint64)VoxelBrick::NUM_VOXELS)
+						throw glare::Exception("Invalid voxel position");
+					voxel_indices[i] = local_morton_table.voxel_index[local_code];
+					next_local_code = local_code + 1;
+				}
+			}
+
+			const Vec3<int> brick_offset((int)compactBits3(brick_code), (int)compactBits3(brick_code >> 1), (int)compactBits3(brick_code >> 2));
+			sink.addBrickVoxels(origin_brick_coords + brick_offset, origin + brick_offset * VoxelBrick::W, voxel_indices.data(), (size_t)brick_num_voxels, (int)m);
+
+			num_voxels_decoded += brick_num_voxels;
+		}
+	}
+
+	if(num_voxels_decoded != total_num_voxels)
+		throw glare::Exception("Voxel count mismatch");
+	if(!reader.endOfData())
+		throw glare::Exception("Didn't reach end of data while reading voxels.");
+}
+
+
+struct VoxelGroupSink
+{
+	void begin(size_t total_num_voxels)
+	{
+		group->voxels.resizeNoCopy(total_num_voxels);
+		write_i = 0;
+	}
+
+	void addBrickVoxels(const Vec3<int>& /*brick_coords*/, const Vec3<int>& brick_origin, const uint16* voxel_indices, size_t num, int mat_index)
+	{
+		Voxel* const dest = group->voxels.data() + write_i;
+		for(size_t i=0; i<num; ++i)
+		{
+			const uint32 index = voxel_indices[i];
+			dest[i] = Voxel(brick_origin + Vec3<int>(index & VoxelBrick::W_MASK, (index >> VoxelBrick::W_SHIFT) & VoxelBrick::W_MASK, index >> (2 * VoxelBrick::W_SHIFT)), mat_index);
+		}
+		write_i += num;
+	}
+
+	VoxelGroup* group;
+	size_t write_i;
+};
+
+
+struct VoxelBricksSink
+{
+	void begin(size_t /*total_num_voxels*/) {}
+
+	void addBrickVoxels(const Vec3<int>& brick_coords, const Vec3<int>& /*brick_origin*/, const uint16* voxel_indices, size_t num, int mat_index)
+	{
+		bricks->setVoxelsInBrick(brick_coords, voxel_indices, num, mat_index);
+	}
+
+	VoxelBricks* bricks;
+};
+
+
+void VoxelCodec::decode(const uint8* data, size_t data_len, glare::Allocator* mem_allocator, VoxelGroup& group_out)
+{
+	const uint32 version = getFormatVersion(data, data_len);
+	if(version == 1)
+	{
+		WorldObject::decompressVoxelGroup(data, data_len, mem_allocator, group_out);
+	}
+	else if(version == 2)
+	{
+		group_out.voxels.clear();
+
+		VoxelGroupSink sink;
+		sink.group = &group_out;
+		decodeVersion2(data, data_len, mem_allocator, sink);
+	}
+	else
+		throw glare::Exception("Unsupported voxel data version: " + toString(version));
+}
+
+
+void VoxelCodec::decodeToBricks(const uint8* data, size_t data_len, VoxelBricks& bricks_out)
+{
+	bricks_out.clear();
+
+	const uint32 version = getFormatVersion(data, data_len);
+	if(version == 1)
+	{
+		VoxelGroup group;
+		WorldObject::decompressVoxelGroup(data, data_len, /*mem_allocator=*/NULL, group);
+		bricks_out.build(group, /*subsample_factor=*/1);
+	}
+	else if(version == 2)
+	{
+		VoxelBricksSink sink;
+		sink.bricks = &bricks_out;
+		decodeVersion2(data, data_len, /*mem_allocator=*/NULL, sink);
+	}
+	else
+		throw glare::Exception("Unsupported voxel data version: " + toString(version));
+}
+
+
+#if BUILD_TESTS
+
+
+#include <utils/TestUtils.h>
+#include <utils/Timer.h>
+#include <maths/PCG32.h>
+#include <cmath>
+
+
+// Returns voxels sorted by (material, z, y, x), with exact duplicates removed.
+static std::vector<Voxel> getCanonicalVoxels(const VoxelGroup& group)
+{
+	std::vector<Voxel> voxels(group.voxels.begin(), group.voxels.end());
+	auto less = [](const Voxel& a, const Voxel& b) {
+		if(a.mat_index != b.mat_index) return a.mat_index < b.mat_index;
+		if(a.pos.z != b.pos.z) return a.pos.z < b.pos.z;
+		if(a.pos.y != b.pos.y) return a.pos.y < b.pos.y;
+		return a.pos.x < b.pos.x;
+	};
+	std::sort(voxels.begin(), voxels.end(), less);
+	voxels.erase(std::unique(voxels.begin(), voxels.end()), voxels.end());
+	return voxels;
+}
+
+
+static void testRoundTrip(const VoxelGroup& group)
+{
+	for(int use_bitmasks=0; use_bitmasks<2; ++use_bitmasks)
+	{
+		Reference<glare::SharedImmutableArray<uint8> > encoded = VoxelCodec::encode(group, use_bitmasks != 0);
+		testAssert(VoxelCodec::getFormatVersion(encoded->data(), encoded->size()) == VoxelCodec::CURRENT_VERSION);
+
+		VoxelGroup decoded;
+		VoxelCodec::decode(encoded->data(), encoded->size(), /*mem_allocator=*/NULL, decoded);
+		testAssert(getCanonicalVoxels(decoded) == getCanonicalVoxels(group));
+
+		// WorldObject::decompressVoxelGroup() should handle version 2 data as well.
+		VoxelGroup decoded2;
+		WorldObject::decompressVoxelGroup(encoded->data(), encoded->size(), /*mem_allocator=*/NULL, decoded2);
+		testAssert(decoded2.voxels == decoded.voxels);
+
+		// Decoding to bricks should give the same result as building bricks from the voxels.
+		// (Voxels at the same position with different materials may resolve differently, so compare against bricks built from the decoded voxels)
+		VoxelBricks bricks;
+		VoxelCodec::decodeToBricks(encoded->data(), encoded->size(), bricks);
+		VoxelBricks ref_bricks;
+		ref_bricks.build(decoded, /*subsample_factor=*/1);
+		testAssert(bricks.numVoxels() == ref_bricks.numVoxels());
+		testAssert(bricks.numBricks() == ref_bricks.numBricks());
+		for(size_t i=0; i<decoded.voxels.size(); ++i)
+			testAssert(bricks.getVoxel(decoded.voxels[i].pos) == ref_bricks.getVoxel(decoded.voxels[i].pos));
+	}
+}
+
+
+// Make a version 2 encoding of the given uncompressed body, for testing decoding of invalid data.
+static std::vector<uint8> makeVersion2Data(const std::vector<uint8>& body)
+{
+	std::vector<uint8> data(8 + ZSTD_compressBound(body.size()));
+	const uint32 magic = VoxelCodec::MAGIC;
+	const uint32 version = 2;
+	std::memcpy(data.data(), &magic, 4);
+	std::memcpy(data.data() + 4, &version, 4);
+	const size_t compressed_size = ZSTD_compress(data.data() + 8, data.size() - 8, body.data(), body.size(), ZSTD_CLEVEL_DEFAULT);
+	testAssert(!ZSTD_isError(compressed_size));
+	data.resize(8 + compressed_size);
+	return data;
+}
+
+
+static void testDecodingFails(const std::vector<uint8>& data)
+{
+	try
+	{
+		VoxelGroup group;
+		VoxelCodec::decode(data.data(), data.size(), /*mem_allocator=*/NULL, group);
+		failTest("Expected exception");
+	}
+	catch(glare::Exception&)
+	{}
+
+	try
+	{
+		VoxelBricks bricks;
+		VoxelCodec::decodeToBricks(data.data(), data.size(), bricks);
+		failTest("Expected exception");
+	}
+	catch(glare::Exception&)
+	{}
+}
+
+
+static void makeTerrainGroup(int w, VoxelGroup& group)
+{
+	for(int y=0; y<w; ++y)
+	for(int x=0; x<w; ++x)
+	{
+		const int height = 20 + (int)(10 * std::sin(x * 0.1) * std::cos(y * 0.13));
+		for(int z=0; z<height; ++z)
+			group.voxels.push_back(Voxel(Vec3<int>(x, y, z), (z < height - 3) ? 0 : 1));
+	}
+}
+
+
+static void benchmarkGroup(const std::string& name, const VoxelGroup& group)
+{
+	const int NUM_ITERS = 5;
+
+	double v1_encode_time = 1.0e10, v1_decode_time = 1.0e10, v1_bricks_time = 1.0e10;
+	double v2_encode_time = 1.0e10, v2_decode_time = 1.0e10, v2_bricks_time = 1.0e10;
+	size_t v1_size = 0, v2_size = 0, v2_no_bitmask_size = 0;
+	for(int iter=0; iter<NUM_ITERS; ++iter)
+	{
+		{
+			Timer timer;
+			Reference<glare::SharedImmutableArray<uint8> > v1 = WorldObject::compressVoxelGroup(group);
+			v1_encode_time = myMin(v1_encode_time, timer.elapsed());
+			v1_size = v1->size();
+
+			timer.reset();
+			VoxelGroup decoded;
+			WorldObject::decompressVoxelGroup(v1->data(), v1->size(), NULL, decoded);
+			v1_decode_time = myMin(v1_decode_time, timer.elapsed());
+
+			timer.reset();
+			VoxelBricks bricks;
+			VoxelCodec::decodeToBricks(v1->data(), v1->size(), bricks);
+			v1_bricks_time = myMin(v1_bricks_time, timer.elapsed());
+		}
+		{
+			Timer timer;
+			Reference<glare::SharedImmutableArray<uint8> > v2 = VoxelCodec::encode(group);
+			v2_encode_time = myMin(v2_encode_time, timer.elapsed());
+			v2_size = v2->size();
+
+			timer.reset();
+			VoxelGroup decoded;
+			VoxelCodec::decode(v2->data(), v2->size(), NULL, decoded);
+			v2_decode_time = myMin(v2_decode_time, timer.elapsed());
+
+			timer.reset();
+			VoxelBricks bricks;
+			VoxelCodec::decodeToBricks(v2->data(), v2->size(), bricks);
+			v2_bricks_time = myMin(v2_bricks_time, timer.elapsed());
+
+			v2_no_bitmask_size = VoxelCodec::encode(group, /*use_dense_brick_bitmasks=*/false)->size();
+		}
+	}
+
+	conPrint(name + " (" + toString(group.voxels.size()) + " voxels):");
+	conPrint("    v1: " + toString(v1_size) + " B, encode " + doubleToStringNSigFigs(v1_encode_time * 1.0e3, 4) + " ms, decode " + doubleToStringNSigFigs(v1_decode_time * 1.0e3, 4) +
+		" ms, decode to bricks " + doubleToStringNSigFigs(v1_bricks_time * 1.0e3, 4) + " ms");
+	conPrint("    v2: " + toString(v2_size) + " B (" + toString(v2_no_bitmask_size) + " B without bitmasks), encode " + doubleToStringNSigFigs(v2_encode_time * 1.0e3, 4) + " ms, decode " +
+		doubleToStringNSigFigs(v2_decode_time * 1.0e3, 4) + " ms, decode to bricks " + doubleToStringNSigFigs(v2_bricks_time * 1.0e3, 4) + " ms");
+}
+
+
+void VoxelCodec::test()
+{
+	conPrint("VoxelCodec::test()");
+
+	//------------------------ Test Morton code functions ------------------------
+	{
+		testAssert(mortonCode(0, 0, 0) == 0);
+		testAssert(mortonCode(1, 0, 0) == 1);
+		testAssert(mortonCode(0, 1, 0) == 2);
+		testAssert(mortonCode(0, 0, 1) == 4);
+		testAssert(mortonCode(0x1FFFFF, 0x1FFFFF, 0x1FFFFF) == 0x7FFFFFFFFFFFFFFFull);
+
+		PCG32 rng(1);
+		for(int i=0; i<1000; ++i)
+		{
+			const uint32 x = (uint32)(rng.unitRandom() * 0x1FFFFF);
+			const uint32 y = (uint32)(rng.unitRandom() * 0x1FFFFF);
+			const uint32 z = (uint32)(rng.unitRandom() * 0x1FFFFF);
+			const uint64 code = mortonCode(x, y, z);
+			testAssert(compactBits3(code) == x && compactBits3(code >> 1) == y && compactBits3(code >> 2) == z);
+		}
+	}
+
+	//------------------------ Test round trips ------------------------
+	{
+		VoxelGroup group;
+		testRoundTrip(group); // Empty group
+
+		group.voxels.push_back(Voxel(Vec3<int>(0, 0, 0), 0));
+		testRoundTrip(group);
+
+		group.voxels.push_back(Voxel(Vec3<int>(-1, -100, 5), 3)); // Negative coords, with unused materials 1 and 2.
+		group.voxels.push_back(Voxel(Vec3<int>(0, 0, 0), 0)); // Exact duplicate
+		group.voxels.push_back(Voxel(Vec3<int>(0, 0, 0), 2)); // Same position, different material
+		testRoundTrip(group);
+
+		// Positions at the extremes of the allowed range
+		group.voxels.push_back(Voxel(Vec3<int>(-1 + (1 << 21) - 32, 2000000, 0), 1));
+		testRoundTrip(group);
+
+		// Too large a range should throw an exception.
+		group.voxels.push_back(Voxel(Vec3<int>(-1 + (1 << 21), 0, 0), 1));
+		try
+		{
+			VoxelCodec::encode(group);
+			failTest("Expected exception");
+		}
+		catch(glare::Exception&)
+		{}
+
+		// Negative materials should throw an exception.
+		group.voxels.back() = Voxel(Vec3<int>(0, 0, 0), -1);
+		try
+		{
+			VoxelCodec::encode(group);
+			failTest("Expected exception");
+		}
+		catch(glare::Exception&)
+		{}
+	}
+
+	// Random sparse and dense voxels
+	{
+		PCG32 rng(1);
+		for(int trial=0; trial<20; ++trial)
+		{
+			const int w = 10 + trial * 5;
+			const float density = (trial % 3 == 0) ? 0.1f : ((trial % 3 == 1) ? 0.6f : 0.99f);
+			const int num_mats = 1 + trial % 4;
+			const Vec3<int> offset((int)(rng.unitRandom() * 2000) - 1000, (int)(rng.unitRandom() * 2000) - 1000, (int)(rng.unitRandom() * 2000) - 1000);
+
+			VoxelGroup group;
+			for(int z=0; z<w; ++z)
+			for(int y=0; y<w; ++y)
+			for(int x=0; x<w; ++x)
+				if(rng.unitRandom() < density)
+					group.voxels.push_back(Voxel(offset + Vec3<int>(x, y, z), (int)(rng.unitRandom() * num_mats) % num_mats));
+
+			testRoundTrip(group);
+		}
+	}
+
+	// A solid block should be stored with bitmasks, and be much smaller than the version 1 format.
+	{
+		VoxelGroup group;
+		for(int z=0; z<64; ++z)
+		for(int y=0; y<64; ++y)
+		for(int x=0; x<64; ++x)
+			group.voxels.push_back(Voxel(Vec3<int>(x, y, z) - Vec3<int>(16), (x + y + z) % 2));
+		testRoundTrip(group);
+
+		testAssert(VoxelCodec::encode(group)->size() < WorldObject::compressVoxelGroup(group)->size());
+	}
+
+	//------------------------ Test version 1 data can be decoded ------------------------
+	{
+		VoxelGroup group;
+		makeTerrainGroup(40, group);
+		Reference<glare::SharedImmutableArray<uint8> > v1 = WorldObject::compressVoxelGroup(group);
+		testAssert(VoxelCodec::getFormatVersion(v1->data(), v1->size()) == 1);
+
+		VoxelGroup decoded;
+		VoxelCodec::decode(v1->data(), v1->size(), NULL, decoded);
+		testAssert(getCanonicalVoxels(decoded) == getCanonicalVoxels(group));
+
+		VoxelBricks bricks;
+		VoxelCodec::decodeToBricks(v1->data(), v1->size(), bricks);
+		testAssert(bricks.numVoxels() == group.voxels.size());
+	}
+
+	//------------------------ Test invalid data ------------------------
+	{
+		// Unsupported version
+		{
+			std::vector<uint8> data = makeVersion2Data(std::vector<uint8>(1, 0));
+			const uint32 version = 3;
+			std::memcpy(data.data() + 4, &version, 4);
+			testDecodingFails(data);
+		}
+
+		// Empty body
+		testDecodingFails(makeVersion2Data(std::vector<uint8>()));
+
+		// Body: total voxels, origin x y z, num mats, num bricks, brick code delta, count and type, local code delta
+		const uint8 valid_body[] = { 1, 0, 0, 0, 1, 1, 0, 2, 5 };
+		{
+			VoxelGroup group;
+			const std::vector<uint8> data = makeVersion2Data(std::vector<uint8>(valid_body, valid_body + sizeof(valid_body)));
+			VoxelCodec::decode(data.data(), data.size(), NULL, group);
+			testAssert(group.voxels.size() == 1 && group.voxels[0].pos == Vec3<int>(1, 0, 1) && group.voxels[0].mat_index == 0); // Morton code 5 = (1, 0, 1)
+		}
+
+		for(size_t i=0; i<sizeof(valid_body); ++i) // Truncated body
+			testDecodingFails(makeVersion2Data(std::vector<uint8>(valid_body, valid_body + i)));
+
+		{ std::vector<uint8> body(valid_body, valid_body + sizeof(valid_body)); body.push_back(0); testDecodingFails(makeVersion2Data(body)); } // Trailing data
+		{ std::vector<uint8> body(valid_body, valid_body + sizeof(valid_body)); body[0] = 2; testDecodingFails(makeVersion2Data(body)); } // Total count mismatch
+		{ std::vector<uint8> body(valid_body, valid_body + sizeof(valid_body)); body[1] = 2; testDecodingFails(makeVersion2Data(body)); } // Origin not a multiple of 32
+		{ std::vector<uint8> body(valid_body, valid_body + sizeof(valid_body)); body[7] = 0; testDecodingFails(makeVersion2Data(body)); } // Zero voxel count in brick
+		{ std::vector<uint8> body(valid_body, valid_body + sizeof(valid_body)); body[7] = 3; testDecodingFails(makeVersion2Data(body)); } // Bitmask (missing)
+		{
+			std::vector<uint8> body(valid_body, valid_body + sizeof(valid_body) - 1); // Local code out of range
+			body.push_back(0x80); body.push_back(0x80); body.push_back(0x02);
+			testDecodingFails(makeVersion2Data(body));
+		}
+		{
+			std::vector<uint8> body(valid_body, valid_body + sizeof(valid_body) - 1); // Bitmask with the wrong number of bits set
+			body[7] = 3;
+			std::vector<uint8> bitmask(4096, 0);
+			bitmask[0] = 3;
+			body.insert(body.end(), bitmask.begin(), bitmask.end());
+			testDecodingFails(makeVersion2Data(body));
+		}
+
+		// Truncated and corrupted encodings of real data shouldn't crash.
+		VoxelGroup group;
+		makeTerrainGroup(20, group);
+		Reference<glare::SharedImmutableArray<uint8> > encoded = VoxelCodec::encode(group);
+		for(size_t len=0; len<encoded->size(); ++len)
+			testDecodingFails(std::vector<uint8>(encoded->begin(), encoded->begin() + len));
+
+		PCG32 rng(1);
+		for(int i=0; i<1000; ++i)
+		{
+			std::vector<uint8> data(encoded->begin(), encoded->end());
+			data[(size_t)(rng.unitRandom() * data.size()) % data.size()] ^= (uint8)(1 + rng.unitRandom() * 254);
+			try
+			{
+				VoxelGroup decoded;
+				VoxelCodec::decode(data.data(), data.size(), NULL, decoded);
+			}
+			catch(glare::Exception&)
+			{}
+		}
+	}
+
+	//------------------------ Benchmark against the version 1 format ------------------------
+	{
+		{
+			VoxelGroup group;
+			makeTerrainGroup(256, group);
+			benchmarkGroup("Terrain", group);
+		}
+		{
+			VoxelGroup group;
+			for(int z=0; z<128; ++z)
+			for(int y=0; y<128; ++y)
+			for(int x=0; x<128; ++x)
+				group.voxels.push_back(Voxel(Vec3<int>(x, y, z), (z < 100) ? 0 : 1));
+			benchmarkGroup("Solid block", group);
+		}
+		{
+			PCG32 rng(1);
+			VoxelGroup group;
+			for(int i=0; i<100000; ++i)
+				group.voxels.push_back(Voxel(Vec3<int>((int)(rng.unitRandom() * 1000), (int)(rng.unitRandom() * 1000), (int)(rng.unitRandom() * 1000)), (int)(rng.unitRandom() * 8)));
+			benchmarkGroup("Random sparse", group);
+		}
+		{
+			// Sphere shell, like a typical hand-built voxel object.
+			VoxelGroup group;
+			for(int z=-40; z<40; ++z)
+			for(int y=-40; y<40; ++y)
+			for(int x=-40; x<40; ++x)
+			{
+				const float r = std::sqrt((float)(x*x + y*y + z*z));
+				if(r >= 36 && r < 40)
+					group.voxels.push_back(Voxel(Vec3<int>(x, y, z), (z > 0) ? 0 : 1));
+			}
+			benchmarkGroup("Sphere shell", group);
+		}
+	}
+
+	conPrint("VoxelCodec::test() done.");
+}
+
+
+#endif // BUILD_TESTS
@@ -0,0 +1,74 @@
+/*=====================================================================
+VoxelCodec.h
+------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#pragma once
+
+
+#include <utils/Reference.h>
+#include <utils/SharedImmutableArray.h>
+#include <utils/Platform.h>
+class VoxelGroup;
+class VoxelBricks;
+namespace glare { class Allocator; }
+
+
+/*=====================================================================
+VoxelCodec
+----------
+Compressed voxel data formats.
+
+Version 1 is the original format written by WorldObject::compressVoxelGroup():
+a zstd frame (with no header) containing voxels counting-sorted by material,
+with each position stored as a 12-byte delta from the previous position.
+
+Version 2 starts with an 8-byte header (MAGIC, then the version number), followed by
+a zstd frame containing:
+
+	varint: total number of voxels
+	zigzag varint x 3: origin, a multiple of the brick width (32)
+	varint: number of materials
+	for each material:
+		varint: number of bricks
+		for each brick, in Morton order:
+			varint: brick Morton code delta (from previous brick code + 1)
+			varint: (num voxels << 1) | is_bitmask
+			if is_bitmask:
+				4096 bytes: bitmask of voxels, bit i is for voxel index i in the brick (see VoxelBrick::voxelIndex())
+			else:
+				num voxels varints: brick-local Morton code delta (from previous code + 1)
+
+Voxel positions are relative to the origin and must be < 2^21 in each dimension.
+Morton-ordered positions are spatially coherent, so the deltas are small and mostly
+fit in a single byte, and zstd compresses the resulting runs well.
+Bricks are aligned with VoxelBricks bricks, so a dense brick bitmask can be decoded
+straight into a VoxelBrick.
+
+Duplicate voxels with the same position and material are stored once.
+
+All decoding functions throw glare::Exception on invalid data.
+=====================================================================*/
+class VoxelCodec
+{
+public:
+	static const uint32 MAGIC = 0x43584F56; // "VOXC" in little-endian byte order.  Can't be the start of a zstd frame (magic 0xFD2FB528).
+	static const uint32 CURRENT_VERSION = 2;
+
+	// Returns the format version of the compressed data: 1 if there is no version 2+ header, otherwise the version from the header.
+	static uint32 getFormatVersion(const uint8* data, size_t data_len);
+
+	// Encodes with the current version.
+	// If use_dense_brick_bitmasks is true, bricks with many voxels of a material are stored as bitmasks when that is smaller.
+	// Throws glare::Exception if a voxel has a negative material index, or if the voxel positions span too large a range.
+	static Reference<glare::SharedImmutableArray<uint8> > encode(const VoxelGroup& group, bool use_dense_brick_bitmasks = true);
+
+	// Decodes version 1 or version 2 data.
+	static void decode(const uint8* data, size_t data_len, glare::Allocator* mem_allocator, VoxelGroup& group_out);
+
+	// Decodes version 1 or version 2 data into bricks, clearing bricks_out first.
+	// Version 2 data is decoded directly into the bricks, without building an intermediate voxel list.
+	static void decodeToBricks(const uint8* data, size_t data_len, VoxelBricks& bricks_out);
+
+	static void test();
+};
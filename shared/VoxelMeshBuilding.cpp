@@ -7,6 +7,7 @@ Copyright Glare Technologies Limited 2022 -
 
 
 #include "../shared/WorldObject.h"
+#include "../shared/VoxelBricks.h"
 #include "../dll/include/IndigoException.h"
 #include "../dll/IndigoStringUtils.h"
 #include "../utils/ShouldCancelCallback.h"
@@ -20,10 +21,13 @@ Copyright Glare Technologies Limited 2022 -
 #include "../utils/Sort.h"
 #include "../utils/Array2D.h"
 #include "../utils/Array3D.h"
+#include "../utils/BitUtils.h"
+#include "../utils/TaskManager.h"
 #if GUI_CLIENT
 #include "superluminal/PerformanceAPI.h"
 #endif
 #include <limits>
+#include <cstring>
 
 
 class VoxelHashFunc
@@ -709,13 +713,338 @@ struct VoxelVertInfoHashFunc
 };
 
 
+typedef HashMap<Vec3<int>, int, VoxelHashFunc> VoxelMatHashMap;
+typedef HashMap<VoxelVertInfo, int, VoxelVertInfoHashFunc> VoxelVertInfoHashMap;
+
+
+static VoxelVertInfo getVoxelVertInfoEmptyKey()
+{
+	VoxelVertInfo vertpos_empty_key;
+	vertpos_empty_key.pos = Indigo::Vec3f(std::numeric_limits<float>::max());
+	vertpos_empty_key.normal = Indigo::Vec3f(std::numeric_limits<float>::max());
+	return vertpos_empty_key;
+}
+
+
+// Want the a_axis x b_axis = dim_axis
+static inline void getQuadAxesForDim(int dim, int& dim_a, int& dim_b)
+{
+	if(dim == 0)
+	{
+		dim_a = 1;
+		dim_b = 2;
+	}
+	else if(dim == 1)
+	{
+		dim_a = 2;
+		dim_b = 0;
+	}
+	else // dim == 2:
+	{
+		dim_a = 0;
+		dim_b = 1;
+	}
+}
+
+
+// Starting from a needed face at (start_x, start_y), expand a quad greedily in the x and y directions over needed faces.
+// The quad will range from (start_x, start_y) to (end_x_out, end_y_out).  Marks faces in the quad as no longer needed.
+static inline void expandGreedyQuad(Array2D<bool>& face_needed, int a_min, int b_min, int a_end, int b_end, int start_x, int start_y, int& end_x_out, int& end_y_out)
+{
+	int end_x = start_x + 1;
+	int end_y = start_y + 1;
+
+	bool x_increase_ok = true;
+	bool y_increase_ok = true;
+	while(x_increase_ok || y_increase_ok)
+	{
+		// Try and increase in x direction
+		if(x_increase_ok)
+		{
+			if(end_x < a_end) // If there is still room to increase in x direction:
+			{
+				// Check y values for new x = end_x
+				for(int y = start_y; y < end_y; ++y)
+					if(!face_needed.elem(end_x - a_min, y - b_min))
+					{
+						x_increase_ok = false;
+						break;
+					}
+
+				if(x_increase_ok)
+					end_x++;
+			}
+			else
+				x_increase_ok = false;
+		}
+
+		// Try and increase in y direction
+		if(y_increase_ok)
+		{
+			if(end_y < b_end)
+			{
+				// Check x values for new y = end_y
+				for(int x = start_x; x < end_x; ++x)
+					if(!face_needed.elem(x - a_min, end_y - b_min))
+					{
+						y_increase_ok = false;
+						break;
+					}
+
+				if(y_increase_ok)
+					end_y++;
+			}
+			else
+				y_increase_ok = false;
+		}
+	}
+
+	// We have worked out the greedy quad.  Mark elements in it as processed
+	for(int y=start_y; y < end_y; ++y)
+	for(int x=start_x; x < end_x; ++x)
+		face_needed.elem(x - a_min, y - b_min) = false;
+
+	end_x_out = end_x;
+	end_y_out = end_y;
+}
+
+
+// Greedy quads for the faces of one material along one dimension, for a slab of slices along that dimension.
+// Vertices are de-duplicated within the slab only, and are in order of first use.
+struct ShadingNormalsSlabMesh
+{
+	js::Vector<Indigo::Vec3f, 16> vert_positions;
+	js::Vector<Indigo::Vec3f, 16> vert_normals;
+	js::Vector<Indigo::Vec2f, 16> uvs;
+	js::Vector<uint32, 16> quad_vert_indices; // 4 indices into vert_positions per quad.
+};
+
+
+static inline uint32 addShadingNormalsSlabVert(VoxelVertInfoHashMap& vertpos_hash, ShadingNormalsSlabMesh& slab_mesh, const Indigo::Vec3f& v, const Indigo::Vec3f& normal, const Indigo::Vec2f& uv)
+{
+	// returns object of type std::pair<iterator, bool>
+	const auto insert_res = vertpos_hash.insert(std::make_pair(VoxelVertInfo(v, normal), (int)vertpos_hash.size())); // Try and insert vertex
+	if(insert_res.second) // If inserted new value:
+	{
+		slab_mesh.vert_positions.push_back(v);
+		slab_mesh.vert_normals.push_back(normal);
+		slab_mesh.uvs.push_back(uv);
+	}
+	return (uint32)insert_res.first->second; // Get existing or new item (insert_res.first) - a (vec3f, index) pair, then get the index.
+}
+
+
+// Does greedy meshing of the faces of voxels with material mat_i facing along dim, for the slices with dim_coord_begin <= dim coord < dim_coord_end.
+// Only reads from voxel_hash, so can be run for different slabs concurrently.
+static void meshShadingNormalsSlab(const VoxelMatHashMap& voxel_hash, int mat_i, int dim, const VoxelBounds& mat_vox_bounds, int dim_coord_begin, int dim_coord_end, ShadingNormalsSlabMesh& slab_mesh)
+{
+	int dim_a, dim_b;
+	getQuadAxesForDim(dim, dim_a, dim_b);
+
+	Indigo::Vec3f normal_up(0.f);
+	normal_up[dim] = 1.f;
+	Indigo::Vec3f normal_down(0.f);
+	normal_down[dim] = -1.f;
+
+	// Get the extents along dim_a, dim_b
+	const int a_min = mat_vox_bounds.min[dim_a];
+	const int a_end = mat_vox_bounds.max[dim_a] + 1;
+
+	const int b_min = mat_vox_bounds.min[dim_b];
+	const int b_end = mat_vox_bounds.max[dim_b] + 1;
+
+	VoxelVertInfoHashMap vertpos_hash(/*empty key=*/getVoxelVertInfoEmptyKey());
+
+	// Make an array to indicate processed voxel faces.  Processed = included in a greedy quad already.
+	Array2D<bool> vox_present(a_end - a_min, b_end - b_min); // Memorize the voxel lookup to use for building upper faces
+	Array2D<bool> face_needed(a_end - a_min, b_end - b_min);
+
+	// Walk from lower to greater coords, look for downwards facing faces
+	for(int dim_coord = dim_coord_begin; dim_coord < dim_coord_end; ++dim_coord)
+	{
+		//================= Do lower faces along dim ==========================
+		// Build face_needed data for this slice
+		Vec3<int> vox, adjacent_vox_pos;
+		vox[dim] = dim_coord;
+		adjacent_vox_pos[dim] = dim_coord - 1;
+		for(int y=b_min; y<b_end; ++y)
+		for(int x=a_min; x<a_end; ++x)
+		{
+			vox[dim_a] = x;
+			vox[dim_b] = y;
+
+			bool this_face_needed = false;
+			bool this_vox_present = false;
+			auto res = voxel_hash.find(vox);
+			if((res != voxel_hash.end()) && (res->second == mat_i)) // If there is a voxel here with mat_i
+			{
+				this_vox_present = true;
+
+				adjacent_vox_pos[dim_a] = x;
+				adjacent_vox_pos[dim_b] = y;
+				auto adjacent_res = voxel_hash.find(adjacent_vox_pos);
+				if((adjacent_res == voxel_hash.end()) || (adjacent_res->second != mat_i)) // If there is no adjacent voxel, or the adjacent voxel has a different material:
+					this_face_needed = true;
+			}
+			vox_present.elem(x - a_min, y - b_min) = this_vox_present;
+			face_needed.elem(x - a_min, y - b_min) = this_face_needed;
+		}
+
+		// For each voxel face:
+		for(int start_y=b_min; start_y<b_end; ++start_y)
+		for(int start_x=a_min; start_x<a_end; ++start_x)
+		{
+			if(face_needed.elem(start_x - a_min, start_y - b_min)) // If we need a face here:
+			{
+				int end_x, end_y;
+				expandGreedyQuad(face_needed, a_min, b_min, a_end, b_end, start_x, start_y, end_x, end_y);
+
+				// Add the greedy quad
+				uint32 v_i[4]; // quad vert indices
+				Indigo::Vec3f v;
+				v[dim] = (float)dim_coord;
+
+				// bot left
+				v[dim_a] = (float)start_x;
+				v[dim_b] = (float)start_y;
+				v_i[0] = addShadingNormalsSlabVert(vertpos_hash, slab_mesh, v, normal_down,
+					(dim == 0)  ? Indigo::Vec2f(-(float)start_x, (float)start_y) : 
+					((dim == 1) ? Indigo::Vec2f( (float)start_y, (float)start_x) : 
+					              Indigo::Vec2f(-(float)start_x, (float)start_y)));
+
+				// top left
+				v[dim_a] = (float)start_x;
+				v[dim_b] = (float)end_y;
+				v_i[1] = addShadingNormalsSlabVert(vertpos_hash, slab_mesh, v, normal_down,
+					(dim == 0) ? Indigo::Vec2f(-(float)start_x, (float)end_y) : 
+					(dim == 1) ? Indigo::Vec2f( (float)end_y, (float)start_x) : 
+					             Indigo::Vec2f(-(float)start_x, (float)end_y));
+
+				// top right
+				v[dim_a] = (float)end_x;
+				v[dim_b] = (float)end_y;
+				v_i[2] = addShadingNormalsSlabVert(vertpos_hash, slab_mesh, v, normal_down,
+					(dim == 0) ? Indigo::Vec2f(-(float)end_x, (float)end_y) :
+					(dim == 1) ? Indigo::Vec2f( (float)end_y, (float)end_x) : 
+					             Indigo::Vec2f(-(float)end_x, (float)end_y));
+
+				// bot right
+				v[dim_a] = (float)end_x;
+				v[dim_b] = (float)start_y;
+				v_i[3] = addShadingNormalsSlabVert(vertpos_hash, slab_mesh, v, normal_down,
+					(dim == 0) ? Indigo::Vec2f(-(float)end_x, (float)start_y) :
+					(dim == 1) ? Indigo::Vec2f( (float)start_y, (float)end_x) : 
+					             Indigo::Vec2f(-(float)end_x, (float)start_y));
+
+				assert(slab_mesh.vert_positions.size() == vertpos_hash.size());
+
+				for(int i=0; i<4; ++i)
+					slab_mesh.quad_vert_indices.push_back(v_i[i]);
+			}
+		}
+
+		//================= Do upper faces along dim ==========================
+		// Build face_needed data for this slice
+		adjacent_vox_pos[dim] = dim_coord + 1;
+		for(int y=b_min; y<b_end; ++y)
+		for(int x=a_min; x<a_end; ++x)
+		{
+			bool this_face_needed = false;
+			if(vox_present.elem(x - a_min, y - b_min)) // If there is a voxel here with mat_i
+			{
+				adjacent_vox_pos[dim_a] = x;
+				adjacent_vox_pos[dim_b] = y;
+				auto adjacent_res = voxel_hash.find(adjacent_vox_pos);
+				if((adjacent_res == voxel_hash.end()) || (adjacent_res->second != mat_i)) // If there is no adjacent voxel, or the adjacent voxel has a different material:
+					this_face_needed = true;
+			}
+			face_needed.elem(x - a_min, y - b_min) = this_face_needed;
+		}
+
+		// For each voxel face:
+		for(int start_y=b_min; start_y<b_end; ++start_y)
+		for(int start_x=a_min; start_x<a_end; ++start_x)
+		{
+			if(face_needed.elem(start_x - a_min, start_y - b_min))
+			{
+				int end_x, end_y;
+				expandGreedyQuad(face_needed, a_min, b_min, a_end, b_end, start_x, start_y, end_x, end_y);
+
+				const float quad_dim_coord = (float)(dim_coord + 1);
+
+				// Add the greedy quad
+				uint32 v_i[4]; // quad vert indices
+				Indigo::Vec3f v;
+				v[dim] = (float)quad_dim_coord;
+
+				// bot left
+				v[dim_a] = (float)start_x;
+				v[dim_b] = (float)start_y;
+				v_i[0] = addShadingNormalsSlabVert(vertpos_hash, slab_mesh, v, normal_up, (dim == 1) ? 
+					Indigo::Vec2f(-(float)start_y, (float)start_x) : 
+					Indigo::Vec2f((float)start_x, (float)start_y));
+
+				// bot right
+				v[dim_a] = (float)end_x;
+				v[dim_b] = (float)start_y;
+				v_i[1] = addShadingNormalsSlabVert(vertpos_hash, slab_mesh, v, normal_up, (dim == 1) ? 
+					Indigo::Vec2f(-(float)start_y, (float)end_x) : 
+					Indigo::Vec2f((float)end_x, (float)start_y));
+
+				// top right
+				v[dim_a] = (float)end_x;
+				v[dim_b] = (float)end_y;
+				v_i[2] = addShadingNormalsSlabVert(vertpos_hash, slab_mesh, v, normal_up, (dim == 1) ? 
+					Indigo::Vec2f(-(float)end_y, (float)end_x) : 
+					Indigo::Vec2f((float)end_x, (float)end_y));
+
+				// top left
+				v[dim_a] = (float)start_x;
+				v[dim_b] = (float)end_y;
+				v_i[3] = addShadingNormalsSlabVert(vertpos_hash, slab_mesh, v, normal_up, (dim == 1) ? 
+					Indigo::Vec2f(-(float)end_y, (float)start_x) : 
+					Indigo::Vec2f((float)start_x, (float)end_y));
+
+				for(int i=0; i<4; ++i)
+					slab_mesh.quad_vert_indices.push_back(v_i[i]);
+			}
+		}
+	}
+}
+
+
+class ShadingNormalsSlabTask : public glare::Task
+{
+public:
+	virtual void run(size_t thread_index) override
+	{
+		meshShadingNormalsSlab(*voxel_hash, mat_i, dim, *mat_vox_bounds, dim_coord_begin, dim_coord_end, slab_mesh);
+	}
+
+	const VoxelMatHashMap* voxel_hash;
+	const VoxelBounds* mat_vox_bounds;
+	int mat_i, dim, dim_coord_begin, dim_coord_end;
+
+	ShadingNormalsSlabMesh slab_mesh; // Output
+};
+
+
+// When meshing with a task manager, slabs are made thick enough to cover roughly this many voxel cells, so that there is enough work per task.
+static const size_t MIN_CELLS_PER_SHADING_NORMALS_TASK = 1 << 16;
+
+
 // Does greedy meshing
 // Computes vertex normals, thereby avoiding reusing vertices with the same positions but different normals.
+//
+// The faces for each material and each dimension are meshed in slabs of slices, which are independent of each other, so can be meshed in parallel.
+// Each slab de-duplicates its own vertices.  The slab meshes are then merged in (material, dimension, slab) order, re-deduplicating vertices with a global hash map.
+// Since vertices in each slab are in order of first use, this assigns the same vertex indices as meshing all slabs serially with a single hash map,
+// so the result doesn't depend on the slab splitting or on thread scheduling.
 Reference<Indigo::Mesh> VoxelMeshBuilding::makeIndigoMeshWithShadingNormalsForVoxelGroup(const VoxelGroup& voxel_group, const int subsample_factor, const js::Vector<bool, 16>& mats_transparent,
-		glare::Allocator* mem_allocator)
+		glare::TaskManager* task_manager, glare::Allocator* mem_allocator)
 {
 	const glare::AllocatorVector<Voxel, 16>& voxels = voxel_group.voxels;
-	HashMap<Vec3<int>, int, VoxelHashFunc> voxel_hash(/*empty key=*/Vec3<int>(1000000));
+	VoxelMatHashMap voxel_hash(/*empty key=*/Vec3<int>(1000000));
 
 	int max_mat_index = 0;
 	for(size_t i=0; i<voxels.size(); ++i)
@@ -727,21 +1056,6 @@ Reference<Indigo::Mesh> VoxelMeshBuilding::makeIndigoMeshWithShadingNormalsForVo
 
 	const int num_mats = max_mat_index + 1;
 
-
-	Reference<Indigo::Mesh> mesh = new Indigo::Mesh();
-
-	VoxelVertInfo vertpos_empty_key;
-	vertpos_empty_key.pos = Indigo::Vec3f(std::numeric_limits<float>::max());
-	vertpos_empty_key.normal = Indigo::Vec3f(std::numeric_limits<float>::max());
-	HashMap<VoxelVertInfo, int, VoxelVertInfoHashFunc> vertpos_hash(/*empty key=*/vertpos_empty_key, /*expected_num_items=*/voxels.size());
-
-	mesh->vert_positions.reserve(voxels.size());
-	mesh->vert_normals.reserve(voxels.size());
-	mesh->uv_pairs.reserve(voxels.size());
-	mesh->triangles.reserve(voxels.size());
-
-	mesh->setMaxNumTexcoordSets(1);
-
 	VoxelBounds b;
 	b.min = Vec3<int>( 1000000000);
 	b.max = Vec3<int>(-1000000000);
@@ -755,6 +1069,9 @@ Reference<Indigo::Mesh> VoxelMeshBuilding::makeIndigoMeshWithShadingNormalsForVo
 		mat_vox_bounds[mat_index].max = mat_vox_bounds[mat_index].max.max(p);
 	}
 
+	// Make the slab tasks.  Without a task manager, just use one slab for each material and dimension.
+	Reference<glare::TaskGroup> task_group = new glare::TaskGroup();
+	std::vector<Reference<ShadingNormalsSlabTask>> tasks;
 	for(size_t mat_i=0; mat_i<num_mats; ++mat_i) // For each mat
 	{
 		if(mat_vox_bounds[mat_i].min == Vec3<int>(1000000000))
@@ -763,423 +1080,524 @@ Reference<Indigo::Mesh> VoxelMeshBuilding::makeIndigoMeshWithShadingNormalsForVo
 		// For each dimension (x, y, z)
 		for(int dim=0; dim<3; ++dim)
 		{
-			// Want the a_axis x b_axis = dim_axis
 			int dim_a, dim_b;
-			if(dim == 0)
+			getQuadAxesForDim(dim, dim_a, dim_b);
+
+			const int dim_min = mat_vox_bounds[mat_i].min[dim];
+			const int dim_end = mat_vox_bounds[mat_i].max[dim] + 1;
+
+			int slab_thickness = dim_end - dim_min;
+			if(task_manager)
 			{
-				dim_a = 1;
-				dim_b = 2;
+				const size_t slice_area = (size_t)(mat_vox_bounds[mat_i].max[dim_a] + 1 - mat_vox_bounds[mat_i].min[dim_a]) * (size_t)(mat_vox_bounds[mat_i].max[dim_b] + 1 - mat_vox_bounds[mat_i].min[dim_b]);
+				slab_thickness = (int)myClamp<size_t>(MIN_CELLS_PER_SHADING_NORMALS_TASK / slice_area, 1, dim_end - dim_min);
 			}
-			else if(dim == 1)
+
+			for(int dim_coord_begin = dim_min; dim_coord_begin < dim_end; dim_coord_begin += slab_thickness)
 			{
-				dim_a = 2;
-				dim_b = 0;
+				Reference<ShadingNormalsSlabTask> task = new ShadingNormalsSlabTask();
+				task->voxel_hash = &voxel_hash;
+				task->mat_vox_bounds = &mat_vox_bounds[mat_i];
+				task->mat_i = (int)mat_i;
+				task->dim = dim;
+				task->dim_coord_begin = dim_coord_begin;
+				task->dim_coord_end = myMin(dim_coord_begin + slab_thickness, dim_end);
+				tasks.push_back(task);
+				task_group->tasks.push_back(task);
 			}
-			else // dim == 2:
+		}
+	}
+
+	if(task_manager && (tasks.size() > 1))
+		task_manager->runTaskGroup(task_group);
+	else
+	{
+		for(size_t i=0; i<tasks.size(); ++i)
+			tasks[i]->run(/*thread_index=*/0);
+	}
+
+	// Merge the slab meshes
+	size_t total_num_slab_verts = 0;
+	size_t total_num_quads = 0;
+	for(size_t i=0; i<tasks.size(); ++i)
+	{
+		total_num_slab_verts += tasks[i]->slab_mesh.vert_positions.size();
+		total_num_quads += tasks[i]->slab_mesh.quad_vert_indices.size() / 4;
+	}
+
+	Reference<Indigo::Mesh> mesh = new Indigo::Mesh();
+
+	VoxelVertInfoHashMap vertpos_hash(/*empty key=*/getVoxelVertInfoEmptyKey(), /*expected_num_items=*/total_num_slab_verts);
+
+	mesh->vert_positions.reserve(total_num_slab_verts);
+	mesh->vert_normals.reserve(total_num_slab_verts);
+	mesh->uv_pairs.reserve(total_num_slab_verts);
+	mesh->triangles.resize(total_num_quads * 2);
+
+	mesh->setMaxNumTexcoordSets(1);
+
+	js::Vector<uint32, 16> slab_to_mesh_vert_index;
+	size_t tri_write_i = 0;
+	for(size_t i=0; i<tasks.size(); ++i)
+	{
+		const ShadingNormalsSlabMesh& slab_mesh = tasks[i]->slab_mesh;
+		const uint32 mat_i = (uint32)tasks[i]->mat_i;
+
+		slab_to_mesh_vert_index.resizeNoCopy(slab_mesh.vert_positions.size());
+		for(size_t v=0; v<slab_mesh.vert_positions.size(); ++v)
+		{
+			const auto insert_res = vertpos_hash.insert(std::make_pair(VoxelVertInfo(slab_mesh.vert_positions[v], slab_mesh.vert_normals[v]), (int)vertpos_hash.size()));
+			slab_to_mesh_vert_index[v] = (uint32)insert_res.first->second;
+			if(insert_res.second) // If inserted new value:
 			{
-				dim_a = 0;
-				dim_b = 1;
+				mesh->vert_positions.push_back(slab_mesh.vert_positions[v]);
+				mesh->vert_normals.push_back(slab_mesh.vert_normals[v]);
+				mesh->uv_pairs.push_back(slab_mesh.uvs[v]);
 			}
+		}
+
+		for(size_t q=0; q<slab_mesh.quad_vert_indices.size(); q += 4)
+		{
+			uint32 v_i[4]; // quad vert indices
+			for(int z=0; z<4; ++z)
+				v_i[z] = slab_to_mesh_vert_index[slab_mesh.quad_vert_indices[q + z]];
+
+			const size_t tri_start = tri_write_i;
+			tri_write_i += 2;
+
+			mesh->triangles[tri_start + 0].vertex_indices[0] = v_i[0];
+			mesh->triangles[tri_start + 0].vertex_indices[1] = v_i[1];
+			mesh->triangles[tri_start + 0].vertex_indices[2] = v_i[2];
+			mesh->triangles[tri_start + 0].uv_indices[0]     = v_i[0];
+			mesh->triangles[tri_start + 0].uv_indices[1]     = v_i[1];
+			mesh->triangles[tri_start + 0].uv_indices[2]     = v_i[2];
+			mesh->triangles[tri_start + 0].tri_mat_index     = mat_i;
+
+			mesh->triangles[tri_start + 1].vertex_indices[0] = v_i[0];
+			mesh->triangles[tri_start + 1].vertex_indices[1] = v_i[2];
+			mesh->triangles[tri_start + 1].vertex_indices[2] = v_i[3];
+			mesh->triangles[tri_start + 1].uv_indices[0]     = v_i[0];
+			mesh->triangles[tri_start + 1].uv_indices[1]     = v_i[2];
+			mesh->triangles[tri_start + 1].uv_indices[2]     = v_i[3];
+			mesh->triangles[tri_start + 1].tri_mat_index     = mat_i;
+		}
+	}
+	assert(tri_write_i == mesh->triangles.size());
 
-			Indigo::Vec3f normal_up(0.f);
-			normal_up[dim] = 1.f;
-			Indigo::Vec3f normal_down(0.f);
-			normal_down[dim] = -1.f;
+	mesh->endOfModel();
+	assert(isFinite(mesh->aabb_os.bound[0].x));
+	return mesh;
+}
 
-			// Get the extents along dim_a, dim_b
-			const int a_min = mat_vox_bounds[mat_i].min[dim_a];
-			const int a_end = mat_vox_bounds[mat_i].max[dim_a] + 1;
 
-			const int b_min = mat_vox_bounds[mat_i].min[dim_b];
-			const int b_end = mat_vox_bounds[mat_i].max[dim_b] + 1;
+Reference<Indigo::Mesh> VoxelMeshBuilding::makeIndigoMeshForVoxelGroup(const VoxelGroup& voxel_group, const int subsample_factor, const js::Vector<bool, 16>& mats_transparent,
+	glare::Allocator* mem_allocator)
+{
+	assert(voxel_group.voxels.size() > 0);
+	// conPrint("Adding " + toString(voxel_group.voxels.size()) + " voxels.");
 
-			// Walk from lower to greater coords, look for downwards facing faces
-			const int dim_min = mat_vox_bounds[mat_i].min[dim];
-			const int dim_end = mat_vox_bounds[mat_i].max[dim] + 1;
+	return doMakeIndigoMeshForVoxelGroupWith3dArray(voxel_group.voxels, subsample_factor, mats_transparent, mem_allocator);
+}
+
+
+struct VertPosKeyUInt64HashFunc
+{
+	size_t operator() (const uint64& key) const
+	{
+		// Mix the bits (MurmurHash3 finalizer), since the hash map uses the lower bits of the hash, and the lower bits of the key are just the z coord.
+		uint64 x = key;
+		x ^= x >> 33;
+		x *= 0xff51afd7ed558ccdull;
+		x ^= x >> 33;
+		x *= 0xc4ceb9fe1a85ec53ull;
+		x ^= x >> 33;
+		return (size_t)x;
+	}
+};
+
+
+typedef HashMap<uint64, uint32, VertPosKeyUInt64HashFunc> BrickVertPosHashMap;
+
+
+// Returns index of the vertex with integer coords p, adding it to the mesh if not already present.
+static inline uint32 addBrickMeshVert(BrickVertPosHashMap& vertpos_hash, Indigo::Mesh* mesh, const Vec3<int>& p)
+{
+	// Coords are in [-32768, 32768], so offset them to be non-negative and pack into 17 bits each.
+	const uint64 key = ((uint64)(p.x + 32768) << 34) | ((uint64)(p.y + 32768) << 17) | (uint64)(p.z + 32768);
+
+	const auto insert_res = vertpos_hash.insert(std::make_pair(key, (uint32)vertpos_hash.size()));
+	if(insert_res.second) // If inserted new value:
+		mesh->vert_positions.push_back(Indigo::Vec3f((float)p.x, (float)p.y, (float)p.z));
+	return insert_res.first->second;
+}
+
+
+static inline void addBrickMeshQuad(BrickVertPosHashMap& vertpos_hash, Indigo::Mesh* mesh, int dim, int dim_a, int dim_b, int dim_coord, int start_a, int start_b, int end_a, int end_b, bool upper_face, uint32 mat_index)
+{
+	Vec3<int> p;
+	p[dim] = dim_coord;
+
+	// Use the same vertex order as makeVoxelMeshForVertPosKeyType(), so the faces have the same winding.
+	unsigned int v_i[4]; // quad vert indices
+	p[dim_a] = start_a; p[dim_b] = start_b;   v_i[0] = addBrickMeshVert(vertpos_hash, mesh, p);
+	if(upper_face)
+	{
+		p[dim_a] = end_a;   p[dim_b] = start_b;   v_i[1] = addBrickMeshVert(vertpos_hash, mesh, p);
+		p[dim_a] = end_a;   p[dim_b] = end_b;     v_i[2] = addBrickMeshVert(vertpos_hash, mesh, p);
+		p[dim_a] = start_a; p[dim_b] = end_b;     v_i[3] = addBrickMeshVert(vertpos_hash, mesh, p);
+	}
+	else
+	{
+		p[dim_a] = start_a; p[dim_b] = end_b;     v_i[1] = addBrickMeshVert(vertpos_hash, mesh, p);
+		p[dim_a] = end_a;   p[dim_b] = end_b;     v_i[2] = addBrickMeshVert(vertpos_hash, mesh, p);
+		p[dim_a] = end_a;   p[dim_b] = start_b;   v_i[3] = addBrickMeshVert(vertpos_hash, mesh, p);
+	}
+
+	const size_t tri_start = mesh->triangles.size();
+	mesh->triangles.resize(tri_start + 2);
+
+	mesh->triangles[tri_start + 0].vertex_indices[0] = v_i[0];
+	mesh->triangles[tri_start + 0].vertex_indices[1] = v_i[1];
+	mesh->triangles[tri_start + 0].vertex_indices[2] = v_i[2];
+	mesh->triangles[tri_start + 0].uv_indices[0]     = 0;
+	mesh->triangles[tri_start + 0].uv_indices[1]     = 0;
+	mesh->triangles[tri_start + 0].uv_indices[2]     = 0;
+	mesh->triangles[tri_start + 0].tri_mat_index     = mat_index;
+
+	mesh->triangles[tri_start + 1].vertex_indices[0] = v_i[0];
+	mesh->triangles[tri_start + 1].vertex_indices[1] = v_i[2];
+	mesh->triangles[tri_start + 1].vertex_indices[2] = v_i[3];
+	mesh->triangles[tri_start + 1].uv_indices[0]     = 0;
+	mesh->triangles[tri_start + 1].uv_indices[1]     = 0;
+	mesh->triangles[tri_start + 1].uv_indices[2]     = 0;
+	mesh->triangles[tri_start + 1].tri_mat_index     = mat_index;
+}
+
+
+// Each brick voxel column along an axis is stored in a uint64.  Bit i+1 is set if there is a voxel at coordinate i along the axis (for i in [0, 32)).
+// Bit 0 and bit 33 are for the voxels in the adjacent bricks, at coordinates -1 and 32, so we can cull faces between bricks.
+static const uint64 BRICK_COLUMN_INTERIOR_MASK = 0x1FFFFFFFEull; // Bits 1 to 32 inclusive.
+
+static inline int brickColumnIndex(int a, int b) { return a + b * VoxelBrick::W; }
+
+
+// Greedy meshing of a 32x32 plane of voxel faces.  Bit a of plane[b] is set if a face is needed at (a, b).
+// Merges runs of set bits in a row, then extends the run over following rows with the same run bits set.
+template <class EmitQuadFunc>
+static inline void greedyMeshFacePlane(uint32* plane, EmitQuadFunc emit_quad)
+{
+	for(int b=0; b<VoxelBrick::W; ++b)
+	{
+		while(plane[b] != 0)
+		{
+			const uint32 row = plane[b];
+			const int start_a = (int)BitUtils::lowestSetBitIndex(row);
+			const int run_len = (int)BitUtils::lowestSetBitIndex(~((uint64)row >> start_a)); // Length of the run of set bits starting at start_a.  Upper bits of the complement are set so the argument is non-zero.
+			const uint32 run_mask = (uint32)((((uint64)1 << run_len) - 1) << start_a);
 
-			// Make an array to indicate processed voxel faces.  Processed = included in a greedy quad already.
-			Array2D<bool> vox_present(a_end - a_min, b_end - b_min); // Memorize the voxel lookup to use for building upper faces
-			Array2D<bool> face_needed(a_end - a_min, b_end - b_min);
+			plane[b] &= ~run_mask;
 
-			for(int dim_coord = dim_min; dim_coord < dim_end; ++dim_coord)
+			// Extend the quad in the b direction while the following rows have all the run bits set.
+			int end_b = b + 1;
+			while(end_b < VoxelBrick::W && (plane[end_b] & run_mask) == run_mask)
 			{
-				//================= Do lower faces along dim ==========================
-				// Build face_needed data for this slice
-				Vec3<int> vox, adjacent_vox_pos;
-				vox[dim] = dim_coord;
-				adjacent_vox_pos[dim] = dim_coord - 1;
-				for(int y=b_min; y<b_end; ++y)
-				for(int x=a_min; x<a_end; ++x)
-				{
-					vox[dim_a] = x;
-					vox[dim_b] = y;
+				plane[end_b] &= ~run_mask;
+				end_b++;
+			}
 
-					bool this_face_needed = false;
-					bool this_vox_present = false;
-					auto res = voxel_hash.find(vox);
-					if((res != voxel_hash.end()) && (res->second == mat_i)) // If there is a voxel here with mat_i
-					{
-						this_vox_present = true;
+			emit_quad(start_a, b, start_a + run_len, end_b);
+		}
+	}
+}
 
-						adjacent_vox_pos[dim_a] = x;
-						adjacent_vox_pos[dim_b] = y;
-						auto adjacent_res = voxel_hash.find(adjacent_vox_pos);
-						if((adjacent_res == voxel_hash.end()) || (adjacent_res->second != mat_i)) // If there is no adjacent voxel, or the adjacent voxel has a different material:
-							this_face_needed = true;
-					}
-					vox_present.elem(x - a_min, y - b_min) = this_vox_present;
-					face_needed.elem(x - a_min, y - b_min) = this_face_needed;
-				}
 
-				// For each voxel face:
-				for(int start_y=b_min; start_y<b_end; ++start_y)
-				for(int start_x=a_min; start_x<a_end; ++start_x)
-				{
-					if(face_needed.elem(start_x - a_min, start_y - b_min)) // If we need a face here:
-					{
-						// Start a quad here (start corner at (start_x, start_y))
-						// The quad will range from (start_x, start_y) to (end_x, end_y)
-						int end_x = start_x + 1;
-						int end_y = start_y + 1;
-
-						bool x_increase_ok = true;
-						bool y_increase_ok = true;
-						while(x_increase_ok || y_increase_ok)
-						{
-							// Try and increase in x direction
-							if(x_increase_ok)
-							{
-								if(end_x < a_end) // If there is still room to increase in x direction:
-								{
-									// Check y values for new x = end_x
-									for(int y = start_y; y < end_y; ++y)
-										if(!face_needed.elem(end_x - a_min, y - b_min))
-										{
-											x_increase_ok = false;
-											break;
-										}
-
-									if(x_increase_ok)
-										end_x++;
-								}
-								else
-									x_increase_ok = false;
-							}
+// Scratch data for meshing a brick, reused between bricks.
+struct BrickMeshingScratch
+{
+	BrickMeshingScratch() : opaque_columns(3 * VoxelBrick::W * VoxelBrick::W)
+	{
+		for(int i=0; i<256; ++i)
+			palette_index_for_mat[i] = 0;
+	}
 
-							// Try and increase in y direction
-							if(y_increase_ok)
-							{
-								if(end_y < b_end)
-								{
-									// Check x values for new y = end_y
-									for(int x = start_x; x < end_x; ++x)
-										if(!face_needed.elem(x - a_min, end_y - b_min))
-										{
-											y_increase_ok = false;
-											break;
-										}
-
-									if(y_increase_ok)
-										end_y++;
-								}
-								else
-									y_increase_ok = false;
-							}
-						}
+	std::vector<uint64> mat_columns; // Voxel columns for each palette entry, for each axis: index = (palette_index * 3 + dim) * NUM_COLUMNS + column index.
+	std::vector<uint64> opaque_columns; // Voxel columns of all opaque voxels, for each axis.
+	uint32 face_planes[2][VoxelBrick::W][VoxelBrick::W]; // For lower and upper faces, for each coord along dim: bit a of face_planes[side][d][b] is set if a face is needed.
+	int palette_index_for_mat[256]; // Zero for materials not in the current brick palette.
+};
 
-						// We have worked out the greedy quad.  Mark elements in it as processed
-						for(int y=start_y; y < end_y; ++y)
-						for(int x=start_x; x < end_x; ++x)
-							face_needed.elem(x - a_min, y - b_min) = false;
 
-						// Add the greedy quad
-						unsigned int v_i[4]; // quad vert indices
-						Indigo::Vec3f v;
-						v[dim] = (float)dim_coord;
-						{
-							// bot left
-							v[dim_a] = (float)start_x;
-							v[dim_b] = (float)start_y;
-
-							// returns object of type std::pair<iterator, bool>
-							VoxelVertInfo vert_info(v, normal_down);
-							const auto insert_res = vertpos_hash.insert(std::make_pair(vert_info, (int)vertpos_hash.size())); // Try and insert vertex
-							v_i[0] = insert_res.first->second; // Get existing or new item (insert_res.first) - a (vec3f, index) pair, then get the index.
-							if(insert_res.second) // If inserted new value:
-							{
-								mesh->vert_positions.push_back(v);
-								mesh->vert_normals.push_back(normal_down);
-								mesh->uv_pairs.push_back(
-									(dim == 0)  ? Indigo::Vec2f(-(float)start_x, (float)start_y) : 
-									((dim == 1) ? Indigo::Vec2f( (float)start_y, (float)start_x) : 
-									              Indigo::Vec2f(-(float)start_x, (float)start_y)));
-							}
-						}
-						{
-							// top left
-							v[dim_a] = (float)start_x;
-							v[dim_b] = (float)end_y;
-
-							VoxelVertInfo vert_info(v, normal_down);
-							const auto insert_res = vertpos_hash.insert(std::make_pair(vert_info, (int)vertpos_hash.size()));
-							v_i[1] = insert_res.first->second; // deref iterator to get (vec3f, index) pair, then get the index.
-							if(insert_res.second) // If inserted new value:
-							{
-								mesh->vert_positions.push_back(v);
-								mesh->vert_normals.push_back(normal_down);
-								mesh->uv_pairs.push_back(
-									(dim == 0) ? Indigo::Vec2f(-(float)start_x, (float)end_y) : 
-									(dim == 1) ? Indigo::Vec2f( (float)end_y, (float)start_x) : 
-									             Indigo::Vec2f(-(float)start_x, (float)end_y));
-							}
-						}
-						{
-							// top right
-							v[dim_a] = (float)end_x;
-							v[dim_b] = (float)end_y;
-
-							VoxelVertInfo vert_info(v, normal_down);
-							const auto insert_res = vertpos_hash.insert(std::make_pair(vert_info, (int)vertpos_hash.size()));
-							v_i[2] = insert_res.first->second; // deref iterator to get (vec3f, index) pair, then get the index.
-							if(insert_res.second) // If inserted new value:
-							{
-								mesh->vert_positions.push_back(v);
-								mesh->vert_normals.push_back(normal_down);
-								mesh->uv_pairs.push_back(
-									(dim == 0) ? Indigo::Vec2f(-(float)end_x, (float)end_y) :
-									(dim == 1) ? Indigo::Vec2f( (float)end_y, (float)end_x) : 
-									             Indigo::Vec2f(-(float)end_x, (float)end_y));
-							}
-						}
-						{
-							// bot right
-							v[dim_a] = (float)end_x;
-							v[dim_b] = (float)start_y;
-
-							VoxelVertInfo vert_info(v, normal_down);
-							const auto insert_res = vertpos_hash.insert(std::make_pair(vert_info, (int)vertpos_hash.size()));
-							v_i[3] = insert_res.first->second; // deref iterator to get (vec3f, index) pair, then get the index.
-							if(insert_res.second) // If inserted new value:
-							{
-								mesh->vert_positions.push_back(v);
-								mesh->vert_normals.push_back(normal_down);
-								mesh->uv_pairs.push_back(
-									(dim == 0) ? Indigo::Vec2f(-(float)end_x, (float)start_y) :
-									(dim == 1) ? Indigo::Vec2f( (float)start_y, (float)end_x) : 
-									             Indigo::Vec2f(-(float)end_x, (float)start_y));
-							}
-						}
+// Builds a local array of mat-transparent booleans, one for each material.  If no such entry in mats_transparent for a given index, assume opaque.
+static void getMatTransparentArray(const js::Vector<bool, 16>& mats_transparent, bool* mat_transparent_out)
+{
+	for(size_t i=0; i<256; ++i)
+		mat_transparent_out[i] = (i < mats_transparent.size()) && mats_transparent[i];
+}
 
-						assert(mesh->vert_positions.size() == vertpos_hash.size());
 
-						const size_t tri_start = mesh->triangles.size();
-						mesh->triangles.resize(tri_start + 2);
-						
-						mesh->triangles[tri_start + 0].vertex_indices[0] = v_i[0];
-						mesh->triangles[tri_start + 0].vertex_indices[1] = v_i[1];
-						mesh->triangles[tri_start + 0].vertex_indices[2] = v_i[2];
-						mesh->triangles[tri_start + 0].uv_indices[0]     = v_i[0];
-						mesh->triangles[tri_start + 0].uv_indices[1]     = v_i[1];
-						mesh->triangles[tri_start + 0].uv_indices[2]     = v_i[2];
-						mesh->triangles[tri_start + 0].tri_mat_index     = (uint32)mat_i;
-						
-						mesh->triangles[tri_start + 1].vertex_indices[0] = v_i[0];
-						mesh->triangles[tri_start + 1].vertex_indices[1] = v_i[2];
-						mesh->triangles[tri_start + 1].vertex_indices[2] = v_i[3];
-						mesh->triangles[tri_start + 1].uv_indices[0]     = v_i[0];
-						mesh->triangles[tri_start + 1].uv_indices[1]     = v_i[2];
-						mesh->triangles[tri_start + 1].uv_indices[2]     = v_i[3];
-						mesh->triangles[tri_start + 1].tri_mat_index     = (uint32)mat_i;
-					}
-				}
+// Limit vertex coords to 16-bit values, like doMakeIndigoMeshForVoxelGroupWith3dArray().  Max brick coord of 1022 gives a max vert coord of 32736.
+static void checkBrickCoordsValidForMeshing(const Vec3<int>& c)
+{
+	const int min_brick_coord = -32768 / VoxelBrick::W;
+	const int max_brick_coord = 32767 / VoxelBrick::W - 1;
+	if(c.x < min_brick_coord || c.y < min_brick_coord || c.z < min_brick_coord || c.x > max_brick_coord || c.y > max_brick_coord || c.z > max_brick_coord)
+		throw glare::Exception("Invalid voxel brick coords: " + toString(c.x) + ", " + toString(c.y) + ", " + toString(c.z));
+}
+
+
+static void checkBrickMaterialsValidForMeshing(const VoxelBrick& brick)
+{
+	for(size_t p=1; p<brick.palette.size(); ++p)
+		if(brick.palette[p].count > 0 && brick.palette[p].mat_index >= 255) // Same limit as doMakeIndigoMeshForVoxelGroupWith3dArray().
+			throw glare::Exception("Too many materials");
+}
+
+
+// Adds the faces of the voxels in the brick at brick_coord to the mesh.
+// Voxels in adjacent bricks are taken into account for face culling, so the faces only depend on the brick and its 6 neighbours.
+// The materials of the brick and adjacent bricks should have been checked with checkBrickMaterialsValidForMeshing().
+static void addFacesForVoxelBrick(const VoxelBricks& bricks, const Vec3<int>& brick_coord, const bool* mat_transparent, BrickMeshingScratch& scratch, BrickVertPosHashMap& vertpos_hash, Indigo::Mesh* mesh)
+{
+	const int W = VoxelBrick::W;
+	const int NUM_COLUMNS = W * W; // Number of columns along each axis
+
+	const VoxelBrick& brick = *bricks.getBrick(brick_coord);
+	const Vec3<int> origin = brick_coord * W;
+	const size_t palette_size = brick.palette.size();
+
+	std::vector<uint64>& mat_columns = scratch.mat_columns;
+	std::vector<uint64>& opaque_columns = scratch.opaque_columns;
+	int* const palette_index_for_mat = scratch.palette_index_for_mat;
+
+	for(size_t p=1; p<palette_size; ++p)
+		if(brick.palette[p].count > 0)
+			palette_index_for_mat[brick.palette[p].mat_index] = (int)p;
+
+	//------------------------ Splat voxels into the column masks ------------------------
+	mat_columns.resize(palette_size * 3 * NUM_COLUMNS);
+	std::memset(mat_columns.data(), 0, mat_columns.size() * sizeof(uint64));
 
-				//================= Do upper faces along dim ==========================
-				// Build face_needed data for this slice
-				adjacent_vox_pos[dim] = dim_coord + 1;
-				for(int y=b_min; y<b_end; ++y)
-				for(int x=a_min; x<a_end; ++x)
+	int vox_i = 0;
+	for(int z=0; z<W; ++z)
+	for(int y=0; y<W; ++y)
+	for(int x=0; x<W; ++x)
+	{
+		const uint8 p = brick.palette_indices[vox_i++];
+		if(p != 0)
+		{
+			uint64* const cols = &mat_columns[p * 3 * NUM_COLUMNS];
+			cols[0 * NUM_COLUMNS + brickColumnIndex(y, z)] |= 2ull << x; // dim 0: (a, b) = (y, z)
+			cols[1 * NUM_COLUMNS + brickColumnIndex(z, x)] |= 2ull << y; // dim 1: (a, b) = (z, x)
+			cols[2 * NUM_COLUMNS + brickColumnIndex(x, y)] |= 2ull << z; // dim 2: (a, b) = (x, y)
+		}
+	}
+
+	std::memset(opaque_columns.data(), 0, opaque_columns.size() * sizeof(uint64));
+	for(size_t p=1; p<palette_size; ++p)
+		if(brick.palette[p].count > 0 && !mat_transparent[brick.palette[p].mat_index])
+		{
+			const uint64* const cols = &mat_columns[p * 3 * NUM_COLUMNS];
+			for(int i=0; i<3 * NUM_COLUMNS; ++i)
+				opaque_columns[i] |= cols[i];
+		}
+
+	//------------------------ Add voxels from adjacent bricks to the ends of the columns ------------------------
+	for(int dim=0; dim<3; ++dim)
+	{
+		const int dim_a = (dim + 1) % 3; // Same as in makeVoxelMeshForVertPosKeyType()
+		const int dim_b = (dim + 2) % 3;
+
+		for(int side=0; side<2; ++side)
+		{
+			Vec3<int> adjacent_brick_coord = brick_coord;
+			adjacent_brick_coord[dim] += (side == 0) ? -1 : 1;
+			const VoxelBrick* adjacent_brick = bricks.getBrick(adjacent_brick_coord);
+			if(!adjacent_brick)
+				continue;
+
+			const uint64 bit = (side == 0) ? 1ull : (1ull << (W + 1));
+			Vec3<int> adj_local;
+			adj_local[dim] = (side == 0) ? (W - 1) : 0;
+			for(int b=0; b<W; ++b)
+			for(int a=0; a<W; ++a)
+			{
+				adj_local[dim_a] = a;
+				adj_local[dim_b] = b;
+				const int adj_mat = adjacent_brick->getVoxel(adj_local.x, adj_local.y, adj_local.z);
+				if(adj_mat >= 0)
 				{
-					bool this_face_needed = false;
-					if(vox_present.elem(x - a_min, y - b_min)) // If there is a voxel here with mat_i
-					{
-						adjacent_vox_pos[dim_a] = x;
-						adjacent_vox_pos[dim_b] = y;
-						auto adjacent_res = voxel_hash.find(adjacent_vox_pos);
-						if((adjacent_res == voxel_hash.end()) || (adjacent_res->second != mat_i)) // If there is no adjacent voxel, or the adjacent voxel has a different material:
-							this_face_needed = true;
-					}
-					face_needed.elem(x - a_min, y - b_min) = this_face_needed;
+					if(!mat_transparent[adj_mat])
+						opaque_columns[dim * NUM_COLUMNS + brickColumnIndex(a, b)] |= bit;
+					else if(palette_index_for_mat[adj_mat] != 0) // Transparent voxels only hide faces of voxels with the same material.
+						mat_columns[(palette_index_for_mat[adj_mat] * 3 + dim) * NUM_COLUMNS + brickColumnIndex(a, b)] |= bit;
 				}
+			}
+		}
+	}
 
-				// For each voxel face:
-				for(int start_y=b_min; start_y<b_end; ++start_y)
-				for(int start_x=a_min; start_x<a_end; ++start_x)
-				{
-					if(face_needed.elem(start_x - a_min, start_y - b_min))
-					{
-						// Start a quad here (start corner at (start_x, start_y))
-						// The quad will range from (start_x, start_y) to (end_x, end_y)
-						int end_x = start_x + 1;
-						int end_y = start_y + 1;
-
-						bool x_increase_ok = true;
-						bool y_increase_ok = true;
-						while(x_increase_ok || y_increase_ok)
-						{
-							// Try and increase in x direction
-							if(x_increase_ok)
-							{
-								if(end_x < a_end) // If there is still room to increase in x direction:
-								{
-									// Check y values for new x = end_x
-									for(int y = start_y; y < end_y; ++y)
-										if(!face_needed.elem(end_x - a_min, y - b_min))
-										{
-											x_increase_ok = false;
-											break;
-										}
-
-									if(x_increase_ok)
-										end_x++;
-								}
-								else
-									x_increase_ok = false;
-							}
+	//------------------------ Compute faces and do greedy meshing ------------------------
+	// As in makeVoxelMeshForVertPosKeyType(), a face of a voxel is needed if the adjacent voxel is empty, or is transparent with a different material.
+	// So the voxels that hide the faces of voxels with material m are the opaque voxels and the voxels with material m.
+	for(int dim=0; dim<3; ++dim)
+	{
+		const int dim_a = (dim + 1) % 3;
+		const int dim_b = (dim + 2) % 3;
+		const uint64* const dim_opaque_cols = &opaque_columns[dim * NUM_COLUMNS];
 
-							// Try and increase in y direction
-							if(y_increase_ok)
-							{
-								if(end_y < b_end)
-								{
-									// Check x values for new y = end_y
-									for(int x = start_x; x < end_x; ++x)
-										if(!face_needed.elem(x - a_min, end_y - b_min))
-										{
-											y_increase_ok = false;
-											break;
-										}
-
-									if(y_increase_ok)
-										end_y++;
-								}
-								else
-									y_increase_ok = false;
-							}
-						}
+		for(size_t p=1; p<palette_size; ++p)
+		{
+			if(brick.palette[p].count == 0)
+				continue;
 
-						// We have worked out the greedy quad.  Mark elements in it as processed
-						for(int y=start_y; y < end_y; ++y)
-							for(int x=start_x; x < end_x; ++x)
-								face_needed.elem(x - a_min, y - b_min) = false;
-
-						const float quad_dim_coord = (float)(dim_coord + 1);
-
-						// Add the greedy quad
-						unsigned int v_i[4]; // quad vert indices
-						Indigo::Vec3f v;
-						v[dim] = (float)quad_dim_coord;
-						{ // Add bot left vert
-							v[dim_a] = (float)start_x;
-							v[dim_b] = (float)start_y;
-								
-							VoxelVertInfo vert_info(v, normal_up);
-							const auto insert_res = vertpos_hash.insert(std::make_pair(vert_info, (int)vertpos_hash.size()));
-							v_i[0] = insert_res.first->second; // deref iterator to get (vec3f, index) pair, then get the index.
-							if(insert_res.second) // If inserted new value:
-							{
-								mesh->vert_positions.push_back(v);
-								mesh->vert_normals.push_back(normal_up);
-								mesh->uv_pairs.push_back((dim == 1) ? 
-									Indigo::Vec2f(-(float)start_y, (float)start_x) : 
-									Indigo::Vec2f((float)start_x, (float)start_y));
-							}
-						}
-						{ // bot right
-							v[dim_a] = (float)end_x;
-							v[dim_b] = (float)start_y;
-
-							VoxelVertInfo vert_info(v, normal_up);
-							const auto insert_res = vertpos_hash.insert(std::make_pair(vert_info, (int)vertpos_hash.size()));
-							v_i[1] = insert_res.first->second; // deref iterator to get (vec3f, index) pair, then get the index.
-							if(insert_res.second) // If inserted new value:
-							{
-								mesh->vert_positions.push_back(v);
-								mesh->vert_normals.push_back(normal_up);
-								mesh->uv_pairs.push_back((dim == 1) ? 
-									Indigo::Vec2f(-(float)start_y, (float)end_x) : 
-									Indigo::Vec2f((float)end_x, (float)start_y));
-							}
-						}
-						{ // top right
-							v[dim_a] = (float)end_x;
-							v[dim_b] = (float)end_y;
-
-							VoxelVertInfo vert_info(v, normal_up);
-							const auto insert_res = vertpos_hash.insert(std::make_pair(vert_info, (int)vertpos_hash.size()));
-							v_i[2] = insert_res.first->second; // deref iterator to get (vec3f, index) pair, then get the index.
-							if(insert_res.second) // If inserted new value:
-							{
-								mesh->vert_positions.push_back(v);
-								mesh->vert_normals.push_back(normal_up);
-								mesh->uv_pairs.push_back((dim == 1) ? 
-									Indigo::Vec2f(-(float)end_y, (float)end_x) : 
-									Indigo::Vec2f((float)end_x, (float)end_y));
-							}
-						}
-						{ // top left
-							v[dim_a] = (float)start_x;
-							v[dim_b] = (float)end_y;
-
-							VoxelVertInfo vert_info(v, normal_up);
-							const auto insert_res = vertpos_hash.insert(std::make_pair(vert_info, (int)vertpos_hash.size()));
-							v_i[3] = insert_res.first->second; // deref iterator to get (vec3f, index) pair, then get the index.
-							if(insert_res.second) // If inserted new value:
-							{
-								mesh->vert_positions.push_back(v);
-								mesh->vert_normals.push_back(normal_up);
-								mesh->uv_pairs.push_back((dim == 1) ? 
-									Indigo::Vec2f(-(float)end_y, (float)start_x) : 
-									Indigo::Vec2f((float)start_x, (float)end_y));
-							}
-						}
-							
-						const size_t tri_start = mesh->triangles.size();
-						mesh->triangles.resize(tri_start + 2);
-							
-						mesh->triangles[tri_start + 0].vertex_indices[0] = v_i[0];
-						mesh->triangles[tri_start + 0].vertex_indices[1] = v_i[1];
-						mesh->triangles[tri_start + 0].vertex_indices[2] = v_i[2];
-						mesh->triangles[tri_start + 0].uv_indices[0]     = v_i[0];
-						mesh->triangles[tri_start + 0].uv_indices[1]     = v_i[1];
-						mesh->triangles[tri_start + 0].uv_indices[2]     = v_i[2];
-						mesh->triangles[tri_start + 0].tri_mat_index     = (uint32)mat_i;
-
-						mesh->triangles[tri_start + 1].vertex_indices[0] = v_i[0];
-						mesh->triangles[tri_start + 1].vertex_indices[1] = v_i[2];
-						mesh->triangles[tri_start + 1].vertex_indices[2] = v_i[3];
-						mesh->triangles[tri_start + 1].uv_indices[0]     = v_i[0];
-						mesh->triangles[tri_start + 1].uv_indices[1]     = v_i[2];
-						mesh->triangles[tri_start + 1].uv_indices[2]     = v_i[3];
-						mesh->triangles[tri_start + 1].tri_mat_index     = (uint32)mat_i;
-					}
+			const uint32 mat_index = (uint32)brick.palette[p].mat_index;
+			const uint64* const cols = &mat_columns[(p * 3 + dim) * NUM_COLUMNS];
+
+			std::memset(scratch.face_planes, 0, sizeof(scratch.face_planes));
+
+			for(int b=0; b<W; ++b)
+			for(int a=0; a<W; ++a)
+			{
+				const int c = brickColumnIndex(a, b);
+				const uint64 occupied = cols[c];
+				if((occupied & BRICK_COLUMN_INTERIOR_MASK) == 0)
+					continue;
+
+				const uint64 hiding = dim_opaque_cols[c] | occupied;
+				uint64 lower_faces = occupied & ~(hiding << 1) & BRICK_COLUMN_INTERIOR_MASK; // Voxel at bit i is hidden on lower side if voxel at bit i-1 is hiding.
+				uint64 upper_faces = occupied & ~(hiding >> 1) & BRICK_COLUMN_INTERIOR_MASK;
+
+				// Transpose the face bits into the planes.
+				while(lower_faces != 0)
+				{
+					const int d = (int)BitUtils::lowestSetBitIndex(lower_faces) - 1;
+					scratch.face_planes[0][d][b] |= 1u << a;
+					lower_faces &= lower_faces - 1; // Clear lowest set bit
 				}
+				while(upper_faces != 0)
+				{
+					const int d = (int)BitUtils::lowestSetBitIndex(upper_faces) - 1;
+					scratch.face_planes[1][d][b] |= 1u << a;
+					upper_faces &= upper_faces - 1;
+				}
+			}
+
+			for(int side=0; side<2; ++side)
+			for(int d=0; d<W; ++d)
+			{
+				const int dim_coord = origin[dim] + d + side; // Upper faces are at the top of the voxel.
+				greedyMeshFacePlane(scratch.face_planes[side][d], [&](int start_a, int start_b, int end_a, int end_b) {
+					addBrickMeshQuad(vertpos_hash, mesh, dim, dim_a, dim_b, dim_coord,
+						origin[dim_a] + start_a, origin[dim_b] + start_b, origin[dim_a] + end_a, origin[dim_b] + end_b, /*upper_face=*/side == 1, mat_index);
+				});
 			}
 		}
 	}
 
-	mesh->endOfModel();
-	assert(isFinite(mesh->aabb_os.bound[0].x));
-	return mesh;
+	for(size_t p=1; p<palette_size; ++p)
+		if(brick.palette[p].count > 0)
+			palette_index_for_mat[brick.palette[p].mat_index] = 0;
 }
 
 
-Reference<Indigo::Mesh> VoxelMeshBuilding::makeIndigoMeshForVoxelGroup(const VoxelGroup& voxel_group, const int subsample_factor, const js::Vector<bool, 16>& mats_transparent,
+Reference<Indigo::Mesh> VoxelMeshBuilding::makeIndigoMeshForVoxelBricks(const VoxelBricks& bricks, const js::Vector<bool, 16>& mats_transparent, glare::Allocator* mem_allocator)
+{
+#if GUI_CLIENT
+	PERFORMANCEAPI_INSTRUMENT_FUNCTION();
+#endif
+
+	try
+	{
+		if(bricks.numVoxels() == 0)
+			throw glare::Exception("No voxels");
+
+		bool mat_transparent[256];
+		getMatTransparentArray(mats_transparent, mat_transparent);
+
+		std::vector<Vec3<int> > brick_coords;
+		bricks.getSortedBrickCoords(brick_coords);
+
+		for(size_t i=0; i<brick_coords.size(); ++i)
+		{
+			checkBrickCoordsValidForMeshing(brick_coords[i]);
+			checkBrickMaterialsValidForMeshing(*bricks.getBrick(brick_coords[i]));
+		}
+
+		Reference<Indigo::Mesh> mesh = new Indigo::Mesh();
+		mesh->setMaxNumTexcoordSets(0);
+
+		BrickVertPosHashMap vertpos_hash(/*empty key=*/std::numeric_limits<uint64>::max(), /*expected_num_items=*/bricks.numVoxels() / 100, mem_allocator);
+
+		BrickMeshingScratch scratch;
+
+		for(size_t i=0; i<brick_coords.size(); ++i)
+			addFacesForVoxelBrick(bricks, brick_coords[i], mat_transparent, scratch, vertpos_hash, mesh.ptr());
+
+		mesh->endOfModel();
+		assert(isFinite(mesh->aabb_os.bound[0].x));
+		return mesh;
+	}
+	catch(Indigo::IndigoException& e)
+	{
+		throw glare::Exception(toStdString(e.what()));
+	}
+}
+
+
+Reference<Indigo::Mesh> VoxelMeshBuilding::makeIndigoMeshForVoxelBrick(const VoxelBricks& bricks, const Vec3<int>& brick_coords, const js::Vector<bool, 16>& mats_transparent, glare::Allocator* mem_allocator)
+{
+	try
+	{
+		const VoxelBrick* brick = bricks.getBrick(brick_coords);
+		if(!brick)
+			throw glare::Exception("No such brick");
+
+		bool mat_transparent[256];
+		getMatTransparentArray(mats_transparent, mat_transparent);
+
+		// Check the brick, and the adjacent bricks, which we will read voxels from.
+		checkBrickCoordsValidForMeshing(brick_coords);
+		checkBrickMaterialsValidForMeshing(*brick);
+		for(int dim=0; dim<3; ++dim)
+			for(int side=-1; side<=1; side += 2)
+			{
+				Vec3<int> adjacent_brick_coords = brick_coords;
+				adjacent_brick_coords[dim] += side;
+				const VoxelBrick* adjacent_brick = bricks.getBrick(adjacent_brick_coords);
+				if(adjacent_brick)
+					checkBrickMaterialsValidForMeshing(*adjacent_brick);
+			}
+
+		Reference<Indigo::Mesh> mesh = new Indigo::Mesh();
+		mesh->setMaxNumTexcoordSets(0);
+
+		BrickVertPosHashMap vertpos_hash(/*empty key=*/std::numeric_limits<uint64>::max(), /*expected_num_items=*/brick->numVoxels() / 100, mem_allocator);
+
+		BrickMeshingScratch scratch;
+		addFacesForVoxelBrick(bricks, brick_coords, mat_transparent, scratch, vertpos_hash, mesh.ptr());
+
+		if(mesh->triangles.empty())
+			return Reference<Indigo::Mesh>();
+
+		mesh->endOfModel();
+		return mesh;
+	}
+	catch(Indigo::IndigoException& e)
+	{
+		throw glare::Exception(toStdString(e.what()));
+	}
+}
+
+
+Reference<Indigo::Mesh> VoxelMeshBuilding::makeIndigoMeshForVoxelGroupWithBricks(const VoxelGroup& voxel_group, const int subsample_factor, const js::Vector<bool, 16>& mats_transparent,
 	glare::Allocator* mem_allocator)
 {
-	assert(voxel_group.voxels.size() > 0);
-	// conPrint("Adding " + toString(voxel_group.voxels.size()) + " voxels.");
+	if(voxel_group.voxels.empty())
+		throw glare::Exception("No voxels");
 
-	return doMakeIndigoMeshForVoxelGroupWith3dArray(voxel_group.voxels, subsample_factor, mats_transparent, mem_allocator);
+	VoxelBricks bricks;
+	bricks.build(voxel_group, subsample_factor);
+
+	return makeIndigoMeshForVoxelBricks(bricks, mats_transparent, mem_allocator);
 }
 
 
@@ -1213,8 +1631,119 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
 
 #include <simpleraytracer/raymesh.h>
 #include <graphics/BatchedMesh.h>
-#include <utils/TaskManager.h>
 #include <utils/TestUtils.h>
+#include <utils/Timer.h>
+#include <maths/PCG32.h>
+#include <map>
+#include <array>
+#include <cmath>
+
+
+// Get the unit voxel faces covered by the mesh, with the material of each face.
+// Key is (axis, facing up, coord along axis, coord along dim_a, coord along dim_b).
+// Assumes each quad is made from 2 consecutive triangles, as created by the voxel meshing functions.  Checks no unit face is covered twice.
+static void getMeshUnitFaces(const Indigo::Mesh& mesh, std::map<std::array<int, 5>, uint32>& faces_out)
+{
+	testAssert(mesh.triangles.size() % 2 == 0);
+	for(size_t t=0; t<mesh.triangles.size(); t += 2)
+	{
+		const auto& tri = mesh.triangles[t];
+		testAssert(mesh.triangles[t + 1].tri_mat_index == tri.tri_mat_index);
+
+		const Indigo::Vec3f v0 = mesh.vert_positions[tri.vertex_indices[0]];
+		const Indigo::Vec3f v1 = mesh.vert_positions[tri.vertex_indices[1]];
+		const Indigo::Vec3f v2 = mesh.vert_positions[tri.vertex_indices[2]];
+
+		// Triangle (0, 1, 2) spans the whole quad.
+		int min_c[3], max_c[3];
+		for(int c=0; c<3; ++c)
+		{
+			min_c[c] = (int)myMin(v0[c], myMin(v1[c], v2[c]));
+			max_c[c] = (int)myMax(v0[c], myMax(v1[c], v2[c]));
+		}
+
+		const int dim = (min_c[0] == max_c[0]) ? 0 : ((min_c[1] == max_c[1]) ? 1 : 2);
+		testAssert(min_c[dim] == max_c[dim]);
+		const int dim_a = (dim + 1) % 3;
+		const int dim_b = (dim + 2) % 3;
+
+		// Get the component along dim of the geometric normal, to see which way the face is facing.
+		const float e1_a = v1[dim_a] - v0[dim_a], e1_b = v1[dim_b] - v0[dim_b];
+		const float e2_a = v2[dim_a] - v0[dim_a], e2_b = v2[dim_b] - v0[dim_b];
+		const int facing_up = (e1_a * e2_b - e1_b * e2_a) > 0 ? 1 : 0;
+
+		for(int b=min_c[dim_b]; b<max_c[dim_b]; ++b)
+		for(int a=min_c[dim_a]; a<max_c[dim_a]; ++a)
+		{
+			const std::array<int, 5> key = { dim, facing_up, min_c[dim], a, b };
+			const bool inserted = faces_out.insert(std::make_pair(key, tri.tri_mat_index)).second;
+			testAssert(inserted);
+		}
+	}
+}
+
+
+// Check the brick mesher covers exactly the same faces, with the same materials and facing, as the 3d-array mesher.
+static void testBrickMeshMatchesArrayMesh(const VoxelGroup& group, int subsample_factor, const js::Vector<bool, 16>& mat_transparent)
+{
+	Reference<Indigo::Mesh> ref_mesh    = VoxelMeshBuilding::makeIndigoMeshForVoxelGroup(group, subsample_factor, mat_transparent, /*allocator=*/NULL);
+	Reference<Indigo::Mesh> bricks_mesh = VoxelMeshBuilding::makeIndigoMeshForVoxelGroupWithBricks(group, subsample_factor, mat_transparent, /*allocator=*/NULL);
+
+	testAssert(bricks_mesh->num_materials_referenced == ref_mesh->num_materials_referenced);
+	testAssert(bricks_mesh->aabb_os.bound[0] == ref_mesh->aabb_os.bound[0]);
+	testAssert(bricks_mesh->aabb_os.bound[1] == ref_mesh->aabb_os.bound[1]);
+
+	std::map<std::array<int, 5>, uint32> ref_faces, bricks_faces;
+	getMeshUnitFaces(*ref_mesh, ref_faces);
+	getMeshUnitFaces(*bricks_mesh, bricks_faces);
+	testAssert(bricks_faces == ref_faces);
+}
+
+
+// Check meshing with shading normals gives exactly the same mesh with and without a task manager.
+static void testShadingNormalsMeshesEqual(const VoxelGroup& group, int subsample_factor, glare::TaskManager& task_manager)
+{
+	js::Vector<bool, 16> mat_transparent;
+	Reference<Indigo::Mesh> serial_mesh   = VoxelMeshBuilding::makeIndigoMeshWithShadingNormalsForVoxelGroup(group, subsample_factor, mat_transparent, /*task_manager=*/NULL, /*allocator=*/NULL);
+	Reference<Indigo::Mesh> parallel_mesh = VoxelMeshBuilding::makeIndigoMeshWithShadingNormalsForVoxelGroup(group, subsample_factor, mat_transparent, &task_manager, /*allocator=*/NULL);
+
+	testAssert(parallel_mesh->vert_positions.size() == serial_mesh->vert_positions.size());
+	testAssert(parallel_mesh->vert_normals.size() == serial_mesh->vert_normals.size());
+	testAssert(parallel_mesh->uv_pairs.size() == serial_mesh->uv_pairs.size());
+	testAssert(parallel_mesh->triangles.size() == serial_mesh->triangles.size());
+	for(size_t i=0; i<serial_mesh->vert_positions.size(); ++i)
+	{
+		testAssert(parallel_mesh->vert_positions[i] == serial_mesh->vert_positions[i]);
+		testAssert(parallel_mesh->vert_normals[i] == serial_mesh->vert_normals[i]);
+		testAssert(parallel_mesh->uv_pairs[i].x == serial_mesh->uv_pairs[i].x && parallel_mesh->uv_pairs[i].y == serial_mesh->uv_pairs[i].y);
+	}
+	for(size_t i=0; i<serial_mesh->triangles.size(); ++i)
+	{
+		for(int v=0; v<3; ++v)
+		{
+			testAssert(parallel_mesh->triangles[i].vertex_indices[v] == serial_mesh->triangles[i].vertex_indices[v]);
+			testAssert(parallel_mesh->triangles[i].uv_indices[v] == serial_mesh->triangles[i].uv_indices[v]);
+		}
+		testAssert(parallel_mesh->triangles[i].tri_mat_index == serial_mesh->triangles[i].tri_mat_index);
+	}
+	testAssert(parallel_mesh->aabb_os.bound[0] == serial_mesh->aabb_os.bound[0]);
+	testAssert(parallel_mesh->aabb_os.bound[1] == serial_mesh->aabb_os.bound[1]);
+}
+
+
+static void makeTerrainVoxelGroup(int size, VoxelGroup& group)
+{
+	for(int y=0; y<size; ++y)
+	for(int x=0; x<size; ++x)
+	{
+		const int height = 16 + (int)(8 * std::sin(x * 0.05f) + 8 * std::cos(y * 0.07f) + 4 * std::sin((x + y) * 0.21f));
+		for(int z=0; z<height; ++z)
+			group.voxels.push_back(Voxel(Vec3<int>(x, y, z), (z < 8) ? 0 : ((z < height - 2) ? 1 : 2)));
+		if(height < 12) // Add some transparent water voxels in the low parts.
+			for(int z=height; z<12; ++z)
+				group.voxels.push_back(Voxel(Vec3<int>(x, y, z), 3));
+	}
+}
 
 
 void VoxelMeshBuilding::test()
@@ -1422,6 +1951,204 @@ void VoxelMeshBuilding::test()
 
 	
 
+	//------------------------ Test brick-based meshing ------------------------
+	{
+		js::Vector<bool, 16> mat_transparent(4, false);
+		mat_transparent[1] = true;
+		mat_transparent[3] = true;
+
+		// Single voxel
+		{
+			VoxelGroup group;
+			group.voxels.push_back(Voxel(Vec3<int>(1, 2, 3), 0));
+			testBrickMeshMatchesArrayMesh(group, /*subsample_factor=*/1, mat_transparent);
+
+			Reference<Indigo::Mesh> data = makeIndigoMeshForVoxelGroupWithBricks(group, /*subsample_factor=*/1, mat_transparent, /*allocator=*/NULL);
+			testAssert(data->triangles.size() == 6 * 2);
+			testAssert(data->vert_positions.size() == 8);
+		}
+
+		// Two adjacent voxels with same material, across a brick boundary.  Since quads are not merged across bricks, the 4 side faces are split.
+		{
+			VoxelGroup group;
+			group.voxels.push_back(Voxel(Vec3<int>(31, 0, 0), 0));
+			group.voxels.push_back(Voxel(Vec3<int>(32, 0, 0), 0));
+			testBrickMeshMatchesArrayMesh(group, /*subsample_factor=*/1, mat_transparent);
+
+			Reference<Indigo::Mesh> data = makeIndigoMeshForVoxelGroupWithBricks(group, /*subsample_factor=*/1, mat_transparent, /*allocator=*/NULL);
+			testAssert(data->triangles.size() == 10 * 2);
+		}
+
+		// Separated voxels, with subsampling
+		{
+			VoxelGroup group;
+			group.voxels.push_back(Voxel(Vec3<int>(0, 0, 0), 0));
+			group.voxels.push_back(Voxel(Vec3<int>(10, 0, 1), 1));
+			group.voxels.push_back(Voxel(Vec3<int>(20, 0, 1), 0));
+			group.voxels.push_back(Voxel(Vec3<int>(30, 0, 1), 1));
+			group.voxels.push_back(Voxel(Vec3<int>(40, 0, 1), 0));
+			group.voxels.push_back(Voxel(Vec3<int>(50, 0, 1), 1));
+			testBrickMeshMatchesArrayMesh(group, /*subsample_factor=*/1, mat_transparent);
+			testBrickMeshMatchesArrayMesh(group, /*subsample_factor=*/4, mat_transparent);
+		}
+
+		// Adjacent opaque-opaque, opaque-transparent, transparent-transparent voxels, within a brick and across brick boundaries.
+		for(int z=-1; z<=31; z += 32)
+		{
+			VoxelGroup group;
+			group.voxels.push_back(Voxel(Vec3<int>(0, 0, z), 0));
+			group.voxels.push_back(Voxel(Vec3<int>(0, 0, z + 1), 2));
+			group.voxels.push_back(Voxel(Vec3<int>(5, 0, z), 0));
+			group.voxels.push_back(Voxel(Vec3<int>(5, 0, z + 1), 1));
+			group.voxels.push_back(Voxel(Vec3<int>(10, 0, z), 1));
+			group.voxels.push_back(Voxel(Vec3<int>(10, 0, z + 1), 3));
+			group.voxels.push_back(Voxel(Vec3<int>(15, 0, z), 3));
+			group.voxels.push_back(Voxel(Vec3<int>(15, 0, z + 1), 3));
+			testBrickMeshMatchesArrayMesh(group, /*subsample_factor=*/1, mat_transparent);
+		}
+
+		// Voxels at edge of 256^3 region.
+		{
+			VoxelGroup group;
+			for(int i=0; i<8; ++i)
+				group.voxels.push_back(Voxel(Vec3<int>((i & 1) ? 255 : 0, (i & 2) ? 255 : 0, (i & 4) ? 255 : 0), 0));
+			testBrickMeshMatchesArrayMesh(group, /*subsample_factor=*/1, mat_transparent);
+		}
+
+		// Random voxels spanning several bricks, with negative coords, and several materials, some transparent.
+		{
+			PCG32 rng(1);
+			VoxelGroup group;
+			for(int z=-20; z<20; ++z)
+			for(int y=-10; y<30; ++y)
+			for(int x=-35; x<5; ++x)
+				if(rng.unitRandom() < 0.6f)
+					group.voxels.push_back(Voxel(Vec3<int>(x, y, z), (int)(rng.unitRandom() * 4.f) % 4));
+
+			testBrickMeshMatchesArrayMesh(group, /*subsample_factor=*/1, mat_transparent);
+			testBrickMeshMatchesArrayMesh(group, /*subsample_factor=*/2, mat_transparent);
+			testBrickMeshMatchesArrayMesh(group, /*subsample_factor=*/1, js::Vector<bool, 16>());
+		}
+
+		// Terrain-like object
+		{
+			VoxelGroup group;
+			makeTerrainVoxelGroup(/*size=*/100, group);
+			testBrickMeshMatchesArrayMesh(group, /*subsample_factor=*/1, mat_transparent);
+			testBrickMeshMatchesArrayMesh(group, /*subsample_factor=*/4, mat_transparent);
+		}
+
+		// Test invalid voxels are rejected.
+		{
+			VoxelGroup group;
+			group.voxels.push_back(Voxel(Vec3<int>(0, 0, 0), 255));
+			try
+			{
+				makeIndigoMeshForVoxelGroupWithBricks(group, /*subsample_factor=*/1, mat_transparent, /*allocator=*/NULL);
+				failTest("Expected exception");
+			}
+			catch(glare::Exception&)
+			{}
+
+			group.voxels[0] = Voxel(Vec3<int>(0, 40000, 0), 0);
+			try
+			{
+				makeIndigoMeshForVoxelGroupWithBricks(group, /*subsample_factor=*/1, mat_transparent, /*allocator=*/NULL);
+				failTest("Expected exception");
+			}
+			catch(glare::Exception&)
+			{}
+		}
+
+		// Compare meshing speed of the 3d-array mesher and the brick mesher.
+		{
+			VoxelGroup group;
+			makeTerrainVoxelGroup(/*size=*/256, group);
+
+			double array_time = 1.0e10, bricks_build_time = 1.0e10, bricks_mesh_time = 1.0e10;
+			size_t array_num_tris = 0, bricks_num_tris = 0;
+			for(int i=0; i<3; ++i)
+			{
+				{
+					Timer timer;
+					Reference<Indigo::Mesh> data = makeIndigoMeshForVoxelGroup(group, /*subsample_factor=*/1, mat_transparent, /*allocator=*/NULL);
+					array_time = myMin(array_time, timer.elapsed());
+					array_num_tris = data->triangles.size();
+				}
+				{
+					Timer timer;
+					VoxelBricks bricks;
+					bricks.build(group, /*subsample_factor=*/1);
+					bricks_build_time = myMin(bricks_build_time, timer.elapsed());
+
+					timer.reset();
+					Reference<Indigo::Mesh> data = makeIndigoMeshForVoxelBricks(bricks, mat_transparent, /*allocator=*/NULL);
+					bricks_mesh_time = myMin(bricks_mesh_time, timer.elapsed());
+					bricks_num_tris = data->triangles.size();
+				}
+			}
+
+			conPrint("Terrain with " + toString(group.voxels.size()) + " voxels:");
+			conPrint("    3d-array meshing:   " + doubleToStringNSigFigs(array_time * 1.0e3, 4) + " ms, " + toString(array_num_tris) + " tris");
+			conPrint("    brick building:     " + doubleToStringNSigFigs(bricks_build_time * 1.0e3, 4) + " ms");
+			conPrint("    brick meshing:      " + doubleToStringNSigFigs(bricks_mesh_time * 1.0e3, 4) + " ms, " + toString(bricks_num_tris) + " tris");
+		}
+	}
+
+	//------------------------ Test makeIndigoMeshWithShadingNormalsForVoxelGroup() ------------------------
+	{
+		js::Vector<bool, 16> mat_transparent;
+
+		// Meshing in parallel slabs should give exactly the same mesh as meshing serially.
+		{
+			VoxelGroup group;
+			group.voxels.push_back(Voxel(Vec3<int>(0, 0, 0), 0));
+			testShadingNormalsMeshesEqual(group, /*subsample_factor=*/1, task_manager);
+		}
+		{
+			VoxelGroup group;
+			makeTerrainVoxelGroup(/*size=*/100, group);
+			testShadingNormalsMeshesEqual(group, /*subsample_factor=*/1, task_manager);
+			testShadingNormalsMeshesEqual(group, /*subsample_factor=*/2, task_manager);
+		}
+		{
+			PCG32 rng(1);
+			VoxelGroup group;
+			for(int i=0; i<20000; ++i)
+				group.voxels.push_back(Voxel(Vec3<int>((int)(rng.unitRandom() * 60) - 30, (int)(rng.unitRandom() * 60) - 30, (int)(rng.unitRandom() * 60) - 30), (int)(rng.unitRandom() * 4)));
+			testShadingNormalsMeshesEqual(group, /*subsample_factor=*/1, task_manager);
+		}
+
+		// Compare meshing speed with and without the task manager.
+		{
+			VoxelGroup group;
+			makeTerrainVoxelGroup(/*size=*/256, group);
+
+			double serial_time = 1.0e10, parallel_time = 1.0e10;
+			size_t num_tris = 0;
+			for(int i=0; i<3; ++i)
+			{
+				{
+					Timer timer;
+					Reference<Indigo::Mesh> data = makeIndigoMeshWithShadingNormalsForVoxelGroup(group, /*subsample_factor=*/1, mat_transparent, /*task_manager=*/NULL, /*allocator=*/NULL);
+					serial_time = myMin(serial_time, timer.elapsed());
+					num_tris = data->triangles.size();
+				}
+				{
+					Timer timer;
+					Reference<Indigo::Mesh> data = makeIndigoMeshWithShadingNormalsForVoxelGroup(group, /*subsample_factor=*/1, mat_transparent, &task_manager, /*allocator=*/NULL);
+					parallel_time = myMin(parallel_time, timer.elapsed());
+				}
+			}
+
+			conPrint("Shading normals meshing of terrain with " + toString(group.voxels.size()) + " voxels (" + toString(num_tris) + " tris):");
+			conPrint("    serial:   " + doubleToStringNSigFigs(serial_time * 1.0e3, 4) + " ms");
+			conPrint("    parallel: " + doubleToStringNSigFigs(parallel_time * 1.0e3, 4) + " ms (" + toString(task_manager.getNumThreads()) + " threads, speedup: " + doubleToStringNSigFigs(serial_time / parallel_time, 3) + "x)");
+		}
+	}
+
+	
+
 	// Performance test
 	if(false)
 	{
@@ -1472,6 +2199,15 @@ void VoxelMeshBuilding::test()
 					conPrint("Meshing of " + toString(group.voxels.size()) + " voxels with subsample_factor=2 took " + timer.elapsedString());
 					conPrint("Resulting num tris: " + toString(data->triangles.size()));
 				}
+
+				{
+					Timer timer;
+
+					Reference<Indigo::Mesh> data = makeIndigoMeshForVoxelGroupWithBricks(group, /*subsample_factor=*/1, mat_transparent, /*allocator=*/NULL);
+
+					conPrint("Brick meshing of " + toString(group.voxels.size()) + " voxels with subsample_factor=1 took " + timer.elapsedString());
+					conPrint("Resulting num tris: " + toString(data->triangles.size()));
+				}
 			}
 
 			if(false)
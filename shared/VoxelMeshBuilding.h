@@ -10,7 +10,9 @@ Copyright Glare Technologies Limited 2022 -
 #include <maths/vec3.h>
 #include <utils/Vector.h>
 class VoxelGroup;
+class VoxelBricks;
 namespace glare { class Allocator; }
+namespace glare { class TaskManager; }
 
 
 /*=====================================================================
@@ -27,9 +29,24 @@ public:
 		glare::Allocator* mem_allocator);
 
 
+	// Builds a mesh in the same format as makeIndigoMeshForVoxelGroup(), using binary greedy meshing on the 64-bit voxel column masks of each brick.
+	// The same faces are covered as with makeIndigoMeshForVoxelGroup(), but quads are not merged across brick boundaries.
+	static Reference<Indigo::Mesh> makeIndigoMeshForVoxelBricks(const VoxelBricks& bricks, const js::Vector<bool, 16>& mats_transparent, glare::Allocator* mem_allocator);
+
+	// Builds a mesh of just the faces of the voxels in the brick at brick_coords, with voxels in adjacent bricks taken into account for face culling.
+	// Meshing all bricks separately like this gives the same quads as makeIndigoMeshForVoxelBricks(), so can be used to re-mesh just the bricks affected by an edit.
+	// Returns a NULL reference if there are no faces.
+	static Reference<Indigo::Mesh> makeIndigoMeshForVoxelBrick(const VoxelBricks& bricks, const Vec3<int>& brick_coords, const js::Vector<bool, 16>& mats_transparent, glare::Allocator* mem_allocator);
+
+	// Converts the voxel group to bricks, then calls makeIndigoMeshForVoxelBricks().
+	static Reference<Indigo::Mesh> makeIndigoMeshForVoxelGroupWithBricks(const VoxelGroup& voxel_group, const int subsample_factor, const js::Vector<bool, 16>& mats_transparent,
+		glare::Allocator* mem_allocator);
+
+
 	// Build a mesh with shading normals and UVs.  This is used in ChunkGenThread.
+	// If task_manager is non-NULL, slabs of each material and axis are meshed in parallel on it.  The resulting mesh is the same either way.
 	static Reference<Indigo::Mesh> makeIndigoMeshWithShadingNormalsForVoxelGroup(const VoxelGroup& voxel_group, const int subsample_factor, const js::Vector<bool, 16>& mats_transparent,
-		glare::Allocator* mem_allocator);
+		glare::TaskManager* task_manager, glare::Allocator* mem_allocator);
 
 	static void test();
 };
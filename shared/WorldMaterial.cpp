@@ -281,13 +281,13 @@ void WorldMaterial::appendDependencyURLsBaseLevel(const GetURLOptions& options,
 
 void WorldMaterial::convertLocalPathsToURLS(ResourceManager& resource_manager)
 {
-	if(FileUtils::fileExists(this->colour_texture_url)) // If the URL is a local path:
+	if(FileUtils::fileExists(this->colour_texture_url.str())) // If the URL is a local path:
 		this->colour_texture_url = resource_manager.URLForPathAndHash(toStdString(this->colour_texture_url), FileChecksum::fileChecksum(this->colour_texture_url));
 	
-	if(FileUtils::fileExists(this->emission_texture_url)) // If the URL is a local path:
+	if(FileUtils::fileExists(this->emission_texture_url.str())) // If the URL is a local path:
 		this->emission_texture_url = resource_manager.URLForPathAndHash(toStdString(this->emission_texture_url), FileChecksum::fileChecksum(this->emission_texture_url));
 	
-	if(FileUtils::fileExists(this->normal_map_url)) // If the URL is a local path:
+	if(FileUtils::fileExists(this->normal_map_url.str())) // If the URL is a local path:
 		this->normal_map_url = resource_manager.URLForPathAndHash(toStdString(this->normal_map_url), FileChecksum::fileChecksum(this->normal_map_url));
 
 	roughness.convertLocalPathsToURLS(resource_manager);
@@ -318,6 +318,13 @@ static void convertRelPathToAbsolute(const std::string& mat_file_path, URLString
 }
 
 
+static void convertRelPathToAbsolute(const std::string& mat_file_path, URLAtom& relative_path_in_out)
+{
+	if(!relative_path_in_out.empty())
+		relative_path_in_out = FileUtils::join(FileUtils::getDirectory(mat_file_path), toStdString(relative_path_in_out));
+}
+
+
 Reference<WorldMaterial> WorldMaterial::loadFromXMLElem(const std::string& mat_file_path, bool convert_rel_paths_to_abs_disk_paths, pugi::xml_node material_elem)
 {
 	WorldMaterialRef mat = new WorldMaterial();
@@ -385,12 +392,12 @@ std::string WorldMaterial::serialiseToXML(int tab_depth) const
 	XMLWriteUtils::writeStringElemToXML(s, "name", name, tab_depth + 1);
 
 	XMLWriteUtils::writeColour3fToXML(s, "colour_rgb", colour_rgb, tab_depth + 1);
-	XMLWriteUtils::writeStringElemToXML(s, "colour_texture_url", colour_texture_url, tab_depth + 1);
+	XMLWriteUtils::writeStringElemToXML(s, "colour_texture_url", colour_texture_url.str(), tab_depth + 1);
 
 	XMLWriteUtils::writeColour3fToXML(s, "emission_rgb", emission_rgb, tab_depth + 1);
-	XMLWriteUtils::writeStringElemToXML(s, "emission_texture_url", emission_texture_url, tab_depth + 1);
+	XMLWriteUtils::writeStringElemToXML(s, "emission_texture_url", emission_texture_url.str(), tab_depth + 1);
 	
-	XMLWriteUtils::writeStringElemToXML(s, "normal_map_url", normal_map_url, tab_depth + 1);
+	XMLWriteUtils::writeStringElemToXML(s, "normal_map_url", normal_map_url.str(), tab_depth + 1);
 
 	writeScalarValToXML(s, "roughness", roughness, tab_depth + 1);
 	writeScalarValToXML(s, "metallic_fraction", metallic_fraction, tab_depth + 1);
@@ -453,10 +460,10 @@ void writeWorldMaterialToStream(const WorldMaterial& mat, RandomAccessOutStream&
 	stream.writeUInt32(0); // Size of buffer will be written here later
 
 	writeToStream(stream, mat.colour_rgb);
-	stream.writeStringLengthFirst(mat.colour_texture_url);
+	stream.writeStringLengthFirst(mat.colour_texture_url.str());
 
 	writeToStream(stream, mat.emission_rgb);
-	stream.writeStringLengthFirst(mat.emission_texture_url);
+	stream.writeStringLengthFirst(mat.emission_texture_url.str());
 
 	writeScalarValToStream(mat.roughness, stream);
 	writeScalarValToStream(mat.metallic_fraction, stream);
@@ -468,7 +475,7 @@ void writeWorldMaterialToStream(const WorldMaterial& mat, RandomAccessOutStream&
 
 	stream.writeUInt32(mat.flags);
 
-	stream.writeStringLengthFirst(mat.normal_map_url);
+	stream.writeStringLengthFirst(mat.normal_map_url.str());
 
 
 	// Go back and write size of buffer to buffer size field
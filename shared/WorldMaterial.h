@@ -7,6 +7,7 @@ Copyright Glare Technologies Limited 2023 -
 
 
 #include "DependencyURL.h"
+#include "URLAtom.h"
 #if GUI_CLIENT
 #include <opengl/OpenGLTextureKey.h>
 #endif
@@ -78,12 +79,12 @@ public:
 	// NOTE: If adding new member variables, make sure to add to clone() and operator ==() below.
 
 	Colour3f colour_rgb; // Non-linear sRGB
-	URLString colour_texture_url;
+	URLAtom colour_texture_url; // Texture URLs are interned, as many materials share the same textures.  See URLAtom.
 
 	Colour3f emission_rgb; // Non-linear sRGB
-	URLString emission_texture_url;
+	URLAtom emission_texture_url;
 
-	URLString normal_map_url;
+	URLAtom normal_map_url;
 
 	ScalarVal roughness; // Metallic-roughness texture URL will be stored in roughness.texture_url.
 	ScalarVal metallic_fraction;
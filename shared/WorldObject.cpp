@@ -23,6 +23,7 @@ Copyright Glare Technologies Limited 2016 -
 #include "../shared/ResourceManager.h"
 #include "../shared/LuaScriptEvaluator.h"
 #include "../shared/ObjectEventHandlers.h"
+#include "../shared/VoxelCodec.h"
 #include <utils/Exception.h>
 #include <utils/StringUtils.h>
 #include <utils/FileUtils.h>
@@ -439,16 +440,16 @@ void WorldObject::getDependencyURLSetBaseLevel(const GetDependencyOptions& optio
 
 void WorldObject::convertLocalPathsToURLS(ResourceManager& resource_manager)
 {
-	if(FileUtils::fileExists(this->model_url)) // If the URL is a local path:
+	if(FileUtils::fileExists(this->model_url.str())) // If the URL is a local path:
 		this->model_url = resource_manager.URLForPathAndHash(toStdString(this->model_url), FileChecksum::fileChecksum(this->model_url));
 
 	for(size_t i=0; i<materials.size(); ++i)
 		materials[i]->convertLocalPathsToURLS(resource_manager);
 
-	if(FileUtils::fileExists(this->lightmap_url)) // If the URL is a local path:
+	if(FileUtils::fileExists(this->lightmap_url.str())) // If the URL is a local path:
 		this->lightmap_url = resource_manager.URLForPathAndHash(toStdString(this->lightmap_url), FileChecksum::fileChecksum(this->lightmap_url));
 
-	if(FileUtils::fileExists(this->audio_source_url)) // If the URL is a local path:
+	if(FileUtils::fileExists(this->audio_source_url.str())) // If the URL is a local path:
 		this->audio_source_url = resource_manager.URLForPathAndHash(toStdString(this->audio_source_url), FileChecksum::fileChecksum(this->audio_source_url));
 }
 
@@ -600,19 +601,19 @@ void WorldObject::writeToStream(RandomAccessOutStream& stream) const
 
 	::writeToStream(uid, stream);
 	stream.writeUInt32((uint32)object_type);
-	stream.writeStringLengthFirst(model_url);
+	stream.writeStringLengthFirst(model_url.str());
 
 	// Write materials
 	stream.writeUInt32((uint32)materials.size());
 	for(size_t i=0; i<materials.size(); ++i)
 		::writeWorldMaterialToStream(*materials[i], stream);
 
-	stream.writeStringLengthFirst(lightmap_url); // new in v13
+	stream.writeStringLengthFirst(lightmap_url.str()); // new in v13
 
 	stream.writeStringLengthFirst(script);
 	stream.writeStringLengthFirst(content);
 	stream.writeStringLengthFirst(target_url);
-	stream.writeStringLengthFirst(audio_source_url);
+	stream.writeStringLengthFirst(audio_source_url.str());
 	stream.writeFloat(audio_volume);
 
 	::writeToStream(pos, stream);
@@ -853,19 +854,19 @@ void WorldObject::writeToNetworkStream(RandomAccessOutStream& stream) const // W
 {
 	::writeToStream(uid, stream);
 	stream.writeUInt32((uint32)object_type);
-	stream.writeStringLengthFirst(model_url);
+	stream.writeStringLengthFirst(model_url.str());
 
 	// Write materials
 	stream.writeUInt32((uint32)materials.size());
 	for(size_t i=0; i<materials.size(); ++i)
 		::writeWorldMaterialToStream(*materials[i], stream);
 
-	stream.writeStringLengthFirst(lightmap_url); // new in v13
+	stream.writeStringLengthFirst(lightmap_url.str()); // new in v13
 
 	stream.writeStringLengthFirst(script);
 	stream.writeStringLengthFirst(content);
 	stream.writeStringLengthFirst(target_url);
-	stream.writeStringLengthFirst(audio_source_url);
+	stream.writeStringLengthFirst(audio_source_url.str());
 	stream.writeFloat(audio_volume);
 
 	::writeToStream(pos, stream);
@@ -982,7 +983,7 @@ std::string WorldObject::serialiseToXML(int tab_depth) const
 
 	XMLWriteUtils::writeUInt64ToXML(s, "uid", uid.value(), tab_depth + 1);
 	XMLWriteUtils::writeStringElemToXML(s, "object_type", objectTypeString(object_type), tab_depth + 1);
-	XMLWriteUtils::writeStringElemToXML(s, "model_url", model_url, tab_depth + 1);
+	XMLWriteUtils::writeStringElemToXML(s, "model_url", model_url.str(), tab_depth + 1);
 
 	// Write materials
 	s += std::string(tab_depth + 1, '\t') + "<materials>\n";
@@ -990,12 +991,12 @@ std::string WorldObject::serialiseToXML(int tab_depth) const
 		s += materials[i]->serialiseToXML(tab_depth + 2);
 	s += std::string(tab_depth + 1, '\t') + "</materials>\n";
 
-	XMLWriteUtils::writeStringElemToXML(s, "lightmap_url", lightmap_url, tab_depth + 1);
+	XMLWriteUtils::writeStringElemToXML(s, "lightmap_url", lightmap_url.str(), tab_depth + 1);
 
 	XMLWriteUtils::writeStringElemToXML(s, "script", script, tab_depth + 1);
 	XMLWriteUtils::writeStringElemToXML(s, "content", content, tab_depth + 1);
 	XMLWriteUtils::writeStringElemToXML(s, "target_url", target_url, tab_depth + 1);
-	XMLWriteUtils::writeStringElemToXML(s, "audio_source_url", audio_source_url, tab_depth + 1);
+	XMLWriteUtils::writeStringElemToXML(s, "audio_source_url", audio_source_url.str(), tab_depth + 1);
 
 	XMLWriteUtils::writeFloatToXML(s, "audio_volume", audio_volume, tab_depth + 1);
 
@@ -1424,6 +1425,13 @@ Reference<glare::SharedImmutableArray<uint8> > WorldObject::compressVoxelGroup(c
 
 void WorldObject::decompressVoxelGroup(const uint8* compressed_data, size_t compressed_data_len, glare::Allocator* mem_allocator, VoxelGroup& group_out)
 {
+	// Data in version 2 or later formats starts with a header, see VoxelCodec.
+	if(VoxelCodec::getFormatVersion(compressed_data, compressed_data_len) != 1)
+	{
+		VoxelCodec::decode(compressed_data, compressed_data_len, mem_allocator, group_out);
+		return;
+	}
+
 	group_out.voxels.clear();
 
 	const uint64 decompressed_size = ZSTD_getFrameContentSize(compressed_data, compressed_data_len);
@@ -8,6 +8,7 @@ Copyright Glare Technologies Limited 2016 -
 
 #include "DependencyURL.h"
 #include "WorldMaterial.h"
+#include "URLAtom.h"
 #include "../shared/UID.h"
 #include "../shared/UserID.h"
 #include <utils/TimeStamp.h>
@@ -219,8 +220,8 @@ public:
 
 	static int getLightMapSideResForAABBWS(const js::AABBox& aabb_ws);
 
-	static Reference<glare::SharedImmutableArray<uint8> > compressVoxelGroup(const VoxelGroup& group);
-	static void decompressVoxelGroup(const uint8* compressed_data, size_t compressed_data_len, glare::Allocator* mem_allocator, VoxelGroup& group_out);
+	static Reference<glare::SharedImmutableArray<uint8> > compressVoxelGroup(const VoxelGroup& group); // Writes the version 1 format, see VoxelCodec.
+	static void decompressVoxelGroup(const uint8* compressed_data, size_t compressed_data_len, glare::Allocator* mem_allocator, VoxelGroup& group_out); // Decodes version 1 or later formats.
 	void compressVoxels();
 	void decompressVoxels();
 	void clearDecompressedVoxels();
@@ -306,9 +307,9 @@ public:
 	static const size_t MAX_CONTENT_SIZE                  = 10000;
 	
 
-	URLString model_url;
+	URLAtom model_url; // Interned, as many objects share the same models.  See URLAtom.
 	std::vector<WorldMaterialRef> materials;
-	URLString lightmap_url;
+	URLAtom lightmap_url;
 	std::string script;
 	std::string content; // For ObjectType_Hypercard, ObjectType_Text
 	std::string target_url;
@@ -359,7 +360,7 @@ public:
 #if GUI_CLIENT
 	Reference<glare::AudioSource> audio_source;
 #endif
-	URLString audio_source_url;
+	URLAtom audio_source_url;
 	float audio_volume;
 
 	enum State
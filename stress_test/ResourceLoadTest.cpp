@@ -0,0 +1,193 @@
+/*=====================================================================
+ResourceLoadTest.cpp
+--------------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#include "ResourceLoadTest.h"
+
+
+#include <networking/networking.h>
+#include <networking/TLSSocket.h>
+#include <maths/mathstypes.h>
+#include <MyThread.h>
+#include <PCG32.h>
+#include <Timer.h>
+#include <ConPrint.h>
+#include <Exception.h>
+#include <StringUtils.h>
+#include <Reference.h>
+#include <algorithm>
+
+
+namespace ResourceLoadTest
+{
+
+
+class ResourceLoadThread : public MyThread
+{
+public:
+	virtual void run()
+	{
+		try
+		{
+			MySocketRef plain_socket = new MySocket();
+			plain_socket->connect(args->hostname, args->port);
+
+			SocketInterfaceRef socket = new TLSSocket(plain_socket, client_tls_config, args->hostname);
+
+			PCG32 rng(seed);
+			Timer total_timer;
+			std::string request_batch;
+
+			while(total_timer.elapsed() < args->duration_s)
+			{
+				// Write a batch of requests with a single write, so they are pipelined.
+				request_batch.clear();
+				for(int i=0; i<args->pipeline_depth; ++i)
+				{
+					const size_t URL_index = myMin(args->resource_URLs.size() - 1, (size_t)(rng.unitRandom() * args->resource_URLs.size()));
+					request_batch +=
+						"GET /resource/" + args->resource_URLs[URL_index] + " HTTP/1.1\r\n"
+						"Host: " + args->hostname + "\r\n"
+						"Connection: keep-alive\r\n"
+						"\r\n";
+				}
+
+				Timer batch_timer;
+				socket->writeData(request_batch.data(), request_batch.size());
+
+				// Read the responses, which come back in request order.
+				for(int i=0; i<args->pipeline_depth; ++i)
+				{
+					const int status = readResponse(*socket);
+					latencies.push_back(batch_timer.elapsed());
+					if(status == 200)
+						num_ok++;
+					else
+						num_errors++;
+				}
+			}
+		}
+		catch(glare::Exception& e)
+		{
+			conPrint("ResourceLoadThread error: " + e.what());
+			connection_failed = true;
+		}
+	}
+
+	// Reads a single response, returns the status code.  Leaves any following pipelined response data in read_buf.
+	int readResponse(SocketInterface& socket)
+	{
+		size_t header_end;
+		while((header_end = read_buf.find("\r\n\r\n")) == std::string::npos)
+		{
+			if(read_buf.size() > 64 * 1024)
+				throw glare::Exception("Response header too long");
+			readMore(socket);
+		}
+
+		// Parse status line, e.g. "HTTP/1.1 200 OK"
+		const size_t status_start = read_buf.find(' ');
+		if(status_start == std::string::npos || status_start > header_end)
+			throw glare::Exception("Invalid status line");
+		const int status = stringToInt(read_buf.substr(status_start + 1, 3));
+
+		// Find Content-Length
+		size_t content_length = 0;
+		const std::string header = toLowerCase(read_buf.substr(0, header_end));
+		const size_t content_length_pos = header.find("\r\ncontent-length:");
+		if(content_length_pos != std::string::npos)
+		{
+			const size_t value_start = content_length_pos + std::string("\r\ncontent-length:").size();
+			const size_t value_end = header.find("\r\n", value_start);
+			content_length = (size_t)myMax(0, stringToInt(stripHeadAndTailWhitespace(header.substr(value_start, value_end - value_start))));
+		}
+
+		const size_t response_size = header_end + 4 + content_length;
+		while(read_buf.size() < response_size)
+			readMore(socket);
+
+		num_bytes_read += response_size;
+		read_buf.erase(0, response_size);
+		return status;
+	}
+
+	void readMore(SocketInterface& socket)
+	{
+		char buf[64 * 1024];
+		const size_t num_read = socket.readSomeBytes(buf, sizeof(buf));
+		if(num_read == 0)
+			throw glare::Exception("Connection closed by server");
+		read_buf.append(buf, num_read);
+	}
+
+	const ResourceLoadTestArgs* args;
+	struct tls_config* client_tls_config;
+	int seed;
+
+	std::string read_buf;
+	std::vector<double> latencies; // Time from writing the request batch to reading each response.
+	size_t num_ok = 0;
+	size_t num_errors = 0;
+	size_t num_bytes_read = 0;
+	bool connection_failed = false;
+};
+
+
+static double getPercentile(const std::vector<double>& sorted_vals, double p)
+{
+	if(sorted_vals.empty())
+		return 0;
+	const size_t i = myMin(sorted_vals.size() - 1, (size_t)(p * sorted_vals.size()));
+	return sorted_vals[i];
+}
+
+
+void runResourceLoadTest(const ResourceLoadTestArgs& args, struct tls_config* client_tls_config)
+{
+	if(args.resource_URLs.empty())
+		throw glare::Exception("No resource URLs given");
+
+	conPrint("Running resource load test against " + args.hostname + ":" + toString(args.port) + " with " + toString(args.num_connections) + " connections, pipeline depth " +
+		toString(args.pipeline_depth) + ", " + toString(args.resource_URLs.size()) + " URLs...");
+
+	Timer timer;
+	std::vector<Reference<ResourceLoadThread>> threads;
+	for(int i=0; i<args.num_connections; ++i)
+	{
+		Reference<ResourceLoadThread> t = new ResourceLoadThread();
+		t->args = &args;
+		t->client_tls_config = client_tls_config;
+		t->seed = i;
+		t->launch();
+		threads.push_back(t);
+	}
+
+	std::vector<double> latencies;
+	size_t num_ok = 0;
+	size_t num_errors = 0;
+	size_t num_bytes_read = 0;
+	size_t num_failed_connections = 0;
+	for(size_t i=0; i<threads.size(); ++i)
+	{
+		threads[i]->join();
+		latencies.insert(latencies.end(), threads[i]->latencies.begin(), threads[i]->latencies.end());
+		num_ok += threads[i]->num_ok;
+		num_errors += threads[i]->num_errors;
+		num_bytes_read += threads[i]->num_bytes_read;
+		if(threads[i]->connection_failed)
+			num_failed_connections++;
+	}
+	const double elapsed = timer.elapsed();
+
+	std::sort(latencies.begin(), latencies.end());
+
+	conPrint("Resource load test done in " + doubleToStringNSigFigs(elapsed, 4) + " s.");
+	conPrint("Responses: " + toString(num_ok) + " OK, " + toString(num_errors) + " non-200, " + toString(num_failed_connections) + " failed connections.");
+	conPrint("Requests/s: " + doubleToStringNSigFigs(latencies.size() / elapsed, 4) + ", throughput: " + doubleToStringNSigFigs(num_bytes_read / elapsed * 1.0e-6, 4) + " MB/s");
+	conPrint("Latency: p50: " + doubleToStringNSigFigs(getPercentile(latencies, 0.5) * 1.0e3, 4) + " ms, p90: " + doubleToStringNSigFigs(getPercentile(latencies, 0.9) * 1.0e3, 4) +
+		" ms, p99: " + doubleToStringNSigFigs(getPercentile(latencies, 0.99) * 1.0e3, 4) + " ms");
+}
+
+
+} // end namespace ResourceLoadTest
@@ -0,0 +1,39 @@
+/*=====================================================================
+ResourceLoadTest.h
+------------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#pragma once
+
+
+#include <string>
+#include <vector>
+struct tls_config;
+
+
+/*=====================================================================
+ResourceLoadTest
+----------------
+Load test for the webserver /resource/ handler.
+
+Simulates many webclients loading resources at once: each connection is
+a keep-alive HTTPS connection, on which batches of pipeline_depth GET
+requests are written at once, then the responses are read in order.
+Prints requests/s, throughput and the response latency distribution.
+=====================================================================*/
+namespace ResourceLoadTest
+{
+
+struct ResourceLoadTestArgs
+{
+	std::string hostname;
+	int port;
+	std::vector<std::string> resource_URLs; // Resource URLs, without the /resource/ prefix.
+	int num_connections;
+	int pipeline_depth; // Number of requests written before reading the responses.
+	double duration_s;
+};
+
+void runResourceLoadTest(const ResourceLoadTestArgs& args, struct tls_config* client_tls_config);
+
+} // end namespace ResourceLoadTest
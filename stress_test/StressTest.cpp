@@ -8,6 +8,7 @@ Copyright Glare Technologies Limited 2021 -
 #include "../shared/Protocol.h"
 #include "../shared/UID.h"
 #include "../shared/Avatar.h"
+#include "ResourceLoadTest.h"
 #include <networking/networking.h>
 #include <networking/TLSSocket.h>
 #include <networking/url.h>
@@ -248,6 +249,38 @@ int main(int argc, char* argv[])
 	tls_config_insecure_noverifyname(client_tls_config);
 
 
+	// Usage: stress_test --resource_load_test hostname URL_list_path [num_connections] [pipeline_depth]
+	// where URL_list_path is a text file with one resource URL per line.
+	if(argc >= 4 && std::string(argv[1]) == "--resource_load_test")
+	{
+		try
+		{
+			ResourceLoadTest::ResourceLoadTestArgs args;
+			args.hostname = argv[2];
+			args.port = 443;
+			args.num_connections = (argc >= 5) ? stringToInt(argv[4]) : 100;
+			args.pipeline_depth = (argc >= 6) ? stringToInt(argv[5]) : 6;
+			args.duration_s = 30;
+
+			const std::vector<std::string> lines = ::split(FileUtils::readEntireFileTextMode(argv[3]), '\n');
+			for(size_t i=0; i<lines.size(); ++i)
+			{
+				const std::string URL = stripHeadAndTailWhitespace(lines[i]);
+				if(!URL.empty())
+					args.resource_URLs.push_back(URL);
+			}
+
+			ResourceLoadTest::runResourceLoadTest(args, client_tls_config);
+		}
+		catch(glare::Exception& e)
+		{
+			conPrint("Error: " + e.what());
+			return 1;
+		}
+		return 0;
+	}
+
+
 	const int NUM_THREADS = 300;
 	std::vector<Reference<StressTestBotThread>> threads;
 	for(int i=0; i<NUM_THREADS; ++i)
@@ -30,6 +30,8 @@ Copyright Glare Technologies Limited 2022 -
 #include "WorldHandlers.h"
 #include "LoginHandlers.h"
 #include "../server/ServerWorldState.h"
+#include "../shared/LuaScriptEvaluator.h"
+#include "../shared/SubstrataLuaVM.h"
 #include "../server/UserWebSession.h"
 #include "../server/SubEthTransaction.h"
 #include "../ethereum/Signing.h"
@@ -53,7 +55,7 @@ void renderUserAccountPage(ServerAllWorldsState& world_state, const web::Request
 			page += WebServerResponseUtils::standardHTMLHeader(*world_state.web_data_store, request, "User Account");
 			page += "You must be logged in to view your user account page.";
 			page += WebServerResponseUtils::standardFooter(request, /*include_email_link=*/true);
-			web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+			WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 			return;
 		}
 
@@ -156,7 +158,7 @@ void renderUserAccountPage(ServerAllWorldsState& world_state, const web::Request
 
 	page += WebServerResponseUtils::standardFooter(request, /*include_email_link=*/true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 }
 
 
@@ -173,7 +175,7 @@ void renderProveEthAddressOwnerPage(ServerAllWorldsState& world_state, const web
 			page += WebServerResponseUtils::standardHTMLHeader(*world_state.web_data_store, request, "User Account");
 			page += "You must be logged in to view your user account page.";
 			page += WebServerResponseUtils::standardFooter(request, /*include_email_link=*/true);
-			web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+			WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 			return;
 		}
 
@@ -218,7 +220,7 @@ void renderProveEthAddressOwnerPage(ServerAllWorldsState& world_state, const web
 
 	page += WebServerResponseUtils::standardFooter(request, /*include_email_link=*/true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 }
 
 
@@ -235,7 +237,7 @@ void renderProveParcelOwnerByNFT(ServerAllWorldsState& world_state, const web::R
 			page += WebServerResponseUtils::standardHTMLHeader(*world_state.web_data_store, request, "User Account");
 			page += "You must be logged in to view this page.";
 			page += WebServerResponseUtils::standardFooter(request, /*include_email_link=*/true);
-			web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+			WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 			return;
 		}
 
@@ -268,7 +270,7 @@ void renderProveParcelOwnerByNFT(ServerAllWorldsState& world_state, const web::R
 
 	page += WebServerResponseUtils::standardFooter(request, /*include_email_link=*/true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 }
 
 
@@ -339,7 +341,7 @@ void renderMakeParcelIntoNFTPage(ServerAllWorldsState& world_state, const web::R
 			page += WebServerResponseUtils::standardHTMLHeader(*world_state.web_data_store, request, "User Account");
 			page += "You must be logged in to view this page.";
 			page += WebServerResponseUtils::standardFooter(request, /*include_email_link=*/true);
-			web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+			WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 			return;
 		}
 
@@ -389,7 +391,7 @@ void renderMakeParcelIntoNFTPage(ServerAllWorldsState& world_state, const web::R
 
 	page += WebServerResponseUtils::standardFooter(request, /*include_email_link=*/true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 }
 
 
@@ -405,7 +407,7 @@ void renderParcelClaimSucceeded(ServerAllWorldsState& world_state, const web::Re
 
 	page += WebServerResponseUtils::standardFooter(request, /*include_email_link=*/true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 }
 
 
@@ -426,7 +428,7 @@ void renderParcelClaimFailed(ServerAllWorldsState& world_state, const web::Reque
 
 	page += WebServerResponseUtils::standardFooter(request, /*include_email_link=*/true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 }
 
 
@@ -446,7 +448,7 @@ void renderParcelClaimInvalid(ServerAllWorldsState& world_state, const web::Requ
 
 	page += WebServerResponseUtils::standardFooter(request, /*include_email_link=*/true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 }
 
 
@@ -470,7 +472,7 @@ void renderMakingParcelIntoNFT(ServerAllWorldsState& world_state, const web::Req
 
 	page += WebServerResponseUtils::standardFooter(request, /*include_email_link=*/true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 }
 
 
@@ -489,7 +491,7 @@ void renderMakingParcelIntoNFTFailed(ServerAllWorldsState& world_state, const we
 
 	page += WebServerResponseUtils::standardFooter(request, /*include_email_link=*/true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 }
 
 
@@ -689,7 +691,7 @@ void renderScriptLog(ServerAllWorldsState& world_state, const web::RequestInfo&
 	Reference<UserScriptLog> log;
 
 	{ // lock scope
-		Lock lock(world_state.mutex);
+		WorldStateLock lock(world_state.mutex);
 
 		User* logged_in_user = LoginHandlers::getLoggedInUser(world_state, request);
 		if(logged_in_user == NULL)
@@ -697,7 +699,7 @@ void renderScriptLog(ServerAllWorldsState& world_state, const web::RequestInfo&
 			page += WebServerResponseUtils::standardHeader(world_state, request, /*page title=*/"Script log");
 			page += "You must be logged in to view this page.";
 			page += WebServerResponseUtils::standardFooter(request, /*include_email_link=*/true);
-			web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+			WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 			return;
 		}
 
@@ -706,6 +708,36 @@ void renderScriptLog(ServerAllWorldsState& world_state, const web::RequestInfo&
 
 		page += "<p>Showing output and error messages for all scripts created by <a href=\"/account\">" + web::Escaping::HTMLEscape(logged_in_user->name) + "</a>.</p>";
 
+		// Show execution stats for each of the user's running scripts.
+		// The user's scripts all run in the user's Lua VM, which keeps track of its script evaluators, so we don't need to scan all objects.
+		{
+			std::string stats_html;
+			auto vm_res = world_state.lua_vms.find(logged_in_user->id);
+			if(vm_res != world_state.lua_vms.end())
+			{
+				SubstrataLuaVM* lua_vm = vm_res->second.ptr();
+				Lock evaluators_lock(lua_vm->script_evaluators_mutex);
+				for(auto it = lua_vm->script_evaluators.begin(); it != lua_vm->script_evaluators.end(); ++it)
+				{
+					const LuaScriptEvaluator* evaluator = it->first;
+					const LuaScriptExecStats& stats = evaluator->exec_stats;
+					const std::string status = evaluator->hit_error ? "disabled" : (evaluator->isThrottled() ? "throttled" : "running");
+
+					stats_html += "<tr><td>ob " + it->second.toString() + "</td><td>" + status + "</td><td>" + toString(stats.num_callbacks) + "</td><td>" + doubleToStringNSigFigs(stats.total_exec_time_s * 1000, 4) + " ms</td>" + 
+						"<td>" + toString(stats.num_budget_overruns) + "</td><td>" + toString(stats.num_throttle_events) + "</td><td>" + toString(stats.num_throttled_callbacks) + "</td><td>" + getNiceByteSize(stats.total_heap_growth_B) + "</td></tr>\n";
+				}
+			}
+
+			if(!stats_html.empty())
+			{
+				page += "<p>Each script callback may run for at most " + toString((int)(LuaScriptEvaluator::CALLBACK_TIME_BUDGET_S * 1000)) + " ms, and a script may use at most " + 
+					toString((int)(LuaScriptEvaluator::WINDOW_EXEC_TIME_BUDGET_S * 1000)) + " ms of execution time every " + toString((int)LuaScriptEvaluator::BUDGET_WINDOW_S) + " s.  Scripts that exceed this are throttled.</p>";
+				page += "<table><tr><th>Script</th><th>Status</th><th>Callbacks</th><th>Total exec time</th><th>Budget overruns</th><th>Throttle events</th><th>Throttled callbacks</th><th>Heap growth</th></tr>\n";
+				page += stats_html;
+				page += "</table>\n";
+			}
+		}
+
 		auto res = world_state.user_script_log.find(logged_in_user->id);
 		if(res != world_state.user_script_log.end())
 			log = res->second;
@@ -742,7 +774,7 @@ void renderScriptLog(ServerAllWorldsState& world_state, const web::RequestInfo&
 
 	page += WebServerResponseUtils::standardFooter(request, /*include_email_link=*/true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 }
 
 
@@ -760,7 +792,7 @@ void renderSecretsPage(ServerAllWorldsState& world_state, const web::RequestInfo
 			page += WebServerResponseUtils::standardHeader(world_state, request, /*page title=*/"Secrets");
 			page += "You must be logged in to view this page.";
 			page += WebServerResponseUtils::standardFooter(request, /*include_email_link=*/true);
-			web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+			WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 			return;
 		}
 
@@ -812,7 +844,7 @@ void renderSecretsPage(ServerAllWorldsState& world_state, const web::RequestInfo
 
 	page += WebServerResponseUtils::standardFooter(request, /*include_email_link=*/true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 }
 
 
@@ -14,13 +14,18 @@ Copyright Glare Technologies Limited 2021 -
 #include "WebServerResponseUtils.h"
 #include "LoginHandlers.h"
 #include "WorldHandlers.h"
+#include "Pagination.h"
 #include "../server/ServerWorldState.h"
+#include "../shared/URLAtom.h"
+#include "../shared/LuaScriptEvaluator.h"
 #include <ConPrint.h>
 #include <Exception.h>
 #include <Lock.h>
 #include <Parser.h>
 #include <Escaping.h>
 #include <maths/Rect2.h>
+#include <lua/LuaVM.h>
+#include <algorithm>
 
 
 namespace AdminHandlers
@@ -33,7 +38,7 @@ std::string sharedAdminHeader(ServerAllWorldsState& world_state, const web::Requ
 
 	page_out += "<p><a href=\"/admin\">Main admin page</a> | <a href=\"/admin_users\">Users</a> | <a href=\"/admin_parcels\">Parcels</a> | ";
 	page_out += "<a href=\"/admin_parcel_auctions\">Parcel Auctions</a> | <a href=\"/admin_orders\">Orders</a> | <a href=\"/admin_sub_eth_transactions\">Eth Transactions</a> | <a href=\"/admin_map\">Map</a> | ";
-	page_out += "<a href=\"/admin_news_posts\">News Posts</a> | <a href=\"/admin_lod_chunks\">LOD Chunks</a> | <a href=\"/admin_worlds\">Worlds</a> </p>";
+	page_out += "<a href=\"/admin_news_posts\">News Posts</a> | <a href=\"/admin_lod_chunks\">LOD Chunks</a> | <a href=\"/admin_worlds\">Worlds</a> | <a href=\"/admin_scripts\">Scripts</a> </p>";
 
 	return page_out;
 }
@@ -84,7 +89,7 @@ void renderAdminAddNewParcel(ServerAllWorldsState& world_state, const web::Reque
 	page += "</div>   \n"; // end main div
 	page += WebServerResponseUtils::standardFooter(request, true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request_info, reply_info, page);
 }
 
 
@@ -161,7 +166,7 @@ void renderAdminEditParcel(ServerAllWorldsState& world_state, const web::Request
 
 	page += WebServerResponseUtils::standardFooter(request, true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request_info, reply_info, page);
 }
 
 
@@ -491,7 +496,71 @@ void renderMainAdminPage(ServerAllWorldsState& world_state, const web::RequestIn
 		page_out += "</form>";
 	}
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page_out);
+	{
+		const WebPageCache::Stats stats = world_state.web_page_cache.getStats();
+		const uint64 num_lookups = stats.num_hits + stats.num_misses;
+
+		page_out += "<h3>Web page cache</h3>";
+		page_out += "<p>Hits: " + toString(stats.num_hits) + ", misses: " + toString(stats.num_misses) + 
+			", hit rate: " + ((num_lookups > 0) ? (doubleToStringNSigFigs(100.0 * stats.num_hits / num_lookups, 3) + "%") : std::string("-")) + "</p>";
+		page_out += "<p>Cached fragments: " + toString(stats.num_fragments) + " (" + getNiceByteSize(stats.total_size_B) + ")</p>";
+	}
+
+	{
+		const ImageFileCache::Stats stats = world_state.image_file_cache.getStats();
+		const uint64 num_lookups = stats.num_hits + stats.num_misses;
+
+		page_out += "<h3>Image file cache</h3>";
+		page_out += "<p>Hits: " + toString(stats.num_hits) + ", misses: " + toString(stats.num_misses) + 
+			", hit rate: " + ((num_lookups > 0) ? (doubleToStringNSigFigs(100.0 * stats.num_hits / num_lookups, 3) + "%") : std::string("-")) + "</p>";
+		page_out += "<p>Cached files: " + toString(stats.num_files) + " (" + getNiceByteSize(stats.total_size_B) + ")</p>";
+	}
+
+	{
+		const DecodedImageCache::Stats stats = world_state.decoded_image_cache.getStats();
+		const uint64 num_lookups = stats.num_hits + stats.num_misses;
+
+		page_out += "<h3>Decoded image cache</h3>";
+		page_out += "<p>Hits: " + toString(stats.num_hits) + ", misses: " + toString(stats.num_misses) + 
+			", hit rate: " + ((num_lookups > 0) ? (doubleToStringNSigFigs(100.0 * stats.num_hits / num_lookups, 3) + "%") : std::string("-")) + ", evictions: " + toString(stats.num_evictions) + "</p>";
+		page_out += "<p>Cached images: " + toString(stats.num_images) + " (" + getNiceByteSize(stats.total_size_B) + " / " + getNiceByteSize(stats.max_total_size_B) + ")</p>";
+	}
+
+	{
+		const BasisEncodingService::Stats stats = world_state.basis_encoding_service.getStats();
+
+		page_out += "<h3>Basis encoding service</h3>";
+		page_out += "<p>Queue depth: " + toString(stats.queue_depth) + " (max " + toString(stats.max_queue_depth) + "), running jobs: " + toString(stats.num_running_jobs) + 
+			", threads in use: " + toString(stats.num_threads_in_use) + " / " + toString(stats.max_total_threads) + "</p>";
+		page_out += "<p>Jobs done: " + toString(stats.num_jobs_done) + " (" + toString(stats.num_jobs_failed) + " failed), total encode time: " + doubleToStringNSigFigs(stats.total_encode_time_s, 3) + 
+			" s, total queue wait time: " + doubleToStringNSigFigs(stats.total_queue_wait_time_s, 3) + " s</p>";
+	}
+
+	{
+		const URLAtomTable::Stats stats = URLAtomTable::getGlobalTable().getStats();
+
+		page_out += "<h3>URL atom table</h3>";
+		page_out += "<p>Distinct URLs: " + toString(stats.num_atoms) + " (" + getNiceByteSize(stats.total_string_size_B) + "), references: " + toString(stats.num_references) + 
+			", estimated memory saved: " + getNiceByteSize((uint64)myMax<int64>(0, stats.bytes_saved)) + "</p>";
+	}
+
+	{
+		const WebServerResponseUtils::CompressionStats stats = WebServerResponseUtils::getCompressionStats();
+		const uint64 num_compressed = stats.num_zstd_responses + stats.num_deflate_responses;
+
+		page_out += "<h3>Dynamic response compression</h3>";
+		page_out += "<p>Compressed responses: " + toString(stats.num_zstd_responses) + " zstd, " + toString(stats.num_deflate_responses) + " deflate.  Uncompressed responses: " + toString(stats.num_uncompressed_responses) + "</p>";
+		if(num_compressed > 0)
+		{
+			page_out += "<p>Compressed " + getNiceByteSize(stats.total_uncompressed_size_B) + " to " + getNiceByteSize(stats.total_compressed_size_B) + 
+				" (" + doubleToStringNSigFigs(100.0 * stats.total_compressed_size_B / stats.total_uncompressed_size_B, 3) + "%), saving " + getNiceByteSize(stats.total_uncompressed_size_B - stats.total_compressed_size_B) + "</p>";
+			page_out += "<p>Compression time: " + doubleToStringNSigFigs(stats.total_compression_time_s, 4) + " s total, " + 
+				doubleToStringNSigFigs(stats.total_compression_time_s * 1.0e3 / num_compressed, 4) + " ms / response, " + 
+				doubleToStringNSigFigs(stats.total_compression_time_s * 1.0e6 / myMax(1.0, (double)(stats.total_uncompressed_size_B - stats.total_compressed_size_B) / 1024), 4) + " us / KB saved</p>";
+		}
+	}
+
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request_info, reply_info, page_out);
 }
 
 
@@ -503,35 +572,68 @@ void renderUsersPage(ServerAllWorldsState& world_state, const web::RequestInfo&
 		return;
 	}
 
+	const Pagination::PageParams page_params = Pagination::parsePageParams(request, /*default_descending=*/true); // Show newest users first by default.
+	const std::string name_prefix = request.getURLParam("name_prefix").str();
+	const bool sort_by_name = (request.getURLParam("sort").str() == "name") || !name_prefix.empty();
+
 	std::string page_out = sharedAdminHeader(world_state, request);
 
 	{ // Lock scope
 		Lock lock(world_state.mutex);
 
-		// Print out users
 		page_out += "<h2>Users</h2>\n";
+		page_out += "<p>" + toString(world_state.user_id_to_users.size()) + " users.  Sort by: <a href=\"/admin_users\">created time</a> | <a href=\"/admin_users?sort=name\">username</a></p>\n";
+
+		page_out += "<form action=\"/admin_users\" method=\"get\">";
+		page_out += "<input type=\"hidden\" name=\"sort\" value=\"name\">";
+		page_out += "username prefix: <input type=\"text\" name=\"name_prefix\" value=\"" + web::Escaping::HTMLEscape(name_prefix) + "\">";
+		page_out += "<input type=\"submit\" value=\"Find users\">";
+		page_out += "</form>";
+
+		std::vector<const User*> users;
+		bool have_next_page;
+		std::string next_cursor;
+		std::string base_URL;
+		if(sort_by_name)
+		{
+			// Use the name_to_users map as an index ordered by username.
+			std::vector<std::map<std::string, Reference<User>>::const_iterator> page;
+			have_next_page = Pagination::getStringPrefixPage(world_state.name_to_users, name_prefix, page_params.after.empty() ? NULL : &page_params.after, page_params.page_size, page);
+			for(size_t i=0; i<page.size(); ++i)
+				users.push_back(page[i]->second.ptr());
+			if(!page.empty())
+				next_cursor = page.back()->first;
+			base_URL = "/admin_users?sort=name&name_prefix=" + web::Escaping::URLEscape(name_prefix);
+		}
+		else
+		{
+			// User ids are allocated in increasing order, so id order is created time order.
+			uint64 cursor_val = 0;
+			const bool have_cursor = Pagination::parseIntCursor(page_params, cursor_val);
+			const UserID cursor((uint32)cursor_val);
+
+			std::vector<std::map<UserID, Reference<User>>::const_iterator> page;
+			have_next_page = Pagination::getMapPage(world_state.user_id_to_users, have_cursor ? &cursor : NULL, page_params.descending, page_params.page_size, page);
+			for(size_t i=0; i<page.size(); ++i)
+				users.push_back(page[i]->second.ptr());
+			if(!page.empty())
+				next_cursor = page.back()->first.toString();
+			base_URL = "/admin_users";
+		}
 
-		for(auto it = world_state.user_id_to_users.begin(); it != world_state.user_id_to_users.end(); ++it)
+		for(size_t i=0; i<users.size(); ++i)
 		{
-			const User* user = it->second.ptr();
+			const User* user = users[i];
 			page_out += "<div>\n";
 			page_out += "<a href=\"/admin_user/" + user->id.toString() + "\">id: " + user->id.toString() + "</a>,       username: " + web::Escaping::HTMLEscape(user->name) + ",       email: " + web::Escaping::HTMLEscape(user->email_address) + ",      joined " + user->created_time.timeAgoDescription() +
 				"  linked eth address: <span class=\"eth-address\">" + user->controlled_eth_address + "</span>";
 			page_out += "</div>\n";
 		}
 
-		/*page_out += "<table>";
-		for(auto it = world_state.user_id_to_users.begin(); it != world_state.user_id_to_users.end(); ++it)
-		{
-		const User* user = it->second.ptr();
-		page_out += "<tr>\n";
-		page_out += "<td>" + user->id.toString() + "</td><td>" + web::Escaping::HTMLEscape(user->name) + "</td><td>" + web::Escaping::HTMLEscape(user->email_address) + "</td><td>" + user->created_time.timeAgoDescription() + "</td>";
-		page_out += "</tr>\n";
-		}
-		page_out += "</table>";*/
+		page_out += Pagination::makePageLinksHTML(base_URL, page_params, have_next_page, next_cursor, /*show_reverse_order_link=*/!sort_by_name);
 	} // End Lock scope
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page_out);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page_out);
 }
 
 
@@ -602,7 +704,7 @@ void renderAdminUserPage(ServerAllWorldsState& world_state, const web::RequestIn
 		}
 	} // End Lock scope
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page_out);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page_out);
 }
 
 
@@ -614,6 +716,10 @@ void renderParcelsPage(ServerAllWorldsState& world_state, const web::RequestInfo
 		return;
 	}
 
+	const Pagination::PageParams page_params = Pagination::parsePageParams(request, /*default_descending=*/false);
+	const bool filter_by_owner = request.isURLParamPresent("owner") && !request.getURLParam("owner").str().empty();
+	const UserID owner_id = filter_by_owner ? UserID((uint32)request.getURLIntParam("owner")) : UserID();
+
 	std::string page_out = sharedAdminHeader(world_state, request);
 
 	{ // Lock scope
@@ -635,9 +741,46 @@ void renderParcelsPage(ServerAllWorldsState& world_state, const web::RequestInfo
 
 		Reference<ServerWorldState> root_world = world_state.getRootWorldState();
 
-		for(auto it = root_world->parcels.begin(); it != root_world->parcels.end(); ++it)
+		page_out += "<p>" + toString(root_world->parcels.size()) + " parcels.</p>";
+		page_out += "<form action=\"/admin_parcels\" method=\"get\">";
+		page_out += "owner user id: <input type=\"number\" name=\"owner\" value=\"" + (filter_by_owner ? toString(owner_id.value()) : std::string()) + "\">";
+		page_out += "<input type=\"submit\" value=\"Find parcels\">";
+		page_out += "</form>";
+
+		uint64 cursor_val = 0;
+		const bool have_cursor = Pagination::parseIntCursor(page_params, cursor_val);
+		const ParcelID cursor((uint32)cursor_val);
+
+		std::vector<const Parcel*> parcels;
+		bool have_next_page;
+		std::string base_URL;
+		if(filter_by_owner)
+		{
+			// Use the parcels-by-owner index
+			std::vector<ParcelID> page;
+			const auto index_res = root_world->parcel_ids_by_owner.find(owner_id);
+			have_next_page = (index_res != root_world->parcel_ids_by_owner.end()) && 
+				Pagination::getSortedVectorPage(index_res->second, have_cursor ? &cursor : NULL, page_params.descending, page_params.page_size, page);
+			for(size_t i=0; i<page.size(); ++i)
+			{
+				const auto res = root_world->parcels.find(page[i]);
+				if(res != root_world->parcels.end() && res->second->owner_id == owner_id) // Index may be slightly out of date, so check parcel still exists and has this owner.
+					parcels.push_back(res->second.ptr());
+			}
+			base_URL = "/admin_parcels?owner=" + toString(owner_id.value());
+		}
+		else
+		{
+			std::vector<ServerWorldState::ParcelMapType::const_iterator> page;
+			have_next_page = Pagination::getMapPage(root_world->parcels, have_cursor ? &cursor : NULL, page_params.descending, page_params.page_size, page);
+			for(size_t i=0; i<page.size(); ++i)
+				parcels.push_back(page[i]->second.ptr());
+			base_URL = "/admin_parcels";
+		}
+
+		for(size_t z=0; z<parcels.size(); ++z)
 		{
-			const Parcel* parcel = it->second.ptr();
+			const Parcel* parcel = parcels[z];
 
 			// Look up owner
 			std::string owner_username;
@@ -675,9 +818,11 @@ void renderParcelsPage(ServerAllWorldsState& world_state, const web::RequestInfo
 			page_out += "</p>\n";
 			page_out += "<br/>  \n";
 		}
+
+		page_out += Pagination::makePageLinksHTML(base_URL, page_params, have_next_page, parcels.empty() ? std::string() : parcels.back()->id.toString());
 	} // End Lock scope
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page_out);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page_out);
 }
 
 
@@ -689,6 +834,8 @@ void renderParcelAuctionsPage(ServerAllWorldsState& world_state, const web::Requ
 		return;
 	}
 
+	const Pagination::PageParams page_params = Pagination::parsePageParams(request, /*default_descending=*/true); // Show newest first by default.
+
 	std::string page_out = sharedAdminHeader(world_state, request);
 
 	{ // Lock scope
@@ -696,9 +843,16 @@ void renderParcelAuctionsPage(ServerAllWorldsState& world_state, const web::Requ
 
 		page_out += "<h2>Parcel auctions</h2>\n";
 
-		for(auto it = world_state.parcel_auctions.begin(); it != world_state.parcel_auctions.end(); ++it)
+		uint64 cursor = 0;
+		const bool have_cursor = Pagination::parseIntCursor(page_params, cursor);
+		const uint32 key_cursor = (uint32)cursor;
+
+		std::vector<std::map<uint32, ParcelAuctionRef>::const_iterator> page;
+		const bool have_next_page = Pagination::getMapPage(world_state.parcel_auctions, have_cursor ? &key_cursor : NULL, page_params.descending, page_params.page_size, page);
+
+		for(size_t z=0; z<page.size(); ++z)
 		{
-			const ParcelAuction* auction = it->second.ptr();
+			const ParcelAuction* auction = page[z]->second.ptr();
 
 			page_out += "<p>\n";
 			page_out += "<a href=\"/admin_parcel_auction/" + toString(auction->id) + "\">Parcel Auction " + toString(auction->id) + "</a><br/>" +
@@ -730,9 +884,11 @@ void renderParcelAuctionsPage(ServerAllWorldsState& world_state, const web::Requ
 
 			page_out += "</p>\n";
 		}
+
+		page_out += Pagination::makePageLinksHTML("/admin_parcel_auctions", page_params, have_next_page, page.empty() ? std::string() : toString(page.back()->first));
 	} // End Lock scope
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page_out);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page_out);
 }
 
 
@@ -827,7 +983,7 @@ void renderAdminParcelAuctionPage(ServerAllWorldsState& world_state, const web::
 		}
 	} // End Lock scope
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page_out);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page_out);
 }
 
 
@@ -839,6 +995,8 @@ void renderOrdersPage(ServerAllWorldsState& world_state, const web::RequestInfo&
 		return;
 	}
 
+	const Pagination::PageParams page_params = Pagination::parsePageParams(request, /*default_descending=*/true); // Show newest first by default.
+
 	std::string page_out = sharedAdminHeader(world_state, request);
 
 	{ // Lock scope
@@ -846,9 +1004,15 @@ void renderOrdersPage(ServerAllWorldsState& world_state, const web::RequestInfo&
 
 		page_out += "<h2>Orders</h2>\n";
 
-		for(auto it = world_state.orders.begin(); it != world_state.orders.end(); ++it)
+		uint64 cursor = 0;
+		const bool have_cursor = Pagination::parseIntCursor(page_params, cursor);
+
+		std::vector<std::map<uint64, OrderRef>::const_iterator> page;
+		const bool have_next_page = Pagination::getMapPage(world_state.orders, have_cursor ? &cursor : NULL, page_params.descending, page_params.page_size, page);
+
+		for(size_t z=0; z<page.size(); ++z)
 		{
-			const Order* order = it->second.ptr();
+			const Order* order = page[z]->second.ptr();
 
 			// Look up user who made the order
 			std::string orderer_username;
@@ -873,9 +1037,11 @@ void renderOrdersPage(ServerAllWorldsState& world_state, const web::RequestInfo&
 
 			page_out += "</p>    \n";
 		}
+
+		page_out += Pagination::makePageLinksHTML("/admin_orders", page_params, have_next_page, page.empty() ? std::string() : toString(page.back()->first));
 	} // End Lock scope
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page_out);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page_out);
 }
 
 
@@ -887,6 +1053,8 @@ void renderSubEthTransactionsPage(ServerAllWorldsState& world_state, const web::
 		return;
 	}
 
+	const Pagination::PageParams page_params = Pagination::parsePageParams(request, /*default_descending=*/true); // Show newest first by default.
+
 	std::string page_out = sharedAdminHeader(world_state, request);
 
 	{ // Lock scope
@@ -901,9 +1069,15 @@ void renderSubEthTransactionsPage(ServerAllWorldsState& world_state, const web::
 
 		page_out += "<h2>Substrata Ethereum Transactions</h2>\n";
 
-		for(auto it = world_state.sub_eth_transactions.begin(); it != world_state.sub_eth_transactions.end(); ++it)
+		uint64 cursor = 0;
+		const bool have_cursor = Pagination::parseIntCursor(page_params, cursor);
+
+		std::vector<std::map<uint64, SubEthTransactionRef>::const_iterator> page;
+		const bool have_next_page = Pagination::getMapPage(world_state.sub_eth_transactions, have_cursor ? &cursor : NULL, page_params.descending, page_params.page_size, page);
+
+		for(size_t z=0; z<page.size(); ++z)
 		{
-			const SubEthTransaction* trans = it->second.ptr();
+			const SubEthTransaction* trans = page[z]->second.ptr();
 
 			// Look up user who initiated the transaction
 			std::string username;
@@ -935,9 +1109,11 @@ void renderSubEthTransactionsPage(ServerAllWorldsState& world_state, const web::
 
 			page_out += "<br/>";
 		}
+
+		page_out += Pagination::makePageLinksHTML("/admin_sub_eth_transactions", page_params, have_next_page, page.empty() ? std::string() : toString(page.back()->first));
 	} // End Lock scope
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page_out);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page_out);
 }
 
 
@@ -1047,7 +1223,7 @@ void renderAdminSubEthTransactionPage(ServerAllWorldsState& world_state, const w
 		}
 	} // End Lock scope
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page_out);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page_out);
 }
 
 
@@ -1087,7 +1263,7 @@ void renderMapPage(ServerAllWorldsState& world_state, const web::RequestInfo& re
 		}
 	} // End Lock scope
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page_out);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page_out);
 }
 
 
@@ -1151,7 +1327,7 @@ void renderAdminOrderPage(ServerAllWorldsState& world_state, const web::RequestI
 		}
 	} // End Lock scope
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page_out);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page_out);
 }
 
 
@@ -1163,6 +1339,8 @@ void renderAdminNewsPostsPage(ServerAllWorldsState& world_state, const web::Requ
 		return;
 	}
 
+	const Pagination::PageParams page_params = Pagination::parsePageParams(request, /*default_descending=*/true); // Show newest first by default.
+
 	std::string page_out = sharedAdminHeader(world_state, request);
 
 	{ // Lock scope
@@ -1178,9 +1356,15 @@ void renderAdminNewsPostsPage(ServerAllWorldsState& world_state, const web::Requ
 		page_out += "<hr/>";
 		//-----------------------
 
-		for(auto it = world_state.news_posts.begin(); it != world_state.news_posts.end(); ++it)
+		uint64 cursor = 0;
+		const bool have_cursor = Pagination::parseIntCursor(page_params, cursor);
+
+		std::vector<std::map<uint64, NewsPostRef>::const_iterator> page;
+		const bool have_next_page = Pagination::getMapPage(world_state.news_posts, have_cursor ? &cursor : NULL, page_params.descending, page_params.page_size, page);
+
+		for(size_t z=0; z<page.size(); ++z)
 		{
-			const NewsPost* news_post = it->second.ptr();
+			const NewsPost* news_post = page[z]->second.ptr();
 
 			// Look up owner
 			std::string creator_username;
@@ -1201,9 +1385,34 @@ void renderAdminNewsPostsPage(ServerAllWorldsState& world_state, const web::Requ
 			page_out += "</p>\n";
 			page_out += "<br/>  \n";
 		}
+
+		page_out += Pagination::makePageLinksHTML("/admin_news_posts", page_params, have_next_page, page.empty() ? std::string() : toString(page.back()->first));
 	} // End Lock scope
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page_out);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page_out);
+}
+
+
+// LOD chunk page cursors are the chunk coordinates, formatted like "x,y,z".
+static std::string makeLODChunkCursor(const Vec3i& coords)
+{
+	return toString(coords.x) + "," + toString(coords.y) + "," + toString(coords.z);
+}
+
+
+static Vec3i parseLODChunkCursor(const std::string& cursor)
+{
+	const std::vector<std::string> parts = ::split(cursor, ',');
+	if(parts.size() != 3)
+		throw glare::Exception("Invalid page cursor");
+	try
+	{
+		return Vec3i(stringToInt(parts[0]), stringToInt(parts[1]), stringToInt(parts[2]));
+	}
+	catch(StringUtilsExcep&)
+	{
+		throw glare::Exception("Invalid page cursor");
+	}
 }
 
 
@@ -1215,6 +1424,9 @@ void renderAdminLODChunksPage(ServerAllWorldsState& all_worlds_state, const web:
 		return;
 	}
 
+	const Pagination::PageParams page_params = Pagination::parsePageParams(request, /*default_descending=*/false);
+	const std::string world_name = request.getURLParam("world").str(); // The main world has the empty name.
+
 	std::string page_out = sharedAdminHeader(all_worlds_state, request);
 
 	{ // Lock scope
@@ -1231,28 +1443,41 @@ void renderAdminLODChunksPage(ServerAllWorldsState& all_worlds_state, const web:
 		page_out += "<hr/>";
 		//-----------------------
 
-		for(auto it = all_worlds_state.world_states.begin(); it != all_worlds_state.world_states.end(); ++it)
+		page_out += "<form action=\"/admin_lod_chunks\" method=\"get\">";
+		page_out += "world name: (empty for the main world) <input type=\"text\" name=\"world\" value=\"" + web::Escaping::HTMLEscape(world_name) + "\">";
+		page_out += "<input type=\"submit\" value=\"Show world LOD chunks\">";
+		page_out += "</form>";
+
+		auto world_res = all_worlds_state.world_states.find(world_name);
+		if(world_res == all_worlds_state.world_states.end())
 		{
-			ServerWorldState* world_state = it->second.ptr();
+			page_out += "<p>No world with that name found.</p>";
+		}
+		else
+		{
+			ServerWorldState::LODChunkMapType& lod_chunks = world_res->second->getLODChunks(lock);
 
-			ServerWorldState::LODChunkMapType& lod_chunks = world_state->getLODChunks(lock);
+			page_out += "<h3>World: '" + web::Escaping::HTMLEscape(world_name) + "' (" + toString(lod_chunks.size()) + " chunks)</h3>";
 
-			if(!lod_chunks.empty())
-			{
-				page_out += "<h3>World: '" + web::Escaping::HTMLEscape(it->first) + "'</h3>";
+			const bool have_cursor = !page_params.after.empty();
+			const Vec3i cursor = have_cursor ? parseLODChunkCursor(page_params.after) : Vec3i(0, 0, 0);
 
-				for(auto lod_it = lod_chunks.begin(); lod_it != lod_chunks.end(); ++lod_it)
-				{
-					const LODChunk* chunk = lod_it->second.ptr();
+			std::vector<ServerWorldState::LODChunkMapType::const_iterator> page;
+			const bool have_next_page = Pagination::getMapPage(lod_chunks, have_cursor ? &cursor : NULL, page_params.descending, page_params.page_size, page);
 
-					page_out += "<div>Coords: " + chunk->coords.toString() + ", <br/> mesh_url: " + web::Escaping::HTMLEscape(toStdString(chunk->getMeshURL())) + ", <br/> combined_array_texture_url: " + web::Escaping::HTMLEscape(toStdString(chunk->combined_array_texture_url)) + 
-						"<br/> compressed_mat_info: " + toString(chunk->compressed_mat_info.size()) + " B, <br/> needs_rebuild: " + boolToString(chunk->needs_rebuild) + "</div><br/>";
-				}
+			for(size_t z=0; z<page.size(); ++z)
+			{
+				const LODChunk* chunk = page[z]->second.ptr();
+
+				page_out += "<div>Coords: " + chunk->coords.toString() + ", <br/> mesh_url: " + web::Escaping::HTMLEscape(toStdString(chunk->getMeshURL())) + ", <br/> combined_array_texture_url: " + web::Escaping::HTMLEscape(toStdString(chunk->combined_array_texture_url)) + 
+					"<br/> compressed_mat_info: " + toString(chunk->compressed_mat_info.size()) + " B, <br/> needs_rebuild: " + boolToString(chunk->needs_rebuild) + "</div><br/>";
 			}
+
+			page_out += Pagination::makePageLinksHTML("/admin_lod_chunks?world=" + web::Escaping::URLEscape(world_name), page_params, have_next_page, page.empty() ? std::string() : makeLODChunkCursor(page.back()->first));
 		}
 	} // End Lock scope
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page_out);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page_out);
 }
 
 
@@ -1264,16 +1489,28 @@ void renderAdminWorldsPage(ServerAllWorldsState& all_worlds_state, const web::Re
 		return;
 	}
 
+	const Pagination::PageParams page_params = Pagination::parsePageParams(request, /*default_descending=*/false);
+	const std::string name_prefix = request.getURLParam("name_prefix").str();
+
 	std::string page_out = sharedAdminHeader(all_worlds_state, request);
 
 	{ // Lock scope
 		WorldStateLock lock(all_worlds_state.mutex);
 
 		page_out += "<h2>Worlds</h2>\n";
+		page_out += "<p>" + toString(all_worlds_state.world_states.size()) + " worlds.</p>";
 
-		for(auto it = all_worlds_state.world_states.begin(); it != all_worlds_state.world_states.end(); ++it)
+		page_out += "<form action=\"/admin_worlds\" method=\"get\">";
+		page_out += "world name prefix: <input type=\"text\" name=\"name_prefix\" value=\"" + web::Escaping::HTMLEscape(name_prefix) + "\">";
+		page_out += "<input type=\"submit\" value=\"Find worlds\">";
+		page_out += "</form>";
+
+		std::vector<std::map<std::string, Reference<ServerWorldState>>::const_iterator> page;
+		const bool have_next_page = Pagination::getStringPrefixPage(all_worlds_state.world_states, name_prefix, page_params.after.empty() ? NULL : &page_params.after, page_params.page_size, page);
+
+		for(size_t z=0; z<page.size(); ++z)
 		{
-			ServerWorldState* world_state = it->second.ptr();
+			ServerWorldState* world_state = page[z]->second.ptr();
 
 			page_out += "<div><a href=\"/world/" + WorldHandlers::URLEscapeWorldName(world_state->details.name) + "\">" + web::Escaping::HTMLEscape(world_state->details.name) + "</a>";
 			page_out += " &nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp; Created: " + world_state->details.created_time.dayAndTimeStringUTC();
@@ -1281,9 +1518,99 @@ void renderAdminWorldsPage(ServerAllWorldsState& all_worlds_state, const web::Re
 				page_out += " &nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;  description: <i>" + web::Escaping::HTMLEscape(world_state->details.description.substr(0, 200)) + "</i>";
 			page_out += "</div>\n";
 		}
+
+		page_out += Pagination::makePageLinksHTML("/admin_worlds?name_prefix=" + web::Escaping::URLEscape(name_prefix), page_params, have_next_page, page.empty() ? std::string() : page.back()->first, /*show_reverse_order_link=*/false);
+	} // End Lock scope
+
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page_out);
+}
+
+
+struct ScriptStatsRow
+{
+	std::string world_name;
+	UID ob_uid;
+	UserID creator_id;
+	LuaScriptExecStats stats;
+	std::string status;
+};
+
+
+void renderAdminScriptsPage(ServerAllWorldsState& all_worlds_state, const web::RequestInfo& request, web::ReplyInfo& reply_info)
+{
+	if(!LoginHandlers::loggedInUserHasAdminPrivs(all_worlds_state, request))
+	{
+		web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, "Access denied sorry.");
+		return;
+	}
+
+	std::string page_out = sharedAdminHeader(all_worlds_state, request);
+
+	std::vector<ScriptStatsRow> rows;
+
+	{ // Lock scope
+		WorldStateLock lock(all_worlds_state.mutex);
+
+		page_out += "<h2>Lua VMs</h2>\n";
+
+		page_out += "<table><tr><th>User</th><th>Heap size</th><th>Peak heap size</th><th>Heap limit</th></tr>\n";
+		for(auto it = all_worlds_state.lua_vms.begin(); it != all_worlds_state.lua_vms.end(); ++it)
+		{
+			SubstrataLuaVM* lua_vm = it->second.ptr();
+
+			std::string username;
+			auto user_res = all_worlds_state.user_id_to_users.find(it->first);
+			if(user_res != all_worlds_state.user_id_to_users.end())
+				username = user_res->second->name;
+
+			const size_t heap_size_B = lua_vm->getHeapSizeB();
+			page_out += "<tr><td><a href=\"/admin_user/" + it->first.toString() + "\">" + web::Escaping::HTMLEscape(username) + "</a></td><td>" + getNiceByteSize(heap_size_B) + "</td><td>" + 
+				getNiceByteSize(lua_vm->peak_heap_size_B) + "</td><td>" + getNiceByteSize(lua_vm->lua_vm->max_total_mem_allowed) + "</td></tr>\n";
+		}
+		page_out += "</table>\n";
+
+		for(auto it = all_worlds_state.world_states.begin(); it != all_worlds_state.world_states.end(); ++it)
+		{
+			ServerWorldState::ObjectMapType& objects = it->second->getObjects(lock);
+			for(auto ob_it = objects.begin(); ob_it != objects.end(); ++ob_it)
+			{
+				const WorldObject* ob = ob_it->second.ptr();
+				if(ob->lua_script_evaluator)
+				{
+					const LuaScriptEvaluator* evaluator = ob->lua_script_evaluator.ptr();
+
+					ScriptStatsRow row;
+					row.world_name = it->first;
+					row.ob_uid = ob->uid;
+					row.creator_id = ob->creator_id;
+					row.stats = evaluator->exec_stats;
+					row.status = evaluator->hit_error ? "disabled" : (evaluator->isThrottled() ? "throttled" : "running");
+					rows.push_back(row);
+				}
+			}
+		}
 	} // End Lock scope
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page_out);
+	// Sort by total execution time, most expensive first
+	std::sort(rows.begin(), rows.end(), [](const ScriptStatsRow& a, const ScriptStatsRow& b) { return a.stats.total_exec_time_s > b.stats.total_exec_time_s; });
+
+	page_out += "<h2>Scripts</h2>\n";
+	page_out += "<p>" + toString(rows.size()) + " scripts.  Callback execution time budget: " + toString((int)(LuaScriptEvaluator::CALLBACK_TIME_BUDGET_S * 1000)) + " ms, " + 
+		toString((int)(LuaScriptEvaluator::WINDOW_EXEC_TIME_BUDGET_S * 1000)) + " ms per " + toString((int)LuaScriptEvaluator::BUDGET_WINDOW_S) + " s.</p>\n";
+
+	page_out += "<table><tr><th>World</th><th>Object</th><th>Creator</th><th>Status</th><th>Callbacks</th><th>Total exec time</th><th>Mean exec time</th><th>Budget overruns</th><th>Throttle events</th><th>Throttled callbacks</th><th>Heap growth</th></tr>\n";
+	for(size_t i=0; i<rows.size(); ++i)
+	{
+		const ScriptStatsRow& row = rows[i];
+		const double mean_exec_time_s = (row.stats.num_callbacks > 0) ? (row.stats.total_exec_time_s / row.stats.num_callbacks) : 0.0;
+
+		page_out += "<tr><td>" + web::Escaping::HTMLEscape(row.world_name) + "</td><td>" + row.ob_uid.toString() + "</td><td><a href=\"/admin_user/" + row.creator_id.toString() + "\">" + row.creator_id.toString() + "</a></td><td>" + row.status + "</td>" + 
+			"<td>" + toString(row.stats.num_callbacks) + "</td><td>" + doubleToStringNSigFigs(row.stats.total_exec_time_s * 1000, 4) + " ms</td><td>" + doubleToStringNSigFigs(mean_exec_time_s * 1.0e6, 4) + " us</td>" + 
+			"<td>" + toString(row.stats.num_budget_overruns) + "</td><td>" + toString(row.stats.num_throttle_events) + "</td><td>" + toString(row.stats.num_throttled_callbacks) + "</td><td>" + getNiceByteSize(row.stats.total_heap_growth_B) + "</td></tr>\n";
+	}
+	page_out += "</table>\n";
+
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page_out);
 }
 
 
@@ -1320,7 +1647,7 @@ void renderCreateParcelAuction(ServerAllWorldsState& world_state, const web::Req
 	page_out += "<input type=\"submit\" value=\"Create auction\">";
 	page_out += "</form>";
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page_out);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page_out);
 }
 
 
@@ -1481,7 +1808,7 @@ void renderSetParcelOwnerPage(ServerAllWorldsState& world_state, const web::Requ
 		}
 	} // End lock scope
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page_out);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page_out);
 }
 
 
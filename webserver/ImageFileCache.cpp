@@ -0,0 +1,222 @@
+/*=====================================================================
+ImageFileCache.cpp
+------------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#include "ImageFileCache.h"
+
+
+#include <utils/Lock.h>
+#include <utils/MemMappedFile.h>
+#include <utils/ConPrint.h>
+
+
+ImageFileCache::ImageFileCache(size_t max_total_size_B_)
+:	total_size_B(0),
+	max_total_size_B(max_total_size_B_),
+	num_hits(0),
+	num_misses(0)
+{}
+
+
+ImageFileCache::~ImageFileCache() {}
+
+
+CachedImageFileRef ImageFileCache::getFile(const std::string& local_path)
+{
+	Lock lock(mutex);
+
+	auto res = files.find(local_path);
+	if(res == files.end())
+	{
+		num_misses++;
+		return CachedImageFileRef();
+	}
+
+	// Move to front of LRU list
+	lru_paths.splice(lru_paths.begin(), lru_paths, res->second.lru_it);
+
+	num_hits++;
+	return res->second.file;
+}
+
+
+CachedImageFileRef ImageFileCache::getOrLoadFile(const std::string& local_path)
+{
+	CachedImageFileRef file = getFile(local_path);
+	if(file.nonNull())
+		return file;
+
+	// Read the file without holding the mutex.
+	file = new CachedImageFile();
+	{
+		MemMappedFile mapped_file(local_path);
+		file->data.assign((const char*)mapped_file.fileData(), mapped_file.fileSize());
+	}
+
+	if(file->data.size() <= MAX_CACHED_FILE_SIZE_B)
+	{
+		Lock lock(mutex);
+		if(files.count(local_path) == 0) // Another thread may have inserted it in the meantime.
+			insertFile(local_path, file);
+	}
+
+	return file;
+}
+
+
+void ImageFileCache::addFile(const std::string& local_path, const void* data, size_t size)
+{
+	if(size > MAX_CACHED_FILE_SIZE_B)
+		return;
+
+	CachedImageFileRef file = new CachedImageFile();
+	file->data.assign((const char*)data, size);
+
+	Lock lock(mutex);
+	if(files.count(local_path) == 0) // Another thread may have inserted it in the meantime.
+		insertFile(local_path, file);
+}
+
+
+void ImageFileCache::insertFile(const std::string& local_path, const CachedImageFileRef& file)
+{
+	lru_paths.push_front(local_path);
+
+	CacheEntry& entry = files[local_path];
+	entry.file = file;
+	entry.lru_it = lru_paths.begin();
+	total_size_B += file->data.size();
+
+	// Evict least recently used files until we are under the size limit.  Don't evict the file just inserted.
+	while(total_size_B > max_total_size_B && lru_paths.size() > 1)
+	{
+		auto res = files.find(lru_paths.back());
+		assert(res != files.end());
+		total_size_B -= res->second.file->data.size();
+		files.erase(res);
+		lru_paths.pop_back();
+	}
+}
+
+
+void ImageFileCache::clear()
+{
+	Lock lock(mutex);
+
+	files.clear();
+	lru_paths.clear();
+	total_size_B = 0;
+}
+
+
+ImageFileCache::Stats ImageFileCache::getStats()
+{
+	Lock lock(mutex);
+
+	Stats stats;
+	stats.num_hits = num_hits;
+	stats.num_misses = num_misses;
+	stats.num_files = files.size();
+	stats.total_size_B = total_size_B;
+	return stats;
+}
+
+
+#if BUILD_TESTS
+
+
+#include <utils/TestUtils.h>
+#include <utils/FileUtils.h>
+#include <utils/PlatformUtils.h>
+#include <utils/StringUtils.h>
+#include <utils/Exception.h>
+
+
+void ImageFileCache::test()
+{
+	conPrint("ImageFileCache::test()");
+
+	try
+	{
+		const std::string dir = PlatformUtils::getTempDirPath() + "/image_file_cache_test";
+		FileUtils::createDirIfDoesNotExist(dir);
+
+		std::vector<std::string> paths;
+		for(int i=0; i<4; ++i)
+		{
+			paths.push_back(dir + "/image_" + toString(i) + ".jpg");
+			FileUtils::writeEntireFile(paths.back(), std::string(100, (char)('a' + i)));
+		}
+
+		// Cache with room for 3 files.
+		ImageFileCache cache(/*max_total_size_B=*/300);
+		testAssert(cache.getFile(paths[0]).isNull());
+
+		CachedImageFileRef file = cache.getOrLoadFile(paths[0]);
+		testAssert(file->data == std::string(100, 'a'));
+		testAssert(cache.getFile(paths[0]).ptr() == file.ptr());
+
+		cache.getOrLoadFile(paths[1]);
+		cache.getOrLoadFile(paths[2]);
+		testAssert(cache.getStats().num_files == 3 && cache.getStats().total_size_B == 300);
+
+		// Use file 0, so file 1 is the least recently used, then load file 3.  File 1 should be evicted.
+		cache.getFile(paths[0]);
+		cache.getOrLoadFile(paths[3]);
+		testAssert(cache.getStats().num_files == 3 && cache.getStats().total_size_B == 300);
+		testAssert(cache.getFile(paths[0]).nonNull());
+		testAssert(cache.getFile(paths[1]).isNull());
+		testAssert(cache.getFile(paths[2]).nonNull());
+		testAssert(cache.getFile(paths[3]).nonNull());
+
+		// Files that are too large should be returned but not cached.
+		const std::string large_path = dir + "/large.jpg";
+		FileUtils::writeEntireFile(large_path, std::string(MAX_CACHED_FILE_SIZE_B + 1, 'z'));
+		{
+			ImageFileCache big_cache;
+			CachedImageFileRef large_file = big_cache.getOrLoadFile(large_path);
+			testAssert(large_file->data.size() == MAX_CACHED_FILE_SIZE_B + 1);
+			testAssert(big_cache.getStats().num_files == 0);
+
+			big_cache.addFile(large_path, large_file->data.data(), large_file->data.size());
+			testAssert(big_cache.getStats().num_files == 0);
+		}
+
+		// Test addFile
+		{
+			ImageFileCache add_cache;
+			const std::string data(100, 'q');
+			add_cache.addFile(paths[0], data.data(), data.size());
+			testAssert(add_cache.getStats().num_files == 1 && add_cache.getStats().total_size_B == 100);
+			testAssert(add_cache.getFile(paths[0])->data == data);
+
+			// Adding an already cached file should leave the cached file unchanged.
+			CachedImageFileRef cached = add_cache.getFile(paths[0]);
+			add_cache.addFile(paths[0], data.data(), 50);
+			testAssert(add_cache.getFile(paths[0]).ptr() == cached.ptr());
+			testAssert(add_cache.getStats().num_files == 1 && add_cache.getStats().total_size_B == 100);
+		}
+
+		// Missing files should throw.
+		try
+		{
+			cache.getOrLoadFile(dir + "/not_a_file.jpg");
+			failTest("Expected exception");
+		}
+		catch(glare::Exception&)
+		{}
+
+		cache.clear();
+		testAssert(cache.getStats().num_files == 0 && cache.getStats().total_size_B == 0);
+	}
+	catch(glare::Exception& e)
+	{
+		failTest(e.what());
+	}
+
+	conPrint("ImageFileCache::test() done.");
+}
+
+
+#endif // BUILD_TESTS
@@ -0,0 +1,90 @@
+/*=====================================================================
+ImageFileCache.h
+----------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#pragma once
+
+
+#include <utils/ThreadSafeRefCounted.h>
+#include <utils/Reference.h>
+#include <Mutex.h>
+#include <Platform.h>
+#include <string>
+#include <list>
+#include <unordered_map>
+
+
+class CachedImageFile : public ThreadSafeRefCounted
+{
+public:
+	std::string data; // File contents
+};
+typedef Reference<CachedImageFile> CachedImageFileRef;
+
+
+/*=====================================================================
+ImageFileCache
+--------------
+LRU cache of recently served small image files (screenshots, map tiles,
+photo thumbnails and mid-size photos), keyed by local path, so hot images
+are served without reading the file again.
+
+Files are assumed to not change once written.  This holds for screenshots,
+map tiles and photos, which are saved with a new random filename each time.
+
+Files larger than MAX_CACHED_FILE_SIZE_B are not cached.
+Least recently used files are evicted once the total size exceeds max_total_size_B.
+
+Thread-safe.
+=====================================================================*/
+class ImageFileCache
+{
+public:
+	ImageFileCache(size_t max_total_size_B = 64 * 1024 * 1024);
+	~ImageFileCache();
+
+	static const size_t MAX_CACHED_FILE_SIZE_B = 1024 * 1024;
+
+	// Returns the cached file, or NULL if it is not cached.  Marks the file as most recently used.
+	CachedImageFileRef getFile(const std::string& local_path);
+
+	// Returns the cached file if present, otherwise reads it from disk, and caches it if it's not too large.
+	// Throws glare::Exception if the file could not be read.
+	CachedImageFileRef getOrLoadFile(const std::string& local_path);
+
+	// Caches a copy of the given file data, if it's not too large.  Does nothing if the file is already cached.
+	void addFile(const std::string& local_path, const void* data, size_t size);
+
+	void clear();
+
+	struct Stats
+	{
+		uint64 num_hits;
+		uint64 num_misses;
+		size_t num_files;
+		size_t total_size_B;
+	};
+	Stats getStats();
+
+	static void test();
+
+private:
+	GLARE_DISABLE_COPY(ImageFileCache);
+
+	void insertFile(const std::string& local_path, const CachedImageFileRef& file) REQUIRES(mutex);
+
+	struct CacheEntry
+	{
+		CachedImageFileRef file;
+		std::list<std::string>::iterator lru_it;
+	};
+
+	Mutex mutex;
+	std::unordered_map<std::string, CacheEntry> files	GUARDED_BY(mutex);
+	std::list<std::string> lru_paths					GUARDED_BY(mutex); // Most recently used at front.
+	size_t total_size_B									GUARDED_BY(mutex);
+	size_t max_total_size_B;
+	uint64 num_hits										GUARDED_BY(mutex);
+	uint64 num_misses									GUARDED_BY(mutex);
+};
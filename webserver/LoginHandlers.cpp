@@ -45,23 +45,35 @@ site-b cookie currently stores session ID.
 */
 
 
-bool isLoggedIn(ServerAllWorldsState& world_state, const web::RequestInfo& request_info, web::UnsafeString& logged_in_username_out, bool& is_user_admin_out)
+bool hasSessionCookie(const web::RequestInfo& request_info)
 {
-	Lock lock(world_state.mutex);
+	for(size_t i=0; i<request_info.cookies.size(); ++i)
+		if(request_info.cookies[i].key == "site-b")
+			return true;
+	return false;
+}
 
-	const User* user = getLoggedInUser(world_state, request_info);
-	if(user == NULL)
-	{
-		logged_in_username_out = "";
-		is_user_admin_out = false;
-		return false;
-	}
-	else
+
+bool isLoggedIn(ServerAllWorldsState& world_state, const web::RequestInfo& request_info, web::UnsafeString& logged_in_username_out, bool& is_user_admin_out)
+{
+	for(size_t i=0; i<request_info.cookies.size(); ++i)
 	{
-		logged_in_username_out = user->name;
-		is_user_admin_out = isGodUser(user->id);
-		return true;
+		if(request_info.cookies[i].key == "site-b")
+		{
+			WebSessionStore::SessionInfo session_info;
+			if(world_state.web_sessions.lookupSession(request_info.cookies[i].value, session_info) && !session_info.username.empty())
+			{
+				logged_in_username_out = session_info.username;
+				is_user_admin_out = isGodUser(session_info.session->user_id);
+				return true;
+			}
+			break;
+		}
 	}
+
+	logged_in_username_out = "";
+	is_user_admin_out = false;
+	return false;
 }
 
 
@@ -85,12 +97,12 @@ User* getLoggedInUser(ServerAllWorldsState& world_state, const web::RequestInfo&
 			try
 			{
 				// Lookup session
-				const auto res = world_state.user_web_sessions.find(request_info.cookies[i].value);
-				if(res == world_state.user_web_sessions.end())
+				WebSessionStore::SessionInfo session_info;
+				if(!world_state.web_sessions.lookupSession(request_info.cookies[i].value, session_info))
 					return NULL; // Session not found
 				else
 				{
-					const UserWebSession* session = res->second.ptr();
+					const UserWebSession* session = session_info.session.ptr();
 
 					// Lookup user from session
 					const auto user_res = world_state.user_id_to_users.find(session->user_id);
@@ -209,7 +221,7 @@ void handleLoginPost(ServerAllWorldsState& world_state, const web::RequestInfo&
 					
 					world_state.addUserWebSessionAsDBDirty(session);
 
-					world_state.user_web_sessions[session->id] = session;
+					world_state.web_sessions.addSession(session, user.name);
 					world_state.markAsChanged();
 
 					session_id = session->id;
@@ -383,7 +395,7 @@ void handleSignUpPost(ServerAllWorldsState& world_state, const web::RequestInfo&
 			session->user_id = new_user->id;
 			session->created_time = TimeStamp::currentTime();
 			world_state.addUserWebSessionAsDBDirty(session);
-			world_state.user_web_sessions[session->id] = session;
+			world_state.web_sessions.addSession(session, new_user->name);
 
 			reply += "HTTP/1.1 302 Redirect" + CRLF;
 			reply += "Location: " + return_URL + CRLF;
@@ -27,7 +27,10 @@ LoginHandlers
 namespace LoginHandlers
 {
 	bool isLoggedIn(ServerAllWorldsState& world_state, const web::RequestInfo& request_info, web::UnsafeString& logged_in_username_out,
-		bool& is_user_admin_out); // Locks ServerAllWorldsState
+		bool& is_user_admin_out); // Doesn't lock ServerAllWorldsState, just looks up the session in world_state.web_sessions.
+
+	// Does the request have a session cookie?  If not, the user is definitely not logged in.  Doesn't lock ServerAllWorldsState.
+	bool hasSessionCookie(const web::RequestInfo& request_info);
 
 	bool loggedInUserHasAdminPrivs(ServerAllWorldsState& world_state, const web::RequestInfo& request_info);
 
@@ -28,202 +28,246 @@ namespace MainPageHandlers
 {
 
 
-void renderRootPage(ServerAllWorldsState& world_state, WebDataStore& data_store, const web::RequestInfo& request_info, web::ReplyInfo& reply_info)
-{
-	//std::string page_out = WebServerResponseUtils::standardHeader(world_state, request_info, /*page title=*/"Substrata");
-	//const bool logged_in = LoginHandlers::isLoggedInAsNick(data_store, request_info);
+// Max ages of the cached root page fragments.  Auction prices and the upcoming events list change with time, not just when the content changes.
+static const double ROOT_AUCTIONS_MAX_AGE_S = 10;
+static const double ROOT_EVENTS_MAX_AGE_S = 60;
+static const double ROOT_NEWS_AND_PHOTOS_MAX_AGE_S = 600;
 
-	std::string page_out = WebServerResponseUtils::standardHTMLHeader(data_store, request_info, /*page title=*/"Metasiberia");
-	page_out +=
-		"	<body class=\"root-body\">\n"
-		"	<div id=\"login\">\n"; // Start login div
-
-	web::UnsafeString logged_in_username;
-	bool is_user_admin;
-	const bool logged_in = LoginHandlers::isLoggedIn(world_state, request_info, logged_in_username, is_user_admin);
-
-	if(logged_in)
-	{
-		page_out += "You are logged in as <a href=\"/account\">" + logged_in_username.HTMLEscaped() + "</a>";
 
-		// Add logout button
-		page_out += "<form action=\"/logout_post\" method=\"post\">\n";
-		page_out += "<input class=\"link-button\" type=\"submit\" value=\"Log out\">\n";
-		page_out += "</form>\n";
-	}
-	else
+static std::string renderRootPageAuctionsHTML(ServerAllWorldsState& world_state, WorldStateLock& lock) REQUIRES(world_state.mutex)
+{
+	std::string auction_html;
+	ServerWorldState* root_world = world_state.getRootWorldState().ptr();
+
+	int num_auctions_shown = 0; // Num substrata auctions shown
+	const TimeStamp now = TimeStamp::currentTime();
+	auction_html += "<div class=\"root-auction-list-container\">\n";
+	const ServerWorldState::ParcelMapType& parcels = root_world->getParcels(lock);
+	for(auto it = parcels.begin(); (it != parcels.end()) && (num_auctions_shown < 4); ++it)
 	{
-		page_out += "<a href=\"/login\">log in</a> <br/>\n";
-	}
-	page_out += 
-		"	</div>																									\n"; // End login div
+		Parcel* parcel = it->second.ptr();
 
+		if(!parcel->parcel_auction_ids.empty())
+		{
+			const uint32 auction_id = parcel->parcel_auction_ids.back(); // Get most recent auction
+			auto res = world_state.parcel_auctions.find(auction_id);
+			if(res != world_state.parcel_auctions.end())
+			{
+				const ParcelAuction* auction = res->second.ptr();
 
-	//page_out += "<img src=\"/files/logo_main_page.png\" alt=\"substrata logo\" class=\"logo-root-page\" />";
+				if(auction->currentlyForSale(now)) // If auction is valid and running:
+				{
+					if(!auction->screenshot_ids.empty())
+					{
+						const uint64 shot_id = auction->screenshot_ids[0]; // Get id of close-in screenshot
 
+						const double cur_price_EUR = auction->computeCurrentAuctionPrice();
+						const double cur_price_BTC = cur_price_EUR * world_state.BTC_per_EUR;
+						const double cur_price_ETH = cur_price_EUR * world_state.ETH_per_EUR;
 
-	std::string auction_html, latest_news_html, events_html, photos_html;
-	{ // lock scope
-		WorldStateLock lock(world_state.mutex);
+						auction_html += "<div class=\"root-auction-div\"><a href=\"/parcel_auction/" + toString(auction_id) + "\"><img src=\"/screenshot/" + toString(shot_id) + "\" class=\"root-auction-thumbnail\" alt=\"screenshot\" /></a>  <br/>"
+							"&euro;" + doubleToStringNDecimalPlaces(cur_price_EUR, 2) + " / " + doubleToStringNSigFigs(cur_price_BTC, 2) + "&nbsp;BTC / " + doubleToStringNSigFigs(cur_price_ETH, 2) + "&nbsp;ETH</div>";
+					}
 
-		ServerWorldState* root_world = world_state.getRootWorldState().ptr();
+					num_auctions_shown++;
+				}
+			}
+		}
+	}
+	auction_html += "</div>\n";
 
-		int num_auctions_shown = 0; // Num substrata auctions shown
-		const TimeStamp now = TimeStamp::currentTime();
+	// If no auctions on substrata site were shown, show OpenSea auctions, if any.
+	int opensea_num_shown = 0;
+	if(num_auctions_shown == 0)
+	{
 		auction_html += "<div class=\"root-auction-list-container\">\n";
-		const ServerWorldState::ParcelMapType& parcels = root_world->getParcels(lock);
-		for(auto it = parcels.begin(); (it != parcels.end()) && (num_auctions_shown < 4); ++it)
+		for(auto it = world_state.opensea_parcel_listings.begin(); (it != world_state.opensea_parcel_listings.end()) && (opensea_num_shown < 3); ++it)
 		{
-			Parcel* parcel = it->second.ptr();
+			const OpenSeaParcelListing& listing = *it;
 
-			if(!parcel->parcel_auction_ids.empty())
+			auto parcel_res = root_world->getParcels(lock).find(listing.parcel_id); // Look up parcel
+			if(parcel_res != root_world->getParcels(lock).end())
 			{
-				const uint32 auction_id = parcel->parcel_auction_ids.back(); // Get most recent auction
-				auto res = world_state.parcel_auctions.find(auction_id);
-				if(res != world_state.parcel_auctions.end())
-				{
-					const ParcelAuction* auction = res->second.ptr();
+				const Parcel* parcel = parcel_res->second.ptr();
 
-					if(auction->currentlyForSale(now)) // If auction is valid and running:
-					{
-						if(!auction->screenshot_ids.empty())
-						{
-							const uint64 shot_id = auction->screenshot_ids[0]; // Get id of close-in screenshot
-
-							const double cur_price_EUR = auction->computeCurrentAuctionPrice();
-							const double cur_price_BTC = cur_price_EUR * world_state.BTC_per_EUR;
-							const double cur_price_ETH = cur_price_EUR * world_state.ETH_per_EUR;
+				if(parcel->screenshot_ids.size() >= 1)
+				{
+					const uint64 shot_id = parcel->screenshot_ids[0]; // Close-in screenshot
 
-							auction_html += "<div class=\"root-auction-div\"><a href=\"/parcel_auction/" + toString(auction_id) + "\"><img src=\"/screenshot/" + toString(shot_id) + "\" class=\"root-auction-thumbnail\" alt=\"screenshot\" /></a>  <br/>"
-								"&euro;" + doubleToStringNDecimalPlaces(cur_price_EUR, 2) + " / " + doubleToStringNSigFigs(cur_price_BTC, 2) + "&nbsp;BTC / " + doubleToStringNSigFigs(cur_price_ETH, 2) + "&nbsp;ETH</div>";
-						}
+					const std::string opensea_url = "https://opensea.io/assets/ethereum/0xa4535f84e8d746462f9774319e75b25bc151ba1d/" + listing.parcel_id.toString();
 
-						num_auctions_shown++;
-					}
+					auction_html += "<div class=\"root-auction-div\"><a href=\"/parcel/" + parcel->id.toString() + "\"><img src=\"/screenshot/" + toString(shot_id) + "\" class=\"root-auction-thumbnail\" alt=\"screenshot\" /></a>  <br/>"
+						"<a href=\"/parcel/" + parcel->id.toString() + "\">Parcel " + parcel->id.toString() + "</a> <a href=\"" + opensea_url + "\">View&nbsp;on&nbsp;OpenSea</a></div>";
 				}
+
+				opensea_num_shown++;
 			}
 		}
 		auction_html += "</div>\n";
+	}
+
+	if(num_auctions_shown == 0 && opensea_num_shown == 0)
+		auction_html += "<p>Sorry, there are no parcels for sale here right now.  Please check back later!</p>";
+
+	return auction_html;
+}
+
+
+static std::string renderRootPageNewsHTML(ServerAllWorldsState& world_state, WorldStateLock& /*lock*/) REQUIRES(world_state.mutex)
+{
+	std::string latest_news_html;
+	latest_news_html += "<div class=\"root-news-div-container\">\n";
+	const int max_num_to_display = 4;
+	int num_displayed = 0;
+	for(auto it = world_state.news_posts.rbegin(); it != world_state.news_posts.rend() && num_displayed < max_num_to_display; ++it)
+	{
+		NewsPost* post = it->second.ptr();
 
-		// If no auctions on substrata site were shown, show OpenSea auctions, if any.
-		int opensea_num_shown = 0;
-		if(num_auctions_shown == 0)
+		if(post->state == NewsPost::State_published)
 		{
-			auction_html += "<div class=\"root-auction-list-container\">\n";
-			for(auto it = world_state.opensea_parcel_listings.begin(); (it != world_state.opensea_parcel_listings.end()) && (opensea_num_shown < 3); ++it)
-			{
-				const OpenSeaParcelListing& listing = *it;
+			latest_news_html += "<div class=\"root-news-div\">";
 
-				auto parcel_res = root_world->getParcels(lock).find(listing.parcel_id); // Look up parcel
-				if(parcel_res != root_world->getParcels(lock).end())
-				{
-					const Parcel* parcel = parcel_res->second.ptr();
+			const std::string post_url = "/news_post/" + toString(post->id);
 
-					if(parcel->screenshot_ids.size() >= 1)
-					{
-						const uint64 shot_id = parcel->screenshot_ids[0]; // Close-in screenshot
+			if(post->thumbnail_URL.empty())
+				latest_news_html += "<div class=\"root-news-thumb-div\"><a href=\"" + post_url + "\"><img src=\"/files/default_thumb.jpg\" class=\"root-news-thumbnail\" /></a></div>";
+			else
+				latest_news_html += "<div class=\"root-news-thumb-div\"><a href=\"" + post_url + "\"><img src=\"" + post->thumbnail_URL + "\" class=\"root-news-thumbnail\" /></a></div>";
 
-						const std::string opensea_url = "https://opensea.io/assets/ethereum/0xa4535f84e8d746462f9774319e75b25bc151ba1d/" + listing.parcel_id.toString();
+			latest_news_html += "<div class=\"root-news-title\"><a href=\"" + post_url + "\">" + post->title + "</a></div>";
+			//latest_news_html += "<div class=\"root-news-content\"><a href=\"" + post_url + "\">" + web::ResponseUtils::getPrefixWithStrippedTags(post->content, /*max len=*/200) + "</a></div>";
 
-						auction_html += "<div class=\"root-auction-div\"><a href=\"/parcel/" + parcel->id.toString() + "\"><img src=\"/screenshot/" + toString(shot_id) + "\" class=\"root-auction-thumbnail\" alt=\"screenshot\" /></a>  <br/>"
-							"<a href=\"/parcel/" + parcel->id.toString() + "\">Parcel " + parcel->id.toString() + "</a> <a href=\"" + opensea_url + "\">View&nbsp;on&nbsp;OpenSea</a></div>";
-					}
+			latest_news_html += "</div>";
 
-					opensea_num_shown++;
-				}
-			}
-			auction_html += "</div>\n";
+			num_displayed++;
 		}
+	}
+	latest_news_html += "</div>\n";
 
-		if(num_auctions_shown == 0 && opensea_num_shown == 0)
-			auction_html += "<p>Sorry, there are no parcels for sale here right now.  Please check back later!</p>";
+	return latest_news_html;
+}
 
 
+static std::string renderRootPageEventsHTML(ServerAllWorldsState& world_state, WorldStateLock& /*lock*/) REQUIRES(world_state.mutex)
+{
+	std::string events_html;
+	events_html += "<div class=\"root-events-div-container\">\n";
+	const int max_num_events_to_display = 4;
+	int num_events_displayed = 0;
+	for(auto it = world_state.events.rbegin(); (it != world_state.events.rend()) && (num_events_displayed < max_num_events_to_display); ++it)
+	{
+		const SubEvent* event = it->second.ptr();
 
-		// Build latest news HTML
-		latest_news_html += "<div class=\"root-news-div-container\">\n";
-		const int max_num_to_display = 4;
-		int num_displayed = 0;
-		for(auto it = world_state.news_posts.rbegin(); it != world_state.news_posts.rend() && num_displayed < max_num_to_display; ++it)
+		// We don't want to show old events, so end time has to be in the future, or sometime today, e.g. end_time >= (current time - 24 hours)
+		const TimeStamp min_end_time(TimeStamp::currentTime().time - 24 * 3600);
+		if((event->end_time >= min_end_time) && (event->state == SubEvent::State_published))
 		{
-			NewsPost* post = it->second.ptr();
-
-			if(post->state == NewsPost::State_published)
-			{
-				latest_news_html += "<div class=\"root-news-div\">";
+			events_html += "<div class=\"root-event-div\">";
 
-				const std::string post_url = "/news_post/" + toString(post->id);
+			events_html += "<div class=\"root-event-title\"><a href=\"/event/" + toString(event->id) + "\">" + web::Escaping::HTMLEscape(event->title) + "</a></div>";
 
-				if(post->thumbnail_URL.empty())
-					latest_news_html += "<div class=\"root-news-thumb-div\"><a href=\"" + post_url + "\"><img src=\"/files/default_thumb.jpg\" class=\"root-news-thumbnail\" /></a></div>";
-				else
-					latest_news_html += "<div class=\"root-news-thumb-div\"><a href=\"" + post_url + "\"><img src=\"" + post->thumbnail_URL + "\" class=\"root-news-thumbnail\" /></a></div>";
+			events_html += "<div class=\"root-event-description\">";
+			const size_t MAX_DESCRIP_SHOW_LEN = 80;
+			events_html += web::Escaping::HTMLEscape(event->description.substr(0, MAX_DESCRIP_SHOW_LEN));
+			if(event->description.size() > MAX_DESCRIP_SHOW_LEN)
+				events_html += "...";
+			events_html += "</div>";
 
-				latest_news_html += "<div class=\"root-news-title\"><a href=\"" + post_url + "\">" + post->title + "</a></div>";
-				//latest_news_html += "<div class=\"root-news-content\"><a href=\"" + post_url + "\">" + web::ResponseUtils::getPrefixWithStrippedTags(post->content, /*max len=*/200) + "</a></div>";
+			events_html += "<div class=\"root-event-time\">" + event->start_time.dayAndTimeStringUTC() + "</div>";
 
-				latest_news_html += "</div>";
+			events_html += "</div>";
 
-				num_displayed++;
-			}
+			num_events_displayed++;
 		}
-		latest_news_html += "</div>\n";
+	}
+	if(num_events_displayed == 0)
+		events_html += "There are no upcoming events.  Create one!";
+	events_html += "</div>\n";
+
+	return events_html;
+}
 
 
-		// Build events HTML
-		events_html += "<div class=\"root-events-div-container\">\n";
-		const int max_num_events_to_display = 4;
-		int num_events_displayed = 0;
-		for(auto it = world_state.events.rbegin(); (it != world_state.events.rend()) && (num_events_displayed < max_num_events_to_display); ++it)
+static std::string renderRootPagePhotosHTML(ServerAllWorldsState& world_state, WorldStateLock& /*lock*/) REQUIRES(world_state.mutex)
+{
+	std::string photos_html;
+	photos_html += "<div class=\"photo-container\">\n";
+	const int max_num_photos_to_display = 20;
+	int num_photos_displayed = 0;
+	for(auto it = world_state.photos.rbegin(); (it != world_state.photos.rend()) && (num_photos_displayed < max_num_photos_to_display); ++it)
+	{
+		const Photo* photo = it->second.ptr();
+		if(photo->state == Photo::State_published)
 		{
-			const SubEvent* event = it->second.ptr();
+			const std::string thumb_URL = "/photo_thumb_image/" + toString(photo->id);
+			photos_html += "<a href=\"/photo/" + toString(photo->id) + "\"><img src=\"" + thumb_URL + "\" class=\"root-photo-img\"/></a>";
 
-			// We don't want to show old events, so end time has to be in the future, or sometime today, e.g. end_time >= (current time - 24 hours)
-			const TimeStamp min_end_time(TimeStamp::currentTime().time - 24 * 3600);
-			if((event->end_time >= min_end_time) && (event->state == SubEvent::State_published))
-			{
-				events_html += "<div class=\"root-event-div\">";
+			num_photos_displayed++;
+		}
+	}
 
-				events_html += "<div class=\"root-event-title\"><a href=\"/event/" + toString(event->id) + "\">" + web::Escaping::HTMLEscape(event->title) + "</a></div>";
+	photos_html += "</div>\n";
 
-				events_html += "<div class=\"root-event-description\">";
-				const size_t MAX_DESCRIP_SHOW_LEN = 80;
-				events_html += web::Escaping::HTMLEscape(event->description.substr(0, MAX_DESCRIP_SHOW_LEN));
-				if(event->description.size() > MAX_DESCRIP_SHOW_LEN)
-					events_html += "...";
-				events_html += "</div>";
+	return photos_html;
+}
 
-				events_html += "<div class=\"root-event-time\">" + event->start_time.dayAndTimeStringUTC() + "</div>";
 
-				events_html += "</div>";
+void renderRootPage(ServerAllWorldsState& world_state, WebDataStore& data_store, const web::RequestInfo& request_info, web::ReplyInfo& reply_info)
+{
+	//std::string page_out = WebServerResponseUtils::standardHeader(world_state, request_info, /*page title=*/"Substrata");
+	//const bool logged_in = LoginHandlers::isLoggedInAsNick(data_store, request_info);
 
-				num_events_displayed++;
-			}
-		}
-		if(num_events_displayed == 0)
-			events_html += "There are no upcoming events.  Create one!";
-		events_html += "</div>\n";
+	std::string page_out = WebServerResponseUtils::standardHTMLHeader(data_store, request_info, /*page title=*/"Metasiberia");
+	page_out +=
+		"	<body class=\"root-body\">\n"
+		"	<div id=\"login\">\n"; // Start login div
 
+	web::UnsafeString logged_in_username;
+	bool is_user_admin;
+	const bool logged_in = LoginHandlers::isLoggedIn(world_state, request_info, logged_in_username, is_user_admin);
 
-		//------------------------------- Build photos grid view HTML --------------------------
-		photos_html += "<div class=\"photo-container\">\n";
-		const int max_num_photos_to_display = 20;
-		int num_photos_displayed = 0;
-		for(auto it = world_state.photos.rbegin(); (it != world_state.photos.rend()) && (num_photos_displayed < max_num_photos_to_display); ++it)
-		{
-			const Photo* photo = it->second.ptr();
-			if(photo->state == Photo::State_published)
-			{
-				const std::string thumb_URL = "/photo_thumb_image/" + toString(photo->id);
-				photos_html += "<a href=\"/photo/" + toString(photo->id) + "\"><img src=\"" + thumb_URL + "\" class=\"root-photo-img\"/></a>";
+	if(logged_in)
+	{
+		page_out += "You are logged in as <a href=\"/account\">" + logged_in_username.HTMLEscaped() + "</a>";
+
+		// Add logout button
+		page_out += "<form action=\"/logout_post\" method=\"post\">\n";
+		page_out += "<input class=\"link-button\" type=\"submit\" value=\"Log out\">\n";
+		page_out += "</form>\n";
+	}
+	else
+	{
+		page_out += "<a href=\"/login\">log in</a> <br/>\n";
+	}
+	page_out += 
+		"	</div>																									\n"; // End login div
+
+
+	//page_out += "<img src=\"/files/logo_main_page.png\" alt=\"substrata logo\" class=\"logo-root-page\" />";
 
-				num_photos_displayed++;
-			}
-		}
 
-		photos_html += "</div>\n";
+	// The dynamic parts of the page are rendered from cached fragments where possible, so that anonymous page views don't need to take the world state lock.
+	WebPageCache& cache = world_state.web_page_cache;
 
-	} // end lock scope
+	const std::string auction_html = cache.getOrRender("root_auctions", world_state.parcel_auctions_version, ROOT_AUCTIONS_MAX_AGE_S, [&]() {
+		WorldStateLock lock(world_state.mutex);
+		return renderRootPageAuctionsHTML(world_state, lock);
+	});
+
+	const std::string latest_news_html = cache.getOrRender("root_news", world_state.news_posts_version, ROOT_NEWS_AND_PHOTOS_MAX_AGE_S, [&]() {
+		WorldStateLock lock(world_state.mutex);
+		return renderRootPageNewsHTML(world_state, lock);
+	});
+
+	const std::string events_html = cache.getOrRender("root_events", world_state.events_version, ROOT_EVENTS_MAX_AGE_S, [&]() {
+		WorldStateLock lock(world_state.mutex);
+		return renderRootPageEventsHTML(world_state, lock);
+	});
+
+	const std::string photos_html = cache.getOrRender("root_photos", world_state.photos_version, ROOT_NEWS_AND_PHOTOS_MAX_AGE_S, [&]() {
+		WorldStateLock lock(world_state.mutex);
+		return renderRootPagePhotosHTML(world_state, lock);
+	});
 
 
 	Reference<WebDataStoreFile> store_file = data_store.getFragmentFile("root_page.htmlfrag");
@@ -244,7 +288,7 @@ void renderRootPage(ServerAllWorldsState& world_state, WebDataStore& data_store,
 	
 	page_out += WebServerResponseUtils::standardFooter(request_info, true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page_out);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request_info, reply_info, page_out);
 }
 
 
@@ -288,7 +332,7 @@ void renderTermsOfUse(ServerAllWorldsState& world_state, const web::RequestInfo&
 
 	page += WebServerResponseUtils::standardFooter(request_info, true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request_info, reply_info, page);
 }
 
 
@@ -339,7 +383,7 @@ void renderAboutParcelSales(ServerAllWorldsState& world_state, const web::Reques
 
 	page += WebServerResponseUtils::standardFooter(request_info, true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request_info, reply_info, page);
 }
 
 
@@ -688,7 +732,7 @@ void renderFAQ(ServerAllWorldsState& world_state, const web::RequestInfo& reques
 
 	page += WebServerResponseUtils::standardFooter(request_info, true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request_info, reply_info, page);
 }
 
 
@@ -704,7 +748,7 @@ void renderAboutScripting(ServerAllWorldsState& world_state, WebDataStore& data_
 
 	page += WebServerResponseUtils::standardFooter(request_info, /*include_email_link=*/true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request_info, reply_info, page);
 }
 
 
@@ -720,7 +764,7 @@ void renderGenericPage(ServerAllWorldsState& world_state, WebDataStore& data_sto
 
 	page += WebServerResponseUtils::standardFooter(request_info, /*include_email_link=*/true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request_info, reply_info, page);
 }
 
 
@@ -736,7 +780,7 @@ void renderAboutSubstrataPage(ServerAllWorldsState& world_state, WebDataStore& d
 
 	page += WebServerResponseUtils::standardFooter(request_info, true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request_info, reply_info, page);
 }
 
 
@@ -752,7 +796,7 @@ void renderRunningYourOwnServerPage(ServerAllWorldsState& world_state, WebDataSt
 	
 	page += WebServerResponseUtils::standardFooter(request_info, true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request_info, reply_info, page);
 }
 
 
@@ -772,7 +816,7 @@ void renderNotFoundPage(ServerAllWorldsState& world_state, const web::RequestInf
 	page_out += "</div>"; // main div
 	page_out += "</body></html>";
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page_out);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request_info, reply_info, page_out);
 }
 
 
@@ -815,7 +859,7 @@ void renderBotStatusPage(ServerAllWorldsState& world_state, const web::RequestIn
 
 	page += WebServerResponseUtils::standardFooter(request_info, true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request_info, reply_info, page);
 }
 
 
@@ -824,11 +868,14 @@ void renderMapPage(ServerAllWorldsState& world_state, const web::RequestInfo& re
 	const std::string extra_header_tags = WebServerResponseUtils::getMapHeaderTags();
 	std::string page = WebServerResponseUtils::standardHeader(world_state, request_info, /*page title=*/"Map", extra_header_tags);
 
-	page += WebServerResponseUtils::getMapEmbedCode(world_state, /*highlighted_parcel_id=*/ParcelID::invalidParcelID());
+	// Parcel ownership changes that don't go through an auction are picked up when the cached fragment expires.
+	page += world_state.web_page_cache.getOrRender("map_embed", world_state.parcel_auctions_version, /*max age s=*/60, [&]() {
+		return WebServerResponseUtils::getMapEmbedCode(world_state, /*highlighted_parcel_id=*/ParcelID::invalidParcelID());
+	});
 
 	page += WebServerResponseUtils::standardFooter(request_info, true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request_info, reply_info, page);
 }
 
 
@@ -43,8 +43,17 @@ void renderNewsPostPage(ServerAllWorldsState& world_state, const web::RequestInf
 		if(!parser.parseUnsignedInt(post_id))
 			throw glare::Exception("Failed to parse post id");
 
+		// Anonymous views are served from the page cache if possible, without taking the world state lock.
+		const bool anonymous = !LoginHandlers::hasSessionCookie(request);
+		const std::string cache_key = "news_post/" + toString(post_id);
+		const uint64 content_version = world_state.news_posts_version;
 		
 		std::string page;
+		if(anonymous && world_state.web_page_cache.getFragment(cache_key, content_version, /*max age s=*/600, page))
+		{
+			web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+			return;
+		}
 
 		{ // lock scope
 			Lock lock(world_state.mutex);
@@ -115,6 +124,9 @@ void renderNewsPostPage(ServerAllWorldsState& world_state, const web::RequestInf
 		page += "</div>   \n"; // end main div
 		page += WebServerResponseUtils::standardFooter(request, true);
 
+		if(anonymous)
+			world_state.web_page_cache.putFragment(cache_key, content_version, page);
+
 		web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
 	}
 	catch(glare::Exception& e)
@@ -137,10 +149,12 @@ void renderAllNewsPage(ServerAllWorldsState& world_state, const web::RequestInfo
 
 		const int max_num_to_display = 5;
 
-		{ // Lock scope
-
+		// The post list is cached, so anonymous views don't need to take the world state lock.
+		page += world_state.web_page_cache.getOrRender("news?start=" + toString(start), world_state.news_posts_version, /*max age s=*/600, [&]() {
 			Lock lock(world_state.mutex);
 
+			std::string list_html;
+
 			// Advance to 'start' offset.  Use reverse iterators to show most recent posts first.
 			auto it = world_state.news_posts.rbegin();
 			for(int i=0; it != world_state.news_posts.rend() && i < start; ++it, ++i)
@@ -152,14 +166,14 @@ void renderAllNewsPage(ServerAllWorldsState& world_state, const web::RequestInfo
 				const NewsPost* post = it->second.ptr();
 				if(post->state == NewsPost::State_published)
 				{
-					page += "<h2><a href=\"/news_post/" + toString(post->id) + "\">" + post->title + "</a></h2>"; // Insert unescaped content!
-					page += "<div class=\"news-post-timestamp\">" + post->created_time.dayString() + "</div>";
-					page += "<div class=\"news-post-content\">\n";
-					page += post->content; // Insert unescaped content!
-					//page += web::ResponseUtils::getPrefixWithStrippedTags(post->content, 200); // Insert unescaped content!
-					page += "</div>\n";
+					list_html += "<h2><a href=\"/news_post/" + toString(post->id) + "\">" + post->title + "</a></h2>"; // Insert unescaped content!
+					list_html += "<div class=\"news-post-timestamp\">" + post->created_time.dayString() + "</div>";
+					list_html += "<div class=\"news-post-content\">\n";
+					list_html += post->content; // Insert unescaped content!
+					//list_html += web::ResponseUtils::getPrefixWithStrippedTags(post->content, 200); // Insert unescaped content!
+					list_html += "</div>\n";
 
-					page += "<br/>\n";
+					list_html += "<br/>\n";
 
 					num_displayed++;
 				}
@@ -167,7 +181,7 @@ void renderAllNewsPage(ServerAllWorldsState& world_state, const web::RequestInfo
 
 			// Show 'newer posts' link if there are any newer posts.
 			if(start > 0)
-				page += "<a href=\"/news?start=" + toString(myMax(0, start - max_num_to_display)) + "\">&lt; Newer posts</a>\n";
+				list_html += "<a href=\"/news?start=" + toString(myMax(0, start - max_num_to_display)) + "\">&lt; Newer posts</a>\n";
 		
 			// Show 'older posts' link if there are any older posts.
 			const int next_start = start + max_num_to_display;
@@ -175,11 +189,12 @@ void renderAllNewsPage(ServerAllWorldsState& world_state, const web::RequestInfo
 			if(num_older_posts_remaining > 0)
 			{
 				if(start > 0)
-					page += " | ";
-				page += "<a href=\"/news?start=" + toString(next_start) + "\">Older posts &gt;</a>  \n";
+					list_html += " | ";
+				list_html += "<a href=\"/news?start=" + toString(next_start) + "\">Older posts &gt;</a>  \n";
 			}
 
-		} // end lock scope
+			return list_html;
+		});
 
 		page += "</div>   \n"; // end main div
 		page += WebServerResponseUtils::standardFooter(request, true);
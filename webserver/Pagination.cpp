@@ -0,0 +1,187 @@
+/*=====================================================================
+Pagination.cpp
+--------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#include "Pagination.h"
+
+
+#include "RequestInfo.h"
+#include "Escaping.h"
+#include <Exception.h>
+#include <maths/mathstypes.h>
+
+
+namespace Pagination
+{
+
+
+PageParams parsePageParams(const web::RequestInfo& request, bool default_descending)
+{
+	PageParams params;
+
+	params.page_size = DEFAULT_PAGE_SIZE;
+	if(request.isURLParamPresent("page_size"))
+		params.page_size = (size_t)myClamp(request.getURLIntParam("page_size"), 1, (int)MAX_PAGE_SIZE);
+
+	params.descending = default_descending;
+	const std::string order = request.getURLParam("order").str();
+	if(order == "asc")
+		params.descending = false;
+	else if(order == "desc")
+		params.descending = true;
+
+	params.after = request.getURLParam("after").str();
+	return params;
+}
+
+
+bool parseIntCursor(const PageParams& params, uint64& cursor_out)
+{
+	if(params.after.empty())
+		return false;
+
+	try
+	{
+		cursor_out = stringToUInt64(params.after);
+		return true;
+	}
+	catch(StringUtilsExcep&)
+	{
+		throw glare::Exception("Invalid page cursor");
+	}
+}
+
+
+std::string makePageLinksHTML(const std::string& base_URL, const PageParams& params, bool have_next_page, const std::string& next_cursor, bool show_reverse_order_link)
+{
+	const std::string URL_prefix = base_URL + ((base_URL.find('?') == std::string::npos) ? "?" : "&");
+	const std::string page_size_param = (params.page_size != DEFAULT_PAGE_SIZE) ? ("&page_size=" + toString(params.page_size)) : std::string();
+	const std::string order_param = std::string("order=") + (params.descending ? "desc" : "asc");
+
+	std::string html = "<p>";
+	if(!params.after.empty())
+		html += "<a href=\"" + URL_prefix + order_param + page_size_param + "\">&lt;&lt; First page</a> &nbsp; ";
+	if(have_next_page)
+		html += "<a href=\"" + URL_prefix + order_param + page_size_param + "&after=" + web::Escaping::URLEscape(next_cursor) + "\">Next page &gt;</a> &nbsp; ";
+	if(show_reverse_order_link)
+		html += "<a href=\"" + URL_prefix + (params.descending ? "order=asc" : "order=desc") + page_size_param + "\">Reverse order</a>";
+	html += "</p>\n";
+	return html;
+}
+
+
+} // end namespace Pagination
+
+
+#if BUILD_TESTS
+
+
+#include <utils/TestUtils.h>
+#include <utils/ConPrint.h>
+#include <map>
+
+
+void Pagination::test()
+{
+	conPrint("Pagination::test()");
+
+	// Test getMapPage: paging through the whole map in either direction should visit each item exactly once, in order.
+	{
+		std::map<uint64, int> map;
+		for(int i=0; i<95; ++i)
+			map[(uint64)i * 3] = i;
+
+		for(int desc=0; desc<2; ++desc)
+		for(size_t page_size=1; page_size<=100; page_size += 7)
+		{
+			std::vector<std::map<uint64, int>::const_iterator> page;
+			std::vector<int> visited;
+			uint64 cursor = 0;
+			bool have_cursor = false;
+			while(1)
+			{
+				const bool more = getMapPage(map, have_cursor ? &cursor : NULL, desc != 0, page_size, page);
+				testAssert(page.size() <= page_size);
+				for(size_t i=0; i<page.size(); ++i)
+					visited.push_back(page[i]->second);
+				if(!more)
+					break;
+				testAssert(page.size() == page_size);
+				cursor = page.back()->first;
+				have_cursor = true;
+			}
+
+			testAssert(visited.size() == map.size());
+			for(size_t i=0; i<visited.size(); ++i)
+				testAssert(visited[i] == (desc ? (int)(map.size() - 1 - i) : (int)i));
+		}
+
+		// Cursor that is not a key in the map
+		std::vector<std::map<uint64, int>::const_iterator> page;
+		uint64 cursor = 4;
+		getMapPage(map, &cursor, /*descending=*/false, 2, page);
+		testAssert(page.size() == 2 && page[0]->first == 6 && page[1]->first == 9);
+		getMapPage(map, &cursor, /*descending=*/true, 10, page);
+		testAssert(page.size() == 2 && page[0]->first == 3 && page[1]->first == 0);
+
+		// Empty map
+		std::map<uint64, int> empty_map;
+		testAssert(!getMapPage(empty_map, NULL, false, 10, page) && page.empty());
+		testAssert(!getMapPage(empty_map, NULL, true, 10, page) && page.empty());
+	}
+
+	// Test getSortedVectorPage
+	{
+		std::vector<int> keys;
+		for(int i=0; i<20; ++i)
+			keys.push_back(i * 2);
+
+		std::vector<int> page;
+		testAssert(getSortedVectorPage(keys, (const int*)NULL, false, 3, page));
+		testAssert(page.size() == 3 && page[0] == 0 && page[2] == 4);
+		int cursor = 4;
+		testAssert(getSortedVectorPage(keys, &cursor, false, 3, page));
+		testAssert(page.size() == 3 && page[0] == 6 && page[2] == 10);
+		cursor = 34;
+		testAssert(!getSortedVectorPage(keys, &cursor, false, 3, page));
+		testAssert(page.size() == 2 && page[0] == 36 && page[1] == 38);
+
+		testAssert(getSortedVectorPage(keys, (const int*)NULL, true, 3, page));
+		testAssert(page.size() == 3 && page[0] == 38 && page[2] == 34);
+		cursor = 5;
+		testAssert(!getSortedVectorPage(keys, &cursor, true, 3, page));
+		testAssert(page.size() == 3 && page[0] == 4 && page[2] == 0);
+	}
+
+	// Test getStringPrefixPage
+	{
+		std::map<std::string, int> map;
+		const char* names[] = { "alice", "bob", "bobby", "bobcat", "bobo", "carol", "dave" };
+		for(int i=0; i<(int)staticArrayNumElems(names); ++i)
+			map[names[i]] = i;
+
+		std::vector<std::map<std::string, int>::const_iterator> page;
+		testAssert(getStringPrefixPage(map, "bob", NULL, 2, page));
+		testAssert(page.size() == 2 && page[0]->first == "bob" && page[1]->first == "bobby");
+		std::string cursor = "bobby";
+		testAssert(!getStringPrefixPage(map, "bob", &cursor, 2, page));
+		testAssert(page.size() == 2 && page[0]->first == "bobcat" && page[1]->first == "bobo");
+
+		testAssert(!getStringPrefixPage(map, "", NULL, 100, page));
+		testAssert(page.size() == map.size());
+
+		testAssert(!getStringPrefixPage(map, "zed", NULL, 100, page));
+		testAssert(page.empty());
+
+		// A cursor before the prefix range should start at the start of the range.
+		cursor = "a";
+		testAssert(!getStringPrefixPage(map, "c", &cursor, 100, page));
+		testAssert(page.size() == 1 && page[0]->first == "carol");
+	}
+
+	conPrint("Pagination::test() done.");
+}
+
+
+#endif // BUILD_TESTS
@@ -0,0 +1,116 @@
+/*=====================================================================
+Pagination.h
+------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#pragma once
+
+
+#include <StringUtils.h>
+#include <Platform.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+namespace web
+{
+class RequestInfo;
+}
+
+
+/*=====================================================================
+Pagination
+----------
+Cursor-based pagination for the admin list pages.
+
+A page is identified by the key of the last item on the previous page
+(the cursor), instead of by an offset.  Finding the start of a page is
+then a lookup in an ordered map or sorted index, so rendering a page only
+touches O(page size) items, regardless of how many items there are.
+=====================================================================*/
+namespace Pagination
+{
+	static const size_t DEFAULT_PAGE_SIZE = 100;
+	static const size_t MAX_PAGE_SIZE = 1000;
+
+
+	struct PageParams
+	{
+		size_t page_size;
+		bool descending; // If true, show items with the greatest keys (e.g. the most recently created) first.
+		std::string after; // Cursor: key of the last item on the previous page, or empty for the first page.
+	};
+
+	// Reads the 'page_size', 'order' ('asc' or 'desc') and 'after' URL params.
+	PageParams parsePageParams(const web::RequestInfo& request, bool default_descending);
+
+	// Parses params.after as an integer key.  Returns false if there is no cursor.  Throws glare::Exception if the cursor is invalid.
+	bool parseIntCursor(const PageParams& params, uint64& cursor_out);
+
+	// Makes the links to the first and next pages, and optionally to reverse the order.
+	// base_URL should include any other URL params, such as filters, e.g. "/admin_users?sort=name".
+	std::string makePageLinksHTML(const std::string& base_URL, const PageParams& params, bool have_next_page, const std::string& next_cursor, bool show_reverse_order_link = true);
+
+
+	// Gets the page of items of an ordered map (e.g. std::map) that follow cursor in ascending or descending key order, or the first page if cursor is NULL.
+	// Returns true if there are more items after this page.
+	template <class MapType>
+	bool getMapPage(const MapType& map, const typename MapType::key_type* cursor, bool descending, size_t page_size, std::vector<typename MapType::const_iterator>& page_out)
+	{
+		page_out.clear();
+		if(!descending)
+		{
+			typename MapType::const_iterator it = cursor ? map.upper_bound(*cursor) : map.begin();
+			for(; it != map.end() && page_out.size() < page_size; ++it)
+				page_out.push_back(it);
+			return it != map.end();
+		}
+		else
+		{
+			typename MapType::const_iterator it = cursor ? map.lower_bound(*cursor) : map.end(); // Items before it have keys < cursor.
+			while(it != map.begin() && page_out.size() < page_size)
+			{
+				--it;
+				page_out.push_back(it);
+			}
+			return it != map.begin();
+		}
+	}
+
+
+	// As getMapPage, for a secondary index stored as a sorted vector of keys.
+	template <class T>
+	bool getSortedVectorPage(const std::vector<T>& sorted_keys, const T* cursor, bool descending, size_t page_size, std::vector<T>& page_out)
+	{
+		page_out.clear();
+		if(!descending)
+		{
+			size_t i = cursor ? (std::upper_bound(sorted_keys.begin(), sorted_keys.end(), *cursor) - sorted_keys.begin()) : 0;
+			for(; i < sorted_keys.size() && page_out.size() < page_size; ++i)
+				page_out.push_back(sorted_keys[i]);
+			return i < sorted_keys.size();
+		}
+		else
+		{
+			size_t i = cursor ? (std::lower_bound(sorted_keys.begin(), sorted_keys.end(), *cursor) - sorted_keys.begin()) : sorted_keys.size();
+			while(i > 0 && page_out.size() < page_size)
+				page_out.push_back(sorted_keys[--i]);
+			return i > 0;
+		}
+	}
+
+
+	// Gets the page of items of an ordered map with string keys, whose keys start with prefix, that follow cursor in ascending key order.
+	// Returns true if there are more matching items after this page.
+	template <class MapType>
+	bool getStringPrefixPage(const MapType& map, const std::string& prefix, const std::string* cursor, size_t page_size, std::vector<typename MapType::const_iterator>& page_out)
+	{
+		page_out.clear();
+		typename MapType::const_iterator it = (cursor && *cursor >= prefix) ? map.upper_bound(*cursor) : map.lower_bound(prefix);
+		for(; it != map.end() && ::hasPrefix(it->first, prefix) && page_out.size() < page_size; ++it)
+			page_out.push_back(it);
+		return it != map.end() && ::hasPrefix(it->first, prefix);
+	}
+
+
+	void test();
+}
@@ -298,7 +298,7 @@ void renderParcelPage(ServerAllWorldsState& world_state, const web::RequestInfo&
 		page += "</div>   \n"; // end main div
 		page += WebServerResponseUtils::standardFooter(request, true);
 
-		web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+		WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 	}
 	catch(glare::Exception& e)
 	{
@@ -335,7 +335,7 @@ void renderEditParcelDescriptionPage(ServerAllWorldsState& world_state, const we
 	page += "</div>   \n"; // end main div
 	page += WebServerResponseUtils::standardFooter(request, true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 }
 
 
@@ -375,7 +375,7 @@ void renderAddParcelWriterPage(ServerAllWorldsState& world_state, const web::Req
 	page += "</div>   \n"; // end main div
 	page += WebServerResponseUtils::standardFooter(request, true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 }
 
 
@@ -421,7 +421,7 @@ void renderRemoveParcelWriterPage(ServerAllWorldsState& world_state, const web::
 	page += "</div>   \n"; // end main div
 	page += WebServerResponseUtils::standardFooter(request, true);
 
-	web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+	WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 }
 
 
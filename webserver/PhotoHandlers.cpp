@@ -77,13 +77,11 @@ void doHandlePhotoImageRequest(ServerAllWorldsState& world_state, WebDataStore&
 
 		try
 		{
-			MemMappedFile file(local_path);
-			
 			assert(web::ResponseUtils::getContentTypeForPath(local_path) == "image/jpeg");
 			const std::string content_type = "image/jpeg";
 
-			// Send it to client
-			web::ResponseUtils::writeHTTPOKHeaderAndDataWithCacheMaxAge(reply_info, file.fileData(), file.fileSize(), content_type, 3600*24*52); // cache max age = 1 year
+			// Send it to client.  The image files for a photo never change, so they can be cached indefinitely.
+			WebServerResponseUtils::writeImageFileWithETag(world_state, request, reply_info, local_path, content_type, /*cache control=*/"max-age=31536000, immutable"); // cache max age = 1 year
 		}
 		catch(glare::Exception& e)
 		{
@@ -30,6 +30,10 @@ namespace ResourceHandlers
 {
 
 
+// Responses with bodies up to this size are written with a single socket write.
+static const size_t MAX_COALESCED_RESPONSE_SIZE = 256 * 1024;
+
+
 void handleResourceRequest(ServerAllWorldsState& world_state, const web::RequestInfo& request, web::ReplyInfo& reply_info)
 {
 	try
@@ -184,7 +188,27 @@ void handleResourceRequest(ServerAllWorldsState& world_state, const web::Request
 				{
 					// conPrint("handleResourceRequest: serving data for '" + resource_URL + "' (len: " + toString(file.fileSize()) + " B)");
 
-					web::ResponseUtils::writeHTTPOKHeaderAndDataWithCacheControl(reply_info, file.fileData(), file.fileSize(), content_type.c_str(), /*cache control=*/"max-age=1000000000, immutable");
+					std::string response =
+						"HTTP/1.1 200 OK\r\n"
+						"Content-Type: " + content_type + "\r\n"
+						"Cache-Control: max-age=1000000000, immutable\r\n"
+						"Connection: Keep-Alive\r\n"
+						"Content-Length: " + toString(file.fileSize()) + "\r\n"
+						"\r\n";
+
+					// The webclient fetches many small resources (textures, meshes) over keep-alive connections.
+					// For small resources, write the header and body with a single write, so the header isn't sent in a packet by itself,
+					// which can delay the body by a round trip (Nagle's algorithm interacting with delayed ACKs on the client).
+					if(file.fileSize() <= MAX_COALESCED_RESPONSE_SIZE)
+					{
+						response.append((const char*)file.fileData(), file.fileSize());
+						reply_info.socket->writeData(response.data(), response.size());
+					}
+					else
+					{
+						reply_info.socket->writeData(response.data(), response.size());
+						reply_info.socket->writeData(file.fileData(), file.fileSize());
+					}
 
 					// conPrint("\thandleResourceRequest: sent data. (len: " + toString(file.fileSize()) + ")");
 				}
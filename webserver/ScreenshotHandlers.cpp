@@ -57,12 +57,10 @@ void handleScreenshotRequest(ServerAllWorldsState& world_state, WebDataStore& da
 
 		try
 		{
-			MemMappedFile file(local_path); // Load screenshot file
-			
 			const std::string content_type = web::ResponseUtils::getContentTypeForPath(local_path);
 
-			// Send it to client
-			web::ResponseUtils::writeHTTPOKHeaderAndDataWithCacheMaxAge(reply_info, file.fileData(), file.fileSize(), content_type, 3600*24*14); // cache max age = 2 weeks
+			// Send it to client.  A screenshot can be retaken, giving it a new local path, so don't mark as immutable.
+			WebServerResponseUtils::writeImageFileWithETag(world_state, request, reply_info, local_path, content_type, /*cache control=*/"max-age=" + toString(3600*24*14)); // cache max age = 2 weeks
 		}
 		catch(glare::Exception&)
 		{
@@ -105,12 +103,12 @@ void handleMapTileRequest(ServerAllWorldsState& world_state, WebDataStore& datas
 
 		try
 		{
-			MemMappedFile file(local_path); // Load screenshot file
-			
 			const std::string content_type = web::ResponseUtils::getContentTypeForPath(local_path);
 
-			// Send it to client
-			web::ResponseUtils::writeHTTPOKHeaderAndDataWithCacheMaxAge(reply_info, file.fileData(), file.fileSize(), content_type, 3600*24*14); // cache max age = 2 weeks
+			// Send it to client.
+			// The tile at a given x, y, z is updated when it is re-rendered, or rebuilt from its child tiles, so use a short max age.
+			// After that the browser revalidates with If-None-Match, which gets a 304 response if the tile hasn't changed.
+			WebServerResponseUtils::writeImageFileWithETag(world_state, request, reply_info, local_path, content_type, /*cache control=*/"max-age=3600"); // cache max age = 1 hour
 		}
 		catch(glare::Exception&)
 		{
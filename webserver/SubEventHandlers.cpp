@@ -40,8 +40,18 @@ void renderEventPage(ServerAllWorldsState& world_state, const web::RequestInfo&
 		if(!parser.parseUInt64(event_id))
 			throw glare::Exception("Failed to parse event id");
 
+		// Anonymous views are served from the page cache if possible, without taking the world state lock.
+		// The page shows the time until the event starts, so use a short max age.
+		const bool anonymous = !LoginHandlers::hasSessionCookie(request);
+		const std::string cache_key = "event/" + toString(event_id);
+		const uint64 content_version = world_state.events_version;
 		
 		std::string page;
+		if(anonymous && world_state.web_page_cache.getFragment(cache_key, content_version, /*max age s=*/60, page))
+		{
+			web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+			return;
+		}
 
 		{ // lock scope
 			Lock lock(world_state.mutex);
@@ -143,6 +153,9 @@ void renderEventPage(ServerAllWorldsState& world_state, const web::RequestInfo&
 		page += "</div>   \n"; // end main div
 		page += WebServerResponseUtils::standardFooter(request, true);
 
+		if(anonymous)
+			world_state.web_page_cache.putFragment(cache_key, content_version, page);
+
 		web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
 	}
 	catch(glare::Exception& e)
@@ -165,10 +178,12 @@ void renderAllEventsPage(ServerAllWorldsState& world_state, const web::RequestIn
 
 		const int max_num_to_display = 8;
 
-		{ // Lock scope
-
+		// The event list is cached, so anonymous views don't need to take the world state lock.
+		page += world_state.web_page_cache.getOrRender("events?start=" + toString(start), world_state.events_version, /*max age s=*/600, [&]() {
 			Lock lock(world_state.mutex);
 
+			std::string list_html;
+
 			// Advance to 'start' offset.  Use reverse iterators to show most recent posts first.
 			auto it = world_state.events.rbegin();
 			for(int i=0; it != world_state.events.rend() && i < start; ++it, ++i)
@@ -180,26 +195,26 @@ void renderAllEventsPage(ServerAllWorldsState& world_state, const web::RequestIn
 				const SubEvent* event = it->second.ptr();
 				if(event->state == SubEvent::State_published)
 				{
-					page += "<h2 class=\"event-title\"><a href=\"/event/" + toString(event->id) + "\">" + web::Escaping::HTMLEscape(event->title) + "</a></h2>";
+					list_html += "<h2 class=\"event-title\"><a href=\"/event/" + toString(event->id) + "\">" + web::Escaping::HTMLEscape(event->title) + "</a></h2>";
 
-					page += "<div class=\"event-description\">";
+					list_html += "<div class=\"event-description\">";
 					const size_t MAX_DESCRIP_SHOW_LEN = 80;
-					page += web::Escaping::HTMLEscape(event->description.substr(0, MAX_DESCRIP_SHOW_LEN));
+					list_html += web::Escaping::HTMLEscape(event->description.substr(0, MAX_DESCRIP_SHOW_LEN));
 					if(event->description.size() > MAX_DESCRIP_SHOW_LEN)
-						page += "...";
-					page += "</div>";
+						list_html += "...";
+					list_html += "</div>";
 					
-					page += "<div class=\"event-time\">" + event->start_time.dayAndTimeStringUTC() + "</div>";
+					list_html += "<div class=\"event-time\">" + event->start_time.dayAndTimeStringUTC() + "</div>";
 
 					num_displayed++;
 				}
 			}
 
-			page += "<br/><br/>\n";
+			list_html += "<br/><br/>\n";
 
 			// Show 'newer events' link if there are any newer posts.
 			if(start > 0)
-				page += "<a href=\"/events?start=" + toString(myMax(0, start - max_num_to_display)) + "\">&lt; Newer events</a>\n";
+				list_html += "<a href=\"/events?start=" + toString(myMax(0, start - max_num_to_display)) + "\">&lt; Newer events</a>\n";
 		
 			// Show 'older events' link if there are any older posts.
 			const int next_start = start + max_num_to_display;
@@ -207,11 +222,12 @@ void renderAllEventsPage(ServerAllWorldsState& world_state, const web::RequestIn
 			if(num_older_events_remaining > 0)
 			{
 				if(start > 0)
-					page += " | ";
-				page += "<a href=\"/events?start=" + toString(next_start) + "\">Older events &gt;</a>  \n";
+					list_html += " | ";
+				list_html += "<a href=\"/events?start=" + toString(next_start) + "\">Older events &gt;</a>  \n";
 			}
 
-		} // end lock scope
+			return list_html;
+		});
 
 		page += "<br/><div><a href=\"/create_event\">Create an event</a></div>";
 
@@ -14,6 +14,7 @@ Copyright Glare Technologies Limited 2022 -
 #include <PlatformUtils.h>
 #include <Lock.h>
 #include <ResponseUtils.h>
+#include <Timer.h>
 #ifdef __linux__
 #include <unistd.h>
 #include <sys/inotify.h>
@@ -123,6 +124,19 @@ void WebDataFileWatcherThread::doRun()
 
 				if(length >= (int)sizeof(struct inotify_event))
 				{
+					// A deploy changes many files in quick succession, giving a burst of events.  Wait until no more events arrive for a while,
+					// so we reload once per burst instead of once per event.
+					Timer burst_timer;
+					while(burst_timer.elapsed() < 10.0)
+					{
+						poll_fds[0].revents = 0;
+						const int num_more = poll(poll_fds, 1, /*timeout (ms)=*/500);
+						if(num_more <= 0)
+							break;
+						if(read(inotify_fd, buf.data(), buf.size()) == -1)
+							throw glare::Exception("read failed: " + PlatformUtils::getLastErrorString());
+					}
+
 					conPrint("public_files_dir or webclient_dir or fragments_dir file(s) changed, reloading files...");
 
 					// The reload-trigger file has changed in some way.  So reload files
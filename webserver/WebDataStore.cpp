@@ -16,6 +16,10 @@ Copyright Glare Technologies Limited 2022 -
 #include <utils/FileUtils.h>
 #include <utils/Lock.h>
 #include <utils/IncludeXXHash.h>
+#include <utils/TaskManager.h>
+#include <utils/Task.h>
+#include <utils/PlatformUtils.h>
+#include <maths/mathstypes.h>
 #include <zlib.h>
 #include <zstd.h>
 #include <Timer.h>
@@ -114,118 +118,187 @@ static bool shouldCompressFile(const std::string& path)
 }
 
 
-static Reference<WebDataStoreFile> loadAndMaybeCompressFile(const std::string& path)
+class CompressWebDataFileTask : public glare::Task
 {
-	Reference<WebDataStoreFile> file = new WebDataStoreFile();
-	file->uncompressed_data = readFile(path);
-
-	const bool should_compresss = shouldCompressFile(path);
-	if(should_compresss)
-		compressFile(file, path);
-	
-	file->content_type = web::ResponseUtils::getContentTypeForPath(path);
-	return file;
-}
+public:
+	virtual void run(size_t thread_index) override
+	{
+		try
+		{
+			compressFile(file, path);
+		}
+		catch(glare::Exception& e)
+		{
+			error_msg = e.what();
+		}
+	}
 
+	Reference<WebDataStoreFile> file;
+	std::string path;
+	std::string key; // Key in the file map.
+	std::map<std::string, Reference<WebDataStoreFile>>* new_files; // The file map the file is in.
+	Reference<WebDataStoreFile> old_file; // Previous version of the file, if any.  Kept if compression fails.
+	std::string error_msg;
+};
 
-void WebDataStore::loadAndCompressFiles()
-{
-	conPrint("WebDataStore::loadAndCompressFiles");
 
+struct ReloadStats
+{
+	ReloadStats() : num_unchanged(0), num_loaded(0), num_removed(0) {}
 
-	parseGenericPageConfig();
+	size_t num_unchanged, num_loaded, num_removed;
+};
 
-	//-------------- Load (HTML) fragment files --------------
-	const std::vector<std::string> fragment_filenames = FileUtils::getFilesInDir(this->fragments_dir);
 
-	for(auto it = fragment_filenames.begin(); it != fragment_filenames.end(); ++it)
+// Loads the files at relative_paths (relative to dir) into new_files_out.
+// Files whose contents hash to the same value as the file with the same key in old_files reuse the old file, including its compressed data.
+// Changed files that need compressing are appended to compress_tasks_out, and are only compressed later, by the tasks.
+static void loadDirFiles(const std::string& dir, const std::vector<std::string>& relative_paths, const std::map<std::string, Reference<WebDataStoreFile>>& old_files, 
+	std::map<std::string, Reference<WebDataStoreFile>>& new_files_out, std::vector<Reference<CompressWebDataFileTask>>& compress_tasks_out, ReloadStats& stats)
+{
+	for(auto it = relative_paths.begin(); it != relative_paths.end(); ++it)
 	{
-		const std::string filename = *it;
-		const std::string path = fragments_dir + "/" + filename;
+		const std::string path = dir + "/" + *it;
+		const std::string key = StringUtils::replaceCharacter(*it, '\\', '/'); // Replace backslashes with forward slashes.
+
+		const auto old_res = old_files.find(key);
+		const Reference<WebDataStoreFile> old_file = (old_res != old_files.end()) ? old_res->second : Reference<WebDataStoreFile>();
 
 		try
 		{
-			conPrint("Loading fragment from '" + path + "'...");
-			Reference<WebDataStoreFile> file = loadAndMaybeCompressFile(path);
+			js::Vector<uint8, 16> data = readFile(path);
+			const uint64 content_hash = XXH64(data.data(), data.size(), /*seed=*/1);
+
+			if(old_file.nonNull() && (old_file->content_hash == content_hash) && (old_file->uncompressed_data.size() == data.size()))
+			{
+				new_files_out[key] = old_file;
+				stats.num_unchanged++;
+				continue;
+			}
+
+			Reference<WebDataStoreFile> file = new WebDataStoreFile();
+			file->uncompressed_data = std::move(data);
+			file->content_hash = content_hash;
+			file->content_type = web::ResponseUtils::getContentTypeForPath(path);
+			new_files_out[key] = file;
+			stats.num_loaded++;
 
+			if(shouldCompressFile(path))
 			{
-				Lock lock(mutex);
-				fragment_files[filename] = file;
+				Reference<CompressWebDataFileTask> task = new CompressWebDataFileTask();
+				task->file = file;
+				task->path = path;
+				task->key = key;
+				task->new_files = &new_files_out;
+				task->old_file = old_file;
+				compress_tasks_out.push_back(task);
 			}
 		}
 		catch(glare::Exception& e)
 		{
 			conPrint("WebDataStore::loadAndCompressFiles: warning: " + e.what());
+
+			// The file may be in the middle of being written.  Keep serving the previous version, if there was one.
+			if(old_file.nonNull())
+				new_files_out[key] = old_file;
 		}
 	}
 
+	for(auto it = old_files.begin(); it != old_files.end(); ++it)
+		if(new_files_out.count(it->first) == 0)
+			stats.num_removed++;
+}
 
-	//-------------- Load public files --------------
-	const std::vector<std::string> public_file_filenames = FileUtils::getFilesInDir(this->public_files_dir);
 
-	for(auto it = public_file_filenames.begin(); it != public_file_filenames.end(); ++it)
-	{
-		const std::string filename = *it;
-		const std::string path = public_files_dir + "/" + filename;
+void WebDataStore::loadAndCompressFiles()
+{
+	conPrint("WebDataStore::loadAndCompressFiles");
 
-		try
-		{
-			//conPrint("Loading file '" + path + "'...");
-			Reference<WebDataStoreFile> file = loadAndMaybeCompressFile(path);
+	Lock reload_lock(reload_mutex);
 
-			{
-				Lock lock(mutex);
-				public_files[filename] = file;
-			}
-		}
-		catch(glare::Exception& e)
-		{
-			conPrint("WebDataStore::loadAndCompressFiles: warning: " + e.what());
-		}
+	Timer timer;
+
+	parseGenericPageConfig();
+
+	// Take copies of the current file maps.  The files themselves are not modified once added to a map, so can be shared with the new maps.
+	std::map<std::string, Reference<WebDataStoreFile>> old_fragment_files, old_public_files, old_webclient_dir_files;
+	{
+		Lock lock(mutex);
+		old_fragment_files = fragment_files;
+		old_public_files = public_files;
+		old_webclient_dir_files = webclient_dir_files;
 	}
 
+	// Load files into new maps, without holding mutex.  Requests continue to be served from the current maps.
+	std::map<std::string, Reference<WebDataStoreFile>> new_fragment_files, new_public_files, new_webclient_dir_files;
+	std::vector<Reference<CompressWebDataFileTask>> compress_tasks;
+	ReloadStats stats;
 
-	//-------------- Load webclient files --------------
-	const std::vector<std::string> webclient_paths = FileUtils::getFilesInDirRecursive(this->webclient_dir);
+	loadDirFiles(fragments_dir,    FileUtils::getFilesInDir(fragments_dir),             old_fragment_files,      new_fragment_files,      compress_tasks, stats);
+	loadDirFiles(public_files_dir, FileUtils::getFilesInDir(public_files_dir),          old_public_files,        new_public_files,        compress_tasks, stats);
+	loadDirFiles(webclient_dir,    FileUtils::getFilesInDirRecursive(webclient_dir),    old_webclient_dir_files, new_webclient_dir_files, compress_tasks, stats);
 
-	for(auto it = webclient_paths.begin(); it != webclient_paths.end(); ++it)
+	// Compress changed files in parallel.
+	if(!compress_tasks.empty())
 	{
-		const std::string relative_path = *it; // path relative to webclient_dir.
-		const std::string path = this->webclient_dir + "/" + relative_path;
+		Timer compress_timer;
 
-		try
-		{
-			Reference<WebDataStoreFile> file = loadAndMaybeCompressFile(path);
+		Reference<glare::TaskGroup> task_group = new glare::TaskGroup();
+		for(size_t i=0; i<compress_tasks.size(); ++i)
+			task_group->tasks.push_back(compress_tasks[i]);
 
-			const std::string use_relative_path = StringUtils::replaceCharacter(relative_path, '\\', '/'); // Replace backslashes with forward slashes.
+		if(compress_tasks.size() > 1)
+		{
+			// Leave some cores free for serving requests while compressing.
+			const size_t num_threads = myClamp<size_t>(PlatformUtils::getNumLogicalProcessors() / 2, 1, 8);
+			glare::TaskManager task_manager("WebDataStore compression", num_threads);
+			task_manager.runTaskGroup(task_group);
+		}
+		else
+			compress_tasks[0]->run(/*thread_index=*/0);
 
-			// conPrint("Loading webclient file '" + path + "', using relative path '" + use_relative_path + "'");
+		for(size_t i=0; i<compress_tasks.size(); ++i)
+		{
+			const CompressWebDataFileTask* task = compress_tasks[i].ptr();
+			if(!task->error_msg.empty())
 			{
-				Lock lock(mutex);
-				webclient_dir_files[use_relative_path] = file;
+				conPrint("WebDataStore::loadAndCompressFiles: warning: failed to compress '" + task->path + "': " + task->error_msg);
+
+				// Keep serving the previous version of the file, if there was one.
+				if(task->old_file.nonNull())
+					(*task->new_files)[task->key] = task->old_file;
+				else
+					task->new_files->erase(task->key);
 			}
 		}
-		catch(glare::Exception& e)
-		{
-			conPrint("WebDataStore::loadAndCompressFiles: warning: " + e.what());
-		}
-	}
 
-	//conPrint("WebDataStore::loadAndCompressFiles done.");
+		conPrint("WebDataStore::loadAndCompressFiles: compressed " + toString(compress_tasks.size()) + " file(s) in " + compress_timer.elapsedStringNSigFigs(4));
+	}
 
 	// Compute main_css_hash (cache-busting hash)
+	std::string new_main_css_hash;
+	{
+		auto res = new_public_files.find("main.css");
+		if(res != new_public_files.end())
+			new_main_css_hash = ::toHexString(res->second->content_hash).substr(0, /*count=*/8);
+	}
+
+	// Swap in the new file maps.
 	{
 		Lock lock(mutex);
-		auto res = public_files.find("main.css");
-		if(res != public_files.end())
-		{
-			WebDataStoreFile* file = res->second.ptr();
-			const uint64 hash = XXH64(file->uncompressed_data.data(), file->uncompressed_data.size(), /*seed=*/1);
+		fragment_files.swap(new_fragment_files);
+		public_files.swap(new_public_files);
+		webclient_dir_files.swap(new_webclient_dir_files);
+	}
 
-			Lock lock2(this->hash_mutex);
-			this->main_css_hash = ::toHexString(hash).substr(0, /*count=*/8);
-		}
+	if(!new_main_css_hash.empty())
+	{
+		Lock lock(this->hash_mutex);
+		this->main_css_hash = new_main_css_hash;
 	}
+
+	conPrint("WebDataStore::loadAndCompressFiles done: " + toString(stats.num_unchanged) + " unchanged, " + toString(stats.num_loaded) + " loaded, " + 
+		toString(stats.num_removed) + " removed.  Elapsed: " + timer.elapsedStringNSigFigs(4));
 }
 
 
@@ -265,3 +338,102 @@ void WebDataStore::parseGenericPageConfig()
 		conPrint("WebDataStore::parseGenericPageConfig(): " + e.what());
 	}
 }
+
+
+#if BUILD_TESTS
+
+
+#include <utils/TestUtils.h>
+#include <utils/PlatformUtils.h>
+
+
+void WebDataStore::test()
+{
+	conPrint("WebDataStore::test()");
+
+	try
+	{
+		const std::string base_dir = PlatformUtils::getTempDirPath() + "/web_data_store_test";
+		if(FileUtils::fileExists(base_dir))
+			FileUtils::deleteDirectoryRecursive(base_dir);
+
+		Reference<WebDataStore> store = new WebDataStore();
+		store->fragments_dir    = base_dir + "/fragments";
+		store->public_files_dir = base_dir + "/public_files";
+		store->webclient_dir    = base_dir + "/webclient";
+		FileUtils::createDirsForPath(store->fragments_dir + "/a");
+		FileUtils::createDirsForPath(store->public_files_dir + "/a");
+		FileUtils::createDirsForPath(store->webclient_dir + "/data/a");
+
+		FileUtils::writeEntireFileTextMode(store->public_files_dir + "/main.css", "body { color: black; }");
+		FileUtils::writeEntireFileTextMode(store->public_files_dir + "/logo.png", "not really a png");
+		FileUtils::writeEntireFileTextMode(store->webclient_dir + "/webclient.js", "console.log('hello');");
+		FileUtils::writeEntireFileTextMode(store->webclient_dir + "/data/data.bin", "some data");
+
+		store->loadAndCompressFiles();
+
+		Reference<WebDataStoreFile> main_css, logo, webclient_js, data_bin;
+		std::string main_css_hash;
+		{
+			Lock lock(store->mutex);
+			testAssert(store->public_files.size() == 2 && store->webclient_dir_files.size() == 2);
+			main_css = store->public_files["main.css"];
+			logo = store->public_files["logo.png"];
+			webclient_js = store->webclient_dir_files["webclient.js"];
+			data_bin = store->webclient_dir_files["data/data.bin"];
+		}
+		testAssert(main_css.nonNull() && logo.nonNull() && webclient_js.nonNull() && data_bin.nonNull());
+		testAssert(main_css->zstd_compressed_data.size() > 0 && main_css->deflate_compressed_data.size() > 0);
+		testAssert(logo->zstd_compressed_data.size() == 0); // PNGs shouldn't be compressed.
+		{
+			Lock lock(store->hash_mutex);
+			main_css_hash = store->main_css_hash;
+			testAssert(!main_css_hash.empty());
+		}
+
+		// Reloading with no changes should reuse all files.
+		store->loadAndCompressFiles();
+		{
+			Lock lock(store->mutex);
+			testAssert(store->public_files["main.css"].ptr() == main_css.ptr());
+			testAssert(store->public_files["logo.png"].ptr() == logo.ptr());
+			testAssert(store->webclient_dir_files["webclient.js"].ptr() == webclient_js.ptr());
+			testAssert(store->webclient_dir_files["data/data.bin"].ptr() == data_bin.ptr());
+		}
+
+		// Change main.css and webclient.js, remove logo.png.  Only the changed files should be reloaded.
+		FileUtils::writeEntireFileTextMode(store->public_files_dir + "/main.css", "body { color: red; }");
+		FileUtils::writeEntireFileTextMode(store->webclient_dir + "/webclient.js", "console.log('hello again');");
+		FileUtils::deleteFile(store->public_files_dir + "/logo.png");
+
+		store->loadAndCompressFiles();
+		{
+			Lock lock(store->mutex);
+			testAssert(store->public_files.size() == 1 && store->webclient_dir_files.size() == 2);
+			testAssert(store->public_files.count("logo.png") == 0);
+
+			const WebDataStoreFile* new_main_css = store->public_files["main.css"].ptr();
+			testAssert(new_main_css != main_css.ptr());
+			testAssert(std::string((const char*)new_main_css->uncompressed_data.data(), new_main_css->uncompressed_data.size()) == "body { color: red; }");
+			testAssert(new_main_css->zstd_compressed_data.size() > 0 && new_main_css->deflate_compressed_data.size() > 0);
+
+			testAssert(store->webclient_dir_files["webclient.js"].ptr() != webclient_js.ptr());
+			testAssert(store->webclient_dir_files["data/data.bin"].ptr() == data_bin.ptr());
+		}
+		{
+			Lock lock(store->hash_mutex);
+			testAssert(store->main_css_hash != main_css_hash);
+		}
+
+		FileUtils::deleteDirectoryRecursive(base_dir);
+	}
+	catch(glare::Exception& e)
+	{
+		failTest(e.what());
+	}
+
+	conPrint("WebDataStore::test() done.");
+}
+
+
+#endif // BUILD_TESTS
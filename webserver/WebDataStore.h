@@ -18,10 +18,13 @@ Copyright Glare Technologies Limited 2022 -
 class WebDataStoreFile : public ThreadSafeRefCounted
 {
 public:
+	WebDataStoreFile() : content_hash(0) {}
+
 	js::Vector<uint8, 16> uncompressed_data;
 	js::Vector<uint8, 16> deflate_compressed_data;
 	js::Vector<uint8, 16> zstd_compressed_data;
 	std::string content_type;
+	uint64 content_hash; // XXH64 hash of uncompressed_data.  Used to tell if the file has changed on reload.
 };
 
 
@@ -37,6 +40,13 @@ public:
 /*=====================================================================
 WebDataStore
 ------------
+In-memory copies of the HTML fragments, public files and webclient files,
+with precompressed versions for serving with deflate or zstd encoding.
+
+Reloading is incremental: only files whose content hash has changed are
+reloaded and recompressed, with compression done in parallel without
+holding mutex.  The new file maps are then swapped in at once, so requests
+see either the old or the new set of files.  Removed files are dropped.
 =====================================================================*/
 class WebDataStore : public ThreadSafeRefCounted
 {
@@ -44,7 +54,7 @@ public:
 	WebDataStore();
 	~WebDataStore();
 
-	void loadAndCompressFiles(); // Loads or reloads files.  Compresses files if needed.
+	void loadAndCompressFiles(); // Loads or reloads files.  Compresses new or changed files if needed.
 
 	Reference<WebDataStoreFile> getFragmentFile(const std::string& path); // Returns NULL if not found
 
@@ -71,4 +81,9 @@ public:
 
 	std::string main_css_hash GUARDED_BY(hash_mutex);
 	Mutex hash_mutex;
+
+	static void test();
+
+private:
+	Mutex reload_mutex; // Held while reloading, so that concurrent reloads don't interleave.
 };
@@ -0,0 +1,158 @@
+/*=====================================================================
+WebPageCache.cpp
+----------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#include "WebPageCache.h"
+
+
+#include <utils/Clock.h>
+#include <utils/Lock.h>
+#include <utils/ConPrint.h>
+
+
+WebPageCache::WebPageCache()
+:	total_size_B(0),
+	num_hits(0),
+	num_misses(0)
+{}
+
+
+WebPageCache::~WebPageCache() {}
+
+
+bool WebPageCache::getFragment(const std::string& key, uint64 content_version, double max_age_s, std::string& html_out)
+{
+	const double cur_time = Clock::getTimeSinceInit();
+
+	Lock lock(mutex);
+
+	auto res = fragments.find(key);
+	if(res != fragments.end() && (res->second.content_version == content_version) && (cur_time - res->second.render_time <= max_age_s))
+	{
+		html_out = res->second.html;
+		LRU_keys.splice(LRU_keys.end(), LRU_keys, res->second.LRU_it); // Move to back of LRU list.
+		num_hits++;
+		return true;
+	}
+
+	num_misses++;
+	return false;
+}
+
+
+void WebPageCache::putFragment(const std::string& key, uint64 content_version, const std::string& html)
+{
+	const double cur_time = Clock::getTimeSinceInit();
+
+	Lock lock(mutex);
+
+	auto res = fragments.find(key);
+	if(res == fragments.end())
+	{
+		if(fragments.size() >= MAX_NUM_FRAGMENTS)
+		{
+			// Evict the least recently used fragment.
+			auto lru_res = fragments.find(LRU_keys.front());
+			assert(lru_res != fragments.end());
+			total_size_B -= lru_res->second.html.size();
+			fragments.erase(lru_res);
+			LRU_keys.pop_front();
+		}
+
+		res = fragments.insert(std::make_pair(key, CachedFragment())).first;
+		res->second.LRU_it = LRU_keys.insert(LRU_keys.end(), key);
+	}
+	else
+		LRU_keys.splice(LRU_keys.end(), LRU_keys, res->second.LRU_it); // Move to back of LRU list.
+
+	total_size_B -= res->second.html.size();
+	res->second.html = html;
+	res->second.content_version = content_version;
+	res->second.render_time = cur_time;
+	total_size_B += html.size();
+}
+
+
+void WebPageCache::clear()
+{
+	Lock lock(mutex);
+
+	fragments.clear();
+	LRU_keys.clear();
+	total_size_B = 0;
+}
+
+
+WebPageCache::Stats WebPageCache::getStats()
+{
+	Lock lock(mutex);
+
+	Stats stats;
+	stats.num_hits = num_hits;
+	stats.num_misses = num_misses;
+	stats.num_fragments = fragments.size();
+	stats.total_size_B = total_size_B;
+	return stats;
+}
+
+
+#if BUILD_TESTS
+
+
+#include <utils/TestUtils.h>
+#include <utils/StringUtils.h>
+
+
+void WebPageCache::test()
+{
+	conPrint("WebPageCache::test()");
+
+	WebPageCache cache;
+	std::string html;
+
+	testAssert(!cache.getFragment("news", /*content version=*/1, /*max age=*/100, html));
+
+	cache.putFragment("news", /*content version=*/1, "<p>news</p>");
+	testAssert(cache.getFragment("news", /*content version=*/1, /*max age=*/100, html));
+	testAssert(html == "<p>news</p>");
+
+	// A different content version should miss.
+	testAssert(!cache.getFragment("news", /*content version=*/2, /*max age=*/100, html));
+
+	// Should miss if the fragment is older than the max age.
+	testAssert(!cache.getFragment("news", /*content version=*/1, /*max age=*/-1, html));
+
+	// Replacing a fragment should update the stored size.
+	cache.putFragment("news", /*content version=*/2, "<p>more news</p>");
+	testAssert(cache.getFragment("news", /*content version=*/2, /*max age=*/100, html));
+	testAssert(html == "<p>more news</p>");
+
+	Stats stats = cache.getStats();
+	testAssert(stats.num_hits == 2);
+	testAssert(stats.num_misses == 3);
+	testAssert(stats.num_fragments == 1);
+	testAssert(stats.total_size_B == std::string("<p>more news</p>").size());
+
+	// Test the bound on the number of fragments.  A fragment that keeps being used should not be evicted by a crawl over many other keys.
+	for(size_t i=0; i<MAX_NUM_FRAGMENTS * 2; ++i)
+	{
+		cache.putFragment("events?start=" + toString(i), 1, "x");
+		testAssert(cache.getFragment("news", /*content version=*/2, /*max age=*/100, html));
+		testAssert(cache.getStats().num_fragments <= MAX_NUM_FRAGMENTS);
+	}
+	stats = cache.getStats();
+	testAssert(stats.num_fragments == MAX_NUM_FRAGMENTS);
+	testAssert(stats.total_size_B == std::string("<p>more news</p>").size() + (MAX_NUM_FRAGMENTS - 1));
+	testAssert(cache.getFragment("events?start=" + toString(MAX_NUM_FRAGMENTS * 2 - 1), 1, /*max age=*/100, html)); // Most recent should still be present.
+	testAssert(!cache.getFragment("events?start=0", 1, /*max age=*/100, html)); // Oldest should have been evicted.
+
+	cache.clear();
+	stats = cache.getStats();
+	testAssert(stats.num_fragments == 0 && stats.total_size_B == 0);
+
+	conPrint("WebPageCache::test() done.");
+}
+
+
+#endif // BUILD_TESTS
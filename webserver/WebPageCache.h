@@ -0,0 +1,89 @@
+/*=====================================================================
+WebPageCache.h
+--------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#pragma once
+
+
+#include <Mutex.h>
+#include <Platform.h>
+#include <string>
+#include <map>
+#include <list>
+
+
+/*=====================================================================
+WebPageCache
+------------
+Cache of rendered HTML fragments for the public web pages (root page, map,
+news and events lists), so they can be served without taking the world
+state lock.
+
+Each fragment is stored with the content version it was rendered from,
+e.g. ServerAllWorldsState::news_posts_version.  A fragment is only returned
+if the content version still matches and the fragment is younger than the
+given max age.  The max age handles content that changes just with time,
+such as Dutch auction prices and expired events.
+
+The number of fragments is bounded, with the least recently used fragment
+evicted when a new one is added to a full cache.
+
+Thread-safe.
+=====================================================================*/
+class WebPageCache
+{
+public:
+	WebPageCache();
+	~WebPageCache();
+
+	// Returns true and sets html_out if there is a valid cached fragment.
+	bool getFragment(const std::string& key, uint64 content_version, double max_age_s, std::string& html_out);
+
+	void putFragment(const std::string& key, uint64 content_version, const std::string& html);
+
+	// Returns the cached fragment if valid, otherwise calls render_func() to render the fragment, and caches the result.
+	// render_func should take the world state lock itself, so that it is only taken on a cache miss.
+	template <class RenderFunc>
+	std::string getOrRender(const std::string& key, uint64 content_version, double max_age_s, RenderFunc render_func)
+	{
+		std::string html;
+		if(!getFragment(key, content_version, max_age_s, html))
+		{
+			html = render_func();
+			putFragment(key, content_version, html);
+		}
+		return html;
+	}
+
+	void clear();
+
+	struct Stats
+	{
+		uint64 num_hits;
+		uint64 num_misses;
+		size_t num_fragments;
+		size_t total_size_B;
+	};
+	Stats getStats();
+
+	static void test();
+
+	static const size_t MAX_NUM_FRAGMENTS = 256; // Keys can include URL params, such as the pagination start index, so bound the number of fragments.
+
+private:
+	struct CachedFragment
+	{
+		std::string html;
+		uint64 content_version;
+		double render_time;
+		std::list<std::string>::iterator LRU_it; // Position of the key in LRU_keys.
+	};
+
+	Mutex mutex;
+	std::map<std::string, CachedFragment> fragments	GUARDED_BY(mutex);
+	std::list<std::string> LRU_keys					GUARDED_BY(mutex); // Keys of fragments, most recently used at the back.
+	size_t total_size_B								GUARDED_BY(mutex);
+	uint64 num_hits									GUARDED_BY(mutex);
+	uint64 num_misses								GUARDED_BY(mutex);
+};
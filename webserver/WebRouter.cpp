@@ -0,0 +1,282 @@
+/*=====================================================================
+WebRouter.cpp
+-------------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#include "WebRouter.h"
+
+
+#include <utils/Exception.h>
+#include <utils/StringUtils.h>
+#include <utils/IncludeXXHash.h>
+#include <maths/mathstypes.h>
+#include <cstring>
+
+
+WebRouter::WebRouter()
+:	exact_hash_seed(0),
+	exact_table_mask(0)
+{}
+
+
+WebRouter::~WebRouter()
+{}
+
+
+inline size_t WebRouter::exactTableIndex(const char* path, size_t path_len) const
+{
+	return (size_t)XXH64(path, path_len, exact_hash_seed) & exact_table_mask;
+}
+
+
+bool WebRouter::tryBuildExactTable(const std::vector<const WebRoute*>& exact_routes, size_t table_size, uint64 seed)
+{
+	exact_table.assign(table_size, NULL);
+	exact_path_lens.assign(table_size, 0);
+	exact_hash_seed = seed;
+	exact_table_mask = table_size - 1;
+
+	for(size_t i=0; i<exact_routes.size(); ++i)
+	{
+		const size_t path_len = std::strlen(exact_routes[i]->path);
+		const size_t index = exactTableIndex(exact_routes[i]->path, path_len);
+		if(exact_table[index])
+			return false; // Collision
+		exact_table[index] = exact_routes[i];
+		exact_path_lens[index] = path_len;
+	}
+	return true;
+}
+
+
+void WebRouter::build(const WebRoute* routes_, size_t num_routes)
+{
+	routes.resize(num_routes);
+	for(size_t i=0; i<num_routes; ++i)
+		routes[i] = &routes_[i];
+
+	// Check that the compiled lookup (exact match, then longest prefix) gives the same result as taking the first matching route.
+	// This is the case as long as no prefix route matches the path of a later route.
+	for(size_t i=0; i<num_routes; ++i)
+		for(size_t z=0; z<i; ++z)
+		{
+			if(routes[z]->match_type == WebRoute::MatchType_Prefix && ::hasPrefix(routes[i]->path, routes[z]->path))
+				throw glare::Exception("WebRouter: route '" + std::string(routes[i]->path) + "' is shadowed by earlier prefix route '" + std::string(routes[z]->path) + "'");
+
+			if(routes[z]->match_type == routes[i]->match_type && std::strcmp(routes[z]->path, routes[i]->path) == 0)
+				throw glare::Exception("WebRouter: duplicate route '" + std::string(routes[i]->path) + "'");
+		}
+
+	//------------------------------- Build exact path perfect hash table -------------------------------
+	std::vector<const WebRoute*> exact_routes;
+	for(size_t i=0; i<num_routes; ++i)
+		if(routes[i]->match_type == WebRoute::MatchType_Exact)
+			exact_routes.push_back(routes[i]);
+
+	// Find a seed that hashes all exact paths to distinct slots.  Start with a table with a load factor of at most 1/2, and grow it if no seed is found quickly.
+	size_t table_size = myMax<size_t>(16, Maths::roundToNextHighestPowerOf2(exact_routes.size() * 2));
+	uint64 seed = 0;
+	while(!tryBuildExactTable(exact_routes, table_size, seed))
+	{
+		seed++;
+		if(seed % 1000 == 0)
+			table_size *= 2;
+	}
+
+	//------------------------------- Build prefix trie -------------------------------
+	trie_nodes.resize(1);
+	trie_nodes[0].route = NULL;
+
+	for(size_t i=0; i<num_routes; ++i)
+		if(routes[i]->match_type == WebRoute::MatchType_Prefix)
+		{
+			int node = 0;
+			for(const char* c = routes[i]->path; *c != '\0'; ++c)
+			{
+				int child = -1;
+				for(size_t e=0; e<trie_nodes[node].edges.size(); ++e)
+					if(trie_nodes[node].edges[e].c == *c)
+					{
+						child = trie_nodes[node].edges[e].child;
+						break;
+					}
+
+				if(child == -1)
+				{
+					child = (int)trie_nodes.size();
+					TrieEdge edge;
+					edge.c = *c;
+					edge.child = child;
+					trie_nodes[node].edges.push_back(edge);
+
+					trie_nodes.push_back(TrieNode());
+					trie_nodes.back().route = NULL;
+				}
+				node = child;
+			}
+			trie_nodes[node].route = routes[i];
+		}
+}
+
+
+const WebRoute* WebRouter::findRoute(const std::string& path) const
+{
+	// Try an exact match first
+	if(!exact_table.empty())
+	{
+		const size_t index = exactTableIndex(path.data(), path.size());
+		const WebRoute* route = exact_table[index];
+		if(route && exact_path_lens[index] == path.size() && std::memcmp(route->path, path.data(), path.size()) == 0)
+			return route;
+	}
+
+	// Walk down the trie, keeping track of the longest matching prefix route.
+	const WebRoute* longest_prefix_route = NULL;
+	int node = 0;
+	for(size_t i=0; i<path.size(); ++i)
+	{
+		const std::vector<TrieEdge>& edges = trie_nodes[node].edges;
+		int child = -1;
+		for(size_t e=0; e<edges.size(); ++e)
+			if(edges[e].c == path[i])
+			{
+				child = edges[e].child;
+				break;
+			}
+
+		if(child == -1)
+			break;
+
+		node = child;
+		if(trie_nodes[node].route)
+			longest_prefix_route = trie_nodes[node].route;
+	}
+
+	return longest_prefix_route;
+}
+
+
+const WebRoute* WebRouter::findRouteLinear(const std::string& path) const
+{
+	for(size_t i=0; i<routes.size(); ++i)
+	{
+		if(routes[i]->match_type == WebRoute::MatchType_Exact)
+		{
+			if(path == routes[i]->path)
+				return routes[i];
+		}
+		else
+		{
+			if(::hasPrefix(path, routes[i]->path))
+				return routes[i];
+		}
+	}
+	return NULL;
+}
+
+
+#if BUILD_TESTS
+
+
+#include <utils/TestUtils.h>
+#include <utils/TestExceptionUtils.h>
+#include <utils/ConPrint.h>
+
+
+static void testHandlerA(WebServerRequestHandler&, const web::RequestInfo&, web::ReplyInfo&) {}
+
+
+void WebRouter::test()
+{
+	conPrint("WebRouter::test()");
+
+	{
+		const WebRoute routes[] = {
+			{ "/",				WebRoute::MatchType_Exact,	testHandlerA },
+			{ "/news_post/",	WebRoute::MatchType_Prefix,	testHandlerA },
+			{ "/news",			WebRoute::MatchType_Prefix,	testHandlerA },
+			{ "/events",		WebRoute::MatchType_Exact,	testHandlerA },
+			{ "/event/",		WebRoute::MatchType_Prefix,	testHandlerA },
+			{ "/photo/",		WebRoute::MatchType_Prefix,	testHandlerA },
+			{ "/photo_image/",	WebRoute::MatchType_Prefix,	testHandlerA },
+			{ "/tile",			WebRoute::MatchType_Exact,	testHandlerA },
+		};
+		WebRouter router;
+		router.build(routes, staticArrayNumElems(routes));
+
+		testAssert(router.findRoute("/") == &routes[0]);
+		testAssert(router.findRoute("/news_post/123") == &routes[1]);
+		testAssert(router.findRoute("/news_post/") == &routes[1]);
+		testAssert(router.findRoute("/news") == &routes[2]);
+		testAssert(router.findRoute("/newsletter") == &routes[2]);
+		testAssert(router.findRoute("/news_pos") == &routes[2]);
+		testAssert(router.findRoute("/events") == &routes[3]);
+		testAssert(router.findRoute("/event/12") == &routes[4]);
+		testAssert(router.findRoute("/event") == NULL);
+		testAssert(router.findRoute("/events/") == NULL);
+		testAssert(router.findRoute("/photo/1") == &routes[5]);
+		testAssert(router.findRoute("/photo_image/1") == &routes[6]);
+		testAssert(router.findRoute("/photo_thumb_image/1") == NULL);
+		testAssert(router.findRoute("/tile") == &routes[7]);
+		testAssert(router.findRoute("/tiles") == NULL);
+		testAssert(router.findRoute("") == NULL);
+		testAssert(router.findRoute(std::string("/tile\0", 6)) == NULL);
+
+		const char* paths[] = { "/", "/news_post/123", "/news", "/newsletter", "/events", "/event/12", "/event", "/photo/1", "/tile", "/tiles", "", "/x" };
+		for(size_t i=0; i<staticArrayNumElems(paths); ++i)
+			testAssert(router.findRoute(paths[i]) == router.findRouteLinear(paths[i]));
+	}
+
+	// A shorter prefix before a longer one would shadow it.
+	{
+		const WebRoute routes[] = {
+			{ "/news",			WebRoute::MatchType_Prefix,	testHandlerA },
+			{ "/news_post/",	WebRoute::MatchType_Prefix,	testHandlerA },
+		};
+		WebRouter router;
+		testThrowsExcepContainingString([&]() { router.build(routes, staticArrayNumElems(routes)); }, "shadowed");
+	}
+
+	// A prefix route before an exact route that it matches would shadow it.
+	{
+		const WebRoute routes[] = {
+			{ "/admin",			WebRoute::MatchType_Prefix,	testHandlerA },
+			{ "/admin_users",	WebRoute::MatchType_Exact,	testHandlerA },
+		};
+		WebRouter router;
+		testThrowsExcepContainingString([&]() { router.build(routes, staticArrayNumElems(routes)); }, "shadowed");
+	}
+
+	// Duplicate exact routes
+	{
+		const WebRoute routes[] = {
+			{ "/a",				WebRoute::MatchType_Exact,	testHandlerA },
+			{ "/a",				WebRoute::MatchType_Exact,	testHandlerA },
+		};
+		WebRouter router;
+		testThrowsExcepContainingString([&]() { router.build(routes, staticArrayNumElems(routes)); }, "duplicate");
+	}
+
+	// Lots of exact routes, to test the perfect hash table construction.
+	{
+		std::vector<std::string> paths(500);
+		std::vector<WebRoute> routes(paths.size());
+		for(size_t i=0; i<paths.size(); ++i)
+		{
+			paths[i] = "/page_" + toString(i);
+			routes[i].path = paths[i].c_str();
+			routes[i].match_type = WebRoute::MatchType_Exact;
+			routes[i].handler = testHandlerA;
+		}
+		WebRouter router;
+		router.build(routes.data(), routes.size());
+		for(size_t i=0; i<paths.size(); ++i)
+			testAssert(router.findRoute(paths[i]) == &routes[i]);
+		testAssert(router.findRoute("/page_500") == NULL);
+	}
+
+	conPrint("WebRouter::test() done.");
+}
+
+
+#endif // BUILD_TESTS
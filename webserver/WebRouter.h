@@ -0,0 +1,95 @@
+/*=====================================================================
+WebRouter.h
+-----------
+Copyright Glare Technologies Limited 2025 -
+=====================================================================*/
+#pragma once
+
+
+#include <Platform.h>
+#include <string>
+#include <vector>
+class WebServerRequestHandler;
+namespace web
+{
+class RequestInfo;
+class ReplyInfo;
+}
+
+
+typedef void (*WebRouteHandlerFunc)(WebServerRequestHandler& handler, const web::RequestInfo& request, web::ReplyInfo& reply_info);
+
+
+struct WebRoute
+{
+	enum MatchType
+	{
+		MatchType_Exact,	// Request path must equal path.
+		MatchType_Prefix	// Request path must start with path, e.g. "/screenshot/" + screenshot id.
+	};
+
+	const char* path;
+	MatchType match_type;
+	WebRouteHandlerFunc handler;
+};
+
+
+/*=====================================================================
+WebRouter
+---------
+Maps request paths to routes.
+
+The routes are given in priority order, as for a chain of if-else path
+comparisons, and are compiled into a perfect hash table for the exact
+paths, and a prefix trie for the prefix paths.
+Lookup is then an exact-path hash lookup, falling back to the longest
+matching prefix.
+
+build() checks that this gives the same result as taking the first
+matching route in order: it throws if a prefix route would shadow a
+later route.
+=====================================================================*/
+class WebRouter
+{
+public:
+	WebRouter();
+	~WebRouter();
+
+	// Throws glare::Exception if there are duplicate exact paths, or a route is shadowed by an earlier prefix route.
+	void build(const WebRoute* routes, size_t num_routes);
+
+	// Returns NULL if no route matches.
+	const WebRoute* findRoute(const std::string& path) const;
+
+	// Reference implementation: returns the first matching route in priority order.  Used for testing and benchmarking.
+	const WebRoute* findRouteLinear(const std::string& path) const;
+
+	const std::vector<const WebRoute*>& getRoutes() const { return routes; }
+
+	static void test();
+
+private:
+	size_t exactTableIndex(const char* path, size_t path_len) const;
+	bool tryBuildExactTable(const std::vector<const WebRoute*>& exact_routes, size_t table_size, uint64 seed);
+
+	std::vector<const WebRoute*> routes; // All routes, in priority order.
+
+	// Perfect hash table for exact routes: each exact path hashes (with exact_hash_seed) to a distinct slot.
+	std::vector<const WebRoute*> exact_table;
+	std::vector<size_t> exact_path_lens;
+	uint64 exact_hash_seed;
+	size_t exact_table_mask;
+
+	// Prefix trie.  Node 0 is the root.
+	struct TrieEdge
+	{
+		char c;
+		int child;
+	};
+	struct TrieNode
+	{
+		std::vector<TrieEdge> edges;
+		const WebRoute* route; // Prefix route ending at this node, or NULL.
+	};
+	std::vector<TrieNode> trie_nodes;
+};
@@ -13,6 +13,7 @@ class WebDataStore;
 class ServerAllWorldsState;
 class ServerWorldState;
 class Server;
+class WebRouter;
 
 
 class WebServerRequestHandler : public web::RequestHandler
@@ -25,6 +26,10 @@ public:
 
 	virtual void handleWebSocketConnection(const web::RequestInfo& request_info, Reference<SocketInterface>& socket) override;
 
+	// Compiled routing tables for POST and GET requests, built on first use.
+	static const WebRouter& getPOSTRouter();
+	static const WebRouter& getGETRouter();
+
 	WebDataStore* data_store;
 	Server* server;
 	ServerAllWorldsState* world_state;
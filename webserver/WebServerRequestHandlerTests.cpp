@@ -10,6 +10,7 @@ Copyright Glare Technologies Limited 2022 -
 
 
 #include "WebServerRequestHandler.h"
+#include "WebRouter.h"
 #include "RequestHandler.h"
 #include "../server/ServerWorldState.h"
 #include "../server/WorldCreation.h"
@@ -26,6 +27,9 @@ Copyright Glare Technologies Limited 2022 -
 #include <PlatformUtils.h>
 #include <WebWorkerThread.h>
 #include <networking/Networking.h>
+#include <utils/TestUtils.h>
+#include <utils/Timer.h>
+#include <maths/mathstypes.h>
 
 
 #if 0
@@ -60,8 +64,13 @@ extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv)
 		// Insert a UserWebSession so we can test while being logged in.
 		Reference<UserWebSession> session = new UserWebSession();
 		session->created_time = TimeStamp::currentTime();
+		session->id = "AAA";
 		session->user_id = UserID(0); // Admin user
-		test_world_state->user_web_sessions["AAA"] = session;
+		{
+			Lock lock(test_world_state->mutex);
+			const auto user_res = test_world_state->user_id_to_users.find(session->user_id);
+			test_world_state->web_sessions.addSession(session, (user_res != test_world_state->user_id_to_users.end()) ? user_res->second->name : std::string("admin"));
+		}
 
 		test_world_state->server_credentials.creds["coinbase_shared_secret_key"] = "AAA";
 		test_world_state->server_credentials.creds["paypal_sandbox_business_email"] = "AAA";
@@ -257,8 +266,88 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
 #endif // end if fuzzing
 
 
+// Check the compiled router gives the same route as the first match in priority order (i.e. as the if-else chain it replaced) for the route paths,
+// and for some paths derived from them.
+static void checkRouterMatchesLinearLookup(const WebRouter& router)
+{
+	const std::vector<const WebRoute*>& routes = router.getRoutes();
+	testAssert(!routes.empty());
+	for(size_t i=0; i<routes.size(); ++i)
+	{
+		const std::string path = routes[i]->path;
+		testAssert(router.findRoute(path) == router.findRouteLinear(path));
+		testAssert(router.findRoute(path) != NULL);
+
+		const std::string derived_paths[] = { path + "123", path + "/", path + "_x", path.substr(0, path.size() - 1), "/x" + path };
+		for(size_t z=0; z<staticArrayNumElems(derived_paths); ++z)
+			testAssert(router.findRoute(derived_paths[z]) == router.findRouteLinear(derived_paths[z]));
+	}
+
+	const char* other_paths[] = { "", "/", "//", "/unknown", "/news", "/newsletter", "/news_post/", "/news_post/10", "/edit_news_post?id=1", "/event", "/events/", "/tile", "/tiles",
+		"/webclient", "/webclient/", "/webclient/gui_client.wasm", "/gui_client.data", "/files/logo.png", "/resource/abc.bmesh", "/p/1", "/parcel/10", "/admin", "/admin_user/1" };
+	for(size_t i=0; i<staticArrayNumElems(other_paths); ++i)
+		testAssert(router.findRoute(other_paths[i]) == router.findRouteLinear(other_paths[i]));
+}
+
+
 void WebServerRequestHandlerTests::test()
 {
+	conPrint("WebServerRequestHandlerTests::test()");
+
+	const WebRouter& get_router = WebServerRequestHandler::getGETRouter(); // Throws if a route is shadowed by an earlier prefix route.
+	const WebRouter& post_router = WebServerRequestHandler::getPOSTRouter();
+
+	checkRouterMatchesLinearLookup(get_router);
+	checkRouterMatchesLinearLookup(post_router);
+
+	// Check some routes dispatch to the expected type of route.
+	testAssert(get_router.findRoute("/")->match_type == WebRoute::MatchType_Exact);
+	testAssert(get_router.findRoute("/screenshot/123")->match_type == WebRoute::MatchType_Prefix);
+	testAssert(std::string(get_router.findRoute("/news_post/123")->path) == "/news_post/");
+	testAssert(std::string(get_router.findRoute("/newsletter")->path) == "/news");
+	testAssert(std::string(get_router.findRoute("/webclient")->path) == "/webclient");
+	testAssert(std::string(get_router.findRoute("/webclient/gui_client.js")->path) == "/webclient/");
+	testAssert(get_router.findRoute("/some_generic_page") == NULL);
+	testAssert(post_router.findRoute("/login") == NULL);
+	testAssert(std::string(post_router.findRoute("/login_post")->path) == "/login_post");
+
+	//-------------------------- Benchmark routing --------------------------
+	// Uses a request path mix resembling the server's traffic, which is dominated by resource, screenshot, photo thumbnail and map tile requests.
+	{
+		const char* recorded_paths[] = { 
+			"/resource/sphere_mesh_123456789.bmesh", "/resource/cube_texture_987654321.ktx2", "/resource/tree_lod1_5555.bmesh", "/resource/grass_1.basis",
+			"/screenshot/1234", "/screenshot/1234?highlight_parcel=1", "/photo_thumb_image/56", "/photo_thumb_image/57", "/tile", "/tile",
+			"/", "/news", "/news_post/45", "/event/12", "/events", "/parcel/120", "/map", "/webclient", "/webclient/gui_client.wasm", "/gui_client.data",
+			"/files/logo.png", "/about_substrata", "/photo/56", "/account", "/login", "/admin_users", "/p/120", "/world/bob", "/some_generic_page", "/favicon.ico"
+		};
+		const size_t N = staticArrayNumElems(recorded_paths);
+		std::vector<std::string> paths(N);
+		for(size_t i=0; i<N; ++i)
+			paths[i] = recorded_paths[i];
+
+		const int num_iters = 100000;
+		size_t linear_sum = 0;
+		Timer timer;
+		for(int it=0; it<num_iters; ++it)
+			for(size_t i=0; i<N; ++i)
+				linear_sum += (size_t)get_router.findRouteLinear(paths[i]);
+		const double linear_elapsed = timer.elapsed();
+
+		size_t compiled_sum = 0;
+		timer.reset();
+		for(int it=0; it<num_iters; ++it)
+			for(size_t i=0; i<N; ++i)
+				compiled_sum += (size_t)get_router.findRoute(paths[i]);
+		const double compiled_elapsed = timer.elapsed();
+
+		testAssert(linear_sum == compiled_sum);
+
+		const double num_lookups = (double)num_iters * N;
+		conPrint("Linear route lookup:   " + doubleToStringNSigFigs(linear_elapsed / num_lookups * 1.0e9, 4) + " ns / request");
+		conPrint("Compiled route lookup: " + doubleToStringNSigFigs(compiled_elapsed / num_lookups * 1.0e9, 4) + " ns / request");
+	}
+
+	conPrint("WebServerRequestHandlerTests::test() done.");
 }
 
 
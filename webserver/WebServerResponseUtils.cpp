@@ -9,6 +9,8 @@ Copyright Glare Technologies Limited 2021 -
 #include "../server/ServerWorldState.h"
 #include "WebDataStore.h"
 #include "RequestInfo.h"
+#include "Response.h"
+#include "ResponseUtils.h"
 #include "Escaping.h"
 #include "LoginHandlers.h"
 #include <ConPrint.h>
@@ -24,6 +26,13 @@ Copyright Glare Technologies Limited 2021 -
 #include <Parser.h>
 #include <MemMappedFile.h>
 #include <maths/Rect2.h>
+#include <AtomicInt.h>
+#include <Timer.h>
+#include <Mutex.h>
+#include <IncludeXXHash.h>
+#include <zstd.h>
+#include <zlib.h>
+#include <vector>
 
 
 namespace WebServerResponseUtils
@@ -271,4 +280,403 @@ const std::string getMapEmbedCode(ServerAllWorldsState& world_state, ParcelID hi
 }
 
 
+//------------------------------------- Dynamic response compression -------------------------------------
+
+// Compression levels for dynamic responses.  These favour speed, as the pages are compressed for each request.
+static const int ZSTD_COMPRESSION_LEVEL = 3;
+static const int DEFLATE_COMPRESSION_LEVEL = 1;
+
+// Max number of contexts of each type kept for reuse.  Should be around the number of concurrently handled requests.
+static const size_t MAX_NUM_POOLED_CONTEXTS = 16;
+
+
+// Compression contexts are relatively expensive to create (zstd and zlib each allocate several hundred KB of tables and windows), so keep them in a pool for reuse.
+// Web worker threads are created per connection, so a pool gives much more reuse than per-thread contexts would.
+static Mutex context_pool_mutex;
+static std::vector<ZSTD_CCtx*> zstd_context_pool		GUARDED_BY(context_pool_mutex);
+static std::vector<z_stream*> deflate_stream_pool		GUARDED_BY(context_pool_mutex);
+
+
+static glare::AtomicInt num_uncompressed_responses(0);
+static glare::AtomicInt num_zstd_responses(0);
+static glare::AtomicInt num_deflate_responses(0);
+static glare::AtomicInt total_uncompressed_size_B(0);
+static glare::AtomicInt total_compressed_size_B(0);
+static glare::AtomicInt total_compression_time_us(0);
+
+
+static ZSTD_CCtx* getZstdContext()
+{
+	{
+		Lock lock(context_pool_mutex);
+		if(!zstd_context_pool.empty())
+		{
+			ZSTD_CCtx* context = zstd_context_pool.back();
+			zstd_context_pool.pop_back();
+			return context;
+		}
+	}
+
+	ZSTD_CCtx* context = ZSTD_createCCtx();
+	if(!context)
+		throw glare::Exception("ZSTD_createCCtx failed.");
+	return context;
+}
+
+
+static void returnZstdContext(ZSTD_CCtx* context)
+{
+	{
+		Lock lock(context_pool_mutex);
+		if(zstd_context_pool.size() < MAX_NUM_POOLED_CONTEXTS)
+		{
+			zstd_context_pool.push_back(context);
+			return;
+		}
+	}
+	ZSTD_freeCCtx(context);
+}
+
+
+static z_stream* getDeflateStream()
+{
+	{
+		Lock lock(context_pool_mutex);
+		if(!deflate_stream_pool.empty())
+		{
+			z_stream* stream = deflate_stream_pool.back();
+			deflate_stream_pool.pop_back();
+			return stream;
+		}
+	}
+
+	z_stream* stream = new z_stream();
+	stream->zalloc = Z_NULL;
+	stream->zfree = Z_NULL;
+	stream->opaque = Z_NULL;
+	if(deflateInit(stream, DEFLATE_COMPRESSION_LEVEL) != Z_OK) // Uses the zlib format, which is what the 'deflate' content encoding is.
+	{
+		delete stream;
+		throw glare::Exception("deflateInit failed.");
+	}
+	return stream;
+}
+
+
+static void returnDeflateStream(z_stream* stream)
+{
+	if(deflateReset(stream) == Z_OK)
+	{
+		Lock lock(context_pool_mutex);
+		if(deflate_stream_pool.size() < MAX_NUM_POOLED_CONTEXTS)
+		{
+			deflate_stream_pool.push_back(stream);
+			return;
+		}
+	}
+	deflateEnd(stream);
+	delete stream;
+}
+
+
+static void compressWithZstd(const std::string& data, std::string& compressed_out)
+{
+	ZSTD_CCtx* context = getZstdContext();
+
+	compressed_out.resize(ZSTD_compressBound(data.size()));
+	const size_t compressed_size = ZSTD_compressCCtx(context, /*dest=*/&compressed_out[0], /*dest capacity=*/compressed_out.size(), /*src=*/data.data(), /*src size=*/data.size(), ZSTD_COMPRESSION_LEVEL);
+
+	returnZstdContext(context);
+
+	if(ZSTD_isError(compressed_size))
+		throw glare::Exception(std::string("Compression failed: ") + ZSTD_getErrorName(compressed_size));
+	compressed_out.resize(compressed_size);
+}
+
+
+static void compressWithDeflate(const std::string& data, std::string& compressed_out)
+{
+	z_stream* stream = getDeflateStream();
+
+	compressed_out.resize(deflateBound(stream, (uLong)data.size()));
+	stream->next_in = (Bytef*)data.data();
+	stream->avail_in = (uInt)data.size();
+	stream->next_out = (Bytef*)&compressed_out[0];
+	stream->avail_out = (uInt)compressed_out.size();
+	const int result = deflate(stream, Z_FINISH); // Output buffer is deflateBound() large, so this should complete in one call.
+	const size_t compressed_size = stream->total_out;
+
+	returnDeflateStream(stream);
+
+	if(result != Z_STREAM_END)
+		throw glare::Exception("Compression failed (deflate result: " + toString(result) + ")");
+	compressed_out.resize(compressed_size);
+}
+
+
+void writeHTTPOKHeaderAndHTML(const web::RequestInfo& request_info, web::ReplyInfo& reply_info, const std::string& page)
+{
+	const bool use_zstd = request_info.zstd_accept_encoding;
+	const bool use_deflate = !use_zstd && request_info.deflate_accept_encoding;
+
+	if((page.size() < MIN_COMPRESSED_RESPONSE_SIZE) || !(use_zstd || use_deflate))
+	{
+		num_uncompressed_responses.increment();
+		web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+		return;
+	}
+
+	Timer timer;
+	std::string compressed;
+	if(use_zstd)
+		compressWithZstd(page, compressed);
+	else
+		compressWithDeflate(page, compressed);
+	const double elapsed = timer.elapsed();
+
+	if(use_zstd)
+		num_zstd_responses.increment();
+	else
+		num_deflate_responses.increment();
+	total_uncompressed_size_B += (int64)page.size();
+	total_compressed_size_B += (int64)compressed.size();
+	total_compression_time_us += (int64)(elapsed * 1.0e6);
+
+	const std::string header = 
+		"HTTP/1.1 200 OK\r\n"
+		"Content-Type: text/html; charset=UTF-8\r\n"
+		"Content-Encoding: " + std::string(use_zstd ? "zstd" : "deflate") + "\r\n"
+		"Vary: Accept-Encoding\r\n"
+		"Connection: Keep-Alive\r\n"
+		"Content-Length: " + toString(compressed.size()) + "\r\n"
+		"\r\n";
+	reply_info.socket->writeData(header.data(), header.size());
+	reply_info.socket->writeData(compressed.data(), compressed.size());
+}
+
+
+CompressionStats getCompressionStats()
+{
+	CompressionStats stats;
+	stats.num_uncompressed_responses = (uint64)num_uncompressed_responses;
+	stats.num_zstd_responses = (uint64)num_zstd_responses;
+	stats.num_deflate_responses = (uint64)num_deflate_responses;
+	stats.total_uncompressed_size_B = (uint64)total_uncompressed_size_B;
+	stats.total_compressed_size_B = (uint64)total_compressed_size_B;
+	stats.total_compression_time_s = (int64)total_compression_time_us * 1.0e-6;
+	return stats;
+}
+
+
+void freePooledCompressionContexts()
+{
+	Lock lock(context_pool_mutex);
+
+	for(size_t i=0; i<zstd_context_pool.size(); ++i)
+		ZSTD_freeCCtx(zstd_context_pool[i]);
+	zstd_context_pool.clear();
+
+	for(size_t i=0; i<deflate_stream_pool.size(); ++i)
+	{
+		deflateEnd(deflate_stream_pool[i]);
+		delete deflate_stream_pool[i];
+	}
+	deflate_stream_pool.clear();
+}
+
+
+const std::string makeETagForImmutableFile(const std::string& local_path)
+{
+	const uint64 hash = XXH64(local_path.data(), local_path.size(), /*seed=*/1);
+	return "\"" + toHexString(hash) + "\"";
+}
+
+
+static const std::string stripWeakETagPrefix(const std::string& etag)
+{
+	return hasPrefix(etag, "W/") ? etag.substr(2) : etag;
+}
+
+
+bool ifNoneMatchValueMatches(const std::string& if_none_match_value, const std::string& etag)
+{
+	const std::string stripped_etag = stripWeakETagPrefix(etag);
+
+	const std::vector<std::string> tags = split(if_none_match_value, ',');
+	for(size_t i=0; i<tags.size(); ++i)
+	{
+		const std::string tag = stripHeadAndTailWhitespace(tags[i]);
+		if(tag == "*" || stripWeakETagPrefix(tag) == stripped_etag)
+			return true;
+	}
+	return false;
+}
+
+
+static void writeImageHeaderAndData(web::ReplyInfo& reply_info, const std::string& content_type, const std::string& etag, const std::string& cache_control, const void* data, size_t size)
+{
+	const std::string header =
+		"HTTP/1.1 200 OK\r\n"
+		"Content-Type: " + content_type + "\r\n"
+		"ETag: " + etag + "\r\n"
+		"Cache-Control: " + cache_control + "\r\n"
+		"Connection: Keep-Alive\r\n"
+		"Content-Length: " + toString(size) + "\r\n"
+		"\r\n";
+	reply_info.socket->writeData(header.data(), header.size());
+	reply_info.socket->writeData(data, size);
+}
+
+
+void writeImageFileWithETag(ServerAllWorldsState& world_state, const web::RequestInfo& request_info, web::ReplyInfo& reply_info, const std::string& local_path, 
+	const std::string& content_type, const std::string& cache_control)
+{
+	const std::string etag = makeETagForImmutableFile(local_path);
+
+	for(size_t i=0; i<request_info.headers.size(); ++i)
+		if(StringUtils::equalCaseInsensitive(request_info.headers[i].key, "if-none-match") && ifNoneMatchValueMatches(toString(request_info.headers[i].value), etag))
+		{
+			const std::string response =
+				"HTTP/1.1 304 Not Modified\r\n"
+				"ETag: " + etag + "\r\n"
+				"Cache-Control: " + cache_control + "\r\n"
+				"Connection: Keep-Alive\r\n"
+				"\r\n";
+
+			reply_info.socket->writeData(response.data(), response.size());
+			return;
+		}
+
+	CachedImageFileRef file = world_state.image_file_cache.getFile(local_path);
+	if(file.nonNull())
+	{
+		// Write the data directly from the cached buffer.
+		writeImageHeaderAndData(reply_info, content_type, etag, cache_control, file->data.data(), file->data.size());
+	}
+	else
+	{
+		// Write the data directly from the mapped file, then cache it if it's small enough.
+		MemMappedFile mapped_file(local_path);
+		writeImageHeaderAndData(reply_info, content_type, etag, cache_control, mapped_file.fileData(), mapped_file.fileSize());
+
+		world_state.image_file_cache.addFile(local_path, mapped_file.fileData(), mapped_file.fileSize());
+	}
+}
+
+
+#if BUILD_TESTS
+
+
+#include <TestUtils.h>
+
+
+static std::string decompressZstd(const std::string& compressed)
+{
+	const unsigned long long decompressed_size = ZSTD_getFrameContentSize(compressed.data(), compressed.size());
+	testAssert(decompressed_size != ZSTD_CONTENTSIZE_UNKNOWN && decompressed_size != ZSTD_CONTENTSIZE_ERROR);
+	std::string decompressed((size_t)decompressed_size, '\0');
+	const size_t res = ZSTD_decompress(&decompressed[0], decompressed.size(), compressed.data(), compressed.size());
+	testAssert(!ZSTD_isError(res) && res == decompressed_size);
+	return decompressed;
+}
+
+
+static std::string decompressDeflate(const std::string& compressed, size_t decompressed_size)
+{
+	std::string decompressed((size_t)decompressed_size, '\0');
+	uLongf dest_len = (uLongf)decompressed_size;
+	const int res = ::uncompress((Bytef*)&decompressed[0], &dest_len, (const Bytef*)compressed.data(), (uLong)compressed.size());
+	testAssert(res == Z_OK && dest_len == decompressed_size);
+	return decompressed;
+}
+
+
+void test()
+{
+	conPrint("WebServerResponseUtils::test()");
+
+	// Make a page resembling the admin users list, which is one of the largest dynamic pages.
+	std::string page = "<html><body><h2>Users</h2>\n";
+	for(int i=0; i<20000; ++i)
+		page += "<div>User id: " + toString(i) + ", username: <a href=\"/admin_user/" + toString(i) + "\">user_" + toString(i * 7919 % 100003) + "</a>, email: user" + toString(i) + "@example.com, joined " + 
+			toString(2020 + i % 5) + "-0" + toString(1 + i % 9) + "-1" + toString(i % 10) + "</div>\n";
+	page += "</body></html>";
+
+	// Check round-trips, including with reused contexts.
+	for(int i=0; i<3; ++i)
+	{
+		std::string compressed;
+		compressWithZstd(page, compressed);
+		testAssert(compressed.size() < page.size());
+		testAssert(decompressZstd(compressed) == page);
+
+		compressWithDeflate(page, compressed);
+		testAssert(compressed.size() < page.size());
+		testAssert(decompressDeflate(compressed, page.size()) == page);
+
+		const std::string small_page = "<html>hello</html>";
+		compressWithDeflate(small_page, compressed);
+		testAssert(decompressDeflate(compressed, small_page.size()) == small_page);
+	}
+
+	// Measure CPU cost versus bytes saved, for fresh contexts vs. reused contexts.
+	{
+		const int N = 20;
+		for(int z=0; z<2; ++z)
+		{
+			const bool reuse = z == 1;
+			std::string compressed;
+
+			Timer timer;
+			for(int i=0; i<N; ++i)
+			{
+				if(!reuse) freePooledCompressionContexts();
+				compressWithZstd(page, compressed);
+			}
+			const double zstd_time = timer.elapsed() / N;
+			const size_t zstd_size = compressed.size();
+
+			timer.reset();
+			for(int i=0; i<N; ++i)
+			{
+				if(!reuse) freePooledCompressionContexts();
+				compressWithDeflate(page, compressed);
+			}
+			const double deflate_time = timer.elapsed() / N;
+			const size_t deflate_size = compressed.size();
+
+			conPrint(std::string(reuse ? "Reused contexts: " : "Fresh contexts:  ") + "page size: " + getNiceByteSize(page.size()));
+			conPrint("  zstd:    " + getNiceByteSize(zstd_size) + " (" + doubleToStringNSigFigs(100.0 * zstd_size / page.size(), 3) + "% of original), " + 
+				doubleToStringNSigFigs(zstd_time * 1.0e3, 4) + " ms, " + doubleToStringNSigFigs(page.size() / zstd_time * 1.0e-6, 4) + " MB/s");
+			conPrint("  deflate: " + getNiceByteSize(deflate_size) + " (" + doubleToStringNSigFigs(100.0 * deflate_size / page.size(), 3) + "% of original), " + 
+				doubleToStringNSigFigs(deflate_time * 1.0e3, 4) + " ms, " + doubleToStringNSigFigs(page.size() / deflate_time * 1.0e-6, 4) + " MB/s");
+		}
+	}
+
+	freePooledCompressionContexts();
+
+	//------------------------ Test ETags ------------------------
+	{
+		const std::string etag = makeETagForImmutableFile("/var/www/screenshots/screenshot_0123456789abcdef.jpg");
+		testAssert(etag.size() >= 3 && etag[0] == '"' && etag.back() == '"');
+		testAssert(etag == makeETagForImmutableFile("/var/www/screenshots/screenshot_0123456789abcdef.jpg"));
+		testAssert(etag != makeETagForImmutableFile("/var/www/screenshots/screenshot_fedcba9876543210.jpg"));
+
+		testAssert(ifNoneMatchValueMatches(etag, etag));
+		testAssert(ifNoneMatchValueMatches("W/" + etag, etag));
+		testAssert(ifNoneMatchValueMatches("\"abc\", " + etag, etag));
+		testAssert(ifNoneMatchValueMatches(" \"abc\" ,W/" + etag + " ", etag));
+		testAssert(ifNoneMatchValueMatches("*", etag));
+		testAssert(!ifNoneMatchValueMatches("\"abc\"", etag));
+		testAssert(!ifNoneMatchValueMatches("", etag));
+		testAssert(!ifNoneMatchValueMatches(etag.substr(1), etag));
+	}
+
+	conPrint("WebServerResponseUtils::test() done.");
+}
+
+
+#endif // BUILD_TESTS
+
+
 } // end namespace WebServerResponseUtils
@@ -6,6 +6,7 @@ Copyright Glare Technologies Limited 2021 -
 #pragma once
 
 #include "../shared/ParcelID.h"
+#include <Platform.h>
 #include <string>
 class ServerAllWorldsState;
 class WebDataStore;
@@ -30,4 +31,42 @@ namespace WebServerResponseUtils
 
 	const std::string getMapHeaderTags();
 	const std::string getMapEmbedCode(ServerAllWorldsState& world_state, ParcelID highlighted_parcel_id);
+
+
+	// Responses smaller than this are sent uncompressed, as the compression saves little and the encoding headers eat into the saving.
+	static const size_t MIN_COMPRESSED_RESPONSE_SIZE = 1024;
+
+	// Writes a 200 OK response with a dynamically generated HTML page.
+	// The page is compressed with zstd or deflate, if the client accepts one of them and the page is at least MIN_COMPRESSED_RESPONSE_SIZE bytes.
+	void writeHTTPOKHeaderAndHTML(const web::RequestInfo& request_info, web::ReplyInfo& reply_info, const std::string& page);
+
+	struct CompressionStats
+	{
+		uint64 num_uncompressed_responses;
+		uint64 num_zstd_responses;
+		uint64 num_deflate_responses;
+		uint64 total_uncompressed_size_B; // Total size of the compressed responses before compression.
+		uint64 total_compressed_size_B;
+		double total_compression_time_s;
+	};
+	CompressionStats getCompressionStats();
+
+	// Frees the compression contexts that are pooled for reuse between responses.
+	void freePooledCompressionContexts();
+
+
+	// Makes a strong ETag for a file whose contents don't change once written.
+	// Screenshots, map tiles and photos are saved with a new random filename each time, so the path identifies the file contents.
+	const std::string makeETagForImmutableFile(const std::string& local_path);
+
+	// Returns true if an If-None-Match header value (e.g. '"abc", W/"def"' or '*') matches etag.  Uses weak comparison, as specified for If-None-Match.
+	bool ifNoneMatchValueMatches(const std::string& if_none_match_value, const std::string& etag);
+
+	// Writes a 304 Not Modified response if the request has an If-None-Match header matching the ETag for the file, 
+	// otherwise writes a 200 OK response with the file contents.  Files are read through world_state.image_file_cache.
+	// Throws glare::Exception if the file could not be read.
+	void writeImageFileWithETag(ServerAllWorldsState& world_state, const web::RequestInfo& request_info, web::ReplyInfo& reply_info, const std::string& local_path, 
+		const std::string& content_type, const std::string& cache_control);
+
+	void test();
 }
@@ -139,7 +139,7 @@ void renderWorldPage(ServerAllWorldsState& world_state, const web::RequestInfo&
 		page += "</div>   \n"; // end main div
 		page += WebServerResponseUtils::standardFooter(request, true);
 
-		web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+		WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 	}
 	catch(glare::Exception& e)
 	{
@@ -186,7 +186,7 @@ void renderCreateWorldPage(ServerAllWorldsState& world_state, const web::Request
 
 		page += WebServerResponseUtils::standardFooter(request, true);
 
-		web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+		WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 	}
 	catch(glare::Exception& e)
 	{
@@ -253,7 +253,7 @@ void renderEditWorldPage(ServerAllWorldsState& world_state, const web::RequestIn
 
 		page += WebServerResponseUtils::standardFooter(request, true);
 
-		web::ResponseUtils::writeHTTPOKHeaderAndData(reply_info, page);
+		WebServerResponseUtils::writeHTTPOKHeaderAndHTML(request, reply_info, page);
 	}
 	catch(glare::Exception& e)
 	{